@@ -2280,19 +2280,9 @@ gst_h264_sps_clear (GstH264SPS * sps)
   }
 }
 
-/**
- * gst_h264_parser_parse_sei:
- * @nalparser: a #GstH264NalParser
- * @nalu: The #GST_H264_NAL_SEI #GstH264NalUnit to parse
- * @messages: The GArray of #GstH264SEIMessage to fill. The caller must free it when done.
- *
- * Parses @data, create and fills the @messages array.
- *
- * Returns: a #GstH264ParserResult
- */
-GstH264ParserResult
-gst_h264_parser_parse_sei (GstH264NalParser * nalparser, GstH264NalUnit * nalu,
-    GArray ** messages)
+static GstH264ParserResult
+gst_h264_parser_parse_sei_messages (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GArray * messages)
 {
   NalReader nr;
   GstH264SEIMessage sei;
@@ -2301,12 +2291,11 @@ gst_h264_parser_parse_sei (GstH264NalParser * nalparser, GstH264NalUnit * nalu,
   GST_DEBUG ("parsing SEI nal");
   nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
       nalu->size - nalu->header_bytes);
-  *messages = g_array_new (FALSE, FALSE, sizeof (GstH264SEIMessage));
 
   do {
     res = gst_h264_parser_parse_sei_message (nalparser, &nr, &sei);
     if (res == GST_H264_PARSER_OK)
-      g_array_append_val (*messages, sei);
+      g_array_append_val (messages, sei);
     else
       break;
   } while (nal_reader_has_more_data (&nr));
@@ -2314,6 +2303,52 @@ gst_h264_parser_parse_sei (GstH264NalParser * nalparser, GstH264NalUnit * nalu,
   return res;
 }
 
+/**
+ * gst_h264_parser_parse_sei:
+ * @nalparser: a #GstH264NalParser
+ * @nalu: The #GST_H264_NAL_SEI #GstH264NalUnit to parse
+ * @messages: The GArray of #GstH264SEIMessage to fill. The caller must free it when done.
+ *
+ * Parses @data, create and fills the @messages array.
+ *
+ * Returns: a #GstH264ParserResult
+ */
+GstH264ParserResult
+gst_h264_parser_parse_sei (GstH264NalParser * nalparser, GstH264NalUnit * nalu,
+    GArray ** messages)
+{
+  *messages = g_array_new (FALSE, FALSE, sizeof (GstH264SEIMessage));
+
+  return gst_h264_parser_parse_sei_messages (nalparser, nalu, *messages);
+}
+
+/**
+ * gst_h264_parser_parse_sei_into:
+ * @nalparser: a #GstH264NalParser
+ * @nalu: The #GST_H264_NAL_SEI #GstH264NalUnit to parse
+ * @messages: A GArray of #GstH264SEIMessage owned by the caller
+ *
+ * Like gst_h264_parser_parse_sei(), but empties and fills the existing
+ * @messages array instead of creating a new one. Keeping one array per stream
+ * avoids any allocation once it has grown to the number of messages per SEI.
+ *
+ * Returns: a #GstH264ParserResult
+ *
+ * Since: 1.12
+ */
+GstH264ParserResult
+gst_h264_parser_parse_sei_into (GstH264NalParser * nalparser,
+    GstH264NalUnit * nalu, GArray * messages)
+{
+  g_return_val_if_fail (messages != NULL, GST_H264_PARSER_ERROR);
+  g_return_val_if_fail (g_array_get_element_size (messages) ==
+      sizeof (GstH264SEIMessage), GST_H264_PARSER_ERROR);
+
+  g_array_set_size (messages, 0);
+
+  return gst_h264_parser_parse_sei_messages (nalparser, nalu, messages);
+}
+
 /**
  * gst_h264_quant_matrix_8x8_get_zigzag_from_raster:
  * @out_quant: (out): The resulting quantization matrix
@@ -1048,6 +1048,9 @@ GstH264ParserResult gst_h264_parser_parse_pps         (GstH264NalParser *nalpars
 GstH264ParserResult gst_h264_parser_parse_sei         (GstH264NalParser *nalparser,
                                                        GstH264NalUnit *nalu, GArray ** messages);
 
+GstH264ParserResult gst_h264_parser_parse_sei_into    (GstH264NalParser *nalparser,
+                                                       GstH264NalUnit *nalu, GArray * messages);
+
 void gst_h264_nal_parser_free                         (GstH264NalParser *nalparser);
 
 GstH264ParserResult gst_h264_parse_subset_sps         (GstH264NalUnit *nalu,
@@ -1889,21 +1889,24 @@ gst_h265_parser_parse_pps (GstH265Parser * parser,
   return res;
 }
 
-/**
- * gst_h265_parser_parse_slice_hdr:
- * @parser: a #GstH265Parser
- * @nalu: The #GST_H265_NAL_SLICE #GstH265NalUnit to parse
- * @slice: The #GstH265SliceHdr to fill.
- *
- * Parses @data, and fills the @slice structure.
- * The resulting @slice_hdr structure shall be deallocated with
- * gst_h265_slice_hdr_free() when it is no longer needed
- *
- * Returns: a #GstH265ParserResult
- */
-GstH265ParserResult
-gst_h265_parser_parse_slice_hdr (GstH265Parser * parser,
-    GstH265NalUnit * nalu, GstH265SliceHdr * slice)
+/* makes room for @n substreams in @segment, keeping its storage when large
+ * enough so that segments reused for every access unit don't allocate */
+static void
+slice_segment_reserve (GstH265SliceSegment * segment, guint n)
+{
+  if (segment->max_substreams >= n)
+    return;
+
+  g_free (segment->substream_offsets);
+  segment->substream_offsets = g_new (guint, n);
+  segment->max_substreams = n;
+}
+
+/* with a @segment, the entry points are read into its substream offsets
+ * instead of being allocated in @slice */
+static GstH265ParserResult
+parse_slice_hdr (GstH265Parser * parser, GstH265NalUnit * nalu,
+    GstH265SliceHdr * slice, GstH265SliceSegment * segment)
 {
   NalReader nr;
   gint pps_id;
@@ -2150,12 +2153,19 @@ gst_h265_parser_parse_slice_hdr (GstH265Parser * parser,
 
     READ_UE_MAX (&nr, slice->num_entry_point_offsets, offset_max);
     if (slice->num_entry_point_offsets > 0) {
+      guint32 *entry_points;
+
       READ_UE_MAX (&nr, slice->offset_len_minus1, 31);
-      slice->entry_point_offset_minus1 =
-          g_new0 (guint32, slice->num_entry_point_offsets);
+      if (segment) {
+        slice_segment_reserve (segment, slice->num_entry_point_offsets + 1);
+        entry_points = segment->substream_offsets + 1;
+      } else {
+        slice->entry_point_offset_minus1 =
+            g_new0 (guint32, slice->num_entry_point_offsets);
+        entry_points = slice->entry_point_offset_minus1;
+      }
       for (i = 0; i < slice->num_entry_point_offsets; i++)
-        READ_UINT32 (&nr, slice->entry_point_offset_minus1[i],
-            (slice->offset_len_minus1 + 1));
+        READ_UINT32 (&nr, entry_points[i], (slice->offset_len_minus1 + 1));
     }
   }
 
@@ -2188,6 +2198,177 @@ error:
   return GST_H265_PARSER_ERROR;
 }
 
+/**
+ * gst_h265_parser_parse_slice_hdr:
+ * @parser: a #GstH265Parser
+ * @nalu: The #GST_H265_NAL_SLICE #GstH265NalUnit to parse
+ * @slice: The #GstH265SliceHdr to fill.
+ *
+ * Parses @data, and fills the @slice structure.
+ * The resulting @slice_hdr structure shall be deallocated with
+ * gst_h265_slice_hdr_free() when it is no longer needed
+ *
+ * Returns: a #GstH265ParserResult
+ */
+GstH265ParserResult
+gst_h265_parser_parse_slice_hdr (GstH265Parser * parser,
+    GstH265NalUnit * nalu, GstH265SliceHdr * slice)
+{
+  return parse_slice_hdr (parser, nalu, slice, NULL);
+}
+
+/* Below this many slice segments, handing them to the thread pool costs
+ * more than parsing the headers in the calling thread */
+#define SLICE_SEGMENTS_PARALLEL_MIN 4
+
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  guint pending;
+} SliceSegmentBatch;
+
+typedef struct
+{
+  GstH265Parser *parser;
+  GstH265SliceSegment *segment;
+  SliceSegmentBatch *batch;
+} SliceSegmentJob;
+
+static void
+parse_slice_segment (GstH265Parser * parser, GstH265SliceSegment * segment)
+{
+  GstH265NalUnit *nalu = &segment->nalu;
+  GstH265SliceHdr *slice = &segment->header;
+  guint end, offset, i;
+
+  segment->data_offset = 0;
+  segment->num_substreams = 0;
+
+  segment->result = parse_slice_hdr (parser, nalu, slice, segment);
+  if (segment->result != GST_H265_PARSER_OK)
+    return;
+
+  /* header_size counts the emulation prevention bytes of the header, which
+   * is what the entry point offsets are relative to as well (7.4.7.1) */
+  end = nalu->offset + nalu->size;
+  offset = nalu->offset + nalu->header_bytes + slice->header_size / 8;
+  if (offset > end)
+    goto broken;
+
+  /* the entry points were read into substream_offsets[1..] already, turn
+   * them into offsets in place */
+  slice_segment_reserve (segment, 1);
+  segment->data_offset = offset;
+  segment->substream_offsets[0] = offset;
+
+  for (i = 1; i <= slice->num_entry_point_offsets; i++) {
+    guint64 next = (guint64) offset + segment->substream_offsets[i] + 1;
+
+    if (next >= end)
+      goto broken;
+    offset = next;
+    segment->substream_offsets[i] = offset;
+  }
+  segment->num_substreams = slice->num_entry_point_offsets + 1;
+
+  return;
+
+broken:
+  GST_WARNING ("slice segment entry points exceed the NAL unit size");
+  segment->data_offset = 0;
+  segment->result = GST_H265_PARSER_BROKEN_DATA;
+}
+
+static void
+parse_slice_segment_job (SliceSegmentJob * job, gpointer user_data)
+{
+  SliceSegmentBatch *batch = job->batch;
+
+  parse_slice_segment (job->parser, job->segment);
+
+  g_mutex_lock (&batch->lock);
+  if (--batch->pending == 0)
+    g_cond_signal (&batch->cond);
+  g_mutex_unlock (&batch->lock);
+}
+
+/**
+ * gst_h265_slice_segment_pool_new:
+ * @max_threads: the maximum number of threads, 0 for the number of
+ *   processors
+ *
+ * Creates a thread pool for gst_h265_parser_parse_slice_segments() to parse
+ * slice segment headers on. Its threads are started on demand, and owned by
+ * the caller, who frees the pool with g_thread_pool_free() when done.
+ *
+ * Returns: (transfer full): a new #GThreadPool
+ *
+ * Since: 1.12
+ */
+GThreadPool *
+gst_h265_slice_segment_pool_new (guint max_threads)
+{
+  if (max_threads == 0)
+    max_threads = g_get_num_processors ();
+
+  return g_thread_pool_new ((GFunc) parse_slice_segment_job, NULL,
+      max_threads, FALSE, NULL);
+}
+
+GstH265ParserResult
+gst_h265_parser_parse_slice_segments (GstH265Parser * parser,
+    GstH265SliceSegment * segments, guint n_segments, GThreadPool * pool)
+{
+  guint i;
+
+  g_return_val_if_fail (parser != NULL, GST_H265_PARSER_ERROR);
+  g_return_val_if_fail (segments != NULL || n_segments == 0,
+      GST_H265_PARSER_ERROR);
+
+  if (pool && n_segments >= SLICE_SEGMENTS_PARALLEL_MIN) {
+    SliceSegmentBatch batch;
+    SliceSegmentJob jobs_static[16];
+    SliceSegmentJob *jobs = jobs_static;
+
+    g_mutex_init (&batch.lock);
+    g_cond_init (&batch.cond);
+    batch.pending = n_segments - 1;
+
+    if (n_segments - 1 > G_N_ELEMENTS (jobs_static))
+      jobs = g_new (SliceSegmentJob, n_segments - 1);
+    for (i = 1; i < n_segments; i++) {
+      jobs[i - 1].parser = parser;
+      jobs[i - 1].segment = &segments[i];
+      jobs[i - 1].batch = &batch;
+      g_thread_pool_push (pool, &jobs[i - 1], NULL);
+    }
+
+    /* take a share of the work while waiting */
+    parse_slice_segment (parser, &segments[0]);
+
+    g_mutex_lock (&batch.lock);
+    while (batch.pending > 0)
+      g_cond_wait (&batch.cond, &batch.lock);
+    g_mutex_unlock (&batch.lock);
+
+    if (jobs != jobs_static)
+      g_free (jobs);
+    g_cond_clear (&batch.cond);
+    g_mutex_clear (&batch.lock);
+  } else {
+    for (i = 0; i < n_segments; i++)
+      parse_slice_segment (parser, &segments[i]);
+  }
+
+  for (i = 0; i < n_segments; i++) {
+    if (segments[i].result != GST_H265_PARSER_OK)
+      return segments[i].result;
+  }
+
+  return GST_H265_PARSER_OK;
+}
+
 static gboolean
 nal_reader_has_more_data_in_payload (NalReader * nr,
     guint32 payload_start_pos_bit, guint32 payloadSize)
@@ -2341,6 +2522,27 @@ gst_h265_slice_hdr_free (GstH265SliceHdr * slice_hdr)
   slice_hdr->entry_point_offset_minus1 = 0;
 }
 
+/**
+ * gst_h265_slice_segment_clear:
+ * @segment: The #GstH265SliceSegment to clear
+ *
+ * Frees the fields of @segment allocated by
+ * gst_h265_parser_parse_slice_segments().
+ *
+ * Since: 1.12
+ */
+void
+gst_h265_slice_segment_clear (GstH265SliceSegment * segment)
+{
+  g_return_if_fail (segment != NULL);
+
+  gst_h265_slice_hdr_free (&segment->header);
+  g_free (segment->substream_offsets);
+  segment->substream_offsets = NULL;
+  segment->num_substreams = 0;
+  segment->max_substreams = 0;
+}
+
 /**
  * gst_h265_sei_copy:
  * @dst_sei: The destination #GstH265SEIMessage to copy into
@@ -2407,6 +2609,29 @@ gst_h265_sei_free (GstH265SEIMessage * sei)
   }
 }
 
+static GstH265ParserResult
+gst_h265_parser_parse_sei_messages (GstH265Parser * nalparser,
+    GstH265NalUnit * nalu, GArray * messages)
+{
+  NalReader nr;
+  GstH265SEIMessage sei;
+  GstH265ParserResult res;
+
+  GST_DEBUG ("parsing SEI nal");
+  nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
+      nalu->size - nalu->header_bytes);
+
+  do {
+    res = gst_h265_parser_parse_sei_message (nalparser, nalu->type, &nr, &sei);
+    if (res == GST_H265_PARSER_OK)
+      g_array_append_val (messages, sei);
+    else
+      break;
+  } while (nal_reader_has_more_data (&nr));
+
+  return res;
+}
+
 /**
  * gst_h265_parser_parse_sei:
  * @nalparser: a #GstH265Parser
@@ -2421,25 +2646,41 @@ GstH265ParserResult
 gst_h265_parser_parse_sei (GstH265Parser * nalparser, GstH265NalUnit * nalu,
     GArray ** messages)
 {
-  NalReader nr;
-  GstH265SEIMessage sei;
-  GstH265ParserResult res;
-
-  GST_DEBUG ("parsing SEI nal");
-  nal_reader_init (&nr, nalu->data + nalu->offset + nalu->header_bytes,
-      nalu->size - nalu->header_bytes);
   *messages = g_array_new (FALSE, FALSE, sizeof (GstH265SEIMessage));
   g_array_set_clear_func (*messages, (GDestroyNotify) gst_h265_sei_free);
 
-  do {
-    res = gst_h265_parser_parse_sei_message (nalparser, nalu->type, &nr, &sei);
-    if (res == GST_H265_PARSER_OK)
-      g_array_append_val (*messages, sei);
-    else
-      break;
-  } while (nal_reader_has_more_data (&nr));
+  return gst_h265_parser_parse_sei_messages (nalparser, nalu, *messages);
+}
 
-  return res;
+/**
+ * gst_h265_parser_parse_sei_into:
+ * @nalparser: a #GstH265Parser
+ * @nalu: The #GST_H265_NAL_SEI #GstH265NalUnit to parse
+ * @messages: A GArray of #GstH265SEIMessage owned by the caller
+ *
+ * Like gst_h265_parser_parse_sei(), but empties and fills the existing
+ * @messages array instead of creating a new one. Keeping one array per stream
+ * avoids any allocation once it has grown to the number of messages per SEI,
+ * except for decoding unit information in picture timing messages.
+ *
+ * @messages should have gst_h265_sei_free() as clear function so that the
+ * previous messages are released when it is emptied.
+ *
+ * Returns: a #GstH265ParserResult
+ *
+ * Since: 1.12
+ */
+GstH265ParserResult
+gst_h265_parser_parse_sei_into (GstH265Parser * nalparser,
+    GstH265NalUnit * nalu, GArray * messages)
+{
+  g_return_val_if_fail (messages != NULL, GST_H265_PARSER_ERROR);
+  g_return_val_if_fail (g_array_get_element_size (messages) ==
+      sizeof (GstH265SEIMessage), GST_H265_PARSER_ERROR);
+
+  g_array_set_size (messages, 0);
+
+  return gst_h265_parser_parse_sei_messages (nalparser, nalu, messages);
 }
 
 
@@ -245,6 +245,7 @@ typedef struct _GstH265RefPicListModification   GstH265RefPicListModification;
 typedef struct _GstH265PredWeightTable          GstH265PredWeightTable;
 typedef struct _GstH265ShortTermRefPicSet       GstH265ShortTermRefPicSet;
 typedef struct _GstH265SliceHdr                 GstH265SliceHdr;
+typedef struct _GstH265SliceSegment             GstH265SliceSegment;
 
 typedef struct _GstH265PicTiming                GstH265PicTiming;
 typedef struct _GstH265BufferingPeriod          GstH265BufferingPeriod;
@@ -931,6 +932,39 @@ struct _GstH265SliceHdr
   guint n_emulation_prevention_bytes;
 };
 
+/**
+ * GstH265SliceSegment:
+ * @nalu: The slice segment #GstH265NalUnit, to be filled by the caller
+ * @header: The parsed #GstH265SliceHdr
+ * @result: The #GstH265ParserResult of parsing @header
+ * @data_offset: Offset of the slice_segment_data() in @nalu.data
+ * @num_substreams: Number of substreams (tiles or CTU rows with WPP) in the
+ *   slice segment data, num_entry_point_offsets + 1
+ * @substream_offsets: Offsets of the @num_substreams substreams in @nalu.data.
+ *   Offsets are in bytes of the NAL unit, emulation prevention bytes included.
+ * @max_substreams: Number of entries allocated in @substream_offsets
+ *
+ * A slice segment of an access unit, as parsed by
+ * gst_h265_parser_parse_slice_segments(). Substream k spans from
+ * @substream_offsets[k] to @substream_offsets[k + 1], the last one ends with
+ * the NAL unit. The entry points are not kept in @header, whose
+ * entry_point_offset_minus1 is %NULL, they are turned into @substream_offsets.
+ *
+ * Since: 1.12
+ */
+struct _GstH265SliceSegment
+{
+  GstH265NalUnit nalu;
+
+  GstH265SliceHdr header;
+  GstH265ParserResult result;
+
+  guint data_offset;
+  guint num_substreams;
+  guint *substream_offsets;
+  guint max_substreams;
+};
+
 struct _GstH265PicTiming
 {
   guint8 pic_struct;
@@ -1025,6 +1059,13 @@ GstH265ParserResult gst_h265_parser_parse_slice_hdr (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
                                                      GstH265SliceHdr * slice);
 
+GstH265ParserResult gst_h265_parser_parse_slice_segments (GstH265Parser       * parser,
+                                                          GstH265SliceSegment * segments,
+                                                          guint                 n_segments,
+                                                          GThreadPool         * pool);
+
+GThreadPool *       gst_h265_slice_segment_pool_new (guint max_threads);
+
 GstH265ParserResult gst_h265_parser_parse_vps       (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
                                                      GstH265VPS      * vps);
@@ -1042,6 +1083,10 @@ GstH265ParserResult gst_h265_parser_parse_sei       (GstH265Parser   * parser,
                                                      GstH265NalUnit  * nalu,
                                                      GArray **messages);
 
+GstH265ParserResult gst_h265_parser_parse_sei_into  (GstH265Parser   * parser,
+                                                     GstH265NalUnit  * nalu,
+                                                     GArray          * messages);
+
 void                gst_h265_parser_free            (GstH265Parser  * parser);
 
 GstH265ParserResult gst_h265_parse_vps              (GstH265NalUnit * nalu,
@@ -1061,6 +1106,8 @@ gboolean            gst_h265_slice_hdr_copy (GstH265SliceHdr       * dst_slice,
 
 void                gst_h265_slice_hdr_free (GstH265SliceHdr * slice_hdr);
 
+void                gst_h265_slice_segment_clear (GstH265SliceSegment * segment);
+
 gboolean            gst_h265_sei_copy       (GstH265SEIMessage       * dest_sei,
                                              const GstH265SEIMessage * src_sei);
 
@@ -0,0 +1,207 @@
+/*
+ * GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gsth265slicemeta.h"
+
+GST_DEBUG_CATEGORY (h265_slice_meta_debug);
+#define GST_CAT_DEFAULT h265_slice_meta_debug
+
+static gboolean
+gst_h265_slice_meta_init (GstH265SliceMeta * slice_meta,
+    gpointer params, GstBuffer * buffer)
+{
+  slice_meta->tiles_enabled = FALSE;
+  slice_meta->entropy_coding_sync_enabled = FALSE;
+  slice_meta->num_tile_columns = slice_meta->num_tile_rows = 1;
+  slice_meta->num_segments = slice_meta->num_substreams = 0;
+  slice_meta->segments = NULL;
+  slice_meta->substreams = NULL;
+
+  return TRUE;
+}
+
+static void
+gst_h265_slice_meta_free (GstH265SliceMeta * slice_meta, GstBuffer * buffer)
+{
+  g_free (slice_meta->segments);
+  g_free (slice_meta->substreams);
+}
+
+static gboolean
+gst_h265_slice_meta_transform (GstBuffer * dest, GstMeta * meta,
+    GstBuffer * buffer, GQuark type, gpointer data)
+{
+  GstH265SliceMeta *smeta, *dmeta;
+
+  smeta = (GstH265SliceMeta *) meta;
+
+  if (GST_META_TRANSFORM_IS_COPY (type)) {
+    GstMetaTransformCopy *copy = data;
+
+    if (!copy->region) {
+      /* only copy if the complete data is copied as well */
+      dmeta = (GstH265SliceMeta *) gst_buffer_add_meta (dest,
+          GST_H265_SLICE_META_INFO, NULL);
+
+      if (!dmeta)
+        return FALSE;
+
+      dmeta->tiles_enabled = smeta->tiles_enabled;
+      dmeta->entropy_coding_sync_enabled = smeta->entropy_coding_sync_enabled;
+      dmeta->num_tile_columns = smeta->num_tile_columns;
+      dmeta->num_tile_rows = smeta->num_tile_rows;
+      dmeta->num_segments = smeta->num_segments;
+      dmeta->segments = g_memdup (smeta->segments,
+          smeta->num_segments * sizeof (GstH265SliceMetaSegment));
+      dmeta->num_substreams = smeta->num_substreams;
+      dmeta->substreams = g_memdup (smeta->substreams,
+          smeta->num_substreams * sizeof (GstH265SliceMetaSubstream));
+    }
+  } else {
+    /* return FALSE, if transform type is not supported */
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+GType
+gst_h265_slice_meta_api_get_type (void)
+{
+  static volatile GType type;
+  static const gchar *tags[] = { "memory", NULL };
+
+  if (g_once_init_enter (&type)) {
+    GType _type = gst_meta_api_type_register ("GstH265SliceMetaAPI", tags);
+    GST_DEBUG_CATEGORY_INIT (h265_slice_meta_debug, "h265slicemeta", 0,
+        "H.265 slice segment GstMeta");
+
+    g_once_init_leave (&type, _type);
+  }
+  return type;
+}
+
+const GstMetaInfo *
+gst_h265_slice_meta_get_info (void)
+{
+  static const GstMetaInfo *h265_slice_meta_info = NULL;
+
+  if (g_once_init_enter (&h265_slice_meta_info)) {
+    const GstMetaInfo *meta = gst_meta_register (GST_H265_SLICE_META_API_TYPE,
+        "GstH265SliceMeta", sizeof (GstH265SliceMeta),
+        (GstMetaInitFunction) gst_h265_slice_meta_init,
+        (GstMetaFreeFunction) gst_h265_slice_meta_free,
+        (GstMetaTransformFunction) gst_h265_slice_meta_transform);
+    g_once_init_leave (&h265_slice_meta_info, meta);
+  }
+
+  return h265_slice_meta_info;
+}
+
+/**
+ * gst_buffer_add_h265_slice_meta:
+ * @buffer: a #GstBuffer
+ * @segments: (array length=n_segments): slice segments parsed with
+ *   gst_h265_parser_parse_slice_segments()
+ * @n_segments: the number of entries in @segments
+ *
+ * Creates and adds a #GstH265SliceMeta to a @buffer.
+ *
+ * The NAL units of @segments must have been identified in the data of
+ * @buffer, so that their offsets are offsets in @buffer. Segments that failed
+ * to parse are left out.
+ *
+ * Returns: (transfer full): a newly created #GstH265SliceMeta
+ *
+ * Since: 1.12
+ */
+GstH265SliceMeta *
+gst_buffer_add_h265_slice_meta (GstBuffer * buffer,
+    const GstH265SliceSegment * segments, guint n_segments)
+{
+  GstH265SliceMeta *slice_meta;
+  guint i, j, n_valid = 0, n_substreams = 0;
+
+  slice_meta =
+      (GstH265SliceMeta *) gst_buffer_add_meta (buffer,
+      GST_H265_SLICE_META_INFO, NULL);
+
+  for (i = 0; i < n_segments; i++) {
+    if (segments[i].result != GST_H265_PARSER_OK)
+      continue;
+    n_valid++;
+    n_substreams += segments[i].num_substreams;
+  }
+
+  GST_DEBUG ("%u of %u slice segments, %u substreams", n_valid, n_segments,
+      n_substreams);
+
+  if (n_valid == 0)
+    return slice_meta;
+
+  slice_meta->segments = g_new (GstH265SliceMetaSegment, n_valid);
+  slice_meta->substreams = g_new (GstH265SliceMetaSubstream, n_substreams);
+
+  for (i = 0; i < n_segments; i++) {
+    const GstH265SliceSegment *segment = &segments[i];
+    GstH265SliceMetaSegment *out;
+    guint end;
+
+    if (segment->result != GST_H265_PARSER_OK)
+      continue;
+
+    if (slice_meta->num_segments == 0) {
+      const GstH265PPS *pps = segment->header.pps;
+
+      slice_meta->tiles_enabled = pps->tiles_enabled_flag;
+      slice_meta->entropy_coding_sync_enabled =
+          pps->entropy_coding_sync_enabled_flag;
+      if (pps->tiles_enabled_flag) {
+        slice_meta->num_tile_columns = pps->num_tile_columns_minus1 + 1;
+        slice_meta->num_tile_rows = pps->num_tile_rows_minus1 + 1;
+      }
+    }
+
+    out = &slice_meta->segments[slice_meta->num_segments++];
+    out->offset = segment->nalu.offset;
+    out->size = segment->nalu.size;
+    out->data_offset = segment->data_offset;
+    out->segment_address = segment->header.segment_address;
+    out->dependent = segment->header.dependent_slice_segment_flag;
+    out->first_substream = slice_meta->num_substreams;
+    out->num_substreams = segment->num_substreams;
+
+    end = segment->nalu.offset + segment->nalu.size;
+    for (j = 0; j < segment->num_substreams; j++) {
+      GstH265SliceMetaSubstream *sub =
+          &slice_meta->substreams[slice_meta->num_substreams++];
+      guint next = (j + 1 < segment->num_substreams) ?
+          segment->substream_offsets[j + 1] : end;
+
+      sub->offset = segment->substream_offsets[j];
+      sub->size = next - sub->offset;
+    }
+  }
+
+  return slice_meta;
+}
@@ -0,0 +1,129 @@
+/* Gstreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_H265_SLICE_META_H__
+#define __GST_H265_SLICE_META_H__
+
+#ifndef GST_USE_UNSTABLE_API
+#warning "The H.265 parsing library is unstable API and may change in future."
+#warning "You can define GST_USE_UNSTABLE_API to avoid this warning."
+#endif
+
+#include <gst/gst.h>
+#include <gst/codecparsers/gsth265parser.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstH265SliceMeta GstH265SliceMeta;
+typedef struct _GstH265SliceMetaSegment GstH265SliceMetaSegment;
+typedef struct _GstH265SliceMetaSubstream GstH265SliceMetaSubstream;
+
+GType gst_h265_slice_meta_api_get_type (void);
+#define GST_H265_SLICE_META_API_TYPE  (gst_h265_slice_meta_api_get_type())
+#define GST_H265_SLICE_META_INFO  (gst_h265_slice_meta_get_info())
+const GstMetaInfo * gst_h265_slice_meta_get_info (void);
+
+/**
+ * GstH265SliceMetaSegment:
+ * @offset: offset of the slice segment NAL unit in the buffer, without its
+ *   start code or length prefix
+ * @size: size of the NAL unit
+ * @data_offset: offset of the slice segment data in the buffer
+ * @segment_address: the slice_segment_address of the segment
+ * @dependent: whether this is a dependent slice segment
+ * @first_substream: index of the first substream of the segment in
+ *   #GstH265SliceMeta.substreams
+ * @num_substreams: number of substreams of the segment
+ *
+ * A slice segment described by a #GstH265SliceMeta.
+ *
+ * Since: 1.12
+ */
+struct _GstH265SliceMetaSegment {
+  guint offset;
+  guint size;
+  guint data_offset;
+  guint32 segment_address;
+  gboolean dependent;
+  guint first_substream;
+  guint num_substreams;
+};
+
+/**
+ * GstH265SliceMetaSubstream:
+ * @offset: offset of the substream in the buffer
+ * @size: size of the substream, emulation prevention bytes included
+ *
+ * A tile, or a row of CTUs with wavefront parallel processing, described by
+ * a #GstH265SliceMeta.
+ *
+ * Since: 1.12
+ */
+struct _GstH265SliceMetaSubstream {
+  guint offset;
+  guint size;
+};
+
+/**
+ * GstH265SliceMeta:
+ * @meta: parent #GstMeta
+ * @tiles_enabled: whether the picture is coded in tiles
+ * @entropy_coding_sync_enabled: whether wavefront parallel processing is used
+ * @num_tile_columns: number of tile columns
+ * @num_tile_rows: number of tile rows
+ * @num_segments: number of entries in @segments
+ * @segments: the slice segments of the access unit, in decoding order
+ * @num_substreams: number of entries in @substreams
+ * @substreams: the substreams of all the slice segments, in decoding order
+ *
+ * Extra buffer metadata locating the slice segments of a H.265 access unit
+ * and the entry points of their tile or WPP substreams.
+ *
+ * Can be used by software decoders to dispatch the substreams of a picture
+ * to several threads without having to parse the slice headers first.
+ *
+ * Offsets are only valid for the buffer the meta was attached to, so the meta
+ * is not copied along with a region of the buffer.
+ *
+ * Since: 1.12
+ */
+struct _GstH265SliceMeta {
+  GstMeta meta;
+
+  gboolean tiles_enabled;
+  gboolean entropy_coding_sync_enabled;
+  guint num_tile_columns;
+  guint num_tile_rows;
+
+  guint num_segments;
+  GstH265SliceMetaSegment *segments;
+
+  guint num_substreams;
+  GstH265SliceMetaSubstream *substreams;
+};
+
+#define gst_buffer_get_h265_slice_meta(b) ((GstH265SliceMeta*)gst_buffer_get_meta((b),GST_H265_SLICE_META_API_TYPE))
+
+GstH265SliceMeta *
+gst_buffer_add_h265_slice_meta (GstBuffer * buffer,
+                                const GstH265SliceSegment *segments,
+                                guint n_segments);
+
+G_END_DECLS
+
+#endif
@@ -21,6 +21,17 @@
 
 #include "parserutils.h"
 
+#if defined (__AVX2__)
+#include <immintrin.h>
+#define SCAN_VECTOR_SIZE 32
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#define SCAN_VECTOR_SIZE 16
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#define SCAN_VECTOR_SIZE 16
+#endif
+
 gboolean
 decode_vlc (GstBitReader * br, guint * res, const VLCTable * table,
     guint length)
@@ -55,3 +66,127 @@ failed:
     return FALSE;
   }
 }
+
+/* Start code scanning
+ *
+ * All the MPEG-style bitstreams we parse delimit their units with a
+ * 0x000001 prefix followed by at least one byte identifying the unit.
+ * Since the payload bytes are mostly non-zero, we test a whole vector of
+ * candidate positions at once and only fall back to the bytewise search
+ * around the (rare) zero bytes. */
+
+static inline gsize
+scan_start_code_scalar (const guint8 * data, gsize i, gsize size)
+{
+  /* we need 4 bytes to match 00 00 01 xx */
+  while (i + 4 <= size) {
+    if (data[i + 2] > 1) {
+      i += 3;
+    } else if (data[i + 1]) {
+      i += 2;
+    } else if (data[i] || data[i + 2] != 1) {
+      i++;
+    } else {
+      return i;
+    }
+  }
+
+  return size;
+}
+
+#ifdef SCAN_VECTOR_SIZE
+/* Returns the offset of the first start code in @data starting at @i, or
+ * @size if there is none. Every position tested by the vector loop has the
+ * 4 bytes it needs within @size, the tail is handled by the scalar loop. */
+static inline gsize
+scan_start_code_vector (const guint8 * data, gsize i, gsize size)
+{
+#if defined (__AVX2__)
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i one = _mm256_set1_epi8 (1);
+
+  while (i + SCAN_VECTOR_SIZE + 3 <= size) {
+    __m256i b0, b1, b2;
+    guint32 mask;
+
+    b0 = _mm256_loadu_si256 ((const __m256i *) (data + i));
+    b1 = _mm256_loadu_si256 ((const __m256i *) (data + i + 1));
+    b2 = _mm256_loadu_si256 ((const __m256i *) (data + i + 2));
+
+    mask = (guint32) _mm256_movemask_epi8 (_mm256_and_si256 (_mm256_and_si256
+            (_mm256_cmpeq_epi8 (b0, zero), _mm256_cmpeq_epi8 (b1, zero)),
+            _mm256_cmpeq_epi8 (b2, one)));
+    if (mask)
+      return i + g_bit_nth_lsf (mask, -1);
+
+    i += SCAN_VECTOR_SIZE;
+  }
+#elif defined (__SSE2__)
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i one = _mm_set1_epi8 (1);
+
+  while (i + SCAN_VECTOR_SIZE + 3 <= size) {
+    __m128i b0, b1, b2;
+    gint mask;
+
+    b0 = _mm_loadu_si128 ((const __m128i *) (data + i));
+    b1 = _mm_loadu_si128 ((const __m128i *) (data + i + 1));
+    b2 = _mm_loadu_si128 ((const __m128i *) (data + i + 2));
+
+    mask = _mm_movemask_epi8 (_mm_and_si128 (_mm_and_si128 (_mm_cmpeq_epi8 (b0,
+                    zero), _mm_cmpeq_epi8 (b1, zero)), _mm_cmpeq_epi8 (b2,
+                one)));
+    if (mask)
+      return i + g_bit_nth_lsf (mask, -1);
+
+    i += SCAN_VECTOR_SIZE;
+  }
+#else
+  const uint8x16_t zero = vdupq_n_u8 (0);
+  const uint8x16_t one = vdupq_n_u8 (1);
+
+  while (i + SCAN_VECTOR_SIZE + 3 <= size) {
+    uint8x16_t b0, b1, b2, m;
+    uint64x2_t m64;
+
+    b0 = vld1q_u8 (data + i);
+    b1 = vld1q_u8 (data + i + 1);
+    b2 = vld1q_u8 (data + i + 2);
+
+    m = vandq_u8 (vandq_u8 (vceqq_u8 (b0, zero), vceqq_u8 (b1, zero)),
+        vceqq_u8 (b2, one));
+    m64 = vreinterpretq_u64_u8 (m);
+    if (vgetq_lane_u64 (m64, 0) | vgetq_lane_u64 (m64, 1))
+      return scan_start_code_scalar (data, i, i + SCAN_VECTOR_SIZE + 3);
+
+    i += SCAN_VECTOR_SIZE;
+  }
+#endif
+
+  return scan_start_code_scalar (data, i, size);
+}
+#endif /* SCAN_VECTOR_SIZE */
+
+static inline gsize
+scan_start_code (const guint8 * data, gsize i, gsize size)
+{
+#ifdef SCAN_VECTOR_SIZE
+  return scan_start_code_vector (data, i, size);
+#else
+  return scan_start_code_scalar (data, i, size);
+#endif
+}
+
+/* Returns the offset of the first 0x000001 start code prefix in @data that
+ * is followed by at least one more byte, or -1 if there is none */
+gint
+scan_for_start_code_prefix (const guint8 * data, gsize size)
+{
+  gsize off;
+
+  off = scan_start_code (data, 0, size);
+  if (off >= size)
+    return -1;
+
+  return (gint) off;
+}
@@ -25,6 +25,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstbitreader.h>
 
+#include "startcodeutils.h"
+
 /* Parsing utils */
 #define GET_BITS(b, num, bits) G_STMT_START {        \
   if (!gst_bit_reader_get_bits_uint32(b, bits, num)) \
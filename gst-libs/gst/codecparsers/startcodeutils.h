@@ -0,0 +1,30 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __START_CODE_UTILS__
+#define __START_CODE_UTILS__
+
+#include <glib.h>
+
+/* Start code scanning, implemented in parserutils.c and shared by all the
+ * start code based parsers. Kept out of parserutils.h so that nalutils.c can
+ * use it without pulling in the conflicting bit reader macros. */
+G_GNUC_INTERNAL gint
+scan_for_start_code_prefix (const guint8 * data, gsize size);
+
+#endif /* __START_CODE_UTILS__ */
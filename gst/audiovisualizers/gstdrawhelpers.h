@@ -20,6 +20,12 @@
  */
  
 /* FIXME: add versions that don't ignore alpha */
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#endif
  
 #define draw_dot(_vd, _x, _y, _st, _c) G_STMT_START {                          \
   _vd[(_y * _st) + _x] = _c;                                                   \
@@ -45,43 +51,99 @@
 #define draw_line(_vd, _x1, _x2, _y1, _y2, _st, _c) G_STMT_START {             \
   guint _i, _j, _x, _y;                                                        \
   gint _dx = _x2 - _x1, _dy = _y2 - _y1;                                       \
-  gfloat _f;                                                                   \
+  gfloat _f, _fs;                                                              \
                                                                                \
   _j = abs (_dx) > abs (_dy) ? abs (_dx) : abs (_dy);                          \
+  _fs = 1.0f / (gfloat) _j;                                                    \
   for (_i = 0; _i < _j; _i++) {                                                \
-    _f = (gfloat) _i / (gfloat) _j;                                            \
+    _f = (gfloat) _i * _fs;                                                    \
     _x = _x1 + _dx * _f;                                                       \
     _y = _y1 + _dy * _f;                                                       \
     draw_dot (_vd, _x, _y, _st, _c);                                           \
   }                                                                            \
 } G_STMT_END
 
+/* Horizontal and vertical lines hit whole pixels, they are drawn as spans
+ * without fractional positions. Most lines of the scopes are one of these,
+ * as consecutive samples are often on the same column. */
 #define draw_line_aa(_vd, _x1, _x2, _y1, _y2, _st, _c) G_STMT_START {          \
   guint _i, _j, _x, _y;                                                        \
   gint _dx = _x2 - _x1, _dy = _y2 - _y1;                                       \
-  gfloat _f, _rx, _ry, _fx, _fy;                                               \
+  gfloat _f, _fs, _rx, _ry, _fx, _fy;                                          \
                                                                                \
   _j = abs (_dx) > abs (_dy) ? abs (_dx) : abs (_dy);                          \
-  for (_i = 0; _i < _j; _i++) {                                                \
-    _f = (gfloat) _i / (gfloat) _j;                                            \
-    _rx = _x1 + _dx * _f;                                                      \
-    _ry = _y1 + _dy * _f;                                                      \
-    _x = (guint)_rx;                                                           \
-    _y = (guint)_ry;                                                           \
-    _fx = _rx - (gfloat)_x;                                                    \
-    _fy = _ry - (gfloat)_y;                                                    \
+  if (_dx == 0 || _dy == 0) {                                                  \
+    gint _sx = (_dx > 0) - (_dx < 0), _sy = (_dy > 0) - (_dy < 0);             \
+                                                                               \
+    _x = _x1;                                                                  \
+    _y = _y1;                                                                  \
+    for (_i = 0; _i < _j; _i++, _x += _sx, _y += _sy) {                        \
+      draw_dot_aa (_vd, _x, _y, _st, _c, 1.0);                                 \
+      draw_dot_aa (_vd, (_x + 1), _y, _st, _c, 0.5);                           \
+      draw_dot_aa (_vd, _x, (_y + 1), _st, _c, 0.5);                           \
+    }                                                                          \
+  } else {                                                                     \
+    _fs = 1.0f / (gfloat) _j;                                                  \
+    for (_i = 0; _i < _j; _i++) {                                              \
+      _f = (gfloat) _i * _fs;                                                  \
+      _rx = _x1 + _dx * _f;                                                    \
+      _ry = _y1 + _dy * _f;                                                    \
+      _x = (guint)_rx;                                                         \
+      _y = (guint)_ry;                                                         \
+      _fx = _rx - (gfloat)_x;                                                  \
+      _fy = _ry - (gfloat)_y;                                                  \
                                                                                \
-    _f = ((1.0 - _fx) + (1.0 - _fy)) / 2.0;                                    \
-    draw_dot_aa (_vd, _x, _y, _st, _c, _f);                                    \
+      _f = ((1.0 - _fx) + (1.0 - _fy)) / 2.0;                                  \
+      draw_dot_aa (_vd, _x, _y, _st, _c, _f);                                  \
                                                                                \
-    _f = (_fx + (1.0 - _fy)) / 2.0;                                            \
-    draw_dot_aa (_vd, (_x + 1), _y, _st, _c, _f);                              \
+      _f = (_fx + (1.0 - _fy)) / 2.0;                                          \
+      draw_dot_aa (_vd, (_x + 1), _y, _st, _c, _f);                            \
                                                                                \
-    _f = ((1.0 - _fx) + _fy) / 2.0;                                            \
-    draw_dot_aa (_vd, _x, (_y + 1), _st, _c, _f);                              \
+      _f = ((1.0 - _fx) + _fy) / 2.0;                                          \
+      draw_dot_aa (_vd, _x, (_y + 1), _st, _c, _f);                            \
                                                                                \
-    _f = (_fx + _fy) / 2.0;                                                    \
-    draw_dot_aa (_vd, (_x + 1), (_y + 1), _st, _c, _f);                        \
+      _f = (_fx + _fy) / 2.0;                                                  \
+      draw_dot_aa (_vd, (_x + 1), (_y + 1), _st, _c, _f);                      \
+    }                                                                          \
   }                                                                            \
 } G_STMT_END
 
+/* saturating add of the colour @_c to the pixel @_p */
+static inline void
+add_pixel (guint32 * _p, guint32 _c)
+{
+  guint8 *p = (guint8 *) _p;
+  guint8 *c = (guint8 *) & _c;
+
+  p[0] = MIN (p[0] + c[0], 255);
+  p[1] = MIN (p[1] + c[1], 255);
+  p[2] = MIN (p[2] + c[2], 255);
+  p[3] = MIN (p[3] + c[3], 255);
+}
+
+/* saturating add of the colours @c to the @n pixels from @p on */
+static inline void
+add_span (guint32 * p, const guint32 * c, guint n)
+{
+  guint i = 0;
+
+#if defined (__SSE2__)
+  for (; i + 4 <= n; i += 4) {
+    __m128i v = _mm_loadu_si128 ((__m128i *) (p + i));
+
+    v = _mm_adds_epu8 (v, _mm_loadu_si128 ((const __m128i *) (c + i)));
+    _mm_storeu_si128 ((__m128i *) (p + i), v);
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  for (; i + 4 <= n; i += 4) {
+    uint8x16_t v = vreinterpretq_u8_u32 (vld1q_u32 (p + i));
+
+    v = vqaddq_u8 (v, vreinterpretq_u8_u32 (vld1q_u32 (c + i)));
+    vst1q_u32 (p + i, vreinterpretq_u32_u8 (v));
+  }
+#endif
+
+  for (; i < n; i++)
+    add_pixel (&p[i], c[i]);
+}
+
@@ -39,6 +39,7 @@
 #include <stdlib.h>
 
 #include "gstspectrascope.h"
+#include "gstdrawhelpers.h"
 
 #if G_BYTE_ORDER == G_BIG_ENDIAN
 #define RGB_ORDER "xRGB"
@@ -118,6 +119,8 @@ gst_spectra_scope_finalize (GObject * object)
     g_free (scope->freq_data);
     scope->freq_data = NULL;
   }
+  g_free (scope->tops);
+  scope->tops = NULL;
 
   G_OBJECT_CLASS (gst_spectra_scope_parent_class)->finalize (object);
 }
@@ -131,37 +134,57 @@ gst_spectra_scope_setup (GstAudioVisualizer * bscope)
   if (scope->fft_ctx)
     gst_fft_s16_free (scope->fft_ctx);
   g_free (scope->freq_data);
+  g_free (scope->tops);
 
   /* we'd need this amount of samples per render() call */
   bscope->req_spf = num_freq * 2 - 2;
   scope->fft_ctx = gst_fft_s16_new (bscope->req_spf, FALSE);
   scope->freq_data = g_new (GstFFTS16Complex, num_freq);
+  scope->tops = g_new (gint, GST_VIDEO_INFO_WIDTH (&bscope->vinfo));
 
   return TRUE;
 }
 
-static inline void
-add_pixel (guint32 * _p, guint32 _c)
+/* saturating add of @c to the pixels of @row whose bar starts above line
+ * @y */
+static void
+add_bars_row (guint32 * row, const gint * tops, gint y, guint32 c, guint w)
 {
-  guint8 *p = (guint8 *) _p;
-  guint8 *c = (guint8 *) & _c;
-
-  if (p[0] < 255 - c[0])
-    p[0] += c[0];
-  else
-    p[0] = 255;
-  if (p[1] < 255 - c[1])
-    p[1] += c[1];
-  else
-    p[1] = 255;
-  if (p[2] < 255 - c[2])
-    p[2] += c[2];
-  else
-    p[2] = 255;
-  if (p[3] < 255 - c[3])
-    p[3] += c[3];
-  else
-    p[3] = 255;
+  guint x = 0;
+
+#if defined (__SSE2__)
+  {
+    const __m128i cv = _mm_set1_epi32 (c);
+    const __m128i yv = _mm_set1_epi32 (y);
+
+    for (; x + 4 <= w; x += 4) {
+      __m128i m = _mm_cmplt_epi32 (_mm_loadu_si128 ((const __m128i *) (tops +
+                  x)), yv);
+      __m128i v = _mm_loadu_si128 ((__m128i *) (row + x));
+
+      v = _mm_adds_epu8 (v, _mm_and_si128 (m, cv));
+      _mm_storeu_si128 ((__m128i *) (row + x), v);
+    }
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    const uint32x4_t cv = vdupq_n_u32 (c);
+    const int32x4_t yv = vdupq_n_s32 (y);
+
+    for (; x + 4 <= w; x += 4) {
+      uint32x4_t m = vcltq_s32 (vld1q_s32 (tops + x), yv);
+      uint8x16_t v = vreinterpretq_u8_u32 (vld1q_u32 (row + x));
+
+      v = vqaddq_u8 (v, vreinterpretq_u8_u32 (vandq_u32 (m, cv)));
+      vst1q_u32 (row + x, vreinterpretq_u32_u8 (v));
+    }
+  }
+#endif
+
+  for (; x < w; x++) {
+    if (tops[x] < y)
+      add_pixel (&row[x], c);
+  }
 }
 
 static gboolean
@@ -171,7 +194,8 @@ gst_spectra_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
   GstSpectraScope *scope = GST_SPECTRA_SCOPE (bscope);
   gint16 *mono_adata;
   GstFFTS16Complex *fdata = scope->freq_data;
-  guint x, y, off, l;
+  gint *tops = scope->tops;
+  guint x, y, l, top;
   guint w = GST_VIDEO_INFO_WIDTH (&bscope->vinfo);
   guint h = GST_VIDEO_INFO_HEIGHT (&bscope->vinfo) - 1;
   gfloat fr, fi;
@@ -207,6 +231,7 @@ gst_spectra_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
   g_free (mono_adata);
 
   /* draw lines */
+  top = h;
   for (x = 0; x < w; x++) {
     /* figure out the range so that we don't need to clip,
      * or even better do a log mapping? */
@@ -216,15 +241,15 @@ gst_spectra_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
     if (y > h)
       y = h;
     y = h - y;
-    off = (y * w) + x;
-    vdata[off] = 0x00FFFFFF;
-    for (l = y; l < h; l++) {
-      off += w;
-      add_pixel (&vdata[off], 0x007F7F7F);
-    }
-    /* ensure bottom line is full bright (especially in move-up mode) */
-    add_pixel (&vdata[off], 0x007F7F7F);
+    tops[x] = y;
+    top = MIN (top, y);
+    vdata[(y * w) + x] = 0x00FFFFFF;
   }
+  /* fill the bars below their tops a row at a time */
+  for (l = top + 1; l <= h; l++)
+    add_bars_row (&vdata[l * w], tops, l, 0x007F7F7F, w);
+  /* ensure bottom line is full bright (especially in move-up mode) */
+  add_bars_row (&vdata[h * w], tops, G_MAXINT, 0x007F7F7F, w);
   gst_buffer_unmap (audio, &amap);
   return TRUE;
 }
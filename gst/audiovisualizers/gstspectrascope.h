@@ -40,6 +40,8 @@ struct _GstSpectraScope
 
   GstFFTS16 *fft_ctx;
   GstFFTS16Complex *freq_data;
+  /* first row of the bar of each column */
+  gint *tops;
 };
 
 struct _GstSpectraScopeClass
@@ -37,6 +37,11 @@
 #endif
 
 #include "gstsynaescope.h"
+#include "gstdrawhelpers.h"
+
+/* the arms of a star get at most this long, shade[] reaches 0 after 20
+ * steps */
+#define MAX_ARM 32
 
 #if G_BYTE_ORDER == G_BIG_ENDIAN
 #define RGB_ORDER "xRGB"
@@ -178,30 +183,6 @@ gst_synae_scope_setup (GstAudioVisualizer * bscope)
   return TRUE;
 }
 
-static inline void
-add_pixel (guint32 * _p, guint32 _c)
-{
-  guint8 *p = (guint8 *) _p;
-  guint8 *c = (guint8 *) & _c;
-
-  if (p[0] < 255 - c[0])
-    p[0] += c[0];
-  else
-    p[0] = 255;
-  if (p[1] < 255 - c[1])
-    p[1] += c[1];
-  else
-    p[1] = 255;
-  if (p[2] < 255 - c[2])
-    p[2] += c[2];
-  else
-    p[2] = 255;
-  if (p[3] < 255 - c[3])
-    p[3] += c[3];
-  else
-    p[3] = 255;
-}
-
 static gboolean
 gst_synae_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
     GstVideoFrame * video)
@@ -225,6 +206,8 @@ gst_synae_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
   guint num_samples;
   gint i, j, b;
   gint br, br1, br2;
+  guint32 arm[MAX_ARM], rarm[MAX_ARM];
+  gint n, nl, nr;
   gint clarity;
   gdouble fc, r, l, rr, ll;
   gdouble frl, fil, frr, fir;
@@ -279,29 +262,34 @@ gst_synae_scope_render (GstAudioVisualizer * bscope, GstBuffer * audio,
     GST_DEBUG ("y %3d fc %10.6f clarity %d br %d br1 %d br2 %d", y, fc, clarity,
         br, br1, br2);
 
-    /* draw a star */
+    /* draw a star, the colours of the arms from the centre outwards */
     off = (y * w) + x;
     c = colors[(br1 >> 4) | (br2 & 0xf0)];
     add_pixel (&vdata[off], c);
+    for (n = 0; (br1 || br2) && n < MAX_ARM;
+        n++, br1 = shade[br1], br2 = shade[br2])
+      arm[n] = colors[(br1 >> 4) | (br2 & 0xf0)];
+    for (i = 0; i < n; i++)
+      rarm[i] = arm[n - 1 - i];
+
+    /* the horizontal arms are spans, the vertical ones single pixels */
     if ((x > (sl - 1)) && (x < (w - sl)) && (y > (sl - 1)) && (y < (h - sl))) {
-      for (i = 1; br1 || br2; i++, br1 = shade[br1], br2 = shade[br2]) {
-        c = colors[(br1 >> 4) + (br2 & 0xf0)];
-        add_pixel (&vdata[off - i], c);
-        add_pixel (&vdata[off + i], c);
-        add_pixel (&vdata[off - i * w], c);
-        add_pixel (&vdata[off + i * w], c);
+      add_span (&vdata[off - n], rarm, n);
+      add_span (&vdata[off + 1], arm, n);
+      for (i = 1; i <= n; i++) {
+        add_pixel (&vdata[off - i * w], arm[i - 1]);
+        add_pixel (&vdata[off + i * w], arm[i - 1]);
       }
     } else {
-      for (i = 1; br1 || br2; i++, br1 = shade[br1], br2 = shade[br2]) {
-        c = colors[(br1 >> 4) | (br2 & 0xf0)];
-        if (x - i > 0)
-          add_pixel (&vdata[off - i], c);
-        if (x + i < (w - 1))
-          add_pixel (&vdata[off + i], c);
+      nl = CLAMP (x - 1, 0, n);
+      nr = CLAMP ((gint) w - 2 - x, 0, n);
+      add_span (&vdata[off - nl], rarm + n - nl, nl);
+      add_span (&vdata[off + 1], arm, nr);
+      for (i = 1; i <= n; i++) {
         if (y - i > 0)
-          add_pixel (&vdata[off - i * w], c);
+          add_pixel (&vdata[off - i * w], arm[i - 1]);
         if (y + i < (h - 1))
-          add_pixel (&vdata[off + i * w], c);
+          add_pixel (&vdata[off + i * w], arm[i - 1]);
       }
     }
   }
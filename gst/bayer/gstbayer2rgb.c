@@ -25,6 +25,18 @@
  * SECTION:element-bayer2rgb
  *
  * Decodes raw camera bayer (fourcc BA81) to RGB.
+ *
+ * Besides 8 bit bayer, 10, 12 and 16 bit little and big endian bayer
+ * (formats such as bggr12le) is accepted. The output can be 32 bit RGB,
+ * ARGB64 to keep the full precision of deep input, or I420 and NV12 to
+ * save a conversion before encoding.
+ *
+ * The #GstBayer2RGB:method property selects between the fast bilinear
+ * interpolation and an edge-aware interpolation that interpolates green
+ * along edges and the other colours from the colour differences, which
+ * avoids most of the zipper and false colour artefacts at the cost of
+ * some speed. Frames are processed in bands by #GstBayer2RGB:threads
+ * threads.
  */
 
 /*
@@ -98,6 +110,21 @@ enum
   GST_BAYER_2_RGB_FORMAT_RGGB
 };
 
+typedef enum
+{
+  GST_BAYER_2_RGB_METHOD_BILINEAR,
+  GST_BAYER_2_RGB_METHOD_EDGE_AWARE
+} GstBayer2RGBMethod;
+
+/* the colour of a bayer sample and, for green, the colour of its horizontal
+ * neighbours */
+enum
+{
+  SITE_R,
+  SITE_B,
+  SITE_G_ON_R,
+  SITE_G_ON_B
+};
 
 #define GST_TYPE_BAYER2RGB            (gst_bayer2rgb_get_type())
 #define GST_BAYER2RGB(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),GST_TYPE_BAYER2RGB,GstBayer2RGB))
@@ -107,9 +134,34 @@ enum
 #define GST_BAYER2RGB_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS((obj) ,GST_TYPE_BAYER2RGB,GstBayer2RGBClass))
 typedef struct _GstBayer2RGB GstBayer2RGB;
 typedef struct _GstBayer2RGBClass GstBayer2RGBClass;
+typedef struct _GstBayer2RGBBand GstBayer2RGBBand;
 
 typedef void (*GstBayer2RGBProcessFunc) (GstBayer2RGB *, guint8 *, guint);
 
+/* number of cached input lines, enough for the 7 lines used by the
+ * edge-aware interpolation of one output line */
+#define N_INPUT_LINES 8
+#define N_GREEN_LINES 4
+/* samples of padding on each side of the cached input lines */
+#define PAD 3
+
+/* a band of lines of the frame, converted by one thread */
+struct _GstBayer2RGBBand
+{
+  guint index;
+
+  /* horizontally upsampled lines for the 8 bit bilinear path */
+  guint8 *tmp;
+  /* unpacked input lines with mirrored padding, and the lines they are for */
+  guint16 *input[N_INPUT_LINES];
+  gint input_line[N_INPUT_LINES];
+  /* interpolated green of the edge-aware path, one sample of padding */
+  guint16 *green[N_GREEN_LINES];
+  gint green_line[N_GREEN_LINES];
+  /* demosaiced r, g and b of the current pair of lines */
+  guint16 *rgb[2][3];
+};
+
 struct _GstBayer2RGB
 {
   GstBaseTransform basetransform;
@@ -122,6 +174,30 @@ struct _GstBayer2RGB
   int g_off;                    /* offset for green */
   int b_off;                    /* offset for blue */
   int format;
+  int depth;                    /* bits per bayer sample */
+  gboolean big_endian;
+  int sites[2][2];              /* site of the samples by line and column parity */
+
+  /* fixed point RGB to YUV coefficients for I420 and NV12 output */
+  gint cy[3], cu[3], cv[3];
+
+  /* properties */
+  GstBayer2RGBMethod method;
+  guint threads;
+
+  /* the frame being converted */
+  const guint8 *src;
+  int src_stride;
+  GstVideoFrame *dest;
+
+  /* band threading, band 0 runs in the streaming thread */
+  GThreadPool *pool;
+  GstBayer2RGBBand *bands;
+  guint n_threads;
+  guint n_bands;
+  GMutex band_lock;
+  GCond band_cond;
+  guint bands_pending;
 };
 
 struct _GstBayer2RGBClass
@@ -130,16 +206,52 @@ struct _GstBayer2RGBClass
 };
 
 #define	SRC_CAPS                                 \
-  GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR }")
+  GST_VIDEO_CAPS_MAKE ("{ RGBx, xRGB, BGRx, xBGR, RGBA, ARGB, BGRA, ABGR, " \
+      "ARGB64, I420, NV12 }")
 
-#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb}," \
+#define BAYER_FORMATS(depth) \
+  "bggr" depth "le,grbg" depth "le,gbrg" depth "le,rggb" depth "le," \
+  "bggr" depth "be,grbg" depth "be,gbrg" depth "be,rggb" depth "be"
+
+#define SINK_CAPS "video/x-bayer,format=(string){bggr,grbg,gbrg,rggb," \
+  BAYER_FORMATS ("10") "," BAYER_FORMATS ("12") "," BAYER_FORMATS ("16") "}," \
   "width=(int)[1,MAX],height=(int)[1,MAX],framerate=(fraction)[0/1,MAX]"
 
+#define DEFAULT_METHOD GST_BAYER_2_RGB_METHOD_BILINEAR
+#define DEFAULT_THREADS 0
+
+#define MAX_THREADS 64
+/* don't bother handing out bands smaller than this many lines */
+#define MIN_BAND_HEIGHT 64
+
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_METHOD,
+  PROP_THREADS
 };
 
+#define GST_TYPE_BAYER2RGB_METHOD (gst_bayer2rgb_method_get_type ())
+static GType
+gst_bayer2rgb_method_get_type (void)
+{
+  static GType bayer2rgb_method_type = 0;
+
+  if (!bayer2rgb_method_type) {
+    static const GEnumValue method_types[] = {
+      {GST_BAYER_2_RGB_METHOD_BILINEAR, "Bilinear interpolation", "bilinear"},
+      {GST_BAYER_2_RGB_METHOD_EDGE_AWARE,
+          "Edge-aware interpolation (Hamilton-Adams)", "edge-aware"},
+      {0, NULL, NULL},
+    };
+
+    bayer2rgb_method_type =
+        g_enum_register_static ("GstBayer2RGBMethod", method_types);
+  }
+
+  return bayer2rgb_method_type;
+}
+
 GType gst_bayer2rgb_get_type (void);
 
 #define gst_bayer2rgb_parent_class parent_class
@@ -149,7 +261,10 @@ static void gst_bayer2rgb_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
 static void gst_bayer2rgb_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
+static void gst_bayer2rgb_finalize (GObject * object);
 
+static gboolean gst_bayer2rgb_start (GstBaseTransform * base);
+static gboolean gst_bayer2rgb_stop (GstBaseTransform * base);
 static gboolean gst_bayer2rgb_set_caps (GstBaseTransform * filter,
     GstCaps * incaps, GstCaps * outcaps);
 static GstFlowReturn gst_bayer2rgb_transform (GstBaseTransform * base,
@@ -159,6 +274,8 @@ static GstCaps *gst_bayer2rgb_transform_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter);
 static gboolean gst_bayer2rgb_get_unit_size (GstBaseTransform * base,
     GstCaps * caps, gsize * size);
+static void gst_bayer2rgb_process_band_func (GstBayer2RGBBand * band,
+    GstBayer2RGB * filter);
 
 
 static void
@@ -172,6 +289,18 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 
   gobject_class->set_property = gst_bayer2rgb_set_property;
   gobject_class->get_property = gst_bayer2rgb_get_property;
+  gobject_class->finalize = gst_bayer2rgb_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method", "Demosaicing method",
+          GST_TYPE_BAYER2RGB_METHOD, DEFAULT_METHOD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of threads converting bands of each frame "
+          "(0 = number of processors)", 0, MAX_THREADS, DEFAULT_THREADS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class,
       "Bayer to RGB decoder for cameras", "Filter/Converter/Video",
@@ -189,6 +318,10 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_transform_caps);
   GST_BASE_TRANSFORM_CLASS (klass)->get_unit_size =
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_get_unit_size);
+  GST_BASE_TRANSFORM_CLASS (klass)->start =
+      GST_DEBUG_FUNCPTR (gst_bayer2rgb_start);
+  GST_BASE_TRANSFORM_CLASS (klass)->stop =
+      GST_DEBUG_FUNCPTR (gst_bayer2rgb_stop);
   GST_BASE_TRANSFORM_CLASS (klass)->set_caps =
       GST_DEBUG_FUNCPTR (gst_bayer2rgb_set_caps);
   GST_BASE_TRANSFORM_CLASS (klass)->transform =
@@ -201,17 +334,41 @@ gst_bayer2rgb_class_init (GstBayer2RGBClass * klass)
 static void
 gst_bayer2rgb_init (GstBayer2RGB * filter)
 {
+  filter->method = DEFAULT_METHOD;
+  filter->threads = DEFAULT_THREADS;
+  g_mutex_init (&filter->band_lock);
+  g_cond_init (&filter->band_cond);
+
   gst_bayer2rgb_reset (filter);
   gst_base_transform_set_in_place (GST_BASE_TRANSFORM (filter), TRUE);
 }
 
-/* No properties are implemented, so only a warning is produced */
+static void
+gst_bayer2rgb_finalize (GObject * object)
+{
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
+
+  g_mutex_clear (&filter->band_lock);
+  g_cond_clear (&filter->band_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_bayer2rgb_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      GST_OBJECT_LOCK (filter);
+      filter->method = g_value_get_enum (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_THREADS:
+      filter->threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -222,14 +379,138 @@ static void
 gst_bayer2rgb_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
+  GstBayer2RGB *filter = GST_BAYER2RGB (object);
 
   switch (prop_id) {
+    case PROP_METHOD:
+      g_value_set_enum (value, filter->method);
+      break;
+    case PROP_THREADS:
+      g_value_set_uint (value, filter->threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* Parses a bayer format such as bggr or rggb12le into its arrangement, bits
+ * per sample and endianness */
+static gboolean
+gst_bayer2rgb_parse_format (const gchar * format, int *arrangement,
+    int *depth, gboolean * big_endian)
+{
+  if (format == NULL || strlen (format) < 4)
+    return FALSE;
+
+  if (g_str_has_prefix (format, "bggr")) {
+    *arrangement = GST_BAYER_2_RGB_FORMAT_BGGR;
+  } else if (g_str_has_prefix (format, "gbrg")) {
+    *arrangement = GST_BAYER_2_RGB_FORMAT_GBRG;
+  } else if (g_str_has_prefix (format, "grbg")) {
+    *arrangement = GST_BAYER_2_RGB_FORMAT_GRBG;
+  } else if (g_str_has_prefix (format, "rggb")) {
+    *arrangement = GST_BAYER_2_RGB_FORMAT_RGGB;
+  } else {
+    return FALSE;
+  }
+
+  format += 4;
+  if (*format == '\0') {
+    *depth = 8;
+    *big_endian = FALSE;
+    return TRUE;
+  }
+
+  if (g_str_equal (format, "10le") || g_str_equal (format, "10be")) {
+    *depth = 10;
+  } else if (g_str_equal (format, "12le") || g_str_equal (format, "12be")) {
+    *depth = 12;
+  } else if (g_str_equal (format, "16le") || g_str_equal (format, "16be")) {
+    *depth = 16;
+  } else {
+    return FALSE;
+  }
+  *big_endian = g_str_equal (format + 2, "be");
+
+  return TRUE;
+}
+
+/* Lines of bayer input are padded to 4 bytes */
+static int
+gst_bayer2rgb_input_stride (int width, int depth)
+{
+  return GST_ROUND_UP_4 (depth > 8 ? width * 2 : width);
+}
+
+static void
+gst_bayer2rgb_free_bands (GstBayer2RGB * filter)
+{
+  guint i, j;
+
+  if (!filter->bands)
+    return;
+
+  for (i = 0; i < filter->n_threads; i++) {
+    GstBayer2RGBBand *band = &filter->bands[i];
+
+    g_free (band->tmp);
+    band->tmp = NULL;
+    for (j = 0; j < N_INPUT_LINES; j++) {
+      g_free (band->input[j]);
+      band->input[j] = NULL;
+    }
+    for (j = 0; j < N_GREEN_LINES; j++) {
+      g_free (band->green[j]);
+      band->green[j] = NULL;
+    }
+    for (j = 0; j < 3; j++) {
+      g_free (band->rgb[0][j]);
+      g_free (band->rgb[1][j]);
+      band->rgb[0][j] = band->rgb[1][j] = NULL;
+    }
+  }
+}
+
+static void
+gst_bayer2rgb_alloc_bands (GstBayer2RGB * filter)
+{
+  const int width = filter->width;
+  guint i, j;
+
+  gst_bayer2rgb_free_bands (filter);
+
+  for (i = 0; i < filter->n_threads; i++) {
+    GstBayer2RGBBand *band = &filter->bands[i];
+
+    band->tmp = g_malloc (2 * 4 * width);
+    for (j = 0; j < N_INPUT_LINES; j++) {
+      band->input[j] = g_new (guint16, width + 2 * PAD);
+      band->input_line[j] = -1;
+    }
+    for (j = 0; j < N_GREEN_LINES; j++) {
+      band->green[j] = g_new (guint16, width + 2);
+      band->green_line[j] = -1;
+    }
+    for (j = 0; j < 3; j++) {
+      band->rgb[0][j] = g_new (guint16, width);
+      band->rgb[1][j] = g_new (guint16, width);
+    }
+  }
+}
+
+/* the sites of the 2x2 pattern of each arrangement, in reading order */
+static const int bayer_sites[4][4] = {
+  /* BGGR */
+  {SITE_B, SITE_G_ON_B, SITE_G_ON_R, SITE_R},
+  /* GBRG */
+  {SITE_G_ON_B, SITE_B, SITE_R, SITE_G_ON_R},
+  /* GRBG */
+  {SITE_G_ON_R, SITE_R, SITE_B, SITE_G_ON_B},
+  /* RGGB */
+  {SITE_R, SITE_G_ON_R, SITE_G_ON_B, SITE_B}
+};
+
 static gboolean
 gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
     GstCaps * outcaps)
@@ -238,6 +519,8 @@ gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
   GstStructure *structure;
   const char *format;
   GstVideoInfo info;
+  gdouble kr, kb, kg;
+  int i;
 
   GST_DEBUG ("in caps %" GST_PTR_FORMAT " out caps %" GST_PTR_FORMAT, incaps,
       outcaps);
@@ -248,26 +531,55 @@ gst_bayer2rgb_set_caps (GstBaseTransform * base, GstCaps * incaps,
   gst_structure_get_int (structure, "height", &bayer2rgb->height);
 
   format = gst_structure_get_string (structure, "format");
-  if (g_str_equal (format, "bggr")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_BGGR;
-  } else if (g_str_equal (format, "gbrg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GBRG;
-  } else if (g_str_equal (format, "grbg")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_GRBG;
-  } else if (g_str_equal (format, "rggb")) {
-    bayer2rgb->format = GST_BAYER_2_RGB_FORMAT_RGGB;
-  } else {
+  if (!gst_bayer2rgb_parse_format (format, &bayer2rgb->format,
+          &bayer2rgb->depth, &bayer2rgb->big_endian)) {
     return FALSE;
   }
 
+  /* the interpolation mirrors up to 3 samples at the edges */
+  if (bayer2rgb->width < 4 || bayer2rgb->height < 4) {
+    GST_DEBUG_OBJECT (bayer2rgb, "frames of %dx%d are too small",
+        bayer2rgb->width, bayer2rgb->height);
+    return FALSE;
+  }
+
+  /* the site of each sample of the 2x2 pattern */
+  for (i = 0; i < 4; i++)
+    bayer2rgb->sites[i >> 1][i & 1] = bayer_sites[bayer2rgb->format][i];
+
   /* To cater for different RGB formats, we need to set params for later */
-  gst_video_info_from_caps (&info, outcaps);
+  if (!gst_video_info_from_caps (&info, outcaps))
+    return FALSE;
   bayer2rgb->r_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 0);
   bayer2rgb->g_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 1);
   bayer2rgb->b_off = GST_VIDEO_INFO_COMP_OFFSET (&info, 2);
 
+  /* 8 bit RGB to limited range YUV, in 1.15 fixed point */
+  if (!gst_video_color_matrix_get_Kr_Kb (info.colorimetry.matrix, &kr, &kb)) {
+    kr = 0.299;
+    kb = 0.114;
+  }
+  kg = 1.0 - kr - kb;
+  bayer2rgb->cy[0] = kr * 219.0 / 255.0 * 32768.0 + 0.5;
+  bayer2rgb->cy[1] = kg * 219.0 / 255.0 * 32768.0 + 0.5;
+  bayer2rgb->cy[2] = kb * 219.0 / 255.0 * 32768.0 + 0.5;
+  bayer2rgb->cu[0] = -kr / (2.0 * (1.0 - kb)) * 224.0 / 255.0 * 32768.0 - 0.5;
+  bayer2rgb->cu[1] = -kg / (2.0 * (1.0 - kb)) * 224.0 / 255.0 * 32768.0 - 0.5;
+  bayer2rgb->cu[2] = -bayer2rgb->cu[0] - bayer2rgb->cu[1];
+  bayer2rgb->cv[1] = -kg / (2.0 * (1.0 - kr)) * 224.0 / 255.0 * 32768.0 - 0.5;
+  bayer2rgb->cv[2] = -kb / (2.0 * (1.0 - kr)) * 224.0 / 255.0 * 32768.0 - 0.5;
+  bayer2rgb->cv[0] = -bayer2rgb->cv[1] - bayer2rgb->cv[2];
+
   bayer2rgb->info = info;
 
+  bayer2rgb->n_bands = CLAMP (bayer2rgb->height / MIN_BAND_HEIGHT, 1,
+      bayer2rgb->n_threads);
+  gst_bayer2rgb_alloc_bands (bayer2rgb);
+
+  GST_DEBUG_OBJECT (bayer2rgb, "%d bit bayer to %s, %u bands",
+      bayer2rgb->depth, gst_video_format_to_string (GST_VIDEO_INFO_FORMAT
+          (&info)), bayer2rgb->n_bands);
+
   return TRUE;
 }
 
@@ -279,9 +591,56 @@ gst_bayer2rgb_reset (GstBayer2RGB * filter)
   filter->r_off = 0;
   filter->g_off = 0;
   filter->b_off = 0;
+  filter->depth = 8;
+  filter->big_endian = FALSE;
   gst_video_info_init (&filter->info);
 }
 
+static gboolean
+gst_bayer2rgb_start (GstBaseTransform * base)
+{
+  GstBayer2RGB *filter = GST_BAYER2RGB (base);
+  guint i;
+
+  filter->n_threads = filter->threads;
+  if (filter->n_threads == 0)
+    filter->n_threads = MIN (g_get_num_processors (), MAX_THREADS);
+  filter->n_bands = 1;
+
+  filter->bands = g_new0 (GstBayer2RGBBand, filter->n_threads);
+  for (i = 0; i < filter->n_threads; i++)
+    filter->bands[i].index = i;
+
+  if (filter->n_threads > 1) {
+    filter->pool =
+        g_thread_pool_new ((GFunc) gst_bayer2rgb_process_band_func, filter,
+        filter->n_threads - 1, FALSE, NULL);
+  }
+
+  GST_DEBUG_OBJECT (filter, "using %u threads", filter->n_threads);
+
+  return TRUE;
+}
+
+static gboolean
+gst_bayer2rgb_stop (GstBaseTransform * base)
+{
+  GstBayer2RGB *filter = GST_BAYER2RGB (base);
+
+  if (filter->pool) {
+    g_thread_pool_free (filter->pool, FALSE, TRUE);
+    filter->pool = NULL;
+  }
+  gst_bayer2rgb_free_bands (filter);
+  g_free (filter->bands);
+  filter->bands = NULL;
+  filter->n_threads = 0;
+
+  gst_bayer2rgb_reset (filter);
+
+  return TRUE;
+}
+
 static GstCaps *
 gst_bayer2rgb_transform_caps (GstBaseTransform * base,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter)
@@ -322,8 +681,11 @@ gst_bayer2rgb_get_unit_size (GstBaseTransform * base, GstCaps * caps,
     gsize * size)
 {
   GstStructure *structure;
+  GstVideoInfo info;
   int width;
   int height;
+  int arrangement, depth;
+  gboolean big_endian;
   const char *name;
 
   structure = gst_caps_get_structure (caps, 0);
@@ -333,11 +695,14 @@ gst_bayer2rgb_get_unit_size (GstBaseTransform * base, GstCaps * caps,
     name = gst_structure_get_name (structure);
     /* Our name must be either video/x-bayer video/x-raw */
     if (strcmp (name, "video/x-raw")) {
-      *size = GST_ROUND_UP_4 (width) * height;
+      if (!gst_bayer2rgb_parse_format (gst_structure_get_string (structure,
+                  "format"), &arrangement, &depth, &big_endian))
+        depth = 8;
+      *size = gst_bayer2rgb_input_stride (width, depth) * height;
       return TRUE;
-    } else {
-      /* For output, calculate according to format (always 32 bits) */
-      *size = width * height * 4;
+    } else if (gst_video_info_from_caps (&info, caps)) {
+      /* For output, calculate according to format */
+      *size = GST_VIDEO_INFO_SIZE (&info);
       return TRUE;
     }
 
@@ -380,15 +745,18 @@ typedef void (*process_func) (guint8 * d0, const guint8 * s0, const guint8 * s1,
     const guint8 * s2, const guint8 * s3, const guint8 * s4, const guint8 * s5,
     int n);
 
-static void
-gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
-    int dest_stride, uint8_t * src, int src_stride)
+/* Picks the ORC merge functions for 8 bit bilinear decoding to 32 bit RGB,
+ * returns FALSE if the output is not handled by them */
+static gboolean
+gst_bayer2rgb_get_merge_funcs (GstBayer2RGB * bayer2rgb, process_func merge[2])
 {
-  int j;
-  guint8 *tmp;
-  process_func merge[2] = { NULL, NULL };
   int r_off, g_off, b_off;
 
+  if (GST_VIDEO_INFO_N_PLANES (&bayer2rgb->info) != 1 ||
+      GST_VIDEO_INFO_COMP_DEPTH (&bayer2rgb->info, 0) != 8 ||
+      !GST_VIDEO_INFO_IS_RGB (&bayer2rgb->info))
+    return FALSE;
+
   /* We exploit some symmetry in the functions here.  The base functions
    * are all named for the BGGR arrangement.  For RGGB, we swap the
    * red offset and blue offset in the output.  For GRBG, we swap the
@@ -402,6 +770,7 @@ gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
     b_off = bayer2rgb->r_off;
   }
 
+  merge[0] = merge[1] = NULL;
   if (r_off == 2 && g_off == 1 && b_off == 0) {
     merge[0] = bayer_orc_merge_bg_bgra;
     merge[1] = bayer_orc_merge_gr_bgra;
@@ -422,32 +791,423 @@ gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, uint8_t * dest,
     merge[1] = tmp;
   }
 
-  tmp = g_malloc (2 * 4 * bayer2rgb->width);
+  return merge[0] != NULL;
+}
+
+/* 8 bit bilinear decoding of lines [first, last) to 32 bit RGB */
+static void
+gst_bayer2rgb_process (GstBayer2RGB * bayer2rgb, GstBayer2RGBBand * band,
+    process_func merge[2], uint8_t * dest, int dest_stride,
+    const uint8_t * src, int src_stride, int first, int last)
+{
+  int j;
+  guint8 *tmp = band->tmp;
+
 #define LINE(x) (tmp + ((x)&7) * bayer2rgb->width)
 
-  gst_bayer2rgb_split_and_upsample_horiz (LINE (3 * 2 + 0), LINE (3 * 2 + 1),
-      src + 1 * src_stride, bayer2rgb->width);
-  j = 0;
+  /* the line above the first one, mirrored at the top of the frame */
+  j = first - 1;
+  gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 + 0), LINE (j * 2 + 1),
+      src + (j < 0 ? 1 : j) * src_stride, bayer2rgb->width);
+  j = first;
   gst_bayer2rgb_split_and_upsample_horiz (LINE (j * 2 + 0), LINE (j * 2 + 1),
       src + j * src_stride, bayer2rgb->width);
 
-  for (j = 0; j < bayer2rgb->height; j++) {
-    if (j < bayer2rgb->height - 1) {
-      gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
-          LINE ((j + 1) * 2 + 1), src + (j + 1) * src_stride, bayer2rgb->width);
-    }
+  for (j = first; j < last; j++) {
+    /* the line below, mirrored at the bottom of the frame */
+    int next = j < bayer2rgb->height - 1 ? j + 1 : j - 1;
+
+    gst_bayer2rgb_split_and_upsample_horiz (LINE ((j + 1) * 2 + 0),
+        LINE ((j + 1) * 2 + 1), src + next * src_stride, bayer2rgb->width);
 
     merge[j & 1] (dest + j * dest_stride,
         LINE (j * 2 - 2), LINE (j * 2 - 1),
         LINE (j * 2 + 0), LINE (j * 2 + 1),
         LINE (j * 2 + 2), LINE (j * 2 + 3), bayer2rgb->width >> 1);
   }
+#undef LINE
+}
+
+/* Returns input line y, mirrored at the top and bottom of the frame, as
+ * samples padded with PAD mirrored samples on both sides. Recently used
+ * lines are cached in the band. */
+static const guint16 *
+gst_bayer2rgb_get_input_line (GstBayer2RGB * filter, GstBayer2RGBBand * band,
+    int y)
+{
+  const int width = filter->width;
+  const guint16 mask = (1 << filter->depth) - 1;
+  const guint8 *src;
+  guint16 *line;
+  int slot, i;
+
+  if (y < 0)
+    y = -y;
+  else if (y >= filter->height)
+    y = 2 * (filter->height - 1) - y;
+
+  slot = y & (N_INPUT_LINES - 1);
+  line = band->input[slot];
+  if (band->input_line[slot] == y)
+    return line + PAD;
+
+  src = filter->src + y * filter->src_stride;
+  if (filter->depth == 8) {
+    for (i = 0; i < width; i++)
+      line[PAD + i] = src[i];
+  } else if (filter->big_endian) {
+    for (i = 0; i < width; i++)
+      line[PAD + i] = GST_READ_UINT16_BE (src + 2 * i) & mask;
+  } else {
+    for (i = 0; i < width; i++)
+      line[PAD + i] = GST_READ_UINT16_LE (src + 2 * i) & mask;
+  }
+
+  /* mirroring keeps the bayer pattern */
+  for (i = 1; i <= PAD; i++) {
+    line[PAD - i] = line[PAD + i];
+    line[PAD + width - 1 + i] = line[PAD + width - 1 - i];
+  }
+  band->input_line[slot] = y;
+
+  return line + PAD;
+}
+
+static inline guint16
+clamp_sample (gint v, gint max)
+{
+  return CLAMP (v, 0, max);
+}
+
+/* Bilinear interpolation of line y */
+static void
+gst_bayer2rgb_bilinear_line (GstBayer2RGB * filter, GstBayer2RGBBand * band,
+    int y, guint16 * r, guint16 * g, guint16 * b)
+{
+  const guint16 *p0, *p1, *p2;
+  const int *sites = filter->sites[y & 1];
+  int x;
+
+  p0 = gst_bayer2rgb_get_input_line (filter, band, y - 1);
+  p1 = gst_bayer2rgb_get_input_line (filter, band, y);
+  p2 = gst_bayer2rgb_get_input_line (filter, band, y + 1);
+
+  for (x = 0; x < filter->width; x++) {
+    const guint16 c = p1[x];
+    const guint16 h = (p1[x - 1] + p1[x + 1] + 1) >> 1;
+    const guint16 v = (p0[x] + p2[x] + 1) >> 1;
+
+    switch (sites[x & 1]) {
+      case SITE_R:
+        r[x] = c;
+        g[x] = (p0[x] + p2[x] + p1[x - 1] + p1[x + 1] + 2) >> 2;
+        b[x] = (p0[x - 1] + p0[x + 1] + p2[x - 1] + p2[x + 1] + 2) >> 2;
+        break;
+      case SITE_B:
+        b[x] = c;
+        g[x] = (p0[x] + p2[x] + p1[x - 1] + p1[x + 1] + 2) >> 2;
+        r[x] = (p0[x - 1] + p0[x + 1] + p2[x - 1] + p2[x + 1] + 2) >> 2;
+        break;
+      case SITE_G_ON_R:
+        g[x] = c;
+        r[x] = h;
+        b[x] = v;
+        break;
+      case SITE_G_ON_B:
+        g[x] = c;
+        b[x] = h;
+        r[x] = v;
+        break;
+    }
+  }
+}
+
+/* Returns the green of line y interpolated along edges, with one sample of
+ * padding on both sides. For the red and blue samples, green is
+ * interpolated in the direction of the smallest gradient, corrected by the
+ * laplacian of the sample's own colour (Hamilton-Adams). */
+static const guint16 *
+gst_bayer2rgb_get_green_line (GstBayer2RGB * filter, GstBayer2RGBBand * band,
+    int y)
+{
+  const guint16 *p[5];
+  const int *sites;
+  const gint max = (1 << filter->depth) - 1;
+  guint16 *line;
+  int slot, i, x;
+
+  if (y < 0)
+    y = -y;
+  else if (y >= filter->height)
+    y = 2 * (filter->height - 1) - y;
+
+  slot = y & (N_GREEN_LINES - 1);
+  line = band->green[slot];
+  if (band->green_line[slot] == y)
+    return line + 1;
+
+  for (i = 0; i < 5; i++)
+    p[i] = gst_bayer2rgb_get_input_line (filter, band, y - 2 + i);
+  sites = filter->sites[y & 1];
+
+  for (x = -1; x <= filter->width; x++) {
+    const gint c = p[2][x];
+    gint dh, dv, gh, gv;
+
+    /* the padding is mirrored so the sites keep alternating */
+    if (sites[x & 1] == SITE_G_ON_R || sites[x & 1] == SITE_G_ON_B) {
+      line[x + 1] = c;
+      continue;
+    }
+
+    dh = ABS (p[2][x - 1] - p[2][x + 1]) + ABS (2 * c - p[2][x - 2] -
+        p[2][x + 2]);
+    dv = ABS (p[1][x] - p[3][x]) + ABS (2 * c - p[0][x] - p[4][x]);
+    gh = ((p[2][x - 1] + p[2][x + 1]) * 2 + 2 * c - p[2][x - 2] - p[2][x + 2]
+        + 2) >> 2;
+    gv = ((p[1][x] + p[3][x]) * 2 + 2 * c - p[0][x] - p[4][x] + 2) >> 2;
+
+    if (dh < dv)
+      line[x + 1] = clamp_sample (gh, max);
+    else if (dv < dh)
+      line[x + 1] = clamp_sample (gv, max);
+    else
+      line[x + 1] = clamp_sample ((gh + gv + 1) >> 1, max);
+  }
+  band->green_line[slot] = y;
+
+  return line + 1;
+}
+
+/* Edge-aware interpolation of line y: green along edges, red and blue from
+ * the interpolated colour differences of their neighbours */
+static void
+gst_bayer2rgb_edge_aware_line (GstBayer2RGB * filter, GstBayer2RGBBand * band,
+    int y, guint16 * r, guint16 * g, guint16 * b)
+{
+  const guint16 *p0, *p1, *p2, *g0, *g1, *g2;
+  const int *sites = filter->sites[y & 1];
+  const gint max = (1 << filter->depth) - 1;
+  int x;
+
+  g0 = gst_bayer2rgb_get_green_line (filter, band, y - 1);
+  g1 = gst_bayer2rgb_get_green_line (filter, band, y);
+  g2 = gst_bayer2rgb_get_green_line (filter, band, y + 1);
+  p0 = gst_bayer2rgb_get_input_line (filter, band, y - 1);
+  p1 = gst_bayer2rgb_get_input_line (filter, band, y);
+  p2 = gst_bayer2rgb_get_input_line (filter, band, y + 1);
+
+  for (x = 0; x < filter->width; x++) {
+    const gint c = p1[x];
+    const gint gc = g1[x];
+    /* colour differences of the horizontal, vertical and diagonal
+     * neighbours */
+    const gint h = (p1[x - 1] - g1[x - 1] + p1[x + 1] - g1[x + 1]) >> 1;
+    const gint v = (p0[x] - g0[x] + p2[x] - g2[x]) >> 1;
+    const gint d = (p0[x - 1] - g0[x - 1] + p0[x + 1] - g0[x + 1] +
+        p2[x - 1] - g2[x - 1] + p2[x + 1] - g2[x + 1]) >> 2;
+
+    switch (sites[x & 1]) {
+      case SITE_R:
+        r[x] = c;
+        g[x] = gc;
+        b[x] = clamp_sample (gc + d, max);
+        break;
+      case SITE_B:
+        b[x] = c;
+        g[x] = gc;
+        r[x] = clamp_sample (gc + d, max);
+        break;
+      case SITE_G_ON_R:
+        g[x] = c;
+        r[x] = clamp_sample (c + h, max);
+        b[x] = clamp_sample (c + v, max);
+        break;
+      case SITE_G_ON_B:
+        g[x] = c;
+        b[x] = clamp_sample (c + h, max);
+        r[x] = clamp_sample (c + v, max);
+        break;
+    }
+  }
+}
+
+/* Scales a sample of the input depth to 8 bits */
+#define TO_8(v, shift) MIN (((v) + ((1 << (shift)) >> 1)) >> (shift), 255)
+
+static void
+gst_bayer2rgb_pack_rgb (GstBayer2RGB * filter, guint8 * dest,
+    guint16 ** rgb)
+{
+  const int shift = filter->depth - 8;
+  const int a_off = 6 - filter->r_off - filter->g_off - filter->b_off;
+  int x;
+
+  for (x = 0; x < filter->width; x++) {
+    dest[filter->r_off] = TO_8 (rgb[0][x], shift);
+    dest[filter->g_off] = TO_8 (rgb[1][x], shift);
+    dest[filter->b_off] = TO_8 (rgb[2][x], shift);
+    dest[a_off] = 255;
+    dest += 4;
+  }
+}
+
+static void
+gst_bayer2rgb_pack_argb64 (GstBayer2RGB * filter, guint16 * dest,
+    guint16 ** rgb)
+{
+  const int up = 16 - filter->depth;
+  const int down = filter->depth - up;
+  int x, i;
+
+  for (x = 0; x < filter->width; x++) {
+    dest[0] = 0xffff;
+    /* replicate the top bits into the new low bits */
+    for (i = 0; i < 3; i++)
+      dest[i + 1] = (rgb[i][x] << up) | (rgb[i][x] >> down);
+    dest += 4;
+  }
+}
+
+static void
+gst_bayer2rgb_pack_y (GstBayer2RGB * filter, guint8 * dest, guint16 ** rgb)
+{
+  const int shift = filter->depth - 8;
+  const gint *cy = filter->cy;
+  int x;
+
+  for (x = 0; x < filter->width; x++) {
+    const gint r = TO_8 (rgb[0][x], shift);
+    const gint g = TO_8 (rgb[1][x], shift);
+    const gint b = TO_8 (rgb[2][x], shift);
+
+    dest[x] = 16 + ((cy[0] * r + cy[1] * g + cy[2] * b + (1 << 14)) >> 15);
+  }
+}
+
+/* Writes the chroma of the pair of lines rgb0 and rgb1, the samples of
+ * u and v are pixel_stride bytes apart */
+static void
+gst_bayer2rgb_pack_uv (GstBayer2RGB * filter, guint8 * u, guint8 * v,
+    int pixel_stride, guint16 ** rgb0, guint16 ** rgb1)
+{
+  const int shift = filter->depth - 8;
+  const gint *cu = filter->cu, *cv = filter->cv;
+  int x, i;
+
+  for (x = 0; x < filter->width; x += 2) {
+    const int x1 = MIN (x + 1, filter->width - 1);
+    gint sum[3];
+
+    for (i = 0; i < 3; i++)
+      sum[i] = TO_8 (rgb0[i][x], shift) + TO_8 (rgb0[i][x1], shift) +
+          TO_8 (rgb1[i][x], shift) + TO_8 (rgb1[i][x1], shift);
+
+    /* the sums are of 4 samples */
+    *u = 128 + ((cu[0] * sum[0] + cu[1] * sum[1] + cu[2] * sum[2] +
+            (1 << 16)) >> 17);
+    *v = 128 + ((cv[0] * sum[0] + cv[1] * sum[1] + cv[2] * sum[2] +
+            (1 << 16)) >> 17);
+    u += pixel_stride;
+    v += pixel_stride;
+  }
+}
 
-  g_free (tmp);
+/* Decoding of lines [first, last) for any input depth and output format */
+static void
+gst_bayer2rgb_process_generic (GstBayer2RGB * filter, GstBayer2RGBBand * band,
+    int first, int last)
+{
+  GstVideoFrame *frame = filter->dest;
+  GstVideoFormat format = GST_VIDEO_FRAME_FORMAT (frame);
+  int y, i;
+
+  for (i = 0; i < N_INPUT_LINES; i++)
+    band->input_line[i] = -1;
+  for (i = 0; i < N_GREEN_LINES; i++)
+    band->green_line[i] = -1;
+
+  for (y = first; y < last; y++) {
+    guint16 **rgb = band->rgb[y & 1];
+    guint8 *line;
+
+    if (filter->method == GST_BAYER_2_RGB_METHOD_EDGE_AWARE)
+      gst_bayer2rgb_edge_aware_line (filter, band, y, rgb[0], rgb[1], rgb[2]);
+    else
+      gst_bayer2rgb_bilinear_line (filter, band, y, rgb[0], rgb[1], rgb[2]);
+
+    line = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 0) +
+        y * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 0);
+
+    switch (format) {
+      case GST_VIDEO_FORMAT_ARGB64:
+        gst_bayer2rgb_pack_argb64 (filter, (guint16 *) line, rgb);
+        break;
+      case GST_VIDEO_FORMAT_I420:
+      case GST_VIDEO_FORMAT_NV12:
+      {
+        guint8 *u, *v;
+        int uv_y = y >> 1;
+
+        gst_bayer2rgb_pack_y (filter, line, rgb);
+
+        /* bands start on even lines, so both lines of a pair are here */
+        if (!(y & 1) && y != filter->height - 1)
+          break;
+
+        if (format == GST_VIDEO_FORMAT_I420) {
+          u = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 1) +
+              uv_y * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 1);
+          v = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 2) +
+              uv_y * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 2);
+          gst_bayer2rgb_pack_uv (filter, u, v, 1, band->rgb[0],
+              band->rgb[y & 1]);
+        } else {
+          u = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, 1) +
+              uv_y * GST_VIDEO_FRAME_PLANE_STRIDE (frame, 1);
+          gst_bayer2rgb_pack_uv (filter, u, u + 1, 2, band->rgb[0],
+              band->rgb[y & 1]);
+        }
+        break;
+      }
+      default:
+        gst_bayer2rgb_pack_rgb (filter, line, rgb);
+        break;
+    }
+  }
 }
 
+static void
+gst_bayer2rgb_process_band (GstBayer2RGBBand * band, GstBayer2RGB * filter)
+{
+  process_func merge[2];
+  /* bands start on even lines so that chroma is never split */
+  int first = (filter->height * band->index / filter->n_bands) & ~1;
+  int last = band->index == filter->n_bands - 1 ? filter->height :
+      (filter->height * (band->index + 1) / filter->n_bands) & ~1;
+
+  if (filter->depth == 8 && filter->method == GST_BAYER_2_RGB_METHOD_BILINEAR
+      && gst_bayer2rgb_get_merge_funcs (filter, merge)) {
+    gst_bayer2rgb_process (filter, band, merge,
+        GST_VIDEO_FRAME_PLANE_DATA (filter->dest, 0),
+        GST_VIDEO_FRAME_PLANE_STRIDE (filter->dest, 0), filter->src,
+        filter->src_stride, first, last);
+  } else {
+    gst_bayer2rgb_process_generic (filter, band, first, last);
+  }
+}
 
+static void
+gst_bayer2rgb_process_band_func (GstBayer2RGBBand * band,
+    GstBayer2RGB * filter)
+{
+  gst_bayer2rgb_process_band (band, filter);
 
+  g_mutex_lock (&filter->band_lock);
+  if (--filter->bands_pending == 0)
+    g_cond_signal (&filter->band_cond);
+  g_mutex_unlock (&filter->band_lock);
+}
 
 static GstFlowReturn
 gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
@@ -455,8 +1215,8 @@ gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
 {
   GstBayer2RGB *filter = GST_BAYER2RGB (base);
   GstMapInfo map;
-  uint8_t *output;
   GstVideoFrame frame;
+  guint i;
 
   GST_DEBUG ("transforming buffer");
 
@@ -468,9 +1228,34 @@ gst_bayer2rgb_transform (GstBaseTransform * base, GstBuffer * inbuf,
     goto map_failed;
   }
 
-  output = GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
-  gst_bayer2rgb_process (filter, output, frame.info.stride[0],
-      map.data, GST_ROUND_UP_4 (filter->width));
+  filter->src = map.data;
+  filter->src_stride = gst_bayer2rgb_input_stride (filter->width,
+      filter->depth);
+  filter->dest = &frame;
+
+  /* the method can change at any time, but all bands must use the same */
+  GST_OBJECT_LOCK (filter);
+
+  if (filter->pool && filter->n_bands > 1) {
+    filter->bands_pending = filter->n_bands - 1;
+    for (i = 1; i < filter->n_bands; i++)
+      g_thread_pool_push (filter->pool, &filter->bands[i], NULL);
+
+    /* take a share of the work while waiting */
+    gst_bayer2rgb_process_band (&filter->bands[0], filter);
+
+    g_mutex_lock (&filter->band_lock);
+    while (filter->bands_pending > 0)
+      g_cond_wait (&filter->band_cond, &filter->band_lock);
+    g_mutex_unlock (&filter->band_lock);
+  } else {
+    gst_bayer2rgb_process_band (&filter->bands[0], filter);
+  }
+
+  GST_OBJECT_UNLOCK (filter);
+
+  filter->src = NULL;
+  filter->dest = NULL;
 
   gst_video_frame_unmap (&frame);
   gst_buffer_unmap (inbuf, &map);
@@ -82,6 +82,12 @@ GST_DEBUG_CATEGORY_STATIC (gst_field_analysis_debug);
 #define DEFAULT_BLOCK_HEIGHT 16
 #define DEFAULT_BLOCK_THRESH 80
 #define DEFAULT_IGNORED_LINES 2
+#define DEFAULT_SUBSAMPLE 1
+#define DEFAULT_THREADS 0
+
+#define MAX_THREADS 64
+/* don't bother handing out bands smaller than this many lines */
+#define MIN_BAND_HEIGHT 64
 
 enum
 {
@@ -96,7 +102,9 @@ enum
   PROP_BLOCK_WIDTH,
   PROP_BLOCK_HEIGHT,
   PROP_BLOCK_THRESH,
-  PROP_IGNORED_LINES
+  PROP_IGNORED_LINES,
+  PROP_SUBSAMPLE,
+  PROP_THREADS
 };
 
 static GstStaticPadTemplate sink_factory =
@@ -274,6 +282,17 @@ gst_field_analysis_class_init (GstFieldAnalysisClass * klass)
           "Ignore this many lines from the top and bottom for windowed comb detection",
           2, G_MAXUINT64, DEFAULT_IGNORED_LINES,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SUBSAMPLE,
+      g_param_spec_uint ("subsample", "Subsample",
+          "Only measure every n-th luma sample of every n-th field line for the field and 5-tap frame metrics (1 = all)",
+          1, 16, DEFAULT_SUBSAMPLE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of threads analysing bands of each frame "
+          "(0 = number of processors)", 0, MAX_THREADS, DEFAULT_THREADS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
 
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_field_analysis_change_state);
@@ -290,21 +309,24 @@ gst_field_analysis_class_init (GstFieldAnalysisClass * klass)
 }
 
 static gfloat same_parity_sad (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2]);
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band);
 static gfloat same_parity_ssd (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2]);
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band);
 static gfloat same_parity_3_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2]);
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band);
 static gfloat opposite_parity_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2]);
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band);
 static guint64 block_score_for_row_32detect (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band,
+    guint8 * base_fj, guint8 * base_fjp1);
 static guint64 block_score_for_row_iscombed (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band,
+    guint8 * base_fj, guint8 * base_fjp1);
 static guint64 block_score_for_row_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1);
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band,
+    guint8 * base_fj, guint8 * base_fjp1);
 static gfloat opposite_parity_windowed_comb (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2]);
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band);
 
 static void
 gst_field_analysis_clear_frames (GstFieldAnalysis * filter)
@@ -325,10 +347,6 @@ gst_field_analysis_reset (GstFieldAnalysis * filter)
   filter->is_telecine = FALSE;
   filter->first_buffer = TRUE;
   gst_video_info_init (&filter->vinfo);
-  g_free (filter->comb_mask);
-  filter->comb_mask = NULL;
-  g_free (filter->block_scores);
-  filter->block_scores = NULL;
 }
 
 static void
@@ -358,6 +376,11 @@ gst_field_analysis_init (GstFieldAnalysis * filter)
   filter->block_height = DEFAULT_BLOCK_HEIGHT;
   filter->block_thresh = DEFAULT_BLOCK_THRESH;
   filter->ignored_lines = DEFAULT_IGNORED_LINES;
+  filter->subsample = DEFAULT_SUBSAMPLE;
+  filter->threads = DEFAULT_THREADS;
+
+  g_mutex_init (&filter->band_lock);
+  g_cond_init (&filter->band_cond);
 }
 
 static void
@@ -423,18 +446,6 @@ gst_field_analysis_set_property (GObject * object, guint prop_id,
       break;
     case PROP_BLOCK_WIDTH:
       filter->block_width = g_value_get_uint64 (value);
-      if (GST_VIDEO_FRAME_WIDTH (&filter->frames[0].frame)) {
-        const gint frame_width =
-            GST_VIDEO_FRAME_WIDTH (&filter->frames[0].frame);
-        if (filter->block_scores) {
-          gsize nbytes = (frame_width / filter->block_width) * sizeof (guint);
-          filter->block_scores = g_realloc (filter->block_scores, nbytes);
-          memset (filter->block_scores, 0, nbytes);
-        } else {
-          filter->block_scores =
-              g_malloc0 ((frame_width / filter->block_width) * sizeof (guint));
-        }
-      }
       break;
     case PROP_BLOCK_HEIGHT:
       filter->block_height = g_value_get_uint64 (value);
@@ -445,6 +456,15 @@ gst_field_analysis_set_property (GObject * object, guint prop_id,
     case PROP_IGNORED_LINES:
       filter->ignored_lines = g_value_get_uint64 (value);
       break;
+    case PROP_SUBSAMPLE:
+      /* the bands of a frame must all measure the same samples */
+      GST_OBJECT_LOCK (filter);
+      filter->subsample = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_THREADS:
+      filter->threads = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -519,6 +539,12 @@ gst_field_analysis_get_property (GObject * object, guint prop_id,
     case PROP_IGNORED_LINES:
       g_value_set_uint64 (value, filter->ignored_lines);
       break;
+    case PROP_SUBSAMPLE:
+      g_value_set_uint (value, filter->subsample);
+      break;
+    case PROP_THREADS:
+      g_value_set_uint (value, filter->threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -528,7 +554,6 @@ gst_field_analysis_get_property (GObject * object, guint prop_id,
 static void
 gst_field_analysis_update_format (GstFieldAnalysis * filter, GstCaps * caps)
 {
-  gint width;
   GQueue *outbufs;
   GstVideoInfo vinfo;
 
@@ -565,22 +590,9 @@ gst_field_analysis_update_format (GstFieldAnalysis * filter, GstCaps * caps)
   filter->flushing = FALSE;
 
   filter->vinfo = vinfo;
-  width = GST_VIDEO_INFO_WIDTH (&filter->vinfo);
-
-  /* update allocations for metric scores */
-  if (filter->comb_mask) {
-    filter->comb_mask = g_realloc (filter->comb_mask, width);
-  } else {
-    filter->comb_mask = g_malloc (width);
-  }
-  if (filter->block_scores) {
-    gsize nbytes = (width / filter->block_width) * sizeof (guint);
-    filter->block_scores = g_realloc (filter->block_scores, nbytes);
-    memset (filter->block_scores, 0, nbytes);
-  } else {
-    filter->block_scores =
-        g_malloc0 ((width / filter->block_width) * sizeof (guint));
-  }
+  filter->n_bands = CLAMP (GST_VIDEO_INFO_HEIGHT (&filter->vinfo) /
+      MIN_BAND_HEIGHT, 1, filter->n_threads);
+  GST_DEBUG_OBJECT (filter, "%u bands", filter->n_bands);
 
   GST_OBJECT_UNLOCK (filter);
   return;
@@ -802,147 +814,195 @@ gst_field_analysis_sink_event (GstPad * pad, GstObject * parent,
 }
 
 
+/* first and last (exclusive) of the n iterations of a metric done by @band */
+static inline void
+gst_field_analysis_band_range (GstFieldAnalysis * filter,
+    FieldAnalysisBand * band, gint n, gint * first, gint * last)
+{
+  *first = (gint64) n * band->index / filter->n_bands;
+  *last = (gint64) n * (band->index + 1) / filter->n_bands;
+}
+
+/* line j of the field of the given parity */
+static inline guint8 *
+field_line (FieldAnalysisFields * field, gint j)
+{
+  return GST_VIDEO_FRAME_COMP_DATA (&field->frame, 0) +
+      ((j << 1) + field->parity) * GST_VIDEO_FRAME_COMP_STRIDE (&field->frame,
+      0);
+}
+
+/* the measured samples of a field, luma only and every subsample-th sample
+ * of every subsample-th line */
+#define MEASURED_COLUMNS(width, subsample) (((width) + (subsample) - 1) / (subsample))
+#define MEASURED_LINES(height, subsample) ((((height) >> 1) + (subsample) - 1) / (subsample))
+
 static gfloat
-same_parity_sad (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
+same_parity_sad (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2],
+    FieldAnalysisBand * band)
 {
-  gint j;
-  gfloat sum;
+  gint i, j, first, last;
+  guint64 sum;
   guint8 *f1j, *f2j;
 
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
+  const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
+  const gint subsample = filter->subsample;
+  const gint step = incr * subsample;
+  const gint lines = MEASURED_LINES (height, subsample);
   const guint32 noise_floor = filter->noise_floor;
 
-  f1j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
-      0) +
-      (*history)[0].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame,
-      0);
-  f2j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-      0) +
-      (*history)[1].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame,
-      0);
+  gst_field_analysis_band_range (filter, band, lines, &first, &last);
+
+  sum = 0;
+  for (j = first; j < last; j++) {
+    f1j = field_line (&(*history)[0], j * subsample);
+    f2j = field_line (&(*history)[1], j * subsample);
 
-  sum = 0.0f;
-  for (j = 0; j < (height >> 1); j++) {
-    guint32 tempsum = 0;
-    fieldanalysis_orc_same_parity_sad_planar_yuv (&tempsum, f1j, f2j,
-        noise_floor, width);
-    sum += tempsum;
-    f1j += stride0x2;
-    f2j += stride1x2;
+    if (step == 1) {
+      guint32 tempsum = 0;
+      fieldanalysis_orc_same_parity_sad_planar_yuv (&tempsum, f1j, f2j,
+          noise_floor, width);
+      sum += tempsum;
+    } else {
+      for (i = 0; i < width * incr; i += step) {
+        guint32 diff = abs (f1j[i] - f2j[i]);
+        if (diff > noise_floor)
+          sum += diff;
+      }
+    }
   }
 
-  return sum / (0.5f * width * height);
+  return sum / ((gfloat) MEASURED_COLUMNS (width, subsample) * lines);
 }
 
 static gfloat
-same_parity_ssd (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
+same_parity_ssd (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2],
+    FieldAnalysisBand * band)
 {
-  gint j;
-  gfloat sum;
+  gint i, j, first, last;
+  guint64 sum;
   guint8 *f1j, *f2j;
 
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
+  const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
+  const gint subsample = filter->subsample;
+  const gint step = incr * subsample;
+  const gint lines = MEASURED_LINES (height, subsample);
   /* noise floor needs to be squared for SSD */
   const guint32 noise_floor = filter->noise_floor * filter->noise_floor;
 
-  f1j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
-      0) +
-      (*history)[0].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame,
-      0);
-  f2j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-      0) +
-      (*history)[1].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame,
-      0);
+  gst_field_analysis_band_range (filter, band, lines, &first, &last);
+
+  sum = 0;
+  for (j = first; j < last; j++) {
+    f1j = field_line (&(*history)[0], j * subsample);
+    f2j = field_line (&(*history)[1], j * subsample);
 
-  sum = 0.0f;
-  for (j = 0; j < (height >> 1); j++) {
-    guint32 tempsum = 0;
-    fieldanalysis_orc_same_parity_ssd_planar_yuv (&tempsum, f1j, f2j,
-        noise_floor, width);
-    sum += tempsum;
-    f1j += stride0x2;
-    f2j += stride1x2;
+    if (step == 1) {
+      guint32 tempsum = 0;
+      fieldanalysis_orc_same_parity_ssd_planar_yuv (&tempsum, f1j, f2j,
+          noise_floor, width);
+      sum += tempsum;
+    } else {
+      for (i = 0; i < width * incr; i += step) {
+        gint diff = f1j[i] - f2j[i];
+        if ((guint32) (diff * diff) > noise_floor)
+          sum += diff * diff;
+      }
+    }
   }
 
-  return sum / (0.5f * width * height); /* field is half height */
+  return sum / ((gfloat) MEASURED_COLUMNS (width, subsample) * lines);
 }
 
 /* horizontal [1,4,1] diff between fields - is this a good idea or should the
  * current sample be emphasised more or less? */
 static gfloat
-same_parity_3_tap (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
+same_parity_3_tap (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2],
+    FieldAnalysisBand * band)
 {
-  gint i, j;
-  gfloat sum;
+  gint i, j, first, last;
+  guint64 sum;
   guint8 *f1j, *f2j;
 
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
+  const gint subsample = filter->subsample;
+  const gint lines = MEASURED_LINES (height, subsample);
+  const gint last_idx = (width - 1) * incr;
   /* noise floor needs to be *6 for [1,4,1] */
   const guint32 noise_floor = filter->noise_floor * 6;
 
-  f1j = GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame, 0) +
-      GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame, 0) +
-      (*history)[0].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame,
-      0);
-  f2j =
-      GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-      0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-      0) +
-      (*history)[1].parity * GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame,
-      0);
+  if (width < 3)
+    return 0.0f;
+
+  gst_field_analysis_band_range (filter, band, lines, &first, &last);
 
-  sum = 0.0f;
-  for (j = 0; j < (height >> 1); j++) {
-    guint32 tempsum = 0;
+  sum = 0;
+  for (j = first; j < last; j++) {
     guint32 diff;
 
+    f1j = field_line (&(*history)[0], j * subsample);
+    f2j = field_line (&(*history)[1], j * subsample);
+
     /* unroll first as it is a special case */
     diff = abs (((f1j[0] << 2) + (f1j[incr] << 1))
         - ((f2j[0] << 2) + (f2j[incr] << 1)));
     if (diff > noise_floor)
       sum += diff;
 
-    fieldanalysis_orc_same_parity_3_tap_planar_yuv (&tempsum, f1j, &f1j[incr],
-        &f1j[incr << 1], f2j, &f2j[incr], &f2j[incr << 1], noise_floor,
-        width - 1);
-    sum += tempsum;
+    if (incr == 1 && subsample == 1) {
+      guint32 tempsum = 0;
+      fieldanalysis_orc_same_parity_3_tap_planar_yuv (&tempsum, f1j, &f1j[1],
+          &f1j[2], f2j, &f2j[1], &f2j[2], noise_floor, width - 2);
+      sum += tempsum;
+    } else {
+      for (i = subsample * incr; i < last_idx; i += subsample * incr) {
+        diff = abs ((f1j[i - incr] + (f1j[i] << 2) + f1j[i + incr])
+            - (f2j[i - incr] + (f2j[i] << 2) + f2j[i + incr]));
+        if (diff > noise_floor)
+          sum += diff;
+      }
+    }
 
     /* unroll last as it is a special case */
-    i = width - 1;
-    diff = abs (((f1j[i - incr] << 1) + (f1j[i] << 2))
-        - ((f2j[i - incr] << 1) + (f2j[i] << 2)));
-    if (diff > noise_floor)
-      sum += diff;
+    if (subsample == 1 || (width - 1) % subsample == 0) {
+      diff = abs (((f1j[last_idx - incr] << 1) + (f1j[last_idx] << 2))
+          - ((f2j[last_idx - incr] << 1) + (f2j[last_idx] << 2)));
+      if (diff > noise_floor)
+        sum += diff;
+    }
+  }
+
+  /* 1 + 4 + 1 = 6 */
+  return sum / (6.0f * MEASURED_COLUMNS (width, subsample) * lines);
+}
 
-    f1j += stride0x2;
-    f2j += stride1x2;
+static inline guint32
+opposite_parity_5_tap_line (const guint8 * s1, const guint8 * s2,
+    const guint8 * s3, const guint8 * s4, const guint8 * s5,
+    guint32 noise_floor, gint width, gint incr, gint subsample)
+{
+  guint32 sum = 0;
+  gint i;
+
+  if (incr == 1 && subsample == 1) {
+    fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&sum, s1, s2, s3, s4,
+        s5, noise_floor, width);
+  } else {
+    for (i = 0; i < width * incr; i += subsample * incr) {
+      guint32 diff =
+          abs (s1[i] - 3 * s2[i] + (s3[i] << 2) - 3 * s4[i] + s5[i]);
+      if (diff > noise_floor)
+        sum += diff;
+    }
   }
 
-  return sum / ((6.0f / 2.0f) * width * height);        /* 1 + 4 + 1 = 6; field is half height */
+  return sum;
 }
 
 /* vertical [1,-3,4,-3,1] - same as is used in FieldDiff from TIVTC,
@@ -950,23 +1010,24 @@ same_parity_3_tap (GstFieldAnalysis * filter, FieldAnalysisFields (*history)[2])
 /* 0th field's parity defines operation */
 static gfloat
 opposite_parity_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2])
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band)
 {
-  gint j;
-  gfloat sum;
+  gint j, first, last;
+  guint64 sum;
   guint8 *fjm2, *fjm1, *fj, *fjp1, *fjp2;
-  guint32 tempsum;
+  GstVideoFrame *top, *bottom;
+  gint top_stride, bottom_stride;
 
   const gint width = GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame);
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
-  const gint stride0x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0) << 1;
-  const gint stride1x2 =
-      GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0) << 1;
+  const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
+  const gint subsample = filter->subsample;
+  const gint lines = MEASURED_LINES (height, subsample);
   /* noise floor needs to be *6 for [1,-3,4,-3,1] */
   const guint32 noise_floor = filter->noise_floor * 6;
 
-  sum = 0.0f;
+  if ((height >> 1) < 2)
+    return 0.0f;
 
   /* fj is line j of the combined frame made from the top field even lines of
    *   field 0 and the bottom field odd lines from field 1
@@ -975,73 +1036,60 @@ opposite_parity_5_tap (GstFieldAnalysis * filter,
    * fj with j == 0 is the 0th line of the top field
    * fj with j == 1 is the 0th line of the bottom field or the 1st field of
    *   the frame*/
-
-  /* unroll first line as it is a special case */
   if ((*history)[0].parity == TOP_FIELD) {
-    fj = GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame, 0);
-    fjp1 =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0);
-    fjp2 = fj + stride0x2;
+    top = &(*history)[0].frame;
+    bottom = &(*history)[1].frame;
   } else {
-    fj = GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame, 0);
-    fjp1 =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
-    fjp2 = fj + stride1x2;
+    top = &(*history)[1].frame;
+    bottom = &(*history)[0].frame;
   }
-
-  tempsum = 0;
-  fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjp2, fjp1, fj,
-      fjp1, fjp2, noise_floor, width);
-  sum += tempsum;
-
-  for (j = 1; j < (height >> 1) - 1; j++) {
-    /* shift everything down a line in the field of interest (means += stridex2) */
-    fjm2 = fj;
-    fjm1 = fjp1;
-    fj = fjp2;
-    if ((*history)[0].parity == TOP_FIELD) {
-      fjp1 += stride1x2;
-      fjp2 += stride0x2;
+  top_stride = GST_VIDEO_FRAME_COMP_STRIDE (top, 0);
+  bottom_stride = GST_VIDEO_FRAME_COMP_STRIDE (bottom, 0);
+
+  gst_field_analysis_band_range (filter, band, lines, &first, &last);
+
+  sum = 0;
+  for (j = first * subsample; j < last * subsample; j += subsample) {
+    fj = GST_VIDEO_FRAME_COMP_DATA (top, 0) + (j << 1) * top_stride;
+
+    /* the first and last lines are special cases, mirror the missing lines */
+    if (j == 0) {
+      fjp1 = GST_VIDEO_FRAME_COMP_DATA (bottom, 0) + bottom_stride;
+      fjp2 = fj + (top_stride << 1);
+      fjm1 = fjp1;
+      fjm2 = fjp2;
+    } else if (j == (height >> 1) - 1) {
+      fjm1 = GST_VIDEO_FRAME_COMP_DATA (bottom, 0) +
+          ((j << 1) - 1) * bottom_stride;
+      fjm2 = fj - (top_stride << 1);
+      fjp1 = fjm1;
+      fjp2 = fjm2;
     } else {
-      fjp1 += stride0x2;
-      fjp2 += stride1x2;
+      fjm1 = GST_VIDEO_FRAME_COMP_DATA (bottom, 0) +
+          ((j << 1) - 1) * bottom_stride;
+      fjm2 = fj - (top_stride << 1);
+      fjp1 = fjm1 + (bottom_stride << 1);
+      fjp2 = fj + (top_stride << 1);
     }
 
-    tempsum = 0;
-    fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjm2, fjm1,
-        fj, fjp1, fjp2, noise_floor, width);
-    sum += tempsum;
+    sum += opposite_parity_5_tap_line (fjm2, fjm1, fj, fjp1, fjp2,
+        noise_floor, width, incr, subsample);
   }
 
-  /* unroll the last line as it is a special case */
-  /* shift everything down a line in the field of interest (means += stridex2) */
-  fjm2 = fj;
-  fjm1 = fjp1;
-  fj = fjp2;
-
-  tempsum = 0;
-  fieldanalysis_orc_opposite_parity_5_tap_planar_yuv (&tempsum, fjm2, fjm1, fj,
-      fjm1, fjm2, noise_floor, width);
-  sum += tempsum;
-
-  return sum / ((6.0f / 2.0f) * width * height);        /* 1 + 4 + 1 == 3 + 3 == 6; field is half height */
+  /* 1 + 4 + 1 == 3 + 3 == 6 */
+  return sum / (6.0f * MEASURED_COLUMNS (width, subsample) * lines);
 }
 
 /* this metric was sourced from HandBrake but originally from transcode
  * the return value is the highest block score for the row of blocks */
 static inline guint64
 block_score_for_row_32detect (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band,
+    guint8 * base_fj, guint8 * base_fjp1)
 {
   guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
+  guint8 *comb_mask = band->comb_mask;
+  guint *block_scores = band->block_scores;
   guint64 block_score;
   guint8 *fjm2, *fjm1, *fj, *fjp1;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
@@ -1054,6 +1102,8 @@ block_score_for_row_32detect (GstFieldAnalysis * filter,
       GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) -
       (GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) % block_width);
 
+  memset (block_scores, 0, (width / block_width) * sizeof (guint));
+
   fjm2 = base_fj - stridex2;
   fjm1 = base_fjp1 - stridex2;
   fj = base_fj;
@@ -1114,8 +1164,6 @@ block_score_for_row_32detect (GstFieldAnalysis * filter,
       block_score = block_scores[i];
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
   return block_score;
 }
 
@@ -1124,11 +1172,12 @@ block_score_for_row_32detect (GstFieldAnalysis * filter,
  * the return value is the highest block score for the row of blocks */
 static inline guint64
 block_score_for_row_iscombed (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band,
+    guint8 * base_fj, guint8 * base_fjp1)
 {
   guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
+  guint8 *comb_mask = band->comb_mask;
+  guint *block_scores = band->block_scores;
   guint64 block_score;
   guint8 *fjm1, *fj, *fjp1;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
@@ -1142,6 +1191,8 @@ block_score_for_row_iscombed (GstFieldAnalysis * filter,
       GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) -
       (GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) % block_width);
 
+  memset (block_scores, 0, (width / block_width) * sizeof (guint));
+
   fjm1 = base_fjp1 - stridex2;
   fj = base_fj;
   fjp1 = base_fjp1;
@@ -1202,8 +1253,6 @@ block_score_for_row_iscombed (GstFieldAnalysis * filter,
       block_score = block_scores[i];
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
   return block_score;
 }
 
@@ -1212,11 +1261,12 @@ block_score_for_row_iscombed (GstFieldAnalysis * filter,
  * the return value is the highest block score for the row of blocks */
 static inline guint64
 block_score_for_row_5_tap (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2], guint8 * base_fj, guint8 * base_fjp1)
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band,
+    guint8 * base_fj, guint8 * base_fjp1)
 {
   guint64 i, j;
-  guint8 *comb_mask = filter->comb_mask;
-  guint *block_scores = filter->block_scores;
+  guint8 *comb_mask = band->comb_mask;
+  guint *block_scores = band->block_scores;
   guint64 block_score;
   guint8 *fjm2, *fjm1, *fj, *fjp1, *fjp2;
   const gint incr = GST_VIDEO_FRAME_COMP_PSTRIDE (&(*history)[0].frame, 0);
@@ -1230,6 +1280,7 @@ block_score_for_row_5_tap (GstFieldAnalysis * filter,
       GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) -
       (GST_VIDEO_FRAME_WIDTH (&(*history)[0].frame) % block_width);
 
+  memset (block_scores, 0, (width / block_width) * sizeof (guint));
 
   fjm2 = base_fj - stridex2;
   fjm1 = base_fjp1 - stridex2;
@@ -1313,8 +1364,6 @@ block_score_for_row_5_tap (GstFieldAnalysis * filter,
       block_score = block_scores[i];
   }
 
-  g_free (block_scores);
-  g_free (comb_mask);
   return block_score;
 }
 
@@ -1325,47 +1374,48 @@ block_score_for_row_5_tap (GstFieldAnalysis * filter,
    score is between half the threshold and the threshold, the block is
    slightly combed. if when analysis is complete, slight combing is detected
    that is returned. if any results are observed that are above the threshold,
-   the function returns immediately */
+   the function returns immediately. each band handles a share of the rows of
+   blocks and the frame result is the largest band result */
 /* 0th field's parity defines operation */
 static gfloat
 opposite_parity_windowed_comb (GstFieldAnalysis * filter,
-    FieldAnalysisFields (*history)[2])
+    FieldAnalysisFields (*history)[2], FieldAnalysisBand * band)
 {
-  gint j;
+  gint j, first, last, rows;
   gboolean slightly_combed;
 
   const gint height = GST_VIDEO_FRAME_HEIGHT (&(*history)[0].frame);
   const gint stride = GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
   const guint64 block_thresh = filter->block_thresh;
   const guint64 block_height = filter->block_height;
+  const gint64 rows_height = (gint64) height - filter->ignored_lines;
   guint8 *base_fj, *base_fjp1;
 
   if ((*history)[0].parity == TOP_FIELD) {
-    base_fj =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame, 0);
+    base_fj = GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame, 0);
     base_fjp1 =
         GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame,
         0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[1].frame, 0);
   } else {
-    base_fj =
-        GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[1].frame, 0);
+    base_fj = GST_VIDEO_FRAME_COMP_DATA (&(*history)[1].frame, 0);
     base_fjp1 =
         GST_VIDEO_FRAME_COMP_DATA (&(*history)[0].frame,
-        0) + GST_VIDEO_FRAME_COMP_OFFSET (&(*history)[0].frame,
         0) + GST_VIDEO_FRAME_COMP_STRIDE (&(*history)[0].frame, 0);
   }
 
+  if (block_height == 0 || rows_height < (gint64) block_height)
+    return 0.0f;
+  rows = (rows_height - block_height) / block_height + 1;
+
+  gst_field_analysis_band_range (filter, band, rows, &first, &last);
+
   /* we operate on a row of blocks of height block_height through each iteration */
   slightly_combed = FALSE;
-  for (j = 0; j <= height - filter->ignored_lines - block_height;
-      j += block_height) {
+  for (j = first * block_height; j < last * block_height; j += block_height) {
     guint64 line_offset = (filter->ignored_lines + j) * stride;
     guint block_score =
-        filter->block_score_for_row (filter, history, base_fj + line_offset,
-        base_fjp1 + line_offset);
+        filter->block_score_for_row (filter, history, band,
+        base_fj + line_offset, base_fjp1 + line_offset);
 
     if (block_score > (block_thresh >> 1)
         && block_score <= block_thresh) {
@@ -1384,6 +1434,143 @@ opposite_parity_windowed_comb (GstFieldAnalysis * filter,
   return (gfloat) slightly_combed;      /* TRUE means blend, else don't */
 }
 
+static void
+gst_field_analysis_run_band (FieldAnalysisBand * band,
+    GstFieldAnalysis * filter)
+{
+  guint i;
+
+  for (i = 0; i < filter->n_jobs; i++)
+    band->results[i] = filter->jobs[i].metric (filter,
+        &filter->jobs[i].history, band);
+}
+
+static void
+gst_field_analysis_run_band_func (FieldAnalysisBand * band,
+    GstFieldAnalysis * filter)
+{
+  gst_field_analysis_run_band (band, filter);
+
+  g_mutex_lock (&filter->band_lock);
+  if (--filter->bands_pending == 0)
+    g_cond_signal (&filter->band_cond);
+  g_mutex_unlock (&filter->band_lock);
+}
+
+/* queue a metric of the current frame, computed by gst_field_analysis_run_jobs
+ * together with the others */
+static void
+gst_field_analysis_add_job (GstFieldAnalysis * filter,
+    gfloat (*metric) (GstFieldAnalysis *, FieldAnalysisFields (*)[2],
+        FieldAnalysisBand *), FieldAnalysisFields (*history)[2],
+    gfloat * result)
+{
+  FieldAnalysisJob *job = &filter->jobs[filter->n_jobs++];
+
+  job->metric = metric;
+  job->history[0] = (*history)[0];
+  job->history[1] = (*history)[1];
+  job->max = metric == &opposite_parity_windowed_comb;
+  job->result = result;
+}
+
+/* compute all the queued metrics in a single pass over the bands of the frame,
+ * so that each band of the fields is still in cache for all the comparisons
+ * it is involved in */
+static void
+gst_field_analysis_run_jobs (GstFieldAnalysis * filter)
+{
+  const gint width = GST_VIDEO_INFO_WIDTH (&filter->vinfo);
+  guint i, j;
+
+  /* scratch for windowed comb detection */
+  for (i = 0; i < filter->n_bands; i++) {
+    FieldAnalysisBand *band = &filter->bands[i];
+    guint64 blocks = width / filter->block_width + 1;
+
+    if (band->scratch_width != width) {
+      band->comb_mask = g_realloc (band->comb_mask, width);
+      band->scratch_width = width;
+    }
+    if (band->scratch_blocks != blocks) {
+      band->block_scores = g_realloc (band->block_scores,
+          blocks * sizeof (guint));
+      band->scratch_blocks = blocks;
+    }
+  }
+
+  if (filter->pool && filter->n_bands > 1) {
+    filter->bands_pending = filter->n_bands - 1;
+    for (i = 1; i < filter->n_bands; i++)
+      g_thread_pool_push (filter->pool, &filter->bands[i], NULL);
+
+    /* take a share of the work while waiting */
+    gst_field_analysis_run_band (&filter->bands[0], filter);
+
+    g_mutex_lock (&filter->band_lock);
+    while (filter->bands_pending > 0)
+      g_cond_wait (&filter->band_cond, &filter->band_lock);
+    g_mutex_unlock (&filter->band_lock);
+  } else {
+    gst_field_analysis_run_band (&filter->bands[0], filter);
+  }
+
+  for (j = 0; j < filter->n_jobs; j++) {
+    FieldAnalysisJob *job = &filter->jobs[j];
+    gfloat result = filter->bands[0].results[j];
+
+    for (i = 1; i < filter->n_bands; i++) {
+      if (job->max)
+        result = MAX (result, filter->bands[i].results[j]);
+      else
+        result += filter->bands[i].results[j];
+    }
+    *job->result = result;
+  }
+  filter->n_jobs = 0;
+}
+
+static void
+gst_field_analysis_start (GstFieldAnalysis * filter)
+{
+  guint i;
+
+  filter->n_threads = filter->threads;
+  if (filter->n_threads == 0)
+    filter->n_threads = MIN (g_get_num_processors (), MAX_THREADS);
+  filter->n_bands = 1;
+
+  filter->bands = g_new0 (FieldAnalysisBand, filter->n_threads);
+  for (i = 0; i < filter->n_threads; i++)
+    filter->bands[i].index = i;
+
+  if (filter->n_threads > 1) {
+    filter->pool =
+        g_thread_pool_new ((GFunc) gst_field_analysis_run_band_func, filter,
+        filter->n_threads - 1, FALSE, NULL);
+  }
+
+  GST_DEBUG_OBJECT (filter, "using %u threads", filter->n_threads);
+}
+
+static void
+gst_field_analysis_stop (GstFieldAnalysis * filter)
+{
+  guint i;
+
+  if (filter->pool) {
+    g_thread_pool_free (filter->pool, FALSE, TRUE);
+    filter->pool = NULL;
+  }
+  for (i = 0; i < filter->n_threads; i++) {
+    g_free (filter->bands[i].comb_mask);
+    g_free (filter->bands[i].block_scores);
+  }
+  g_free (filter->bands);
+  filter->bands = NULL;
+  filter->n_threads = 0;
+}
+
 /* this is where the magic happens
  *
  * the buffer incoming to the chain function (buf_to_queue) is added to the
@@ -1432,17 +1619,49 @@ gst_field_analysis_process_buffer (GstFieldAnalysis * filter,
   res0 = &filter->frames[0].results;    /* results for current frame */
   res1 = &filter->frames[1].results;    /* results for previous frame */
 
+  /* queue all the comparisons involving the fields of the new frame and
+   * compute them in one pass. the results of the previous frame are kept in
+   * res1 so every pair of fields is only ever compared once */
   history[0].frame = filter->frames[0].frame;
+  history[1].frame = filter->frames[0].frame;
+  res0->t = res0->b = res0->t_b = res0->b_t = G_MAXFLOAT;
+
   /* we do it like this because the first frame has no predecessor so this is
    * the only result we can get for it */
-  if (filter->nframes >= 1) {
-    history[1].frame = filter->frames[0].frame;
+  /* compare the fields within the buffer, if the buffer exhibits combing it
+   * could be interlaced or a mixed telecine frame */
+  history[0].parity = TOP_FIELD;
+  history[1].parity = BOTTOM_FIELD;
+  gst_field_analysis_add_job (filter, filter->same_frame, &history, &res0->f);
+
+  if (filter->nframes >= 2) {
+    history[1].frame = filter->frames[1].frame;
+
+    /* compare the top and bottom fields to the previous frame */
+    history[0].parity = TOP_FIELD;
+    history[1].parity = TOP_FIELD;
+    gst_field_analysis_add_job (filter, filter->same_field, &history,
+        &res0->t);
+    history[0].parity = BOTTOM_FIELD;
+    history[1].parity = BOTTOM_FIELD;
+    gst_field_analysis_add_job (filter, filter->same_field, &history,
+        &res0->b);
+
+    /* compare the top field from this frame to the bottom of the previous for
+     * for combing (and vice versa) */
     history[0].parity = TOP_FIELD;
     history[1].parity = BOTTOM_FIELD;
-    /* compare the fields within the buffer, if the buffer exhibits combing it
-     * could be interlaced or a mixed telecine frame */
-    res0->f = filter->same_frame (filter, &history);
-    res0->t = res0->b = res0->t_b = res0->b_t = G_MAXFLOAT;
+    gst_field_analysis_add_job (filter, filter->same_frame, &history,
+        &res0->t_b);
+    history[0].parity = BOTTOM_FIELD;
+    history[1].parity = TOP_FIELD;
+    gst_field_analysis_add_job (filter, filter->same_frame, &history,
+        &res0->b_t);
+  }
+
+  gst_field_analysis_run_jobs (filter);
+
+  if (filter->nframes >= 1) {
     if (filter->nframes == 1)
       GST_DEBUG_OBJECT (filter, "Scores: f %f, t , b , t_b , b_t ", res0->f);
     if (res0->f <= filter->frame_thresh) {
@@ -1459,25 +1678,6 @@ gst_field_analysis_process_buffer (GstFieldAnalysis * filter,
 
     filter->first_buffer = FALSE;
 
-    history[1].frame = filter->frames[1].frame;
-
-    /* compare the top and bottom fields to the previous frame */
-    history[0].parity = TOP_FIELD;
-    history[1].parity = TOP_FIELD;
-    res0->t = filter->same_field (filter, &history);
-    history[0].parity = BOTTOM_FIELD;
-    history[1].parity = BOTTOM_FIELD;
-    res0->b = filter->same_field (filter, &history);
-
-    /* compare the top field from this frame to the bottom of the previous for
-     * for combing (and vice versa) */
-    history[0].parity = TOP_FIELD;
-    history[1].parity = BOTTOM_FIELD;
-    res0->t_b = filter->same_frame (filter, &history);
-    history[0].parity = BOTTOM_FIELD;
-    history[1].parity = TOP_FIELD;
-    res0->b_t = filter->same_frame (filter, &history);
-
     GST_DEBUG_OBJECT (filter,
         "Scores: f %f, t %f, b %f, t_b %f, b_t %f", res0->f,
         res0->t, res0->b, res0->t_b, res0->b_t);
@@ -1800,6 +2000,7 @@ gst_field_analysis_change_state (GstElement * element,
     case GST_STATE_CHANGE_NULL_TO_READY:
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_field_analysis_start (filter);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
@@ -1816,6 +2017,7 @@ gst_field_analysis_change_state (GstElement * element,
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_field_analysis_reset (filter);
+      gst_field_analysis_stop (filter);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
     default:
@@ -1831,6 +2033,8 @@ gst_field_analysis_finalize (GObject * object)
   GstFieldAnalysis *filter = GST_FIELDANALYSIS (object);
 
   gst_field_analysis_reset (filter);
+  g_mutex_clear (&filter->band_lock);
+  g_cond_clear (&filter->band_cond);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
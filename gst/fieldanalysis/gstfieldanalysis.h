@@ -63,6 +63,8 @@ typedef struct _GstFieldAnalysisClass GstFieldAnalysisClass;
 typedef struct _FieldAnalysisFields FieldAnalysisFields;
 typedef struct _FieldAnalysisHistory FieldAnalysisHistory;
 typedef struct _FieldAnalysis FieldAnalysis;
+typedef struct _FieldAnalysisBand FieldAnalysisBand;
+typedef struct _FieldAnalysisJob FieldAnalysisJob;
 
 typedef enum
 {
@@ -101,6 +103,29 @@ struct _FieldAnalysisHistory
   FieldAnalysis results;
 };
 
+/* a band of the frame, analysed by one thread */
+struct _FieldAnalysisBand
+{
+  guint index;
+  /* one result per job */
+  gfloat results[5];
+  /* scratch for windowed comb detection */
+  guint8 *comb_mask;
+  guint *block_scores;
+  gint scratch_width;
+  guint64 scratch_blocks;
+};
+
+/* one of the metrics computed for a frame */
+struct _FieldAnalysisJob
+{
+  gfloat (*metric) (GstFieldAnalysis *, FieldAnalysisFields (*)[2], FieldAnalysisBand *);
+  FieldAnalysisFields history[2];
+  /* the result of the frame is the largest band result, not the sum */
+  gboolean max;
+  gfloat *result;
+};
+
 typedef enum
 {
   METHOD_32DETECT,
@@ -117,14 +142,12 @@ struct _GstFieldAnalysis
   guint nframes;
   FieldAnalysisHistory frames[2];
   GstVideoInfo vinfo;
-  gfloat (*same_field) (GstFieldAnalysis *, FieldAnalysisFields (*)[2]);
-  gfloat (*same_frame) (GstFieldAnalysis *, FieldAnalysisFields (*)[2]);
-  guint64 (*block_score_for_row) (GstFieldAnalysis *, FieldAnalysisFields (*)[2], guint8 *, guint8 *);
+  gfloat (*same_field) (GstFieldAnalysis *, FieldAnalysisFields (*)[2], FieldAnalysisBand *);
+  gfloat (*same_frame) (GstFieldAnalysis *, FieldAnalysisFields (*)[2], FieldAnalysisBand *);
+  guint64 (*block_score_for_row) (GstFieldAnalysis *, FieldAnalysisFields (*)[2], FieldAnalysisBand *, guint8 *, guint8 *);
   gboolean is_telecine;
   gboolean first_buffer; /* indicates the first buffer for which a buffer will be output
                           * after a discont or flushing seek */
-  guint8 *comb_mask;
-  guint *block_scores;
   gboolean flushing;     /* indicates whether we are flushing or not */
 
   /* properties */
@@ -135,6 +158,21 @@ struct _GstFieldAnalysis
   guint64 block_width, block_height; /* width/height of window used for comb clusted detection */
   guint64 block_thresh;
   guint64 ignored_lines;
+  guint subsample; /* only every subsample-th luma sample and line is measured */
+  guint threads;
+
+  /* the metrics of the current frame, each computed in a single pass */
+  FieldAnalysisJob jobs[5];
+  guint n_jobs;
+
+  /* band threading, band 0 runs in the streaming thread */
+  GThreadPool *pool;
+  FieldAnalysisBand *bands;
+  guint n_threads;
+  guint n_bands;
+  GMutex band_lock;
+  GCond band_cond;
+  guint bands_pending;
 };
 
 struct _GstFieldAnalysisClass
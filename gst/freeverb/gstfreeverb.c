@@ -54,6 +54,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
 
@@ -150,6 +156,17 @@ static const GstFreeverbProcessFunc process_functions[2][2] = {
 #define DC_OFFSET 1e-8
 //#define DC_OFFSET 0.001f
 
+/* Block processing:
+ *
+ * The filters are run one after the other over blocks of up to
+ * FREEVERB_BLOCK_SIZE samples instead of all of them per sample. Each comb
+ * delay line is at least one block long, so the samples a comb reads in a
+ * block are never the ones it writes in that block and only the damping
+ * lowpass remains recursive.
+ */
+#define FREEVERB_BLOCK_SIZE 256
+#define FREEVERB_COMB_LANES 4
+
 /* all pass filter */
 
 typedef struct _freeverb_allpass
@@ -163,6 +180,8 @@ typedef struct _freeverb_allpass
 static void
 freeverb_allpass_setbuffer (freeverb_allpass * allpass, gint size)
 {
+  /* very low rates would otherwise end up with empty delay lines */
+  size = MAX (size, 1);
   allpass->bufidx = 0;
   allpass->buffer = g_new (gfloat, size);
   allpass->bufsize = size;
@@ -198,17 +217,65 @@ freeverb_allpass_getfeedback(freeverb_allpass* allpass)
   return allpass->feedback;
 }*/
 
-#define freeverb_allpass_process(_allpass, _input_1) \
-{ \
-  gfloat output; \
-  gfloat bufout; \
-  bufout = _allpass.buffer[_allpass.bufidx]; \
-  output = bufout-_input_1; \
-  _allpass.buffer[_allpass.bufidx] = _input_1 + (bufout * _allpass.feedback); \
-  if (++_allpass.bufidx >= _allpass.bufsize) { \
-    _allpass.bufidx = 0; \
-  } \
-  _input_1 = output; \
+/* runs one contiguous run of the delay line: the sample read from each slot
+ * is the allpass output and the slot is refilled with the new input */
+static void
+freeverb_allpass_run (gfloat * buf, gfloat * data, gfloat feedback, gint len)
+{
+  gfloat bufout, input;
+  gint i = 0;
+
+#if defined (__SSE2__)
+  {
+    const __m128 fb = _mm_set1_ps (feedback);
+
+    for (; i + 4 <= len; i += 4) {
+      __m128 b = _mm_loadu_ps (buf + i);
+      __m128 x = _mm_loadu_ps (data + i);
+
+      _mm_storeu_ps (buf + i, _mm_add_ps (x, _mm_mul_ps (b, fb)));
+      _mm_storeu_ps (data + i, _mm_sub_ps (b, x));
+    }
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    const float32x4_t fb = vdupq_n_f32 (feedback);
+
+    for (; i + 4 <= len; i += 4) {
+      float32x4_t b = vld1q_f32 (buf + i);
+      float32x4_t x = vld1q_f32 (data + i);
+
+      vst1q_f32 (buf + i, vaddq_f32 (x, vmulq_f32 (b, fb)));
+      vst1q_f32 (data + i, vsubq_f32 (b, x));
+    }
+  }
+#endif
+
+  for (; i < len; i++) {
+    bufout = buf[i];
+    input = data[i];
+    buf[i] = input + (bufout * feedback);
+    data[i] = bufout - input;
+  }
+}
+
+/* filters @n samples of @data in place, splitting the block where the
+ * delay line wraps around */
+static void
+freeverb_allpass_process (freeverb_allpass * allpass, gfloat * data, gint n)
+{
+  gint len;
+
+  while (n > 0) {
+    len = MIN (n, allpass->bufsize - allpass->bufidx);
+    freeverb_allpass_run (allpass->buffer + allpass->bufidx, data,
+        allpass->feedback, len);
+    data += len;
+    n -= len;
+    if ((allpass->bufidx += len) >= allpass->bufsize) {
+      allpass->bufidx = 0;
+    }
+  }
 }
 
 /* comb filter */
@@ -227,6 +294,8 @@ typedef struct _freeverb_comb
 static void
 freeverb_comb_setbuffer (freeverb_comb * comb, gint size)
 {
+  /* very low rates would otherwise end up with empty delay lines */
+  size = MAX (size, 1);
   comb->filterstore = 0;
   comb->bufidx = 0;
   comb->buffer = g_new (gfloat, size);
@@ -277,15 +346,194 @@ freeverb_comb_getfeedback(freeverb_comb* comb)
   return comb->feedback;
 }*/
 
-#define freeverb_comb_process(_comb, _input_1, _output) \
+/* copies the @n samples the comb is going to read into @tmp, the delay line
+ * is longer than a block so none of them is overwritten by the block itself */
+static void
+freeverb_comb_read (freeverb_comb * comb, gfloat * tmp, gint n)
+{
+  gint len = MIN (n, comb->bufsize - comb->bufidx);
+
+  memcpy (tmp, comb->buffer + comb->bufidx, len * sizeof (gfloat));
+  if (len < n)
+    memcpy (tmp + len, comb->buffer, (n - len) * sizeof (gfloat));
+}
+
+/* refills one contiguous run of the delay line from the input and the
+ * damped feedback, and sums the samples read from it into @output */
+static void
+freeverb_comb_run (gfloat * buf, const gfloat * input, const gfloat * store,
+    const gfloat * tmp, gfloat * output, gfloat feedback, gint len)
+{
+  gint i = 0;
+
+#if defined (__SSE2__)
+  {
+    const __m128 fb = _mm_set1_ps (feedback);
+
+    for (; i + 4 <= len; i += 4) {
+      _mm_storeu_ps (buf + i, _mm_add_ps (_mm_loadu_ps (input + i),
+              _mm_mul_ps (_mm_loadu_ps (store + i), fb)));
+      _mm_storeu_ps (output + i, _mm_add_ps (_mm_loadu_ps (output + i),
+              _mm_loadu_ps (tmp + i)));
+    }
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    const float32x4_t fb = vdupq_n_f32 (feedback);
+
+    for (; i + 4 <= len; i += 4) {
+      vst1q_f32 (buf + i, vaddq_f32 (vld1q_f32 (input + i),
+              vmulq_f32 (vld1q_f32 (store + i), fb)));
+      vst1q_f32 (output + i, vaddq_f32 (vld1q_f32 (output + i),
+              vld1q_f32 (tmp + i)));
+    }
+  }
+#endif
+
+  for (; i < len; i++) {
+    buf[i] = input[i] + (store[i] * feedback);
+    output[i] += tmp[i];
+  }
+}
+
+static void
+freeverb_comb_write (freeverb_comb * comb, const gfloat * input,
+    const gfloat * store, const gfloat * tmp, gfloat * output, gint n)
+{
+  gint len;
+
+  while (n > 0) {
+    len = MIN (n, comb->bufsize - comb->bufidx);
+    freeverb_comb_run (comb->buffer + comb->bufidx, input, store, tmp, output,
+        comb->feedback, len);
+    input += len;
+    store += len;
+    tmp += len;
+    output += len;
+    n -= len;
+    if ((comb->bufidx += len) >= comb->bufsize) {
+      comb->bufidx = 0;
+    }
+  }
+}
+
+#if defined (__ARM_NEON) || defined (__ARM_NEON__)
+#define FREEVERB_TRANSPOSE4(r0, r1, r2, r3) \
 { \
-  gfloat _tmp = _comb.buffer[_comb.bufidx]; \
-  _comb.filterstore = (_tmp * _comb.damp2) + (_comb.filterstore * _comb.damp1); \
-  _comb.buffer[_comb.bufidx] = _input_1 + (_comb.filterstore * _comb.feedback); \
-  if (++_comb.bufidx >= _comb.bufsize) { \
-    _comb.bufidx = 0; \
-  } \
-  _output += _tmp; \
+  float32x4x2_t _t01 = vtrnq_f32 (r0, r1); \
+  float32x4x2_t _t23 = vtrnq_f32 (r2, r3); \
+  r0 = vcombine_f32 (vget_low_f32 (_t01.val[0]), vget_low_f32 (_t23.val[0])); \
+  r1 = vcombine_f32 (vget_low_f32 (_t01.val[1]), vget_low_f32 (_t23.val[1])); \
+  r2 = vcombine_f32 (vget_high_f32 (_t01.val[0]), \
+      vget_high_f32 (_t23.val[0])); \
+  r3 = vcombine_f32 (vget_high_f32 (_t01.val[1]), \
+      vget_high_f32 (_t23.val[1])); \
+}
+#endif
+
+/* The lowpass in the feedback path is the only recursion of the comb, run
+ * it for FREEVERB_COMB_LANES combs at once with one comb per vector lane.
+ * The rows read from the delay lines are transposed four samples at a time
+ * so that each vector holds one sample of every comb. */
+static void
+freeverb_comb_filter (freeverb_comb * combs,
+    gfloat tmp[][FREEVERB_BLOCK_SIZE], gfloat store[][FREEVERB_BLOCK_SIZE],
+    gint n)
+{
+  gfloat filterstore[FREEVERB_COMB_LANES];
+  gint c, i = 0;
+
+  for (c = 0; c < FREEVERB_COMB_LANES; c++)
+    filterstore[c] = combs[c].filterstore;
+
+#if defined (__SSE2__)
+  {
+    const __m128 d1 = _mm_setr_ps (combs[0].damp1, combs[1].damp1,
+        combs[2].damp1, combs[3].damp1);
+    const __m128 d2 = _mm_setr_ps (combs[0].damp2, combs[1].damp2,
+        combs[2].damp2, combs[3].damp2);
+    __m128 r0, r1, r2, r3, s = _mm_loadu_ps (filterstore);
+
+    for (; i + 4 <= n; i += 4) {
+      r0 = _mm_loadu_ps (tmp[0] + i);
+      r1 = _mm_loadu_ps (tmp[1] + i);
+      r2 = _mm_loadu_ps (tmp[2] + i);
+      r3 = _mm_loadu_ps (tmp[3] + i);
+      _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+      r0 = s = _mm_add_ps (_mm_mul_ps (r0, d2), _mm_mul_ps (s, d1));
+      r1 = s = _mm_add_ps (_mm_mul_ps (r1, d2), _mm_mul_ps (s, d1));
+      r2 = s = _mm_add_ps (_mm_mul_ps (r2, d2), _mm_mul_ps (s, d1));
+      r3 = s = _mm_add_ps (_mm_mul_ps (r3, d2), _mm_mul_ps (s, d1));
+      _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+      _mm_storeu_ps (store[0] + i, r0);
+      _mm_storeu_ps (store[1] + i, r1);
+      _mm_storeu_ps (store[2] + i, r2);
+      _mm_storeu_ps (store[3] + i, r3);
+    }
+    _mm_storeu_ps (filterstore, s);
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    const gfloat damp1s[4] = { combs[0].damp1, combs[1].damp1,
+      combs[2].damp1, combs[3].damp1
+    };
+    const gfloat damp2s[4] = { combs[0].damp2, combs[1].damp2,
+      combs[2].damp2, combs[3].damp2
+    };
+    const float32x4_t d1 = vld1q_f32 (damp1s);
+    const float32x4_t d2 = vld1q_f32 (damp2s);
+    float32x4_t r0, r1, r2, r3, s = vld1q_f32 (filterstore);
+
+    for (; i + 4 <= n; i += 4) {
+      r0 = vld1q_f32 (tmp[0] + i);
+      r1 = vld1q_f32 (tmp[1] + i);
+      r2 = vld1q_f32 (tmp[2] + i);
+      r3 = vld1q_f32 (tmp[3] + i);
+      FREEVERB_TRANSPOSE4 (r0, r1, r2, r3);
+      r0 = s = vaddq_f32 (vmulq_f32 (r0, d2), vmulq_f32 (s, d1));
+      r1 = s = vaddq_f32 (vmulq_f32 (r1, d2), vmulq_f32 (s, d1));
+      r2 = s = vaddq_f32 (vmulq_f32 (r2, d2), vmulq_f32 (s, d1));
+      r3 = s = vaddq_f32 (vmulq_f32 (r3, d2), vmulq_f32 (s, d1));
+      FREEVERB_TRANSPOSE4 (r0, r1, r2, r3);
+      vst1q_f32 (store[0] + i, r0);
+      vst1q_f32 (store[1] + i, r1);
+      vst1q_f32 (store[2] + i, r2);
+      vst1q_f32 (store[3] + i, r3);
+    }
+    vst1q_f32 (filterstore, s);
+  }
+#endif
+
+  /* the combs are interleaved so that their recursions overlap */
+  for (; i < n; i++) {
+    for (c = 0; c < FREEVERB_COMB_LANES; c++) {
+      filterstore[c] = (tmp[c][i] * combs[c].damp2) +
+          (filterstore[c] * combs[c].damp1);
+      store[c][i] = filterstore[c];
+    }
+  }
+
+  for (c = 0; c < FREEVERB_COMB_LANES; c++)
+    combs[c].filterstore = filterstore[c];
+}
+
+/* runs FREEVERB_COMB_LANES parallel combs over @n samples of @input and
+ * accumulates their outputs into @output */
+static void
+freeverb_comb_process (freeverb_comb * combs, const gfloat * input,
+    gfloat * output, gint n)
+{
+  gfloat tmp[FREEVERB_COMB_LANES][FREEVERB_BLOCK_SIZE];
+  gfloat store[FREEVERB_COMB_LANES][FREEVERB_BLOCK_SIZE];
+  gint c;
+
+  for (c = 0; c < FREEVERB_COMB_LANES; c++)
+    freeverb_comb_read (&combs[c], tmp[c], n);
+
+  freeverb_comb_filter (combs, tmp, store, n);
+
+  for (c = 0; c < FREEVERB_COMB_LANES; c++)
+    freeverb_comb_write (&combs[c], input, store[c], tmp[c], output, n);
 }
 
 #define numcombs 8
@@ -345,8 +593,12 @@ struct _GstFreeverbPrivate
   /* Allpass filters */
   freeverb_allpass allpassL[numallpasses];
   freeverb_allpass allpassR[numallpasses];
+  /* samples processed per block, bounded by the shortest comb */
+  gint block_size;
 };
 
+G_STATIC_ASSERT (numcombs % FREEVERB_COMB_LANES == 0);
+
 static void
 freeverb_revmodel_init (GstFreeverb * filter)
 {
@@ -379,6 +631,27 @@ freeverb_revmodel_free (GstFreeverb * filter)
   }
 }
 
+static void
+freeverb_revmodel_process (GstFreeverbPrivate * priv, const gfloat * input_l,
+    const gfloat * input_r, gfloat * output_l, gfloat * output_r, gint n)
+{
+  gint i;
+
+  memset (output_l, 0, n * sizeof (gfloat));
+  memset (output_r, 0, n * sizeof (gfloat));
+
+  /* Accumulate comb filters in parallel */
+  for (i = 0; i < numcombs; i += FREEVERB_COMB_LANES) {
+    freeverb_comb_process (&priv->combL[i], input_l, output_l, n);
+    freeverb_comb_process (&priv->combR[i], input_r, output_r, n);
+  }
+  /* Feed through allpasses in series */
+  for (i = 0; i < numallpasses; i++) {
+    freeverb_allpass_process (&priv->allpassL[i], output_l, n);
+    freeverb_allpass_process (&priv->allpassR[i], output_r, n);
+  }
+}
+
 /* GObject vmethod implementations */
 
 static void
@@ -486,6 +759,7 @@ gst_freeverb_init_rev_model (GstFreeverb * filter)
 {
   gfloat srfactor = GST_AUDIO_INFO_RATE (&filter->info) / 44100.0f;
   GstFreeverbPrivate *priv = filter->priv;
+  gint i;
 
   freeverb_revmodel_free (filter);
 
@@ -516,6 +790,12 @@ gst_freeverb_init_rev_model (GstFreeverb * filter)
   freeverb_allpass_setbuffer (&priv->allpassL[3], allpasstuningL4 * srfactor);
   freeverb_allpass_setbuffer (&priv->allpassR[3], allpasstuningR4 * srfactor);
 
+  priv->block_size = FREEVERB_BLOCK_SIZE;
+  for (i = 0; i < numcombs; i++) {
+    priv->block_size = MIN (priv->block_size, priv->combL[i].bufsize);
+    priv->block_size = MIN (priv->block_size, priv->combR[i].bufsize);
+  }
+
   /* clear buffers */
   freeverb_revmodel_init (filter);
 
@@ -693,46 +973,44 @@ gst_freeverb_transform_m2s_int (GstFreeverb * filter,
     gint16 * idata, gint16 * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1;
+  gint i, n;
+  gfloat out_l1[FREEVERB_BLOCK_SIZE], out_r1[FREEVERB_BLOCK_SIZE];
+  gfloat input_1[FREEVERB_BLOCK_SIZE];
   gfloat out_l2, out_r2, input_2;
   gboolean drained = TRUE;
 
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  for (; num_samples > 0; num_samples -= n) {
+    n = MIN (num_samples, priv->block_size);
 
     /* The original Freeverb code expects a stereo signal and 'input_1'
      * is set to the sum of the left and right input_1 sample. Since
      * this code works on a mono signal, 'input_1' is set to twice the
      * input_1 sample. */
-    input_2 = (gfloat) * idata++;
-    input_1 = (2.0f * input_2 + DC_OFFSET) * priv->gain;
-
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
+    for (i = 0; i < n; i++)
+      input_1[i] = (2.0f * (gfloat) idata[i] + DC_OFFSET) * priv->gain;
+
+    freeverb_revmodel_process (priv, input_1, input_1, out_l1, out_r1, n);
+
+    for (i = 0; i < n; i++) {
+      input_2 = (gfloat) * idata++;
+
+      /* Remove the DC offset */
+      out_l1[i] -= (gfloat) DC_OFFSET;
+      out_r1[i] -= (gfloat) DC_OFFSET;
+
+      /* Calculate output */
+      out_l2 = out_l1[i] * priv->wet1 + out_r1[i] * priv->wet2 +
+          input_2 * priv->dry;
+      out_r2 = out_r1[i] * priv->wet1 + out_l1[i] * priv->wet2 +
+          input_2 * priv->dry;
+      out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
+      out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
+      *odata++ = (gint16) out_l2;
+      *odata++ = (gint16) out_r2;
+
+      if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
+        drained = FALSE;
     }
-
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
-
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2 * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2 * priv->dry;
-    out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
-    out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
-    *odata++ = (gint16) out_l2;
-    *odata++ = (gint16) out_r2;
-
-    if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
-      drained = FALSE;
   }
   return drained;
 }
@@ -742,44 +1020,43 @@ gst_freeverb_transform_s2s_int (GstFreeverb * filter,
     gint16 * idata, gint16 * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1l, input_1r;
+  gint i, n;
+  gfloat out_l1[FREEVERB_BLOCK_SIZE], out_r1[FREEVERB_BLOCK_SIZE];
+  gfloat input_1l[FREEVERB_BLOCK_SIZE], input_1r[FREEVERB_BLOCK_SIZE];
   gfloat out_l2, out_r2, input_2l, input_2r;
   gboolean drained = TRUE;
 
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  for (; num_samples > 0; num_samples -= n) {
+    n = MIN (num_samples, priv->block_size);
 
-    input_2l = (gfloat) * idata++;
-    input_2r = (gfloat) * idata++;
-    input_1l = (input_2l + DC_OFFSET) * priv->gain;
-    input_1r = (input_2r + DC_OFFSET) * priv->gain;
-
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1l, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1r, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
+    for (i = 0; i < n; i++) {
+      input_1l[i] = ((gfloat) idata[2 * i] + DC_OFFSET) * priv->gain;
+      input_1r[i] = ((gfloat) idata[2 * i + 1] + DC_OFFSET) * priv->gain;
     }
 
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
+    freeverb_revmodel_process (priv, input_1l, input_1r, out_l1, out_r1, n);
+
+    for (i = 0; i < n; i++) {
+      input_2l = (gfloat) * idata++;
+      input_2r = (gfloat) * idata++;
+
+      /* Remove the DC offset */
+      out_l1[i] -= (gfloat) DC_OFFSET;
+      out_r1[i] -= (gfloat) DC_OFFSET;
 
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2l * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2r * priv->dry;
-    out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
-    out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
-    *odata++ = (gint16) out_l2;
-    *odata++ = (gint16) out_r2;
+      /* Calculate output */
+      out_l2 = out_l1[i] * priv->wet1 + out_r1[i] * priv->wet2 +
+          input_2l * priv->dry;
+      out_r2 = out_r1[i] * priv->wet1 + out_l1[i] * priv->wet2 +
+          input_2r * priv->dry;
+      out_l2 = CLAMP (out_l2, G_MININT16, G_MAXINT16);
+      out_r2 = CLAMP (out_r2, G_MININT16, G_MAXINT16);
+      *odata++ = (gint16) out_l2;
+      *odata++ = (gint16) out_r2;
 
-    if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
-      drained = FALSE;
+      if (abs ((gint16) out_l2) > 0 || abs ((gint16) out_r2) > 0)
+        drained = FALSE;
+    }
   }
   return drained;
 }
@@ -789,44 +1066,42 @@ gst_freeverb_transform_m2s_float (GstFreeverb * filter,
     gfloat * idata, gfloat * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1;
+  gint i, n;
+  gfloat out_l1[FREEVERB_BLOCK_SIZE], out_r1[FREEVERB_BLOCK_SIZE];
+  gfloat input_1[FREEVERB_BLOCK_SIZE];
   gfloat out_l2, out_r2, input_2;
   gboolean drained = TRUE;
 
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  for (; num_samples > 0; num_samples -= n) {
+    n = MIN (num_samples, priv->block_size);
 
     /* The original Freeverb code expects a stereo signal and 'input_1'
      * is set to the sum of the left and right input_1 sample. Since
      * this code works on a mono signal, 'input_1' is set to twice the
      * input_1 sample. */
-    input_2 = *idata++;
-    input_1 = (2.0f * input_2 + DC_OFFSET) * priv->gain;
+    for (i = 0; i < n; i++)
+      input_1[i] = (2.0f * idata[i] + DC_OFFSET) * priv->gain;
 
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
-    }
+    freeverb_revmodel_process (priv, input_1, input_1, out_l1, out_r1, n);
 
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
+    for (i = 0; i < n; i++) {
+      input_2 = *idata++;
 
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2 * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2 * priv->dry;
-    *odata++ = out_l2;
-    *odata++ = out_r2;
+      /* Remove the DC offset */
+      out_l1[i] -= (gfloat) DC_OFFSET;
+      out_r1[i] -= (gfloat) DC_OFFSET;
 
-    if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
-      drained = FALSE;
+      /* Calculate output */
+      out_l2 = out_l1[i] * priv->wet1 + out_r1[i] * priv->wet2 +
+          input_2 * priv->dry;
+      out_r2 = out_r1[i] * priv->wet1 + out_l1[i] * priv->wet2 +
+          input_2 * priv->dry;
+      *odata++ = out_l2;
+      *odata++ = out_r2;
+
+      if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
+        drained = FALSE;
+    }
   }
   return drained;
 }
@@ -836,42 +1111,41 @@ gst_freeverb_transform_s2s_float (GstFreeverb * filter,
     gfloat * idata, gfloat * odata, guint num_samples)
 {
   GstFreeverbPrivate *priv = filter->priv;
-  gint i, k;
-  gfloat out_l1, out_r1, input_1l, input_1r;
+  gint i, n;
+  gfloat out_l1[FREEVERB_BLOCK_SIZE], out_r1[FREEVERB_BLOCK_SIZE];
+  gfloat input_1l[FREEVERB_BLOCK_SIZE], input_1r[FREEVERB_BLOCK_SIZE];
   gfloat out_l2, out_r2, input_2l, input_2r;
   gboolean drained = TRUE;
 
-  for (k = 0; k < num_samples; k++) {
-    out_l1 = out_r1 = 0.0;
+  for (; num_samples > 0; num_samples -= n) {
+    n = MIN (num_samples, priv->block_size);
 
-    input_2l = *idata++;
-    input_2r = *idata++;
-    input_1l = (input_2l + DC_OFFSET) * priv->gain;
-    input_1r = (input_2r + DC_OFFSET) * priv->gain;
-
-    /* Accumulate comb filters in parallel */
-    for (i = 0; i < numcombs; i++) {
-      freeverb_comb_process (priv->combL[i], input_1l, out_l1);
-      freeverb_comb_process (priv->combR[i], input_1r, out_r1);
-    }
-    /* Feed through allpasses in series */
-    for (i = 0; i < numallpasses; i++) {
-      freeverb_allpass_process (priv->allpassL[i], out_l1);
-      freeverb_allpass_process (priv->allpassR[i], out_r1);
+    for (i = 0; i < n; i++) {
+      input_1l[i] = (idata[2 * i] + DC_OFFSET) * priv->gain;
+      input_1r[i] = (idata[2 * i + 1] + DC_OFFSET) * priv->gain;
     }
 
-    /* Remove the DC offset */
-    out_l1 -= (gfloat) DC_OFFSET;
-    out_r1 -= (gfloat) DC_OFFSET;
+    freeverb_revmodel_process (priv, input_1l, input_1r, out_l1, out_r1, n);
 
-    /* Calculate output */
-    out_l2 = out_l1 * priv->wet1 + out_r1 * priv->wet2 + input_2l * priv->dry;
-    out_r2 = out_r1 * priv->wet1 + out_l1 * priv->wet2 + input_2r * priv->dry;
-    *odata++ = out_l2;
-    *odata++ = out_r2;
+    for (i = 0; i < n; i++) {
+      input_2l = *idata++;
+      input_2r = *idata++;
 
-    if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
-      drained = FALSE;
+      /* Remove the DC offset */
+      out_l1[i] -= (gfloat) DC_OFFSET;
+      out_r1[i] -= (gfloat) DC_OFFSET;
+
+      /* Calculate output */
+      out_l2 = out_l1[i] * priv->wet1 + out_r1[i] * priv->wet2 +
+          input_2l * priv->dry;
+      out_r2 = out_r1[i] * priv->wet1 + out_l1[i] * priv->wet2 +
+          input_2r * priv->dry;
+      *odata++ = out_l2;
+      *odata++ = out_r2;
+
+      if (fabs (out_l2) > 0 || fabs (out_r2) > 0)
+        drained = FALSE;
+    }
   }
   return drained;
 }
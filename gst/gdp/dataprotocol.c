@@ -363,6 +363,61 @@ static const guint16 gst_dp_crc_table[256] = {
   0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0
 };
 
+/* gst_dp_crc_table extended to process eight bytes at a time: entry [k][i] is
+ * the CRC register after byte i followed by k zero bytes, starting from 0 */
+static guint16 gst_dp_crc_tables[8][256];
+
+static void
+gst_dp_crc_init_tables (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    guint i, k;
+
+    for (i = 0; i < 256; i++)
+      gst_dp_crc_tables[0][i] = gst_dp_crc_table[i];
+
+    for (k = 1; k < 8; k++) {
+      for (i = 0; i < 256; i++) {
+        guint16 crc = gst_dp_crc_tables[k - 1][i];
+
+        gst_dp_crc_tables[k][i] =
+            (guint16) ((crc << 8) ^ gst_dp_crc_tables[0][crc >> 8]);
+      }
+    }
+
+    g_once_init_leave (&initialized, 1);
+  }
+}
+
+/* slice-by-8: the register is combined with the first two of every eight
+ * bytes, the table lookups of the eight bytes are independent */
+static guint16
+gst_dp_crc_update (guint16 crc_register, const guint8 * buffer, gsize length)
+{
+  guint16 (*t)[256] = gst_dp_crc_tables;
+
+  gst_dp_crc_init_tables ();
+
+  while (length >= 8) {
+    crc_register = t[7][buffer[0] ^ (crc_register >> 8)] ^
+        t[6][buffer[1] ^ (crc_register & 0xff)] ^
+        t[5][buffer[2]] ^ t[4][buffer[3]] ^
+        t[3][buffer[4]] ^ t[2][buffer[5]] ^
+        t[1][buffer[6]] ^ t[0][buffer[7]];
+    buffer += 8;
+    length -= 8;
+  }
+
+  while (length-- > 0) {
+    crc_register = (guint16) ((crc_register << 8) ^
+        t[0][((crc_register >> 8) & 0x00ff) ^ *buffer++]);
+  }
+
+  return crc_register;
+}
+
 /**
  * gst_dp_crc:
  * @buffer: array of bytes
@@ -385,10 +440,8 @@ gst_dp_crc (const guint8 * buffer, guint length)
   g_assert (buffer != NULL);
 
   /* calc CRC */
-  for (; length--;) {
-    crc_register = (guint16) ((crc_register << 8) ^
-        gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
-  }
+  crc_register = gst_dp_crc_update (crc_register, buffer, length);
+
   return (0xffff ^ crc_register);
 }
 
@@ -405,15 +458,8 @@ gst_dp_crc_from_memory_maps (const GstMapInfo * maps, guint n_maps)
 
   /* calc CRC */
   while (n_maps > 0) {
-    guint8 *buffer = maps->data;
-    gsize length = maps->size;
-
-    total_length += length;
-
-    while (length-- > 0) {
-      crc_register = (guint16) ((crc_register << 8) ^
-          gst_dp_crc_table[((crc_register >> 8) & 0x00ff) ^ *buffer++]);
-    }
+    total_length += maps->size;
+    crc_register = gst_dp_crc_update (crc_register, maps->data, maps->size);
     --n_maps;
     ++maps;
   }
@@ -58,12 +58,14 @@ GST_DEBUG_CATEGORY_STATIC (gst_gdp_pay_debug);
 
 #define DEFAULT_CRC_HEADER TRUE
 #define DEFAULT_CRC_PAYLOAD FALSE
+#define DEFAULT_BATCH_SIZE 1
 
 enum
 {
   PROP_0,
   PROP_CRC_HEADER,
-  PROP_CRC_PAYLOAD
+  PROP_CRC_PAYLOAD,
+  PROP_BATCH_SIZE
 };
 
 #define _do_init \
@@ -112,6 +114,21 @@ gst_gdp_pay_class_init (GstGDPPayClass * klass)
       g_param_spec_boolean ("crc-payload", "CRC Payload",
           "Calculate and store a CRC checksum on the payload",
           DEFAULT_CRC_PAYLOAD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstGDPPay:batch-size:
+   *
+   * Number of payloaded buffers to collect and push downstream at once in a
+   * buffer list, which lets sinks write them with a single call. Buffers are
+   * held back until the batch is full or a serialized event arrives, which
+   * adds latency.
+   *
+   * Since: 1.12
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch Size",
+          "Number of buffers to push at once in a buffer list "
+          "(1 = push each buffer on its own)", 1, G_MAXUINT,
+          DEFAULT_BATCH_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
   gst_element_class_set_static_metadata (gstelement_class,
       "GDP Payloader", "GDP/Payloader",
       "Payloads GStreamer Data Protocol buffers",
@@ -145,6 +162,7 @@ gst_gdp_pay_init (GstGDPPay * gdppay)
   gdppay->crc_header = DEFAULT_CRC_HEADER;
   gdppay->crc_payload = DEFAULT_CRC_PAYLOAD;
   gdppay->header_flag = gdppay->crc_header | gdppay->crc_payload;
+  gdppay->batch_size = DEFAULT_BATCH_SIZE;
   gdppay->offset = 0;
 }
 
@@ -173,6 +191,10 @@ gst_gdp_pay_reset (GstGDPPay * this)
 
     gst_buffer_unref (buffer);
   }
+  if (this->batch) {
+    gst_buffer_list_unref (this->batch);
+    this->batch = NULL;
+  }
   if (this->caps) {
     gst_caps_unref (this->caps);
     this->caps = NULL;
@@ -420,6 +442,36 @@ gst_gdp_queue_buffer (GstGDPPay * this, GstBuffer * buffer)
   return GST_FLOW_OK;
 }
 
+static GstFlowReturn
+gst_gdp_pay_push_batch (GstGDPPay * this)
+{
+  GstBufferList *batch = this->batch;
+
+  if (batch == NULL)
+    return GST_FLOW_OK;
+
+  this->batch = NULL;
+  GST_LOG_OBJECT (this, "Pushing batch of %u GDP buffers",
+      gst_buffer_list_length (batch));
+
+  return gst_pad_push_list (this->srcpad, batch);
+}
+
+/* add a buffer to the batch and push the batch once it is full, this takes
+ * ownership of the buffer */
+static GstFlowReturn
+gst_gdp_pay_batch_buffer (GstGDPPay * this, GstBuffer * buffer)
+{
+  if (this->batch == NULL)
+    this->batch = gst_buffer_list_new_sized (this->batch_size);
+
+  gst_buffer_list_add (this->batch, buffer);
+  if (gst_buffer_list_length (this->batch) < this->batch_size)
+    return GST_FLOW_OK;
+
+  return gst_gdp_pay_push_batch (this);
+}
+
 static GstFlowReturn
 gst_gdp_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
@@ -481,7 +533,17 @@ gst_gdp_pay_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (this->reset_streamheader)
     gst_gdp_pay_reset_streamheader (this);
 
-  ret = gst_gdp_queue_buffer (this, outbuffer);
+  if (this->batch_size > 1 && this->sent_streamheader
+      && !this->reset_streamheader) {
+    ret = gst_gdp_pay_batch_buffer (this, outbuffer);
+  } else {
+    /* buffers batched before the batch size was lowered go out first */
+    ret = gst_gdp_pay_push_batch (this);
+    if (ret == GST_FLOW_OK)
+      ret = gst_gdp_queue_buffer (this, outbuffer);
+    else
+      gst_buffer_unref (outbuffer);
+  }
 
 done:
   gst_buffer_unref (buffer);
@@ -519,6 +581,20 @@ gst_gdp_pay_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
   GST_DEBUG_OBJECT (this, "received event %p of type %s (%d)",
       event, gst_event_type_get_name (event->type), event->type);
 
+  /* batched buffers go out before any serialized event, they are dropped
+   * when flushing */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+    if (this->batch) {
+      gst_buffer_list_unref (this->batch);
+      this->batch = NULL;
+    }
+  } else if (GST_EVENT_IS_SERIALIZED (event)) {
+    flowret = gst_gdp_pay_push_batch (this);
+    if (flowret != GST_FLOW_OK)
+      GST_WARNING_OBJECT (this, "pushing batched GDP buffers returned %d",
+          flowret);
+  }
+
   /* now turn the event into a buffer */
   outbuffer = gst_gdp_buffer_from_event (this, event);
   if (!outbuffer)
@@ -655,6 +731,9 @@ gst_gdp_pay_set_property (GObject * object, guint prop_id,
           g_value_get_boolean (value) ? GST_DP_HEADER_FLAG_CRC_PAYLOAD : 0;
       this->header_flag = this->crc_header | this->crc_payload;
       break;
+    case PROP_BATCH_SIZE:
+      this->batch_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -677,6 +756,9 @@ gst_gdp_pay_get_property (GObject * object, guint prop_id,
     case PROP_CRC_PAYLOAD:
       g_value_set_boolean (value, this->crc_payload);
       break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, this->batch_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
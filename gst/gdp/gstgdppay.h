@@ -65,6 +65,9 @@ struct _GstGDPPay
   gboolean crc_header;
   gboolean crc_payload;
   GstDPHeaderFlag header_flag;
+
+  guint batch_size;
+  GstBufferList *batch; /* buffers collected for the next push */
 };
 
 struct _GstGDPPayClass
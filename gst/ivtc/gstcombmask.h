@@ -0,0 +1,100 @@
+/* GStreamer
+ *
+ * gstcombmask.h: comb detection kernel of the ivtc element
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_COMB_MASK_H_
+#define _GST_COMB_MASK_H_
+
+#include <glib.h>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+G_BEGIN_DECLS
+
+/* Marks the samples of line 2 that stick out of lines 1 and 3 by more than
+ * 5 in the same direction. Returns whether any sample is marked. */
+static inline gboolean
+get_comb_mask (guint8 * mask, const guint8 * src1, const guint8 * src2,
+    const guint8 * src3, int width)
+{
+  guint8 any = 0;
+  int i = 0;
+
+#if defined (__SSE2__)
+  {
+    const __m128i five = _mm_set1_epi8 (5);
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i acc = zero;
+
+    for (; i + 16 <= width; i += 16) {
+      __m128i a = _mm_loadu_si128 ((const __m128i *) (src1 + i));
+      __m128i b = _mm_loadu_si128 ((const __m128i *) (src2 + i));
+      __m128i c = _mm_loadu_si128 ((const __m128i *) (src3 + i));
+      /* saturating, so that nothing can be below 0 - 5 or above 255 + 5 */
+      __m128i lo = _mm_subs_epu8 (_mm_min_epu8 (a, c), five);
+      __m128i hi = _mm_adds_epu8 (_mm_max_epu8 (a, c), five);
+      /* b < lo or b > hi, i.e. a non-zero saturated difference */
+      __m128i m = _mm_or_si128 (_mm_subs_epu8 (lo, b), _mm_subs_epu8 (b, hi));
+
+      m = _mm_andnot_si128 (_mm_cmpeq_epi8 (m, zero), _mm_set1_epi8 (1));
+      _mm_storeu_si128 ((__m128i *) (mask + i), m);
+      acc = _mm_or_si128 (acc, m);
+    }
+    any = _mm_movemask_epi8 (_mm_cmpeq_epi8 (acc, zero)) != 0xffff;
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    const uint8x16_t five = vdupq_n_u8 (5);
+    const uint8x16_t one = vdupq_n_u8 (1);
+    uint8x16_t acc = vdupq_n_u8 (0);
+    uint8x8_t acc8;
+
+    for (; i + 16 <= width; i += 16) {
+      uint8x16_t a = vld1q_u8 (src1 + i);
+      uint8x16_t b = vld1q_u8 (src2 + i);
+      uint8x16_t c = vld1q_u8 (src3 + i);
+      uint8x16_t lo = vqsubq_u8 (vminq_u8 (a, c), five);
+      uint8x16_t hi = vqaddq_u8 (vmaxq_u8 (a, c), five);
+      uint8x16_t m = vorrq_u8 (vcltq_u8 (b, lo), vcgtq_u8 (b, hi));
+
+      m = vandq_u8 (m, one);
+      vst1q_u8 (mask + i, m);
+      acc = vorrq_u8 (acc, m);
+    }
+    acc8 = vorr_u8 (vget_low_u8 (acc), vget_high_u8 (acc));
+    any = vget_lane_u64 (vreinterpret_u64_u8 (acc8), 0) != 0;
+  }
+#endif
+
+  for (; i < width; i++) {
+    mask[i] = src2[i] < MIN (src1[i], src3[i]) - 5 ||
+        src2[i] > MAX (src1[i], src3[i]) + 5;
+    any |= mask[i];
+  }
+
+  return any;
+}
+
+G_END_DECLS
+
+#endif
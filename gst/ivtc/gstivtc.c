@@ -50,6 +50,8 @@
 #include <string.h>
 #include <math.h>
 
+#include "gstcombmask.h"
+
 /* only because element registration is in this file */
 #include "gstcombdetect.h"
 
@@ -139,6 +141,7 @@ gst_ivtc_class_init (GstIvtcClass * klass)
 static void
 gst_ivtc_init (GstIvtc * ivtc)
 {
+  ivtc->next_field_id = 1;
 }
 
 static GstCaps *
@@ -299,6 +302,7 @@ add_field (GstIvtc * ivtc, GstBuffer * buffer, int parity, int index)
   field->buffer = gst_buffer_ref (buffer);
   field->parity = parity;
   field->ts = ts;
+  field->id = ivtc->next_field_id++;
 
   gst_video_frame_map (&ivtc->fields[i].frame, &ivtc->sink_video_info,
       buffer, GST_MAP_READ);
@@ -311,6 +315,8 @@ similarity (GstIvtc * ivtc, int i1, int i2)
 {
   GstIvtcField *f1, *f2;
   int score;
+  int slot;
+  gboolean cacheable;
 
   g_return_val_if_fail (i1 >= 0 && i1 < ivtc->n_fields, 0);
   g_return_val_if_fail (i2 >= 0 && i2 < ivtc->n_fields, 0);
@@ -318,6 +324,15 @@ similarity (GstIvtc * ivtc, int i1, int i2)
   f1 = &ivtc->fields[i1];
   f2 = &ivtc->fields[i2];
 
+  /* each field is compared with the next one several times while the
+   * cadence is evaluated, only do it once */
+  slot = f1->id % GST_IVTC_MAX_FIELDS;
+  cacheable = f2->id == f1->id + 1;
+  if (cacheable && ivtc->score_ids[slot] == f1->id) {
+    GST_DEBUG ("cached score %d", ivtc->scores[slot]);
+    return ivtc->scores[slot];
+  }
+
   if (f1->parity == TOP_FIELD) {
     score = get_comb_score (&f1->frame, &f2->frame);
   } else {
@@ -326,6 +341,11 @@ similarity (GstIvtc * ivtc, int i1, int i2)
 
   GST_DEBUG ("score %d", score);
 
+  if (cacheable) {
+    ivtc->scores[slot] = score;
+    ivtc->score_ids[slot] = f1->id;
+  }
+
   return score;
 }
 
@@ -356,6 +376,17 @@ reconstruct (GstIvtc * ivtc, GstVideoFrame * dest_frame, int i1, int i2)
   for (k = 0; k < 3; k++) {
     height = GST_VIDEO_FRAME_COMP_HEIGHT (top, k);
     width = GST_VIDEO_FRAME_COMP_WIDTH (top, k);
+
+    /* both fields of the same frame with the same layout: the frame is
+     * copied as it is, in one go */
+    if (top->data[k] == bottom->data[k] &&
+        GST_VIDEO_FRAME_COMP_STRIDE (top, k) ==
+        GST_VIDEO_FRAME_COMP_STRIDE (dest_frame, k)) {
+      memcpy (GET_LINE (dest_frame, k, 0), GET_LINE (top, k, 0),
+          (height - 1) * GST_VIDEO_FRAME_COMP_STRIDE (top, k) + width);
+      continue;
+    }
+
     for (j = 0; j < height; j++) {
       guint8 *dest = GET_LINE (dest_frame, k, j);
       guint8 *src = GET_LINE_IL (top, bottom, k, j);
@@ -634,6 +665,7 @@ get_comb_score (GstVideoFrame * top, GstVideoFrame * bottom)
 {
   int j;
   int thisline[MAX_WIDTH];
+  guint8 mask[MAX_WIDTH];
   int score = 0;
   int height;
   int width;
@@ -653,9 +685,14 @@ get_comb_score (GstVideoFrame * top, GstVideoFrame * bottom)
     guint8 *src3 = GET_LINE_IL (top, bottom, 0, j + 1);
     int i;
 
+    /* most lines of matching fields have no combing at all */
+    if (!get_comb_mask (mask, src1, src2, src3, width)) {
+      memset (thisline, 0, width * sizeof (int));
+      continue;
+    }
+
     for (i = 0; i < width; i++) {
-      if (src2[i] < MIN (src1[i], src3[i]) - 5 ||
-          src2[i] > MAX (src1[i], src3[i]) + 5) {
+      if (mask[i]) {
         if (i > 0) {
           thisline[i] += thisline[i - 1];
         }
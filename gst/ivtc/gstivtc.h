@@ -41,6 +41,8 @@ struct _GstIvtcField
   int parity;
   GstVideoFrame frame;
   GstClockTime ts;
+  /* increasing by one for each field added, never 0 */
+  guint64 id;
 };
 
 #define GST_IVTC_MAX_FIELDS 10
@@ -58,6 +60,12 @@ struct _GstIvtc
 
   int n_fields;
   GstIvtcField fields[GST_IVTC_MAX_FIELDS];
+  guint64 next_field_id;
+
+  /* comb score of each field woven with the field after it, in a ring
+   * indexed by the id of the first field */
+  int scores[GST_IVTC_MAX_FIELDS];
+  guint64 score_ids[GST_IVTC_MAX_FIELDS];
 };
 
 struct _GstIvtcClass
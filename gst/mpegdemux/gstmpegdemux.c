@@ -2188,12 +2188,15 @@ gst_ps_demux_data_cb (GstPESFilter * filter, gboolean first,
   gint stream_type;
   guint32 start_code;
   guint8 id;
-  GstMapInfo map;
-  gsize datalen;
+  guint8 hdr[4];
+  gsize hdrlen = 0, datalen;
   guint offset = 0;
 
-  gst_buffer_map (buffer, &map, GST_MAP_READ);
-  datalen = map.size;
+  datalen = gst_buffer_get_size (buffer);
+  /* only the first bytes are needed to identify the stream, don't map the
+   * payload */
+  if (first)
+    hdrlen = gst_buffer_extract (buffer, 0, hdr, sizeof (hdr));
 
   start_code = filter->start_code;
   id = filter->id;
@@ -2203,13 +2206,13 @@ gst_ps_demux_data_cb (GstPESFilter * filter, gboolean first,
     stream_type = demux->psm[id];
     if (stream_type == -1) {
       /* no stream type, if PS1, get the new id */
-      if (start_code == ID_PRIVATE_STREAM_1 && datalen >= 2) {
+      if (start_code == ID_PRIVATE_STREAM_1 && hdrlen >= 2) {
         /* VDR writes A52 streams without any header bytes
          * (see ftp://ftp.mplayerhq.hu/MPlayer/samples/MPEG-VOB/vdr-AC3) */
-        if (datalen >= 4) {
-          guint hdr = GST_READ_UINT32_BE (map.data);
+        if (hdrlen >= 4) {
+          guint sync = GST_READ_UINT32_BE (hdr);
 
-          if (G_UNLIKELY ((hdr & 0xffff0000) == AC3_SYNC_WORD)) {
+          if (G_UNLIKELY ((sync & 0xffff0000) == AC3_SYNC_WORD)) {
             id = 0x80;
             stream_type = demux->psm[id] = ST_GST_AUDIO_RAWA52;
             GST_DEBUG_OBJECT (demux, "Found VDR raw A52 stream");
@@ -2218,7 +2221,7 @@ gst_ps_demux_data_cb (GstPESFilter * filter, gboolean first,
 
         if (G_LIKELY (stream_type == -1)) {
           /* new id is in the first byte */
-          id = map.data[offset++];
+          id = hdr[offset++];
           datalen--;
 
           /* and remap */
@@ -2232,7 +2235,7 @@ gst_ps_demux_data_cb (GstPESFilter * filter, gboolean first,
 #ifndef GST_DISABLE_GST_DEBUG
             guint8 nframes;
 
-            nframes = map.data[offset];
+            nframes = hdr[offset];
             GST_LOG_OBJECT (demux, "private type 0x%02x, %d frames", id,
                 nframes);
 #endif
@@ -2288,8 +2291,16 @@ gst_ps_demux_data_cb (GstPESFilter * filter, gboolean first,
   }
 
   if (demux->current_stream->notlinked == FALSE) {
-    out_buf =
-        gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL, offset, datalen);
+    /* the payload is usually a sub-buffer of the input already, only strip
+     * the private stream header bytes if there are any */
+    if (offset == 0) {
+      out_buf = gst_buffer_make_writable (buffer);
+      buffer = NULL;
+    } else {
+      out_buf =
+          gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL, offset,
+          datalen);
+    }
 
     ret = gst_ps_demux_send_data (demux, demux->current_stream, out_buf);
     if (ret == GST_FLOW_NOT_LINKED) {
@@ -2298,8 +2309,8 @@ gst_ps_demux_data_cb (GstPESFilter * filter, gboolean first,
   }
 
 done:
-  gst_buffer_unmap (buffer, &map);
-  gst_buffer_unref (buffer);
+  if (buffer)
+    gst_buffer_unref (buffer);
 
   return ret;
 
@@ -2315,58 +2326,46 @@ unknown_stream_type:
 static gboolean
 gst_ps_demux_resync (GstPsDemux * demux, gboolean save)
 {
-  const guint8 *data;
   gint avail;
   guint32 code;
-  gint offset;
+  gint skip;
   gboolean found;
 
   avail = gst_adapter_available (demux->adapter);
   if (G_UNLIKELY (avail < 4))
     goto need_data;
 
-  /* Common case, read 4 bytes an check it */
-  data = gst_adapter_map (demux->adapter, 4);
-
-  /* read currect code */
-  code = GST_READ_UINT32_BE (data);
+  /* Search the sync code in all available data in the adapter. The common
+   * case is that it is at 0 bytes offset. The scan works on the buffers in
+   * the adapter and does not merge them. */
+  skip = gst_adapter_masked_scan_uint32_peek (demux->adapter, 0xffffff00,
+      0x100, 0, avail, &code);
 
-  /* The common case is that the sync code is at 0 bytes offset */
-  if (G_LIKELY ((code & 0xffffff00) == 0x100L)) {
+  if (G_LIKELY (skip == 0)) {
     GST_LOG_OBJECT (demux, "Found resync code %08x after 0 bytes", code);
     demux->last_sync_code = code;
-    gst_adapter_unmap (demux->adapter);
     return TRUE;
   }
 
-  /* Otherwise, we are starting at byte 4 and we need to search
-     the sync code in all available data in the adapter */
-  offset = 4;
-  if (offset >= avail)
-    goto need_data;             /* Not enough data to find sync */
-
-  data = gst_adapter_map (demux->adapter, avail);
-
-  do {
-    code = (code << 8) | data[offset++];
-    found = (code & 0xffffff00) == 0x100L;
-  } while (offset < avail && !found);
-
-  gst_adapter_unmap (demux->adapter);
+  found = skip != -1;
+  if (!found) {
+    /* keep the last bytes, they could be the start of a sync code */
+    skip = avail - 4;
+  }
 
   if (!save || demux->sink_segment.rate >= 0.0) {
-    GST_LOG_OBJECT (demux, "flushing %d bytes", offset - 4);
+    GST_LOG_OBJECT (demux, "flushing %d bytes", skip);
     /* forward playback, we can discard and flush the skipped bytes */
-    gst_adapter_flush (demux->adapter, offset - 4);
-    ADAPTER_OFFSET_FLUSH (offset - 4);
+    gst_adapter_flush (demux->adapter, skip);
+    ADAPTER_OFFSET_FLUSH (skip);
   } else {
     if (found) {
-      GST_LOG_OBJECT (demux, "reverse saving %d bytes", offset - 4);
+      GST_LOG_OBJECT (demux, "reverse saving %d bytes", skip);
       /* reverse playback, we keep the flushed bytes and we will append them to
        * the next buffer in the chain function, which is the previous buffer in
        * the stream. */
       gst_adapter_push (demux->rev_adapter,
-          gst_adapter_take_buffer (demux->adapter, offset - 4));
+          gst_adapter_take_buffer (demux->adapter, skip));
     } else {
       GST_LOG_OBJECT (demux, "reverse saving %d bytes", avail);
       /* nothing found, keep all bytes */
@@ -2377,10 +2376,10 @@ gst_ps_demux_resync (GstPsDemux * demux, gboolean save)
 
   if (found) {
     GST_LOG_OBJECT (demux, "Found resync code %08x after %d bytes",
-        code, offset - 4);
+        code, skip);
     demux->last_sync_code = code;
   } else {
-    GST_LOG_OBJECT (demux, "No resync after skipping %d", offset);
+    GST_LOG_OBJECT (demux, "No resync after skipping %d", skip);
   }
 
   return found;
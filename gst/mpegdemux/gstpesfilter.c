@@ -56,6 +56,10 @@ static GstFlowReturn gst_pes_filter_data_push (GstPESFilter * filter,
 
 #define ADAPTER_OFFSET_FLUSH(_bytes_)  if (filter->adapter_offset) *filter->adapter_offset = *filter->adapter_offset + (_bytes_)
 
+/* start code, length and the largest MPEG-2 PES header (3 bytes of flags
+ * and up to 255 bytes of header data). MPEG-1 headers are smaller. */
+#define PES_MAX_HEADER_SIZE (6 + 3 + 255)
+
 /* May pass null for adapter to have the filter create one */
 void
 gst_pes_filter_init (GstPESFilter * filter, GstAdapter * adapter,
@@ -116,7 +120,7 @@ gst_pes_filter_parse (GstPESFilter * filter)
   gboolean STD_buffer_bound_scale G_GNUC_UNUSED;
   guint16 STD_buffer_size_bound;
   const guint8 *data;
-  gint avail, datalen;
+  gint avail, datalen, header_size;
   gboolean have_size = FALSE;
 
   avail = gst_adapter_available (filter->adapter);
@@ -176,16 +180,17 @@ gst_pes_filter_parse (GstPESFilter * filter)
 
   gst_adapter_unmap (filter->adapter);
 
-  /* read more data, either the whole packet if there is a length
-   * or whatever we have available if this in an unbounded packet. */
-  data = gst_adapter_map (filter->adapter, avail);
+  /* map the PES header only, the payload is taken from the adapter without
+   * mapping it, which avoids merging the input buffers the packet lies in */
+  header_size = MIN (avail, PES_MAX_HEADER_SIZE);
+  data = gst_adapter_map (filter->adapter, header_size);
 
   /* This will make us flag LOST_SYNC if we run out of data from here onward */
   have_size = TRUE;
 
   /* skip start code and length */
   data += 6;
-  datalen = avail - 6;
+  datalen = header_size - 6;
 
   GST_DEBUG ("datalen %d", datalen);
 
@@ -462,9 +467,13 @@ push_out:
 #ifndef GST_DISABLE_GST_DEBUG
     guint16 consumed;
 
-    consumed = avail - 6 - datalen;
+    consumed = header_size - 6 - datalen;
 #endif
 
+    /* from here on, datalen is the size of the payload in the packet */
+    header_size = MIN (header_size - datalen, avail);
+    datalen = avail - header_size;
+
     if (filter->unbounded_packet == FALSE) {
       filter->length -= avail - 6;
       GST_DEBUG ("pushing %d, need %d more, consumed %d",
@@ -474,9 +483,14 @@ push_out:
           datalen, consumed);
     }
 
+    gst_adapter_unmap (filter->adapter);
+    gst_adapter_flush (filter->adapter, header_size);
+    ADAPTER_OFFSET_FLUSH (header_size);
+
     if (datalen > 0) {
-      out = gst_buffer_new_allocate (NULL, datalen, NULL);
-      gst_buffer_fill (out, 0, data, datalen);
+      /* a sub-buffer of the input buffer if the payload lies within one */
+      out = gst_adapter_take_buffer (filter->adapter, datalen);
+      ADAPTER_OFFSET_FLUSH (datalen);
       ret = gst_pes_filter_data_push (filter, TRUE, out);
       filter->first = FALSE;
     } else {
@@ -489,10 +503,6 @@ push_out:
       filter->state = STATE_DATA_PUSH;
   }
 
-  gst_adapter_unmap (filter->adapter);
-  gst_adapter_flush (filter->adapter, avail);
-  ADAPTER_OFFSET_FLUSH (avail);
-
   return ret;
 
 need_more_data:
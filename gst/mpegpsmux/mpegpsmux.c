@@ -54,10 +54,15 @@ GST_DEBUG_CATEGORY (mpegpsmux_debug);
 
 enum
 {
-  PROP_AGGREGATE_GOPS = 1
+  PROP_AGGREGATE_GOPS = 1,
+  PROP_PACKS_PER_BUFFER
 };
 
 #define DEFAULT_AGGREGATE_GOPS FALSE
+#define DEFAULT_PACKS_PER_BUFFER 0
+
+/* room for the pack header, system header and PSM in front of a PES packet */
+#define PACK_HEADERS_ROOM 1024
 
 static GstStaticPadTemplate mpegpsmux_sink_factory =
     GST_STATIC_PAD_TEMPLATE ("sink_%u",
@@ -95,6 +100,8 @@ static void gst_mpegpsmux_get_property (GObject * object, guint prop_id,
 
 static void mpegpsmux_finalize (GObject * object);
 static gboolean new_packet_cb (guint8 * data, guint len, void *user_data);
+static guint8 *alloc_packet_cb (guint len, void *user_data);
+static GstFlowReturn mpegpsmux_finish_out_buffer (MpegPsMux * mux);
 
 static gboolean mpegpsdemux_prepare_srcpad (MpegPsMux * mux);
 static GstFlowReturn mpegpsmux_collected (GstCollectPads * pads,
@@ -127,6 +134,12 @@ mpegpsmux_class_init (MpegPsMuxClass * klass)
           "Whether to aggregate GOPs and push them out as buffer lists",
           DEFAULT_AGGREGATE_GOPS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_PACKS_PER_BUFFER,
+      g_param_spec_uint ("packs-per-buffer", "Packs per buffer",
+          "Number of packs to write directly into each output buffer "
+          "(0 = one buffer per packet)", 0, 1024, DEFAULT_PACKS_PER_BUFFER,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (gstelement_class,
       &mpegpsmux_sink_factory);
   gst_element_class_add_static_pad_template (gstelement_class,
@@ -152,17 +165,33 @@ mpegpsmux_init (MpegPsMux * mux)
 
   mux->psmux = psmux_new ();
   psmux_set_write_func (mux->psmux, new_packet_cb, mux);
+  psmux_set_alloc_func (mux->psmux, alloc_packet_cb, mux);
+  mux->packs_per_buffer = DEFAULT_PACKS_PER_BUFFER;
 
   mux->first = TRUE;
   mux->last_flow_ret = GST_FLOW_OK;
   mux->last_ts = 0;             /* XXX: or -1? */
 }
 
+static void
+mpegpsmux_drop_out_buffer (MpegPsMux * mux)
+{
+  if (mux->out_buf == NULL)
+    return;
+
+  gst_buffer_unmap (mux->out_buf, &mux->out_map);
+  gst_buffer_unref (mux->out_buf);
+  mux->out_buf = NULL;
+  mux->out_ptr = NULL;
+}
+
 static void
 mpegpsmux_finalize (GObject * object)
 {
   MpegPsMux *mux = GST_MPEG_PSMUX (object);
 
+  mpegpsmux_drop_out_buffer (mux);
+
   if (mux->collect) {
     gst_object_unref (mux->collect);
     mux->collect = NULL;
@@ -190,6 +219,9 @@ gst_mpegpsmux_set_property (GObject * object, guint prop_id,
     case PROP_AGGREGATE_GOPS:
       mux->aggregate_gops = g_value_get_boolean (value);
       break;
+    case PROP_PACKS_PER_BUFFER:
+      mux->packs_per_buffer = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -206,6 +238,9 @@ gst_mpegpsmux_get_property (GObject * object, guint prop_id,
     case PROP_AGGREGATE_GOPS:
       g_value_set_boolean (value, mux->aggregate_gops);
       break;
+    case PROP_PACKS_PER_BUFFER:
+      g_value_set_uint (value, mux->packs_per_buffer);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -549,8 +584,11 @@ mpegpsmux_collected (GstCollectPads * pads, MpegPsMux * mux)
     keyunit = !GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
 
     if (keyunit && best->stream_id == mux->video_stream_id
-        && mux->gop_list != NULL) {
-      ret = mpegpsmux_push_gop_list (mux);
+        && (mux->gop_list != NULL || mux->out_buf != NULL)) {
+      /* a GOP starts in a new output buffer */
+      ret = mpegpsmux_finish_out_buffer (mux);
+      if (ret == GST_FLOW_OK && mux->gop_list != NULL)
+        ret = mpegpsmux_push_gop_list (mux);
       if (ret != GST_FLOW_OK)
         goto done;
     }
@@ -561,23 +599,31 @@ mpegpsmux_collected (GstCollectPads * pads, MpegPsMux * mux)
     best->queued.buf = NULL;
 
     /* write the data from libpsmux to stream */
+    mux->last_flow_ret = GST_FLOW_OK;
     while (psmux_stream_bytes_in_buffer (best->stream) > 0) {
       GST_LOG_OBJECT (mux, "Before @psmux_write_stream_packet");
       if (!psmux_write_stream_packet (mux->psmux, best->stream)) {
         GST_DEBUG_OBJECT (mux, "Failed to write data packet");
         goto write_fail;
       }
+      if (mux->out_buf != NULL
+          && ++mux->out_packs >= mux->packs_per_buffer) {
+        ret = mpegpsmux_finish_out_buffer (mux);
+        if (ret != GST_FLOW_OK)
+          goto done;
+      }
     }
     mux->last_ts = best->last_ts;
   } else {
     /* FIXME: Drain all remaining streams */
     /* At EOS */
-    if (mux->gop_list != NULL)
-      mpegpsmux_push_gop_list (mux);
+    mpegpsmux_finish_out_buffer (mux);
 
     if (!psmux_write_end_code (mux->psmux)) {
       GST_WARNING_OBJECT (mux, "Writing MPEG PS Program end code failed.");
     }
+    if (mux->gop_list != NULL)
+      mpegpsmux_push_gop_list (mux);
     gst_pad_push_event (mux->srcpad, gst_event_new_eos ());
 
     ret = GST_FLOW_EOS;
@@ -658,6 +704,73 @@ mpegpsmux_release_pad (GstElement * element, GstPad * pad)
   gst_collect_pads_remove_pad (mux->collect, pad);
 }
 
+/* pushes the filled output buffer, or adds it to the pending GOP */
+static GstFlowReturn
+mpegpsmux_finish_out_buffer (MpegPsMux * mux)
+{
+  GstBuffer *buf = mux->out_buf;
+  GstFlowReturn ret;
+
+  if (buf == NULL)
+    return GST_FLOW_OK;
+
+  gst_buffer_unmap (buf, &mux->out_map);
+  gst_buffer_set_size (buf, mux->out_size);
+  mux->out_buf = NULL;
+  mux->out_ptr = NULL;
+
+  GST_LOG_OBJECT (mux, "Outputting %u packs in a buffer of %" G_GSIZE_FORMAT
+      " bytes", mux->out_packs, mux->out_size);
+
+  if (mux->aggregate_gops) {
+    if (mux->gop_list == NULL)
+      mux->gop_list = gst_buffer_list_new ();
+
+    gst_buffer_list_add (mux->gop_list, buf);
+    return GST_FLOW_OK;
+  }
+
+  ret = gst_pad_push (mux->srcpad, buf);
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    mux->last_flow_ret = ret;
+
+  return ret;
+}
+
+static guint8 *
+alloc_packet_cb (guint len, void *user_data)
+{
+  /* Called when the PsMux is about to write a packet of at most len bytes.
+   * Return NULL to let it use its own memory */
+
+  MpegPsMux *mux = (MpegPsMux *) user_data;
+
+  if (mux->packs_per_buffer == 0)
+    return NULL;
+
+  /* a failed push is stored in last_flow_ret, new_packet_cb then fails the
+   * packet */
+  if (mux->out_buf != NULL && mux->out_map.size - mux->out_size < len) {
+    if (mpegpsmux_finish_out_buffer (mux) != GST_FLOW_OK)
+      return NULL;
+  }
+
+  if (mux->out_buf == NULL) {
+    gsize size = MAX (len,
+        mux->packs_per_buffer * (PSMUX_MAX_PACKET_LEN + PACK_HEADERS_ROOM));
+
+    mux->out_buf = gst_buffer_new_allocate (NULL, size, NULL);
+    gst_buffer_map (mux->out_buf, &mux->out_map, GST_MAP_WRITE);
+    mux->out_size = 0;
+    mux->out_packs = 0;
+    GST_BUFFER_TIMESTAMP (mux->out_buf) = mux->last_ts;
+  }
+
+  mux->out_ptr = mux->out_map.data + mux->out_size;
+
+  return mux->out_ptr;
+}
+
 static gboolean
 new_packet_cb (guint8 * data, guint len, void *user_data)
 {
@@ -668,6 +781,16 @@ new_packet_cb (guint8 * data, guint len, void *user_data)
   GstBuffer *buf;
   GstFlowReturn ret;
 
+  if (G_UNLIKELY (mux->last_flow_ret != GST_FLOW_OK))
+    return FALSE;
+
+  if (mux->out_ptr != NULL && data == mux->out_ptr) {
+    /* written in place into the output buffer */
+    mux->out_size += len;
+    mux->out_ptr = NULL;
+    return TRUE;
+  }
+
   GST_LOG_OBJECT (mux, "Outputting a packet of length %d", len);
 
   data = g_memdup (data, len);
@@ -753,6 +876,7 @@ mpegpsmux_change_state (GstElement * element, GstStateChange transition)
       break;
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_collect_pads_stop (mux->collect);
+      mpegpsmux_drop_out_buffer (mux);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       break;
@@ -81,6 +81,14 @@ struct MpegPsMux {
 
   GstBufferList *gop_list;
   gboolean       aggregate_gops;
+
+  /* output buffer the packs are written into directly */
+  guint          packs_per_buffer;
+  GstBuffer     *out_buf;
+  GstMapInfo     out_map;
+  gsize          out_size;  /* bytes written into out_buf */
+  guint          out_packs; /* PES packets written into out_buf */
+  guint8        *out_ptr;   /* memory handed out for the next packet */
 };
 
 struct MpegPsMuxClass  {
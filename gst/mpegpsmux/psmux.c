@@ -111,6 +111,39 @@ psmux_set_write_func (PsMux * mux, PsMuxWriteFunc func, void *user_data)
   mux->write_func_data = user_data;
 }
 
+/**
+ * psmux_set_alloc_func:
+ * @mux: a #PsMux
+ * @func: a user callback function
+ * @user_data: user data passed to @func
+ *
+ * Set the callback function that provides the memory the next packet of at
+ * most len bytes is written into, so that the write function is called with
+ * that memory and the packet does not need to be copied again. If @func
+ * returns NULL, the packet is written into internal scratch memory.
+ */
+void
+psmux_set_alloc_func (PsMux * mux, PsMuxAllocFunc func, void *user_data)
+{
+  g_return_if_fail (mux != NULL);
+
+  mux->alloc_func = func;
+  mux->alloc_func_data = user_data;
+}
+
+/* select the memory the next packet of at most @max_len bytes goes into */
+static guint8 *
+psmux_packet_begin (PsMux * mux, guint max_len)
+{
+  mux->packet_buf = NULL;
+  if (mux->alloc_func)
+    mux->packet_buf = mux->alloc_func (max_len, mux->alloc_func_data);
+  if (mux->packet_buf == NULL)
+    mux->packet_buf = mux->packet_storage;
+
+  return mux->packet_buf;
+}
+
 gboolean
 psmux_write_end_code (PsMux * mux)
 {
@@ -232,6 +265,7 @@ gboolean
 psmux_write_stream_packet (PsMux * mux, PsMuxStream * stream)
 {
   gboolean res;
+  guint max_len;
 
   g_return_val_if_fail (mux != NULL, FALSE);
   g_return_val_if_fail (stream != NULL, FALSE);
@@ -280,9 +314,11 @@ psmux_write_stream_packet (PsMux * mux, PsMuxStream * stream)
   }
 
   /* Write the packet */
+  max_len = MIN (psmux_stream_bytes_in_buffer (stream), mux->pes_max_payload)
+      + PSMUX_PES_MAX_HDR_LEN;
   if (!(mux->packet_bytes_written =
-          psmux_stream_get_data (stream, mux->packet_buf,
-              mux->pes_max_payload + PSMUX_PES_MAX_HDR_LEN))) {
+          psmux_stream_get_data (stream, psmux_packet_begin (mux, max_len),
+              max_len))) {
     return FALSE;
   }
 
@@ -306,7 +342,7 @@ psmux_write_pack_header (PsMux * mux)
     scr = 0;
 
   /* pack_start_code */
-  bits_initwrite (&bw, 14, mux->packet_buf);
+  bits_initwrite (&bw, 14, psmux_packet_begin (mux, 14));
   bits_write (&bw, 24, PSMUX_START_CODE_PREFIX);
   bits_write (&bw, 8, PSMUX_PACK_HEADER);
 
@@ -396,14 +432,14 @@ psmux_ensure_system_header (PsMux * mux)
 static gboolean
 psmux_write_system_header (PsMux * mux)
 {
-  GstMapInfo map;
+  gsize size;
 
   psmux_ensure_system_header (mux);
 
-  gst_buffer_map (mux->sys_header, &map, GST_MAP_READ);
-  memcpy (mux->packet_buf, map.data, map.size);
-  mux->packet_bytes_written = map.size;
-  gst_buffer_unmap (mux->sys_header, &map);
+  size = gst_buffer_get_size (mux->sys_header);
+  gst_buffer_extract (mux->sys_header, 0, psmux_packet_begin (mux, size),
+      size);
+  mux->packet_bytes_written = size;
 
   return psmux_packet_out (mux);
 }
@@ -480,14 +516,13 @@ psmux_ensure_program_stream_map (PsMux * mux)
 static gboolean
 psmux_write_program_stream_map (PsMux * mux)
 {
-  GstMapInfo map;
+  gsize size;
 
   psmux_ensure_program_stream_map (mux);
 
-  gst_buffer_map (mux->psm, &map, GST_MAP_READ);
-  memcpy (mux->packet_buf, map.data, map.size);
-  mux->packet_bytes_written = map.size;
-  gst_buffer_unmap (mux->psm, &map);
+  size = gst_buffer_get_size (mux->psm);
+  gst_buffer_extract (mux->psm, 0, psmux_packet_begin (mux, size), size);
+  mux->packet_bytes_written = size;
 
   return psmux_packet_out (mux);
 }
@@ -55,6 +55,7 @@ G_BEGIN_DECLS
 #define PSMUX_MAX_ES_INFO_LENGTH ((1 << 12) - 1)
 
 typedef gboolean (*PsMuxWriteFunc) (guint8 *data, guint len, void *user_data);
+typedef guint8 * (*PsMuxAllocFunc) (guint len, void *user_data);
 
 struct PsMux {
   GList *streams;    /* PsMuxStream* array of all streams */
@@ -81,10 +82,15 @@ struct PsMux {
   guint psm_freq; /* program stream map frequency */ 
   GstClockTime psm_pts; /* last time a psm is written */
 
-  guint8 packet_buf[PSMUX_MAX_PACKET_LEN];
+  guint8 *packet_buf; /* where the current packet is written */
   guint packet_bytes_written; /* # of bytes written in the buf */
   PsMuxWriteFunc write_func;
   void *write_func_data;
+  PsMuxAllocFunc alloc_func;
+  void *alloc_func_data;
+
+  /* Scratch space for packets if there is no alloc_func */
+  guint8 packet_storage[PSMUX_MAX_PACKET_LEN];
 
   /* Scratch space for writing ES_info descriptors */
   guint8 es_info_buf[PSMUX_MAX_ES_INFO_LENGTH];
@@ -105,6 +111,7 @@ void 		psmux_free 			(PsMux *mux);
 
 /* Setting muxing session properties */
 void 		psmux_set_write_func 		(PsMux *mux, PsMuxWriteFunc func, void *user_data);
+void 		psmux_set_alloc_func 		(PsMux *mux, PsMuxAllocFunc func, void *user_data);
 
 /* stream management */
 PsMuxStream *	psmux_create_stream 		(PsMux *mux, PsMuxStreamType stream_type);
@@ -168,7 +168,8 @@ psmux_stream_new (PsMux * mux, PsMuxStreamType stream_type)
   else
     stream->pi.flags |= PSMUX_PACKET_FLAG_PES_FULL_HEADER;
 
-  stream->buffers = NULL;
+  stream->buffers = g_ptr_array_new ();
+  stream->buffers_head = 0;
   stream->bytes_avail = 0;
   stream->cur_buffer = NULL;
   stream->cur_buffer_consumed = 0;
@@ -206,11 +207,25 @@ psmux_stream_new (PsMux * mux, PsMuxStreamType stream_type)
 void
 psmux_stream_free (PsMuxStream * stream)
 {
+  guint i;
+
   g_return_if_fail (stream != NULL);
 
   if (psmux_stream_bytes_in_buffer (stream)) {
     g_warning ("Freeing stream with data not yet processed");
   }
+
+  for (i = stream->buffers_head; i < stream->buffers->len; i++) {
+    PsMuxStreamBuffer *packet = g_ptr_array_index (stream->buffers, i);
+
+    gst_buffer_unmap (packet->buf, &packet->map);
+    gst_buffer_unref (packet->buf);
+    g_slice_free (PsMuxStreamBuffer, packet);
+  }
+  g_ptr_array_free (stream->buffers, TRUE);
+  if (stream->spare_buffer)
+    g_slice_free (PsMuxStreamBuffer, stream->spare_buffer);
+
   g_slice_free (PsMuxStream, stream);
 }
 
@@ -233,11 +248,21 @@ psmux_stream_consume (PsMuxStream * stream, guint len)
 
   if (stream->cur_buffer_consumed == stream->cur_buffer->map.size) {
     /* Current packet is completed, move along */
-    stream->buffers = g_list_delete_link (stream->buffers, stream->buffers);
+    stream->buffers_head++;
+    if (stream->buffers_head == stream->buffers->len) {
+      g_ptr_array_set_size (stream->buffers, 0);
+      stream->buffers_head = 0;
+    } else if (stream->buffers_head >= 64) {
+      g_ptr_array_remove_range (stream->buffers, 0, stream->buffers_head);
+      stream->buffers_head = 0;
+    }
 
     gst_buffer_unmap (stream->cur_buffer->buf, &stream->cur_buffer->map);
     gst_buffer_unref (stream->cur_buffer->buf);
-    g_slice_free (PsMuxStreamBuffer, stream->cur_buffer);
+    if (stream->spare_buffer == NULL)
+      stream->spare_buffer = stream->cur_buffer;
+    else
+      g_slice_free (PsMuxStreamBuffer, stream->cur_buffer);
     stream->cur_buffer = NULL;
   }
 }
@@ -317,9 +342,10 @@ psmux_stream_get_data (PsMuxStream * stream, guint8 * buf, guint len)
 
     if (stream->cur_buffer == NULL) {
       /* Start next packet */
-      if (stream->buffers == NULL)
+      if (stream->buffers_head == stream->buffers->len)
         return FALSE;
-      stream->cur_buffer = (PsMuxStreamBuffer *) (stream->buffers->data);
+      stream->cur_buffer = (PsMuxStreamBuffer *)
+          g_ptr_array_index (stream->buffers, stream->buffers_head);
       stream->cur_buffer_consumed = 0;
     }
 
@@ -383,14 +409,13 @@ psmux_stream_find_pts_dts_within (PsMuxStream * stream, guint bound,
    * 2. If the bound is too small to include even one buffer, output the pts/dts
    * of that buffer.
    */
-  GList *cur;
+  guint i;
 
   *pts = -1;
   *dts = -1;
 
-  for (cur = g_list_first (stream->buffers); cur != NULL;
-      cur = g_list_next (cur)) {
-    PsMuxStreamBuffer *curbuf = cur->data;
+  for (i = stream->buffers_head; i < stream->buffers->len; i++) {
+    PsMuxStreamBuffer *curbuf = g_ptr_array_index (stream->buffers, i);
 
     /* FIXME: This isn't quite correct - if the 'bound' is within this
      * buffer, we don't know if the timestamp is before or after the split
@@ -494,7 +519,13 @@ psmux_stream_add_data (PsMuxStream * stream, GstBuffer * buffer,
 
   g_return_if_fail (stream != NULL);
 
-  packet = g_slice_new (PsMuxStreamBuffer);
+  /* usually one buffer is consumed for every one that is added */
+  if (stream->spare_buffer) {
+    packet = stream->spare_buffer;
+    stream->spare_buffer = NULL;
+  } else {
+    packet = g_slice_new (PsMuxStreamBuffer);
+  }
   packet->buf = buffer;
 
   if (!gst_buffer_map (packet->buf, &packet->map, GST_MAP_READ)) {
@@ -512,8 +543,7 @@ psmux_stream_add_data (PsMuxStream * stream, GstBuffer * buffer,
     stream->last_pts = pts;
 
   stream->bytes_avail += packet->map.size;
-  /* FIXME: perhaps use GstQueueArray instead? */
-  stream->buffers = g_list_append (stream->buffers, packet);
+  g_ptr_array_add (stream->buffers, packet);
 
 }
 
@@ -102,13 +102,17 @@ struct PsMuxStream{
   guint8 stream_id;
   guint8 stream_id_ext; /* extended stream id (13818-1 Amdt 2) */
 
-  /* List of data buffers available for writing out */
-  GList *buffers;
+  /* Data buffers available for writing out, starting at buffers_head.
+   * The array is reused instead of allocating a list node per buffer */
+  GPtrArray *buffers;
+  guint buffers_head;
   guint32 bytes_avail;
 
   /* Current data buffer being consumed */
   PsMuxStreamBuffer *cur_buffer;
   guint32 cur_buffer_consumed;
+  /* Consumed data buffer kept for the next one added */
+  PsMuxStreamBuffer *spare_buffer;
 
   /* PES payload */
   guint16 cur_pes_payload_size;
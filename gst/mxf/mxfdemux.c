@@ -71,6 +71,9 @@ GST_STATIC_PAD_TEMPLATE ("track_%u",
 GST_DEBUG_CATEGORY_STATIC (mxfdemux_debug);
 #define GST_CAT_DEFAULT mxfdemux_debug
 
+/* How often to look for new partitions in a file that is being written */
+#define GROWING_FILE_UPDATE_INTERVAL (G_USEC_PER_SEC)
+
 static GstFlowReturn
 gst_mxf_demux_pull_klv_packet (GstMXFDemux * demux, guint64 offset, MXFUL * key,
     GstBuffer ** outbuf, guint * read);
@@ -79,6 +82,7 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
     const MXFUL * key, GstBuffer * buffer, guint64 offset);
 
 static void collect_index_table_segments (GstMXFDemux * demux);
+static void gst_mxf_demux_update_growing_file (GstMXFDemux * demux);
 
 GType gst_mxf_demux_pad_get_type (void);
 G_DEFINE_TYPE (GstMXFDemuxPad, gst_mxf_demux_pad, GST_TYPE_PAD);
@@ -115,7 +119,8 @@ enum
   PROP_0,
   PROP_PACKAGE,
   PROP_MAX_DRIFT,
-  PROP_STRUCTURE
+  PROP_STRUCTURE,
+  PROP_LAZY_DESCRIPTIVE_METADATA
 };
 
 static gboolean gst_mxf_demux_sink_event (GstPad * pad, GstObject * parent,
@@ -152,6 +157,159 @@ gst_mxf_demux_partition_free (GstMXFDemuxPartition * partition)
   g_free (partition);
 }
 
+/* A descriptive metadata set that was not parsed yet */
+typedef struct
+{
+  guint8 scheme;
+  guint32 type;
+  MXFPrimerPack *primer;
+  guint64 offset;
+  GstBuffer *buffer;
+} GstMXFDemuxPendingMetadata;
+
+static void
+gst_mxf_demux_pending_metadata_free (GstMXFDemuxPendingMetadata * pending)
+{
+  gst_buffer_unref (pending->buffer);
+  g_slice_free (GstMXFDemuxPendingMetadata, pending);
+}
+
+static void
+gst_mxf_demux_offsets_clear (GstMXFDemuxOffsets * offsets)
+{
+  if (offsets->entries)
+    g_array_free (offsets->entries, TRUE);
+  offsets->entries = NULL;
+  if (offsets->keyframes)
+    g_array_free (offsets->keyframes, TRUE);
+  offsets->keyframes = NULL;
+}
+
+static guint
+gst_mxf_demux_offsets_get_length (const GstMXFDemuxOffsets * offsets)
+{
+  return offsets->entries ? offsets->entries->len : 0;
+}
+
+/* Returns the entry for @position if its offset is known */
+static GstMXFDemuxIndex *
+gst_mxf_demux_offsets_get (const GstMXFDemuxOffsets * offsets,
+    gint64 position)
+{
+  GstMXFDemuxIndex *index;
+
+  if (position < 0 || position >= gst_mxf_demux_offsets_get_length (offsets))
+    return NULL;
+
+  index = &g_array_index (offsets->entries, GstMXFDemuxIndex, position);
+  if (index->offset == 0)
+    return NULL;
+
+  return index;
+}
+
+static void
+gst_mxf_demux_offsets_set_length (GstMXFDemuxOffsets * offsets, guint length)
+{
+  if (!offsets->entries) {
+    offsets->entries = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
+    offsets->keyframes = g_array_new (FALSE, FALSE, sizeof (gint64));
+  }
+
+  if (offsets->entries->len < length)
+    g_array_set_size (offsets->entries, length);
+}
+
+/* Index in the keyframe list of the first keyframe after @position */
+static guint
+gst_mxf_demux_offsets_upper_keyframe (const GstMXFDemuxOffsets * offsets,
+    gint64 position)
+{
+  guint lo = 0, hi = offsets->keyframes ? offsets->keyframes->len : 0;
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+
+    if (g_array_index (offsets->keyframes, gint64, mid) <= position)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
+}
+
+static void
+gst_mxf_demux_offsets_set (GstMXFDemuxOffsets * offsets, gint64 position,
+    guint64 offset, gboolean keyframe)
+{
+  GstMXFDemuxIndex *index;
+  gboolean was_keyframe;
+  guint k;
+
+  gst_mxf_demux_offsets_set_length (offsets, position + 1);
+
+  index = &g_array_index (offsets->entries, GstMXFDemuxIndex, position);
+  index->offset = offset;
+  index->keyframe = keyframe && offset != 0;
+
+  k = gst_mxf_demux_offsets_upper_keyframe (offsets, position);
+  was_keyframe = k > 0
+      && g_array_index (offsets->keyframes, gint64, k - 1) == position;
+
+  if (index->keyframe && !was_keyframe)
+    g_array_insert_val (offsets->keyframes, k, position);
+  else if (!index->keyframe && was_keyframe)
+    g_array_remove_index (offsets->keyframes, k - 1);
+}
+
+/* Edit units are stored in the file in order, so the known offsets are
+ * increasing with the edit unit */
+static gint64
+gst_mxf_demux_offsets_find_position (const GstMXFDemuxOffsets * offsets,
+    guint64 offset)
+{
+  guint lo = 0, hi = gst_mxf_demux_offsets_get_length (offsets);
+
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    guint probe = mid;
+    GstMXFDemuxIndex *index;
+
+    /* skip back over edit units with unknown offset */
+    while (probe > lo
+        && g_array_index (offsets->entries, GstMXFDemuxIndex,
+            probe).offset == 0)
+      probe--;
+
+    index = &g_array_index (offsets->entries, GstMXFDemuxIndex, probe);
+    if (index->offset == 0 || index->offset < offset)
+      lo = mid + 1;
+    else if (index->offset > offset)
+      hi = probe;
+    else
+      return probe;
+  }
+
+  return -1;
+}
+
+static GstMXFDemuxIndexTable *
+gst_mxf_demux_find_index_table (GstMXFDemux * demux, guint32 body_sid,
+    guint32 index_sid)
+{
+  GList *l;
+
+  for (l = demux->index_tables; l; l = l->next) {
+    GstMXFDemuxIndexTable *t = l->data;
+
+    if (t->body_sid == body_sid && t->index_sid == index_sid)
+      return t;
+  }
+
+  return NULL;
+}
+
 static void
 gst_mxf_demux_reset_mxf_state (GstMXFDemux * demux)
 {
@@ -159,6 +317,13 @@ gst_mxf_demux_reset_mxf_state (GstMXFDemux * demux)
 
   GST_DEBUG_OBJECT (demux, "Resetting MXF state");
 
+  /* pending metadata refers to the primer packs of the partitions */
+  g_rw_lock_writer_lock (&demux->metadata_lock);
+  g_list_free_full (demux->pending_descriptive_metadata,
+      (GDestroyNotify) gst_mxf_demux_pending_metadata_free);
+  demux->pending_descriptive_metadata = NULL;
+  g_rw_lock_writer_unlock (&demux->metadata_lock);
+
   g_list_foreach (demux->partitions, (GFunc) gst_mxf_demux_partition_free,
       NULL);
   g_list_free (demux->partitions);
@@ -170,8 +335,7 @@ gst_mxf_demux_reset_mxf_state (GstMXFDemux * demux)
     GstMXFDemuxEssenceTrack *t =
         &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack, i);
 
-    if (t->offsets)
-      g_array_free (t->offsets, TRUE);
+    gst_mxf_demux_offsets_clear (&t->offsets);
 
     g_free (t->mapping_data);
 
@@ -227,6 +391,10 @@ gst_mxf_demux_reset_metadata (GstMXFDemux * demux)
   }
   demux->metadata = mxf_metadata_hash_table_new ();
 
+  g_list_free_full (demux->pending_descriptive_metadata,
+      (GDestroyNotify) gst_mxf_demux_pending_metadata_free);
+  demux->pending_descriptive_metadata = NULL;
+
   if (demux->tags) {
     gst_tag_list_unref (demux->tags);
     demux->tags = NULL;
@@ -284,7 +452,7 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
     for (l = demux->index_tables; l; l = l->next) {
       GstMXFDemuxIndexTable *t = l->data;
-      g_array_free (t->offsets, TRUE);
+      gst_mxf_demux_offsets_clear (&t->offsets);
       g_free (t);
     }
     g_list_free (demux->index_tables);
@@ -293,6 +461,10 @@ gst_mxf_demux_reset (GstMXFDemux * demux)
 
   demux->index_table_segments_collected = FALSE;
 
+  demux->growing = FALSE;
+  demux->growing_scan_offset = 0;
+  demux->growing_last_update = 0;
+
   gst_mxf_demux_reset_mxf_state (demux);
   gst_mxf_demux_reset_metadata (demux);
 
@@ -492,24 +664,12 @@ gst_mxf_demux_handle_primer_pack (GstMXFDemux * demux, const MXFUL * key,
   return GST_FLOW_OK;
 }
 
-static GstFlowReturn
-gst_mxf_demux_resolve_references (GstMXFDemux * demux)
+/* Must be called with the metadata lock */
+static gboolean
+gst_mxf_demux_resolve_metadata (GstMXFDemux * demux)
 {
-  GstFlowReturn ret = GST_FLOW_OK;
   GHashTableIter iter;
   MXFMetadataBase *m = NULL;
-  GstStructure *structure;
-
-  g_rw_lock_writer_lock (&demux->metadata_lock);
-
-  GST_DEBUG_OBJECT (demux, "Resolve metadata references");
-  demux->update_metadata = FALSE;
-
-  if (!demux->metadata) {
-    GST_ERROR_OBJECT (demux, "No metadata yet");
-    g_rw_lock_writer_unlock (&demux->metadata_lock);
-    return GST_FLOW_ERROR;
-  }
 
   g_hash_table_iter_init (&iter, demux->metadata);
   while (g_hash_table_iter_next (&iter, NULL, (gpointer) & m)) {
@@ -524,10 +684,33 @@ gst_mxf_demux_resolve_references (GstMXFDemux * demux)
 
     /* Resolving can fail for anything but the preface, as the preface
      * will resolve everything required */
-    if (!resolved && MXF_IS_METADATA_PREFACE (m)) {
-      ret = GST_FLOW_ERROR;
-      goto error;
-    }
+    if (!resolved && MXF_IS_METADATA_PREFACE (m))
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+static GstFlowReturn
+gst_mxf_demux_resolve_references (GstMXFDemux * demux)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstStructure *structure;
+
+  g_rw_lock_writer_lock (&demux->metadata_lock);
+
+  GST_DEBUG_OBJECT (demux, "Resolve metadata references");
+  demux->update_metadata = FALSE;
+
+  if (!demux->metadata) {
+    GST_ERROR_OBJECT (demux, "No metadata yet");
+    g_rw_lock_writer_unlock (&demux->metadata_lock);
+    return GST_FLOW_ERROR;
+  }
+
+  if (!gst_mxf_demux_resolve_metadata (demux)) {
+    ret = GST_FLOW_ERROR;
+    goto error;
   }
 
   demux->metadata_resolved = TRUE;
@@ -1354,6 +1537,11 @@ gst_mxf_demux_handle_metadata (GstMXFDemux * demux, const MXFUL * key,
     demux->preface = MXF_METADATA_PREFACE (metadata);
   }
 
+  /* its framework is only parsed with the other descriptive metadata */
+  if (demux->lazy_descriptive_metadata
+      && MXF_IS_METADATA_DM_SEGMENT (metadata))
+    MXF_METADATA_DM_SEGMENT (metadata)->dm_framework_deferred = TRUE;
+
   gst_mxf_demux_reset_linked_metadata (demux);
 
   g_hash_table_replace (demux->metadata,
@@ -1363,42 +1551,22 @@ gst_mxf_demux_handle_metadata (GstMXFDemux * demux, const MXFUL * key,
   return ret;
 }
 
+/* Parses a descriptive metadata set and adds it to the metadata unless a
+ * newer version of it is known already. Must be called with the metadata
+ * lock */
 static GstFlowReturn
-gst_mxf_demux_handle_descriptive_metadata (GstMXFDemux * demux,
-    const MXFUL * key, GstBuffer * buffer)
+gst_mxf_demux_add_descriptive_metadata (GstMXFDemux * demux, guint8 scheme,
+    guint32 type, MXFPrimerPack * primer, guint64 offset, GstBuffer * buffer,
+    gboolean * added)
 {
-  guint32 type;
-  guint8 scheme;
   GstMapInfo map;
-  GstFlowReturn ret = GST_FLOW_OK;
   MXFDescriptiveMetadata *m = NULL, *old = NULL;
 
-  scheme = GST_READ_UINT8 (key->u + 12);
-  type = GST_READ_UINT24_BE (key->u + 13);
-
-  GST_DEBUG_OBJECT (demux,
-      "Handling descriptive metadata of size %" G_GSIZE_FORMAT " at offset %"
-      G_GUINT64_FORMAT " with scheme 0x%02x and type 0x%06x",
-      gst_buffer_get_size (buffer), demux->offset, scheme, type);
-
-  if (G_UNLIKELY (!demux->current_partition)) {
-    GST_ERROR_OBJECT (demux, "Partition pack doesn't exist");
-    return GST_FLOW_ERROR;
-  }
-
-  if (G_UNLIKELY (!demux->current_partition->primer.mappings)) {
-    GST_ERROR_OBJECT (demux, "Primer pack doesn't exists");
-    return GST_FLOW_ERROR;
-  }
-
-  if (demux->current_partition->parsed_metadata) {
-    GST_DEBUG_OBJECT (demux, "Metadata of this partition was already parsed");
-    return GST_FLOW_OK;
-  }
+  *added = FALSE;
 
   gst_buffer_map (buffer, &map, GST_MAP_READ);
-  m = mxf_descriptive_metadata_new (scheme, type,
-      &demux->current_partition->primer, demux->offset, map.data, map.size);
+  m = mxf_descriptive_metadata_new (scheme, type, primer, offset, map.data,
+      map.size);
   gst_buffer_unmap (buffer, &map);
 
   if (!m) {
@@ -1438,13 +1606,115 @@ gst_mxf_demux_handle_descriptive_metadata (GstMXFDemux * demux,
     return GST_FLOW_OK;
   }
 
-  g_rw_lock_writer_lock (&demux->metadata_lock);
-
-  demux->update_metadata = TRUE;
-  gst_mxf_demux_reset_linked_metadata (demux);
-
   g_hash_table_replace (demux->metadata, &MXF_METADATA_BASE (m)->instance_uid,
       m);
+  *added = TRUE;
+
+  return GST_FLOW_OK;
+}
+
+/* Parses the descriptive metadata sets that were skipped so far and resolves
+ * the references to them. Must be called with the metadata lock */
+static void
+gst_mxf_demux_parse_pending_descriptive_metadata (GstMXFDemux * demux)
+{
+  GList *l;
+  gboolean added, any_added = FALSE;
+  GHashTableIter iter;
+  MXFMetadataBase *m;
+
+  if (!demux->pending_descriptive_metadata)
+    return;
+
+  GST_DEBUG_OBJECT (demux, "Parsing %u pending descriptive metadata sets",
+      g_list_length (demux->pending_descriptive_metadata));
+
+  for (l = demux->pending_descriptive_metadata; l; l = l->next) {
+    GstMXFDemuxPendingMetadata *pending = l->data;
+
+    gst_mxf_demux_add_descriptive_metadata (demux, pending->scheme,
+        pending->type, pending->primer, pending->offset, pending->buffer,
+        &added);
+    any_added |= added;
+  }
+
+  g_list_free_full (demux->pending_descriptive_metadata,
+      (GDestroyNotify) gst_mxf_demux_pending_metadata_free);
+  demux->pending_descriptive_metadata = NULL;
+
+  if (!any_added || !demux->metadata_resolved)
+    return;
+
+  /* Only link the new frameworks to the DM segments that were resolved
+   * without them. Resolving everything again would reset the packages and
+   * tracks the streaming thread is using */
+  g_hash_table_iter_init (&iter, demux->metadata);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer) & m)) {
+    if (!MXF_IS_METADATA_DM_SEGMENT (m)
+        || MXF_METADATA_DM_SEGMENT (m)->dm_framework)
+      continue;
+
+    m->resolved = MXF_METADATA_BASE_RESOLVE_STATE_NONE;
+    if (!mxf_metadata_base_resolve (m, demux->metadata))
+      GST_ERROR_OBJECT (demux, "Failed to resolve descriptive metadata");
+  }
+}
+
+static GstFlowReturn
+gst_mxf_demux_handle_descriptive_metadata (GstMXFDemux * demux,
+    const MXFUL * key, GstBuffer * buffer)
+{
+  guint32 type;
+  guint8 scheme;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gboolean added;
+
+  scheme = GST_READ_UINT8 (key->u + 12);
+  type = GST_READ_UINT24_BE (key->u + 13);
+
+  GST_DEBUG_OBJECT (demux,
+      "Handling descriptive metadata of size %" G_GSIZE_FORMAT " at offset %"
+      G_GUINT64_FORMAT " with scheme 0x%02x and type 0x%06x",
+      gst_buffer_get_size (buffer), demux->offset, scheme, type);
+
+  if (G_UNLIKELY (!demux->current_partition)) {
+    GST_ERROR_OBJECT (demux, "Partition pack doesn't exist");
+    return GST_FLOW_ERROR;
+  }
+
+  if (G_UNLIKELY (!demux->current_partition->primer.mappings)) {
+    GST_ERROR_OBJECT (demux, "Primer pack doesn't exists");
+    return GST_FLOW_ERROR;
+  }
+
+  if (demux->current_partition->parsed_metadata) {
+    GST_DEBUG_OBJECT (demux, "Metadata of this partition was already parsed");
+    return GST_FLOW_OK;
+  }
+
+  g_rw_lock_writer_lock (&demux->metadata_lock);
+
+  if (demux->lazy_descriptive_metadata) {
+    GstMXFDemuxPendingMetadata *pending =
+        g_slice_new (GstMXFDemuxPendingMetadata);
+
+    /* Nothing but the structure refers to descriptive metadata, so they are
+     * only parsed once it is requested */
+    pending->scheme = scheme;
+    pending->type = type;
+    pending->primer = &demux->current_partition->primer;
+    pending->offset = demux->offset;
+    pending->buffer = gst_buffer_ref (buffer);
+    demux->pending_descriptive_metadata =
+        g_list_prepend (demux->pending_descriptive_metadata, pending);
+  } else {
+    ret = gst_mxf_demux_add_descriptive_metadata (demux, scheme, type,
+        &demux->current_partition->primer, demux->offset, buffer, &added);
+    if (added) {
+      demux->update_metadata = TRUE;
+      gst_mxf_demux_reset_linked_metadata (demux);
+    }
+  }
 
   g_rw_lock_writer_unlock (&demux->metadata_lock);
 
@@ -1671,17 +1941,9 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
   if (etrack->position == -1) {
     GST_DEBUG_OBJECT (demux,
         "Unknown essence track position, looking into index");
-    if (etrack->offsets) {
-      for (i = 0; i < etrack->offsets->len; i++) {
-        GstMXFDemuxIndex *idx =
-            &g_array_index (etrack->offsets, GstMXFDemuxIndex, i);
-
-        if (idx->offset != 0 && idx->offset == demux->offset - demux->run_in) {
-          etrack->position = i;
-          break;
-        }
-      }
-    }
+    etrack->position =
+        gst_mxf_demux_offsets_find_position (&etrack->offsets,
+        demux->offset - demux->run_in);
 
     if (etrack->position == -1) {
       GST_WARNING_OBJECT (demux, "Essence track position not in index");
@@ -1689,10 +1951,10 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
     }
   }
 
-  if (etrack->offsets && etrack->offsets->len > etrack->position) {
+  {
     GstMXFDemuxIndex *index =
-        &g_array_index (etrack->offsets, GstMXFDemuxIndex, etrack->position);
-    if (index->offset != 0)
+        gst_mxf_demux_offsets_get (&etrack->offsets, etrack->position);
+    if (index)
       keyframe = index->keyframe;
   }
 
@@ -1730,24 +1992,14 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
 
   /* Prefer keyframe information from index tables over everything else */
   if (demux->index_tables && outbuf) {
-    GList *l;
-    GstMXFDemuxIndexTable *index_table = NULL;
+    GstMXFDemuxIndexTable *index_table =
+        gst_mxf_demux_find_index_table (demux, etrack->body_sid,
+        etrack->index_sid);
 
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *tmp = l->data;
-
-      if (tmp->body_sid == etrack->body_sid
-          && tmp->index_sid == etrack->index_sid) {
-        index_table = tmp;
-        break;
-      }
-    }
-
-    if (index_table && index_table->offsets->len > etrack->position) {
+    if (index_table) {
       GstMXFDemuxIndex *index =
-          &g_array_index (index_table->offsets, GstMXFDemuxIndex,
-          etrack->position);
-      if (index->offset != 0) {
+          gst_mxf_demux_offsets_get (&index_table->offsets, etrack->position);
+      if (index) {
         keyframe = index->keyframe;
 
         if (keyframe)
@@ -1758,26 +2010,8 @@ gst_mxf_demux_handle_generic_container_essence_element (GstMXFDemux * demux,
     }
   }
 
-  if (!etrack->offsets)
-    etrack->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
-
-  {
-    if (etrack->offsets->len > etrack->position) {
-      GstMXFDemuxIndex *index =
-          &g_array_index (etrack->offsets, GstMXFDemuxIndex, etrack->position);
-
-      index->offset = demux->offset - demux->run_in;
-      index->keyframe = keyframe;
-    } else {
-      GstMXFDemuxIndex index;
-
-      index.offset = demux->offset - demux->run_in;
-      index.keyframe = keyframe;
-      if (etrack->offsets->len < etrack->position)
-        g_array_set_size (etrack->offsets, etrack->position);
-      g_array_insert_val (etrack->offsets, etrack->position, index);
-    }
-  }
+  gst_mxf_demux_offsets_set (&etrack->offsets, etrack->position,
+      demux->offset - demux->run_in, keyframe);
 
   if (peek)
     goto out;
@@ -2118,14 +2352,14 @@ gst_mxf_demux_handle_index_table_segment (GstMXFDemux * demux,
   return GST_FLOW_OK;
 }
 
+/* Reads the key and length of the KLV packet at @offset without pulling its
+ * value. @data_offset is set to the size of key and length. */
 static GstFlowReturn
-gst_mxf_demux_pull_klv_packet (GstMXFDemux * demux, guint64 offset, MXFUL * key,
-    GstBuffer ** outbuf, guint * read)
+gst_mxf_demux_peek_klv_packet (GstMXFDemux * demux, guint64 offset,
+    MXFUL * key, guint * data_offset, guint64 * length)
 {
   GstBuffer *buffer = NULL;
   const guint8 *data;
-  guint64 data_offset = 0;
-  guint64 length;
   GstFlowReturn ret = GST_FLOW_OK;
   GstMapInfo map;
 #ifndef GST_DISABLE_GST_DEBUG
@@ -2148,12 +2382,12 @@ gst_mxf_demux_pull_klv_packet (GstMXFDemux * demux, guint64 offset, MXFUL * key,
 
   /* Decode BER encoded packet length */
   if ((map.data[16] & 0x80) == 0) {
-    length = map.data[16];
-    data_offset = 17;
+    *length = map.data[16];
+    *data_offset = 17;
   } else {
     guint slen = map.data[16] & 0x7f;
 
-    data_offset = 16 + 1 + slen;
+    *data_offset = 16 + 1 + slen;
 
     gst_buffer_unmap (buffer, &map);
     gst_buffer_unref (buffer);
@@ -2174,17 +2408,38 @@ gst_mxf_demux_pull_klv_packet (GstMXFDemux * demux, guint64 offset, MXFUL * key,
     gst_buffer_map (buffer, &map, GST_MAP_READ);
 
     data = map.data;
-    length = 0;
+    *length = 0;
     while (slen) {
-      length = (length << 8) | *data;
+      *length = (*length << 8) | *data;
       data++;
       slen--;
     }
   }
 
   gst_buffer_unmap (buffer, &map);
-  gst_buffer_unref (buffer);
-  buffer = NULL;
+
+beach:
+  if (buffer)
+    gst_buffer_unref (buffer);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_mxf_demux_pull_klv_packet (GstMXFDemux * demux, guint64 offset, MXFUL * key,
+    GstBuffer ** outbuf, guint * read)
+{
+  GstBuffer *buffer = NULL;
+  guint data_offset = 0;
+  guint64 length;
+  GstFlowReturn ret = GST_FLOW_OK;
+#ifndef GST_DISABLE_GST_DEBUG
+  gchar str[48];
+#endif
+
+  if ((ret = gst_mxf_demux_peek_klv_packet (demux, offset, key, &data_offset,
+              &length)) != GST_FLOW_OK)
+    goto beach;
 
   /* GStreamer's buffer sizes are stored in a guint so we
    * limit ourself to G_MAXUINT large buffers */
@@ -2289,6 +2544,62 @@ gst_mxf_demux_pull_random_index_pack (GstMXFDemux * demux)
   }
 }
 
+/* Checks if the header metadata of the current partition, starting with the
+ * primer pack, is byte for byte the same as the one of the header partition
+ * with its partition pack at @header_offset */
+static gboolean
+gst_mxf_demux_is_header_metadata (GstMXFDemux * demux,
+    GstMXFDemuxPartition * header, guint64 header_offset)
+{
+  guint64 size = demux->current_partition->partition.header_byte_count;
+  guint64 offset = header_offset;
+  GstBuffer *header_buffer = NULL, *buffer = NULL;
+  GstMapInfo map;
+  MXFUL key;
+  guint data_offset;
+  guint64 length;
+  gboolean ret = FALSE;
+
+  if (!header || header == demux->current_partition
+      || header->partition.type != MXF_PARTITION_PACK_HEADER
+      || header->partition.header_byte_count != size || size > G_MAXUINT)
+    return FALSE;
+
+  /* skip the partition pack and fill to get to the primer pack */
+  if (gst_mxf_demux_peek_klv_packet (demux, offset, &key, &data_offset,
+          &length) != GST_FLOW_OK || !mxf_is_partition_pack (&key))
+    return FALSE;
+
+  do {
+    offset += data_offset + length;
+    if (gst_mxf_demux_peek_klv_packet (demux, offset, &key, &data_offset,
+            &length) != GST_FLOW_OK)
+      return FALSE;
+  } while (mxf_is_fill (&key));
+
+  if (!mxf_is_primer_pack (&key))
+    return FALSE;
+
+  if (gst_mxf_demux_pull_range (demux, offset, size,
+          &header_buffer) != GST_FLOW_OK)
+    goto out;
+  if (gst_mxf_demux_pull_range (demux, demux->current_partition->primer.offset,
+          size, &buffer) != GST_FLOW_OK)
+    goto out;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  ret = gst_buffer_memcmp (header_buffer, 0, map.data, map.size) == 0;
+  gst_buffer_unmap (buffer, &map);
+
+out:
+  if (header_buffer)
+    gst_buffer_unref (header_buffer);
+  if (buffer)
+    gst_buffer_unref (buffer);
+
+  return ret;
+}
+
 static void
 gst_mxf_demux_parse_footer_metadata (GstMXFDemux * demux)
 {
@@ -2385,6 +2696,13 @@ next_try:
     }
   }
 
+  /* The header partition is parsed next anyway, no need to parse the same
+   * metadata twice */
+  if (gst_mxf_demux_is_header_metadata (demux, old_partition, old_offset)) {
+    GST_DEBUG_OBJECT (demux, "Metadata is the same as in the header partition");
+    goto out;
+  }
+
   /* parse metadata */
   while (demux->offset <
       demux->run_in + demux->current_partition->primer.offset +
@@ -2573,6 +2891,22 @@ gst_mxf_demux_handle_klv_packet (GstMXFDemux * demux, const MXFUL * key,
         etrack->position = 0;
       }
     }
+  } else if (mxf_is_partition_pack (key) && ret == GST_FLOW_OK
+      && !demux->growing && demux->growing_scan_offset == 0
+      && demux->random_access && demux->current_partition
+      && demux->current_partition->partition.type == MXF_PARTITION_PACK_HEADER
+      && (!demux->current_partition->partition.closed
+          || !demux->current_partition->partition.complete)
+      && demux->footer_partition_pack_offset == 0
+      && !demux->random_index_pack) {
+    /* Without footer nor random index pack the file is most likely still
+     * being written, so keep an eye on the partitions and index table
+     * segments that are appended to it */
+    GST_DEBUG_OBJECT (demux, "Open header partition without footer, "
+        "handling as growing file");
+    demux->growing = TRUE;
+    demux->growing_scan_offset = demux->offset;
+    gst_mxf_demux_update_growing_file (demux);
   }
 
 beach:
@@ -2595,61 +2929,71 @@ gst_mxf_demux_set_partition_for_offset (GstMXFDemux * demux, guint64 offset)
 }
 
 static guint64
-find_offset (GArray * offsets, gint64 * position, gboolean keyframe)
+find_offset (const GstMXFDemuxOffsets * offsets, gint64 * position,
+    gboolean keyframe)
 {
   GstMXFDemuxIndex *idx;
-  guint64 current_offset = -1;
-  gint64 current_position = *position;
+  gint64 current_position;
+  guint k;
 
-  if (!offsets || offsets->len <= *position)
+  idx = gst_mxf_demux_offsets_get (offsets, *position);
+  if (!idx)
     return -1;
 
-  idx = &g_array_index (offsets, GstMXFDemuxIndex, *position);
-  if (idx->offset != 0 && (!keyframe || idx->keyframe)) {
-    current_offset = idx->offset;
-  } else if (idx->offset != 0) {
-    current_position--;
-    while (current_position >= 0) {
-      idx = &g_array_index (offsets, GstMXFDemuxIndex, current_position);
-      if (idx->offset == 0) {
-        break;
-      } else if (!idx->keyframe) {
-        current_position--;
-        continue;
-      } else {
-        current_offset = idx->offset;
-        break;
-      }
-    }
-  }
+  if (!keyframe || idx->keyframe)
+    return idx->offset;
 
-  if (current_offset == -1)
+  /* The previous keyframe is only usable if the offsets of all edit units
+   * up to the requested one are known */
+  k = gst_mxf_demux_offsets_upper_keyframe (offsets, *position);
+  if (k == 0)
     return -1;
 
+  current_position = g_array_index (offsets->keyframes, gint64, k - 1);
+  for (k = current_position + 1; k < *position; k++) {
+    if (g_array_index (offsets->entries, GstMXFDemuxIndex, k).offset == 0)
+      return -1;
+  }
+
   *position = current_position;
-  return current_offset;
+  return g_array_index (offsets->entries, GstMXFDemuxIndex,
+      current_position).offset;
 }
 
 static guint64
-find_closest_offset (GArray * offsets, gint64 * position, gboolean keyframe)
+find_closest_offset (const GstMXFDemuxOffsets * offsets, gint64 * position,
+    gboolean keyframe)
 {
   GstMXFDemuxIndex *idx;
   gint64 current_position = *position;
+  guint len = gst_mxf_demux_offsets_get_length (offsets);
 
-  if (!offsets || offsets->len == 0)
+  if (len == 0)
     return -1;
 
-  current_position = MIN (current_position, offsets->len - 1);
+  current_position = MIN (current_position, len - 1);
+
+  if (keyframe) {
+    guint k = gst_mxf_demux_offsets_upper_keyframe (offsets, current_position);
 
-  idx = &g_array_index (offsets, GstMXFDemuxIndex, current_position);
-  while (idx->offset == 0 || (keyframe && !idx->keyframe)) {
+    if (k == 0)
+      return -1;
+
+    *position = g_array_index (offsets->keyframes, gint64, k - 1);
+    return g_array_index (offsets->entries, GstMXFDemuxIndex,
+        *position).offset;
+  }
+
+  idx = &g_array_index (offsets->entries, GstMXFDemuxIndex, current_position);
+  while (idx->offset == 0) {
     current_position--;
     if (current_position < 0)
       break;
-    idx = &g_array_index (offsets, GstMXFDemuxIndex, current_position);
+    idx = &g_array_index (offsets->entries, GstMXFDemuxIndex,
+        current_position);
   }
 
-  if (idx->offset != 0 && (!keyframe || idx->keyframe)) {
+  if (idx->offset != 0) {
     *position = current_position;
     return idx->offset;
   }
@@ -2673,19 +3017,9 @@ gst_mxf_demux_find_essence_element (GstMXFDemux * demux,
       " of track %u with body_sid %u (keyframe %d)", *position,
       etrack->track_number, etrack->body_sid, keyframe);
 
-  if (demux->index_tables) {
-    GList *l;
-
-    for (l = demux->index_tables; l; l = l->next) {
-      GstMXFDemuxIndexTable *tmp = l->data;
-
-      if (tmp->body_sid == etrack->body_sid
-          && tmp->index_sid == etrack->index_sid) {
-        index_table = tmp;
-        break;
-      }
-    }
-  }
+  index_table =
+      gst_mxf_demux_find_index_table (demux, etrack->body_sid,
+      etrack->index_sid);
 
 from_index:
 
@@ -2695,7 +3029,7 @@ from_index:
   }
 
   /* First try to find an offset in our index */
-  offset = find_offset (etrack->offsets, position, keyframe);
+  offset = find_offset (&etrack->offsets, position, keyframe);
   if (offset != -1) {
     GST_DEBUG_OBJECT (demux,
         "Found edit unit %" G_GINT64_FORMAT " for %" G_GINT64_FORMAT
@@ -2706,7 +3040,7 @@ from_index:
 
   GST_DEBUG_OBJECT (demux, "Not found in index");
   if (!demux->random_access) {
-    offset = find_closest_offset (etrack->offsets, position, keyframe);
+    offset = find_closest_offset (&etrack->offsets, position, keyframe);
     if (offset != -1) {
       GST_DEBUG_OBJECT (demux,
           "Starting with edit unit %" G_GINT64_FORMAT " for %" G_GINT64_FORMAT
@@ -2716,7 +3050,7 @@ from_index:
     }
 
     if (index_table) {
-      offset = find_closest_offset (index_table->offsets, position, keyframe);
+      offset = find_closest_offset (&index_table->offsets, position, keyframe);
       if (offset != -1) {
         GST_DEBUG_OBJECT (demux,
             "Starting with edit unit %" G_GINT64_FORMAT " for %" G_GINT64_FORMAT
@@ -2731,7 +3065,7 @@ from_index:
     demux->offset = demux->run_in;
 
     offset =
-        find_closest_offset (etrack->offsets, &index_start_position, FALSE);
+        find_closest_offset (&etrack->offsets, &index_start_position, FALSE);
     if (offset != -1) {
       demux->offset = offset + demux->run_in;
       GST_DEBUG_OBJECT (demux,
@@ -2745,7 +3079,7 @@ from_index:
     if (index_table) {
       gint64 tmp_position = *position;
 
-      offset = find_closest_offset (index_table->offsets, &tmp_position, TRUE);
+      offset = find_closest_offset (&index_table->offsets, &tmp_position, TRUE);
       if (offset != -1 && tmp_position > index_start_position) {
         demux->offset = offset + demux->run_in;
         index_start_position = tmp_position;
@@ -2820,9 +3154,7 @@ from_index:
       /* If we found the position read it from the index again */
       if (((ret == GST_FLOW_OK && etrack->position == *position + 2) ||
               (ret == GST_FLOW_EOS && etrack->position == *position + 1))
-          && etrack->offsets && etrack->offsets->len > *position
-          && g_array_index (etrack->offsets, GstMXFDemuxIndex,
-              *position).offset != 0) {
+          && gst_mxf_demux_offsets_get (&etrack->offsets, *position)) {
         GST_DEBUG_OBJECT (demux, "Found at offset %" G_GUINT64_FORMAT,
             demux->offset);
         demux->offset = old_offset;
@@ -2860,6 +3192,14 @@ gst_mxf_demux_pull_and_handle_klv_packet (GstMXFDemux * demux)
       gst_mxf_demux_pull_klv_packet (demux, demux->offset, &key, &buffer,
       &read);
 
+  if (ret == GST_FLOW_EOS && demux->growing) {
+    /* More might have been written since the last update */
+    gst_mxf_demux_update_growing_file (demux);
+    ret =
+        gst_mxf_demux_pull_klv_packet (demux, demux->offset, &key, &buffer,
+        &read);
+  }
+
   if (ret == GST_FLOW_EOS && demux->src->len > 0) {
     guint i;
     GstMXFDemuxPad *p = NULL;
@@ -3024,6 +3364,10 @@ gst_mxf_demux_loop (GstPad * pad)
     gst_mxf_demux_pull_random_index_pack (demux);
   }
 
+  if (demux->growing && g_get_monotonic_time () - demux->growing_last_update >=
+      GROWING_FILE_UPDATE_INTERVAL)
+    gst_mxf_demux_update_growing_file (demux);
+
   /* Now actually do something */
   flow = gst_mxf_demux_pull_and_handle_klv_packet (demux);
 
@@ -3503,87 +3847,84 @@ no_new_offset:
   }
 }
 
-static void
-collect_index_table_segments (GstMXFDemux * demux)
+/* Partition of @body_partitions that contains @body_offset. Partitions of
+ * one BodySID are sorted by their body offsets as well. */
+static GList *
+find_body_partition (GPtrArray * body_partitions, guint64 body_offset)
 {
-  GList *l;
-  guint i;
-  guint64 old_offset = demux->offset;
-  GstMXFDemuxPartition *old_partition = demux->current_partition;
+  guint lo = 0, hi = body_partitions->len;
 
-  if (!demux->random_index_pack)
-    return;
+  while (lo < hi) {
+    guint mid = lo + (hi - lo) / 2;
+    GList *link = g_ptr_array_index (body_partitions, mid);
+    GstMXFDemuxPartition *partition = link->data;
 
-  for (i = 0; i < demux->random_index_pack->len; i++) {
-    MXFRandomIndexPackEntry *e =
-        &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
-
-    if (e->offset < demux->run_in) {
-      GST_ERROR_OBJECT (demux, "Invalid random index pack entry");
-      return;
-    }
-
-    demux->offset = e->offset;
-    read_partition_header (demux);
+    if (partition->partition.body_offset <= body_offset)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
 
-  demux->offset = old_offset;
-  demux->current_partition = old_partition;
+  return lo > 0 ? g_ptr_array_index (body_partitions, lo - 1) : NULL;
+}
+
+/* Adds the pending index table segments to the index tables, mapping their
+ * stream offsets to file offsets with the partitions known so far */
+static void
+gst_mxf_demux_merge_index_table_segments (GstMXFDemux * demux)
+{
+  GList *l;
+  guint i;
+  GPtrArray *body_partitions = g_ptr_array_new ();
+  guint32 body_sid = 0;
 
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *segment = l->data;
-    GstMXFDemuxIndexTable *t = NULL;
-    GList *k;
+    GstMXFDemuxIndexTable *t;
     guint64 start, end;
 
-    for (k = demux->index_tables; k; k = k->next) {
-      GstMXFDemuxIndexTable *tmp = k->data;
-
-      if (tmp->body_sid == segment->body_sid
-          && tmp->index_sid == segment->index_sid) {
-        t = tmp;
-        break;
-      }
-    }
-
+    t = gst_mxf_demux_find_index_table (demux, segment->body_sid,
+        segment->index_sid);
     if (!t) {
       t = g_new0 (GstMXFDemuxIndexTable, 1);
       t->body_sid = segment->body_sid;
       t->index_sid = segment->index_sid;
-      t->offsets = g_array_new (FALSE, TRUE, sizeof (GstMXFDemuxIndex));
       demux->index_tables = g_list_prepend (demux->index_tables, t);
     }
 
+    /* the links of the partitions containing this body, to map stream
+     * offsets without walking all partitions for every entry */
+    if (body_partitions->len == 0 || body_sid != t->body_sid) {
+      GList *m;
+
+      g_ptr_array_set_size (body_partitions, 0);
+      body_sid = t->body_sid;
+      for (m = demux->partitions; m; m = m->next) {
+        GstMXFDemuxPartition *partition = m->data;
+
+        if (partition->partition.body_sid == body_sid)
+          g_ptr_array_add (body_partitions, m);
+      }
+    }
+
     start = segment->index_start_position;
     end = start + segment->index_duration;
 
-    if (t->offsets->len < end)
-      g_array_set_size (t->offsets, end);
+    gst_mxf_demux_offsets_set_length (&t->offsets, end);
 
     for (i = 0; i < segment->n_index_entries; i++) {
-      GstMXFDemuxIndex *index =
-          &g_array_index (t->offsets, GstMXFDemuxIndex, start + i);
       guint64 offset = segment->index_entries[i].stream_offset;
-      GList *m;
-      GstMXFDemuxPartition *offset_partition = NULL, *next_partition = NULL;
-
-      for (m = demux->partitions; m; m = m->next) {
-        GstMXFDemuxPartition *partition = m->data;
-
-        if (!next_partition && offset_partition)
-          next_partition = partition;
+      GList *link;
+      GstMXFDemuxPartition *offset_partition, *next_partition;
 
-        if (partition->partition.body_sid != t->body_sid)
-          continue;
-        if (partition->partition.body_offset > offset)
-          break;
+      link = find_body_partition (body_partitions, offset);
+      if (!link)
+        continue;
 
-        offset_partition = partition;
-        next_partition = NULL;
-      }
+      offset_partition = link->data;
+      next_partition = link->next ? link->next->data : NULL;
 
-      if (offset_partition && offset >= offset_partition->partition.body_offset
-          && (offset - offset_partition->partition.body_offset)) {
+      if (offset - offset_partition->partition.body_offset) {
         offset =
             offset_partition->partition.this_partition +
             offset_partition->essence_container_offset + (offset -
@@ -3594,14 +3935,16 @@ collect_index_table_segments (GstMXFDemux * demux)
           GST_ERROR_OBJECT (demux,
               "Invalid index table segment going into next unrelated partition");
         } else {
-          index->offset = offset;
-          index->keyframe = ! !(segment->index_entries[i].flags & 0x80)
-              || (segment->index_entries[i].key_frame_offset == 0);
+          gst_mxf_demux_offsets_set (&t->offsets, start + i, offset,
+              ! !(segment->index_entries[i].flags & 0x80)
+              || (segment->index_entries[i].key_frame_offset == 0));
         }
       }
     }
   }
 
+  g_ptr_array_free (body_partitions, TRUE);
+
   for (l = demux->pending_index_table_segments; l; l = l->next) {
     MXFIndexTableSegment *s = l->data;
     mxf_index_table_segment_reset (s);
@@ -3609,6 +3952,163 @@ collect_index_table_segments (GstMXFDemux * demux)
   }
   g_list_free (demux->pending_index_table_segments);
   demux->pending_index_table_segments = NULL;
+
+  /* Files that are still being written don't have the final duration in
+   * their metadata, the index tells how much of it is there already */
+  g_rw_lock_writer_lock (&demux->metadata_lock);
+  for (i = 0; i < demux->essence_tracks->len; i++) {
+    GstMXFDemuxEssenceTrack *etrack =
+        &g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack, i);
+    GstMXFDemuxIndexTable *t =
+        gst_mxf_demux_find_index_table (demux, etrack->body_sid,
+        etrack->index_sid);
+
+    if (t)
+      etrack->indexed_duration = MAX (etrack->indexed_duration,
+          gst_mxf_demux_offsets_get_length (&t->offsets));
+  }
+  g_rw_lock_writer_unlock (&demux->metadata_lock);
+}
+
+static void
+collect_index_table_segments (GstMXFDemux * demux)
+{
+  guint i;
+  guint64 old_offset = demux->offset;
+  GstMXFDemuxPartition *old_partition = demux->current_partition;
+
+  if (!demux->random_index_pack)
+    return;
+
+  for (i = 0; i < demux->random_index_pack->len; i++) {
+    MXFRandomIndexPackEntry *e =
+        &g_array_index (demux->random_index_pack, MXFRandomIndexPackEntry, i);
+
+    if (e->offset < demux->run_in) {
+      GST_ERROR_OBJECT (demux, "Invalid random index pack entry");
+      return;
+    }
+
+    demux->offset = e->offset;
+    read_partition_header (demux);
+  }
+
+  demux->offset = old_offset;
+  demux->current_partition = old_partition;
+
+  gst_mxf_demux_merge_index_table_segments (demux);
+}
+
+/* Picks up the partitions and index table segments that were added to a file
+ * that is still being written since the last call. Only the keys and lengths
+ * of the new KLV packets are read, apart from partition headers and index
+ * table segments. */
+static void
+gst_mxf_demux_update_growing_file (GstMXFDemux * demux)
+{
+  guint64 old_offset = demux->offset;
+  GstMXFDemuxPartition *old_partition = demux->current_partition;
+  guint64 offset = demux->growing_scan_offset;
+  gint64 filesize = -1;
+  gint64 *old_durations;
+  gboolean duration_changed = FALSE;
+  guint i;
+
+  demux->growing_last_update = g_get_monotonic_time ();
+
+  if (gst_pad_peer_query_duration (demux->sinkpad, GST_FORMAT_BYTES,
+          &filesize) && filesize != -1 && offset >= filesize) {
+    GST_LOG_OBJECT (demux, "File did not grow");
+    return;
+  }
+
+  GST_DEBUG_OBJECT (demux, "Scanning growing file from offset %"
+      G_GUINT64_FORMAT " to %" G_GINT64_FORMAT, offset, filesize);
+
+  gst_mxf_demux_set_partition_for_offset (demux, offset);
+
+  while (demux->growing) {
+    MXFUL key;
+    guint data_offset;
+    guint64 length;
+
+    if (gst_mxf_demux_peek_klv_packet (demux, offset, &key, &data_offset,
+            &length) != GST_FLOW_OK)
+      break;
+
+    /* the last packet might not be completely written yet */
+    if (filesize != -1 && offset + data_offset + length > filesize)
+      break;
+
+    if (mxf_is_partition_pack (&key)) {
+      demux->offset = offset;
+      read_partition_header (demux);
+
+      if (demux->current_partition &&
+          demux->current_partition->partition.type ==
+          MXF_PARTITION_PACK_FOOTER) {
+        GST_DEBUG_OBJECT (demux, "Found footer partition, file is complete");
+        demux->footer_partition_pack_offset =
+            demux->current_partition->partition.this_partition;
+        demux->growing = FALSE;
+      }
+
+      /* continue after the index table segments, or retry from where
+       * reading the partition header stopped */
+      if (demux->offset > offset) {
+        offset = demux->offset;
+        continue;
+      }
+    } else if (mxf_is_index_table_segment (&key)) {
+      GstBuffer *buffer = NULL;
+
+      if (gst_mxf_demux_pull_klv_packet (demux, offset, &key, &buffer,
+              NULL) != GST_FLOW_OK)
+        break;
+      gst_mxf_demux_handle_index_table_segment (demux, &key, buffer, offset);
+      gst_buffer_unref (buffer);
+    } else if ((mxf_is_generic_container_system_item (&key) ||
+            mxf_is_generic_container_essence_element (&key) ||
+            mxf_is_avid_essence_container_essence_element (&key))
+        && demux->current_partition
+        && demux->current_partition->essence_container_offset == 0) {
+      demux->current_partition->essence_container_offset =
+          offset - demux->current_partition->partition.this_partition -
+          demux->run_in;
+    } else if (mxf_is_random_index_pack (&key)) {
+      demux->growing = FALSE;
+    }
+
+    offset += data_offset + length;
+  }
+
+  demux->growing_scan_offset = offset;
+  demux->offset = old_offset;
+  demux->current_partition = old_partition;
+
+  old_durations = g_newa (gint64, demux->essence_tracks->len);
+  for (i = 0; i < demux->essence_tracks->len; i++)
+    old_durations[i] = g_array_index (demux->essence_tracks,
+        GstMXFDemuxEssenceTrack, i).indexed_duration;
+
+  gst_mxf_demux_merge_index_table_segments (demux);
+
+  for (i = 0; i < demux->essence_tracks->len; i++) {
+    if (g_array_index (demux->essence_tracks, GstMXFDemuxEssenceTrack,
+            i).indexed_duration != old_durations[i])
+      duration_changed = TRUE;
+  }
+
+  if (!demux->growing) {
+    /* a finished file can be handled like any other */
+    gst_mxf_demux_pull_random_index_pack (demux);
+  }
+
+  if (duration_changed) {
+    GST_DEBUG_OBJECT (demux, "Indexed duration changed");
+    gst_element_post_message (GST_ELEMENT_CAST (demux),
+        gst_message_new_duration_changed (GST_OBJECT_CAST (demux)));
+  }
 }
 
 static gboolean
@@ -3672,6 +4172,9 @@ gst_mxf_demux_seek_pull (GstMXFDemux * demux, GstEvent * event)
     gst_pad_push_event (demux->sinkpad, e);
   }
 
+  if (demux->growing)
+    gst_mxf_demux_update_growing_file (demux);
+
   /* Work on a copy until we are sure the seek succeeded. */
   memcpy (&seeksegment, &demux->segment, sizeof (GstSegment));
 
@@ -3853,6 +4356,35 @@ gst_mxf_demux_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return ret;
 }
 
+/* Duration of the pad in edit units of its material track, taking the
+ * indexed part of a file that is still being written into account.
+ * Must be called with the metadata lock */
+static gint64
+gst_mxf_demux_pad_get_duration (GstMXFDemuxPad * pad)
+{
+  GstMXFDemuxEssenceTrack *etrack = pad->current_essence_track;
+  gint64 duration = pad->material_track->parent.sequence->duration;
+
+  if (duration <= -1)
+    duration = -1;
+
+  if (etrack && etrack->indexed_duration > 0 && etrack->source_track &&
+      etrack->source_track->edit_rate.n != 0 &&
+      etrack->source_track->edit_rate.d != 0 &&
+      pad->material_track->edit_rate.n != 0 &&
+      pad->material_track->edit_rate.d != 0) {
+    gint64 indexed = gst_util_uint64_scale (etrack->indexed_duration,
+        (guint64) pad->material_track->edit_rate.n *
+        etrack->source_track->edit_rate.d,
+        (guint64) pad->material_track->edit_rate.d *
+        etrack->source_track->edit_rate.n);
+
+    duration = MAX (duration, indexed);
+  }
+
+  return duration;
+}
+
 static gboolean
 gst_mxf_demux_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
 {
@@ -3913,9 +4445,7 @@ gst_mxf_demux_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
         goto error;
       }
 
-      duration = mxfpad->material_track->parent.sequence->duration;
-      if (duration <= -1)
-        duration = -1;
+      duration = gst_mxf_demux_pad_get_duration (mxfpad);
 
       if (duration != -1 && format == GST_FORMAT_TIME) {
         if (mxfpad->material_track->edit_rate.n == 0 ||
@@ -4213,7 +4743,7 @@ gst_mxf_demux_query (GstElement * element, GstQuery * query)
         if (!pad->material_track || !pad->material_track->parent.sequence)
           continue;
 
-        pdur = pad->material_track->parent.sequence->duration;
+        pdur = gst_mxf_demux_pad_get_duration (pad);
         if (pad->material_track->edit_rate.n == 0 ||
             pad->material_track->edit_rate.d == 0 || pdur <= -1)
           continue;
@@ -4344,6 +4874,9 @@ gst_mxf_demux_set_property (GObject * object, guint prop_id,
     case PROP_MAX_DRIFT:
       demux->max_drift = g_value_get_uint64 (value);
       break;
+    case PROP_LAZY_DESCRIPTIVE_METADATA:
+      demux->lazy_descriptive_metadata = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4366,7 +4899,8 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
     case PROP_STRUCTURE:{
       GstStructure *s;
 
-      g_rw_lock_reader_lock (&demux->metadata_lock);
+      g_rw_lock_writer_lock (&demux->metadata_lock);
+      gst_mxf_demux_parse_pending_descriptive_metadata (demux);
       if (demux->preface)
         s = mxf_metadata_base_to_structure (MXF_METADATA_BASE (demux->preface));
       else
@@ -4377,9 +4911,12 @@ gst_mxf_demux_get_property (GObject * object, guint prop_id,
       if (s)
         gst_structure_free (s);
 
-      g_rw_lock_reader_unlock (&demux->metadata_lock);
+      g_rw_lock_writer_unlock (&demux->metadata_lock);
       break;
     }
+    case PROP_LAZY_DESCRIPTIVE_METADATA:
+      g_value_set_boolean (value, demux->lazy_descriptive_metadata);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -4455,6 +4992,15 @@ gst_mxf_demux_class_init (GstMXFDemuxClass * klass)
           "Structural metadata of the MXF file",
           GST_TYPE_STRUCTURE, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class,
+      PROP_LAZY_DESCRIPTIVE_METADATA,
+      g_param_spec_boolean ("lazy-descriptive-metadata",
+          "Lazy descriptive metadata",
+          "Only parse descriptive metadata (e.g. DMS-1) when the structure "
+          "property is read. The structure tag sent downstream does not "
+          "include it then", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->change_state =
       GST_DEBUG_FUNCPTR (gst_mxf_demux_change_state);
   gstelement_class->query = GST_DEBUG_FUNCPTR (gst_mxf_demux_query);
@@ -62,6 +62,16 @@ typedef struct
   gboolean keyframe;
 } GstMXFDemuxIndex;
 
+/* Offsets of the edit units of a track or index table, indexed directly by
+ * edit unit. Edit units with unknown offset have offset 0. The edit units of
+ * all keyframes are kept sorted in keyframes to find the previous keyframe of
+ * an edit unit without walking back over the GOP. */
+typedef struct
+{
+  GArray *entries;
+  GArray *keyframes;
+} GstMXFDemuxOffsets;
+
 typedef struct
 {
   guint32 body_sid;
@@ -73,8 +83,10 @@ typedef struct
 
   gint64 position;
   gint64 duration;
+  /* number of edit units covered by the index of a growing file */
+  gint64 indexed_duration;
 
-  GArray *offsets;
+  GstMXFDemuxOffsets offsets;
 
   MXFMetadataSourcePackage *source_package;
   MXFMetadataTimelineTrack *source_track;
@@ -92,7 +104,7 @@ typedef struct
 {
   guint32 body_sid;
   guint32 index_sid;
-  GArray *offsets;
+  GstMXFDemuxOffsets offsets;
 } GstMXFDemuxIndexTable;
 
 struct _GstMXFDemuxPad
@@ -168,6 +180,11 @@ struct _GstMXFDemux
 
   GArray *random_index_pack;
 
+  /* File that is still being written */
+  gboolean growing;
+  guint64 growing_scan_offset;
+  gint64 growing_last_update;
+
   /* Metadata */
   GRWLock metadata_lock;
   gboolean update_metadata;
@@ -176,6 +193,8 @@ struct _GstMXFDemux
   gboolean metadata_resolved;
   MXFMetadataPreface *preface;
   GHashTable *metadata;
+  /* descriptive metadata sets that are only parsed when needed */
+  GList *pending_descriptive_metadata;
 
   MXFUMID current_package_uid;
   MXFMetadataGenericPackage *current_package;
@@ -186,6 +205,7 @@ struct _GstMXFDemux
   /* Properties */
   gchar *requested_package_string;
   GstClockTime max_drift;
+  gboolean lazy_descriptive_metadata;
 };
 
 struct _GstMXFDemuxClass
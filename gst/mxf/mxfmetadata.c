@@ -3785,13 +3785,18 @@ mxf_metadata_dm_segment_resolve (MXFMetadataBase * m, GHashTable * metadata)
           mxf_uuid_to_string (&self->dm_framework_uid, str));
       return FALSE;
     }
+  } else if (!current && self->dm_framework_deferred) {
+    /* The demuxer defers descriptive metadata, keep the segment and link
+     * the framework once it is parsed */
+    GST_DEBUG ("DM framework %s not parsed yet",
+        mxf_uuid_to_string (&self->dm_framework_uid, str));
+    self->dm_framework = NULL;
   } else {
     GST_ERROR ("Couldn't find DM framework %s",
         mxf_uuid_to_string (&self->dm_framework_uid, str));
     return FALSE;
   }
 
-
   return
       MXF_METADATA_BASE_CLASS (mxf_metadata_dm_segment_parent_class)->resolve
       (m, metadata);
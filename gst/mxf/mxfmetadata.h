@@ -614,6 +614,9 @@ struct _MXFMetadataDMSegment {
       
   MXFUUID dm_framework_uid;
   MXFDescriptiveMetadataFramework *dm_framework;
+
+  /* the framework is parsed later, a missing one is linked then */
+  gboolean dm_framework_deferred;
 };
 
 struct _MXFMetadataGenericDescriptor {
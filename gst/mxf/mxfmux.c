@@ -112,15 +112,22 @@ static GstStaticPadTemplate src_templ = GST_STATIC_PAD_TEMPLATE ("src",
     GST_STATIC_CAPS ("application/mxf")
     );
 
+#define DEFAULT_PARTITION_INTERVAL 0
+
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_PARTITION_INTERVAL
 };
 
 #define gst_mxf_mux_parent_class parent_class
 G_DEFINE_TYPE (GstMXFMux, gst_mxf_mux, GST_TYPE_AGGREGATOR);
 
 static void gst_mxf_mux_finalize (GObject * object);
+static void gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
 
 static GstFlowReturn gst_mxf_mux_aggregate (GstAggregator * aggregator,
     gboolean timeout);
@@ -134,6 +141,7 @@ static GstAggregatorPad *gst_mxf_mux_create_new_pad (GstAggregator * aggregator,
     GstPadTemplate * templ, const gchar * name, const GstCaps * caps);
 
 static void gst_mxf_mux_reset (GstMXFMux * mux);
+static GstFlowReturn gst_mxf_mux_write_body_partition (GstMXFMux * mux);
 
 static GstFlowReturn
 gst_mxf_mux_push (GstMXFMux * mux, GstBuffer * buf)
@@ -162,6 +170,16 @@ gst_mxf_mux_class_init (GstMXFMuxClass * klass)
   gstaggregator_class = (GstAggregatorClass *) klass;
 
   gobject_class->finalize = gst_mxf_mux_finalize;
+  gobject_class->set_property = gst_mxf_mux_set_property;
+  gobject_class->get_property = gst_mxf_mux_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_PARTITION_INTERVAL,
+      g_param_spec_uint64 ("partition-interval", "Partition interval",
+          "Start a new body partition with repeated header metadata and the "
+          "index table segments written since the previous one at the first "
+          "keyframe after this many nanoseconds (0 = single body partition)",
+          0, G_MAXUINT64, DEFAULT_PARTITION_INTERVAL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
   gstaggregator_class->create_new_pad =
       GST_DEBUG_FUNCPTR (gst_mxf_mux_create_new_pad);
@@ -190,6 +208,9 @@ static void
 gst_mxf_mux_init (GstMXFMux * mux)
 {
   mux->index_table = g_array_new (FALSE, FALSE, sizeof (MXFIndexTableSegment));
+  mux->partitions =
+      g_array_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry));
+  mux->partition_interval = DEFAULT_PARTITION_INTERVAL;
   gst_mxf_mux_reset (mux);
 }
 
@@ -212,9 +233,57 @@ gst_mxf_mux_finalize (GObject * object)
     mux->index_table = NULL;
   }
 
+  if (mux->partitions) {
+    g_array_free (mux->partitions, TRUE);
+    mux->partitions = NULL;
+  }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+static void
+gst_mxf_mux_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      mux->partition_interval = g_value_get_uint64 (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mxf_mux_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstMXFMux *mux = GST_MXF_MUX (object);
+
+  switch (prop_id) {
+    case PROP_PARTITION_INTERVAL:
+      g_value_set_uint64 (value, mux->partition_interval);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_mxf_mux_clear_index_table (GstMXFMux * mux)
+{
+  guint i;
+
+  for (i = 0; i < mux->index_table->len; i++)
+    mxf_index_table_segment_reset (&g_array_index (mux->index_table,
+            MXFIndexTableSegment, i));
+  g_array_set_size (mux->index_table, 0);
+}
+
 static void
 gst_mxf_mux_reset (GstMXFMux * mux)
 {
@@ -254,8 +323,11 @@ gst_mxf_mux_reset (GstMXFMux * mux)
   mux->last_gc_timestamp = 0;
   mux->last_gc_position = 0;
   mux->offset = 0;
+  mux->body_offset = 0;
+  mux->last_partition_timestamp = GST_CLOCK_TIME_NONE;
 
-  g_array_set_size (mux->index_table, 0);
+  gst_mxf_mux_clear_index_table (mux);
+  g_array_set_size (mux->partitions, 0);
 }
 
 static gboolean
@@ -1257,6 +1329,23 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
     MXFIndexTableSegment *segment;
     const gint max_segment_size = G_MAXUINT16 / 11;
 
+    /* The first body partition was written before the first content
+     * package, the interval counts from there */
+    if (!GST_CLOCK_TIME_IS_VALID (mux->last_partition_timestamp))
+      mux->last_partition_timestamp = pad->last_timestamp;
+
+    /* The first stream starts every content package, so a new partition
+     * can start here */
+    if (mux->partition_interval > 0 && is_keyframe
+        && pad->last_timestamp >=
+        mux->last_partition_timestamp + mux->partition_interval) {
+      mux->last_partition_timestamp = pad->last_timestamp;
+      if ((ret = gst_mxf_mux_write_body_partition (mux)) != GST_FLOW_OK) {
+        gst_buffer_unref (buf);
+        return ret;
+      }
+    }
+
     if (mux->index_table->len == 0 ||
         g_array_index (mux->index_table, MXFIndexTableSegment,
             mux->index_table->len - 1).index_duration >= max_segment_size) {
@@ -1290,7 +1379,7 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
     segment->index_entries[segment->n_index_entries].key_frame_offset = 0;
     segment->index_entries[segment->n_index_entries].flags = is_keyframe ? 0x80 : 0x20; /* FIXME: Need to distinguish all the cases */
     segment->index_entries[segment->n_index_entries].stream_offset =
-        mux->partition.body_offset;
+        mux->body_offset;
 
     segment->n_index_entries++;
     segment->index_duration++;
@@ -1310,7 +1399,7 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
       "Pushing buffer of size %" G_GSIZE_FORMAT " for track %u",
       gst_buffer_get_size (outbuf), pad->source_track->parent.track_id);
 
-  mux->partition.body_offset += gst_buffer_get_size (outbuf);
+  mux->body_offset += gst_buffer_get_size (outbuf);
   if ((ret = gst_mxf_mux_push (mux, outbuf)) != GST_FLOW_OK) {
     GST_ERROR_OBJECT (pad,
         "Failed pushing buffer for track %u, reason %s",
@@ -1326,26 +1415,104 @@ gst_mxf_mux_handle_buffer (GstMXFMux * mux, GstMXFMuxPad * pad)
   return ret;
 }
 
+/* Serializes the index table segments collected so far and removes them
+ * from the index table */
+static GList *
+gst_mxf_mux_take_index_table_segments (GstMXFMux * mux,
+    guint64 * index_byte_count)
+{
+  GList *buffers = NULL;
+  guint i;
+
+  *index_byte_count = 0;
+  for (i = 0; i < mux->index_table->len; i++) {
+    MXFIndexTableSegment *segment =
+        &g_array_index (mux->index_table, MXFIndexTableSegment, i);
+    GstBuffer *segment_buffer = mxf_index_table_segment_to_buffer (segment);
+
+    *index_byte_count += gst_buffer_get_size (segment_buffer);
+    buffers = g_list_prepend (buffers, segment_buffer);
+  }
+  gst_mxf_mux_clear_index_table (mux);
+
+  return g_list_reverse (buffers);
+}
+
+static GstFlowReturn
+gst_mxf_mux_push_index_table_segments (GstMXFMux * mux, GList * buffers)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GList *l;
+
+  for (l = buffers; l; l = l->next) {
+    GstBuffer *buf = l->data;
+
+    l->data = NULL;
+    if ((ret = gst_mxf_mux_push (mux, buf)) != GST_FLOW_OK) {
+      GST_ERROR_OBJECT (mux, "Failed pushing index table segment");
+      g_list_foreach (l->next, (GFunc) gst_mini_object_unref, NULL);
+      break;
+    }
+  }
+  g_list_free (buffers);
+
+  return ret;
+}
+
+/* Writes the first body partition after the header partition, or a new one
+ * with a copy of the header metadata and the index table segments of the
+ * previous partitions' essence */
 static GstFlowReturn
 gst_mxf_mux_write_body_partition (GstMXFMux * mux)
 {
   GstBuffer *buf;
+  GList *index_segments;
+  guint64 index_byte_count;
+  MXFRandomIndexPackEntry entry;
+  gboolean first = mux->partitions->len == 1;
+  GstFlowReturn ret;
+
+  index_segments =
+      gst_mxf_mux_take_index_table_segments (mux, &index_byte_count);
+
+  GST_DEBUG_OBJECT (mux, "Writing body partition at offset %" G_GUINT64_FORMAT
+      " with %u index table segments", mux->offset,
+      g_list_length (index_segments));
 
   mux->partition.type = MXF_PARTITION_PACK_BODY;
-  mux->partition.closed = TRUE;
-  mux->partition.complete = TRUE;
+  /* the repeated metadata is not final before the end of the stream */
+  mux->partition.closed = first;
+  mux->partition.complete = first;
   mux->partition.this_partition = mux->offset;
-  mux->partition.prev_partition = 0;
+  mux->partition.prev_partition =
+      g_array_index (mux->partitions, MXFRandomIndexPackEntry,
+      mux->partitions->len - 1).offset;
   mux->partition.footer_partition = 0;
   mux->partition.header_byte_count = 0;
-  mux->partition.index_byte_count = 0;
-  mux->partition.index_sid = 0;
-  mux->partition.body_offset = 0;
+  mux->partition.index_byte_count = index_byte_count;
+  mux->partition.index_sid = index_segments ?
+      mux->preface->content_storage->essence_container_data[0]->index_sid : 0;
+  mux->partition.body_offset = mux->body_offset;
   mux->partition.body_sid =
       mux->preface->content_storage->essence_container_data[0]->body_sid;
 
-  buf = mxf_partition_pack_to_buffer (&mux->partition);
-  return gst_mxf_mux_push (mux, buf);
+  entry.offset = mux->offset;
+  entry.body_sid = mux->partition.body_sid;
+  g_array_append_val (mux->partitions, entry);
+
+  if (first) {
+    buf = mxf_partition_pack_to_buffer (&mux->partition);
+    ret = gst_mxf_mux_push (mux, buf);
+  } else {
+    ret = gst_mxf_mux_write_header_metadata (mux);
+  }
+
+  if (ret != GST_FLOW_OK) {
+    g_list_free_full (index_segments, (GDestroyNotify) gst_mini_object_unref);
+    return ret;
+  }
+
+  return gst_mxf_mux_push_index_table_segments (mux, index_segments);
 }
 
 static GstFlowReturn
@@ -1462,32 +1629,27 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
   }
 
   {
-    guint64 body_partition = mux->partition.this_partition;
-    guint32 body_sid = mux->partition.body_sid;
+    guint64 body_partition =
+        g_array_index (mux->partitions, MXFRandomIndexPackEntry, 1).offset;
+    guint64 prev_partition =
+        g_array_index (mux->partitions, MXFRandomIndexPackEntry,
+        mux->partitions->len - 1).offset;
     guint64 footer_partition = mux->offset;
-    GArray *rip;
     GstFlowReturn ret;
     GstSegment segment;
     MXFRandomIndexPackEntry entry;
-    GList *index_entries = NULL, *l;
-    guint index_byte_count = 0;
-    guint i;
+    GList *index_entries;
+    guint64 index_byte_count;
     GstBuffer *buf;
 
-    for (i = 0; i < mux->index_table->len; i++) {
-      MXFIndexTableSegment *segment =
-          &g_array_index (mux->index_table, MXFIndexTableSegment, i);
-      GstBuffer *segment_buffer = mxf_index_table_segment_to_buffer (segment);
-
-      index_byte_count += gst_buffer_get_size (segment_buffer);
-      index_entries = g_list_prepend (index_entries, segment_buffer);
-    }
+    index_entries =
+        gst_mxf_mux_take_index_table_segments (mux, &index_byte_count);
 
     mux->partition.type = MXF_PARTITION_PACK_FOOTER;
     mux->partition.closed = TRUE;
     mux->partition.complete = TRUE;
     mux->partition.this_partition = mux->offset;
-    mux->partition.prev_partition = body_partition;
+    mux->partition.prev_partition = prev_partition;
     mux->partition.footer_partition = mux->offset;
     mux->partition.header_byte_count = 0;
     mux->partition.index_byte_count = index_byte_count;
@@ -1498,30 +1660,16 @@ gst_mxf_mux_handle_eos (GstMXFMux * mux)
 
     gst_mxf_mux_write_header_metadata (mux);
 
-    index_entries = g_list_reverse (index_entries);
-    for (l = index_entries; l; l = l->next) {
-      if ((ret = gst_mxf_mux_push (mux, l->data)) != GST_FLOW_OK) {
-        GST_ERROR_OBJECT (mux, "Failed pushing index table segment");
-      }
-    }
-    g_list_free (index_entries);
+    gst_mxf_mux_push_index_table_segments (mux, index_entries);
 
-    rip = g_array_sized_new (FALSE, FALSE, sizeof (MXFRandomIndexPackEntry), 3);
-    entry.offset = 0;
-    entry.body_sid = 0;
-    g_array_append_val (rip, entry);
-    entry.offset = body_partition;
-    entry.body_sid = body_sid;
-    g_array_append_val (rip, entry);
     entry.offset = footer_partition;
     entry.body_sid = 0;
-    g_array_append_val (rip, entry);
+    g_array_append_val (mux->partitions, entry);
 
-    packet = mxf_random_index_pack_to_buffer (rip);
+    packet = mxf_random_index_pack_to_buffer (mux->partitions);
     if ((ret = gst_mxf_mux_push (mux, packet)) != GST_FLOW_OK) {
       GST_ERROR_OBJECT (mux, "Failed pushing random index pack");
     }
-    g_array_free (rip, TRUE);
 
     /* Rewrite header partition with updated values */
     gst_segment_init (&segment, GST_FORMAT_BYTES);
@@ -1649,6 +1797,12 @@ gst_mxf_mux_aggregate (GstAggregator * aggregator, gboolean timeout)
     if ((ret = gst_mxf_mux_write_header_metadata (mux)) != GST_FLOW_OK)
       goto error;
 
+    {
+      MXFRandomIndexPackEntry entry = { 0, 0 };
+
+      g_array_append_val (mux->partitions, entry);
+    }
+
     /* Sort pads, we will always write in that order */
     GST_OBJECT_LOCK (mux);
     GST_ELEMENT_CAST (mux)->sinkpads =
@@ -69,7 +69,16 @@ typedef struct _GstMXFMux {
 
   gchar *application;
 
+  /* index table segments not written to a partition yet */
   GArray *index_table;
+  /* offset of the next essence element in the essence container */
+  guint64 body_offset;
+  /* MXFRandomIndexPackEntry for every partition written so far */
+  GArray *partitions;
+  GstClockTime last_partition_timestamp;
+
+  /* Properties */
+  GstClockTime partition_interval;
 } GstMXFMux;
 
 typedef struct _GstMXFMuxClass {
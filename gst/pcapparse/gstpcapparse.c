@@ -25,6 +25,15 @@
  * #GstPcapParse:src-port and #GstPcapParse:dst-port to restrict which packets
  * should be included.
  *
+ * Both classic pcap files, with microsecond or nanosecond timestamps, and
+ * pcapng files are understood. VLAN tags in Ethernet frames are skipped.
+ *
+ * With #GstPcapParse:demux, a source pad is created for each flow of UDP or
+ * TCP packets (source and destination address and port, and protocol) that
+ * passes the filters, so that all flows of a capture are extracted in a
+ * single pass. With #GstPcapParse:sync, the packets are output at the pace
+ * they were captured at.
+ *
  * <refsect2>
  * <title>Example pipelines</title>
  * |[
@@ -32,6 +41,11 @@
  * ! ffdec_h264 ! fakesink
  * ]| Read from a pcap dump file using filesrc, extract the raw UDP packets,
  * depayload and decode them.
+ * |[
+ * gst-launch-1.0 filesrc location=bundle.pcapng ! pcapparse demux=true sync=true
+ * caps="application/x-rtp" name=p p.src_0 ! queue ! udpsink port=5000
+ * p.src_1 ! queue ! udpsink port=5002
+ * ]| Replay the first two flows of a capture with their original timing.
  * </refsect2>
  */
 
@@ -63,9 +77,37 @@ enum
   PROP_SRC_PORT,
   PROP_DST_PORT,
   PROP_CAPS,
-  PROP_TS_OFFSET
+  PROP_TS_OFFSET,
+  PROP_DEMUX,
+  PROP_SYNC
 };
 
+#define DEFAULT_DEMUX FALSE
+#define DEFAULT_SYNC FALSE
+
+/* A flow of packets in demux mode. The first fields are the key in the
+ * flows hash table */
+typedef struct
+{
+  guint32 src_ip;
+  guint32 dst_ip;
+  guint16 src_port;
+  guint16 dst_port;
+  guint8 protocol;
+
+  GstPad *pad;
+  GstBufferList *list;
+  gboolean need_segment;
+} GstPcapParseFlow;
+
+/* An interface of a pcapng section */
+typedef struct
+{
+  GstPcapParseLinktype linktype;
+  /* timestamp units per second */
+  guint64 ts_rate;
+} GstPcapParseInterface;
+
 GST_DEBUG_CATEGORY_STATIC (gst_pcap_parse_debug);
 #define GST_CAT_DEFAULT gst_pcap_parse_debug
 
@@ -79,6 +121,12 @@ static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS_ANY);
 
+static GstStaticPadTemplate flow_src_template =
+GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS_ANY);
+
 static void gst_pcap_parse_finalize (GObject * object);
 static void gst_pcap_parse_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
@@ -138,8 +186,21 @@ gst_pcap_parse_class_init (GstPcapParseClass * klass)
           "Relative timestamp offset (ns) to apply (-1 = use absolute packet time)",
           -1, G_MAXINT64, -1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_DEMUX,
+      g_param_spec_boolean ("demux", "Demux",
+          "Output each UDP or TCP flow on its own source pad",
+          DEFAULT_DEMUX, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SYNC,
+      g_param_spec_boolean ("sync", "Sync",
+          "Output packets synchronized to the clock, at the pace they were "
+          "captured at", DEFAULT_SYNC,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &sink_template);
   gst_element_class_add_static_pad_template (element_class, &src_template);
+  gst_element_class_add_static_pad_template (element_class,
+      &flow_src_template);
 
   element_class->change_state = gst_pcap_parse_change_state;
 
@@ -151,6 +212,34 @@ gst_pcap_parse_class_init (GstPcapParseClass * klass)
   GST_DEBUG_CATEGORY_INIT (gst_pcap_parse_debug, "pcapparse", 0, "pcap parser");
 }
 
+static guint
+gst_pcap_parse_flow_hash (gconstpointer key)
+{
+  const GstPcapParseFlow *flow = key;
+
+  return flow->src_ip ^ flow->dst_ip ^
+      (((guint32) flow->src_port << 16) | flow->dst_port) ^ flow->protocol;
+}
+
+static gboolean
+gst_pcap_parse_flow_equal (gconstpointer a, gconstpointer b)
+{
+  const GstPcapParseFlow *flow_a = a, *flow_b = b;
+
+  return flow_a->src_ip == flow_b->src_ip && flow_a->dst_ip == flow_b->dst_ip
+      && flow_a->src_port == flow_b->src_port
+      && flow_a->dst_port == flow_b->dst_port
+      && flow_a->protocol == flow_b->protocol;
+}
+
+static void
+gst_pcap_parse_flow_free (GstPcapParseFlow * flow)
+{
+  if (flow->list)
+    gst_buffer_list_unref (flow->list);
+  g_free (flow);
+}
+
 static void
 gst_pcap_parse_init (GstPcapParse * self)
 {
@@ -171,8 +260,17 @@ gst_pcap_parse_init (GstPcapParse * self)
   self->src_port = -1;
   self->dst_port = -1;
   self->offset = -1;
+  self->demux = DEFAULT_DEMUX;
+  self->sync = DEFAULT_SYNC;
 
   self->adapter = gst_adapter_new ();
+  self->interfaces =
+      g_array_new (FALSE, FALSE, sizeof (GstPcapParseInterface));
+  self->flows = g_hash_table_new_full (gst_pcap_parse_flow_hash,
+      gst_pcap_parse_flow_equal, NULL,
+      (GDestroyNotify) gst_pcap_parse_flow_free);
+  self->flowcombiner = gst_flow_combiner_new ();
+  self->group_id = G_MAXUINT;
 
   gst_pcap_parse_reset (self);
 }
@@ -182,6 +280,10 @@ gst_pcap_parse_finalize (GObject * object)
 {
   GstPcapParse *self = GST_PCAP_PARSE (object);
 
+  /* the pads were removed when disposing */
+  g_hash_table_unref (self->flows);
+  gst_flow_combiner_free (self->flowcombiner);
+  g_array_free (self->interfaces, TRUE);
   g_object_unref (self->adapter);
   if (self->caps)
     gst_caps_unref (self->caps);
@@ -244,6 +346,14 @@ gst_pcap_parse_get_property (GObject * object, guint prop_id,
       g_value_set_int64 (value, self->offset);
       break;
 
+    case PROP_DEMUX:
+      g_value_set_boolean (value, self->demux);
+      break;
+
+    case PROP_SYNC:
+      g_value_set_boolean (value, self->sync);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -298,6 +408,14 @@ gst_pcap_parse_set_property (GObject * object, guint prop_id,
       self->offset = g_value_get_int64 (value);
       break;
 
+    case PROP_DEMUX:
+      self->demux = g_value_get_boolean (value);
+      break;
+
+    case PROP_SYNC:
+      self->sync = g_value_get_boolean (value);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -307,16 +425,53 @@ gst_pcap_parse_set_property (GObject * object, guint prop_id,
 static void
 gst_pcap_parse_reset (GstPcapParse * self)
 {
+  GHashTableIter iter;
+  gpointer value;
+
   self->initialized = FALSE;
   self->swap_endian = FALSE;
+  self->pcapng = FALSE;
+  self->nsec_timestamps = FALSE;
   self->cur_packet_size = -1;
+  self->cur_packet_skip = 0;
   self->cur_ts = GST_CLOCK_TIME_NONE;
   self->base_ts = GST_CLOCK_TIME_NONE;
   self->newsegment_sent = FALSE;
+  gst_segment_init (&self->segment, GST_FORMAT_TIME);
+
+  g_array_set_size (self->interfaces, 0);
+
+  /* flows keep their pads, but need a new segment */
+  g_hash_table_iter_init (&iter, self->flows);
+  while (g_hash_table_iter_next (&iter, NULL, &value)) {
+    GstPcapParseFlow *flow = value;
+
+    flow->need_segment = TRUE;
+  }
+  gst_flow_combiner_reset (self->flowcombiner);
 
   gst_adapter_clear (self->adapter);
 }
 
+static void
+gst_pcap_parse_remove_flows (GstPcapParse * self)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, self->flows);
+  while (g_hash_table_iter_next (&iter, NULL, &value)) {
+    GstPcapParseFlow *flow = value;
+
+    gst_flow_combiner_remove_pad (self->flowcombiner, flow->pad);
+    gst_pad_set_active (flow->pad, FALSE);
+    gst_element_remove_pad (GST_ELEMENT_CAST (self), flow->pad);
+  }
+  g_hash_table_remove_all (self->flows);
+  self->n_flows = 0;
+  self->group_id = G_MAXUINT;
+}
+
 static guint32
 gst_pcap_parse_read_uint32 (GstPcapParse * self, const guint8 * p)
 {
@@ -333,11 +488,32 @@ gst_pcap_parse_read_uint32 (GstPcapParse * self, const guint8 * p)
   }
 }
 
+static guint16
+gst_pcap_parse_read_uint16 (GstPcapParse * self, const guint8 * p)
+{
+  guint16 val = *((guint16 *) p);
+
+  if (self->swap_endian) {
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    return GUINT16_FROM_BE (val);
+#else
+    return GUINT16_FROM_LE (val);
+#endif
+  } else {
+    return val;
+  }
+}
+
 #define ETH_HEADER_LEN    14
 #define SLL_HEADER_LEN    16
+#define VLAN_TAG_LEN       4
 #define IP_HEADER_MIN_LEN 20
 #define UDP_HEADER_LEN     8
 
+#define ETH_TYPE_IPV4     0x0800
+#define ETH_TYPE_VLAN     0x8100
+#define ETH_TYPE_QINQ     0x88a8
+
 #define IP_PROTO_UDP      17
 #define IP_PROTO_TCP      6
 
@@ -345,7 +521,8 @@ gst_pcap_parse_read_uint32 (GstPcapParse * self, const guint8 * p)
 static gboolean
 gst_pcap_parse_scan_frame (GstPcapParse * self,
     const guint8 * buf,
-    gint buf_size, const guint8 ** payload, gint * payload_size)
+    gint buf_size, const guint8 ** payload, gint * payload_size,
+    GstPcapParseFlow * flow)
 {
   const guint8 *buf_ip = 0;
   const guint8 *buf_proto;
@@ -378,7 +555,7 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
       if (buf_size < IP_HEADER_MIN_LEN + UDP_HEADER_LEN)
         return FALSE;
 
-      eth_type = 0x800;         /* This is fine since IPv4/IPv6 is parse elsewhere */
+      eth_type = ETH_TYPE_IPV4; /* This is fine since IPv4/IPv6 is parse elsewhere */
       buf_ip = buf;
       break;
 
@@ -386,7 +563,17 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
       return FALSE;
   }
 
-  if (eth_type != 0x800)
+  /* skip 802.1Q and 802.1ad VLAN tags */
+  while (eth_type == ETH_TYPE_VLAN || eth_type == ETH_TYPE_QINQ) {
+    if (buf_ip + VLAN_TAG_LEN + IP_HEADER_MIN_LEN + UDP_HEADER_LEN >
+        buf + buf_size)
+      return FALSE;
+
+    eth_type = GUINT16_FROM_BE (*((guint16 *) (buf_ip + 2)));
+    buf_ip += VLAN_TAG_LEN;
+  }
+
+  if (eth_type != ETH_TYPE_IPV4)
     return FALSE;
 
   b = *buf_ip;
@@ -445,14 +632,402 @@ gst_pcap_parse_scan_frame (GstPcapParse * self,
   if (self->dst_port >= 0 && dst_port != self->dst_port)
     return FALSE;
 
+  flow->src_ip = ip_src_addr;
+  flow->dst_ip = ip_dst_addr;
+  flow->src_port = src_port;
+  flow->dst_port = dst_port;
+  flow->protocol = ip_protocol;
+
+  return TRUE;
+}
+
+static GstPcapParseFlow *
+gst_pcap_parse_get_flow (GstPcapParse * self, const GstPcapParseFlow * key)
+{
+  GstPcapParseFlow *flow;
+  GstEvent *event;
+  gchar *name, *stream_id;
+
+  flow = g_hash_table_lookup (self->flows, key);
+  if (flow)
+    return flow;
+
+  flow = g_new0 (GstPcapParseFlow, 1);
+  flow->src_ip = key->src_ip;
+  flow->dst_ip = key->dst_ip;
+  flow->src_port = key->src_port;
+  flow->dst_port = key->dst_port;
+  flow->protocol = key->protocol;
+  flow->need_segment = TRUE;
+
+  name = g_strdup_printf ("src_%u", self->n_flows++);
+  flow->pad = gst_pad_new_from_static_template (&flow_src_template, name);
+  g_free (name);
+  gst_pad_use_fixed_caps (flow->pad);
+  gst_pad_set_active (flow->pad, TRUE);
+
+  GST_DEBUG_OBJECT (self, "new flow %08x:%u -> %08x:%u, protocol %u on %"
+      GST_PTR_FORMAT, GUINT32_FROM_BE (flow->src_ip), flow->src_port,
+      GUINT32_FROM_BE (flow->dst_ip), flow->dst_port, flow->protocol,
+      flow->pad);
+
+  if (self->group_id == G_MAXUINT)
+    self->group_id = gst_util_group_id_next ();
+
+  stream_id = gst_pad_create_stream_id_printf (flow->pad,
+      GST_ELEMENT_CAST (self), "%08x:%u-%08x:%u-%u",
+      GUINT32_FROM_BE (flow->src_ip), flow->src_port,
+      GUINT32_FROM_BE (flow->dst_ip), flow->dst_port, flow->protocol);
+  event = gst_event_new_stream_start (stream_id);
+  gst_event_set_group_id (event, self->group_id);
+  gst_pad_push_event (flow->pad, event);
+  g_free (stream_id);
+
+  if (self->caps && gst_caps_is_fixed (self->caps))
+    gst_pad_push_event (flow->pad, gst_event_new_caps (self->caps));
+
+  g_hash_table_insert (self->flows, flow, flow);
+  gst_flow_combiner_add_pad (self->flowcombiner, flow->pad);
+  gst_element_add_pad (GST_ELEMENT_CAST (self), flow->pad);
+
+  return flow;
+}
+
+static GstFlowReturn
+gst_pcap_parse_push_pending (GstPcapParse * self, GstBufferList ** list)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  GHashTableIter iter;
+  gpointer value;
+
+  if (*list) {
+    if (!self->newsegment_sent && GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
+      if (self->caps)
+        gst_pad_set_caps (self->src_pad, self->caps);
+      gst_pad_push_event (self->src_pad,
+          gst_event_new_segment (&self->segment));
+      self->newsegment_sent = TRUE;
+    }
+
+    ret = gst_pad_push_list (self->src_pad, *list);
+    *list = NULL;
+  }
+
+  g_hash_table_iter_init (&iter, self->flows);
+  while (g_hash_table_iter_next (&iter, NULL, &value)) {
+    GstPcapParseFlow *flow = value;
+    GstFlowReturn flow_ret;
+
+    if (flow->list == NULL)
+      continue;
+
+    if (flow->need_segment) {
+      gst_pad_push_event (flow->pad, gst_event_new_segment (&self->segment));
+      flow->need_segment = FALSE;
+    }
+
+    flow_ret = gst_pad_push_list (flow->pad, flow->list);
+    flow->list = NULL;
+    ret = gst_flow_combiner_update_pad_flow (self->flowcombiner, flow->pad,
+        flow_ret);
+  }
+
+  return ret;
+}
+
+static void
+gst_pcap_parse_set_flushing (GstPcapParse * self, gboolean flushing)
+{
+  GST_OBJECT_LOCK (self);
+  self->flushing = flushing;
+  if (flushing && self->clock_id)
+    gst_clock_id_unschedule (self->clock_id);
+  GST_OBJECT_UNLOCK (self);
+}
+
+/* Waits until the running time of the capture timestamp. Nothing is waited
+ * for before the pipeline is playing */
+static GstFlowReturn
+gst_pcap_parse_wait (GstPcapParse * self, GstClockTime timestamp)
+{
+  GstClockTime running_time;
+  GstClockReturn clock_ret;
+  GstClockID id;
+  GstClock *clock;
+
+  running_time = gst_segment_to_running_time (&self->segment,
+      GST_FORMAT_TIME, timestamp);
+  if (!GST_CLOCK_TIME_IS_VALID (running_time))
+    return GST_FLOW_OK;
+
+  GST_OBJECT_LOCK (self);
+  if (self->flushing) {
+    GST_OBJECT_UNLOCK (self);
+    return GST_FLOW_FLUSHING;
+  }
+
+  clock = GST_ELEMENT_CLOCK (self);
+  if (clock == NULL || GST_STATE (self) != GST_STATE_PLAYING) {
+    GST_OBJECT_UNLOCK (self);
+    return GST_FLOW_OK;
+  }
+
+  id = self->clock_id = gst_clock_new_single_shot_id (clock,
+      GST_ELEMENT_CAST (self)->base_time + running_time);
+  GST_OBJECT_UNLOCK (self);
+
+  GST_LOG_OBJECT (self, "waiting for running time %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (running_time));
+  clock_ret = gst_clock_id_wait (id, NULL);
+
+  GST_OBJECT_LOCK (self);
+  self->clock_id = NULL;
+  GST_OBJECT_UNLOCK (self);
+  gst_clock_id_unref (id);
+
+  if (clock_ret == GST_CLOCK_UNSCHEDULED)
+    return GST_FLOW_FLUSHING;
+
+  return GST_FLOW_OK;
+}
+
+/* Queues @buf for the src pad, or for the pad of its flow in demux mode, and
+ * pushes it right away when synchronizing to the clock */
+static GstFlowReturn
+gst_pcap_parse_add_buffer (GstPcapParse * self, const GstPcapParseFlow * key,
+    GstBuffer * buf, GstBufferList ** list)
+{
+  GstFlowReturn ret;
+
+  if (self->sync) {
+    ret = gst_pcap_parse_wait (self, GST_BUFFER_TIMESTAMP (buf));
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (buf);
+      return ret;
+    }
+  }
+
+  if (self->demux) {
+    GstPcapParseFlow *flow = gst_pcap_parse_get_flow (self, key);
+
+    list = &flow->list;
+  }
+
+  if (*list == NULL)
+    *list = gst_buffer_list_new ();
+  gst_buffer_list_add (*list, buf);
+
+  if (self->sync)
+    return gst_pcap_parse_push_pending (self, list);
+
+  return GST_FLOW_OK;
+}
+
+#define PCAPNG_BLOCK_IDB          0x00000001
+#define PCAPNG_BLOCK_OPB          0x00000002
+#define PCAPNG_BLOCK_SPB          0x00000003
+#define PCAPNG_BLOCK_EPB          0x00000006
+#define PCAPNG_BLOCK_SHB          0x0a0d0d0a
+#define PCAPNG_BYTE_ORDER_MAGIC   0x1a2b3c4d
+
+#define PCAPNG_OPT_ENDOFOPT       0
+#define PCAPNG_OPT_IF_TSRESOL     9
+
+/* Parses the options of an interface description block for the timestamp
+ * resolution, microseconds if there is none */
+static guint64
+gst_pcap_parse_read_ts_rate (GstPcapParse * self, const guint8 * data,
+    gsize size)
+{
+  guint64 ts_rate = G_GUINT64_CONSTANT (1000000);
+
+  while (size >= 4) {
+    guint16 code = gst_pcap_parse_read_uint16 (self, data);
+    guint16 len = gst_pcap_parse_read_uint16 (self, data + 2);
+    gsize padded_len = GST_ROUND_UP_4 (len);
+
+    if (code == PCAPNG_OPT_ENDOFOPT || 4 + padded_len > size)
+      break;
+
+    if (code == PCAPNG_OPT_IF_TSRESOL && len >= 1) {
+      guint8 resol = data[4];
+
+      if (resol & 0x80) {
+        if ((resol & 0x7f) < 64)
+          ts_rate = G_GUINT64_CONSTANT (1) << (resol & 0x7f);
+      } else if (resol <= 19) {
+        guint i;
+
+        for (ts_rate = 1, i = 0; i < resol; i++)
+          ts_rate *= 10;
+      }
+    }
+
+    data += 4 + padded_len;
+    size -= 4 + padded_len;
+  }
+
+  return ts_rate;
+}
+
+/* Parses the pcapng block at the start of the adapter. Returns FALSE if more
+ * data is needed. For packet blocks, only the block header is consumed and
+ * the packet is handled like a classic pcap record. */
+static gboolean
+gst_pcap_parse_read_block (GstPcapParse * self, gint avail,
+    GstFlowReturn * ret)
+{
+  const guint8 *data;
+  guint32 block_type, block_len;
+  guint32 if_id = 0, cap_len = 0, header_len = 0;
+  guint64 ts = GST_CLOCK_TIME_NONE;
+  GstPcapParseInterface *iface;
+
+  if (avail < 12)
+    return FALSE;
+
+  data = gst_adapter_map (self->adapter, 12);
+  block_type = GST_READ_UINT32_LE (data);
+
+  /* the block type of the section header is the same in both byte orders,
+   * the byte order magic tells the byte order of the section */
+  if (block_type == PCAPNG_BLOCK_SHB) {
+    guint32 magic = *((guint32 *) (data + 8));
+
+    if (magic == PCAPNG_BYTE_ORDER_MAGIC) {
+      self->swap_endian = FALSE;
+    } else if (magic == GUINT32_SWAP_LE_BE (PCAPNG_BYTE_ORDER_MAGIC)) {
+      self->swap_endian = TRUE;
+    } else {
+      gst_adapter_unmap (self->adapter);
+      GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
+          ("Invalid pcapng byte order magic %X", magic));
+      *ret = GST_FLOW_ERROR;
+      return TRUE;
+    }
+  }
+
+  block_type = gst_pcap_parse_read_uint32 (self, data);
+  block_len = gst_pcap_parse_read_uint32 (self, data + 4);
+  gst_adapter_unmap (self->adapter);
+
+  if (block_len < 12 || block_len % 4 != 0) {
+    GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+        ("Invalid pcapng block length %u", block_len));
+    *ret = GST_FLOW_ERROR;
+    return TRUE;
+  }
+
+  GST_LOG_OBJECT (self, "block type 0x%08x, length %u", block_type,
+      block_len);
+
+  switch (block_type) {
+    case PCAPNG_BLOCK_SHB:
+      /* interface ids are per section */
+      g_array_set_size (self->interfaces, 0);
+      /* fall through */
+    default:
+      if (avail < block_len)
+        return FALSE;
+      gst_adapter_flush (self->adapter, block_len);
+      return TRUE;
+
+    case PCAPNG_BLOCK_IDB:{
+      GstPcapParseInterface new_iface;
+
+      if (block_len < 20) {
+        GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+            ("Invalid pcapng interface description block"));
+        *ret = GST_FLOW_ERROR;
+        return TRUE;
+      }
+      if (avail < block_len)
+        return FALSE;
+
+      data = gst_adapter_map (self->adapter, block_len);
+      new_iface.linktype = gst_pcap_parse_read_uint16 (self, data + 8);
+      new_iface.ts_rate =
+          gst_pcap_parse_read_ts_rate (self, data + 16, block_len - 20);
+      gst_adapter_unmap (self->adapter);
+      gst_adapter_flush (self->adapter, block_len);
+
+      GST_DEBUG_OBJECT (self, "interface %u, linktype %u, %" G_GUINT64_FORMAT
+          " timestamp units per second", self->interfaces->len,
+          new_iface.linktype, new_iface.ts_rate);
+      g_array_append_val (self->interfaces, new_iface);
+      return TRUE;
+    }
+
+    case PCAPNG_BLOCK_EPB:
+    case PCAPNG_BLOCK_OPB:
+      header_len = 28;
+      if (block_len < header_len + 4)
+        goto invalid_packet_block;
+      if (avail < header_len)
+        return FALSE;
+
+      data = gst_adapter_map (self->adapter, header_len);
+      if (block_type == PCAPNG_BLOCK_EPB)
+        if_id = gst_pcap_parse_read_uint32 (self, data + 8);
+      else
+        if_id = gst_pcap_parse_read_uint16 (self, data + 8);
+      ts = ((guint64) gst_pcap_parse_read_uint32 (self, data + 12) << 32) |
+          gst_pcap_parse_read_uint32 (self, data + 16);
+      cap_len = gst_pcap_parse_read_uint32 (self, data + 20);
+      gst_adapter_unmap (self->adapter);
+
+      if (cap_len > block_len - header_len - 4)
+        goto invalid_packet_block;
+      break;
+
+    case PCAPNG_BLOCK_SPB:
+      header_len = 12;
+      if (block_len < header_len + 4)
+        goto invalid_packet_block;
+      if (avail < header_len)
+        return FALSE;
+
+      data = gst_adapter_map (self->adapter, header_len);
+      cap_len = gst_pcap_parse_read_uint32 (self, data + 8);
+      gst_adapter_unmap (self->adapter);
+
+      /* the original length, the packet may have been cut */
+      cap_len = MIN (cap_len, block_len - header_len - 4);
+      break;
+  }
+
+  if (if_id >= self->interfaces->len)
+    goto invalid_packet_block;
+
+  iface = &g_array_index (self->interfaces, GstPcapParseInterface, if_id);
+
+  gst_adapter_flush (self->adapter, header_len);
+
+  /* packets of interfaces with unsupported link types are dropped */
+  self->linktype = iface->linktype;
+  if (ts != GST_CLOCK_TIME_NONE)
+    self->cur_ts = gst_util_uint64_scale (ts, GST_SECOND, iface->ts_rate);
+  else
+    self->cur_ts = GST_CLOCK_TIME_NONE;
+  self->cur_packet_size = cap_len;
+  self->cur_packet_skip = block_len - header_len - cap_len;
+
   return TRUE;
+
+invalid_packet_block:
+  {
+    GST_ELEMENT_ERROR (self, STREAM, DECODE, (NULL),
+        ("Invalid pcapng packet block"));
+    *ret = GST_FLOW_ERROR;
+    return TRUE;
+  }
 }
 
 static GstFlowReturn
 gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstPcapParse *self = GST_PCAP_PARSE (parent);
-  GstFlowReturn ret = GST_FLOW_OK;
+  GstFlowReturn ret = GST_FLOW_OK, push_ret;
   GstBufferList *list = NULL;
 
   gst_adapter_push (self->adapter, buffer);
@@ -471,6 +1046,7 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
         if (self->cur_packet_size > 0) {
           const guint8 *payload_data;
           gint payload_size;
+          GstPcapParseFlow key;
 
           data = gst_adapter_map (self->adapter, self->cur_packet_size);
 
@@ -478,7 +1054,7 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
               self->cur_packet_size);
 
           if (gst_pcap_parse_scan_frame (self, data, self->cur_packet_size,
-                  &payload_data, &payload_size)) {
+                  &payload_data, &payload_size, &key)) {
             GstBuffer *out_buf;
             guintptr offset = payload_data - data;
 
@@ -497,8 +1073,13 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
                 self->cur_packet_size - offset - payload_size);
 
             if (GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
-              if (!GST_CLOCK_TIME_IS_VALID (self->base_ts))
+              if (!GST_CLOCK_TIME_IS_VALID (self->base_ts)) {
                 self->base_ts = self->cur_ts;
+                gst_segment_init (&self->segment, GST_FORMAT_TIME);
+                /* the timestamps are rebased to the offset */
+                self->segment.start =
+                    self->offset >= 0 ? self->offset : self->base_ts;
+              }
               if (self->offset >= 0) {
                 self->cur_ts -= self->base_ts;
                 self->cur_ts += self->offset;
@@ -506,10 +1087,7 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
             }
             GST_BUFFER_TIMESTAMP (out_buf) = self->cur_ts;
 
-
-            if (list == NULL)
-              list = gst_buffer_list_new ();
-            gst_buffer_list_add (list, out_buf);
+            ret = gst_pcap_parse_add_buffer (self, &key, out_buf, &list);
           } else {
             gst_adapter_unmap (self->adapter);
             gst_adapter_flush (self->adapter, self->cur_packet_size);
@@ -517,6 +1095,18 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
         }
 
         self->cur_packet_size = -1;
+      } else if (self->cur_packet_skip > 0) {
+        gint skip = MIN (avail, self->cur_packet_skip);
+
+        if (skip == 0)
+          break;
+
+        /* padding, options and trailing length of a pcapng block */
+        gst_adapter_flush (self->adapter, skip);
+        self->cur_packet_skip -= skip;
+      } else if (self->pcapng) {
+        if (!gst_pcap_parse_read_block (self, avail, &ret))
+          break;
       } else {
         guint32 ts_sec;
         guint32 ts_usec;
@@ -535,7 +1125,9 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
         gst_adapter_unmap (self->adapter);
         gst_adapter_flush (self->adapter, 16);
 
-        self->cur_ts = ts_sec * GST_SECOND + ts_usec * GST_USECOND;
+        /* ts_usec are nanoseconds in files with the nanosecond magic */
+        self->cur_ts = ts_sec * GST_SECOND +
+            ts_usec * (self->nsec_timestamps ? 1 : GST_USECOND);
         self->cur_packet_size = incl_len;
       }
     } else {
@@ -543,6 +1135,22 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       guint32 linktype;
       guint16 major_version;
 
+      if (avail < 4)
+        break;
+
+      data = gst_adapter_map (self->adapter, 4);
+      magic = GST_READ_UINT32_LE (data);
+      gst_adapter_unmap (self->adapter);
+
+      /* the section header block of a pcapng file is parsed like all other
+       * pcapng blocks */
+      if (magic == PCAPNG_BLOCK_SHB) {
+        GST_DEBUG_OBJECT (self, "pcapng file");
+        self->pcapng = TRUE;
+        self->initialized = TRUE;
+        continue;
+      }
+
       if (avail < 24)
         break;
 
@@ -553,23 +1161,25 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
       linktype = gst_pcap_parse_read_uint32 (self, data + 20);
       gst_adapter_unmap (self->adapter);
 
-      if (magic == 0xa1b2c3d4) {
+      if (magic == 0xa1b2c3d4 || magic == 0xa1b23c4d) {
         self->swap_endian = FALSE;
-      } else if (magic == 0xd4c3b2a1) {
+      } else if (magic == 0xd4c3b2a1 || magic == 0x4d3cb2a1) {
         self->swap_endian = TRUE;
         major_version = major_version << 8 | major_version >> 8;
       } else {
         GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
             ("File is not a libpcap file, magic is %X", magic));
         ret = GST_FLOW_ERROR;
-        goto out;
+        break;
       }
 
+      self->nsec_timestamps = magic == 0xa1b23c4d || magic == 0x4d3cb2a1;
+
       if (major_version != 2) {
         GST_ELEMENT_ERROR (self, STREAM, WRONG_TYPE, (NULL),
             ("File is not a libpcap major version 2, but %u", major_version));
         ret = GST_FLOW_ERROR;
-        goto out;
+        break;
       }
 
       if (linktype != LINKTYPE_ETHER && linktype != LINKTYPE_SLL &&
@@ -578,7 +1188,7 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
             ("Only dumps of type Ethernet, raw IP or Linux Cooked (SLL) "
                 "understood; type %d unknown", linktype));
         ret = GST_FLOW_ERROR;
-        goto out;
+        break;
       }
 
       GST_DEBUG_OBJECT (self, "linktype %u", linktype);
@@ -589,26 +1199,10 @@ gst_pcap_parse_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     }
   }
 
-  if (list) {
-    if (!self->newsegment_sent && GST_CLOCK_TIME_IS_VALID (self->cur_ts)) {
-      GstSegment segment;
-
-      if (self->caps)
-        gst_pad_set_caps (self->src_pad, self->caps);
-      gst_segment_init (&segment, GST_FORMAT_TIME);
-      segment.start = self->base_ts;
-      gst_pad_push_event (self->src_pad, gst_event_new_segment (&segment));
-      self->newsegment_sent = TRUE;
-    }
-
-    ret = gst_pad_push_list (self->src_pad, list);
-    list = NULL;
-  }
-
-out:
-
-  if (list)
-    gst_buffer_list_unref (list);
+  /* push what was collected, also if an error happened later on */
+  push_ret = gst_pcap_parse_push_pending (self, &list);
+  if (ret == GST_FLOW_OK)
+    ret = push_ret;
 
   return ret;
 }
@@ -624,12 +1218,28 @@ gst_pcap_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
       /* Drop it, we'll replace it with our own */
       gst_event_unref (event);
       break;
+    case GST_EVENT_STREAM_START:
+    case GST_EVENT_CAPS:
+      /* the pads of the flows have their own */
+      ret = gst_pad_push_event (self->src_pad, event);
+      break;
+    case GST_EVENT_FLUSH_START:
+      gst_pcap_parse_set_flushing (self, TRUE);
+      ret = gst_pad_event_default (pad, parent, event);
+      break;
     case GST_EVENT_FLUSH_STOP:
       gst_pcap_parse_reset (self);
+      gst_pcap_parse_set_flushing (self, FALSE);
       /* Push event down the pipeline so that other elements stop flushing */
+      ret = gst_pad_event_default (pad, parent, event);
+      break;
+    case GST_EVENT_EOS:
+      if (self->demux)
+        gst_element_no_more_pads (GST_ELEMENT_CAST (self));
       /* fall through */
     default:
-      ret = gst_pad_push_event (self->src_pad, event);
+      /* to the src pad and the pads of all flows */
+      ret = gst_pad_event_default (pad, parent, event);
       break;
   }
 
@@ -642,11 +1252,24 @@ gst_pcap_parse_change_state (GstElement * element, GstStateChange transition)
   GstPcapParse *self = GST_PCAP_PARSE (element);
   GstStateChangeReturn ret;
 
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      gst_pcap_parse_set_flushing (self, FALSE);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* stop waiting for the clock */
+      gst_pcap_parse_set_flushing (self, TRUE);
+      break;
+    default:
+      break;
+  }
+
   ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
 
   switch (transition) {
     case GST_STATE_CHANGE_PAUSED_TO_READY:
       gst_pcap_parse_reset (self);
+      gst_pcap_parse_remove_flows (self);
       break;
     default:
       break;
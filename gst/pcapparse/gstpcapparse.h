@@ -22,6 +22,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstadapter.h>
+#include <gst/base/gstflowcombiner.h>
 
 G_BEGIN_DECLS
 
@@ -73,17 +74,34 @@ struct _GstPcapParse
   gint32 dst_port;
   GstCaps *caps;
   gint64 offset;
+  gboolean demux;
+  gboolean sync;
 
   /* state */
   GstAdapter * adapter;
   gboolean initialized;
   gboolean swap_endian;
+  gboolean pcapng;
+  gboolean nsec_timestamps;
+  GArray * interfaces;
   gint64 cur_packet_size;
+  gint64 cur_packet_skip;
   GstClockTime cur_ts;
   GstClockTime base_ts;
   GstPcapParseLinktype linktype;
+  GstSegment segment;
 
   gboolean newsegment_sent;
+
+  /* demux mode, GstPcapParseFlow */
+  GHashTable * flows;
+  guint n_flows;
+  guint group_id;
+  GstFlowCombiner * flowcombiner;
+
+  /* sync mode, protected by the object lock */
+  GstClockID clock_id;
+  gboolean flushing;
 };
 
 struct _GstPcapParseClass
@@ -100,6 +100,11 @@
  *       timestamps will incorrectly include the overhead bytes.
  *     </para></listitem>
  * </listitem>
+ *
+ * In pull mode, the use-mmap property makes the parser map the file upstream
+ * reads from, if upstream is a filesrc, and serve its reads from the mapping.
+ * The output buffers then wrap the mapped file directly instead of data that
+ * was read() into newly allocated memory.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -107,6 +112,11 @@
 #endif
 
 #include <string.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 #include "gstrawbaseparse.h"
 
 
@@ -117,11 +127,13 @@ GST_DEBUG_CATEGORY_STATIC (raw_base_parse_debug);
 enum
 {
   PROP_0,
-  PROP_USE_SINK_CAPS
+  PROP_USE_SINK_CAPS,
+  PROP_USE_MMAP
 };
 
 
 #define DEFAULT_USE_SINK_CAPS  FALSE
+#define DEFAULT_USE_MMAP  FALSE
 #define INITIAL_PARSER_CONFIG \
   ((DEFAULT_USE_SINK_CAPS) ? GST_RAW_BASE_PARSE_CONFIG_SINKCAPS : \
    GST_RAW_BASE_PARSE_CONFIG_PROPERTIES)
@@ -194,6 +206,23 @@ gst_raw_base_parse_class_init (GstRawBaseParseClass * klass)
           "Use the sink caps for defining the output format",
           DEFAULT_USE_SINK_CAPS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)
       );
+  /**
+   * GstRawBaseParse::use-mmap:
+   *
+   * In pull mode, map the local file upstream reads from and output buffers
+   * wrapping the mapping instead of reading the data. The file must not be
+   * modified while it is being parsed. Falls back to normal reads if
+   * upstream is not a filesrc.
+   *
+   * Since: 1.12
+   */
+  g_object_class_install_property (object_class,
+      PROP_USE_MMAP,
+      g_param_spec_boolean ("use-mmap",
+          "Use mmap",
+          "Map the upstream file in pull mode instead of reading it",
+          DEFAULT_USE_MMAP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)
+      );
 }
 
 
@@ -201,6 +230,7 @@ static void
 gst_raw_base_parse_init (GstRawBaseParse * raw_base_parse)
 {
   raw_base_parse->src_caps_set = FALSE;
+  raw_base_parse->use_mmap = DEFAULT_USE_MMAP;
   g_mutex_init (&(raw_base_parse->config_mutex));
 }
 
@@ -285,6 +315,12 @@ gst_raw_base_parse_set_property (GObject * object, guint prop_id,
       break;
     }
 
+    case PROP_USE_MMAP:
+      GST_OBJECT_LOCK (object);
+      raw_base_parse->use_mmap = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (object);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -306,6 +342,12 @@ gst_raw_base_parse_get_property (GObject * object, guint prop_id,
       GST_RAW_BASE_PARSE_CONFIG_MUTEX_UNLOCK (object);
       break;
 
+    case PROP_USE_MMAP:
+      GST_OBJECT_LOCK (object);
+      g_value_set_boolean (value, raw_base_parse->use_mmap);
+      GST_OBJECT_UNLOCK (object);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -313,6 +355,159 @@ gst_raw_base_parse_get_property (GObject * object, guint prop_id,
 }
 
 
+static void
+gst_raw_base_parse_mmap_advise (GstRawBaseParse * raw_base_parse,
+    gsize offset, gsize size, gboolean sequential)
+{
+#if defined (HAVE_SYS_MMAN_H) && defined (MADV_WILLNEED)
+  guint8 *data = (guint8 *) g_mapped_file_get_contents (raw_base_parse->
+      mapped_file);
+  gsize page_mask = sysconf (_SC_PAGESIZE) - 1;
+  gsize start = offset & ~page_mask;
+
+  if (madvise (data + start, offset + size - start,
+          sequential ? MADV_SEQUENTIAL : MADV_WILLNEED) != 0)
+    GST_LOG_OBJECT (raw_base_parse, "madvise failed: %s", g_strerror (errno));
+#endif
+}
+
+/* Only a filesrc linked directly to the sink pad reads its data unchanged
+ * from the file its URI names. Other elements may answer the URI query
+ * for data they transform, so their data can't be replaced by the file */
+static gboolean
+gst_raw_base_parse_upstream_is_filesrc (GstPad * peer)
+{
+  GstElement *upstream;
+  GstElementFactory *factory;
+  gboolean res = FALSE;
+
+  upstream = gst_pad_get_parent_element (peer);
+  if (upstream == NULL)
+    return FALSE;
+
+  factory = gst_element_get_factory (upstream);
+  if (factory != NULL)
+    res = !g_strcmp0 (gst_plugin_feature_get_name (GST_PLUGIN_FEATURE
+            (factory)), "filesrc");
+  gst_object_unref (upstream);
+
+  return res;
+}
+
+static GMappedFile *
+gst_raw_base_parse_map_upstream_file (GstRawBaseParse * raw_base_parse)
+{
+  GstQuery *query;
+  GstPad *peer;
+  GMappedFile *mapped_file;
+  GError *err = NULL;
+  gchar *uri = NULL, *filename;
+
+  peer = gst_pad_get_peer (GST_BASE_PARSE_SINK_PAD (raw_base_parse));
+  if (peer == NULL)
+    return NULL;
+
+  if (!gst_raw_base_parse_upstream_is_filesrc (peer)) {
+    GST_DEBUG_OBJECT (raw_base_parse, "upstream is not a filesrc, "
+        "not using mmap");
+    gst_object_unref (peer);
+    return NULL;
+  }
+
+  query = gst_query_new_uri ();
+  if (gst_pad_query (peer, query))
+    gst_query_parse_uri (query, &uri);
+  gst_query_unref (query);
+  gst_object_unref (peer);
+
+  if (uri == NULL || !gst_uri_has_protocol (uri, "file")) {
+    GST_DEBUG_OBJECT (raw_base_parse, "upstream is not a local file (%s), "
+        "not using mmap", GST_STR_NULL (uri));
+    g_free (uri);
+    return NULL;
+  }
+
+  filename = g_filename_from_uri (uri, NULL, NULL);
+  g_free (uri);
+  if (filename == NULL)
+    return NULL;
+
+  mapped_file = g_mapped_file_new (filename, FALSE, &err);
+  if (mapped_file == NULL) {
+    GST_WARNING_OBJECT (raw_base_parse, "could not map %s: %s", filename,
+        err->message);
+    g_clear_error (&err);
+  } else {
+    GST_DEBUG_OBJECT (raw_base_parse, "mapped %s, %" G_GSIZE_FORMAT " bytes",
+        filename, g_mapped_file_get_length (mapped_file));
+  }
+  g_free (filename);
+
+  return mapped_file;
+}
+
+/* Pulls on the sink pad are answered with buffers wrapping the mapped file
+ * before upstream is asked for the data. A probe that sets the data and
+ * drops the pull makes gst_pad_pull_range() return that buffer, and no
+ * buffer makes it return EOS. If the file can't be mapped, the probe
+ * removes itself and all pulls go upstream */
+static GstPadProbeReturn
+gst_raw_base_parse_mmap_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstRawBaseParse *raw_base_parse = GST_RAW_BASE_PARSE (user_data);
+  GstBuffer *buffer;
+  guint8 *data;
+  gsize file_size, size;
+
+  /* ignore the probe after the pull, and pulls into a caller buffer */
+  if (GST_PAD_PROBE_INFO_DATA (info) != NULL)
+    return GST_PAD_PROBE_OK;
+
+  if (!raw_base_parse->mmap_checked) {
+    raw_base_parse->mmap_checked = TRUE;
+    raw_base_parse->mapped_file =
+        gst_raw_base_parse_map_upstream_file (raw_base_parse);
+    if (raw_base_parse->mapped_file)
+      gst_raw_base_parse_mmap_advise (raw_base_parse, 0,
+          g_mapped_file_get_length (raw_base_parse->mapped_file), TRUE);
+  }
+
+  if (raw_base_parse->mapped_file == NULL) {
+    GST_OBJECT_LOCK (raw_base_parse);
+    raw_base_parse->mmap_probe_id = 0;
+    GST_OBJECT_UNLOCK (raw_base_parse);
+    return GST_PAD_PROBE_REMOVE;
+  }
+
+  file_size = g_mapped_file_get_length (raw_base_parse->mapped_file);
+  if (GST_PAD_PROBE_INFO_OFFSET (info) >= file_size) {
+    GST_DEBUG_OBJECT (raw_base_parse, "pull beyond the end of the file");
+    return GST_PAD_PROBE_DROP;
+  }
+
+  size = MIN (GST_PAD_PROBE_INFO_SIZE (info),
+      file_size - GST_PAD_PROBE_INFO_OFFSET (info));
+  data = (guint8 *) g_mapped_file_get_contents (raw_base_parse->mapped_file);
+
+  gst_raw_base_parse_mmap_advise (raw_base_parse,
+      GST_PAD_PROBE_INFO_OFFSET (info), size, FALSE);
+
+  buffer = gst_buffer_new ();
+  gst_buffer_append_memory (buffer,
+      gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY, data, file_size,
+          GST_PAD_PROBE_INFO_OFFSET (info), size,
+          g_mapped_file_ref (raw_base_parse->mapped_file),
+          (GDestroyNotify) g_mapped_file_unref));
+  GST_BUFFER_OFFSET (buffer) = GST_PAD_PROBE_INFO_OFFSET (info);
+  GST_BUFFER_OFFSET_END (buffer) = GST_PAD_PROBE_INFO_OFFSET (info) + size;
+
+  GST_PAD_PROBE_INFO_DATA (info) = buffer;
+
+  return GST_PAD_PROBE_DROP;
+}
+
+
 static gboolean
 gst_raw_base_parse_start (GstBaseParse * parse)
 {
@@ -335,6 +530,16 @@ gst_raw_base_parse_start (GstBaseParse * parse)
 
   GST_RAW_BASE_PARSE_CONFIG_MUTEX_UNLOCK (raw_base_parse);
 
+  /* the probe only ever sees pulls, so it is harmless in push mode */
+  GST_OBJECT_LOCK (raw_base_parse);
+  if (raw_base_parse->use_mmap) {
+    raw_base_parse->mmap_probe_id =
+        gst_pad_add_probe (GST_BASE_PARSE_SINK_PAD (parse),
+        GST_PAD_PROBE_TYPE_PULL, gst_raw_base_parse_mmap_probe, raw_base_parse,
+        NULL);
+  }
+  GST_OBJECT_UNLOCK (raw_base_parse);
+
   return TRUE;
 }
 
@@ -348,6 +553,19 @@ gst_raw_base_parse_stop (GstBaseParse * parse)
   raw_base_parse->src_caps_set = FALSE;
   GST_RAW_BASE_PARSE_CONFIG_MUTEX_UNLOCK (raw_base_parse);
 
+  GST_OBJECT_LOCK (raw_base_parse);
+  if (raw_base_parse->mmap_probe_id != 0) {
+    gst_pad_remove_probe (GST_BASE_PARSE_SINK_PAD (parse),
+        raw_base_parse->mmap_probe_id);
+    raw_base_parse->mmap_probe_id = 0;
+  }
+  GST_OBJECT_UNLOCK (raw_base_parse);
+  if (raw_base_parse->mapped_file) {
+    g_mapped_file_unref (raw_base_parse->mapped_file);
+    raw_base_parse->mapped_file = NULL;
+  }
+  raw_base_parse->mmap_checked = FALSE;
+
   return TRUE;
 }
 
@@ -82,6 +82,12 @@ struct _GstRawBaseParse
 
   /* Mutex which protects access to and modifications on the configs. */
   GMutex config_mutex;
+
+  /* Pull mode reads served from a mapping of the upstream file */
+  gboolean use_mmap;
+  gulong mmap_probe_id;
+  gboolean mmap_checked;
+  GMappedFile *mapped_file;
 };
 
 
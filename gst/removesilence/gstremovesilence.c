@@ -23,6 +23,17 @@
  *
  * Removes all silence periods from an audio stream, dropping silence buffers.
  *
+ * Multichannel streams are downmixed for detection, or with
+ * #GstRemoveSilence:per-channel each channel is looked at separately and
+ * the stream is silent when all of them are.
+ *
+ * With #GstRemoveSilence:silent set to %FALSE, the start and the end of
+ * each silence period are reported with a "removesilence" element message
+ * and a custom downstream event of the same structure. It has a
+ * "silence-detected" or a "silence-finished" field with the timestamp of
+ * the transition. Together with remove=false, this can be used to split
+ * the stream without losing any audio. The stream starts out silent.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -35,6 +46,8 @@
 #include "config.h"
 #endif
 
+#include <string.h>
+
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
 #include <gst/audio/audio.h>
@@ -45,6 +58,9 @@
 GST_DEBUG_CATEGORY_STATIC (gst_remove_silence_debug);
 #define GST_CAT_DEFAULT gst_remove_silence_debug
 #define DEFAULT_VAD_HYSTERESIS  480     /* 60 mseg */
+#define DEFAULT_VAD_THRESHOLD   -60
+#define DEFAULT_PER_CHANNEL     FALSE
+#define DEFAULT_SILENT          TRUE
 
 /* Filter signals and args */
 enum
@@ -57,25 +73,28 @@ enum
 {
   PROP_0,
   PROP_REMOVE,
-  PROP_HYSTERESIS
+  PROP_HYSTERESIS,
+  PROP_THRESHOLD,
+  PROP_PER_CHANNEL,
+  PROP_SILENT
 };
 
 
+#define CAPS_STR \
+    "audio/x-raw, " \
+    "format = (string) { " GST_AUDIO_NE (S16) ", " GST_AUDIO_NE (F32) " }, " \
+    "layout = (string) interleaved, " \
+    "rate = (int) [ 1, MAX ], " "channels = (int) [ 1, MAX ]"
+
 static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
-        "layout = (string) interleaved, "
-        "rate = (int) [ 1, MAX ], " "channels = (int) 1"));
+    GST_STATIC_CAPS (CAPS_STR));
 
 static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
-    GST_STATIC_CAPS ("audio/x-raw, "
-        "format = (string) " GST_AUDIO_NE (S16) ", "
-        "layout = (string) interleaved, "
-        "rate = (int) [ 1, MAX ], " "channels = (int) 1"));
+    GST_STATIC_CAPS (CAPS_STR));
 
 
 #define DEBUG_INIT(bla) \
@@ -90,6 +109,9 @@ static void gst_remove_silence_set_property (GObject * object, guint prop_id,
 static void gst_remove_silence_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 
+static gboolean gst_remove_silence_start (GstBaseTransform * trans);
+static gboolean gst_remove_silence_set_caps (GstBaseTransform * trans,
+    GstCaps * incaps, GstCaps * outcaps);
 static GstFlowReturn gst_remove_silence_transform_ip (GstBaseTransform * base,
     GstBuffer * buf);
 static void gst_remove_silence_finalize (GObject * obj);
@@ -121,6 +143,25 @@ gst_remove_silence_class_init (GstRemoveSilenceClass * klass)
           "Set the hysteresis (on samples) used on the internal VAD",
           1, G_MAXUINT64, DEFAULT_VAD_HYSTERESIS, G_PARAM_READWRITE));
 
+  g_object_class_install_property (gobject_class, PROP_THRESHOLD,
+      g_param_spec_int ("threshold",
+          "Threshold",
+          "Set the power (in dB of full scale) below which the internal VAD "
+          "considers the audio silent", -90, 0, DEFAULT_VAD_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PER_CHANNEL,
+      g_param_spec_boolean ("per-channel", "Per channel",
+          "Detect voice on each channel instead of on the downmixed stream",
+          DEFAULT_PER_CHANNEL,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SILENT,
+      g_param_spec_boolean ("silent", "Silent",
+          "Don't report the silence periods with messages and events",
+          DEFAULT_SILENT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "RemoveSilence",
       "Filter/Effect/Audio",
@@ -131,6 +172,10 @@ gst_remove_silence_class_init (GstRemoveSilenceClass * klass)
   gst_element_class_add_static_pad_template (gstelement_class, &src_template);
   gst_element_class_add_static_pad_template (gstelement_class, &sink_template);
 
+  GST_BASE_TRANSFORM_CLASS (klass)->start =
+      GST_DEBUG_FUNCPTR (gst_remove_silence_start);
+  GST_BASE_TRANSFORM_CLASS (klass)->set_caps =
+      GST_DEBUG_FUNCPTR (gst_remove_silence_set_caps);
   GST_BASE_TRANSFORM_CLASS (klass)->transform_ip =
       GST_DEBUG_FUNCPTR (gst_remove_silence_transform_ip);
 }
@@ -143,23 +188,35 @@ gst_remove_silence_class_init (GstRemoveSilenceClass * klass)
 static void
 gst_remove_silence_init (GstRemoveSilence * filter)
 {
-  filter->vad = vad_new (DEFAULT_VAD_HYSTERESIS);
   filter->remove = FALSE;
+  filter->hysteresis = DEFAULT_VAD_HYSTERESIS;
+  filter->threshold = DEFAULT_VAD_THRESHOLD;
+  filter->per_channel = DEFAULT_PER_CHANNEL;
+  filter->silent = DEFAULT_SILENT;
+  filter->state = VAD_SILENCE;
+  gst_audio_info_init (&filter->info);
+}
 
-  if (!filter->vad) {
-    GST_DEBUG ("Error initializing VAD !!");
-    return;
-  }
+static void
+gst_remove_silence_free_vads (GstRemoveSilence * filter)
+{
+  guint i;
+
+  GST_DEBUG ("Destroying VAD");
+  for (i = 0; i < filter->n_vads; i++)
+    vad_destroy (filter->vads[i]);
+  g_free (filter->vads);
+  filter->vads = NULL;
+  filter->n_vads = 0;
+  g_free (filter->block);
+  filter->block = NULL;
 }
 
 static void
 gst_remove_silence_finalize (GObject * obj)
 {
   GstRemoveSilence *filter = GST_REMOVE_SILENCE (obj);
-  GST_DEBUG ("Destroying VAD");
-  vad_destroy (filter->vad);
-  filter->vad = NULL;
-  GST_DEBUG ("VAD Destroyed");
+  gst_remove_silence_free_vads (filter);
   G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
 
@@ -168,13 +225,31 @@ gst_remove_silence_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
   GstRemoveSilence *filter = GST_REMOVE_SILENCE (object);
+  guint i;
 
   switch (prop_id) {
     case PROP_REMOVE:
       filter->remove = g_value_get_boolean (value);
       break;
     case PROP_HYSTERESIS:
-      vad_set_hysteresis (filter->vad, g_value_get_uint64 (value));
+      GST_OBJECT_LOCK (filter);
+      filter->hysteresis = g_value_get_uint64 (value);
+      for (i = 0; i < filter->n_vads; i++)
+        vad_set_hysteresis (filter->vads[i], filter->hysteresis);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_THRESHOLD:
+      GST_OBJECT_LOCK (filter);
+      filter->threshold = g_value_get_int (value);
+      for (i = 0; i < filter->n_vads; i++)
+        vad_set_threshold (filter->vads[i], filter->threshold);
+      GST_OBJECT_UNLOCK (filter);
+      break;
+    case PROP_PER_CHANNEL:
+      filter->per_channel = g_value_get_boolean (value);
+      break;
+    case PROP_SILENT:
+      filter->silent = g_value_get_boolean (value);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -193,7 +268,16 @@ gst_remove_silence_get_property (GObject * object, guint prop_id,
       g_value_set_boolean (value, filter->remove);
       break;
     case PROP_HYSTERESIS:
-      g_value_set_uint64 (value, vad_get_hysteresis (filter->vad));
+      g_value_set_uint64 (value, filter->hysteresis);
+      break;
+    case PROP_THRESHOLD:
+      g_value_set_int (value, filter->threshold);
+      break;
+    case PROP_PER_CHANNEL:
+      g_value_set_boolean (value, filter->per_channel);
+      break;
+    case PROP_SILENT:
+      g_value_set_boolean (value, filter->silent);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -201,21 +285,192 @@ gst_remove_silence_get_property (GObject * object, guint prop_id,
   }
 }
 
+static gboolean
+gst_remove_silence_start (GstBaseTransform * trans)
+{
+  GstRemoveSilence *filter = GST_REMOVE_SILENCE (trans);
+  guint i;
+
+  for (i = 0; i < filter->n_vads; i++)
+    vad_reset (filter->vads[i]);
+  filter->state = VAD_SILENCE;
+  filter->offset = 0;
+
+  return TRUE;
+}
+
+static gboolean
+gst_remove_silence_set_caps (GstBaseTransform * trans, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  GstRemoveSilence *filter = GST_REMOVE_SILENCE (trans);
+  GstAudioInfo info;
+  guint n_vads, i;
+
+  if (!gst_audio_info_from_caps (&info, incaps)) {
+    GST_ERROR_OBJECT (filter, "invalid caps %" GST_PTR_FORMAT, incaps);
+    return FALSE;
+  }
+
+  n_vads = filter->per_channel ? GST_AUDIO_INFO_CHANNELS (&info) : 1;
+
+  /* keep the state going if only the rate changes */
+  if (filter->vads && n_vads == filter->n_vads &&
+      GST_AUDIO_INFO_FORMAT (&info) == GST_AUDIO_INFO_FORMAT (&filter->info)
+      && GST_AUDIO_INFO_CHANNELS (&info) ==
+      GST_AUDIO_INFO_CHANNELS (&filter->info)) {
+    filter->info = info;
+    return TRUE;
+  }
+
+  GST_OBJECT_LOCK (filter);
+  gst_remove_silence_free_vads (filter);
+
+  filter->info = info;
+  filter->n_vads = n_vads;
+  filter->vads = g_new (VADFilter *, filter->n_vads);
+  for (i = 0; i < filter->n_vads; i++)
+    filter->vads[i] = vad_new (filter->hysteresis, filter->threshold);
+  filter->block = g_new (gfloat, filter->n_vads * VAD_BLOCK_SIZE);
+  GST_OBJECT_UNLOCK (filter);
+
+  filter->state = VAD_SILENCE;
+
+  GST_DEBUG_OBJECT (filter, "running %u VADs", filter->n_vads);
+
+  return TRUE;
+}
+
+/* Converts @frames frames to floats, either downmixed or deinterleaved into
+ * one block per channel */
+static void
+gst_remove_silence_fill_block (GstRemoveSilence * filter, const guint8 * data,
+    gint frames)
+{
+  gint channels = GST_AUDIO_INFO_CHANNELS (&filter->info);
+  gfloat *block = filter->block;
+  gfloat scale;
+  gint i, c;
+
+  if (GST_AUDIO_INFO_FORMAT (&filter->info) == GST_AUDIO_FORMAT_S16) {
+    const gint16 *in = (const gint16 *) data;
+
+    scale = 1.0f / 32768;
+    if (filter->n_vads > 1) {
+      for (c = 0; c < channels; c++)
+        for (i = 0; i < frames; i++)
+          block[c * VAD_BLOCK_SIZE + i] = in[i * channels + c] * scale;
+    } else if (channels == 1) {
+      for (i = 0; i < frames; i++)
+        block[i] = in[i] * scale;
+    } else {
+      scale /= channels;
+      for (i = 0; i < frames; i++) {
+        gint sum = 0;
+
+        for (c = 0; c < channels; c++)
+          sum += in[i * channels + c];
+        block[i] = sum * scale;
+      }
+    }
+  } else {
+    const gfloat *in = (const gfloat *) data;
+
+    if (filter->n_vads > 1) {
+      for (c = 0; c < channels; c++)
+        for (i = 0; i < frames; i++)
+          block[c * VAD_BLOCK_SIZE + i] = in[i * channels + c];
+    } else if (channels == 1) {
+      memcpy (block, in, frames * sizeof (gfloat));
+    } else {
+      scale = 1.0f / channels;
+      for (i = 0; i < frames; i++) {
+        gfloat sum = 0;
+
+        for (c = 0; c < channels; c++)
+          sum += in[i * channels + c];
+        block[i] = sum * scale;
+      }
+    }
+  }
+}
+
+/* Posts and pushes downstream the change to filter->state at @frame of
+ * @buf */
+static void
+gst_remove_silence_report (GstRemoveSilence * filter, GstBuffer * buf,
+    gint frame)
+{
+  gint rate = GST_AUDIO_INFO_RATE (&filter->info);
+  GstClockTime ts;
+  GstStructure *s;
+
+  if (GST_BUFFER_PTS_IS_VALID (buf))
+    ts = GST_BUFFER_PTS (buf) +
+        gst_util_uint64_scale_int (frame, GST_SECOND, rate);
+  else
+    ts = gst_util_uint64_scale_int (filter->offset + frame, GST_SECOND, rate);
+
+  GST_DEBUG_OBJECT (filter, "silence %s at %" GST_TIME_FORMAT,
+      filter->state == VAD_SILENCE ? "detected" : "finished",
+      GST_TIME_ARGS (ts));
+
+  s = gst_structure_new ("removesilence",
+      filter->state == VAD_SILENCE ? "silence-detected" : "silence-finished",
+      G_TYPE_UINT64, ts, NULL);
+
+  gst_pad_push_event (GST_BASE_TRANSFORM_SRC_PAD (filter),
+      gst_event_new_custom (GST_EVENT_CUSTOM_DOWNSTREAM,
+          gst_structure_copy (s)));
+  gst_element_post_message (GST_ELEMENT (filter),
+      gst_message_new_element (GST_OBJECT (filter), s));
+}
+
 static GstFlowReturn
 gst_remove_silence_transform_ip (GstBaseTransform * trans, GstBuffer * inbuf)
 {
   GstRemoveSilence *filter = NULL;
-  int frame_type;
   GstMapInfo map;
+  gint bpf, frames, offset, n;
+  guint i;
 
   filter = GST_REMOVE_SILENCE (trans);
 
+  if (!filter->vads) {
+    GST_ELEMENT_ERROR (filter, CORE, NEGOTIATION, (NULL),
+        ("no format negotiated"));
+    return GST_FLOW_NOT_NEGOTIATED;
+  }
+
+  bpf = GST_AUDIO_INFO_BPF (&filter->info);
+
   gst_buffer_map (inbuf, &map, GST_MAP_READ);
-  frame_type =
-      vad_update (filter->vad, (gint16 *) map.data, map.size / sizeof (gint16));
+  frames = map.size / bpf;
+
+  /* the VADs are updated a block at a time, so that the silence periods
+   * are found with that precision within large buffers */
+  for (offset = 0; offset < frames; offset += n) {
+    gint frame_type = VAD_SILENCE;
+
+    n = MIN (frames - offset, VAD_BLOCK_SIZE);
+    gst_remove_silence_fill_block (filter, map.data + offset * bpf, n);
+    for (i = 0; i < filter->n_vads; i++) {
+      if (vad_update (filter->vads[i], filter->block + i * VAD_BLOCK_SIZE,
+              n) == VAD_VOICE)
+        frame_type = VAD_VOICE;
+    }
+
+    if (frame_type != filter->state) {
+      filter->state = frame_type;
+      if (!filter->silent)
+        gst_remove_silence_report (filter, inbuf, offset);
+    }
+  }
   gst_buffer_unmap (inbuf, &map);
 
-  if (frame_type == VAD_SILENCE) {
+  filter->offset += frames;
+
+  if (filter->state == VAD_SILENCE) {
     GST_DEBUG ("Silence detected");
 
     if (filter->remove) {
@@ -227,7 +482,6 @@ gst_remove_silence_transform_ip (GstBaseTransform * trans, GstBuffer * inbuf)
 
   return GST_FLOW_OK;
 }
-
 /*Plugin init functions*/
 static gboolean
 plugin_init (GstPlugin * plugin)
@@ -24,6 +24,7 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
 #include "vad_private.h"
 
 G_BEGIN_DECLS
@@ -41,8 +42,22 @@ G_BEGIN_DECLS
 
 typedef struct _GstRemoveSilence {
   GstBaseTransform parent;
-  VADFilter* vad;
   gboolean remove;
+  guint64 hysteresis;
+  gint threshold;
+  gboolean per_channel;
+  gboolean silent;
+
+  GstAudioInfo info;
+  /* one for the downmixed stream or one per channel */
+  VADFilter** vads;
+  guint n_vads;
+  /* a block of samples for each VAD */
+  gfloat* block;
+  /* voice when any of the VADs detects voice */
+  gint state;
+  /* frames since start, for timestamping buffers without one */
+  guint64 offset;
 } GstRemoveSilence;
 
 typedef struct _GstRemoveSilenceClass {
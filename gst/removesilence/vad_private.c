@@ -22,63 +22,68 @@
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <glib.h>
 #include "vad_private.h"
 
-#define VAD_POWER_ALPHA     0x0800      /* Q16 */
-#define VAD_POWER_THRESHOLD 0x000010C7  /* -60 dB (square wave) */
-#define VAD_ZCR_THRESHOLD   0
-#define VAD_BUFFER_SIZE     256
-
-
-union pgen
-{
-  guint64 a;
-  gpointer v;
-  guint64 *l;
-  guchar *b;
-  guint16 *w;
-  gint16 *s;
-};
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
-struct _cqueue_s
-{
-  union pgen base;
-  union pgen tail;
-  union pgen head;
-  gint size;
-};
+/* the power is smoothed over the samples by p = (1 - a) * p + a * x^2 */
+#define VAD_POWER_ALPHA     (1.0f / 32)
+#define VAD_ZCR_THRESHOLD   0
 
-typedef struct _cqueue_s cqueue_t;
 
 struct _vad_s
 {
-  gint16 vad_buffer[VAD_BUFFER_SIZE];
-  cqueue_t cqueue;
+  /* the last VAD_BLOCK_SIZE samples, followed by room for a new block */
+  gfloat history[2 * VAD_BLOCK_SIZE];
+  gint history_len;
   gint vad_state;
   guint64 hysteresis;
+  gint threshold;
+  gfloat power_threshold;
   guint64 vad_samples;
-  guint64 vad_power;
-  long vad_zcr;
+  gfloat vad_power;
+  gint vad_zcr;
+
+  /* weights[VAD_BLOCK_SIZE - n + k] is the weight of sample k of a block of
+   * n samples in the power after it, decay[n] the one of the power before
+   * it */
+  gfloat weights[VAD_BLOCK_SIZE];
+  gfloat decay[VAD_BLOCK_SIZE + 1];
 };
 
 VADFilter *
-vad_new (guint64 hysteresis)
+vad_new (guint64 hysteresis, gint threshold)
 {
   VADFilter *vad = malloc (sizeof (VADFilter));
+  gint i;
+
+  vad->decay[0] = 1.0f;
+  for (i = 1; i <= VAD_BLOCK_SIZE; i++)
+    vad->decay[i] = vad->decay[i - 1] * (1.0f - VAD_POWER_ALPHA);
+  for (i = 0; i < VAD_BLOCK_SIZE; i++)
+    vad->weights[i] = VAD_POWER_ALPHA * vad->decay[VAD_BLOCK_SIZE - 1 - i];
+
   vad_reset (vad);
   vad->hysteresis = hysteresis;
+  vad_set_threshold (vad, threshold);
   return vad;
 }
 
 void
 vad_reset (VADFilter * vad)
 {
-  memset (vad, 0, sizeof (*vad));
-  vad->cqueue.base.s = vad->vad_buffer;
-  vad->cqueue.tail.a = vad->cqueue.head.a = 0;
-  vad->cqueue.size = VAD_BUFFER_SIZE;
+  memset (vad->history, 0, sizeof (vad->history));
+  vad->history_len = 0;
   vad->vad_state = VAD_SILENCE;
+  vad->vad_samples = 0;
+  vad->vad_power = 0;
+  vad->vad_zcr = 0;
 }
 
 void
@@ -99,37 +104,135 @@ vad_get_hysteresis (struct _vad_s *p)
   return p->hysteresis;
 }
 
+/* in dB of the power of a full scale square wave */
+void
+vad_set_threshold (struct _vad_s *p, gint threshold)
+{
+  p->threshold = threshold;
+  p->power_threshold = pow (10, threshold / 10.0);
+}
+
 gint
-vad_update (struct _vad_s * p, gint16 * data, gint len)
+vad_get_threshold (struct _vad_s *p)
 {
-  guint64 tail;
-  gint frame_type;
-  gint16 sample;
-  gint i;
+  return p->threshold;
+}
 
-  for (i = 0; i < len; i++) {
-    p->vad_power = VAD_POWER_ALPHA * ((data[i] * data[i] >> 14) & 0xFFFF) +
-        (0xFFFF - VAD_POWER_ALPHA) * (p->vad_power >> 16) +
-        ((0xFFFF - VAD_POWER_ALPHA) * (p->vad_power & 0xFFFF) >> 16);
-    /* Update VAD buffer */
-    p->cqueue.base.s[p->cqueue.head.a] = data[i];
-    p->cqueue.head.a = (p->cqueue.head.a + 1) & (p->cqueue.size - 1);
-    if (p->cqueue.head.a == p->cqueue.tail.a)
-      p->cqueue.tail.a = (p->cqueue.tail.a + 1) & (p->cqueue.size - 1);
+/* sum of weights[i] * data[i]^2 */
+static gfloat
+vad_weighted_power (const gfloat * weights, const gfloat * data, gint len)
+{
+  gfloat sum = 0;
+  gint i = 0;
+
+#if defined (__SSE2__)
+  {
+    __m128 acc = _mm_setzero_ps ();
+    gfloat tmp[4];
+
+    for (; i + 4 <= len; i += 4) {
+      __m128 x = _mm_loadu_ps (data + i);
+      acc = _mm_add_ps (acc, _mm_mul_ps (_mm_loadu_ps (weights + i),
+              _mm_mul_ps (x, x)));
+    }
+    _mm_storeu_ps (tmp, acc);
+    sum = tmp[0] + tmp[1] + tmp[2] + tmp[3];
   }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    float32x4_t acc = vdupq_n_f32 (0);
+    float32x2_t acc2;
+
+    for (; i + 4 <= len; i += 4) {
+      float32x4_t x = vld1q_f32 (data + i);
+      acc = vmlaq_f32 (acc, vld1q_f32 (weights + i), vmulq_f32 (x, x));
+    }
+    acc2 = vadd_f32 (vget_low_f32 (acc), vget_high_f32 (acc));
+    sum = vget_lane_f32 (vpadd_f32 (acc2, acc2), 0);
+  }
+#endif
+
+  for (; i < len; i++)
+    sum += weights[i] * data[i] * data[i];
 
-  tail = p->cqueue.tail.a;
-  p->vad_zcr = 0;
-  for (;;) {
-    sample = p->cqueue.base.s[tail];
-    tail = (tail + 1) & (p->cqueue.size - 1);
-    if (tail == p->cqueue.head.a)
-      break;
-    p->vad_zcr +=
-        ((sample & 0x8000) != (p->cqueue.base.s[tail] & 0x8000)) ? 1 : -1;
+  return sum;
+}
+
+/* number of sign changes between neighbouring samples */
+static gint
+vad_sign_changes (const gfloat * data, gint len)
+{
+  gint changes = 0;
+  gint i = 0;
+
+#if defined (__SSE2__)
+  {
+    const __m128 zero = _mm_setzero_ps ();
+    __m128i acc = _mm_setzero_si128 ();
+    gint32 tmp[4];
+
+    for (; i + 5 <= len; i += 4) {
+      __m128 a = _mm_cmplt_ps (_mm_loadu_ps (data + i), zero);
+      __m128 b = _mm_cmplt_ps (_mm_loadu_ps (data + i + 1), zero);
+
+      /* -1 for each change */
+      acc = _mm_sub_epi32 (acc, _mm_castps_si128 (_mm_xor_ps (a, b)));
+    }
+    _mm_storeu_si128 ((__m128i *) tmp, acc);
+    changes = tmp[0] + tmp[1] + tmp[2] + tmp[3];
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    const float32x4_t zero = vdupq_n_f32 (0);
+    uint32x4_t acc = vdupq_n_u32 (0);
+    uint32x2_t acc2;
+
+    for (; i + 5 <= len; i += 4) {
+      uint32x4_t a = vcltq_f32 (vld1q_f32 (data + i), zero);
+      uint32x4_t b = vcltq_f32 (vld1q_f32 (data + i + 1), zero);
+
+      /* all bits set for each change */
+      acc = vsubq_u32 (acc, veorq_u32 (a, b));
+    }
+    acc2 = vadd_u32 (vget_low_u32 (acc), vget_high_u32 (acc));
+    changes = vget_lane_u32 (vpadd_u32 (acc2, acc2), 0);
+  }
+#endif
+
+  for (; i + 1 < len; i++)
+    changes += (data[i] < 0) != (data[i + 1] < 0);
+
+  return changes;
+}
+
+/* Takes up to VAD_BLOCK_SIZE samples, normalized to [-1, 1] */
+gint
+vad_update (struct _vad_s * p, const gfloat * data, gint len)
+{
+  gint frame_type;
+  gint window;
+
+  g_return_val_if_fail (len >= 0 && len <= VAD_BLOCK_SIZE, p->vad_state);
+
+  p->vad_power = p->decay[len] * p->vad_power +
+      vad_weighted_power (p->weights + VAD_BLOCK_SIZE - len, data, len);
+
+  /* Update VAD buffer, the zero crossings are counted over the last
+   * VAD_BLOCK_SIZE - 1 samples: +1 for each sign change, -1 for each pair
+   * without */
+  memcpy (p->history + VAD_BLOCK_SIZE, data, len * sizeof (gfloat));
+  p->history_len = MIN (p->history_len + len, VAD_BLOCK_SIZE - 1);
+  window = p->history_len;
+  if (window > 1) {
+    const gfloat *start = p->history + VAD_BLOCK_SIZE + len - window;
+
+    p->vad_zcr = 2 * vad_sign_changes (start, window) - (window - 1);
+  } else {
+    p->vad_zcr = 0;
   }
+  memmove (p->history, p->history + len, VAD_BLOCK_SIZE * sizeof (gfloat));
 
-  frame_type = (p->vad_power > VAD_POWER_THRESHOLD
+  frame_type = (p->vad_power > p->power_threshold
       && p->vad_zcr < VAD_ZCR_THRESHOLD) ? VAD_VOICE : VAD_SILENCE;
 
   if (p->vad_state != frame_type) {
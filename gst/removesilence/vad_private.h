@@ -23,19 +23,29 @@
 #ifndef __VAD_FILTER_H__
 #define __VAD_FILTER_H__
 
+#include <glib.h>
+
 #define VAD_SILENCE  0
 #define VAD_VOICE    1
 
+/* samples over which the zero crossings are counted, also the most
+ * samples vad_update() takes at once */
+#define VAD_BLOCK_SIZE 256
+
 
 typedef struct _vad_s VADFilter;
 
-gint vad_update(VADFilter *p, gint16 *data, gint len);
+gint vad_update(VADFilter *p, const gfloat *data, gint len);
 
 void vad_set_hysteresis(VADFilter *p, guint64 hysteresis);
 
 guint64 vad_get_hysteresis(VADFilter *p);
 
-VADFilter* vad_new(guint64 hysteresis);
+void vad_set_threshold(VADFilter *p, gint threshold);
+
+gint vad_get_threshold(VADFilter *p);
+
+VADFilter* vad_new(guint64 hysteresis, gint threshold);
 
 void vad_reset(VADFilter *p);
 
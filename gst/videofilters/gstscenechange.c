@@ -32,6 +32,12 @@
  *
  * The scenechange element does not work with compressed video.
  *
+ * By default the luma planes of consecutive frames are compared pixel by
+ * pixel. For high resolution video, #GstSceneChange:line-step makes it
+ * compare only every few lines, and #GstSceneChange:method can select a
+ * comparison of luma histograms instead, which does not need to keep the
+ * previous frame around.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -83,12 +89,23 @@
 #include <string.h>
 #include "gstscenechange.h"
 
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_scene_change_debug_category);
 #define GST_CAT_DEFAULT gst_scene_change_debug_category
 
 /* prototypes */
 
 
+static void gst_scene_change_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_scene_change_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static gboolean gst_scene_change_stop (GstBaseTransform * trans);
 static GstFlowReturn gst_scene_change_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
 
@@ -99,12 +116,37 @@ static gboolean is_shot_change (int frame_number);
 
 enum
 {
-  PROP_0
+  PROP_0,
+  PROP_METHOD,
+  PROP_LINE_STEP
 };
 
+#define DEFAULT_METHOD GST_SCENE_CHANGE_METHOD_SAD
+#define DEFAULT_LINE_STEP 1
+
 #define VIDEO_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, Y42B, Y41B, Y444 }")
 
+#define GST_TYPE_SCENE_CHANGE_METHOD (gst_scene_change_method_get_type ())
+static GType
+gst_scene_change_method_get_type (void)
+{
+  static GType method_type = 0;
+
+  static const GEnumValue method_types[] = {
+    {GST_SCENE_CHANGE_METHOD_SAD, "Sum of absolute luma differences", "sad"},
+    {GST_SCENE_CHANGE_METHOD_HISTOGRAM, "Difference of luma histograms",
+        "histogram"},
+    {0, NULL, NULL},
+  };
+
+  if (!method_type) {
+    method_type = g_enum_register_static ("GstSceneChangeMethod",
+        method_types);
+  }
+  return method_type;
+}
+
 /* class initialization */
 
 G_DEFINE_TYPE_WITH_CODE (GstSceneChange, gst_scene_change,
@@ -115,6 +157,9 @@ G_DEFINE_TYPE_WITH_CODE (GstSceneChange, gst_scene_change,
 static void
 gst_scene_change_class_init (GstSceneChangeClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
@@ -129,23 +174,127 @@ gst_scene_change_class_init (GstSceneChangeClass * klass)
       "Video/Filter", "Detects scene changes in video",
       "David Schleef <ds@entropywave.com>");
 
+  gobject_class->set_property = gst_scene_change_set_property;
+  gobject_class->get_property = gst_scene_change_get_property;
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_scene_change_stop);
   video_filter_class->transform_frame_ip =
       GST_DEBUG_FUNCPTR (gst_scene_change_transform_frame_ip);
 
+  g_object_class_install_property (gobject_class, PROP_METHOD,
+      g_param_spec_enum ("method", "Method",
+          "How consecutive frames are compared", GST_TYPE_SCENE_CHANGE_METHOD,
+          DEFAULT_METHOD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_LINE_STEP,
+      g_param_spec_uint ("line-step", "Line step",
+          "Only compare every Nth line of the frames", 1, 16,
+          DEFAULT_LINE_STEP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_scene_change_init (GstSceneChange * scenechange)
 {
+  scenechange->method = DEFAULT_METHOD;
+  scenechange->line_step = DEFAULT_LINE_STEP;
 }
 
+static void
+gst_scene_change_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  GST_OBJECT_LOCK (scenechange);
+  switch (property_id) {
+    case PROP_METHOD:
+      scenechange->method = g_value_get_enum (value);
+      break;
+    case PROP_LINE_STEP:
+      scenechange->line_step = g_value_get_uint (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (scenechange);
+}
+
+static void
+gst_scene_change_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (object);
+
+  GST_OBJECT_LOCK (scenechange);
+  switch (property_id) {
+    case PROP_METHOD:
+      g_value_set_enum (value, scenechange->method);
+      break;
+    case PROP_LINE_STEP:
+      g_value_set_uint (value, scenechange->line_step);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+  GST_OBJECT_UNLOCK (scenechange);
+}
+
+static gboolean
+gst_scene_change_stop (GstBaseTransform * trans)
+{
+  GstSceneChange *scenechange = GST_SCENE_CHANGE (trans);
+
+  gst_buffer_replace (&scenechange->oldbuf, NULL);
+  scenechange->have_hist = FALSE;
+
+  return TRUE;
+}
+
+/* sum of absolute differences of one line */
+static guint64
+get_line_sad (const guint8 * s1, const guint8 * s2, gint width)
+{
+  guint64 sad = 0;
+  gint i = 0;
+
+#if defined (__SSE2__)
+  __m128i acc = _mm_setzero_si128 ();
+  guint64 lanes[2];
+
+  for (; i + 16 <= width; i += 16) {
+    __m128i a = _mm_loadu_si128 ((const __m128i *) (s1 + i));
+    __m128i b = _mm_loadu_si128 ((const __m128i *) (s2 + i));
+
+    acc = _mm_add_epi64 (acc, _mm_sad_epu8 (a, b));
+  }
+  _mm_storeu_si128 ((__m128i *) lanes, acc);
+  sad = lanes[0] + lanes[1];
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  uint32x4_t acc = vdupq_n_u32 (0);
+  uint64x2_t acc64;
+
+  for (; i + 16 <= width; i += 16) {
+    uint8x16_t diff = vabdq_u8 (vld1q_u8 (s1 + i), vld1q_u8 (s2 + i));
+
+    acc = vpadalq_u16 (acc, vpaddlq_u8 (diff));
+  }
+  acc64 = vpaddlq_u32 (acc);
+  sad = vgetq_lane_u64 (acc64, 0) + vgetq_lane_u64 (acc64, 1);
+#endif
+
+  for (; i < width; i++)
+    sad += ABS (s1[i] - s2[i]);
+
+  return sad;
+}
 
 static double
-get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
+get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2, guint line_step)
 {
-  int i;
   int j;
-  int score = 0;
+  guint64 score = 0;
+  guint64 n_pixels = 0;
   int width, height;
   guint8 *s1;
   guint8 *s2;
@@ -153,15 +302,64 @@ get_frame_score (GstVideoFrame * f1, GstVideoFrame * f2)
   width = f1->info.width;
   height = f1->info.height;
 
-  for (j = 0; j < height; j++) {
+  for (j = 0; j < height; j += line_step) {
     s1 = (guint8 *) f1->data[0] + f1->info.stride[0] * j;
     s2 = (guint8 *) f2->data[0] + f2->info.stride[0] * j;
-    for (i = 0; i < width; i++) {
-      score += ABS (s1[i] - s2[i]);
+    score += get_line_sad (s1, s2, width);
+    n_pixels += width;
+  }
+
+  return ((double) score) / n_pixels;
+}
+
+static void
+get_frame_histogram (GstVideoFrame * frame, guint line_step, guint64 * hist)
+{
+  guint32 counts[4][SC_HIST_BINS];
+  int i, j, b;
+  int width, height;
+  guint8 *s;
+
+  width = frame->info.width;
+  height = frame->info.height;
+
+  /* spread consecutive pixels over separate tables, so that runs of equal
+   * values don't stall on incrementing the same counter */
+  memset (counts, 0, sizeof (counts));
+  for (j = 0; j < height; j += line_step) {
+    s = (guint8 *) frame->data[0] + frame->info.stride[0] * j;
+    for (i = 0; i + 4 <= width; i += 4) {
+      counts[0][s[i] >> 2]++;
+      counts[1][s[i + 1] >> 2]++;
+      counts[2][s[i + 2] >> 2]++;
+      counts[3][s[i + 3] >> 2]++;
     }
+    for (; i < width; i++)
+      counts[0][s[i] >> 2]++;
+  }
+
+  for (b = 0; b < SC_HIST_BINS; b++)
+    hist[b] = (guint64) counts[0][b] + counts[1][b] + counts[2][b] +
+        counts[3][b];
+}
+
+/* scaled to 0-256 so that the thresholds tuned for the SAD scores apply
+ * roughly */
+static double
+get_histogram_score (const guint64 * h1, const guint64 * h2)
+{
+  guint64 diff = 0, total = 0;
+  int b;
+
+  for (b = 0; b < SC_HIST_BINS; b++) {
+    diff += h1[b] > h2[b] ? h1[b] - h2[b] : h2[b] - h1[b];
+    total += h1[b];
   }
 
-  return ((double) score) / (width * height);
+  if (total == 0)
+    return 0;
+
+  return 128.0 * diff / total;
 }
 
 static GstFlowReturn
@@ -176,33 +374,61 @@ gst_scene_change_transform_frame_ip (GstVideoFilter * filter,
   double score;
   gboolean change;
   gboolean ret;
+  GstSceneChangeMethod method;
+  guint line_step;
   int i;
 
   GST_DEBUG_OBJECT (scenechange, "transform_frame_ip");
 
-  if (!scenechange->oldbuf) {
-    scenechange->n_diffs = 0;
-    memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
-    scenechange->oldbuf = gst_buffer_ref (frame->buffer);
-    memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
-    return GST_FLOW_OK;
-  }
+  GST_OBJECT_LOCK (scenechange);
+  method = scenechange->method;
+  line_step = scenechange->line_step;
+  GST_OBJECT_UNLOCK (scenechange);
 
-  ret =
-      gst_video_frame_map (&oldframe, &scenechange->oldinfo,
-      scenechange->oldbuf, GST_MAP_READ);
-  if (!ret) {
-    GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
-    return GST_FLOW_ERROR;
-  }
+  if (method == GST_SCENE_CHANGE_METHOD_HISTOGRAM) {
+    guint64 hist[SC_HIST_BINS];
 
-  score = get_frame_score (&oldframe, frame);
+    gst_buffer_replace (&scenechange->oldbuf, NULL);
 
-  gst_video_frame_unmap (&oldframe);
+    get_frame_histogram (frame, line_step, hist);
 
-  gst_buffer_unref (scenechange->oldbuf);
-  scenechange->oldbuf = gst_buffer_ref (frame->buffer);
-  memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+    if (!scenechange->have_hist) {
+      scenechange->n_diffs = 0;
+      memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
+      memcpy (scenechange->hist, hist, sizeof (hist));
+      scenechange->have_hist = TRUE;
+      return GST_FLOW_OK;
+    }
+
+    score = get_histogram_score (scenechange->hist, hist);
+    memcpy (scenechange->hist, hist, sizeof (hist));
+  } else {
+    scenechange->have_hist = FALSE;
+
+    if (!scenechange->oldbuf) {
+      scenechange->n_diffs = 0;
+      memset (scenechange->diffs, 0, sizeof (double) * SC_N_DIFFS);
+      scenechange->oldbuf = gst_buffer_ref (frame->buffer);
+      memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+      return GST_FLOW_OK;
+    }
+
+    ret =
+        gst_video_frame_map (&oldframe, &scenechange->oldinfo,
+        scenechange->oldbuf, GST_MAP_READ);
+    if (!ret) {
+      GST_ERROR_OBJECT (scenechange, "failed to map old video frame");
+      return GST_FLOW_ERROR;
+    }
+
+    score = get_frame_score (&oldframe, frame, line_step);
+
+    gst_video_frame_unmap (&oldframe);
+
+    gst_buffer_unref (scenechange->oldbuf);
+    scenechange->oldbuf = gst_buffer_ref (frame->buffer);
+    memcpy (&scenechange->oldinfo, &frame->info, sizeof (GstVideoInfo));
+  }
 
   memmove (scenechange->diffs, scenechange->diffs + 1,
       sizeof (double) * (SC_N_DIFFS - 1));
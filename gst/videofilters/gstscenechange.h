@@ -35,15 +35,26 @@ typedef struct _GstSceneChange GstSceneChange;
 typedef struct _GstSceneChangeClass GstSceneChangeClass;
 
 #define SC_N_DIFFS 5
+#define SC_HIST_BINS 64
+
+typedef enum {
+  GST_SCENE_CHANGE_METHOD_SAD,
+  GST_SCENE_CHANGE_METHOD_HISTOGRAM
+} GstSceneChangeMethod;
 
 struct _GstSceneChange
 {
   GstVideoFilter base_scenechange;
 
+  GstSceneChangeMethod method;
+  guint line_step;
+
   int n_diffs;
   double diffs[SC_N_DIFFS];
   GstBuffer *oldbuf;
   GstVideoInfo oldinfo;
+  guint64 hist[SC_HIST_BINS];
+  gboolean have_hist;
   int count;
 };
 
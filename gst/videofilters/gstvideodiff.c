@@ -22,6 +22,12 @@
  * The videodiff element highlights the difference between a frame and its
  * previous on the luma plane.
  *
+ * Frames are processed in horizontal bands by several threads, see the
+ * #GstVideoDiff:threads property. With #GstVideoDiff:subsample, only every
+ * n-th luma sample of every n-th line is compared and the stripes are
+ * drawn over the whole block it stands for, which is cheaper for monitoring
+ * many streams at once.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -38,15 +44,35 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 #include "gstvideodiff.h"
+#include "gstvideofilterslines.h"
 
 GST_DEBUG_CATEGORY_STATIC (gst_video_diff_debug_category);
 #define GST_CAT_DEFAULT gst_video_diff_debug_category
 
 /* prototypes */
 
+static void gst_video_diff_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void gst_video_diff_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void gst_video_diff_finalize (GObject * object);
+static gboolean gst_video_diff_stop (GstBaseTransform * trans);
+static gboolean gst_video_diff_set_info (GstVideoFilter * filter,
+    GstCaps * incaps, GstVideoInfo * in_info, GstCaps * outcaps,
+    GstVideoInfo * out_info);
 static GstFlowReturn gst_video_diff_transform_frame (GstVideoFilter * filter,
     GstVideoFrame * inframe, GstVideoFrame * outframe);
 
+enum
+{
+  PROP_0,
+  PROP_THREADS,
+  PROP_SUBSAMPLE
+};
+
+#define DEFAULT_THREADS 0
+#define DEFAULT_SUBSAMPLE 1
+
 #define VIDEO_SRC_CAPS \
     GST_VIDEO_CAPS_MAKE("{ I420, Y444, Y42B, Y41B }")
 
@@ -61,6 +87,9 @@ G_DEFINE_TYPE_WITH_CODE (GstVideoDiff, gst_video_diff, GST_TYPE_VIDEO_FILTER,
 static void
 gst_video_diff_class_init (GstVideoDiffClass * klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
   GstVideoFilterClass *video_filter_class = GST_VIDEO_FILTER_CLASS (klass);
 
   gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
@@ -75,53 +104,192 @@ gst_video_diff_class_init (GstVideoDiffClass * klass)
       "Visualize differences between adjacent video frames",
       "David Schleef <ds@schleef.org>");
 
+  gobject_class->set_property = gst_video_diff_set_property;
+  gobject_class->get_property = gst_video_diff_get_property;
+  gobject_class->finalize = gst_video_diff_finalize;
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_video_diff_stop);
+  video_filter_class->set_info = GST_DEBUG_FUNCPTR (gst_video_diff_set_info);
   video_filter_class->transform_frame =
       GST_DEBUG_FUNCPTR (gst_video_diff_transform_frame);
+
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of threads processing bands of each frame "
+          "(0 = number of processors)", 0, GST_VIDEO_FILTERS_MAX_THREADS,
+          DEFAULT_THREADS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SUBSAMPLE,
+      g_param_spec_uint ("subsample", "Subsample",
+          "Only compare every n-th luma sample of every n-th line and mark "
+          "the n x n block around it (1 = all)", 1, 16, DEFAULT_SUBSAMPLE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_video_diff_init (GstVideoDiff * videodiff)
 {
   videodiff->threshold = 10;
+  videodiff->threads = DEFAULT_THREADS;
+  videodiff->subsample = DEFAULT_SUBSAMPLE;
+  videodiff->n_bands = 1;
+  gst_video_filters_bands_init (&videodiff->bands);
 }
 
-static GstFlowReturn
-gst_video_diff_transform_frame_ip_planarY (GstVideoDiff * videodiff,
-    GstVideoFrame * outframe, GstVideoFrame * inframe, GstVideoFrame * oldframe)
+static void
+gst_video_diff_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  switch (property_id) {
+    case PROP_THREADS:
+      videodiff->threads = g_value_get_uint (value);
+      break;
+    case PROP_SUBSAMPLE:
+      GST_OBJECT_LOCK (videodiff);
+      videodiff->subsample = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (videodiff);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_video_diff_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  switch (property_id) {
+    case PROP_THREADS:
+      g_value_set_uint (value, videodiff->threads);
+      break;
+    case PROP_SUBSAMPLE:
+      GST_OBJECT_LOCK (videodiff);
+      g_value_set_uint (value, videodiff->subsample);
+      GST_OBJECT_UNLOCK (videodiff);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_video_diff_finalize (GObject * object)
 {
-  int width = inframe->info.width;
-  int height = inframe->info.height;
-  int i, j;
-  int threshold = videodiff->threshold;
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (object);
+
+  g_free (videodiff->mask_lines);
+  gst_video_filters_bands_clear (&videodiff->bands);
+
+  G_OBJECT_CLASS (gst_video_diff_parent_class)->finalize (object);
+}
+
+static gboolean
+gst_video_diff_stop (GstBaseTransform * trans)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (trans);
+
+  gst_buffer_replace (&videodiff->previous_buffer, NULL);
+
+  return TRUE;
+}
+
+static gboolean
+gst_video_diff_set_info (GstVideoFilter * filter, GstCaps * incaps,
+    GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
+{
+  GstVideoDiff *videodiff = GST_VIDEO_DIFF (filter);
+
+  videodiff->n_bands = gst_video_filters_bands_get_count (videodiff->threads,
+      GST_VIDEO_INFO_HEIGHT (in_info));
+  videodiff->mask_stride = GST_ROUND_UP_16 (GST_VIDEO_INFO_WIDTH (in_info));
+  g_free (videodiff->mask_lines);
+  videodiff->mask_lines =
+      g_malloc (videodiff->mask_stride * videodiff->n_bands);
+
+  /* a frame of another size can't be compared with */
+  gst_buffer_replace (&videodiff->previous_buffer, NULL);
+
+  GST_DEBUG_OBJECT (videodiff, "%u bands", videodiff->n_bands);
+
+  return TRUE;
+}
+
+/* Same as video_diff_mask_line(), only comparing every @step-th sample and
+ * using the result for the following @step samples */
+static void
+video_diff_mask_line_subsampled (guint8 * mask, const guint8 * s1,
+    const guint8 * s2, int width, guint8 threshold, int step)
+{
+  int i;
+
+  for (i = 0; i < width; i += step)
+    memset (mask + i, ABS (s2[i] - s1[i]) > threshold ? 0xff : 0,
+        MIN (step, width - i));
+}
+
+static void
+gst_video_diff_process_band (GstVideoDiff * videodiff, guint band,
+    guint n_bands)
+{
+  GstVideoFrame *inframe = videodiff->inframe;
+  GstVideoFrame *outframe = videodiff->outframe;
+  GstVideoFrame *oldframe = videodiff->oldframe;
+  int width = GST_VIDEO_FRAME_WIDTH (inframe);
+  int height = GST_VIDEO_FRAME_HEIGHT (inframe);
+  int step = videodiff->frame_subsample;
+  guint8 threshold = CLAMP (videodiff->threshold, 0, 255);
+  guint8 *mask = videodiff->mask_lines + band * videodiff->mask_stride;
   int t = videodiff->t;
+  gint first, last;
+  int j, k;
+
+  gst_video_filters_bands_get_range (height, step, band, n_bands, &first,
+      &last);
 
-  for (j = 0; j < height; j++) {
+  for (j = first; j < last; j++) {
     guint8 *d = (guint8 *) outframe->data[0] + outframe->info.stride[0] * j;
-    guint8 *s1 = (guint8 *) oldframe->data[0] + oldframe->info.stride[0] * j;
     guint8 *s2 = (guint8 *) inframe->data[0] + inframe->info.stride[0] * j;
-    for (i = 0; i < width; i++) {
-      if ((s2[i] < s1[i] - threshold) || (s2[i] > s1[i] + threshold)) {
-        if ((i + j + t) & 0x4) {
-          d[i] = 16;
-        } else {
-          d[i] = 240;
-        }
-      } else {
-        d[i] = s2[i];
-      }
+
+    if (!oldframe) {
+      memcpy (d, s2, width);
+      continue;
     }
+
+    /* bands start on a multiple of step, so this is the first line of a
+     * block */
+    if (j % step == 0) {
+      guint8 *s1 = (guint8 *) oldframe->data[0] + oldframe->info.stride[0] * j;
+
+      if (step == 1)
+        video_diff_mask_line (mask, s1, s2, width, threshold);
+      else
+        video_diff_mask_line_subsampled (mask, s1, s2, width, threshold,
+            step);
+    }
+
+    video_diff_draw_line (d, s2, mask, width, (j + t) & 7);
   }
-  for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 1); j++) {
-    guint8 *d = (guint8 *) outframe->data[1] + outframe->info.stride[1] * j;
-    guint8 *s = (guint8 *) inframe->data[1] + inframe->info.stride[1] * j;
-    memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, 1));
-  }
-  for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, 2); j++) {
-    guint8 *d = (guint8 *) outframe->data[2] + outframe->info.stride[2] * j;
-    guint8 *s = (guint8 *) inframe->data[2] + inframe->info.stride[2] * j;
-    memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, 2));
+
+  /* this band's share of the chroma lines */
+  for (k = 1; k < 3; k++) {
+    gint comp_height = GST_VIDEO_FRAME_COMP_HEIGHT (inframe, k);
+    gint comp_width = GST_VIDEO_FRAME_COMP_WIDTH (inframe, k);
+    gint comp_first = gst_util_uint64_scale_int (first, comp_height, height);
+    gint comp_last = gst_util_uint64_scale_int (last, comp_height, height);
+
+    for (j = comp_first; j < comp_last; j++) {
+      guint8 *d = (guint8 *) outframe->data[k] + outframe->info.stride[k] * j;
+      guint8 *s = (guint8 *) inframe->data[k] + inframe->info.stride[k] * j;
+      memcpy (d, s, comp_width);
+    }
   }
-  return GST_FLOW_OK;
 }
 
 static GstFlowReturn
@@ -129,40 +297,36 @@ gst_video_diff_transform_frame (GstVideoFilter * filter,
     GstVideoFrame * inframe, GstVideoFrame * outframe)
 {
   GstVideoDiff *videodiff = GST_VIDEO_DIFF (filter);
+  GstVideoFrame oldframe;
+
+  GST_DEBUG_OBJECT (videodiff, "transform_frame");
+
+  videodiff->inframe = inframe;
+  videodiff->outframe = outframe;
+  videodiff->oldframe = NULL;
 
-  GST_DEBUG_OBJECT (videodiff, "transform_frame_ip");
+  GST_OBJECT_LOCK (videodiff);
+  videodiff->frame_subsample = videodiff->subsample;
+  GST_OBJECT_UNLOCK (videodiff);
 
   if (videodiff->previous_buffer) {
-    GstVideoFrame oldframe;
-
-    gst_video_frame_map (&oldframe, &videodiff->oldinfo,
-        videodiff->previous_buffer, GST_MAP_READ);
-
-    switch (inframe->info.finfo->format) {
-      case GST_VIDEO_FORMAT_I420:
-      case GST_VIDEO_FORMAT_Y41B:
-      case GST_VIDEO_FORMAT_Y444:
-      case GST_VIDEO_FORMAT_Y42B:
-        gst_video_diff_transform_frame_ip_planarY (videodiff, outframe,
-            inframe, &oldframe);
-        break;
-      default:
-        g_assert_not_reached ();
+    if (!gst_video_frame_map (&oldframe, &videodiff->oldinfo,
+            videodiff->previous_buffer, GST_MAP_READ)) {
+      GST_ELEMENT_ERROR (videodiff, STREAM, FAILED, (NULL),
+          ("Failed to map previous frame"));
+      return GST_FLOW_ERROR;
     }
+    videodiff->oldframe = &oldframe;
+  }
+
+  gst_video_filters_bands_run (&videodiff->bands, videodiff->n_bands,
+      (GstVideoFiltersBandFunc) gst_video_diff_process_band, videodiff);
 
+  if (videodiff->oldframe) {
     gst_video_frame_unmap (&oldframe);
     gst_buffer_unref (videodiff->previous_buffer);
-  } else {
-    int k;
-    int j;
-    for (k = 0; k < 3; k++) {
-      for (j = 0; j < GST_VIDEO_FRAME_COMP_HEIGHT (inframe, k); j++) {
-        guint8 *d = (guint8 *) outframe->data[k] + outframe->info.stride[k] * j;
-        guint8 *s = (guint8 *) inframe->data[k] + inframe->info.stride[k] * j;
-        memcpy (d, s, GST_VIDEO_FRAME_COMP_WIDTH (inframe, k));
-      }
-    }
   }
+  videodiff->inframe = videodiff->outframe = videodiff->oldframe = NULL;
 
   videodiff->previous_buffer = gst_buffer_ref (inframe->buffer);
   memcpy (&videodiff->oldinfo, &inframe->info, sizeof (GstVideoInfo));
@@ -24,6 +24,8 @@
 #include <gst/video/gstvideofilter.h>
 #include <string.h>
 
+#include "gstvideofiltersbands.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_VIDEO_DIFF   (gst_video_diff_get_type())
@@ -44,6 +46,22 @@ struct _GstVideoDiff
 
   int threshold;
   int t;
+
+  /* properties */
+  guint threads;
+  guint subsample;
+
+  /* frame being processed by the bands, oldframe is NULL for the first */
+  GstVideoFrame *inframe;
+  GstVideoFrame *outframe;
+  GstVideoFrame *oldframe;
+  guint frame_subsample;
+
+  guint n_bands;
+  /* one line of differences per band */
+  guint8 *mask_lines;
+  gint mask_stride;
+  GstVideoFiltersBands bands;
 };
 
 struct _GstVideoDiffClass
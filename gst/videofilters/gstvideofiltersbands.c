@@ -0,0 +1,142 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gstvideofiltersbands.h"
+
+typedef struct
+{
+  GstVideoFiltersBands *bands;
+  GstVideoFiltersBandFunc func;
+  gpointer user_data;
+  guint band;
+  guint n_bands;
+} GstVideoFiltersBandTask;
+
+static void
+gst_video_filters_bands_task_func (GstVideoFiltersBandTask * task,
+    gpointer unused)
+{
+  GstVideoFiltersBands *bands = task->bands;
+
+  task->func (task->user_data, task->band, task->n_bands);
+
+  g_mutex_lock (&bands->lock);
+  if (--bands->pending == 0)
+    g_cond_signal (&bands->cond);
+  g_mutex_unlock (&bands->lock);
+}
+
+/* One pool for all instances, so that a process running many of these
+ * elements doesn't start a set of threads per element. The streaming
+ * thread always takes a band itself, hence one thread less than there
+ * are processors. */
+static GThreadPool *
+gst_video_filters_bands_get_pool (void)
+{
+  static gsize pool = 0;
+
+  if (g_once_init_enter (&pool)) {
+    gint n = MIN (g_get_num_processors (), GST_VIDEO_FILTERS_MAX_THREADS);
+    GThreadPool *p;
+
+    p = g_thread_pool_new ((GFunc) gst_video_filters_bands_task_func, NULL,
+        MAX (n - 1, 1), FALSE, NULL);
+    g_once_init_leave (&pool, (gsize) p);
+  }
+
+  return (GThreadPool *) pool;
+}
+
+void
+gst_video_filters_bands_init (GstVideoFiltersBands * bands)
+{
+  g_mutex_init (&bands->lock);
+  g_cond_init (&bands->cond);
+  bands->pending = 0;
+}
+
+void
+gst_video_filters_bands_clear (GstVideoFiltersBands * bands)
+{
+  g_mutex_clear (&bands->lock);
+  g_cond_clear (&bands->cond);
+}
+
+/* Number of bands a frame of @height rows is split in, for a threads
+ * property of @threads (0 = number of processors) */
+guint
+gst_video_filters_bands_get_count (guint threads, gint height)
+{
+  if (threads == 0)
+    threads = MIN (g_get_num_processors (), GST_VIDEO_FILTERS_MAX_THREADS);
+
+  return CLAMP (height / GST_VIDEO_FILTERS_MIN_BAND_HEIGHT, 1, threads);
+}
+
+/* Rows [@first, @last) of band @band, the bands starting on multiples of
+ * @align rows */
+void
+gst_video_filters_bands_get_range (gint height, guint align, guint band,
+    guint n_bands, gint * first, gint * last)
+{
+  gint blocks = (height + align - 1) / align;
+
+  *first = MIN (blocks * band / n_bands * align, height);
+  *last = MIN (blocks * (band + 1) / n_bands * align, height);
+}
+
+/* Runs @func on each of @n_bands bands and returns when all are done. Band
+ * 0 runs in the calling thread. */
+void
+gst_video_filters_bands_run (GstVideoFiltersBands * bands, guint n_bands,
+    GstVideoFiltersBandFunc func, gpointer user_data)
+{
+  GstVideoFiltersBandTask tasks[GST_VIDEO_FILTERS_MAX_THREADS];
+  GThreadPool *pool;
+  guint i;
+
+  g_return_if_fail (n_bands > 0 && n_bands <= GST_VIDEO_FILTERS_MAX_THREADS);
+
+  if (n_bands == 1) {
+    func (user_data, 0, 1);
+    return;
+  }
+
+  pool = gst_video_filters_bands_get_pool ();
+
+  bands->pending = n_bands - 1;
+  for (i = 1; i < n_bands; i++) {
+    tasks[i].bands = bands;
+    tasks[i].func = func;
+    tasks[i].user_data = user_data;
+    tasks[i].band = i;
+    tasks[i].n_bands = n_bands;
+    g_thread_pool_push (pool, &tasks[i], NULL);
+  }
+
+  func (user_data, 0, n_bands);
+
+  g_mutex_lock (&bands->lock);
+  while (bands->pending > 0)
+    g_cond_wait (&bands->cond, &bands->lock);
+  g_mutex_unlock (&bands->lock);
+}
@@ -0,0 +1,57 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _GST_VIDEO_FILTERS_BANDS_H_
+#define _GST_VIDEO_FILTERS_BANDS_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define GST_VIDEO_FILTERS_MAX_THREADS 64
+/* don't bother handing out bands smaller than this many rows */
+#define GST_VIDEO_FILTERS_MIN_BAND_HEIGHT 64
+
+typedef struct _GstVideoFiltersBands GstVideoFiltersBands;
+
+/* processes band @band of @n_bands of the current frame */
+typedef void (*GstVideoFiltersBandFunc) (gpointer user_data, guint band,
+    guint n_bands);
+
+/* per element state, the worker threads are shared by all elements of the
+ * plugin */
+struct _GstVideoFiltersBands
+{
+  GMutex lock;
+  GCond cond;
+  guint pending;
+};
+
+void gst_video_filters_bands_init (GstVideoFiltersBands * bands);
+void gst_video_filters_bands_clear (GstVideoFiltersBands * bands);
+
+guint gst_video_filters_bands_get_count (guint threads, gint height);
+void gst_video_filters_bands_get_range (gint height, guint align, guint band,
+    guint n_bands, gint * first, gint * last);
+
+void gst_video_filters_bands_run (GstVideoFiltersBands * bands,
+    guint n_bands, GstVideoFiltersBandFunc func, gpointer user_data);
+
+G_END_DECLS
+
+#endif
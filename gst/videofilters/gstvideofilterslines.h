@@ -0,0 +1,158 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Suite 500,
+ * Boston, MA 02110-1335, USA.
+ */
+
+#ifndef _GST_VIDEO_FILTERS_LINES_H_
+#define _GST_VIDEO_FILTERS_LINES_H_
+
+#include <glib.h>
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+G_BEGIN_DECLS
+
+/* 0xff where @s2 differs from @s1 by more than @threshold, 0 elsewhere */
+static inline void
+video_diff_mask_line (guint8 * mask, const guint8 * s1, const guint8 * s2,
+    int width, guint8 threshold)
+{
+  int i = 0;
+
+#if defined (__SSE2__)
+  {
+    const __m128i thr = _mm_set1_epi8 ((char) threshold);
+    const __m128i zero = _mm_setzero_si128 ();
+
+    for (; i + 16 <= width; i += 16) {
+      __m128i a = _mm_loadu_si128 ((const __m128i *) (s1 + i));
+      __m128i b = _mm_loadu_si128 ((const __m128i *) (s2 + i));
+      __m128i d = _mm_or_si128 (_mm_subs_epu8 (a, b), _mm_subs_epu8 (b, a));
+
+      /* d <= threshold, inverted */
+      d = _mm_cmpeq_epi8 (_mm_subs_epu8 (d, thr), zero);
+      _mm_storeu_si128 ((__m128i *) (mask + i),
+          _mm_andnot_si128 (d, _mm_cmpeq_epi8 (zero, zero)));
+    }
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    const uint8x16_t thr = vdupq_n_u8 (threshold);
+
+    for (; i + 16 <= width; i += 16) {
+      uint8x16_t d = vabdq_u8 (vld1q_u8 (s1 + i), vld1q_u8 (s2 + i));
+
+      vst1q_u8 (mask + i, vcgtq_u8 (d, thr));
+    }
+  }
+#endif
+
+  for (; i < width; i++)
+    mask[i] = ABS (s2[i] - s1[i]) > threshold ? 0xff : 0;
+}
+
+/* Diagonal stripes where @mask is set, the current frame elsewhere */
+static inline void
+video_diff_draw_line (guint8 * d, const guint8 * s, const guint8 * mask,
+    int width, int phase)
+{
+  /* 4 samples black, 4 samples white, enough of them to load 16 starting at
+   * any phase */
+  static const guint8 stripes[24] = {
+    240, 240, 240, 240, 16, 16, 16, 16,
+    240, 240, 240, 240, 16, 16, 16, 16,
+    240, 240, 240, 240, 16, 16, 16, 16
+  };
+  int i = 0;
+
+#if defined (__SSE2__)
+  {
+    const __m128i st = _mm_loadu_si128 ((const __m128i *) (stripes + phase));
+
+    for (; i + 16 <= width; i += 16) {
+      __m128i m = _mm_loadu_si128 ((const __m128i *) (mask + i));
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (s + i));
+
+      _mm_storeu_si128 ((__m128i *) (d + i),
+          _mm_or_si128 (_mm_and_si128 (m, st), _mm_andnot_si128 (m, v)));
+    }
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    const uint8x16_t st = vld1q_u8 (stripes + phase);
+
+    for (; i + 16 <= width; i += 16)
+      vst1q_u8 (d + i, vbslq_u8 (vld1q_u8 (mask + i), st, vld1q_u8 (s + i)));
+  }
+#endif
+
+  for (; i < width; i++)
+    d[i] = mask[i] ? stripes[(i + phase) & 7] : s[i];
+}
+
+/* Sets the bytes selected by both @stripes and @mask that are at least
+ * @threshold to 16. Both select with 0xff and not with 0, other values mix
+ * the bits of the result */
+static inline void
+zebra_stripe_line (guint8 * data, const guint8 * stripes, const guint8 * mask,
+    int n, guint8 threshold)
+{
+  int i = 0;
+
+#if defined (__SSE2__)
+  {
+    const __m128i thr = _mm_set1_epi8 ((char) threshold);
+    const __m128i black = _mm_set1_epi8 (16);
+
+    for (; i + 16 <= n; i += 16) {
+      __m128i v = _mm_loadu_si128 ((__m128i *) (data + i));
+      __m128i m = _mm_and_si128 (_mm_loadu_si128 ((const __m128i *) (stripes +
+                  i)), _mm_loadu_si128 ((const __m128i *) (mask + i)));
+
+      /* v >= threshold */
+      m = _mm_and_si128 (m, _mm_cmpeq_epi8 (_mm_max_epu8 (v, thr), v));
+      _mm_storeu_si128 ((__m128i *) (data + i),
+          _mm_or_si128 (_mm_andnot_si128 (m, v), _mm_and_si128 (m, black)));
+    }
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    const uint8x16_t thr = vdupq_n_u8 (threshold);
+    const uint8x16_t black = vdupq_n_u8 (16);
+
+    for (; i + 16 <= n; i += 16) {
+      uint8x16_t v = vld1q_u8 (data + i);
+      uint8x16_t m = vandq_u8 (vld1q_u8 (stripes + i), vld1q_u8 (mask + i));
+
+      m = vandq_u8 (m, vcgeq_u8 (v, thr));
+      vst1q_u8 (data + i, vbslq_u8 (m, black, v));
+    }
+  }
+#endif
+
+  for (; i < n; i++) {
+    if ((stripes[i] & mask[i]) && data[i] >= threshold)
+      data[i] = 16;
+  }
+}
+
+G_END_DECLS
+
+#endif
@@ -39,6 +39,11 @@
  * property setting can be calculated from IRE by using the formula
  * percent = (IRE * 1.075) - 7.5.  Note that 100 IRE corresponds to
  * 100 %, and 70 IRE corresponds to 68 %.
+ *
+ * Frames are processed in horizontal bands by several threads, see the
+ * #GstZebraStripe:threads property. With #GstZebraStripe:subsample, only
+ * every n-th pixel of every n-th line is compared with the threshold and
+ * the stripes are drawn over the whole block it stands for.
  * </refsect2>
  */
 
@@ -50,7 +55,9 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 #include "gstzebrastripe.h"
+#include "gstvideofilterslines.h"
 #include <math.h>
+#include <string.h>
 
 GST_DEBUG_CATEGORY_STATIC (gst_zebra_stripe_debug_category);
 #define GST_CAT_DEFAULT gst_zebra_stripe_debug_category
@@ -64,6 +71,10 @@ static void gst_zebra_stripe_get_property (GObject * object,
     guint property_id, GValue * value, GParamSpec * pspec);
 static gboolean gst_zebra_stripe_start (GstBaseTransform * trans);
 static gboolean gst_zebra_stripe_stop (GstBaseTransform * trans);
+static void gst_zebra_stripe_finalize (GObject * object);
+static gboolean gst_zebra_stripe_set_info (GstVideoFilter * filter,
+    GstCaps * incaps, GstVideoInfo * in_info, GstCaps * outcaps,
+    GstVideoInfo * out_info);
 
 static GstFlowReturn gst_zebra_stripe_transform_frame_ip (GstVideoFilter *
     filter, GstVideoFrame * frame);
@@ -71,10 +82,14 @@ static GstFlowReturn gst_zebra_stripe_transform_frame_ip (GstVideoFilter *
 enum
 {
   PROP_0,
-  PROP_THRESHOLD
+  PROP_THRESHOLD,
+  PROP_THREADS,
+  PROP_SUBSAMPLE
 };
 
 #define DEFAULT_THRESHOLD 90
+#define DEFAULT_THREADS 0
+#define DEFAULT_SUBSAMPLE 1
 
 /* pad templates */
 
@@ -114,8 +129,10 @@ gst_zebra_stripe_class_init (GstZebraStripeClass * klass)
 
   gobject_class->set_property = gst_zebra_stripe_set_property;
   gobject_class->get_property = gst_zebra_stripe_get_property;
+  gobject_class->finalize = gst_zebra_stripe_finalize;
   base_transform_class->start = GST_DEBUG_FUNCPTR (gst_zebra_stripe_start);
   base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_zebra_stripe_stop);
+  video_filter_class->set_info = GST_DEBUG_FUNCPTR (gst_zebra_stripe_set_info);
   video_filter_class->transform_frame_ip =
       GST_DEBUG_FUNCPTR (gst_zebra_stripe_transform_frame_ip);
 
@@ -124,11 +141,41 @@ gst_zebra_stripe_class_init (GstZebraStripeClass * klass)
           "Threshold above which the video is striped", 0, 100,
           DEFAULT_THRESHOLD,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of threads processing bands of each frame "
+          "(0 = number of processors)", 0, GST_VIDEO_FILTERS_MAX_THREADS,
+          DEFAULT_THREADS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_SUBSAMPLE,
+      g_param_spec_uint ("subsample", "Subsample",
+          "Only compare every n-th pixel of every n-th line with the "
+          "threshold and stripe the n x n block around it (1 = all)", 1, 16,
+          DEFAULT_SUBSAMPLE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_PLAYING |
+          G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_zebra_stripe_init (GstZebraStripe * zebrastripe)
 {
+  zebrastripe->threads = DEFAULT_THREADS;
+  zebrastripe->subsample = DEFAULT_SUBSAMPLE;
+  zebrastripe->n_bands = 1;
+  gst_video_filters_bands_init (&zebrastripe->bands);
+}
+
+static void
+gst_zebra_stripe_finalize (GObject * object)
+{
+  GstZebraStripe *zebrastripe = GST_ZEBRA_STRIPE (object);
+
+  g_free (zebrastripe->stripes);
+  g_free (zebrastripe->mask_lines);
+  gst_video_filters_bands_clear (&zebrastripe->bands);
+
+  G_OBJECT_CLASS (gst_zebra_stripe_parent_class)->finalize (object);
 }
 
 void
@@ -141,9 +188,19 @@ gst_zebra_stripe_set_property (GObject * object, guint property_id,
 
   switch (property_id) {
     case PROP_THRESHOLD:
+      GST_OBJECT_LOCK (zebrastripe);
       zebrastripe->threshold = g_value_get_int (value);
       zebrastripe->y_threshold =
           16 + floor (0.5 + 2.19 * zebrastripe->threshold);
+      GST_OBJECT_UNLOCK (zebrastripe);
+      break;
+    case PROP_THREADS:
+      zebrastripe->threads = g_value_get_uint (value);
+      break;
+    case PROP_SUBSAMPLE:
+      GST_OBJECT_LOCK (zebrastripe);
+      zebrastripe->subsample = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (zebrastripe);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -163,6 +220,12 @@ gst_zebra_stripe_get_property (GObject * object, guint property_id,
     case PROP_THRESHOLD:
       g_value_set_int (value, zebrastripe->threshold);
       break;
+    case PROP_THREADS:
+      g_value_set_uint (value, zebrastripe->threads);
+      break;
+    case PROP_SUBSAMPLE:
+      g_value_set_uint (value, zebrastripe->subsample);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -199,24 +262,18 @@ gst_zebra_stripe_stop (GstBaseTransform * trans)
   return TRUE;
 }
 
-static GstFlowReturn
-gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
-    GstVideoFrame * frame)
+static gboolean
+gst_zebra_stripe_set_info (GstVideoFilter * filter, GstCaps * incaps,
+    GstVideoInfo * in_info, GstCaps * outcaps, GstVideoInfo * out_info)
 {
   GstZebraStripe *zebrastripe = GST_ZEBRA_STRIPE (filter);
-  int width = frame->info.width;
-  int height = frame->info.height;
-  int i, j;
-  int threshold = zebrastripe->y_threshold;
-  int t = zebrastripe->t;
-  int offset = 0;
-  int pixel_stride = 0, y_position = 0;
+  int width = GST_VIDEO_INFO_WIDTH (in_info);
+  int pixel_stride, y_position = 0;
+  int k, n;
 
-  GST_DEBUG_OBJECT (zebrastripe, "transform_frame_ip");
-  zebrastripe->t++;
-  pixel_stride = GST_VIDEO_FORMAT_INFO_PSTRIDE (frame->info.finfo, 0);
+  pixel_stride = GST_VIDEO_FORMAT_INFO_PSTRIDE (in_info->finfo, 0);
 
-  switch (frame->info.finfo->format) {
+  switch (GST_VIDEO_INFO_FORMAT (in_info)) {
     case GST_VIDEO_FORMAT_I420:
     case GST_VIDEO_FORMAT_Y41B:
     case GST_VIDEO_FORMAT_Y444:
@@ -227,8 +284,6 @@ gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
     case GST_VIDEO_FORMAT_YV12:
       break;
     case GST_VIDEO_FORMAT_UYVY:
-      offset = 1;
-      break;
     case GST_VIDEO_FORMAT_AYUV:
       y_position = 1;
       break;
@@ -236,16 +291,93 @@ gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
       g_assert_not_reached ();
   }
 
-  for (j = 0; j < height; j++) {
-    guint8 *data =
-        (guint8 *) frame->data[0] + frame->info.stride[0] * j + offset;
-    for (i = 0; i < width; i++) {
-      if (data[pixel_stride * i + y_position] >= threshold) {
-        if ((i + j + t) & 0x4)
-          data[pixel_stride * i + y_position] = 16;
-      }
+  zebrastripe->pixel_stride = pixel_stride;
+  zebrastripe->y_position = y_position;
+
+  /* the stripes are 4 pixels wide and repeat every 8 pixels, lines are
+   * shifted by up to 7 pixels */
+  n = (width + 8) * pixel_stride;
+  g_free (zebrastripe->stripes);
+  zebrastripe->stripes = g_malloc (n);
+  for (k = 0; k < n; k++)
+    zebrastripe->stripes[k] = (k % pixel_stride == y_position &&
+        ((k / pixel_stride) & 0x4)) ? 0xff : 0;
+
+  zebrastripe->n_bands =
+      gst_video_filters_bands_get_count (zebrastripe->threads,
+      GST_VIDEO_INFO_HEIGHT (in_info));
+  zebrastripe->mask_stride = GST_ROUND_UP_16 (width * pixel_stride);
+  g_free (zebrastripe->mask_lines);
+  zebrastripe->mask_lines =
+      g_malloc (zebrastripe->mask_stride * zebrastripe->n_bands);
+
+  GST_DEBUG_OBJECT (zebrastripe, "%u bands", zebrastripe->n_bands);
+
+  return TRUE;
+}
+
+static void
+gst_zebra_stripe_process_band (GstZebraStripe * zebrastripe, guint band,
+    guint n_bands)
+{
+  GstVideoFrame *frame = zebrastripe->frame;
+  int width = GST_VIDEO_FRAME_WIDTH (frame);
+  int height = GST_VIDEO_FRAME_HEIGHT (frame);
+  int pixel_stride = zebrastripe->pixel_stride;
+  int y_position = zebrastripe->y_position;
+  int n = width * pixel_stride;
+  int step = zebrastripe->frame_subsample;
+  int threshold = zebrastripe->frame_y_threshold;
+  int t = zebrastripe->frame_t;
+  guint8 *mask = zebrastripe->mask_lines + band * zebrastripe->mask_stride;
+  gint first, last;
+  int i, j;
+
+  gst_video_filters_bands_get_range (height, step, band, n_bands, &first,
+      &last);
+
+  for (j = first; j < last; j++) {
+    guint8 *data = (guint8 *) frame->data[0] + frame->info.stride[0] * j;
+    const guint8 *stripes =
+        zebrastripe->stripes + ((j + t) & 0x7) * pixel_stride;
+
+    if (step == 1) {
+      zebra_stripe_line (data, stripes, stripes, n, threshold);
+      continue;
+    }
+
+    /* bands start on a multiple of step, so this is the first line of a
+     * block and still unmodified */
+    if (j % step == 0) {
+      for (i = 0; i < width; i += step)
+        memset (mask + i * pixel_stride,
+            data[i * pixel_stride + y_position] >= threshold ? 0xff : 0,
+            MIN (step, width - i) * pixel_stride);
     }
+
+    zebra_stripe_line (data, stripes, mask, n, 0);
   }
+}
+
+static GstFlowReturn
+gst_zebra_stripe_transform_frame_ip (GstVideoFilter * filter,
+    GstVideoFrame * frame)
+{
+  GstZebraStripe *zebrastripe = GST_ZEBRA_STRIPE (filter);
+
+  GST_DEBUG_OBJECT (zebrastripe, "transform_frame_ip");
+
+  zebrastripe->frame = frame;
+  zebrastripe->frame_t = zebrastripe->t++;
+  GST_OBJECT_LOCK (zebrastripe);
+  zebrastripe->frame_y_threshold = zebrastripe->y_threshold;
+  zebrastripe->frame_subsample = zebrastripe->subsample;
+  GST_OBJECT_UNLOCK (zebrastripe);
+
+  gst_video_filters_bands_run (&zebrastripe->bands, zebrastripe->n_bands,
+      (GstVideoFiltersBandFunc) gst_zebra_stripe_process_band, zebrastripe);
+
+  zebrastripe->frame = NULL;
 
   return GST_FLOW_OK;
 }
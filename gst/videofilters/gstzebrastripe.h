@@ -23,6 +23,8 @@
 #include <gst/video/video.h>
 #include <gst/video/gstvideofilter.h>
 
+#include "gstvideofiltersbands.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_ZEBRA_STRIPE   (gst_zebra_stripe_get_type())
@@ -40,10 +42,31 @@ struct _GstZebraStripe
 
   /* properties */
   int threshold;
+  guint threads;
+  guint subsample;
 
   /* state */
   int t;
   int y_threshold;
+
+  /* frame being processed by the bands */
+  GstVideoFrame *frame;
+  int frame_t;
+  int frame_y_threshold;
+  guint frame_subsample;
+
+  int pixel_stride;
+  /* of the luma byte within a pixel */
+  int y_position;
+  /* 0xff on the luma bytes of the pixels that get a stripe, for a line
+   * shifted by n pixels start at n * pixel_stride */
+  guint8 *stripes;
+
+  guint n_bands;
+  /* one line of marked blocks per band, for subsampling */
+  guint8 *mask_lines;
+  gint mask_stride;
+  GstVideoFiltersBands bands;
 };
 
 struct _GstZebraStripeClass
@@ -63,16 +63,15 @@ GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS_ANY);
 
-//static GstBaseTransformClass *parent_class = NULL;
-
 static void gst_measure_collector_finalize (GObject * object);
-static gboolean gst_measure_collector_event (GstBaseTransform * base,
+static gboolean gst_measure_collector_sink_event (GstBaseTransform * base,
     GstEvent * event);
 static void gst_measure_collector_save_csv (GstMeasureCollector * mc);
 
 static void gst_measure_collector_post_message (GstMeasureCollector * mc);
 
-GST_BOILERPLATE (GstMeasureCollector, gst_measure_collector, GstBaseTransform,
+#define gst_measure_collector_parent_class parent_class
+G_DEFINE_TYPE (GstMeasureCollector, gst_measure_collector,
     GST_TYPE_BASE_TRANSFORM);
 
 static void
@@ -118,9 +117,12 @@ static void
 gst_measure_collector_post_message (GstMeasureCollector * mc)
 {
   GstMessage *m;
+  GstStructure *s;
   guint64 i;
 
-  g_return_if_fail (mc->metric);
+  /* nothing was measured */
+  if (mc->metric == NULL)
+    return;
 
   if (strcmp (mc->metric, "SSIM") == 0) {
     gfloat dresult = 0;
@@ -142,12 +144,16 @@ gst_measure_collector_post_message (GstMeasureCollector * mc)
         mlen--;
       }
     }
-    g_value_set_float (mc->result, dresult / mlen);
+    if (mlen > 0)
+      g_value_set_float (mc->result, dresult / mlen);
   }
 
-  m = gst_message_new_element (GST_OBJECT_CAST (mc),
-      gst_structure_new ("GstMeasureCollector",
-          "measure-result", G_TYPE_VALUE, mc->result, NULL));
+  if (mc->result == NULL)
+    return;
+
+  s = gst_structure_new_empty ("GstMeasureCollector");
+  gst_structure_set_value (s, "measure-result", mc->result);
+  m = gst_message_new_element (GST_OBJECT_CAST (mc), s);
 
   gst_element_post_message (GST_ELEMENT_CAST (mc), m);
 }
@@ -165,6 +171,7 @@ gst_measure_collector_set_property (GObject * object, guint prop_id,
       measurecollector->flags = g_value_get_uint64 (value);
       break;
     case PROP_FILENAME:
+      g_free (measurecollector->filename);
       measurecollector->filename = g_value_dup_string (value);
       break;
     default:
@@ -195,7 +202,7 @@ gst_measure_collector_get_property (GObject * object, guint prop_id,
 }
 
 static gboolean
-gst_measure_collector_event (GstBaseTransform * base, GstEvent * event)
+gst_measure_collector_sink_event (GstBaseTransform * base, GstEvent * event)
 {
   GstMeasureCollector *mc = GST_MEASURE_COLLECTOR (base);
 
@@ -212,7 +219,7 @@ gst_measure_collector_event (GstBaseTransform * base, GstEvent * event)
       break;
   }
 
-  return parent_class->event (base, event);
+  return GST_BASE_TRANSFORM_CLASS (parent_class)->sink_event (base, event);
 }
 
 static void
@@ -253,7 +260,10 @@ gst_measure_collector_save_csv (GstMeasureCollector * mc)
   if (file == NULL)
     goto open_failed;
 
-  str = (GstStructure *) g_ptr_array_index (mc->measurements, 0);
+  /* take the field names from the first frame that was measured */
+  str = NULL;
+  for (i = 0; i < mc->measurements->len && str == NULL; i++)
+    str = (GstStructure *) g_ptr_array_index (mc->measurements, i);
 
   for (j = 0; j < gst_structure_n_fields (str); j++) {
     const gchar *fieldname;
@@ -311,9 +321,15 @@ open_failed:
 }
 
 static void
-gst_measure_collector_base_init (gpointer g_class)
+gst_measure_collector_class_init (GstMeasureCollectorClass * klass)
 {
-  GstElementClass *element_class = GST_ELEMENT_CLASS (g_class);
+  GObjectClass *gobject_class;
+  GstElementClass *element_class;
+  GstBaseTransformClass *trans_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  element_class = GST_ELEMENT_CLASS (klass);
+  trans_class = GST_BASE_TRANSFORM_CLASS (klass);
 
   gst_element_class_set_static_metadata (element_class,
       "Video measure collector", "Filter/Effect/Video",
@@ -324,16 +340,6 @@ gst_measure_collector_base_init (gpointer g_class)
       &gst_measure_collector_sink_template);
   gst_element_class_add_static_pad_template (element_class,
       &gst_measure_collector_src_template);
-}
-
-static void
-gst_measure_collector_class_init (GstMeasureCollectorClass * klass)
-{
-  GObjectClass *gobject_class;
-  GstBaseTransformClass *trans_class;
-
-  gobject_class = G_OBJECT_CLASS (klass);
-  trans_class = GST_BASE_TRANSFORM_CLASS (klass);
 
   GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "measurecollect", 0,
       "measurement collector");
@@ -354,22 +360,19 @@ gst_measure_collector_class_init (GstMeasureCollectorClass * klass)
           " information", "",
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
-  trans_class->event = GST_DEBUG_FUNCPTR (gst_measure_collector_event);
+  trans_class->sink_event = GST_DEBUG_FUNCPTR (gst_measure_collector_sink_event);
 
   trans_class->passthrough_on_same_caps = TRUE;
 
 }
 
 static void
-gst_measure_collector_init (GstMeasureCollector * instance,
-    GstMeasureCollectorClass * g_class)
+gst_measure_collector_init (GstMeasureCollector * measurecollector)
 {
-  GstMeasureCollector *measurecollector;
-
-  measurecollector = GST_MEASURE_COLLECTOR (instance);
-
   GST_DEBUG_OBJECT (measurecollector, "gst_measure_collector_init");
 
+  gst_base_transform_set_passthrough (GST_BASE_TRANSFORM (measurecollector),
+      TRUE);
   gst_base_transform_set_qos_enabled (GST_BASE_TRANSFORM (measurecollector),
       FALSE);
 
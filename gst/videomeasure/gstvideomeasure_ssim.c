@@ -5,7 +5,7 @@
  * modify it under the terms of the GNU Lesser General Public
  * License as published by the Free Software Foundation; either
  * version 2.1 of the License, or (at your option) any later version.
- * 
+ *
  * This library is distributed in the hope that it will be useful,
  * but WITHOUT ANY WARRANTY; without even the implied warranty of
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
@@ -20,28 +20,77 @@
 /**
  * SECTION:element-ssim
  *
- * The ssim calculates SSIM (Structural SIMilarity) index for two or more 
- * streams, for each frame.
- * First stream is the original, other streams are modified (compressed) ones.
- * ssim will calculate SSIM index of each frame of each modified stream, using 
+ * The ssim calculates SSIM (Structural SIMilarity) index and PSNR for two or
+ * more streams, for each frame.
+ * The stream on the first sink pad (the one with the lowest zorder) is the
+ * original, other streams are modified (compressed) ones. ssim will calculate
+ * the SSIM index and PSNR of each frame of each modified stream, using the
  * original stream as a reference.
  *
- * The ssim accepts only YUV planar top-first data and calculates only Y-SSIM.
- * All streams must have the same width, height and colorspace.
- * Output streams are greyscale video streams, where bright pixels indicate 
- * high SSIM values, dark pixels - low SSIM values.
- * The ssim also calculates mean SSIM index for each frame and emits is as a 
- * message.
- * ssim is intended to be used with videomeasure_collector element to catch the 
- * events (such as mean SSIM index values) and save them into a file.
+ * Only the luma plane is compared. All streams must have the same width and
+ * height. The SSIM index is computed over square windows of #GstSSim:window-size
+ * pixels without weighting, at every pixel position.
+ *
+ * The output is a greyscale video stream of the SSIM map of the first modified
+ * stream, where bright pixels indicate high SSIM values, dark pixels low SSIM
+ * values.
+ *
+ * For every frame and every modified stream an element message named "ssim"
+ * is posted with the following fields:
+ * <itemizedlist>
+ * <listitem>
+ *   <para>
+ *   #gchar *
+ *   <classname>&quot;stream&quot;</classname>:
+ *   the name of the sink pad of the modified stream.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #GstClockTime
+ *   <classname>&quot;timestamp&quot;</classname>:
+ *   the timestamp of the output frame.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #guint64
+ *   <classname>&quot;offset&quot;</classname>:
+ *   the number of the frame.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #gdouble
+ *   <classname>&quot;ssim-mean&quot;</classname>,
+ *   <classname>&quot;ssim-min&quot;</classname>,
+ *   <classname>&quot;ssim-max&quot;</classname>:
+ *   the mean, lowest and highest SSIM index of all windows of the frame.
+ *   </para>
+ * </listitem>
+ * <listitem>
+ *   <para>
+ *   #gdouble
+ *   <classname>&quot;psnr&quot;</classname>:
+ *   the luma PSNR of the frame in dB, 100 for identical frames.
+ *   </para>
+ * </listitem>
+ * </itemizedlist>
+ *
+ * When all streams are finished an element message named "ssim-summary" is
+ * posted for every modified stream, with the "stream" and "frames" fields,
+ * the "ssim-mean" and "psnr-mean" averages and the "ssim-min" and "psnr-min"
+ * of the worst frame.
+ *
+ * The measurements of the first modified stream are also sent downstream as
+ * events for the measurecollector element.
  *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
- * gst-launch ssim name=ssim ssim.src0 ! videoconvert ! glimagesink filesrc
- * location=orig.avi ! decodebin ! ssim.original filesrc location=compr.avi !
- * decodebin ! ssim.modified0
- * ]| This pipeline produces a video stream that consists of SSIM frames.
+ * gst-launch-1.0 filesrc location=orig.avi ! decodebin ! ssim name=ssim !
+ * videoconvert ! autovideosink filesrc location=compr.avi ! decodebin ! ssim.
+ * ]| This pipeline shows the SSIM map of compr.avi compared to orig.avi.
  * </refsect2>
  */
 /* Element-Checklist-Version: 5 */
@@ -52,1629 +101,897 @@
 
 #include "gstvideomeasure.h"
 #include "gstvideomeasure_ssim.h"
-#include <gst/audio/audio.h>
-#include <stdlib.h>
 #include <string.h>
 #include <math.h>
 
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
 #define GST_CAT_DEFAULT gst_ssim_debug
 GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 
-/* elementfactory information */
+#define DEFAULT_WINDOW_SIZE 8
+#define MAX_WINDOW_SIZE 32
+#define DEFAULT_THREADS 0
+#define MAX_THREADS 64
 
-#define SINK_CAPS \
-  "video/x-raw-yuv, " \
-  "format = (fourcc) { I420, YV12, Y41B, Y42B } "
+/* don't bother handing out slices smaller than this many rows */
+#define MIN_SLICE_HEIGHT 32
 
+/* reported for identical frames instead of infinity */
+#define MAX_PSNR 100.0
 
-#define SRC_CAPS \
-  "video/x-raw-gray, " \
-  "width = (int) [ 1, MAX ], " \
-  "height = (int) [ 1, MAX ], " \
-  "framerate = (fraction) [ 0/1, MAX ], " \
-  "bpp = (int) 8, " \
-  "depth = (int) 8 "
+/* SSIM stabilisation constants for 8 bit samples */
+#define SSIM_C1 (0.01 * 255 * 0.01 * 255)
+#define SSIM_C2 (0.03 * 255 * 0.03 * 255)
+
+enum
+{
+  PROP_0,
+  PROP_WINDOW_SIZE,
+  PROP_THREADS
+};
+
+struct _GstSSimSlice
+{
+  guint index;
+
+  /* the comparison this slice is part of */
+  GstVideoFrame *orig;
+  GstVideoFrame *mod;
+  GstVideoFrame *map;
+  gint windowsize;
+
+  /* per row scratch: the column sums of the 5 window statistics and the
+   * SSIM index of the windows */
+  guint32 *cols;
+  gfloat *scores;
+  gint scratch_width;
+
+  /* results, the SSIM sums go to the rows of GstSSim::row_sums */
+  gdouble ssim_min;
+  gdouble ssim_max;
+  guint64 windows;
+  guint64 sse;
+};
+
+/* elementfactory information */
+
+#define SSIM_CAPS \
+  GST_VIDEO_CAPS_MAKE ("{ I420, YV12, Y41B, Y42B, Y444, NV12, NV21, GRAY8 }")
 
 static GstStaticPadTemplate gst_ssim_src_template =
-GST_STATIC_PAD_TEMPLATE ("src_%u",
+GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
-    GST_PAD_SOMETIMES,
-    GST_STATIC_CAPS (SRC_CAPS)
-    );
-
-static GstStaticPadTemplate gst_ssim_sink_original_template =
-GST_STATIC_PAD_TEMPLATE ("original",
-    GST_PAD_SINK,
-    GST_PAD_REQUEST,
-    GST_STATIC_CAPS (SINK_CAPS)
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (SSIM_CAPS)
     );
 
-static GstStaticPadTemplate gst_ssim_sink_modified_template =
-GST_STATIC_PAD_TEMPLATE ("modified_%u",
+static GstStaticPadTemplate gst_ssim_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink_%u",
     GST_PAD_SINK,
     GST_PAD_REQUEST,
-    GST_STATIC_CAPS (SINK_CAPS)
+    GST_STATIC_CAPS (SSIM_CAPS)
     );
 
-static void gst_ssim_class_init (GstSSimClass * klass);
-static void gst_ssim_init (GstSSim * ssim);
-static void gst_ssim_finalize (GObject * object);
-
-static gboolean gst_ssim_setcaps (GstPad * pad, GstCaps * caps);
-static gboolean gst_ssim_query (GstPad * pad, GstQuery * query);
-static gboolean gst_ssim_src_event (GstPad * pad, GstEvent * event);
-static gboolean gst_ssim_sink_event (GstPad * pad, GstEvent * event);
-
-static GstPad *gst_ssim_request_new_pad (GstElement * element,
-    GstPadTemplate * temp, const gchar * unused);
-static void gst_ssim_release_pad (GstElement * element, GstPad * pad);
+G_DEFINE_TYPE (GstSSimPad, gst_ssim_pad, GST_TYPE_VIDEO_AGGREGATOR_PAD);
 
-static GstStateChangeReturn gst_ssim_change_state (GstElement * element,
-    GstStateChange transition);
-
-static GstFlowReturn gst_ssim_collected (GstCollectPads * pads,
-    gpointer user_data);
-
-static GstElementClass *parent_class = NULL;
+static void
+gst_ssim_pad_reset (GstSSimPad * pad)
+{
+  pad->frames = 0;
+  pad->ssim_sum = 0.0;
+  pad->ssim_min = G_MAXDOUBLE;
+  pad->psnr_sum = 0.0;
+  pad->psnr_min = G_MAXDOUBLE;
+}
 
-GType
-gst_ssim_get_type (void)
+static void
+gst_ssim_pad_class_init (GstSSimPadClass * klass)
 {
-  static GType ssim_type = 0;
-
-  if (G_UNLIKELY (ssim_type == 0)) {
-    static const GTypeInfo ssim_info = {
-      sizeof (GstSSimClass), NULL, NULL,
-      (GClassInitFunc) gst_ssim_class_init, NULL, NULL,
-      sizeof (GstSSim), 0,
-      (GInstanceInitFunc) gst_ssim_init,
-    };
-
-    ssim_type = g_type_register_static (GST_TYPE_ELEMENT, "GstSSim",
-        &ssim_info, 0);
-    GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "ssim", 0, "SSIM calculator");
-  }
-  return ssim_type;
 }
 
 static void
-gst_ssim_post_message (GstSSim * ssim, GstBuffer * buffer, gfloat mssim,
-    gfloat lowest, gfloat highest)
+gst_ssim_pad_init (GstSSimPad * pad)
 {
-  GstMessage *m;
-  guint64 offset;
+  gst_ssim_pad_reset (pad);
+}
 
-  offset = GST_BUFFER_OFFSET (buffer);
+#define gst_ssim_parent_class parent_class
+G_DEFINE_TYPE (GstSSim, gst_ssim, GST_TYPE_VIDEO_AGGREGATOR);
 
-  m = gst_message_new_element (GST_OBJECT_CAST (ssim),
-      gst_structure_new ("SSIM",
-          "offset", G_TYPE_UINT64, offset,
-          "timestamp", GST_TYPE_CLOCK_TIME, GST_BUFFER_TIMESTAMP (buffer),
-          "mean", G_TYPE_FLOAT, mssim,
-          "lowest", G_TYPE_FLOAT, lowest,
-          "highest", G_TYPE_FLOAT, highest, NULL));
+/* Adds (or removes) a row of both pictures to the column sums of the window
+ * statistics: the sums of the original and modified samples, of their
+ * squares and of their products. The column sums of a window never exceed
+ * MAX_WINDOW_SIZE * 255 * 255, so they fit 32 bits. */
+static void
+ssim_accumulate_row (const guint8 * orig, const guint8 * mod, guint32 * cols,
+    gint width, gboolean subtract)
+{
+  guint32 *sum_o = cols;
+  guint32 *sum_m = cols + width;
+  guint32 *sum_oo = cols + 2 * width;
+  guint32 *sum_mm = cols + 3 * width;
+  guint32 *sum_om = cols + 4 * width;
+  gint x = 0;
+
+#if defined (__SSE2__)
+  const __m128i zero = _mm_setzero_si128 ();
+
+#define ACC4(p, v) G_STMT_START {                                       \
+  __m128i s = _mm_loadu_si128 ((const __m128i *) (p));                  \
+  s = subtract ? _mm_sub_epi32 (s, v) : _mm_add_epi32 (s, v);           \
+  _mm_storeu_si128 ((__m128i *) (p), s);                                \
+} G_STMT_END
+#define ACC8(p, v) G_STMT_START {                                       \
+  __m128i lo = _mm_unpacklo_epi16 (v, zero);                            \
+  __m128i hi = _mm_unpackhi_epi16 (v, zero);                            \
+  ACC4 (p, lo);                                                         \
+  ACC4 ((p) + 4, hi);                                                   \
+} G_STMT_END
+
+  for (; x + 16 <= width; x += 16) {
+    __m128i vo = _mm_loadu_si128 ((const __m128i *) (orig + x));
+    __m128i vm = _mm_loadu_si128 ((const __m128i *) (mod + x));
+    gint i;
 
-  GST_DEBUG_OBJECT (GST_OBJECT (ssim), "Frame %" G_GINT64_FORMAT
-      " @ %" GST_TIME_FORMAT " mean SSIM is %f, l-h is %f-%f", offset,
-      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)), mssim, lowest, highest);
+    for (i = 0; i < 16; i += 8) {
+      __m128i o16 = i ? _mm_unpackhi_epi8 (vo, zero) :
+          _mm_unpacklo_epi8 (vo, zero);
+      __m128i m16 = i ? _mm_unpackhi_epi8 (vm, zero) :
+          _mm_unpacklo_epi8 (vm, zero);
+      /* the products fit 16 unsigned bits */
+      __m128i oo16 = _mm_mullo_epi16 (o16, o16);
+      __m128i mm16 = _mm_mullo_epi16 (m16, m16);
+      __m128i om16 = _mm_mullo_epi16 (o16, m16);
+
+      ACC8 (sum_o + x + i, o16);
+      ACC8 (sum_m + x + i, m16);
+      ACC8 (sum_oo + x + i, oo16);
+      ACC8 (sum_mm + x + i, mm16);
+      ACC8 (sum_om + x + i, om16);
+    }
+  }
 
-  gst_element_post_message (GST_ELEMENT_CAST (ssim), m);
-}
+#undef ACC8
+#undef ACC4
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+
+#define ACC4(p, v) G_STMT_START {                                       \
+  uint32x4_t s = vld1q_u32 (p);                                         \
+  s = subtract ? vsubw_u16 (s, v) : vaddw_u16 (s, v);                   \
+  vst1q_u32 (p, s);                                                     \
+} G_STMT_END
+#define ACC8(p, v) G_STMT_START {                                       \
+  ACC4 (p, vget_low_u16 (v));                                           \
+  ACC4 ((p) + 4, vget_high_u16 (v));                                    \
+} G_STMT_END
+
+  for (; x + 8 <= width; x += 8) {
+    uint16x8_t o16 = vmovl_u8 (vld1_u8 (orig + x));
+    uint16x8_t m16 = vmovl_u8 (vld1_u8 (mod + x));
+    uint16x8_t oo16 = vmulq_u16 (o16, o16);
+    uint16x8_t mm16 = vmulq_u16 (m16, m16);
+    uint16x8_t om16 = vmulq_u16 (o16, m16);
+
+    ACC8 (sum_o + x, o16);
+    ACC8 (sum_m + x, m16);
+    ACC8 (sum_oo + x, oo16);
+    ACC8 (sum_mm + x, mm16);
+    ACC8 (sum_om + x, om16);
+  }
+
+#undef ACC8
+#undef ACC4
+#endif
 
-static GstCaps *
-gst_ssim_src_getcaps (GstPad * pad)
-{
-  GstCaps *result;
-  gchar *capstr;
-
-  result = gst_caps_copy (gst_pad_get_pad_template_caps (pad));
-  capstr = gst_caps_to_string (result);
-  GST_DEBUG ("getsrccaps - return static caps: %s", capstr);
-  g_free (capstr);
-  return result;
+  if (subtract) {
+    for (; x < width; x++) {
+      sum_o[x] -= orig[x];
+      sum_m[x] -= mod[x];
+      sum_oo[x] -= orig[x] * orig[x];
+      sum_mm[x] -= mod[x] * mod[x];
+      sum_om[x] -= orig[x] * mod[x];
+    }
+  } else {
+    for (; x < width; x++) {
+      sum_o[x] += orig[x];
+      sum_m[x] += mod[x];
+      sum_oo[x] += orig[x] * orig[x];
+      sum_mm[x] += mod[x] * mod[x];
+      sum_om[x] += orig[x] * mod[x];
+    }
+  }
 }
 
-static GstCaps *
-gst_ssim_sink_getcaps (GstPad * pad)
+/* Sum of squared differences of a row */
+static guint64
+ssim_row_sse (const guint8 * orig, const guint8 * mod, gint width)
 {
-  GstCaps *result = NULL;
-  GstSSim *ssim;
-  gchar *capstr;
-
-  ssim = GST_SSIM (GST_PAD_PARENT (pad));
+  guint64 sse = 0;
+  gint x = 0;
 
-  GST_OBJECT_LOCK (ssim);
+#if defined (__SSE2__)
+  {
+    const __m128i zero = _mm_setzero_si128 ();
+    __m128i acc = zero;
+    guint32 lanes[4];
+
+    /* each 32 bit lane grows by at most 4 * 255 * 255 per 16 samples, so
+     * flush to 64 bits every 1024 iterations */
+    while (x + 16 <= width) {
+      gint end = MIN (width, x + 16 * 1024);
+
+      for (; x + 16 <= end; x += 16) {
+        __m128i vo = _mm_loadu_si128 ((const __m128i *) (orig + x));
+        __m128i vm = _mm_loadu_si128 ((const __m128i *) (mod + x));
+        __m128i d;
+
+        d = _mm_sub_epi16 (_mm_unpacklo_epi8 (vo, zero),
+            _mm_unpacklo_epi8 (vm, zero));
+        acc = _mm_add_epi32 (acc, _mm_madd_epi16 (d, d));
+        d = _mm_sub_epi16 (_mm_unpackhi_epi8 (vo, zero),
+            _mm_unpackhi_epi8 (vm, zero));
+        acc = _mm_add_epi32 (acc, _mm_madd_epi16 (d, d));
+      }
 
-  result = gst_pad_get_fixed_caps_func (pad);
-  capstr = gst_caps_to_string (result);
-  GST_DEBUG ("getsinkcaps - return caps: %s", capstr);
-  g_free (capstr);
+      _mm_storeu_si128 ((__m128i *) lanes, acc);
+      sse += (guint64) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+      acc = zero;
+    }
+  }
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+  {
+    uint32x4_t acc;
 
-  GST_OBJECT_UNLOCK (ssim);
+    while (x + 16 <= width) {
+      gint end = MIN (width, x + 16 * 1024);
 
-  return result;
-}
+      acc = vdupq_n_u32 (0);
+      for (; x + 16 <= end; x += 16) {
+        uint8x16_t d = vabdq_u8 (vld1q_u8 (orig + x), vld1q_u8 (mod + x));
 
-static void
-calculate_mu (GstSSim * ssim, gfloat * outmu, guint8 * buf)
-{
-  gint oy, ox, iy, ix;
-
-  for (oy = 0; oy < ssim->height; oy++) {
-    for (ox = 0; ox < ssim->width; ox++) {
-      gfloat mu = 0;
-      gfloat elsumm;
-      gint weight_y_base, weight_x_base;
-      gint weight_offset;
-      gint pixel_offset;
-      gint winstart_y;
-      gint wghstart_y;
-      gint winend_y;
-      gint winstart_x;
-      gint wghstart_x;
-      gint winend_x;
-      gfloat weight;
-      gint source_offset;
-
-      source_offset = oy * ssim->width + ox;
-
-      winstart_x = ssim->windows[source_offset].x_window_start;
-      wghstart_x = ssim->windows[source_offset].x_weight_start;
-      winend_x = ssim->windows[source_offset].x_window_end;
-      winstart_y = ssim->windows[source_offset].y_window_start;
-      wghstart_y = ssim->windows[source_offset].y_weight_start;
-      winend_y = ssim->windows[source_offset].y_window_end;
-      elsumm = ssim->windows[source_offset].element_summ;
-
-      switch (ssim->windowtype) {
-        case 0:
-          for (iy = winstart_y; iy <= winend_y; iy++) {
-            pixel_offset = iy * ssim->width;
-            for (ix = winstart_x; ix <= winend_x; ix++)
-              mu += buf[pixel_offset + ix];
-          }
-          mu = mu / elsumm;
-          break;
-        case 1:
-
-          weight_y_base = wghstart_y - winstart_y;
-          weight_x_base = wghstart_x - winstart_x;
-
-          for (iy = winstart_y; iy <= winend_y; iy++) {
-            pixel_offset = iy * ssim->width;
-            weight_offset = (weight_y_base + iy) * ssim->windowsize +
-                weight_x_base;
-            for (ix = winstart_x; ix <= winend_x; ix++) {
-              weight = ssim->weights[weight_offset + ix];
-              mu += weight * buf[pixel_offset + ix];
-            }
-          }
-          mu = mu / elsumm;
-          break;
+        acc = vpadalq_u16 (acc, vmull_u8 (vget_low_u8 (d), vget_low_u8 (d)));
+        acc = vpadalq_u16 (acc, vmull_u8 (vget_high_u8 (d),
+                vget_high_u8 (d)));
       }
-      outmu[oy * ssim->width + ox] = mu;
+
+      sse += (guint64) vgetq_lane_u32 (acc, 0) + vgetq_lane_u32 (acc, 1) +
+          vgetq_lane_u32 (acc, 2) + vgetq_lane_u32 (acc, 3);
     }
   }
+#endif
+
+  for (; x < width; x++) {
+    gint d = orig[x] - mod[x];
 
+    sse += d * d;
+  }
+
+  return sse;
 }
 
+/* Slides a window of @n columns along the column sums of a row of windows and
+ * stores the SSIM index of each of the @n_windows windows in @scores */
 static void
-calcssim_without_mu (GstSSim * ssim, guint8 * org, gfloat * orgmu, guint8 * mod,
-    guint8 * out, gfloat * mean, gfloat * lowest, gfloat * highest)
+ssim_score_row (const guint32 * cols, gint width, gint n, gfloat * scores,
+    gint n_windows)
 {
-  gint oy, ox, iy, ix;
-  gfloat cumulative_ssim = 0;
-  *lowest = G_MAXFLOAT;
-  *highest = -G_MAXFLOAT;
-
-  for (oy = 0; oy < ssim->height; oy++) {
-    for (ox = 0; ox < ssim->width; ox++) {
-      gfloat mu_o = 128, mu_m = 128;
-      gdouble sigma_o = 0, sigma_m = 0, sigma_om = 0;
-      gfloat tmp1 = 0, tmp2 = 0;
-      gfloat elsumm = 0;
-      gint weight_y_base, weight_x_base;
-      gint weight_offset;
-      gint pixel_offset;
-      gint winstart_y;
-      gint wghstart_y;
-      gint winend_y;
-      gint winstart_x;
-      gint wghstart_x;
-      gint winend_x;
-      gfloat weight;
-      gint source_offset;
-
-      source_offset = oy * ssim->width + ox;
-
-      winstart_x = ssim->windows[source_offset].x_window_start;
-      wghstart_x = ssim->windows[source_offset].x_weight_start;
-      winend_x = ssim->windows[source_offset].x_window_end;
-      winstart_y = ssim->windows[source_offset].y_window_start;
-      wghstart_y = ssim->windows[source_offset].y_weight_start;
-      winend_y = ssim->windows[source_offset].y_window_end;
-      elsumm = ssim->windows[source_offset].element_summ;
-
-      weight_y_base = wghstart_y - winstart_y;
-      weight_x_base = wghstart_x - winstart_x;
-      switch (ssim->windowtype) {
-        case 0:
-          for (iy = winstart_y; iy <= winend_y; iy++) {
-            guint8 *org_with_offset, *mod_with_offset;
-            pixel_offset = iy * ssim->width;
-            org_with_offset = &org[pixel_offset];
-            mod_with_offset = &mod[pixel_offset];
-            for (ix = winstart_x; ix <= winend_x; ix++) {
-              tmp1 = org_with_offset[ix] - mu_o;
-              sigma_o += tmp1 * tmp1;
-              tmp2 = mod_with_offset[ix] - mu_m;
-              sigma_m += tmp2 * tmp2;
-              sigma_om += tmp1 * tmp2;
-            }
-          }
-          break;
-        case 1:
-
-          weight_y_base = wghstart_y - winstart_y;
-          weight_x_base = wghstart_x - winstart_x;
-
-          for (iy = winstart_y; iy <= winend_y; iy++) {
-            guint8 *org_with_offset, *mod_with_offset;
-            gfloat *weights_with_offset;
-            gfloat wt1, wt2;
-            pixel_offset = iy * ssim->width;
-            weight_offset = (weight_y_base + iy) * ssim->windowsize +
-                weight_x_base;
-            org_with_offset = &org[pixel_offset];
-            mod_with_offset = &mod[pixel_offset];
-            weights_with_offset = &ssim->weights[weight_offset];
-            for (ix = winstart_x; ix <= winend_x; ix++) {
-              weight = weights_with_offset[ix];
-              tmp1 = org_with_offset[ix] - mu_o;
-              tmp2 = mod_with_offset[ix] - mu_m;
-              wt1 = weight * tmp1;
-              wt2 = weight * tmp2;
-              sigma_o += wt1 * tmp1;
-              sigma_m += wt2 * tmp2;
-              sigma_om += wt1 * tmp2;
-            }
-          }
-          break;
-      }
-      sigma_o = sqrt (sigma_o / elsumm);
-      sigma_m = sqrt (sigma_m / elsumm);
-      sigma_om = sigma_om / elsumm;
-      tmp1 = (2 * mu_o * mu_m + ssim->const1) * (2 * sigma_om + ssim->const2) /
-          ((mu_o * mu_o + mu_m * mu_m + ssim->const1) *
-          (sigma_o * sigma_o + sigma_m * sigma_m + ssim->const2));
-
-      /* SSIM can go negative, that's why it is
-         127 + index * 128 instead of index * 255 */
-      out[oy * ssim->width + ox] = 127 + tmp1 * 128;
-      *lowest = MIN (*lowest, tmp1);
-      *highest = MAX (*highest, tmp1);
-      cumulative_ssim += tmp1;
+  const guint32 *sum_o = cols;
+  const guint32 *sum_m = cols + width;
+  const guint32 *sum_oo = cols + 2 * width;
+  const guint32 *sum_mm = cols + 3 * width;
+  const guint32 *sum_om = cols + 4 * width;
+  const gint64 area = n * n;
+  const gdouble c1 = SSIM_C1 * area * area;
+  const gdouble c2 = SSIM_C2 * area * area;
+  guint32 o = 0, m = 0, oo = 0, mm = 0, om = 0;
+  gint x;
+
+  for (x = 0; x < n; x++) {
+    o += sum_o[x];
+    m += sum_m[x];
+    oo += sum_oo[x];
+    mm += sum_mm[x];
+    om += sum_om[x];
+  }
+
+  for (x = 0; x < n_windows; x++) {
+    /* all terms scaled by area^2, exact in 64 bits */
+    gint64 om_mean = (gint64) o * m;
+    gint64 oo_mean = (gint64) o * o;
+    gint64 mm_mean = (gint64) m * m;
+    gint64 var = area * oo - oo_mean + area * mm - mm_mean;
+    gint64 cov = area * om - om_mean;
+
+    scores[x] = ((2.0 * om_mean + c1) * (2.0 * cov + c2)) /
+        (((gdouble) oo_mean + mm_mean + c1) * ((gdouble) var + c2));
+
+    if (x + 1 < n_windows) {
+      o += sum_o[x + n] - sum_o[x];
+      m += sum_m[x + n] - sum_m[x];
+      oo += sum_oo[x + n] - sum_oo[x];
+      mm += sum_mm[x + n] - sum_mm[x];
+      om += sum_om[x + n] - sum_om[x];
     }
   }
-  *mean = cumulative_ssim / (ssim->width * ssim->height);
 }
 
+/* Writes a row of the SSIM map. The window of a pixel is centered on it,
+ * clamped to the windows that fit the picture. */
 static void
-calcssim_canonical (GstSSim * ssim, guint8 * org, gfloat * orgmu, guint8 * mod,
-    guint8 * out, gfloat * mean, gfloat * lowest, gfloat * highest)
+ssim_write_map_row (guint8 * out, gint width, const gfloat * scores,
+    gint n_windows, gint half)
 {
-  gint oy, ox, iy, ix;
-  gfloat cumulative_ssim = 0;
-  *lowest = G_MAXFLOAT;
-  *highest = -G_MAXFLOAT;
-
-  for (oy = 0; oy < ssim->height; oy++) {
-    for (ox = 0; ox < ssim->width; ox++) {
-      gfloat mu_o = 0, mu_m = 0;
-      gdouble sigma_o = 0, sigma_m = 0, sigma_om = 0;
-      gfloat tmp1, tmp2;
-      gfloat elsumm = 0;
-      gint weight_y_base, weight_x_base;
-      gint weight_offset;
-      gint pixel_offset;
-      gint winstart_y;
-      gint wghstart_y;
-      gint winend_y;
-      gint winstart_x;
-      gint wghstart_x;
-      gint winend_x;
-      gfloat weight;
-      gint source_offset;
-
-      source_offset = oy * ssim->width + ox;
-
-      winstart_x = ssim->windows[source_offset].x_window_start;
-      wghstart_x = ssim->windows[source_offset].x_weight_start;
-      winend_x = ssim->windows[source_offset].x_window_end;
-      winstart_y = ssim->windows[source_offset].y_window_start;
-      wghstart_y = ssim->windows[source_offset].y_weight_start;
-      winend_y = ssim->windows[source_offset].y_window_end;
-      elsumm = ssim->windows[source_offset].element_summ;
-
-      switch (ssim->windowtype) {
-        case 0:
-          for (iy = winstart_y; iy <= winend_y; iy++) {
-            pixel_offset = iy * ssim->width;
-            for (ix = winstart_x; ix <= winend_x; ix++) {
-              mu_m += mod[pixel_offset + ix];
-            }
-          }
-          mu_m = mu_m / elsumm;
-          mu_o = orgmu[oy * ssim->width + ox];
-          for (iy = winstart_y; iy <= winend_y; iy++) {
-            pixel_offset = iy * ssim->width;
-            for (ix = winstart_x; ix <= winend_x; ix++) {
-              tmp1 = org[pixel_offset + ix] - mu_o;
-              tmp2 = mod[pixel_offset + ix] - mu_m;
-              sigma_o += tmp1 * tmp1;
-              sigma_m += tmp2 * tmp2;
-              sigma_om += tmp1 * tmp2;
-            }
-          }
-          break;
-        case 1:
-
-          weight_y_base = wghstart_y - winstart_y;
-          weight_x_base = wghstart_x - winstart_x;
-
-          for (iy = winstart_y; iy <= winend_y; iy++) {
-            pixel_offset = iy * ssim->width;
-            weight_offset = (weight_y_base + iy) * ssim->windowsize +
-                weight_x_base;
-            for (ix = winstart_x; ix <= winend_x; ix++) {
-              weight = ssim->weights[weight_offset + ix];
-              mu_o += weight * org[pixel_offset + ix];
-              mu_m += weight * mod[pixel_offset + ix];
-            }
-          }
-          mu_m = mu_m / elsumm;
-          mu_o = orgmu[oy * ssim->width + ox];
-          for (iy = winstart_y; iy <= winend_y; iy++) {
-            gfloat *weights_with_offset;
-            guint8 *org_with_offset, *mod_with_offset;
-            gfloat wt1, wt2;
-            pixel_offset = iy * ssim->width;
-            weight_offset = (weight_y_base + iy) * ssim->windowsize +
-                weight_x_base;
-            weights_with_offset = &ssim->weights[weight_offset];
-            org_with_offset = &org[pixel_offset];
-            mod_with_offset = &mod[pixel_offset];
-            for (ix = winstart_x; ix <= winend_x; ix++) {
-              weight = weights_with_offset[ix];
-              tmp1 = org_with_offset[ix] - mu_o;
-              tmp2 = mod_with_offset[ix] - mu_m;
-              wt1 = weight * tmp1;
-              wt2 = weight * tmp2;
-              sigma_o += wt1 * tmp1;
-              sigma_m += wt2 * tmp2;
-              sigma_om += wt1 * tmp2;
-            }
-          }
-          break;
-      }
-      sigma_o = sqrt (sigma_o / elsumm);
-      sigma_m = sqrt (sigma_m / elsumm);
-      sigma_om = sigma_om / elsumm;
-      tmp1 = (2 * mu_o * mu_m + ssim->const1) * (2 * sigma_om + ssim->const2) /
-          ((mu_o * mu_o + mu_m * mu_m + ssim->const1) *
-          (sigma_o * sigma_o + sigma_m * sigma_m + ssim->const2));
-
-      /* SSIM can go negative, that's why it is
-         127 + index * 128 instead of index * 255 */
-      out[oy * ssim->width + ox] = 127 + tmp1 * 128;
-      *lowest = MIN (*lowest, tmp1);
-      *highest = MAX (*highest, tmp1);
-      cumulative_ssim += tmp1;
-    }
+  gint x;
+
+  for (x = 0; x < width; x++) {
+    gint w = CLAMP (x - half, 0, n_windows - 1);
+
+    out[x] = CLAMP (127 + scores[w] * 128, 0, 255);
   }
-  *mean = cumulative_ssim / (ssim->width * ssim->height);
 }
 
-
-/* the first caps we receive on any of the sinkpads will define the caps for all
- * the other sinkpads because we can only measure streams with the same caps.
- */
-static gboolean
-gst_ssim_setcaps (GstPad * pad, GstCaps * caps)
+static void
+gst_ssim_compare_slice (GstSSimSlice * slice, GstSSim * ssim)
 {
-  GstSSim *ssim;
-  GList *pads;
-  const char *media_type;
-  GstStructure *capsstr;
-  gint width, height, fps_n, fps_d;
-  guint32 fourcc;
-
-  ssim = GST_SSIM (GST_PAD_PARENT (pad));
+  const guint8 *orig = GST_VIDEO_FRAME_COMP_DATA (slice->orig, 0);
+  const guint8 *mod = GST_VIDEO_FRAME_COMP_DATA (slice->mod, 0);
+  gint orig_stride = GST_VIDEO_FRAME_COMP_STRIDE (slice->orig, 0);
+  gint mod_stride = GST_VIDEO_FRAME_COMP_STRIDE (slice->mod, 0);
+  gint width = GST_VIDEO_FRAME_COMP_WIDTH (slice->orig, 0);
+  gint height = GST_VIDEO_FRAME_COMP_HEIGHT (slice->orig, 0);
+  gint n = slice->windowsize;
+  gint half = n / 2;
+  gint n_windows = width - n + 1;
+  gint n_rows = height - n + 1;
+  gint y, y0, y1, oy;
+
+  slice->ssim_min = G_MAXDOUBLE;
+  slice->ssim_max = -G_MAXDOUBLE;
+  slice->sse = 0;
+
+  /* rows of windows */
+  y0 = n_rows * slice->index / ssim->n_slices;
+  y1 = n_rows * (slice->index + 1) / ssim->n_slices;
+  slice->windows = (guint64) (y1 - y0) * n_windows;
+
+  memset (slice->cols, 0, 5 * width * sizeof (guint32));
+  for (y = y0; y < y0 + n - 1; y++)
+    ssim_accumulate_row (orig + y * orig_stride, mod + y * mod_stride,
+        slice->cols, width, FALSE);
+
+  for (y = y0; y < y1; y++) {
+    gdouble row_sum = 0.0;
+    gint x;
+
+    if (y > y0)
+      ssim_accumulate_row (orig + (y - 1) * orig_stride,
+          mod + (y - 1) * mod_stride, slice->cols, width, TRUE);
+    ssim_accumulate_row (orig + (y + n - 1) * orig_stride,
+        mod + (y + n - 1) * mod_stride, slice->cols, width, FALSE);
+
+    ssim_score_row (slice->cols, width, n, slice->scores, n_windows);
+
+    for (x = 0; x < n_windows; x++) {
+      gfloat s = slice->scores[x];
+
+      row_sum += s;
+      if (s < slice->ssim_min)
+        slice->ssim_min = s;
+      if (s > slice->ssim_max)
+        slice->ssim_max = s;
+    }
+    ssim->row_sums[y] = row_sum;
 
-  GST_DEBUG_OBJECT (ssim, "setting caps on pad %p,%s to %" GST_PTR_FORMAT, pad,
-      GST_PAD_NAME (pad), caps);
+    if (slice->map) {
+      guint8 *out = GST_VIDEO_FRAME_COMP_DATA (slice->map, 0);
+      gint out_stride = GST_VIDEO_FRAME_COMP_STRIDE (slice->map, 0);
+      gint first = y == 0 ? 0 : y + half;
+      gint last = y == n_rows - 1 ? height - 1 : y + half;
 
-  capsstr = gst_caps_get_structure (caps, 0);
-  gst_structure_get_int (capsstr, "width", &width);
-  gst_structure_get_int (capsstr, "height", &height);
-  gst_structure_get_fraction (capsstr, "framerate", &fps_n, &fps_d);
-  gst_structure_get_fourcc (capsstr, "format", &fourcc);
+      for (oy = first; oy <= last; oy++)
+        ssim_write_map_row (out + oy * out_stride, width, slice->scores,
+            n_windows, half);
+    }
+  }
 
-  GST_OBJECT_LOCK (ssim);
+  /* rows of samples */
+  y0 = height * slice->index / ssim->n_slices;
+  y1 = height * (slice->index + 1) / ssim->n_slices;
+  for (y = y0; y < y1; y++)
+    slice->sse += ssim_row_sse (orig + y * orig_stride, mod + y * mod_stride,
+        width);
+}
 
-  /* Sink caps are stored only once. At the moment it doesn't feel
-   * right to measure streams with variable caps.
-   */
-  if (G_UNLIKELY (!ssim->sinkcaps)) {
-    GstStructure *newstr;
-    GValue list = { 0, }
-    , fourcc = {
-    0,};
-
-    g_value_init (&list, GST_TYPE_LIST);
-    g_value_init (&fourcc, GST_TYPE_FOURCC);
-
-    gst_value_set_fourcc (&fourcc, GST_MAKE_FOURCC ('I', '4', '2', '0'));
-    gst_value_list_append_value (&list, &fourcc);
-    gst_value_set_fourcc (&fourcc, GST_MAKE_FOURCC ('Y', 'V', '1', '2'));
-    gst_value_list_append_value (&list, &fourcc);
-    gst_value_set_fourcc (&fourcc, GST_MAKE_FOURCC ('Y', '4', '1', 'B'));
-    gst_value_list_append_value (&list, &fourcc);
-    gst_value_set_fourcc (&fourcc, GST_MAKE_FOURCC ('Y', '4', '2', 'B'));
-    gst_value_list_append_value (&list, &fourcc);
-
-    newstr = gst_structure_new ("video/x-raw-yuv", NULL);
-    gst_structure_set (newstr, "width", G_TYPE_INT, width, NULL);
-    gst_structure_set (newstr, "height", G_TYPE_INT, height, NULL);
-    gst_structure_set_value (newstr, "format", &list);
-
-    ssim->sinkcaps = gst_caps_new_full (newstr, NULL);
-
-    g_value_unset (&list);
-    g_value_unset (&fourcc);
-  }
+static void
+gst_ssim_compare_slice_func (GstSSimSlice * slice, GstSSim * ssim)
+{
+  gst_ssim_compare_slice (slice, ssim);
 
-  if (G_UNLIKELY (!ssim->srccaps)) {
-    GstStructure *newstr;
-
-    newstr = gst_structure_new ("video/x-raw-gray", NULL);
-    gst_structure_set (newstr, "width", G_TYPE_INT, width, NULL);
-    gst_structure_set (newstr, "height", G_TYPE_INT, height, NULL);
-    gst_structure_set (newstr, "framerate", GST_TYPE_FRACTION, fps_n, fps_d,
-        NULL);
-    /* Calculates SSIM only for Y channel, hence the output is monochrome.
-     * TODO: an option (a mask?) to calculate SSIM for more than one channel,
-     * will probably output RGB, one metric per channel...that would
-     * look kinda funny :)
-     */
-    gst_structure_set (newstr, "bpp", G_TYPE_INT, 8, "depth", G_TYPE_INT, 8,
-        NULL);
-
-    ssim->srccaps = gst_caps_new_full (newstr, NULL);
-  }
+  g_mutex_lock (&ssim->slice_lock);
+  if (--ssim->slices_pending == 0)
+    g_cond_signal (&ssim->slice_cond);
+  g_mutex_unlock (&ssim->slice_lock);
+}
 
-  pads = GST_ELEMENT (ssim)->pads;
-  while (pads) {
-    GstPadDirection direction;
-    GstPad *otherpad = GST_PAD (pads->data);
-    direction = gst_pad_get_direction (otherpad);
-
-    GST_DEBUG_OBJECT (ssim, "checking caps on pad %p", otherpad);
-    if (direction == GST_PAD_SINK) {
-      gchar *capstr;
-      capstr = gst_caps_to_string (GST_PAD_CAPS (otherpad));
-      GST_DEBUG_OBJECT (ssim, "old caps on pad %p,%s were %s", otherpad,
-          GST_PAD_NAME (otherpad), capstr);
-      g_free (capstr);
-      gst_caps_replace (&GST_PAD_CAPS (otherpad), ssim->sinkcaps);
-      capstr = gst_caps_to_string (ssim->sinkcaps);
-      GST_DEBUG_OBJECT (ssim, "new caps on pad %p,%s are %s", otherpad,
-          GST_PAD_NAME (otherpad), capstr);
-      g_free (capstr);
-    } else if (direction == GST_PAD_SRC) {
-      gst_caps_replace (&GST_PAD_CAPS (otherpad), ssim->srccaps);
+typedef struct
+{
+  gdouble ssim_mean;
+  gdouble ssim_min;
+  gdouble ssim_max;
+  gdouble psnr;
+} GstSSimResult;
+
+/* Compares the luma planes of @orig and @mod, which have the same size, and
+ * writes the SSIM map to @map if not %NULL */
+static void
+gst_ssim_compare (GstSSim * ssim, GstVideoFrame * orig, GstVideoFrame * mod,
+    GstVideoFrame * map, gint windowsize, GstSSimResult * result)
+{
+  gint width = GST_VIDEO_FRAME_COMP_WIDTH (orig, 0);
+  gint height = GST_VIDEO_FRAME_COMP_HEIGHT (orig, 0);
+  gdouble ssim_sum = 0.0, mse;
+  guint64 windows = 0, sse = 0;
+  gint y;
+  guint i;
+
+  windowsize = MIN (windowsize, MIN (width, height));
+  ssim->n_slices = CLAMP ((height - windowsize + 1) / MIN_SLICE_HEIGHT, 1,
+      ssim->n_threads);
+
+  if (ssim->n_row_sums < height) {
+    g_free (ssim->row_sums);
+    ssim->row_sums = g_new (gdouble, height);
+    ssim->n_row_sums = height;
+  }
+
+  for (i = 0; i < ssim->n_slices; i++) {
+    GstSSimSlice *slice = &ssim->slices[i];
+
+    slice->orig = orig;
+    slice->mod = mod;
+    slice->map = map;
+    slice->windowsize = windowsize;
+
+    if (slice->scratch_width < width) {
+      g_free (slice->cols);
+      g_free (slice->scores);
+      slice->cols = g_new (guint32, 5 * width);
+      slice->scores = g_new (gfloat, width);
+      slice->scratch_width = width;
     }
-    pads = g_list_next (pads);
   }
 
-  /* parse caps now */
-  media_type = gst_structure_get_name (capsstr);
-  GST_DEBUG_OBJECT (ssim, "media type is %s", media_type);
-  if (strcmp (media_type, "video/x-raw-yuv") == 0) {
-    ssim->width = width;
-    ssim->height = height;
-    ssim->frame_rate = fps_n;
-    ssim->frame_rate_base = fps_d;
-
-    GST_INFO_OBJECT (ssim, "parse_caps sets ssim to yuv format "
-        "%d, %dx%d, %d/%d fps", fourcc, ssim->width, ssim->height,
-        ssim->frame_rate, ssim->frame_rate_base);
-
-    /* Only planar formats are supported.
-     * TODO: implement support for interleaved formats
-     * Only YUV formats are supported. There's no sense in calculating the
-     * index for R, G or B channels separately.
-     */
-    switch (fourcc) {
-      case GST_MAKE_FOURCC ('I', '4', '2', '0'):
-      case GST_MAKE_FOURCC ('Y', 'V', '1', '2'):
-      case GST_MAKE_FOURCC ('Y', '4', '1', 'B'):
-      case GST_MAKE_FOURCC ('Y', '4', '2', 'B'):
-        break;
-      default:
-        goto not_supported;
-    }
+  if (ssim->pool && ssim->n_slices > 1) {
+    ssim->slices_pending = ssim->n_slices - 1;
+    for (i = 1; i < ssim->n_slices; i++)
+      g_thread_pool_push (ssim->pool, &ssim->slices[i], NULL);
 
+    gst_ssim_compare_slice (&ssim->slices[0], ssim);
+
+    g_mutex_lock (&ssim->slice_lock);
+    while (ssim->slices_pending > 0)
+      g_cond_wait (&ssim->slice_cond, &ssim->slice_lock);
+    g_mutex_unlock (&ssim->slice_lock);
   } else {
-    goto not_supported;
+    gst_ssim_compare_slice (&ssim->slices[0], ssim);
   }
 
-  GST_OBJECT_UNLOCK (ssim);
-  return TRUE;
-  /* ERRORS */
-not_supported:
-  {
-    GST_OBJECT_UNLOCK (ssim);
-    GST_DEBUG_OBJECT (ssim, "unsupported format set as caps");
-    return FALSE;
+  result->ssim_min = G_MAXDOUBLE;
+  result->ssim_max = -G_MAXDOUBLE;
+  for (i = 0; i < ssim->n_slices; i++) {
+    GstSSimSlice *slice = &ssim->slices[i];
+
+    windows += slice->windows;
+    sse += slice->sse;
+    result->ssim_min = MIN (result->ssim_min, slice->ssim_min);
+    result->ssim_max = MAX (result->ssim_max, slice->ssim_max);
   }
+
+  /* add up the rows in order, so that the mean doesn't depend on the
+   * number of slices or the order in which they finished */
+  for (y = 0; y < height - windowsize + 1; y++)
+    ssim_sum += ssim->row_sums[y];
+
+  result->ssim_mean = ssim_sum / windows;
+  mse = (gdouble) sse / ((gdouble) width * height);
+  if (mse > 0.0)
+    result->psnr = MIN (10.0 * log10 (255.0 * 255.0 / mse), MAX_PSNR);
+  else
+    result->psnr = MAX_PSNR;
 }
 
-static gboolean
-gst_ssim_query_latency (GstSSim * ssim, GstQuery * query)
+/* Fills the luma of @frame with @luma and the chroma with 128 */
+static void
+gst_ssim_fill_frame (GstVideoFrame * frame, guint8 luma)
 {
-  GstClockTime min, max;
-  gboolean live;
-  gboolean res;
-  GstIterator *it;
-  gboolean done;
-
-  res = TRUE;
-  done = FALSE;
-
-  live = FALSE;
-  min = 0;
-  max = GST_CLOCK_TIME_NONE;
-
-  /* Take maximum of all latency values */
-  it = gst_element_iterate_sink_pads (GST_ELEMENT_CAST (ssim));
-  while (!done) {
-    GstIteratorResult ires;
-
-    gpointer item;
-
-    ires = gst_iterator_next (it, &item);
-    switch (ires) {
-      case GST_ITERATOR_DONE:
-        done = TRUE;
-        break;
-      case GST_ITERATOR_OK:
-      {
-        GstPad *pad = GST_PAD_CAST (item);
-        GstQuery *peerquery;
-        GstClockTime min_cur, max_cur;
-        gboolean live_cur;
-
-        peerquery = gst_query_new_latency ();
-
-        /* Ask peer for latency */
-        res &= gst_pad_peer_query (pad, peerquery);
-
-        /* take max from all valid return values */
-        if (res) {
-          gst_query_parse_latency (peerquery, &live_cur, &min_cur, &max_cur);
-
-          if (live_cur) {
-            if (min_cur > min)
-              min = min_cur;
-
-            if (max == GST_CLOCK_TIME_NONE)
-              max = max_cur;
-            else if (max_cur < max)
-              max = max_cur;
-
-            live = TRUE;
-          }
-        }
-
-        gst_query_unref (peerquery);
-        gst_object_unref (pad);
-        break;
-      }
-      case GST_ITERATOR_RESYNC:
-        live = FALSE;
-        min = 0;
-        max = GST_CLOCK_TIME_NONE;
-        res = TRUE;
-        gst_iterator_resync (it);
-        break;
-      default:
-        res = FALSE;
-        done = TRUE;
-        break;
+  guint i, plane, num_planes, height;
+
+  num_planes = GST_VIDEO_FRAME_N_PLANES (frame);
+  for (plane = 0; plane < num_planes; ++plane) {
+    guint8 *pdata;
+    gsize rowsize, plane_stride;
+
+    pdata = GST_VIDEO_FRAME_PLANE_DATA (frame, plane);
+    plane_stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, plane);
+    rowsize = GST_VIDEO_FRAME_COMP_WIDTH (frame, plane)
+        * GST_VIDEO_FRAME_COMP_PSTRIDE (frame, plane);
+    height = GST_VIDEO_FRAME_COMP_HEIGHT (frame, plane);
+
+    for (i = 0; i < height; ++i) {
+      memset (pdata, plane == 0 ? luma : 128, rowsize);
+      pdata += plane_stride;
     }
   }
-  gst_iterator_free (it);
-
-  if (res) {
-    /* store the results */
-    GST_DEBUG_OBJECT (ssim, "Calculated total latency: live %s, min %"
-        GST_TIME_FORMAT ", max %" GST_TIME_FORMAT,
-        (live ? "yes" : "no"), GST_TIME_ARGS (min), GST_TIME_ARGS (max));
-    gst_query_set_latency (query, live, min, max);
-  }
-
-  return res;
 }
 
-static gboolean
-gst_ssim_query_duration (GstSSim * ssim, GstQuery * query)
+static GstFlowReturn
+gst_ssim_aggregate_frames (GstVideoAggregator * vagg, GstBuffer * outbuf)
 {
-  gint64 max, min;
-  gboolean res;
-  GstFormat format;
-  GstIterator *it;
-  gboolean done;
-
-  /* parse format */
-  gst_query_parse_duration (query, &format, NULL);
-
-  max = -1;
-  min = G_MAXINT64;
-  res = TRUE;
-  done = FALSE;
-
-  it = gst_element_iterate_sink_pads (GST_ELEMENT_CAST (ssim));
-  while (!done) {
-    GstIteratorResult ires;
-
-    gpointer item;
-
-    ires = gst_iterator_next (it, &item);
-    switch (ires) {
-      case GST_ITERATOR_DONE:
-        done = TRUE;
-        break;
-      case GST_ITERATOR_OK:
-      {
-        GstPad *pad = GST_PAD_CAST (item);
-
-        gint64 duration;
-
-        /* ask sink peer for duration */
-        res &= gst_pad_query_peer_duration (pad, &format, &duration);
-        /* take min&max from all valid return values */
-        if (res) {
-          /* valid unknown length, stop searching */
-          if (duration == -1) {
-            max = duration;
-            done = TRUE;
-          }
-          /* else see if bigger than current max */
-          else {
-            if (duration > max)
-              max = duration;
-            if (duration < min)
-              min = duration;
-          }
-        }
-        gst_object_unref (pad);
-        break;
-      }
-      case GST_ITERATOR_RESYNC:
-        max = -1;
-        min = G_MAXINT64;
-        res = TRUE;
-        gst_iterator_resync (it);
-        break;
-      default:
-        res = FALSE;
-        done = TRUE;
-        break;
+  GstSSim *ssim = GST_SSIM (vagg);
+  GstVideoAggregatorPad *orig = NULL;
+  GstVideoFrame out_frame;
+  GstClockTime timestamp = GST_BUFFER_TIMESTAMP (outbuf);
+  GList *pads = NULL, *messages = NULL, *l;
+  gboolean have_map = FALSE;
+  gint windowsize;
+
+  if (!gst_video_frame_map (&out_frame, &vagg->info, outbuf, GST_MAP_WRITE)) {
+    GST_WARNING_OBJECT (vagg, "Could not map output buffer");
+    return GST_FLOW_ERROR;
+  }
+
+  /* the pads are sorted by zorder, the first one with a frame is the
+   * original */
+  GST_OBJECT_LOCK (vagg);
+  windowsize = ssim->windowsize;
+  for (l = GST_ELEMENT (vagg)->sinkpads; l; l = l->next) {
+    GstVideoAggregatorPad *pad = l->data;
+
+    if (pad->aggregated_frame == NULL)
+      continue;
+
+    if (orig == NULL)
+      orig = gst_object_ref (pad);
+    else
+      pads = g_list_prepend (pads, gst_object_ref (pad));
+  }
+  GST_OBJECT_UNLOCK (vagg);
+  pads = g_list_reverse (pads);
+
+  for (l = pads; l; l = l->next) {
+    GstVideoAggregatorPad *pad = l->data;
+    GstSSimPad *spad = GST_SSIM_PAD (pad);
+    GstVideoFrame *map = NULL;
+    GstSSimResult result;
+    GstStructure *s;
+
+    if (GST_VIDEO_FRAME_WIDTH (pad->aggregated_frame) !=
+        GST_VIDEO_FRAME_WIDTH (orig->aggregated_frame) ||
+        GST_VIDEO_FRAME_HEIGHT (pad->aggregated_frame) !=
+        GST_VIDEO_FRAME_HEIGHT (orig->aggregated_frame))
+      goto wrong_size;
+
+    if (!have_map && GST_VIDEO_FRAME_WIDTH (&out_frame) ==
+        GST_VIDEO_FRAME_WIDTH (orig->aggregated_frame) &&
+        GST_VIDEO_FRAME_HEIGHT (&out_frame) ==
+        GST_VIDEO_FRAME_HEIGHT (orig->aggregated_frame)) {
+      gst_ssim_fill_frame (&out_frame, 0);
+      map = &out_frame;
+      have_map = TRUE;
     }
-  }
-  gst_iterator_free (it);
 
-  if (res) {
-    /* and store the max */
-    GST_DEBUG_OBJECT (ssim, "Total duration in format %s: %"
-        GST_TIME_FORMAT, gst_format_get_name (format), GST_TIME_ARGS (min));
-    gst_query_set_duration (query, format, min);
+    gst_ssim_compare (ssim, orig->aggregated_frame, pad->aggregated_frame,
+        map, windowsize, &result);
+
+    GST_LOG_OBJECT (pad, "frame %" G_GUINT64_FORMAT ": SSIM %f (%f - %f), "
+        "PSNR %f dB", ssim->offset, result.ssim_mean, result.ssim_min,
+        result.ssim_max, result.psnr);
+
+    spad->frames++;
+    spad->ssim_sum += result.ssim_mean;
+    spad->ssim_min = MIN (spad->ssim_min, result.ssim_mean);
+    spad->psnr_sum += result.psnr;
+    spad->psnr_min = MIN (spad->psnr_min, result.psnr);
+
+    s = gst_structure_new ("ssim",
+        "stream", G_TYPE_STRING, GST_OBJECT_NAME (pad),
+        "timestamp", GST_TYPE_CLOCK_TIME, timestamp,
+        "offset", G_TYPE_UINT64, ssim->offset,
+        "ssim-mean", G_TYPE_DOUBLE, result.ssim_mean,
+        "ssim-min", G_TYPE_DOUBLE, result.ssim_min,
+        "ssim-max", G_TYPE_DOUBLE, result.ssim_max,
+        "psnr", G_TYPE_DOUBLE, result.psnr, NULL);
+    messages = g_list_prepend (messages,
+        gst_message_new_element (GST_OBJECT (ssim), s));
+
+    /* the collector only keeps one measurement per frame */
+    if (l == pads) {
+      GValue mean = G_VALUE_INIT, lowest = G_VALUE_INIT, highest =
+          G_VALUE_INIT;
+
+      g_value_init (&mean, G_TYPE_FLOAT);
+      g_value_init (&lowest, G_TYPE_FLOAT);
+      g_value_init (&highest, G_TYPE_FLOAT);
+      g_value_set_float (&mean, result.ssim_mean);
+      g_value_set_float (&lowest, result.ssim_min);
+      g_value_set_float (&highest, result.ssim_max);
+      ssim->pending_events = g_list_append (ssim->pending_events,
+          gst_event_new_measured (ssim->offset, timestamp, "SSIM", &mean,
+              &lowest, &highest));
+    }
   }
 
-  return res;
-}
+  if (!have_map)
+    gst_ssim_fill_frame (&out_frame, 128);
 
+  gst_video_frame_unmap (&out_frame);
+  if (orig)
+    gst_object_unref (orig);
+  g_list_free_full (pads, gst_object_unref);
 
-static gboolean
-gst_ssim_query (GstPad * pad, GstQuery * query)
-{
-  GstSSim *ssim = GST_SSIM (gst_pad_get_parent (pad));
-  gboolean res = FALSE;
-
-  switch (GST_QUERY_TYPE (query)) {
-    case GST_QUERY_POSITION:
-    {
-      GstFormat format;
-
-      gst_query_parse_position (query, &format, NULL);
-
-      switch (format) {
-        case GST_FORMAT_TIME:
-          /* FIXME, bring to stream time, might be tricky */
-          gst_query_set_position (query, format, ssim->timestamp);
-          res = TRUE;
-          break;
-        case GST_FORMAT_DEFAULT:
-          gst_query_set_position (query, format, ssim->offset);
-          res = TRUE;
-          break;
-        default:
-          break;
-      }
-      break;
-    }
-    case GST_QUERY_DURATION:
-      res = gst_ssim_query_duration (ssim, query);
-      break;
-    case GST_QUERY_LATENCY:
-      res = gst_ssim_query_latency (ssim, query);
-      break;
-    default:
-      /* FIXME, needs a custom query handler because we have multiple
-       * sinkpads
-       */
-      res = gst_pad_query_default (pad, query);
-      break;
-  }
+  ssim->offset++;
+
+  messages = g_list_reverse (messages);
+  for (l = messages; l; l = l->next)
+    gst_element_post_message (GST_ELEMENT (ssim), l->data);
+  g_list_free (messages);
+
+  return GST_FLOW_OK;
 
-  gst_object_unref (ssim);
-  return res;
+  /* ERRORS */
+wrong_size:
+  {
+    GST_ELEMENT_ERROR (ssim, STREAM, FORMAT, (NULL),
+        ("%s is %dx%d, but the original %s is %dx%d", GST_OBJECT_NAME (l->data),
+            GST_VIDEO_FRAME_WIDTH (((GstVideoAggregatorPad *)
+                    l->data)->aggregated_frame),
+            GST_VIDEO_FRAME_HEIGHT (((GstVideoAggregatorPad *)
+                    l->data)->aggregated_frame), GST_OBJECT_NAME (orig),
+            GST_VIDEO_FRAME_WIDTH (orig->aggregated_frame),
+            GST_VIDEO_FRAME_HEIGHT (orig->aggregated_frame)));
+    gst_video_frame_unmap (&out_frame);
+    gst_object_unref (orig);
+    g_list_free_full (pads, gst_object_unref);
+    g_list_free_full (messages, (GDestroyNotify) gst_message_unref);
+    return GST_FLOW_ERROR;
+  }
 }
 
-static gboolean
-forward_event_func (GstPad * pad, GValue * ret, GstEvent * event)
+static void
+gst_ssim_post_summary (GstSSim * ssim)
 {
-  gst_event_ref (event);
-  GST_LOG_OBJECT (pad, "About to send event %s", GST_EVENT_TYPE_NAME (event));
-  if (!gst_pad_push_event (pad, event)) {
-    g_value_set_boolean (ret, FALSE);
-    GST_LOG_OBJECT (pad, "Sending event  %p (%s) failed.",
-        event, GST_EVENT_TYPE_NAME (event));
-  } else {
-    GST_LOG_OBJECT (pad, "Sent event  %p (%s).",
-        event, GST_EVENT_TYPE_NAME (event));
+  GList *messages = NULL, *l;
+
+  GST_OBJECT_LOCK (ssim);
+  for (l = GST_ELEMENT (ssim)->sinkpads; l; l = l->next) {
+    GstSSimPad *pad = l->data;
+    GstStructure *s;
+
+    if (pad->frames == 0)
+      continue;
+
+    s = gst_structure_new ("ssim-summary",
+        "stream", G_TYPE_STRING, GST_OBJECT_NAME (pad),
+        "frames", G_TYPE_UINT64, pad->frames,
+        "ssim-mean", G_TYPE_DOUBLE, pad->ssim_sum / pad->frames,
+        "ssim-min", G_TYPE_DOUBLE, pad->ssim_min,
+        "psnr-mean", G_TYPE_DOUBLE, pad->psnr_sum / pad->frames,
+        "psnr-min", G_TYPE_DOUBLE, pad->psnr_min, NULL);
+    messages = g_list_prepend (messages,
+        gst_message_new_element (GST_OBJECT (ssim), s));
   }
-  gst_object_unref (pad);
-  return TRUE;
+  GST_OBJECT_UNLOCK (ssim);
+
+  messages = g_list_reverse (messages);
+  for (l = messages; l; l = l->next)
+    gst_element_post_message (GST_ELEMENT (ssim), l->data);
+  g_list_free (messages);
 }
 
-/* forwards the event to all sinkpads, takes ownership of the
- * event
- *
- * Returns: TRUE if the event could be forwarded on all
- * sinkpads.
- */
-static gboolean
-forward_event (GstSSim * ssim, GstEvent * event)
+static GstFlowReturn
+gst_ssim_aggregate (GstAggregator * agg, gboolean timeout)
 {
-  GstIterator *it;
-  GValue vret = { 0 };
+  GstSSim *ssim = GST_SSIM (agg);
+  GstFlowReturn ret;
+  GList *events, *l;
 
-  GST_LOG_OBJECT (ssim, "Forwarding event %p (%s)", event,
-      GST_EVENT_TYPE_NAME (event));
+  ret = GST_AGGREGATOR_CLASS (parent_class)->aggregate (agg, timeout);
 
-  g_value_init (&vret, G_TYPE_BOOLEAN);
-  g_value_set_boolean (&vret, TRUE);
-  it = gst_element_iterate_sink_pads (GST_ELEMENT_CAST (ssim));
-  gst_iterator_fold (it, (GstIteratorFoldFunction) forward_event_func, &vret,
-      event);
-  gst_iterator_free (it);
-  gst_event_unref (event);
+  /* the measure events follow the frame they describe, so they can't be
+   * pushed before the caps and segment */
+  events = ssim->pending_events;
+  ssim->pending_events = NULL;
+  for (l = events; l; l = l->next) {
+    if (ret == GST_FLOW_OK)
+      gst_pad_push_event (agg->srcpad, l->data);
+    else
+      gst_event_unref (l->data);
+  }
+  g_list_free (events);
 
-  return g_value_get_boolean (&vret);
+  if (ret == GST_FLOW_EOS && !ssim->summary_posted) {
+    gst_ssim_post_summary (ssim);
+    ssim->summary_posted = TRUE;
+  }
+
+  return ret;
 }
 
 static gboolean
-gst_ssim_src_event (GstPad * pad, GstEvent * event)
+gst_ssim_start (GstAggregator * agg)
 {
-  GstSSim *ssim;
-  gboolean result;
+  GstSSim *ssim = GST_SSIM (agg);
+  GList *l;
+  guint i;
 
-  ssim = GST_SSIM (gst_pad_get_parent (pad));
+  if (!GST_AGGREGATOR_CLASS (parent_class)->start (agg))
+    return FALSE;
 
-  switch (GST_EVENT_TYPE (event)) {
-    case GST_EVENT_QOS:
-      /* QoS might be tricky */
-      result = FALSE;
-      break;
-    case GST_EVENT_SEEK:
-    {
-      GstSeekFlags flags;
-      GstSeekType curtype;
-      gint64 cur;
-
-      /* parse the seek parameters */
-      gst_event_parse_seek (event, &ssim->segment_rate, NULL, &flags, &curtype,
-          &cur, NULL, NULL);
-
-      /* check if we are flushing */
-      if (flags & GST_SEEK_FLAG_FLUSH) {
-        /* make sure we accept nothing anymore and return WRONG_STATE */
-        gst_collect_pads_set_flushing (ssim->collect, TRUE);
-
-        /* flushing seek, start flush downstream, the flush will be done
-         * when all pads received a FLUSH_STOP. */
-        gst_pad_push_event (pad, gst_event_new_flush_start ());
-      }
-      /* now wait for the collected to be finished and mark a new
-       * segment */
-      GST_OBJECT_LOCK (ssim->collect);
-      if (curtype == GST_SEEK_TYPE_SET)
-        ssim->segment_position = cur;
-      else
-        ssim->segment_position = 0;
-      {
-        GstSSimOutputContext *c;
-        gint i = 0;
-        for (i = 0; i < ssim->src->len; i++) {
-          c = (GstSSimOutputContext *) g_ptr_array_index (ssim->src, i);
-          c->segment_pending = TRUE;
-        }
-      }
-      GST_OBJECT_UNLOCK (ssim->collect);
+  GST_OBJECT_LOCK (ssim);
+  ssim->n_threads = ssim->threads;
+  for (l = GST_ELEMENT (ssim)->sinkpads; l; l = l->next)
+    gst_ssim_pad_reset (l->data);
+  GST_OBJECT_UNLOCK (ssim);
 
-      result = forward_event (ssim, event);
-      break;
-    }
-    case GST_EVENT_NAVIGATION:
-      /* navigation is rather pointless. */
-      result = FALSE;
-      break;
-    default:
-      /* just forward the rest for now */
-      result = forward_event (ssim, event);
-      break;
+  if (ssim->n_threads == 0)
+    ssim->n_threads = MIN (g_get_num_processors (), MAX_THREADS);
+  ssim->n_slices = 1;
+
+  ssim->slices = g_new0 (GstSSimSlice, ssim->n_threads);
+  for (i = 0; i < ssim->n_threads; i++)
+    ssim->slices[i].index = i;
+
+  if (ssim->n_threads > 1) {
+    ssim->pool = g_thread_pool_new ((GFunc) gst_ssim_compare_slice_func, ssim,
+        ssim->n_threads - 1, FALSE, NULL);
   }
-  gst_object_unref (ssim);
 
-  return result;
+  GST_DEBUG_OBJECT (ssim, "using %u threads", ssim->n_threads);
+
+  ssim->offset = 0;
+  ssim->summary_posted = FALSE;
+
+  return TRUE;
 }
 
 static gboolean
-gst_ssim_sink_event (GstPad * pad, GstEvent * event)
+gst_ssim_stop (GstAggregator * agg)
 {
-  GstSSim *ssim;
-  gboolean ret;
-
-  ssim = GST_SSIM (gst_pad_get_parent (pad));
-
-  GST_DEBUG ("Got %s event on pad %s:%s", GST_EVENT_TYPE_NAME (event),
-      GST_DEBUG_PAD_NAME (pad));
-
-  switch (GST_EVENT_TYPE (event)) {
-    case GST_EVENT_NEWSEGMENT:
-    {
-      gboolean update;
-      gdouble rate;
-      gdouble applied_rate;
-      GstFormat format;
-      gint64 start;
-      gint64 stop;
-      gint64 position;
-      gst_event_parse_new_segment_full (event, &update, &rate, &applied_rate,
-          &format, &start, &stop, &position);
-      GST_DEBUG ("NEWSEGMENTEVENT: update(%d), rate(%f), app_rate(%f), "
-          "format(%d), start(%" GST_TIME_FORMAT ") stop(%" GST_TIME_FORMAT ") "
-          "position(%" GST_TIME_FORMAT ")", update, rate, applied_rate, format,
-          GST_TIME_ARGS (start), GST_TIME_ARGS (stop),
-          GST_TIME_ARGS (position));
-      break;
-    }
-    case GST_EVENT_FLUSH_STOP:
-      /* mark a pending new segment. This event is synchronized
-       * with the streaming thread so we can safely update the
-       * variable without races. It's somewhat weird because we
-       * assume the collectpads forwarded the FLUSH_STOP past us
-       * and downstream (using our source pad, the bastard!).
-       */
-    {
-      GstSSimOutputContext *c;
-      gint i = 0;
-      for (i = 0; i < ssim->src->len; i++) {
-        c = (GstSSimOutputContext *) g_ptr_array_index (ssim->src, i);
-        c->segment_pending = TRUE;
-      }
-    }
-      break;
-    default:
-      break;
+  GstSSim *ssim = GST_SSIM (agg);
+  guint i;
+
+  if (ssim->pool) {
+    g_thread_pool_free (ssim->pool, FALSE, TRUE);
+    ssim->pool = NULL;
   }
 
-  /* now GstCollectPads can take care of the rest, e.g. EOS */
-  GST_DEBUG ("Dispatching %s event on pad %s:%s", GST_EVENT_TYPE_NAME (event),
-      GST_DEBUG_PAD_NAME (pad));
-  ret = ssim->collect_event (pad, event);
-  GST_DEBUG ("Event %s on pad %s:%s is dispatched", GST_EVENT_TYPE_NAME (event),
-      GST_DEBUG_PAD_NAME (pad));
-  gst_object_unref (ssim);
-  return ret;
+  for (i = 0; i < ssim->n_threads; i++) {
+    g_free (ssim->slices[i].cols);
+    g_free (ssim->slices[i].scores);
+  }
+  g_free (ssim->slices);
+  ssim->slices = NULL;
+  g_free (ssim->row_sums);
+  ssim->row_sums = NULL;
+  ssim->n_row_sums = 0;
+
+  g_list_free_full (ssim->pending_events, (GDestroyNotify) gst_event_unref);
+  ssim->pending_events = NULL;
+
+  return GST_AGGREGATOR_CLASS (parent_class)->stop (agg);
 }
 
 static void
-gst_ssim_set_property (GObject * object, guint prop_id,
-    const GValue * value, GParamSpec * pspec)
+gst_ssim_set_property (GObject * object, guint prop_id, const GValue * value,
+    GParamSpec * pspec)
 {
-  GstSSim *ssim;
-
-  ssim = GST_SSIM (object);
+  GstSSim *ssim = GST_SSIM (object);
 
+  GST_OBJECT_LOCK (ssim);
   switch (prop_id) {
-    case PROP_SSIM_TYPE:
-      ssim->ssimtype = g_value_get_int (value);
-      break;
-    case PROP_WINDOW_TYPE:
-      ssim->windowtype = g_value_get_int (value);
-      g_free (ssim->windows);
-      ssim->windows = NULL;
-      break;
     case PROP_WINDOW_SIZE:
       ssim->windowsize = g_value_get_int (value);
-      g_free (ssim->windows);
-      ssim->windows = NULL;
       break;
-    case PROP_GAUSS_SIGMA:
-      ssim->sigma = g_value_get_float (value);
-      g_free (ssim->windows);
-      ssim->windows = NULL;
+    case PROP_THREADS:
+      ssim->threads = g_value_get_uint (value);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
+  GST_OBJECT_UNLOCK (ssim);
 }
 
 static void
 gst_ssim_get_property (GObject * object, guint prop_id, GValue * value,
     GParamSpec * pspec)
 {
-  GstSSim *ssim;
-
-  ssim = GST_SSIM (object);
+  GstSSim *ssim = GST_SSIM (object);
 
+  GST_OBJECT_LOCK (ssim);
   switch (prop_id) {
-    case PROP_SSIM_TYPE:
-      g_value_set_int (value, ssim->ssimtype);
-      break;
-    case PROP_WINDOW_TYPE:
-      g_value_set_int (value, ssim->windowtype);
-      break;
     case PROP_WINDOW_SIZE:
       g_value_set_int (value, ssim->windowsize);
       break;
-    case PROP_GAUSS_SIGMA:
-      g_value_set_float (value, ssim->sigma);
+    case PROP_THREADS:
+      g_value_set_uint (value, ssim->threads);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
+  GST_OBJECT_UNLOCK (ssim);
 }
 
+static void
+gst_ssim_finalize (GObject * object)
+{
+  GstSSim *ssim = GST_SSIM (object);
+
+  g_mutex_clear (&ssim->slice_lock);
+  g_cond_clear (&ssim->slice_cond);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
 
 static void
 gst_ssim_class_init (GstSSimClass * klass)
 {
   GObjectClass *gobject_class = (GObjectClass *) klass;
   GstElementClass *gstelement_class = (GstElementClass *) klass;
+  GstAggregatorClass *agg_class = (GstAggregatorClass *) klass;
+  GstVideoAggregatorClass *videoaggregator_class =
+      (GstVideoAggregatorClass *) klass;
 
   gobject_class->set_property = gst_ssim_set_property;
   gobject_class->get_property = gst_ssim_get_property;
-  gobject_class->finalize = GST_DEBUG_FUNCPTR (gst_ssim_finalize);
-
-  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_SSIM_TYPE,
-      g_param_spec_int ("ssim-type", "SSIM type",
-          "Type of the SSIM metric. 0 - canonical. 1 - with fixed mu "
-          "(almost the same results, but roughly 20% faster)",
-          0, 1, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
-
-  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_WINDOW_TYPE,
-      g_param_spec_int ("window-type", "Window type",
-          "Type of the weighting in the window. "
-          "0 - no weighting. 1 - Gaussian weighting (controlled by \"sigma\")",
-          0, 1, 1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  gobject_class->finalize = gst_ssim_finalize;
 
-  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_WINDOW_SIZE,
+  g_object_class_install_property (gobject_class, PROP_WINDOW_SIZE,
       g_param_spec_int ("window-size", "Window size",
-          "Size of a window.", 1, 22, 11,
+          "Width and height of the square window over which SSIM is computed",
+          2, MAX_WINDOW_SIZE, DEFAULT_WINDOW_SIZE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
-  g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_GAUSS_SIGMA,
-      g_param_spec_float ("gauss-sigma", "Deviation (for Gauss function)",
-          "Used to calculate Gussian weights "
-          "(only when using Gaussian window).",
-          G_MINFLOAT, 10, 1.5, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of threads comparing slices of each frame "
+          "(0 = number of processors)", 0, MAX_THREADS, DEFAULT_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  agg_class->sinkpads_type = GST_TYPE_SSIM_PAD;
+  agg_class->aggregate = GST_DEBUG_FUNCPTR (gst_ssim_aggregate);
+  agg_class->start = GST_DEBUG_FUNCPTR (gst_ssim_start);
+  agg_class->stop = GST_DEBUG_FUNCPTR (gst_ssim_stop);
+
+  videoaggregator_class->aggregate_frames =
+      GST_DEBUG_FUNCPTR (gst_ssim_aggregate_frames);
 
   gst_element_class_add_static_pad_template (gstelement_class,
       &gst_ssim_src_template);
   gst_element_class_add_static_pad_template (gstelement_class,
-      &gst_ssim_sink_original_template);
-  gst_element_class_add_static_pad_template (gstelement_class,
-      &gst_ssim_sink_modified_template);
+      &gst_ssim_sink_template);
+
   gst_element_class_set_static_metadata (gstelement_class, "SSim",
-      "Filter/Analyzer/Video", "Calculate Y-SSIM for n+2 YUV video streams",
+      "Filter/Analyzer/Video",
+      "Calculate Y-SSIM and PSNR of video streams against a reference stream",
       "Руслан Ижбулатов <lrn1986 _at_ gmail _dot_ com>");
 
-  parent_class = g_type_class_peek_parent (klass);
-
-  gstelement_class->request_new_pad =
-      GST_DEBUG_FUNCPTR (gst_ssim_request_new_pad);
-  gstelement_class->release_pad = GST_DEBUG_FUNCPTR (gst_ssim_release_pad);
-
-  gstelement_class->change_state = GST_DEBUG_FUNCPTR (gst_ssim_change_state);
-}
-
-static GstPad *
-gst_ssim_request_new_pad (GstElement * element, GstPadTemplate * templ,
-    const gchar * padname)
-{
-  gchar *name;
-  GstSSim *ssim;
-  GstPad *newpad;
-  GstPad *newsrc;
-  gint padcount;
-  GstPadTemplate *template;
-  guint num = -1;
-
-  if (templ->direction != GST_PAD_SINK)
-    goto not_sink;
-
-  ssim = GST_SSIM (element);
-
-  padcount = ssim->padcount;
-
-  GST_DEBUG_OBJECT (ssim, "number of pads = %d", padcount);
-
-  if (padname)
-    GST_DEBUG_OBJECT (ssim, "reqested pad %s", padname);
-  else
-    goto unnamed_pad;
-
-  if (strcmp (padname, "original") == 0) {
-    newpad = gst_pad_new_from_template (templ, "original");
-    GST_DEBUG_OBJECT (ssim, "request new sink pad original");
-    ssim->orig = newpad;
-  } else if (strncmp (padname, "modified_", 9) == 0) {
-    const gchar *numstr = &padname[9];
-    num = strtoul (numstr, NULL, 10);
-    if (errno == EINVAL || errno == ERANGE)
-      goto bad_name;
-    newpad = gst_pad_new_from_template (templ, padname);
-    GST_DEBUG_OBJECT (ssim, "request new sink pad %s", padname);
-  } else
-    goto bad_name;
-
-  gst_pad_set_getcaps_function (newpad,
-      GST_DEBUG_FUNCPTR (gst_ssim_sink_getcaps));
-  gst_pad_set_setcaps_function (newpad, GST_DEBUG_FUNCPTR (gst_ssim_setcaps));
-  gst_collect_pads_add_pad (ssim->collect, newpad, sizeof (GstCollectData),
-      NULL, TRUE);
-
-  /* FIXME: hacked way to override/extend the event function of
-   * GstCollectPads; because it sets its own event function giving the
-   * element no access to events
-   */
-  GST_DEBUG_OBJECT (ssim, "Current collect_event is %p, changing to %p",
-      ssim->collect_event, GST_PAD_EVENTFUNC (newpad));
-  ssim->collect_event = (GstPadEventFunction) GST_PAD_EVENTFUNC (newpad);
-  gst_pad_set_event_function (newpad, GST_DEBUG_FUNCPTR (gst_ssim_sink_event));
-
-  GST_DEBUG_OBJECT (ssim, "Adding a pad...");
-  /* takes ownership of the pad */
-  if (!gst_element_add_pad (GST_ELEMENT (ssim), newpad))
-    goto could_not_add_sink;
-  else
-    /* increment pad counter */
-    padcount = g_atomic_int_add (&ssim->padcount, 1);
-
-  if (num != -1) {
-    GstSSimOutputContext *c;
-
-    template = gst_static_pad_template_get (&gst_ssim_src_template);
-    name = g_strdup_printf ("src_%u", num);
-    newsrc = gst_pad_new_from_template (template, name);
-    GST_DEBUG_OBJECT (ssim, "creating src pad %s", name);
-    g_free (name);
-    gst_object_unref (template);
-
-    gst_pad_set_getcaps_function (newsrc,
-        GST_DEBUG_FUNCPTR (gst_ssim_src_getcaps));
-    gst_pad_set_query_function (newsrc, GST_DEBUG_FUNCPTR (gst_ssim_query));
-    gst_pad_set_event_function (newsrc, GST_DEBUG_FUNCPTR (gst_ssim_src_event));
-
-    if (!gst_element_add_pad (GST_ELEMENT (ssim), newsrc))
-      goto could_not_add_src;
-
-    c = g_new (GstSSimOutputContext, 1);
-    c->pad = newsrc;
-    g_object_set_data (G_OBJECT (newpad), "ssim-match-output-context", c);
-    g_ptr_array_add (ssim->src, (gpointer) c);
-  }
-
-  return newpad;
-
-  /* errors */
-bad_name:
-  {
-    g_warning ("gstssim: request new pad with bad name %s (must be "
-        "'modified')\n", padname);
-    return NULL;
-  }
-unnamed_pad:
-  {
-    g_warning ("gstssim: request new pad without a name (must be "
-        "'modified')\n");
-    return NULL;
-  }
-not_sink:
-  {
-    g_warning ("gstssim: request new pad that is not a SINK pad\n");
-    return NULL;
-  }
-could_not_add_src:
-  {
-    GST_DEBUG_OBJECT (ssim, "could not add src pad");
-    gst_object_unref (newsrc);
-  }
-could_not_add_sink:
-  {
-    GST_DEBUG_OBJECT (ssim, "could not add sink pad");
-    gst_collect_pads_remove_pad (ssim->collect, newpad);
-    gst_object_unref (newpad);
-    return NULL;
-  }
-}
-
-static void
-gst_ssim_release_pad (GstElement * element, GstPad * pad)
-{
-  GstSSim *ssim;
-
-  ssim = GST_SSIM (element);
-
-  GST_DEBUG_OBJECT (ssim, "release pad %s:%s", GST_DEBUG_PAD_NAME (pad));
-
-  gst_collect_pads_remove_pad (ssim->collect, pad);
-  gst_element_remove_pad (element, pad);
+  GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "ssim", 0, "SSIM calculator");
 }
 
-
 static void
 gst_ssim_init (GstSSim * ssim)
 {
-  ssim->windowsize = 11;
-  ssim->windowtype = 1;
-  ssim->windows = NULL;
-  ssim->sigma = 1.5;
-  ssim->ssimtype = 0;
-  ssim->src = g_ptr_array_new ();
-  ssim->padcount = 0;
-  ssim->collect_event = NULL;
-  ssim->sinkcaps = NULL;
-
-  /* keep track of the sinkpads requested */
-  ssim->collect = gst_collect_pads_new ();
-  gst_collect_pads_set_function (ssim->collect,
-      GST_DEBUG_FUNCPTR (gst_ssim_collected), ssim);
-}
-
-static void
-gst_ssim_finalize (GObject * object)
-{
-  GstSSim *ssim = GST_SSIM (object);
-
-  gst_object_unref (ssim->collect);
-  ssim->collect = NULL;
-
-  g_free (ssim->windows);
-  ssim->windows = NULL;
-
-  g_free (ssim->weights);
-  ssim->weights = NULL;
-
-  if (ssim->sinkcaps)
-    gst_caps_unref (ssim->sinkcaps);
-  if (ssim->srccaps)
-    gst_caps_unref (ssim->srccaps);
-
-  g_ptr_array_free (ssim->src, TRUE);
-
-  G_OBJECT_CLASS (parent_class)->finalize (object);
-}
-
-typedef gfloat (*GstSSimWeightFunc) (GstSSim * ssim, gint y, gint x);
-
-static gfloat
-gst_ssim_weight_func_none (GstSSim * ssim, gint y, gint x)
-{
-  return 1;
-}
-
-static gfloat
-gst_ssim_weight_func_gauss (GstSSim * ssim, gint y, gint x)
-{
-  gfloat coord = sqrt (x * x + y * y);
-  return exp (-1 * (coord * coord) / (2 * ssim->sigma * ssim->sigma)) /
-      (ssim->sigma * sqrt (2 * G_PI));
-}
-
-static gboolean
-gst_ssim_regenerate_windows (GstSSim * ssim)
-{
-  gint windowiseven;
-  gint y, x, y2, x2;
-  GstSSimWeightFunc func;
-  gfloat normal_summ = 0;
-  gint normal_count = 0;
-
-  g_free (ssim->weights);
-
-  ssim->weights = g_new (gfloat, ssim->windowsize * ssim->windowsize);
-
-  windowiseven = ((gint) ssim->windowsize / 2) * 2 == ssim->windowsize ? 1 : 0;
-
-  g_free (ssim->windows);
-
-  ssim->windows = g_new (GstSSimWindowCache, ssim->height * ssim->width);
-
-  switch (ssim->windowtype) {
-    case 0:
-      func = gst_ssim_weight_func_none;
-      break;
-    case 1:
-      func = gst_ssim_weight_func_gauss;
-      break;
-    default:
-      GST_WARNING_OBJECT (ssim, "unknown window type - %d. Defaulting to %d",
-          ssim->windowtype, 1);
-      ssim->windowtype = 1;
-      func = gst_ssim_weight_func_gauss;
-  }
-
-  for (y = 0; y < ssim->windowsize; y++) {
-    gint yoffset = y * ssim->windowsize;
-    for (x = 0; x < ssim->windowsize; x++) {
-      ssim->weights[yoffset + x] = func (ssim, x - ssim->windowsize / 2 +
-          windowiseven, y - ssim->windowsize / 2 + windowiseven);
-      normal_summ += ssim->weights[yoffset + x];
-      normal_count++;
-    }
-  }
-
-  for (y = 0; y < ssim->height; y++) {
-    for (x = 0; x < ssim->width; x++) {
-      GstSSimWindowCache win;
-      gint element_count = 0;
-
-      win.x_window_start = x - ssim->windowsize / 2 + windowiseven;
-      win.x_weight_start = 0;
-      if (win.x_window_start < 0) {
-        win.x_weight_start = -win.x_window_start;
-        win.x_window_start = 0;
-      }
-
-      win.x_window_end = x + ssim->windowsize / 2;
-      if (win.x_window_end >= ssim->width)
-        win.x_window_end = ssim->width - 1;
-
-      win.y_window_start = y - ssim->windowsize / 2 + windowiseven;
-      win.y_weight_start = 0;
-      if (win.y_window_start < 0) {
-        win.y_weight_start = -win.y_window_start;
-        win.y_window_start = 0;
-      }
-
-      win.y_window_end = y + ssim->windowsize / 2;
-      if (win.y_window_end >= ssim->height)
-        win.y_window_end = ssim->height - 1;
-
-      win.element_summ = 0;
-      element_count = (win.y_window_end - win.y_window_start + 1) *
-          (win.x_window_end - win.x_window_start + 1);
-      if (element_count == normal_count)
-        win.element_summ = normal_summ;
-      else {
-        for (y2 = win.y_weight_start; y2 < ssim->windowsize; y2++) {
-          for (x2 = win.x_weight_start; x2 < ssim->windowsize; x2++) {
-            win.element_summ += ssim->weights[y2 * ssim->windowsize + x2];
-          }
-        }
-      }
-      ssim->windows[(y * ssim->width + x)] = win;
-    }
-  }
-
-  /* FIXME: while 0.01 and 0.03 are pretty much static, the 255 implies that
-   * we're working with 8-bit-per-color-component format, which may not be true
-   */
-  ssim->const1 = 0.01 * 255 * 0.01 * 255;
-  ssim->const2 = 0.03 * 255 * 0.03 * 255;
-  return TRUE;
-}
-
-static GstFlowReturn
-gst_ssim_collected (GstCollectPads * pads, gpointer user_data)
-{
-  GstSSim *ssim;
-  GSList *collected;
-  GstFlowReturn ret = GST_FLOW_OK;
-  GstBuffer *orgbuf = NULL;
-  gfloat *orgmu = NULL;
-  GstBuffer *outbuf = NULL;
-  gpointer outdata = NULL;
-  guint outsize = 0;
-  gfloat mssim = 0, lowest = 1, highest = -1;
-  gboolean ready = TRUE;
-  gint padnumber = 0;
-
-  ssim = GST_SSIM (user_data);
-
-  if (G_UNLIKELY (ssim->windows == NULL)) {
-    GST_DEBUG_OBJECT (ssim, "Regenerating windows");
-    gst_ssim_regenerate_windows (ssim);
-  }
-
-  switch (ssim->ssimtype) {
-    case 0:
-      ssim->func = (GstSSimFunction) calcssim_canonical;
-      break;
-    case 1:
-      ssim->func = (GstSSimFunction) calcssim_without_mu;
-      break;
-    default:
-      return GST_FLOW_ERROR;
-  }
-
-  for (collected = pads->data; collected; collected = g_slist_next (collected)) {
-    GstCollectData *collect_data;
-    GstBuffer *inbuf;
-
-    collect_data = (GstCollectData *) collected->data;
-
-    inbuf = gst_collect_pads_peek (pads, collect_data);
-
-    if (inbuf == NULL) {
-      GST_LOG_OBJECT (ssim, "channel %p: no bytes available", collect_data);
-      ready = FALSE;
-    } else
-      gst_buffer_unref (inbuf);
-  }
-
-  /* if _collected() was called, all pads should have data, but if
-   * one of them doesn't, it means that it is EOS and we can't go any further
-   *
-   * FIXME, shouldn't we do something about pads that DO have data?
-   * Flush them or something?
-   */
-  if (G_UNLIKELY (!ready))
-    goto eos;
-
-  /* Mu is just a blur, we can calculate it once */
-  if (ssim->ssimtype == 0) {
-    orgmu = g_new (gfloat, ssim->width * ssim->height);
-
-    for (collected = pads->data; collected;
-        collected = g_slist_next (collected)) {
-      GstCollectData *collect_data;
-
-      collect_data = (GstCollectData *) collected->data;
-
-      if (collect_data->pad == ssim->orig) {
-        orgbuf = gst_collect_pads_pop (pads, collect_data);
-
-        GST_DEBUG_OBJECT (ssim, "Original stream - flags(0x%x), timestamp(%"
-            GST_TIME_FORMAT "), duration(%" GST_TIME_FORMAT ")",
-            GST_BUFFER_FLAGS (orgbuf),
-            GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (orgbuf)),
-            GST_TIME_ARGS (GST_BUFFER_DURATION (orgbuf)));
-        calculate_mu (ssim, orgmu, GST_BUFFER_DATA (orgbuf));
-
-        break;
-      }
-    }
-  }
-
-  GST_LOG_OBJECT (ssim, "starting to cycle through streams");
-
-  for (collected = pads->data; collected; collected = g_slist_next (collected)) {
-    GstCollectData *collect_data;
-    GstBuffer *inbuf;
-    guint8 *indata;
-
-    collect_data = (GstCollectData *) collected->data;
-
-    if (collect_data->pad != ssim->orig) {
-      inbuf = gst_collect_pads_pop (pads, collect_data);
-
-      indata = GST_BUFFER_DATA (inbuf);
-
-      GST_DEBUG_OBJECT (ssim, "Modified stream - flags(0x%x), timestamp(%"
-          GST_TIME_FORMAT "), duration(%" GST_TIME_FORMAT ")",
-          GST_BUFFER_FLAGS (inbuf),
-          GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (inbuf)),
-          GST_TIME_ARGS (GST_BUFFER_DURATION (inbuf)));
-
-      if (!GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_GAP)) {
-        GstSSimOutputContext *c;
-        GstEvent *measured;
-        guint64 offset;
-        GValue vmean = { 0 }
-        , vlowest = {
-        0}
-        , vhighest = {
-        0};
-
-        c = (GstSSimOutputContext *)
-            g_object_get_data (G_OBJECT (collect_data->pad),
-            "ssim-match-output-context");
-
-        GST_DEBUG_OBJECT (ssim, "Output context is %" GST_PTR_FORMAT
-            ", pad will be %" GST_PTR_FORMAT, c, c->pad);
-
-        outsize = GST_ROUND_UP_4 (ssim->width) * ssim->height;
-        GST_LOG_OBJECT (ssim, "channel %p: making output buffer of %d bytes",
-            collect_data, outsize);
-
-        /* first buffer, alloc outsize.
-         * FIXME: we can easily subbuffer and _make_writable.
-         * FIXME: only create empty buffer for first non-gap buffer, so that we
-         * only use ssim function when really calculating
-         */
-        outbuf = gst_buffer_new_and_alloc (GST_ROUND_UP_4 (ssim->width) *
-            ssim->height);
-        outdata = GST_BUFFER_DATA (outbuf);
-        gst_buffer_set_caps (outbuf, gst_pad_get_fixed_caps_func (c->pad));
-
-        /* Videos should match, so the output video has the same characteristics
-         * as the input video
-         */
-        /* set timestamps on the output buffer */
-        gst_buffer_copy_metadata (outbuf, inbuf, (GstBufferCopyFlags)
-            GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS);
-
-        g_value_init (&vmean, G_TYPE_FLOAT);
-        g_value_init (&vlowest, G_TYPE_FLOAT);
-        g_value_init (&vhighest, G_TYPE_FLOAT);
-
-        GST_LOG_OBJECT (ssim, "channel %p: calculating SSIM", collect_data);
-
-        ssim->func (ssim, GST_BUFFER_DATA (orgbuf), orgmu, indata, outdata,
-            &mssim, &lowest, &highest);
-
-        GST_DEBUG_OBJECT (GST_OBJECT (ssim), "MSSIM is %f, l-h is %f - %f",
-            mssim, lowest, highest);
-
-        gst_ssim_post_message (ssim, outbuf, mssim, lowest, highest);
-
-        g_value_set_float (&vmean, mssim);
-        g_value_set_float (&vlowest, lowest);
-        g_value_set_float (&vhighest, highest);
-        offset = GST_BUFFER_OFFSET (inbuf);
-
-        /* our timestamping is very simple, just an ever incrementing
-         * counter, the new segment time will take care of their respective
-         * stream time.
-         */
-        if (c->segment_pending) {
-          GstEvent *event;
-
-          /* FIXME, use rate/applied_rate as set on all sinkpads.
-           * - currently we just set rate as received from last seek-event
-           * We could potentially figure out the duration as well using
-           * the current segment positions and the stated stop positions.
-           * Also we just start from stream time 0 which is rather
-           * weird. For non-synchronized mixing, the time should be
-           * the min of the stream times of all received segments,
-           * rationale being that the duration is at least going to
-           * be as long as the earliest stream we start mixing. This
-           * would also be correct for synchronized mixing but then
-           * the later streams would be delayed until the stream times`
-           * match.
-           */
-          event = gst_event_new_new_segment_full (FALSE, ssim->segment_rate,
-              1.0, GST_FORMAT_TIME, ssim->timestamp, -1,
-              ssim->segment_position);
-
-          gst_pad_push_event (c->pad, event);
-          c->segment_pending = FALSE;
-        }
-
-        measured = gst_event_new_measured (offset,
-            GST_BUFFER_TIMESTAMP (inbuf), "SSIM", &vmean, &vlowest, &vhighest);
-        gst_pad_push_event (c->pad, measured);
-
-        /* send it out */
-        GST_DEBUG_OBJECT (ssim, "pushing outbuf, timestamp %" GST_TIME_FORMAT
-            ", size %d", GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (outbuf)),
-            GST_BUFFER_SIZE (outbuf));
-        ret &= gst_pad_push (c->pad, outbuf);
-
-      } else {
-        GST_LOG_OBJECT (ssim, "channel %p: skipping", collect_data);
-      }
-      gst_buffer_unref (inbuf);
-      padnumber++;
-    }
-  }
-  gst_buffer_unref (orgbuf);
-
-  if (ssim->ssimtype == 0)
-    g_free (orgmu);
-
-  ssim->segment_position = 0;
-
-  return ret;
-
-  /* ERRORS */
-eos:
-  {
-    gint i;
-    GST_DEBUG_OBJECT (ssim, "no data available, must be EOS");
-    for (i = 0; i < ssim->src->len; i++) {
-      GstSSimOutputContext *c =
-          (GstSSimOutputContext *) g_ptr_array_index (ssim->src, i);
-      gst_pad_push_event (c->pad, gst_event_new_eos ());
-    }
-
-    return GST_FLOW_UNEXPECTED;
-  }
-}
-
-static GstStateChangeReturn
-gst_ssim_change_state (GstElement * element, GstStateChange transition)
-{
-  GstSSim *ssim;
-  GstStateChangeReturn ret;
-
-  ssim = GST_SSIM (element);
-
-  switch (transition) {
-    case GST_STATE_CHANGE_NULL_TO_READY:
-      break;
-    case GST_STATE_CHANGE_READY_TO_PAUSED:
-      ssim->timestamp = 0;
-      ssim->offset = 0;
-      {
-        GstSSimOutputContext *c;
-        gint i = 0;
-        for (i = 0; i < ssim->src->len; i++) {
-          c = (GstSSimOutputContext *) g_ptr_array_index (ssim->src, i);
-          c->segment_pending = TRUE;
-        }
-      }
-      ssim->segment_position = 0;
-      ssim->segment_rate = 1.0;
-      gst_segment_init (&ssim->segment, GST_FORMAT_UNDEFINED);
-      gst_collect_pads_start (ssim->collect);
-      break;
-    case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
-      break;
-    case GST_STATE_CHANGE_PAUSED_TO_READY:
-      /* need to unblock the collectpads before calling the
-       * parent change_state so that streaming can finish
-       */
-      gst_collect_pads_stop (ssim->collect);
-      break;
-    default:
-      break;
-  }
-
-  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  ssim->windowsize = DEFAULT_WINDOW_SIZE;
+  ssim->threads = DEFAULT_THREADS;
 
-  switch (transition) {
-    default:
-      break;
-  }
-
-  return ret;
+  g_mutex_init (&ssim->slice_lock);
+  g_cond_init (&ssim->slice_cond);
 }
@@ -36,12 +36,15 @@
 GST_DEBUG_CATEGORY (h264_parse_debug);
 #define GST_CAT_DEFAULT h264_parse_debug
 
+static const guint8 start_code[4] = { 0x00, 0x00, 0x00, 0x01 };
+
 #define DEFAULT_CONFIG_INTERVAL      (0)
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_INDEX_LOCATION
 };
 
 enum
@@ -137,6 +140,13 @@ gst_h264_parse_class_init (GstH264ParseClass * klass)
           -1, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index Location",
+          "Frame index file. If it holds a complete index of the stream, "
+          "it is used for seeking, otherwise it is (re)written with the "
+          "offset, timestamps and type of every frame while parsing",
+          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h264_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h264_parse_stop);
@@ -160,7 +170,12 @@ gst_h264_parse_class_init (GstH264ParseClass * klass)
 static void
 gst_h264_parse_init (GstH264Parse * h264parse)
 {
-  h264parse->frame_out = gst_adapter_new ();
+  gst_byte_writer_init (&h264parse->frame_out_tail);
+  h264parse->start_code = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+      (gpointer) start_code, sizeof (start_code), 0, sizeof (start_code),
+      NULL, NULL);
+  h264parse->sei_messages =
+      g_array_sized_new (FALSE, FALSE, sizeof (GstH264SEIMessage), 4);
   gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (h264parse), FALSE);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (h264parse));
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (h264parse));
@@ -172,7 +187,13 @@ gst_h264_parse_finalize (GObject * object)
 {
   GstH264Parse *h264parse = GST_H264_PARSE (object);
 
-  g_object_unref (h264parse->frame_out);
+  gst_buffer_replace (&h264parse->frame_out, NULL);
+  gst_byte_writer_reset (&h264parse->frame_out_tail);
+  gst_memory_unref (h264parse->start_code);
+  if (h264parse->prefixes)
+    gst_memory_unref (h264parse->prefixes);
+  g_array_free (h264parse->sei_messages, TRUE);
+  g_free (h264parse->index_location);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -192,7 +213,12 @@ gst_h264_parse_reset_frame (GstH264Parse * h264parse)
   h264parse->keyframe = FALSE;
   h264parse->header = FALSE;
   h264parse->frame_start = FALSE;
-  gst_adapter_clear (h264parse->frame_out);
+  h264parse->frame_type = GST_VIDEO_PARSE_FRAME_TYPE_UNKNOWN;
+  h264parse->frame_idr = FALSE;
+  gst_buffer_replace (&h264parse->frame_out, NULL);
+  gst_byte_writer_reset (&h264parse->frame_out_tail);
+  gst_byte_writer_init (&h264parse->frame_out_tail);
+  h264parse->frame_out_copy = FALSE;
 }
 
 static void
@@ -271,6 +297,11 @@ gst_h264_parse_start (GstBaseParse * parse)
 
   gst_base_parse_set_min_frame_size (parse, 6);
 
+  GST_OBJECT_LOCK (h264parse);
+  if (h264parse->index_location)
+    h264parse->index = gst_video_parse_index_open (h264parse->index_location);
+  GST_OBJECT_UNLOCK (h264parse);
+
   return TRUE;
 }
 
@@ -282,6 +313,11 @@ gst_h264_parse_stop (GstBaseParse * parse)
   GST_DEBUG_OBJECT (parse, "stop");
   gst_h264_parse_reset (h264parse);
 
+  if (h264parse->index) {
+    gst_video_parse_index_close (h264parse->index);
+    h264parse->index = NULL;
+  }
+
   gst_h264_nal_parser_free (h264parse->nalparser);
 
   return TRUE;
@@ -411,31 +447,151 @@ gst_h264_parse_negotiate (GstH264Parse * h264parse, gint in_format,
       align == GST_H264_PARSE_ALIGN_AU;
 }
 
-static GstBuffer *
-gst_h264_parse_wrap_nal (GstH264Parse * h264parse, guint format, guint8 * data,
+/* number of bytes of length prefixes handed out from one memory */
+#define PREFIXES_SIZE 256
+
+/* Returns a memory holding the start code or length prefix of a NAL of
+ * @size bytes. Start codes share one memory, length prefixes are written
+ * to a block that is shared until it is full. */
+static GstMemory *
+gst_h264_parse_get_prefix (GstH264Parse * h264parse, guint format,
     guint size)
 {
-  GstBuffer *buf;
   guint nl = h264parse->nal_length_size;
-  guint32 tmp;
+  GstMemory *prefix;
+  guint i;
+
+  if (format != GST_H264_PARSE_FORMAT_AVC
+      && format != GST_H264_PARSE_FORMAT_AVC3) {
+    /* HACK: nl should always be 4 here, otherwise this won't work.
+     * There are legit cases where nl in avc stream is 2, but byte-stream
+     * SC is still always 4 bytes. */
+    return gst_memory_ref (h264parse->start_code);
+  }
+
+  if (!h264parse->prefixes || h264parse->prefixes_used + nl > PREFIXES_SIZE) {
+    if (h264parse->prefixes)
+      gst_memory_unref (h264parse->prefixes);
+    /* the handed out parts are never written again, so the block is filled
+     * through its data pointer instead of mapping it */
+    h264parse->prefixes_data = g_malloc (PREFIXES_SIZE);
+    h264parse->prefixes = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+        h264parse->prefixes_data, PREFIXES_SIZE, 0, PREFIXES_SIZE,
+        h264parse->prefixes_data, g_free);
+    h264parse->prefixes_used = 0;
+  }
+
+  for (i = 0; i < nl; i++)
+    h264parse->prefixes_data[h264parse->prefixes_used + i] =
+        size >> (8 * (nl - 1 - i));
+  prefix = gst_memory_share (h264parse->prefixes, h264parse->prefixes_used,
+      nl);
+  h264parse->prefixes_used += nl;
+
+  return prefix;
+}
+
+/* Appends @size bytes at @offset of @src to @buf, after a start code or
+ * length prefix, without copying the NAL payload. Returns FALSE if @buf
+ * has no room for the memories of the NAL, keeping one for a copied tail. */
+static gboolean
+gst_h264_parse_append_nal (GstH264Parse * h264parse, GstBuffer * buf,
+    guint format, GstBuffer * src, guint offset, guint size)
+{
+  guint idx, length;
+  gsize skip;
 
   GST_DEBUG_OBJECT (h264parse, "nal length %d", size);
 
-  buf = gst_buffer_new_allocate (NULL, 4 + size, NULL);
-  if (format == GST_H264_PARSE_FORMAT_AVC
-      || format == GST_H264_PARSE_FORMAT_AVC3) {
-    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
+  if (!gst_buffer_find_memory (src, offset, size, &idx, &length, &skip))
+    return FALSE;
+
+  if (gst_buffer_n_memory (buf) + length + 2 > gst_buffer_get_max_memory ())
+    return FALSE;
+
+  gst_buffer_append_memory (buf,
+      gst_h264_parse_get_prefix (h264parse, format, size));
+  gst_buffer_copy_into (buf, src, GST_BUFFER_COPY_MEMORY, offset, size);
+
+  return TRUE;
+}
+
+/* Adds a properly prefixed NAL to the converted frame. A shared NAL takes
+ * two memories, its prefix and its payload, or more if the payload spans
+ * several input memories. As a buffer holds at most
+ * gst_buffer_get_max_memory() (16) memories and one is kept for the tail,
+ * only the first 7 NALs of a frame are shared at best, the following ones
+ * are copied once into the tail. */
+static void
+gst_h264_parse_convert_nal (GstH264Parse * h264parse, GstBuffer * src,
+    GstH264NalUnit * nalu)
+{
+  GstByteWriter *bw = &h264parse->frame_out_tail;
+  guint nl = h264parse->nal_length_size;
+  gboolean ok = TRUE;
+
+  if (!h264parse->frame_out)
+    h264parse->frame_out = gst_buffer_new ();
+
+  if (!h264parse->frame_out_copy) {
+    if (gst_h264_parse_append_nal (h264parse, h264parse->frame_out,
+            h264parse->format, src, nalu->offset, nalu->size))
+      return;
+
+    /* merging the memories would copy the whole frame, each time the
+     * buffer is full, so copy this NAL and all the following ones once */
+    GST_LOG_OBJECT (h264parse, "frame has too many NALs, copying the rest");
+    h264parse->frame_out_copy = TRUE;
+  }
+
+  if (h264parse->format == GST_H264_PARSE_FORMAT_AVC
+      || h264parse->format == GST_H264_PARSE_FORMAT_AVC3) {
+    ok &= gst_byte_writer_put_uint32_be (bw, nalu->size << (32 - 8 * nl));
+    ok &= gst_byte_writer_set_pos (bw, gst_byte_writer_get_pos (bw) - 4 + nl);
   } else {
-    /* HACK: nl should always be 4 here, otherwise this won't work. 
-     * There are legit cases where nl in avc stream is 2, but byte-stream
-     * SC is still always 4 bytes. */
-    nl = 4;
-    tmp = GUINT32_TO_BE (1);
+    ok &= gst_byte_writer_put_data (bw, start_code, sizeof (start_code));
   }
+  ok &= gst_byte_writer_put_data (bw, nalu->data + nalu->offset, nalu->size);
+
+  if (G_UNLIKELY (!ok))
+    GST_ERROR_OBJECT (h264parse, "failed to copy nal");
+}
+
+static gsize
+gst_h264_parse_frame_out_size (GstH264Parse * h264parse)
+{
+  if (!h264parse->frame_out)
+    return 0;
+
+  return gst_buffer_get_size (h264parse->frame_out) +
+      gst_byte_writer_get_pos (&h264parse->frame_out_tail);
+}
 
-  gst_buffer_fill (buf, 0, &tmp, sizeof (guint32));
-  gst_buffer_fill (buf, nl, data, size);
-  gst_buffer_set_size (buf, size + nl);
+/* returns the converted frame, or NULL if nothing was collected */
+static GstBuffer *
+gst_h264_parse_take_frame_out (GstH264Parse * h264parse)
+{
+  GstByteWriter *bw = &h264parse->frame_out_tail;
+  GstBuffer *buf = h264parse->frame_out;
+  guint tail = gst_byte_writer_get_pos (bw);
+
+  h264parse->frame_out = NULL;
+  if (!buf)
+    return NULL;
+
+  if (tail > 0) {
+    guint8 *data = gst_byte_writer_reset_and_get_data (bw);
+
+    gst_buffer_append_memory (buf, gst_memory_new_wrapped (0, data, tail, 0,
+            tail, data, g_free));
+    gst_byte_writer_init (bw);
+  }
+  h264parse->frame_out_copy = FALSE;
+
+  if (gst_buffer_get_size (buf) == 0) {
+    gst_buffer_unref (buf);
+    return NULL;
+  }
 
   return buf;
 }
@@ -463,6 +619,14 @@ gst_h264_parser_store_nal (GstH264Parse * h264parse, guint id,
     return;
   }
 
+  /* parameter sets are usually repeated verbatim, keep the stored copy */
+  if (store[id] && gst_buffer_get_size (store[id]) == size
+      && gst_buffer_memcmp (store[id], 0, nalu->data + nalu->offset,
+          size) == 0) {
+    GST_LOG_OBJECT (h264parse, "nal unchanged");
+    return;
+  }
+
   buf = gst_buffer_new_allocate (NULL, size, NULL);
   gst_buffer_fill (buf, 0, nalu->data + nalu->offset, size);
 
@@ -516,10 +680,10 @@ gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
   GstH264SEIMessage sei;
   GstH264NalParser *nalparser = h264parse->nalparser;
   GstH264ParserResult pres;
-  GArray *messages;
+  GArray *messages = h264parse->sei_messages;
   guint i;
 
-  pres = gst_h264_parser_parse_sei (nalparser, nalu, &messages);
+  pres = gst_h264_parser_parse_sei_into (nalparser, nalu, messages);
   if (pres != GST_H264_PARSER_OK)
     GST_WARNING_OBJECT (h264parse, "failed to parse one or more SEI message");
 
@@ -689,12 +853,13 @@ gst_h264_parse_process_sei (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       }
     }
   }
-  g_array_free (messages, TRUE);
 }
 
-/* caller guarantees 2 bytes of nal payload */
+/* caller guarantees 2 bytes of nal payload, @buffer holds the data
+ * @nalu refers to */
 static gboolean
-gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
+gst_h264_parse_process_nal (GstH264Parse * h264parse, GstBuffer * buffer,
+    GstH264NalUnit * nalu)
 {
   guint nal_type;
   GstH264PPS pps = { 0, };
@@ -794,7 +959,7 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       /* mark SEI pos */
       if (h264parse->sei_pos == -1) {
         if (h264parse->transform)
-          h264parse->sei_pos = gst_adapter_available (h264parse->frame_out);
+          h264parse->sei_pos = gst_h264_parse_frame_out_size (h264parse);
         else
           h264parse->sei_pos = nalu->sc_offset;
         GST_DEBUG_OBJECT (h264parse, "marking SEI in frame at offset %d",
@@ -833,8 +998,17 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
             "parse result %d, first MB: %u, slice type: %u",
             pres, slice.first_mb_in_slice, slice.type);
         if (pres == GST_H264_PARSER_OK) {
-          if (GST_H264_IS_I_SLICE (&slice) || GST_H264_IS_SI_SLICE (&slice))
+          GstVideoParseFrameType type = GST_VIDEO_PARSE_FRAME_TYPE_P;
+
+          if (GST_H264_IS_I_SLICE (&slice) || GST_H264_IS_SI_SLICE (&slice)) {
             h264parse->keyframe |= TRUE;
+            type = GST_VIDEO_PARSE_FRAME_TYPE_I;
+          } else if (GST_H264_IS_B_SLICE (&slice)) {
+            type = GST_VIDEO_PARSE_FRAME_TYPE_B;
+          }
+          /* a frame is as dependent as its most dependent slice */
+          h264parse->frame_type = MAX (h264parse->frame_type, type);
+          h264parse->frame_idr |= (nal_type == GST_H264_NAL_SLICE_IDR);
 
           h264parse->state |= GST_H264_PARSE_STATE_GOT_SLICE;
           h264parse->field_pic_flag = slice.field_pic_flag;
@@ -850,7 +1024,7 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       /* mind replacement buffer if applicable */
       if (h264parse->idr_pos == -1) {
         if (h264parse->transform)
-          h264parse->idr_pos = gst_adapter_available (h264parse->frame_out);
+          h264parse->idr_pos = gst_h264_parse_frame_out_size (h264parse);
         else
           h264parse->idr_pos = nalu->sc_offset;
         GST_DEBUG_OBJECT (h264parse, "marking IDR in frame at offset %d",
@@ -880,15 +1054,11 @@ gst_h264_parse_process_nal (GstH264Parse * h264parse, GstH264NalUnit * nalu)
       break;
   }
 
-  /* if AVC output needed, collect properly prefixed nal in adapter,
+  /* if AVC output needed, collect properly prefixed nal,
    * and use that to replace outgoing buffer data later on */
   if (h264parse->transform) {
-    GstBuffer *buf;
-
     GST_LOG_OBJECT (h264parse, "collecting NAL in AVC frame");
-    buf = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
-        nalu->data + nalu->offset, nalu->size);
-    gst_adapter_push (h264parse->frame_out, buf);
+    gst_h264_parse_convert_nal (h264parse, buffer, nalu);
   }
   return TRUE;
 }
@@ -980,7 +1150,7 @@ gst_h264_parse_handle_frame_packetized (GstBaseParse * parse,
     GST_DEBUG_OBJECT (h264parse, "AVC nal offset %d", nalu.offset + nalu.size);
 
     /* either way, have a look at it */
-    gst_h264_parse_process_nal (h264parse, &nalu);
+    gst_h264_parse_process_nal (h264parse, buffer, &nalu);
 
     /* dispatch per NALU if needed */
     if (h264parse->split_packetized) {
@@ -1217,7 +1387,7 @@ gst_h264_parse_handle_frame (GstBaseParse * parse,
       }
     }
 
-    if (!gst_h264_parse_process_nal (h264parse, &nalu)) {
+    if (!gst_h264_parse_process_nal (h264parse, buffer, &nalu)) {
       GST_WARNING_OBJECT (h264parse,
           "broken/invalid nal Type: %d %s, Size: %u will be dropped",
           nalu.type, _nal_name (nalu.type), nalu.size);
@@ -2073,8 +2243,7 @@ static GstFlowReturn
 gst_h264_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 {
   GstH264Parse *h264parse;
-  GstBuffer *buffer;
-  guint av;
+  GstBuffer *buffer, *buf;
 
   h264parse = GST_H264_PARSE (parse);
   buffer = frame->buffer;
@@ -2104,11 +2273,8 @@ gst_h264_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   }
 
   /* replace with transformed AVC output if applicable */
-  av = gst_adapter_available (h264parse->frame_out);
-  if (av) {
-    GstBuffer *buf;
-
-    buf = gst_adapter_take_buffer (h264parse->frame_out, av);
+  buf = gst_h264_parse_take_frame_out (h264parse);
+  if (buf) {
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -2123,17 +2289,16 @@ static GstFlowReturn
 gst_h264_parse_push_codec_buffer (GstH264Parse * h264parse,
     GstBuffer * nal, GstClockTime ts)
 {
-  GstMapInfo map;
+  GstBuffer *buf = gst_buffer_new ();
 
-  gst_buffer_map (nal, &map, GST_MAP_READ);
-  nal = gst_h264_parse_wrap_nal (h264parse, h264parse->format,
-      map.data, map.size);
-  gst_buffer_unmap (nal, &map);
+  /* stored codec NALs are a single memory, so they always fit */
+  gst_h264_parse_append_nal (h264parse, buf, h264parse->format, nal, 0,
+      gst_buffer_get_size (nal));
 
-  GST_BUFFER_TIMESTAMP (nal) = ts;
-  GST_BUFFER_DURATION (nal) = 0;
+  GST_BUFFER_TIMESTAMP (buf) = ts;
+  GST_BUFFER_DURATION (buf) = 0;
 
-  return gst_pad_push (GST_BASE_PARSE_SRC_PAD (h264parse), nal);
+  return gst_pad_push (GST_BASE_PARSE_SRC_PAD (h264parse), buf);
 }
 
 static GstEvent *
@@ -2441,6 +2606,18 @@ gst_h264_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   }
 #endif
 
+  if (h264parse->index) {
+    GstVideoParseIndexFlags flags = GST_VIDEO_PARSE_INDEX_FLAG_NONE;
+
+    if (h264parse->keyframe)
+      flags |= GST_VIDEO_PARSE_INDEX_FLAG_KEYFRAME;
+    if (h264parse->frame_idr)
+      flags |= GST_VIDEO_PARSE_INDEX_FLAG_GOP_START;
+
+    gst_video_parse_index_add_frame (h264parse->index, parse, frame,
+        h264parse->frame_type, flags);
+  }
+
   gst_h264_parse_reset_frame (h264parse);
 
   return GST_FLOW_OK;
@@ -2579,7 +2756,7 @@ gst_h264_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
         goto avcc_too_small;
       }
 
-      gst_h264_parse_process_nal (h264parse, &nalu);
+      gst_h264_parse_process_nal (h264parse, codec_data, &nalu);
       off = nalu.offset + nalu.size;
     }
 
@@ -2594,7 +2771,7 @@ gst_h264_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
         goto avcc_too_small;
       }
 
-      gst_h264_parse_process_nal (h264parse, &nalu);
+      gst_h264_parse_process_nal (h264parse, codec_data, &nalu);
       off = nalu.offset + nalu.size;
     }
 
@@ -2854,6 +3031,12 @@ gst_h264_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_int (value);
       break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_free (parse->index_location);
+      parse->index_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2872,6 +3055,11 @@ gst_h264_parse_get_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       g_value_set_int (value, parse->interval);
       break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_value_set_string (value, parse->index_location);
+      GST_OBJECT_UNLOCK (parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -27,9 +27,12 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbaseparse.h>
+#include <gst/base/gstbytewriter.h>
 #include <gst/codecparsers/gsth264parser.h>
 #include <gst/video/video.h>
 
+#include "gstvideoparseindex.h"
+
 G_BEGIN_DECLS
 
 typedef struct _H264Params H264Params;
@@ -111,15 +114,32 @@ struct _GstH264Parse
   /*guint next_sc_pos;*/
   gint idr_pos, sei_pos;
   gboolean update_caps;
-  GstAdapter *frame_out;
+  /* converted frame: a prefix memory and the input memories of each NAL,
+   * NALs that do not fit in its memories are copied in frame_out_tail */
+  GstBuffer *frame_out;
+  GstByteWriter frame_out_tail;
+  gboolean frame_out_copy;
+  /* shared start code, and block the length prefixes are handed out from */
+  GstMemory *start_code;
+  GstMemory *prefixes;
+  guint8 *prefixes_data;
+  guint prefixes_used;
+  /* reused for every SEI NAL */
+  GArray *sei_messages;
   gboolean keyframe;
   gboolean header;
   gboolean frame_start;
+  GstVideoParseFrameType frame_type;
+  gboolean frame_idr;
   /* AU state */
   gboolean picture_start;
 
   /* props */
   gint interval;
+  gchar *index_location;
+
+  /* frame index, if index-location is set */
+  GstVideoParseIndex *index;
 
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
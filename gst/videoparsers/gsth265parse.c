@@ -32,12 +32,22 @@
 GST_DEBUG_CATEGORY (h265_parse_debug);
 #define GST_CAT_DEFAULT h265_parse_debug
 
+static const guint8 start_code[4] = { 0x00, 0x00, 0x00, 0x01 };
+
+/* a slice mapped on its own, and its offset in the buffer */
+typedef struct
+{
+  GstMapInfo map;
+  guint shift;
+} GstH265ParseSliceMap;
+
 #define DEFAULT_CONFIG_INTERVAL      (0)
 
 enum
 {
   PROP_0,
-  PROP_CONFIG_INTERVAL
+  PROP_CONFIG_INTERVAL,
+  PROP_INDEX_LOCATION
 };
 
 enum
@@ -90,6 +100,8 @@ static gboolean gst_h265_parse_set_caps (GstBaseParse * parse, GstCaps * caps);
 static GstCaps *gst_h265_parse_get_caps (GstBaseParse * parse,
     GstCaps * filter);
 static gboolean gst_h265_parse_event (GstBaseParse * parse, GstEvent * event);
+static gboolean gst_h265_parse_sink_query (GstBaseParse * parse,
+    GstQuery * query);
 static gboolean gst_h265_parse_src_event (GstBaseParse * parse,
     GstEvent * event);
 
@@ -113,6 +125,14 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
           "will be multiplexed in the data stream when detected.) (0 = disabled)",
           0, 3600, DEFAULT_CONFIG_INTERVAL,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index Location",
+          "Frame index file. If it holds a complete index of the stream, "
+          "it is used for seeking, otherwise it is (re)written with the "
+          "offset, timestamps and type of every frame while parsing",
+          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   /* Override BaseParse vfuncs */
   parse_class->start = GST_DEBUG_FUNCPTR (gst_h265_parse_start);
   parse_class->stop = GST_DEBUG_FUNCPTR (gst_h265_parse_stop);
@@ -122,6 +142,7 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
   parse_class->set_sink_caps = GST_DEBUG_FUNCPTR (gst_h265_parse_set_caps);
   parse_class->get_sink_caps = GST_DEBUG_FUNCPTR (gst_h265_parse_get_caps);
   parse_class->sink_event = GST_DEBUG_FUNCPTR (gst_h265_parse_event);
+  parse_class->sink_query = GST_DEBUG_FUNCPTR (gst_h265_parse_sink_query);
   parse_class->src_event = GST_DEBUG_FUNCPTR (gst_h265_parse_src_event);
 
   gst_element_class_add_static_pad_template (gstelement_class, &srctemplate);
@@ -136,7 +157,18 @@ gst_h265_parse_class_init (GstH265ParseClass * klass)
 static void
 gst_h265_parse_init (GstH265Parse * h265parse)
 {
-  h265parse->frame_out = gst_adapter_new ();
+  gst_byte_writer_init (&h265parse->frame_out_tail);
+  h265parse->start_code = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+      (gpointer) start_code, sizeof (start_code), 0, sizeof (start_code),
+      NULL, NULL);
+  h265parse->frame_nals = g_array_new (FALSE, FALSE, sizeof (GstH265NalUnit));
+  h265parse->out_nals = g_array_new (FALSE, FALSE, sizeof (GstH265NalUnit));
+  h265parse->slice_segments =
+      g_array_new (FALSE, TRUE, sizeof (GstH265SliceSegment));
+  g_array_set_clear_func (h265parse->slice_segments,
+      (GDestroyNotify) gst_h265_slice_segment_clear);
+  h265parse->slice_maps =
+      g_array_new (FALSE, FALSE, sizeof (GstH265ParseSliceMap));
   gst_base_parse_set_pts_interpolation (GST_BASE_PARSE (h265parse), FALSE);
   GST_PAD_SET_ACCEPT_INTERSECT (GST_BASE_PARSE_SINK_PAD (h265parse));
   GST_PAD_SET_ACCEPT_TEMPLATE (GST_BASE_PARSE_SINK_PAD (h265parse));
@@ -148,7 +180,16 @@ gst_h265_parse_finalize (GObject * object)
 {
   GstH265Parse *h265parse = GST_H265_PARSE (object);
 
-  g_object_unref (h265parse->frame_out);
+  gst_buffer_replace (&h265parse->frame_out, NULL);
+  gst_byte_writer_reset (&h265parse->frame_out_tail);
+  gst_memory_unref (h265parse->start_code);
+  if (h265parse->prefixes)
+    gst_memory_unref (h265parse->prefixes);
+  g_array_free (h265parse->frame_nals, TRUE);
+  g_array_free (h265parse->out_nals, TRUE);
+  g_array_free (h265parse->slice_segments, TRUE);
+  g_array_free (h265parse->slice_maps, TRUE);
+  g_free (h265parse->index_location);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -167,7 +208,27 @@ gst_h265_parse_reset_frame (GstH265Parse * h265parse)
   h265parse->sei_pos = -1;
   h265parse->keyframe = FALSE;
   h265parse->header = FALSE;
-  gst_adapter_clear (h265parse->frame_out);
+  h265parse->frame_type = GST_VIDEO_PARSE_FRAME_TYPE_UNKNOWN;
+  h265parse->frame_irap = FALSE;
+  gst_buffer_replace (&h265parse->frame_out, NULL);
+  gst_byte_writer_reset (&h265parse->frame_out_tail);
+  gst_byte_writer_init (&h265parse->frame_out_tail);
+  h265parse->frame_out_copy = FALSE;
+  g_array_set_size (h265parse->frame_nals, 0);
+  h265parse->n_slice_segments = 0;
+}
+
+/* the segments are kept from one AU to the next, so that their substream
+ * storage is reused */
+static GstH265SliceSegment *
+gst_h265_parse_next_slice_segment (GstH265Parse * h265parse)
+{
+  guint n = h265parse->n_slice_segments++;
+
+  if (n == h265parse->slice_segments->len)
+    g_array_set_size (h265parse->slice_segments, n + 1);
+
+  return &g_array_index (h265parse->slice_segments, GstH265SliceSegment, n);
 }
 
 static void
@@ -201,6 +262,8 @@ gst_h265_parse_reset (GstH265Parse * h265parse)
   h265parse->pending_key_unit_ts = GST_CLOCK_TIME_NONE;
   h265parse->force_key_unit_event = NULL;
 
+  h265parse->out_nals_buffer = NULL;
+
   gst_h265_parse_reset_frame (h265parse);
 }
 
@@ -216,6 +279,11 @@ gst_h265_parse_start (GstBaseParse * parse)
 
   gst_base_parse_set_min_frame_size (parse, 7);
 
+  GST_OBJECT_LOCK (h265parse);
+  if (h265parse->index_location)
+    h265parse->index = gst_video_parse_index_open (h265parse->index_location);
+  GST_OBJECT_UNLOCK (h265parse);
+
   return TRUE;
 }
 
@@ -237,6 +305,11 @@ gst_h265_parse_stop (GstBaseParse * parse)
 
   gst_h265_parser_free (h265parse->nalparser);
 
+  if (h265parse->index) {
+    gst_video_parse_index_close (h265parse->index);
+    h265parse->index = NULL;
+  }
+
   return TRUE;
 }
 
@@ -360,31 +433,167 @@ gst_h265_parse_negotiate (GstH265Parse * h265parse, gint in_format,
   h265parse->transform = (in_format != h265parse->format);
 }
 
-static GstBuffer *
-gst_h265_parse_wrap_nal (GstH265Parse * h265parse, guint format, guint8 * data,
+/* number of bytes of length prefixes handed out from one memory */
+#define PREFIXES_SIZE 256
+
+/* Returns a memory holding the start code or length prefix of a NAL of
+ * @size bytes. Start codes share one memory, length prefixes are written
+ * to a block that is shared until it is full. */
+static GstMemory *
+gst_h265_parse_get_prefix (GstH265Parse * h265parse, guint format,
     guint size)
 {
-  GstBuffer *buf;
   guint nl = h265parse->nal_length_size;
-  guint32 tmp;
-
-  GST_DEBUG_OBJECT (h265parse, "nal length %d", size);
+  GstMemory *prefix;
+  guint i;
 
-  buf = gst_buffer_new_allocate (NULL, 4 + size, NULL);
-  if (format == GST_H265_PARSE_FORMAT_HVC1
-      || format == GST_H265_PARSE_FORMAT_HEV1) {
-    tmp = GUINT32_TO_BE (size << (32 - 8 * nl));
-  } else {
+  if (format != GST_H265_PARSE_FORMAT_HVC1
+      && format != GST_H265_PARSE_FORMAT_HEV1) {
     /* HACK: nl should always be 4 here, otherwise this won't work.
      * There are legit cases where nl in hevc stream is 2, but byte-stream
      * SC is still always 4 bytes. */
-    nl = 4;
-    tmp = GUINT32_TO_BE (1);
+    return gst_memory_ref (h265parse->start_code);
+  }
+
+  if (!h265parse->prefixes || h265parse->prefixes_used + nl > PREFIXES_SIZE) {
+    if (h265parse->prefixes)
+      gst_memory_unref (h265parse->prefixes);
+    /* the handed out parts are never written again, so the block is filled
+     * through its data pointer instead of mapping it */
+    h265parse->prefixes_data = g_malloc (PREFIXES_SIZE);
+    h265parse->prefixes = gst_memory_new_wrapped (GST_MEMORY_FLAG_READONLY,
+        h265parse->prefixes_data, PREFIXES_SIZE, 0, PREFIXES_SIZE,
+        h265parse->prefixes_data, g_free);
+    h265parse->prefixes_used = 0;
+  }
+
+  for (i = 0; i < nl; i++)
+    h265parse->prefixes_data[h265parse->prefixes_used + i] =
+        size >> (8 * (nl - 1 - i));
+  prefix = gst_memory_share (h265parse->prefixes, h265parse->prefixes_used,
+      nl);
+  h265parse->prefixes_used += nl;
+
+  return prefix;
+}
+
+/* Appends @size bytes at @offset of @src to @buf, after a start code or
+ * length prefix, without copying the NAL payload. Returns FALSE if @buf
+ * has no room for the memories of the NAL, keeping one for a copied tail. */
+static gboolean
+gst_h265_parse_append_nal (GstH265Parse * h265parse, GstBuffer * buf,
+    guint format, GstBuffer * src, guint offset, guint size)
+{
+  guint idx, length;
+  gsize skip;
+
+  GST_DEBUG_OBJECT (h265parse, "nal length %d", size);
+
+  if (!gst_buffer_find_memory (src, offset, size, &idx, &length, &skip))
+    return FALSE;
+
+  if (gst_buffer_n_memory (buf) + length + 2 > gst_buffer_get_max_memory ())
+    return FALSE;
+
+  gst_buffer_append_memory (buf,
+      gst_h265_parse_get_prefix (h265parse, format, size));
+  gst_buffer_copy_into (buf, src, GST_BUFFER_COPY_MEMORY, offset, size);
+
+  return TRUE;
+}
+
+static gsize
+gst_h265_parse_frame_out_size (GstH265Parse * h265parse)
+{
+  if (!h265parse->frame_out)
+    return 0;
+
+  return gst_buffer_get_size (h265parse->frame_out) +
+      gst_byte_writer_get_pos (&h265parse->frame_out_tail);
+}
+
+/* Adds a properly prefixed NAL to the converted frame. A shared NAL takes
+ * two memories, its prefix and its payload, or more if the payload spans
+ * several input memories. As a buffer holds at most
+ * gst_buffer_get_max_memory() (16) memories and one is kept for the tail,
+ * only the first 7 NALs of a frame are shared at best, the following ones
+ * are copied once into the tail. */
+static void
+gst_h265_parse_convert_nal (GstH265Parse * h265parse, GstBuffer * src,
+    GstH265NalUnit * nalu)
+{
+  GstByteWriter *bw = &h265parse->frame_out_tail;
+  guint nl = h265parse->nal_length_size;
+  gboolean hvc = h265parse->format == GST_H265_PARSE_FORMAT_HVC1
+      || h265parse->format == GST_H265_PARSE_FORMAT_HEV1;
+  GstH265NalUnit out = *nalu;
+  gboolean ok = TRUE;
+
+  if (!h265parse->frame_out)
+    h265parse->frame_out = gst_buffer_new ();
+
+  /* remember where the NAL ends up, its data is not kept */
+  out.sc_offset = gst_h265_parse_frame_out_size (h265parse);
+  out.offset = out.sc_offset + (hvc ? nl : sizeof (start_code));
+  out.data = NULL;
+  g_array_append_val (h265parse->frame_nals, out);
+
+  if (!h265parse->frame_out_copy) {
+    if (gst_h265_parse_append_nal (h265parse, h265parse->frame_out,
+            h265parse->format, src, nalu->offset, nalu->size))
+      return;
+
+    /* merging the memories would copy the whole frame, each time the
+     * buffer is full, so copy this NAL and all the following ones once */
+    GST_LOG_OBJECT (h265parse, "frame has too many NALs, copying the rest");
+    h265parse->frame_out_copy = TRUE;
+  }
+
+  if (hvc) {
+    ok &= gst_byte_writer_put_uint32_be (bw, nalu->size << (32 - 8 * nl));
+    ok &= gst_byte_writer_set_pos (bw, gst_byte_writer_get_pos (bw) - 4 + nl);
+  } else {
+    ok &= gst_byte_writer_put_data (bw, start_code, sizeof (start_code));
+  }
+  ok &= gst_byte_writer_put_data (bw, nalu->data + nalu->offset, nalu->size);
+
+  if (G_UNLIKELY (!ok))
+    GST_ERROR_OBJECT (h265parse, "failed to copy nal");
+}
+
+/* returns the converted frame, or NULL if nothing was collected */
+static GstBuffer *
+gst_h265_parse_take_frame_out (GstH265Parse * h265parse)
+{
+  GstByteWriter *bw = &h265parse->frame_out_tail;
+  GstBuffer *buf = h265parse->frame_out;
+  guint tail = gst_byte_writer_get_pos (bw);
+  GArray *nals;
+
+  h265parse->frame_out = NULL;
+  if (!buf)
+    return NULL;
+
+  if (tail > 0) {
+    guint8 *data = gst_byte_writer_reset_and_get_data (bw);
+
+    gst_buffer_append_memory (buf, gst_memory_new_wrapped (0, data, tail, 0,
+            tail, data, g_free));
+    gst_byte_writer_init (bw);
   }
+  h265parse->frame_out_copy = FALSE;
 
-  gst_buffer_fill (buf, 0, &tmp, sizeof (guint32));
-  gst_buffer_fill (buf, nl, data, size);
-  gst_buffer_set_size (buf, size + nl);
+  /* keep the NAL layout for the slice meta of the pushed frame */
+  nals = h265parse->out_nals;
+  h265parse->out_nals = h265parse->frame_nals;
+  h265parse->frame_nals = nals;
+  g_array_set_size (h265parse->frame_nals, 0);
+
+  if (gst_buffer_get_size (buf) == 0) {
+    gst_buffer_unref (buf);
+    buf = NULL;
+  }
+  h265parse->out_nals_buffer = buf;
 
   return buf;
 }
@@ -416,6 +625,14 @@ gst_h265_parser_store_nal (GstH265Parse * h265parse, guint id,
     return;
   }
 
+  /* parameter sets are usually repeated verbatim, keep the stored copy */
+  if (store[id] && gst_buffer_get_size (store[id]) == size
+      && gst_buffer_memcmp (store[id], 0, nalu->data + nalu->offset,
+          size) == 0) {
+    GST_LOG_OBJECT (h265parse, "nal unchanged");
+    return;
+  }
+
   buf = gst_buffer_new_allocate (NULL, size, NULL);
   gst_buffer_fill (buf, 0, nalu->data + nalu->offset, size);
 
@@ -483,9 +700,11 @@ _nal_name (GstH265NalUnitType nal_type)
 }
 #endif
 
-/* caller guarantees 2 bytes of nal payload */
+/* caller guarantees 2 bytes of nal payload, @buffer holds the data
+ * @nalu refers to */
 static void
-gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
+gst_h265_parse_process_nal (GstH265Parse * h265parse, GstBuffer * buffer,
+    GstH265NalUnit * nalu)
 {
   GstH265PPS pps = { 0, };
   GstH265SPS sps = { 0, };
@@ -585,7 +804,7 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
       /* mark SEI pos */
       if (h265parse->sei_pos == -1) {
         if (h265parse->transform)
-          h265parse->sei_pos = gst_adapter_available (h265parse->frame_out);
+          h265parse->sei_pos = gst_h265_parse_frame_out_size (h265parse);
         else
           h265parse->sei_pos = nalu->sc_offset;
         GST_DEBUG_OBJECT (h265parse, "marking SEI in frame at offset %d",
@@ -610,23 +829,46 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
     case GST_H265_NAL_SLICE_IDR_N_LP:
     case GST_H265_NAL_SLICE_CRA_NUT:
     {
-      GstH265SliceHdr slice;
-
-      pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, &slice);
+      GstH265SliceHdr slice_hdr, *slice = &slice_hdr;
+
+      /* the slice meta needs the entry points too, parse them at once so
+       * that the header is only parsed once */
+      if (h265parse->send_slice_meta) {
+        GstH265SliceSegment *segment =
+            gst_h265_parse_next_slice_segment (h265parse);
+
+        segment->nalu = *nalu;
+        pres = gst_h265_parser_parse_slice_segments (nalparser, segment, 1,
+            NULL);
+        slice = &segment->header;
+      } else {
+        pres = gst_h265_parser_parse_slice_hdr (nalparser, nalu, slice);
+      }
 
       if (pres == GST_H265_PARSER_OK) {
-        if (GST_H265_IS_I_SLICE (&slice))
+        GstVideoParseFrameType type = GST_VIDEO_PARSE_FRAME_TYPE_P;
+
+        if (GST_H265_IS_I_SLICE (slice)) {
           h265parse->keyframe |= TRUE;
+          type = GST_VIDEO_PARSE_FRAME_TYPE_I;
+        } else if (GST_H265_IS_B_SLICE (slice)) {
+          type = GST_VIDEO_PARSE_FRAME_TYPE_B;
+        }
+        /* a frame is as dependent as its most dependent slice */
+        h265parse->frame_type = MAX (h265parse->frame_type, type);
+        h265parse->frame_irap |= (nal_type >= GST_H265_NAL_SLICE_BLA_W_LP &&
+            nal_type <= GST_H265_NAL_SLICE_CRA_NUT);
       }
-      if (slice.first_slice_segment_in_pic_flag == 1)
+      if (slice->first_slice_segment_in_pic_flag == 1)
         GST_DEBUG_OBJECT (h265parse,
             "frame start, first_slice_segment_in_pic_flag = 1");
 
       GST_DEBUG_OBJECT (h265parse,
           "parse result %d, first slice_segment: %u, slice type: %u",
-          pres, slice.first_slice_segment_in_pic_flag, slice.type);
+          pres, slice->first_slice_segment_in_pic_flag, slice->type);
 
-      gst_h265_slice_hdr_free (&slice);
+      if (slice == &slice_hdr)
+        gst_h265_slice_hdr_free (&slice_hdr);
     }
 
       is_irap = ((nal_type >= GST_H265_NAL_SLICE_BLA_W_LP)
@@ -641,7 +883,7 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
       /* mind replacement buffer if applicable */
       if (h265parse->idr_pos == -1) {
         if (h265parse->transform)
-          h265parse->idr_pos = gst_adapter_available (h265parse->frame_out);
+          h265parse->idr_pos = gst_h265_parse_frame_out_size (h265parse);
         else
           h265parse->idr_pos = nalu->sc_offset;
         GST_DEBUG_OBJECT (h265parse, "marking IDR in frame at offset %d",
@@ -658,15 +900,11 @@ gst_h265_parse_process_nal (GstH265Parse * h265parse, GstH265NalUnit * nalu)
       gst_h265_parser_parse_nal (nalparser, nalu);
   }
 
-  /* if HEVC output needed, collect properly prefixed nal in adapter,
+  /* if HEVC output needed, collect properly prefixed nal,
    * and use that to replace outgoing buffer data later on */
   if (h265parse->transform) {
-    GstBuffer *buf;
-
     GST_LOG_OBJECT (h265parse, "collecting NAL in HEVC frame");
-    buf = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
-        nalu->data + nalu->offset, nalu->size);
-    gst_adapter_push (h265parse->frame_out, buf);
+    gst_h265_parse_convert_nal (h265parse, buffer, nalu);
   }
 }
 
@@ -756,7 +994,7 @@ gst_h265_parse_handle_frame_packetized (GstBaseParse * parse,
     GST_DEBUG_OBJECT (h265parse, "HEVC nal offset %d", nalu.offset + nalu.size);
 
     /* either way, have a look at it */
-    gst_h265_parse_process_nal (h265parse, &nalu);
+    gst_h265_parse_process_nal (h265parse, buffer, &nalu);
 
     /* dispatch per NALU if needed */
     if (h265parse->split_packetized) {
@@ -972,7 +1210,7 @@ gst_h265_parse_handle_frame (GstBaseParse * parse,
         nalu.type == GST_H265_NAL_SPS ||
         nalu.type == GST_H265_NAL_PPS ||
         (h265parse->have_sps && h265parse->have_pps)) {
-      gst_h265_parse_process_nal (h265parse, &nalu);
+      gst_h265_parse_process_nal (h265parse, buffer, &nalu);
     } else {
       GST_WARNING_OBJECT (h265parse,
           "no SPS/PPS yet, nal Type: %d %s, Size: %u will be dropped",
@@ -1624,8 +1862,7 @@ static GstFlowReturn
 gst_h265_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 {
   GstH265Parse *h265parse;
-  GstBuffer *buffer;
-  guint av;
+  GstBuffer *buffer, *buf;
 
   h265parse = GST_H265_PARSE (parse);
   buffer = frame->buffer;
@@ -1647,11 +1884,8 @@ gst_h265_parse_parse_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
     GST_BUFFER_FLAG_UNSET (buffer, GST_BUFFER_FLAG_HEADER);
 
   /* replace with transformed HEVC output if applicable */
-  av = gst_adapter_available (h265parse->frame_out);
-  if (av) {
-    GstBuffer *buf;
-
-    buf = gst_adapter_take_buffer (h265parse->frame_out, av);
+  buf = gst_h265_parse_take_frame_out (h265parse);
+  if (buf) {
     gst_buffer_copy_into (buf, buffer, GST_BUFFER_COPY_METADATA, 0, -1);
     gst_buffer_replace (&frame->out_buffer, buf);
     gst_buffer_unref (buf);
@@ -1666,17 +1900,16 @@ static GstFlowReturn
 gst_h265_parse_push_codec_buffer (GstH265Parse * h265parse, GstBuffer * nal,
     GstClockTime ts)
 {
-  GstMapInfo map;
+  GstBuffer *buf = gst_buffer_new ();
 
-  gst_buffer_map (nal, &map, GST_MAP_READ);
-  nal = gst_h265_parse_wrap_nal (h265parse, h265parse->format,
-      map.data, map.size);
-  gst_buffer_unmap (nal, &map);
+  /* stored codec NALs are a single memory, so they always fit */
+  gst_h265_parse_append_nal (h265parse, buf, h265parse->format, nal, 0,
+      gst_buffer_get_size (nal));
 
-  GST_BUFFER_TIMESTAMP (nal) = ts;
-  GST_BUFFER_DURATION (nal) = 0;
+  GST_BUFFER_TIMESTAMP (buf) = ts;
+  GST_BUFFER_DURATION (buf) = 0;
 
-  return gst_pad_push (GST_BASE_PARSE_SRC_PAD (h265parse), nal);
+  return gst_pad_push (GST_BASE_PARSE_SRC_PAD (h265parse), buf);
 }
 
 static GstEvent *
@@ -1780,6 +2013,166 @@ gst_h265_parse_prepare_key_unit (GstH265Parse * parse, GstEvent * event)
   parse->push_codec = TRUE;
 }
 
+static inline gboolean
+gst_h265_parse_is_slice (const GstH265NalUnit * nalu)
+{
+  return (nalu->type >= GST_H265_NAL_SLICE_TRAIL_N
+      && nalu->type <= GST_H265_NAL_SLICE_RASL_R)
+      || (nalu->type >= GST_H265_NAL_SLICE_BLA_W_LP
+      && nalu->type <= GST_H265_NAL_SLICE_CRA_NUT);
+}
+
+/* Places the next slice segment of the outgoing AU at @nalu. The segment
+ * parsed while processing the frame is moved there if it is the same NAL,
+ * otherwise, e.g. if the slice meta was only just negotiated, it is parsed
+ * now. @parsed is the number of segments parsed while processing. */
+static void
+gst_h265_parse_locate_slice (GstH265Parse * h265parse, guint parsed,
+    const GstH265NalUnit * nalu)
+{
+  GstH265SliceSegment *segment;
+  guint n = h265parse->n_slice_segments;
+  guint i;
+
+  segment = gst_h265_parse_next_slice_segment (h265parse);
+
+  if (n < parsed && segment->nalu.type == nalu->type
+      && segment->nalu.size == nalu->size) {
+    if (segment->result == GST_H265_PARSER_OK) {
+      segment->data_offset += nalu->offset - segment->nalu.offset;
+      for (i = 0; i < segment->num_substreams; i++)
+        segment->substream_offsets[i] += nalu->offset - segment->nalu.offset;
+    }
+    segment->nalu = *nalu;
+    return;
+  }
+
+  segment->nalu = *nalu;
+  gst_h265_parser_parse_slice_segments (h265parse->nalparser, segment, 1,
+      NULL);
+}
+
+/* collects the slice segments of the AU in @map */
+static void
+gst_h265_parse_find_slices (GstH265Parse * h265parse, guint parsed,
+    GstMapInfo * map)
+{
+  GstH265Parser *nalparser = h265parse->nalparser;
+  GstH265ParserResult pres;
+  GstH265NalUnit nalu;
+  guint off = 0;
+
+  while (off < map->size) {
+    if (h265parse->format == GST_H265_PARSE_FORMAT_BYTE)
+      pres = gst_h265_parser_identify_nalu (nalparser, map->data, off,
+          map->size, &nalu);
+    else
+      pres = gst_h265_parser_identify_nalu_hevc (nalparser, map->data, off,
+          map->size, h265parse->nal_length_size, &nalu);
+
+    /* the last NAL of a byte-stream AU has no following start code */
+    if (pres != GST_H265_PARSER_OK && (pres != GST_H265_PARSER_NO_NAL_END
+            || h265parse->format != GST_H265_PARSE_FORMAT_BYTE))
+      break;
+
+    if (gst_h265_parse_is_slice (&nalu))
+      gst_h265_parse_locate_slice (h265parse, parsed, &nalu);
+
+    off = nalu.offset + nalu.size;
+  }
+}
+
+/* collects the slice segments of the converted frame @buffer from the NALs
+ * recorded while converting it. Mapping the frame as a whole would merge its
+ * memories, so each slice is mapped on its own, and its offsets are relative
+ * to its map until shifted back */
+static void
+gst_h265_parse_map_slices (GstH265Parse * h265parse, guint parsed,
+    GstBuffer * buffer)
+{
+  GArray *nals = h265parse->out_nals;
+  guint i;
+
+  for (i = 0; i < nals->len; i++) {
+    GstH265NalUnit *nalu = &g_array_index (nals, GstH265NalUnit, i);
+    GstH265ParseSliceMap slice_map;
+    GstH265NalUnit slice_nalu;
+    guint idx, length;
+    gsize skip;
+
+    if (!gst_h265_parse_is_slice (nalu))
+      continue;
+
+    if (!gst_buffer_find_memory (buffer, nalu->offset, nalu->size, &idx,
+            &length, &skip)
+        || !gst_buffer_map_range (buffer, idx, length, &slice_map.map,
+            GST_MAP_READ))
+      break;
+    slice_map.shift = nalu->offset - skip;
+    g_array_append_val (h265parse->slice_maps, slice_map);
+
+    slice_nalu = *nalu;
+    slice_nalu.data = slice_map.map.data;
+    slice_nalu.offset = skip;
+    slice_nalu.sc_offset = nalu->sc_offset - slice_map.shift;
+    gst_h265_parse_locate_slice (h265parse, parsed, &slice_nalu);
+  }
+}
+
+/* locates the slice segments and substreams of the outgoing AU for
+ * decoders that dispatch tiles or WPP rows to several threads */
+static void
+gst_h265_parse_add_slice_meta (GstH265Parse * h265parse, GstBuffer * buffer)
+{
+  GstH265SliceSegment *segments;
+  GstMapInfo map = GST_MAP_INFO_INIT;
+  guint parsed = h265parse->n_slice_segments;
+  guint i, j;
+
+  /* the segments parsed while processing the frame are moved to where the
+   * slices are in @buffer */
+  h265parse->n_slice_segments = 0;
+
+  if (buffer == h265parse->out_nals_buffer
+      && gst_buffer_n_memory (buffer) > 1) {
+    gst_h265_parse_map_slices (h265parse, parsed, buffer);
+  } else {
+    if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+      return;
+    gst_h265_parse_find_slices (h265parse, parsed, &map);
+  }
+
+  if (h265parse->n_slice_segments > 0) {
+    segments = (GstH265SliceSegment *) h265parse->slice_segments->data;
+
+    /* make the offsets of separately mapped slices offsets in @buffer */
+    for (i = 0; i < h265parse->slice_maps->len; i++) {
+      GstH265SliceSegment *segment = &segments[i];
+      guint shift = g_array_index (h265parse->slice_maps,
+          GstH265ParseSliceMap, i).shift;
+
+      segment->nalu.offset += shift;
+      segment->nalu.sc_offset += shift;
+      segment->data_offset += shift;
+      for (j = 0; j < segment->num_substreams; j++)
+        segment->substream_offsets[j] += shift;
+    }
+
+    GST_LOG_OBJECT (h265parse, "adding slice meta for %u slice segments",
+        h265parse->n_slice_segments);
+    gst_buffer_add_h265_slice_meta (buffer, segments,
+        h265parse->n_slice_segments);
+  }
+
+  for (i = 0; i < h265parse->slice_maps->len; i++)
+    gst_buffer_unmap (buffer, &g_array_index (h265parse->slice_maps,
+            GstH265ParseSliceMap, i).map);
+  g_array_set_size (h265parse->slice_maps, 0);
+
+  if (map.memory)
+    gst_buffer_unmap (buffer, &map);
+}
+
 static GstFlowReturn
 gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
 {
@@ -1961,6 +2354,7 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
           GST_BUFFER_FLAG_UNSET (new_buf, GST_BUFFER_FLAG_DELTA_UNIT);
           gst_buffer_replace (&frame->out_buffer, new_buf);
           gst_buffer_unref (new_buf);
+          h265parse->out_nals_buffer = NULL;
           /* some result checking seems to make some compilers happy */
           if (G_UNLIKELY (!ok)) {
             GST_ERROR_OBJECT (h265parse, "failed to insert SPS/PPS");
@@ -1975,6 +2369,29 @@ gst_h265_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
     }
   }
 
+  if (h265parse->send_slice_meta &&
+      h265parse->align == GST_H265_PARSE_ALIGN_AU) {
+    if (frame->out_buffer) {
+      frame->out_buffer = gst_buffer_make_writable (frame->out_buffer);
+      gst_h265_parse_add_slice_meta (h265parse, frame->out_buffer);
+    } else {
+      frame->buffer = gst_buffer_make_writable (frame->buffer);
+      gst_h265_parse_add_slice_meta (h265parse, frame->buffer);
+    }
+  }
+
+  if (h265parse->index) {
+    GstVideoParseIndexFlags flags = GST_VIDEO_PARSE_INDEX_FLAG_NONE;
+
+    if (h265parse->keyframe)
+      flags |= GST_VIDEO_PARSE_INDEX_FLAG_KEYFRAME;
+    if (h265parse->frame_irap)
+      flags |= GST_VIDEO_PARSE_INDEX_FLAG_GOP_START;
+
+    gst_video_parse_index_add_frame (h265parse->index, parse, frame,
+        h265parse->frame_type, flags);
+  }
+
   gst_h265_parse_reset_frame (h265parse);
 
   return GST_FLOW_OK;
@@ -2057,7 +2474,7 @@ gst_h265_parse_set_caps (GstBaseParse * parse, GstCaps * caps)
           goto hvcc_too_small;
         }
 
-        gst_h265_parse_process_nal (h265parse, &nalu);
+        gst_h265_parse_process_nal (h265parse, codec_data, &nalu);
         off = nalu.offset + nalu.size;
       }
     }
@@ -2189,6 +2606,26 @@ gst_h265_parse_get_caps (GstBaseParse * parse, GstCaps * filter)
   return res;
 }
 
+static gboolean
+gst_h265_parse_sink_query (GstBaseParse * parse, GstQuery * query)
+{
+  GstH265Parse *h265parse = GST_H265_PARSE (parse);
+  gboolean res;
+
+  res = GST_BASE_PARSE_CLASS (parent_class)->sink_query (parse, query);
+
+  if (res && GST_QUERY_TYPE (query) == GST_QUERY_ALLOCATION) {
+    h265parse->send_slice_meta =
+        gst_query_find_allocation_meta (query, GST_H265_SLICE_META_API_TYPE,
+        NULL);
+
+    GST_DEBUG_OBJECT (parse, "Downstream can handle GstH265SliceMeta : %d",
+        h265parse->send_slice_meta);
+  }
+
+  return res;
+}
+
 static gboolean
 gst_h265_parse_event (GstBaseParse * parse, GstEvent * event)
 {
@@ -2290,6 +2727,12 @@ gst_h265_parse_set_property (GObject * object, guint prop_id,
     case PROP_CONFIG_INTERVAL:
       parse->interval = g_value_get_uint (value);
       break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_free (parse->index_location);
+      parse->index_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -2307,6 +2750,11 @@ gst_h265_parse_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_CONFIG_INTERVAL:
       g_value_set_uint (value, parse->interval);
       break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_value_set_string (value, parse->index_location);
+      GST_OBJECT_UNLOCK (parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -23,7 +23,11 @@
 
 #include <gst/gst.h>
 #include <gst/base/gstbaseparse.h>
+#include <gst/base/gstbytewriter.h>
 #include <gst/codecparsers/gsth265parser.h>
+#include <gst/codecparsers/gsth265slicemeta.h>
+
+#include "gstvideoparseindex.h"
 
 G_BEGIN_DECLS
 
@@ -42,7 +46,6 @@ GType gst_h265_parse_get_type (void);
 
 typedef struct _GstH265Parse GstH265Parse;
 typedef struct _GstH265ParseClass GstH265ParseClass;
-
 struct _GstH265Parse
 {
   GstBaseParse baseparse;
@@ -81,16 +84,43 @@ struct _GstH265Parse
   /* frame parsing */
   gint idr_pos, sei_pos;
   gboolean update_caps;
-  GstAdapter *frame_out;
+  /* converted frame: a prefix memory and the input memories of each NAL,
+   * NALs that do not fit in its memories are copied in frame_out_tail */
+  GstBuffer *frame_out;
+  GstByteWriter frame_out_tail;
+  gboolean frame_out_copy;
+  /* shared start code, and block the length prefixes are handed out from */
+  GstMemory *start_code;
+  GstMemory *prefixes;
+  guint8 *prefixes_data;
+  guint prefixes_used;
+  /* NALs of frame_out at their output offsets, and those of the last
+   * converted frame, so its slices can be mapped one by one */
+  GArray *frame_nals;
+  GArray *out_nals;
+  GstBuffer *out_nals_buffer;
   gboolean keyframe;
   gboolean header;
+  GstVideoParseFrameType frame_type;
+  gboolean frame_irap;
   /* AU state */
   gboolean picture_start;
 
   /* props */
   guint interval;
+  gchar *index_location;
+
+  /* frame index, if index-location is set */
+  GstVideoParseIndex *index;
 
   gboolean sent_codec_tag;
+  gboolean send_slice_meta;
+  /* GstH265SliceSegment of the AU, when sending slice meta. The entries past
+   * n_slice_segments are only kept for their storage */
+  GArray *slice_segments;
+  guint n_slice_segments;
+  /* slices of the AU mapped one by one */
+  GArray *slice_maps;
 
   GstClockTime pending_key_unit_ts;
   GstEvent *force_key_unit_event;
@@ -59,7 +59,8 @@ enum
 {
   PROP_0,
   PROP_DROP,
-  PROP_GOP_SPLIT
+  PROP_GOP_SPLIT,
+  PROP_INDEX_LOCATION
 };
 
 #define parent_class gst_mpegv_parse_parent_class
@@ -97,6 +98,12 @@ gst_mpegv_parse_set_property (GObject * object, guint property_id,
     case PROP_GOP_SPLIT:
       parse->gop_split = g_value_get_boolean (value);
       break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_free (parse->index_location);
+      parse->index_location = g_value_dup_string (value);
+      GST_OBJECT_UNLOCK (parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
@@ -115,11 +122,26 @@ gst_mpegv_parse_get_property (GObject * object, guint property_id,
     case PROP_GOP_SPLIT:
       g_value_set_boolean (value, parse->gop_split);
       break;
+    case PROP_INDEX_LOCATION:
+      GST_OBJECT_LOCK (parse);
+      g_value_set_string (value, parse->index_location);
+      GST_OBJECT_UNLOCK (parse);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
   }
 }
 
+static void
+gst_mpegv_parse_finalize (GObject * object)
+{
+  GstMpegvParse *parse = GST_MPEGVIDEO_PARSE (object);
+
+  g_free (parse->index_location);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
 static void
 gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
 {
@@ -132,6 +154,7 @@ gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
 
   parent_class = g_type_class_peek_parent (klass);
 
+  gobject_class->finalize = gst_mpegv_parse_finalize;
   gobject_class->set_property = gst_mpegv_parse_set_property;
   gobject_class->get_property = gst_mpegv_parse_get_property;
 
@@ -146,6 +169,13 @@ gst_mpegv_parse_class_init (GstMpegvParseClass * klass)
           "Split frame when encountering GOP", DEFAULT_PROP_GOP_SPLIT,
           G_PARAM_CONSTRUCT | G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_INDEX_LOCATION,
+      g_param_spec_string ("index-location", "Index Location",
+          "Frame index file. If it holds a complete index of the stream, "
+          "it is used for seeking, otherwise it is (re)written with the "
+          "offset, timestamps and type of every frame while parsing",
+          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_add_static_pad_template (element_class, &src_template);
   gst_element_class_add_static_pad_template (element_class, &sink_template);
 
@@ -191,6 +221,7 @@ gst_mpegv_parse_reset_frame (GstMpegvParse * mpvparse)
   mpvparse->ext_count = 0;
   mpvparse->slice_count = 0;
   mpvparse->slice_offset = 0;
+  mpvparse->gop_start = FALSE;
 }
 
 static void
@@ -247,6 +278,11 @@ gst_mpegv_parse_start (GstBaseParse * parse)
   /* at least this much for a valid frame */
   gst_base_parse_set_min_frame_size (parse, 6);
 
+  GST_OBJECT_LOCK (mpvparse);
+  if (mpvparse->index_location)
+    mpvparse->index = gst_video_parse_index_open (mpvparse->index_location);
+  GST_OBJECT_UNLOCK (mpvparse);
+
   return TRUE;
 }
 
@@ -259,6 +295,11 @@ gst_mpegv_parse_stop (GstBaseParse * parse)
 
   gst_mpegv_parse_reset (mpvparse);
 
+  if (mpvparse->index) {
+    gst_video_parse_index_close (mpvparse->index);
+    mpvparse->index = NULL;
+  }
+
   return TRUE;
 }
 
@@ -491,12 +532,16 @@ gst_mpegv_parse_process_sc (GstMpegvParse * mpvparse,
       break;
     case GST_MPEG_VIDEO_PACKET_SEQUENCE:
       GST_LOG_OBJECT (mpvparse, "startcode is SEQUENCE");
+      if (mpvparse->pic_offset < 0)
+        mpvparse->gop_start = TRUE;
       if (mpvparse->seq_offset < 0)
         mpvparse->seq_offset = off;
       ret = TRUE;
       break;
     case GST_MPEG_VIDEO_PACKET_GOP:
       GST_LOG_OBJECT (mpvparse, "startcode is GOP");
+      if (mpvparse->pic_offset < 0)
+        mpvparse->gop_start = TRUE;
       if (mpvparse->seq_offset >= 0)
         ret = mpvparse->gop_split;
       else
@@ -1002,6 +1047,34 @@ gst_mpegv_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
     meta->num_slices = mpvparse->slice_count;
     meta->slice_offset = mpvparse->slice_offset;
   }
+
+  if (mpvparse->index) {
+    GstVideoParseFrameType type = GST_VIDEO_PARSE_FRAME_TYPE_UNKNOWN;
+    GstVideoParseIndexFlags flags = GST_VIDEO_PARSE_INDEX_FLAG_NONE;
+
+    if (mpvparse->pic_offset >= 0) {
+      switch (mpvparse->pichdr.pic_type) {
+        case GST_MPEG_VIDEO_PICTURE_TYPE_I:
+          type = GST_VIDEO_PARSE_FRAME_TYPE_I;
+          flags |= GST_VIDEO_PARSE_INDEX_FLAG_KEYFRAME;
+          if (mpvparse->gop_start)
+            flags |= GST_VIDEO_PARSE_INDEX_FLAG_GOP_START;
+          break;
+        case GST_MPEG_VIDEO_PICTURE_TYPE_P:
+          type = GST_VIDEO_PARSE_FRAME_TYPE_P;
+          break;
+        case GST_MPEG_VIDEO_PICTURE_TYPE_B:
+          type = GST_VIDEO_PARSE_FRAME_TYPE_B;
+          break;
+        default:
+          break;
+      }
+    }
+
+    gst_video_parse_index_add_frame (mpvparse->index, parse, frame, type,
+        flags);
+  }
+
   return GST_FLOW_OK;
 }
 
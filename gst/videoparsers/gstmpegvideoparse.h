@@ -30,6 +30,8 @@
 
 #include <gst/codecparsers/gstmpegvideoparser.h>
 
+#include "gstvideoparseindex.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_MPEGVIDEO_PARSE            (gst_mpegv_parse_get_type())
@@ -67,6 +69,8 @@ struct _GstMpegvParse {
   gint pic_offset;
   guint slice_count;
   guint slice_offset;
+  /* sequence or GOP header before the picture */
+  gboolean gop_start;
   gboolean update_caps;
   gboolean send_codec_tag;
   gboolean send_mpeg_meta;
@@ -90,6 +94,10 @@ struct _GstMpegvParse {
   /* properties */
   gboolean drop;
   gboolean gop_split;
+  gchar *index_location;
+
+  /* frame index, if index-location is set */
+  GstVideoParseIndex *index;
 
   int fps_num;
   int fps_den;
@@ -0,0 +1,608 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/*
+ * Frame index sidecar files for the video parsers.
+ *
+ * While parsing, the parsers already know where each frame starts, its
+ * timestamps and whether it is a keyframe. This records that in a file next
+ * to the media, so that the next time the same stream is parsed the parser
+ * can seed its seeking index from the file instead of scanning the stream
+ * for keyframes.
+ *
+ * File layout, all values big endian:
+ *
+ *   8 bytes   "GSTVPIDX"
+ *   4 bytes   version (3)
+ *   4 bytes   flags, bit 0 set once the whole stream has been indexed
+ *   8 bytes   size of the media in bytes, 0 if unknown
+ *   8 bytes   modification time of the media in seconds, 0 if unknown
+ *   8 bytes   hash of the first frame, identifying media of unknown size
+ *   n * 26    entries: offset (8), pts (8), dts (8), frame type (1),
+ *             flags (1)
+ *
+ * Entries are appended as frames are pushed, so memory use does not grow
+ * with the stream length while the index is being written, in whatever
+ * order seeks make the parser visit the stream. The byte ranges covered so
+ * far are tracked, bytes the parser skipped between two frames count as
+ * covered. The index is written next to @location and only replaces it once
+ * the ranges cover the whole media, or a single range from the start of the
+ * stream reaches EOS, so an interrupted run or a seek past unindexed frames
+ * never leaves a partial index behind.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <glib/gstdio.h>
+#include <gst/base/gstbytereader.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include "gstvideoparseindex.h"
+
+GST_DEBUG_CATEGORY_STATIC (video_parse_index_debug);
+#define GST_CAT_DEFAULT video_parse_index_debug
+
+#define INDEX_MAGIC "GSTVPIDX"
+#define INDEX_VERSION 3
+#define INDEX_HEADER_SIZE 40
+#define INDEX_FLAGS_OFFSET 12
+#define INDEX_ENTRY_SIZE 26
+
+#define INDEX_FILE_FLAG_COMPLETE (1 << 0)
+
+typedef struct
+{
+  /* byte offset of the frame in the parser input */
+  guint64 offset;
+  GstClockTime pts;
+  GstClockTime dts;
+  guint8 frame_type;
+  guint8 flags;
+} GstVideoParseIndexEntry;
+
+typedef struct
+{
+  guint64 start;
+  guint64 end;
+} GstVideoParseIndexRange;
+
+struct _GstVideoParseIndex
+{
+  gchar *location;
+
+  /* whether the media was identified and the index loaded or created */
+  gboolean prepared;
+  guint64 media_size;
+  guint64 media_mtime;
+  guint64 fingerprint;
+
+  /* a complete index read from @location, keyframes only, sorted by time */
+  GArray *keyframes;
+
+  /* the index being written to @tmp_location */
+  gchar *tmp_location;
+  FILE *file;
+  guint n_written;
+
+  /* the byte ranges covered by the frames written, sorted and disjoint, and
+   * the one the frames being parsed extend, -1 after a seek */
+  GArray *ranges;
+  gint run;
+
+  /* watches the segments and EOS pushed by the parser */
+  GstBaseParse *parse;
+  gulong probe_id;
+};
+
+static void
+gst_video_parse_index_init_debug (void)
+{
+  static gsize done = 0;
+
+  if (g_once_init_enter (&done)) {
+    GST_DEBUG_CATEGORY_INIT (video_parse_index_debug, "videoparseindex", 0,
+        "video parser frame index");
+    g_once_init_leave (&done, 1);
+  }
+}
+
+static GstClockTime
+entry_time (const GstVideoParseIndexEntry * entry)
+{
+  return GST_CLOCK_TIME_IS_VALID (entry->pts) ? entry->pts : entry->dts;
+}
+
+static gint
+compare_entries (gconstpointer a, gconstpointer b)
+{
+  GstClockTime ta = entry_time (a);
+  GstClockTime tb = entry_time (b);
+
+  return ta < tb ? -1 : (ta > tb ? 1 : 0);
+}
+
+/* Identifies the media parsed by @parse by its size, and by its modification
+ * time if it is a local file. Without either, e.g. behind a demuxer, the
+ * media is identified by the hash of @frame, the first one parsed. */
+static void
+gst_video_parse_index_query_media (GstVideoParseIndex * index,
+    GstBaseParse * parse, GstBaseParseFrame * frame)
+{
+  GstPad *sinkpad = GST_BASE_PARSE_SINK_PAD (parse);
+  GstQuery *query;
+  gchar *uri = NULL, *filename = NULL;
+  GStatBuf st;
+  GstMapInfo map;
+  gint64 size;
+  gsize i;
+
+  index->media_size = 0;
+  index->media_mtime = 0;
+  index->fingerprint = 0;
+
+  query = gst_query_new_uri ();
+  if (gst_pad_peer_query (sinkpad, query))
+    gst_query_parse_uri (query, &uri);
+  gst_query_unref (query);
+
+  if (uri)
+    filename = g_filename_from_uri (uri, NULL, NULL);
+
+  if (filename && g_stat (filename, &st) == 0) {
+    index->media_size = st.st_size;
+    index->media_mtime = st.st_mtime;
+  } else if (gst_pad_peer_query_duration (sinkpad, GST_FORMAT_BYTES, &size)
+      && size > 0) {
+    index->media_size = size;
+  } else if (gst_buffer_map (frame->buffer, &map, GST_MAP_READ)) {
+    /* FNV-1a of the offset and the data of the frame */
+    index->fingerprint = G_GUINT64_CONSTANT (0xcbf29ce484222325);
+    for (i = 0; i < 8; i++) {
+      index->fingerprint ^= (frame->offset >> (8 * i)) & 0xff;
+      index->fingerprint *= G_GUINT64_CONSTANT (0x100000001b3);
+    }
+    for (i = 0; i < map.size; i++) {
+      index->fingerprint ^= map.data[i];
+      index->fingerprint *= G_GUINT64_CONSTANT (0x100000001b3);
+    }
+    gst_buffer_unmap (frame->buffer, &map);
+  }
+
+  g_free (filename);
+  g_free (uri);
+}
+
+static gboolean
+gst_video_parse_index_load (GstVideoParseIndex * index)
+{
+  GstByteReader br;
+  gchar *contents;
+  gsize size;
+  guint32 version, flags;
+  guint64 media_size, media_mtime, fingerprint;
+  const guint8 *magic;
+
+  if (!g_file_get_contents (index->location, &contents, &size, NULL))
+    return FALSE;
+
+  gst_byte_reader_init (&br, (const guint8 *) contents, size);
+
+  if (!gst_byte_reader_get_data (&br, 8, &magic) ||
+      memcmp (magic, INDEX_MAGIC, 8) != 0 ||
+      !gst_byte_reader_get_uint32_be (&br, &version) ||
+      version != INDEX_VERSION ||
+      !gst_byte_reader_get_uint32_be (&br, &flags) ||
+      !gst_byte_reader_get_uint64_be (&br, &media_size) ||
+      !gst_byte_reader_get_uint64_be (&br, &media_mtime) ||
+      !gst_byte_reader_get_uint64_be (&br, &fingerprint)) {
+    GST_WARNING ("%s is not a frame index", index->location);
+    goto invalid;
+  }
+
+  if (!(flags & INDEX_FILE_FLAG_COMPLETE)) {
+    GST_INFO ("index %s is incomplete", index->location);
+    goto invalid;
+  }
+
+  if (media_size != index->media_size || media_mtime != index->media_mtime ||
+      fingerprint != index->fingerprint) {
+    GST_INFO ("index %s is for other media", index->location);
+    goto invalid;
+  }
+
+  index->keyframes = g_array_new (FALSE, FALSE,
+      sizeof (GstVideoParseIndexEntry));
+
+  while (gst_byte_reader_get_remaining (&br) >= INDEX_ENTRY_SIZE) {
+    GstVideoParseIndexEntry entry;
+
+    entry.offset = gst_byte_reader_get_uint64_be_unchecked (&br);
+    entry.pts = gst_byte_reader_get_uint64_be_unchecked (&br);
+    entry.dts = gst_byte_reader_get_uint64_be_unchecked (&br);
+    entry.frame_type = gst_byte_reader_get_uint8_unchecked (&br);
+    entry.flags = gst_byte_reader_get_uint8_unchecked (&br);
+
+    if ((entry.flags & GST_VIDEO_PARSE_INDEX_FLAG_KEYFRAME) &&
+        GST_CLOCK_TIME_IS_VALID (entry_time (&entry)))
+      g_array_append_val (index->keyframes, entry);
+  }
+
+  g_array_sort (index->keyframes, compare_entries);
+
+  GST_INFO ("loaded %u keyframes from %s", index->keyframes->len,
+      index->location);
+
+  g_free (contents);
+  return TRUE;
+
+invalid:
+  g_free (contents);
+  return FALSE;
+}
+
+static gboolean
+gst_video_parse_index_create (GstVideoParseIndex * index)
+{
+  guint8 header[INDEX_HEADER_SIZE];
+
+  index->tmp_location = g_strconcat (index->location, ".part", NULL);
+  index->file = g_fopen (index->tmp_location, "wb");
+  if (!index->file) {
+    GST_WARNING ("failed to create index %s: %s", index->tmp_location,
+        g_strerror (errno));
+    return FALSE;
+  }
+  index->ranges = g_array_new (FALSE, FALSE, sizeof (GstVideoParseIndexRange));
+  index->run = -1;
+
+  memcpy (header, INDEX_MAGIC, 8);
+  GST_WRITE_UINT32_BE (header + 8, INDEX_VERSION);
+  GST_WRITE_UINT32_BE (header + INDEX_FLAGS_OFFSET, 0);
+  GST_WRITE_UINT64_BE (header + 16, index->media_size);
+  GST_WRITE_UINT64_BE (header + 24, index->media_mtime);
+  GST_WRITE_UINT64_BE (header + 32, index->fingerprint);
+
+  if (fwrite (header, sizeof (header), 1, index->file) != 1) {
+    GST_WARNING ("failed to write index %s", index->tmp_location);
+    return FALSE;
+  }
+
+  index->n_written = 0;
+
+  return TRUE;
+}
+
+/* stops writing the index, and drops it unless @complete */
+static void
+gst_video_parse_index_finish (GstVideoParseIndex * index, gboolean complete)
+{
+  guint8 flags[4];
+
+  if (!index->file)
+    return;
+
+  if (complete) {
+    GST_WRITE_UINT32_BE (flags, INDEX_FILE_FLAG_COMPLETE);
+    if (fseek (index->file, INDEX_FLAGS_OFFSET, SEEK_SET) != 0 ||
+        fwrite (flags, sizeof (flags), 1, index->file) != 1) {
+      GST_WARNING ("failed to finish index %s", index->tmp_location);
+      complete = FALSE;
+    }
+  }
+
+  if (fclose (index->file) != 0)
+    complete = FALSE;
+  index->file = NULL;
+
+  g_array_free (index->ranges, TRUE);
+  index->ranges = NULL;
+
+  if (complete) {
+#ifdef G_OS_WIN32
+    /* rename does not replace existing files there */
+    g_unlink (index->location);
+#endif
+    if (g_rename (index->tmp_location, index->location) == 0) {
+      GST_INFO ("finished index %s with %u entries", index->location,
+          index->n_written);
+      return;
+    }
+    GST_WARNING ("failed to rename index to %s: %s", index->location,
+        g_strerror (errno));
+  }
+
+  g_unlink (index->tmp_location);
+}
+
+/*
+ * gst_video_parse_index_open:
+ * @location: the index file
+ *
+ * Creates an index for @location. The file is only read or written once the
+ * first frame is parsed, when the media can be identified.
+ *
+ * Returns: the index
+ */
+GstVideoParseIndex *
+gst_video_parse_index_open (const gchar * location)
+{
+  GstVideoParseIndex *index;
+
+  g_return_val_if_fail (location != NULL, NULL);
+
+  gst_video_parse_index_init_debug ();
+
+  index = g_slice_new0 (GstVideoParseIndex);
+  index->location = g_strdup (location);
+
+  return index;
+}
+
+/*
+ * gst_video_parse_index_close:
+ * @index: a #GstVideoParseIndex
+ *
+ * Closes @index. An index being written that does not cover the whole media
+ * yet is dropped, leaving the file at @location untouched.
+ */
+void
+gst_video_parse_index_close (GstVideoParseIndex * index)
+{
+  gst_video_parse_index_finish (index, FALSE);
+
+  if (index->probe_id)
+    gst_pad_remove_probe (GST_BASE_PARSE_SRC_PAD (index->parse),
+        index->probe_id);
+
+  if (index->keyframes)
+    g_array_free (index->keyframes, TRUE);
+
+  g_free (index->tmp_location);
+  g_free (index->location);
+  g_slice_free (GstVideoParseIndex, index);
+}
+
+/* Returns TRUE if the offsets of the frames are positions in the media, and
+ * not a count of the bytes parsed since the last seek, as they are behind a
+ * demuxer */
+static gboolean
+gst_video_parse_index_has_positions (GstBaseParse * parse)
+{
+  GstPad *sinkpad = GST_BASE_PARSE_SINK_PAD (parse);
+  const GstSegment *segment;
+  GstEvent *event;
+  gboolean ret;
+
+  if (GST_PAD_MODE (sinkpad) == GST_PAD_MODE_PULL)
+    return TRUE;
+
+  event = gst_pad_get_sticky_event (sinkpad, GST_EVENT_SEGMENT, 0);
+  if (!event)
+    return FALSE;
+  gst_event_parse_segment (event, &segment);
+  ret = segment->format == GST_FORMAT_BYTES;
+  gst_event_unref (event);
+
+  return ret;
+}
+
+/* completes the index once the ranges cover the whole media */
+static void
+gst_video_parse_index_check_complete (GstVideoParseIndex * index,
+    gboolean eos)
+{
+  GstVideoParseIndexRange *range;
+
+  if (index->ranges->len != 1)
+    return;
+
+  range = &g_array_index (index->ranges, GstVideoParseIndexRange, 0);
+  if (range->start != 0)
+    return;
+
+  /* a single run from the start of the stream to EOS covers it all, even
+   * when the size of what is parsed is not known */
+  if (eos || (index->media_size > 0 && range->end >= index->media_size))
+    gst_video_parse_index_finish (index, TRUE);
+}
+
+static GstPadProbeReturn
+gst_video_parse_index_src_event (GstPad * pad, GstPadProbeInfo * info,
+    GstVideoParseIndex * index)
+{
+  GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+
+  if (!index->file)
+    return GST_PAD_PROBE_OK;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_SEGMENT:
+      /* frames after a seek start a new range */
+      if (index->ranges->len == 0)
+        break;
+      if (!gst_video_parse_index_has_positions (index->parse)) {
+        GST_INFO_OBJECT (index->parse, "frame offsets are not positions in "
+            "the media, cannot index across a seek, dropping index");
+        gst_video_parse_index_finish (index, FALSE);
+        break;
+      }
+      index->run = -1;
+      break;
+    case GST_EVENT_EOS:
+      /* all frames were pushed before, but with a segment stop the stream
+       * may end early */
+      if (index->parse->segment.stop == -1)
+        gst_video_parse_index_check_complete (index, TRUE);
+      break;
+    default:
+      break;
+  }
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* identifies the media, then loads a complete index of it from the file, or
+ * starts writing one */
+static void
+gst_video_parse_index_prepare (GstVideoParseIndex * index,
+    GstBaseParse * parse, GstBaseParseFrame * frame)
+{
+  index->prepared = TRUE;
+
+  gst_video_parse_index_query_media (index, parse, frame);
+
+  if (gst_video_parse_index_load (index))
+    return;
+
+  if (!gst_video_parse_index_create (index)) {
+    gst_video_parse_index_finish (index, FALSE);
+    return;
+  }
+
+  GST_INFO_OBJECT (parse, "writing frame index to %s", index->tmp_location);
+
+  index->parse = parse;
+  index->probe_id = gst_pad_add_probe (GST_BASE_PARSE_SRC_PAD (parse),
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      (GstPadProbeCallback) gst_video_parse_index_src_event, index, NULL);
+}
+
+/* Adds the bytes from @start to @end to the range of the current run, or to
+ * a new one. Returns FALSE if they are already covered. */
+static gboolean
+gst_video_parse_index_cover (GstVideoParseIndex * index, guint64 start,
+    guint64 end)
+{
+  GstVideoParseIndexRange *range, *next;
+  guint i;
+
+  if (index->run < 0) {
+    GstVideoParseIndexRange new_range;
+
+    /* unless it was seeked, the parser may have skipped data at the start
+     * of the stream */
+    if (index->ranges->len == 0 && index->parse->segment.start == 0)
+      start = 0;
+
+    for (i = 0; i < index->ranges->len; i++) {
+      range = &g_array_index (index->ranges, GstVideoParseIndexRange, i);
+      if (start < range->start)
+        break;
+      /* seeked into a covered range, continue it */
+      if (start < range->end) {
+        index->run = i;
+        return FALSE;
+      }
+    }
+
+    new_range.start = start;
+    new_range.end = start;
+    g_array_insert_val (index->ranges, i, new_range);
+    index->run = i;
+  }
+
+  range = &g_array_index (index->ranges, GstVideoParseIndexRange, index->run);
+  if (start < range->end)
+    return FALSE;
+
+  /* anything skipped since the previous frame of the run is covered too */
+  range->end = end;
+
+  /* merge with the ranges the run caught up with */
+  while ((guint) index->run + 1 < index->ranges->len) {
+    next = &g_array_index (index->ranges, GstVideoParseIndexRange,
+        index->run + 1);
+    if (next->start > range->end)
+      break;
+    range->end = MAX (range->end, next->end);
+    g_array_remove_index (index->ranges, index->run + 1);
+    range = &g_array_index (index->ranges, GstVideoParseIndexRange,
+        index->run);
+  }
+
+  return TRUE;
+}
+
+/*
+ * gst_video_parse_index_add_frame:
+ * @index: a #GstVideoParseIndex
+ * @parse: the parser
+ * @frame: the frame about to be pushed
+ * @frame_type: the coding type of the frame
+ * @flags: #GstVideoParseIndexFlags of the frame
+ *
+ * To be called from the parser's pre_push_frame. With a complete index of
+ * the media, seeds the seeking index of @parse with all the keyframes on the
+ * first call, so that seeks anywhere in the stream are resolved by a lookup
+ * instead of a scan. Otherwise records @frame, and completes the index once
+ * the frames recorded cover the whole media, which does not depend on seeing
+ * EOS so it also works in pull mode, or at EOS after a single run from the
+ * start of the stream.
+ */
+void
+gst_video_parse_index_add_frame (GstVideoParseIndex * index,
+    GstBaseParse * parse, GstBaseParseFrame * frame,
+    GstVideoParseFrameType frame_type, GstVideoParseIndexFlags flags)
+{
+  GstBuffer *buffer = frame->out_buffer ? frame->out_buffer : frame->buffer;
+  guint8 data[INDEX_ENTRY_SIZE];
+  guint i;
+
+  if (!index->prepared) {
+    gst_video_parse_index_prepare (index, parse, frame);
+
+    if (index->keyframes) {
+      for (i = 0; i < index->keyframes->len; i++) {
+        GstVideoParseIndexEntry *entry =
+            &g_array_index (index->keyframes, GstVideoParseIndexEntry, i);
+
+        gst_base_parse_add_index_entry (parse, entry->offset,
+            entry_time (entry), TRUE, TRUE);
+      }
+      GST_DEBUG_OBJECT (parse, "seeded index with %u keyframes",
+          index->keyframes->len);
+    }
+  }
+
+  if (!index->file || frame->offset == -1)
+    return;
+
+  /* the input size of the frame, @buffer may have been converted */
+  if (!gst_video_parse_index_cover (index, frame->offset,
+          frame->offset + gst_buffer_get_size (frame->buffer)))
+    return;
+
+  GST_WRITE_UINT64_BE (data, frame->offset);
+  GST_WRITE_UINT64_BE (data + 8, GST_BUFFER_PTS (buffer));
+  GST_WRITE_UINT64_BE (data + 16, GST_BUFFER_DTS (buffer));
+  data[24] = frame_type;
+  data[25] = flags;
+
+  if (fwrite (data, sizeof (data), 1, index->file) != 1) {
+    GST_WARNING_OBJECT (parse, "failed to write index entry, giving up");
+    gst_video_parse_index_finish (index, FALSE);
+    return;
+  }
+  index->n_written++;
+
+  gst_video_parse_index_check_complete (index, FALSE);
+}
@@ -0,0 +1,57 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_VIDEO_PARSE_INDEX_H__
+#define __GST_VIDEO_PARSE_INDEX_H__
+
+#include <gst/gst.h>
+#include <gst/base/gstbaseparse.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  GST_VIDEO_PARSE_FRAME_TYPE_UNKNOWN = 0,
+  GST_VIDEO_PARSE_FRAME_TYPE_I,
+  GST_VIDEO_PARSE_FRAME_TYPE_P,
+  GST_VIDEO_PARSE_FRAME_TYPE_B
+} GstVideoParseFrameType;
+
+typedef enum {
+  GST_VIDEO_PARSE_INDEX_FLAG_NONE      = 0,
+  /* frame can be decoded on its own */
+  GST_VIDEO_PARSE_INDEX_FLAG_KEYFRAME  = (1 << 0),
+  /* frame starts a GOP / is a random access point (IDR, IRAP, I picture
+   * following a sequence or GOP header) */
+  GST_VIDEO_PARSE_INDEX_FLAG_GOP_START = (1 << 1)
+} GstVideoParseIndexFlags;
+
+typedef struct _GstVideoParseIndex GstVideoParseIndex;
+
+GstVideoParseIndex * gst_video_parse_index_open (const gchar * location);
+
+void gst_video_parse_index_close (GstVideoParseIndex * index);
+
+void gst_video_parse_index_add_frame (GstVideoParseIndex * index,
+                                      GstBaseParse * parse,
+                                      GstBaseParseFrame * frame,
+                                      GstVideoParseFrameType frame_type,
+                                      GstVideoParseIndexFlags flags);
+
+G_END_DECLS
+
+#endif /* __GST_VIDEO_PARSE_INDEX_H__ */
@@ -41,6 +41,7 @@
 #include <string.h>
 
 #define MAX_SIZE 32768
+#define MAX_HEADER_LENGTH 80
 
 GST_DEBUG_CATEGORY (y4mdec_debug);
 #define GST_CAT_DEFAULT y4mdec_debug
@@ -55,8 +56,13 @@ static void gst_y4m_dec_get_property (GObject * object,
 static void gst_y4m_dec_dispose (GObject * object);
 static void gst_y4m_dec_finalize (GObject * object);
 
+static gboolean gst_y4m_dec_sink_activate (GstPad * sinkpad,
+    GstObject * parent);
+static gboolean gst_y4m_dec_sink_activate_mode (GstPad * sinkpad,
+    GstObject * parent, GstPadMode mode, gboolean active);
 static GstFlowReturn gst_y4m_dec_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static void gst_y4m_dec_loop (GstPad * pad);
 static gboolean gst_y4m_dec_sink_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 
@@ -123,6 +129,10 @@ gst_y4m_dec_init (GstY4mDec * y4mdec)
 
   y4mdec->sinkpad =
       gst_pad_new_from_static_template (&gst_y4m_dec_sink_template, "sink");
+  gst_pad_set_activate_function (y4mdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_activate));
+  gst_pad_set_activatemode_function (y4mdec->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_activate_mode));
   gst_pad_set_event_function (y4mdec->sinkpad,
       GST_DEBUG_FUNCPTR (gst_y4m_dec_sink_event));
   gst_pad_set_chain_function (y4mdec->sinkpad,
@@ -207,6 +217,12 @@ gst_y4m_dec_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_NULL_TO_READY:
       break;
     case GST_STATE_CHANGE_READY_TO_PAUSED:
+      y4mdec->have_header = FALSE;
+      y4mdec->have_new_segment = FALSE;
+      y4mdec->frame_index = 0;
+      y4mdec->offset = 0;
+      gst_segment_init (&y4mdec->segment, GST_FORMAT_TIME);
+      gst_adapter_clear (y4mdec->adapter);
       break;
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
       break;
@@ -481,13 +497,216 @@ error:
   return FALSE;
 }
 
+static gboolean
+gst_y4m_dec_sink_activate (GstPad * sinkpad, GstObject * parent)
+{
+  GstQuery *query;
+  gboolean pull_mode;
+
+  query = gst_query_new_scheduling ();
+
+  if (!gst_pad_peer_query (sinkpad, query)) {
+    gst_query_unref (query);
+    goto activate_push;
+  }
+
+  pull_mode = gst_query_has_scheduling_mode_with_flags (query,
+      GST_PAD_MODE_PULL, GST_SCHEDULING_FLAG_SEEKABLE);
+  gst_query_unref (query);
+
+  if (!pull_mode)
+    goto activate_push;
+
+  GST_DEBUG_OBJECT (sinkpad, "activating pull");
+  return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PULL, TRUE);
+
+activate_push:
+  {
+    GST_DEBUG_OBJECT (sinkpad, "activating push");
+    return gst_pad_activate_mode (sinkpad, GST_PAD_MODE_PUSH, TRUE);
+  }
+}
+
+static gboolean
+gst_y4m_dec_sink_activate_mode (GstPad * sinkpad, GstObject * parent,
+    GstPadMode mode, gboolean active)
+{
+  GstY4mDec *y4mdec = GST_Y4M_DEC (parent);
+
+  switch (mode) {
+    case GST_PAD_MODE_PUSH:
+      y4mdec->pull_mode = FALSE;
+      return TRUE;
+    case GST_PAD_MODE_PULL:
+      if (active) {
+        y4mdec->pull_mode = TRUE;
+        return gst_pad_start_task (sinkpad, (GstTaskFunction) gst_y4m_dec_loop,
+            sinkpad, NULL);
+      }
+      return gst_pad_stop_task (sinkpad);
+    default:
+      return FALSE;
+  }
+}
+
+/* sets the caps from the parsed stream header on the source pad and sets up
+ * a pool if downstream needs the planes repacked */
+static gboolean
+gst_y4m_dec_negotiate (GstY4mDec * y4mdec)
+{
+  GstCaps *caps;
+  GstQuery *query;
+  gboolean ret;
+
+  caps = gst_video_info_to_caps (&y4mdec->info);
+  ret = gst_pad_set_caps (y4mdec->srcpad, caps);
+
+  query = gst_query_new_allocation (caps, FALSE);
+  y4mdec->video_meta = FALSE;
+
+  if (y4mdec->pool) {
+    gst_buffer_pool_set_active (y4mdec->pool, FALSE);
+    gst_object_unref (y4mdec->pool);
+  }
+  y4mdec->pool = NULL;
+
+  if (gst_pad_peer_query (y4mdec->srcpad, query)) {
+    y4mdec->video_meta =
+        gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
+
+    /* We only need a pool if we need to do stride conversion for downstream */
+    if (!y4mdec->video_meta && memcmp (&y4mdec->info, &y4mdec->out_info,
+            sizeof (y4mdec->info)) != 0) {
+      GstBufferPool *pool = NULL;
+      GstAllocator *allocator = NULL;
+      GstAllocationParams params;
+      GstStructure *config;
+      guint size, min, max;
+
+      if (gst_query_get_n_allocation_params (query) > 0) {
+        gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
+      } else {
+        allocator = NULL;
+        gst_allocation_params_init (&params);
+      }
+
+      if (gst_query_get_n_allocation_pools (query) > 0) {
+        gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min,
+            &max);
+        size = MAX (size, y4mdec->out_info.size);
+      } else {
+        pool = NULL;
+        size = y4mdec->out_info.size;
+        min = max = 0;
+      }
+
+      if (pool == NULL) {
+        pool = gst_video_buffer_pool_new ();
+      }
+
+      config = gst_buffer_pool_get_config (pool);
+      gst_buffer_pool_config_set_params (config, caps, size, min, max);
+      gst_buffer_pool_config_set_allocator (config, allocator, &params);
+      gst_buffer_pool_set_config (pool, config);
+
+      if (allocator)
+        gst_object_unref (allocator);
+
+      y4mdec->pool = pool;
+    }
+  } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
+          sizeof (y4mdec->info)) != 0) {
+    GstBufferPool *pool;
+    GstStructure *config;
+
+    /* No pool, create our own if we need to do stride conversion */
+    pool = gst_video_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (pool);
+    gst_buffer_pool_config_set_params (config, caps, y4mdec->out_info.size, 0,
+        0);
+    gst_buffer_pool_set_config (pool, config);
+    y4mdec->pool = pool;
+  }
+  if (y4mdec->pool) {
+    gst_buffer_pool_set_active (y4mdec->pool, TRUE);
+  }
+  gst_query_unref (query);
+  gst_caps_unref (caps);
+
+  return ret;
+}
+
+/* timestamps the frame data in @buffer, attaches the plane layout or repacks
+ * the planes for downstream and pushes it. Takes ownership of @buffer */
+static GstFlowReturn
+gst_y4m_dec_push_frame (GstY4mDec * y4mdec, GstBuffer * buffer)
+{
+  GstFlowReturn flow_ret;
+
+  GST_BUFFER_TIMESTAMP (buffer) =
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
+  GST_BUFFER_DURATION (buffer) =
+      gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index + 1) -
+      GST_BUFFER_TIMESTAMP (buffer);
+
+  y4mdec->frame_index++;
+
+  if (y4mdec->video_meta) {
+    gst_buffer_add_video_meta_full (buffer, 0, y4mdec->info.finfo->format,
+        y4mdec->info.width, y4mdec->info.height, y4mdec->info.finfo->n_planes,
+        y4mdec->info.offset, y4mdec->info.stride);
+  } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
+          sizeof (y4mdec->info)) != 0) {
+    GstBuffer *outbuf;
+    GstVideoFrame iframe, oframe;
+    gint i, j;
+    gint w, h, istride, ostride;
+    guint8 *src, *dest;
+
+    /* Allocate a new buffer and do stride conversion */
+    g_assert (y4mdec->pool != NULL);
+
+    flow_ret = gst_buffer_pool_acquire_buffer (y4mdec->pool, &outbuf, NULL);
+    if (flow_ret != GST_FLOW_OK) {
+      gst_buffer_unref (buffer);
+      return flow_ret;
+    }
+
+    gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
+    gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
+
+    for (i = 0; i < 3; i++) {
+      w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
+      h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
+      istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
+      ostride = GST_VIDEO_FRAME_COMP_STRIDE (&oframe, i);
+      src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
+      dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
+
+      for (j = 0; j < h; j++) {
+        memcpy (dest, src, w);
+
+        dest += ostride;
+        src += istride;
+      }
+    }
+
+    gst_video_frame_unmap (&iframe);
+    gst_video_frame_unmap (&oframe);
+    gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+    gst_buffer_unref (buffer);
+    buffer = outbuf;
+  }
+
+  return gst_pad_push (y4mdec->srcpad, buffer);
+}
+
 static GstFlowReturn
 gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 {
   GstY4mDec *y4mdec;
   int n_avail;
   GstFlowReturn flow_ret = GST_FLOW_OK;
-#define MAX_HEADER_LENGTH 80
   char header[MAX_HEADER_LENGTH];
   int i;
   int len;
@@ -506,8 +725,6 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
   if (!y4mdec->have_header) {
     gboolean ret;
-    GstCaps *caps;
-    GstQuery *query;
 
     if (n_avail < MAX_HEADER_LENGTH)
       return GST_FLOW_OK;
@@ -530,81 +747,7 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
     y4mdec->header_size = strlen (header) + 1;
     gst_adapter_flush (y4mdec->adapter, y4mdec->header_size);
 
-    caps = gst_video_info_to_caps (&y4mdec->info);
-    ret = gst_pad_set_caps (y4mdec->srcpad, caps);
-
-    query = gst_query_new_allocation (caps, FALSE);
-    y4mdec->video_meta = FALSE;
-
-    if (y4mdec->pool) {
-      gst_buffer_pool_set_active (y4mdec->pool, FALSE);
-      gst_object_unref (y4mdec->pool);
-    }
-    y4mdec->pool = NULL;
-
-    if (gst_pad_peer_query (y4mdec->srcpad, query)) {
-      y4mdec->video_meta =
-          gst_query_find_allocation_meta (query, GST_VIDEO_META_API_TYPE, NULL);
-
-      /* We only need a pool if we need to do stride conversion for downstream */
-      if (!y4mdec->video_meta && memcmp (&y4mdec->info, &y4mdec->out_info,
-              sizeof (y4mdec->info)) != 0) {
-        GstBufferPool *pool = NULL;
-        GstAllocator *allocator = NULL;
-        GstAllocationParams params;
-        GstStructure *config;
-        guint size, min, max;
-
-        if (gst_query_get_n_allocation_params (query) > 0) {
-          gst_query_parse_nth_allocation_param (query, 0, &allocator, &params);
-        } else {
-          allocator = NULL;
-          gst_allocation_params_init (&params);
-        }
-
-        if (gst_query_get_n_allocation_pools (query) > 0) {
-          gst_query_parse_nth_allocation_pool (query, 0, &pool, &size, &min,
-              &max);
-          size = MAX (size, y4mdec->out_info.size);
-        } else {
-          pool = NULL;
-          size = y4mdec->out_info.size;
-          min = max = 0;
-        }
-
-        if (pool == NULL) {
-          pool = gst_video_buffer_pool_new ();
-        }
-
-        config = gst_buffer_pool_get_config (pool);
-        gst_buffer_pool_config_set_params (config, caps, size, min, max);
-        gst_buffer_pool_config_set_allocator (config, allocator, &params);
-        gst_buffer_pool_set_config (pool, config);
-
-        if (allocator)
-          gst_object_unref (allocator);
-
-        y4mdec->pool = pool;
-      }
-    } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
-            sizeof (y4mdec->info)) != 0) {
-      GstBufferPool *pool;
-      GstStructure *config;
-
-      /* No pool, create our own if we need to do stride conversion */
-      pool = gst_video_buffer_pool_new ();
-      config = gst_buffer_pool_get_config (pool);
-      gst_buffer_pool_config_set_params (config, caps, y4mdec->out_info.size, 0,
-          0);
-      gst_buffer_pool_set_config (pool, config);
-      y4mdec->pool = pool;
-    }
-    if (y4mdec->pool) {
-      gst_buffer_pool_set_active (y4mdec->pool, TRUE);
-    }
-    gst_query_unref (query);
-    gst_caps_unref (caps);
-    if (!ret) {
+    if (!gst_y4m_dec_negotiate (y4mdec)) {
       GST_DEBUG_OBJECT (y4mdec, "Couldn't set caps on src pad");
       return GST_FLOW_ERROR;
     }
@@ -668,69 +811,152 @@ gst_y4m_dec_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
     buffer = gst_adapter_take_buffer (y4mdec->adapter, y4mdec->info.size);
 
-    GST_BUFFER_TIMESTAMP (buffer) =
-        gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
-    GST_BUFFER_DURATION (buffer) =
-        gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index + 1) -
-        GST_BUFFER_TIMESTAMP (buffer);
+    flow_ret = gst_y4m_dec_push_frame (y4mdec, buffer);
+    if (flow_ret != GST_FLOW_OK)
+      break;
+  }
 
-    y4mdec->frame_index++;
+  GST_DEBUG ("returning %d", flow_ret);
 
-    if (y4mdec->video_meta) {
-      gst_buffer_add_video_meta_full (buffer, 0, y4mdec->info.finfo->format,
-          y4mdec->info.width, y4mdec->info.height, y4mdec->info.finfo->n_planes,
-          y4mdec->info.offset, y4mdec->info.stride);
-    } else if (memcmp (&y4mdec->info, &y4mdec->out_info,
-            sizeof (y4mdec->info)) != 0) {
-      GstBuffer *outbuf;
-      GstVideoFrame iframe, oframe;
-      gint i, j;
-      gint w, h, istride, ostride;
-      guint8 *src, *dest;
-
-      /* Allocate a new buffer and do stride conversion */
-      g_assert (y4mdec->pool != NULL);
-
-      flow_ret = gst_buffer_pool_acquire_buffer (y4mdec->pool, &outbuf, NULL);
-      if (flow_ret != GST_FLOW_OK) {
-        gst_buffer_unref (buffer);
-        break;
-      }
+  return flow_ret;
+}
 
-      gst_video_frame_map (&iframe, &y4mdec->info, buffer, GST_MAP_READ);
-      gst_video_frame_map (&oframe, &y4mdec->out_info, outbuf, GST_MAP_WRITE);
+/* reads the line at @offset into @line, without the newline */
+static GstFlowReturn
+gst_y4m_dec_pull_line (GstY4mDec * y4mdec, guint64 offset, char *line)
+{
+  GstFlowReturn flow_ret;
+  GstBuffer *buffer = NULL;
+  gsize size, i;
+
+  flow_ret = gst_pad_pull_range (y4mdec->sinkpad, offset, MAX_HEADER_LENGTH,
+      &buffer);
+  if (flow_ret != GST_FLOW_OK)
+    return flow_ret;
+
+  size = gst_buffer_extract (buffer, 0, line, MAX_HEADER_LENGTH - 1);
+  gst_buffer_unref (buffer);
+
+  line[size] = 0;
+  for (i = 0; i < size; i++) {
+    if (line[i] == 0x0a) {
+      line[i] = 0;
+      break;
+    }
+  }
 
-      for (i = 0; i < 3; i++) {
-        w = GST_VIDEO_FRAME_COMP_WIDTH (&iframe, i);
-        h = GST_VIDEO_FRAME_COMP_HEIGHT (&iframe, i);
-        istride = GST_VIDEO_FRAME_COMP_STRIDE (&iframe, i);
-        ostride = GST_VIDEO_FRAME_COMP_STRIDE (&oframe, i);
-        src = GST_VIDEO_FRAME_COMP_DATA (&iframe, i);
-        dest = GST_VIDEO_FRAME_COMP_DATA (&oframe, i);
+  return GST_FLOW_OK;
+}
 
-        for (j = 0; j < h; j++) {
-          memcpy (dest, src, w);
+/* In pull mode the frame header is read first, then exactly the frame data
+ * is pulled, so the buffer from upstream can be pushed without copying */
+static void
+gst_y4m_dec_loop (GstPad * pad)
+{
+  GstY4mDec *y4mdec = GST_Y4M_DEC (GST_PAD_PARENT (pad));
+  GstFlowReturn flow_ret;
+  GstBuffer *buffer = NULL;
+  GstClockTime timestamp;
+  char header[MAX_HEADER_LENGTH];
+  guint64 len;
 
-          dest += ostride;
-          src += istride;
-        }
-      }
+  if (!y4mdec->have_header) {
+    gchar *stream_id;
 
-      gst_video_frame_unmap (&iframe);
-      gst_video_frame_unmap (&oframe);
-      gst_buffer_copy_into (outbuf, buffer, GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
-      gst_buffer_unref (buffer);
-      buffer = outbuf;
+    flow_ret = gst_y4m_dec_pull_line (y4mdec, 0, header);
+    if (flow_ret != GST_FLOW_OK)
+      goto pause;
+
+    if (!gst_y4m_dec_parse_header (y4mdec, header)) {
+      GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
+          ("Failed to parse YUV4MPEG header"), (NULL));
+      goto error;
     }
 
-    flow_ret = gst_pad_push (y4mdec->srcpad, buffer);
-    if (flow_ret != GST_FLOW_OK)
-      break;
+    y4mdec->header_size = strlen (header) + 1;
+    y4mdec->offset = y4mdec->header_size;
+
+    stream_id = gst_pad_create_stream_id (y4mdec->srcpad,
+        GST_ELEMENT_CAST (y4mdec), NULL);
+    gst_pad_push_event (y4mdec->srcpad, gst_event_new_stream_start (stream_id));
+    g_free (stream_id);
+
+    if (!gst_y4m_dec_negotiate (y4mdec)) {
+      GST_DEBUG_OBJECT (y4mdec, "Couldn't set caps on src pad");
+      flow_ret = GST_FLOW_NOT_NEGOTIATED;
+      goto pause;
+    }
+
+    y4mdec->have_header = TRUE;
+    gst_segment_init (&y4mdec->segment, GST_FORMAT_TIME);
+    y4mdec->have_new_segment = TRUE;
   }
 
-  GST_DEBUG ("returning %d", flow_ret);
+  if (y4mdec->have_new_segment) {
+    gst_pad_push_event (y4mdec->srcpad,
+        gst_event_new_segment (&y4mdec->segment));
+    y4mdec->have_new_segment = FALSE;
+  }
 
-  return flow_ret;
+  timestamp = gst_y4m_dec_frames_to_timestamp (y4mdec, y4mdec->frame_index);
+  if (GST_CLOCK_TIME_IS_VALID (y4mdec->segment.stop)
+      && timestamp >= y4mdec->segment.stop) {
+    GST_DEBUG_OBJECT (y4mdec, "reached segment stop");
+    flow_ret = GST_FLOW_EOS;
+    goto pause;
+  }
+
+  flow_ret = gst_y4m_dec_pull_line (y4mdec, y4mdec->offset, header);
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  if (memcmp (header, "FRAME", 5) != 0) {
+    GST_ELEMENT_ERROR (y4mdec, STREAM, DECODE,
+        ("Failed to parse YUV4MPEG frame"), (NULL));
+    goto error;
+  }
+  len = strlen (header) + 1;
+
+  flow_ret = gst_pad_pull_range (pad, y4mdec->offset + len, y4mdec->info.size,
+      &buffer);
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  if (gst_buffer_get_size (buffer) < y4mdec->info.size) {
+    GST_DEBUG_OBJECT (y4mdec, "incomplete last frame, %" G_GSIZE_FORMAT
+        " < %" G_GSIZE_FORMAT, gst_buffer_get_size (buffer), y4mdec->info.size);
+    gst_buffer_unref (buffer);
+    flow_ret = GST_FLOW_EOS;
+    goto pause;
+  }
+
+  y4mdec->offset += len + y4mdec->info.size;
+
+  flow_ret = gst_y4m_dec_push_frame (y4mdec, buffer);
+  if (flow_ret != GST_FLOW_OK)
+    goto pause;
+
+  return;
+
+pause:
+  {
+    GST_DEBUG_OBJECT (y4mdec, "pausing task, reason %s",
+        gst_flow_get_name (flow_ret));
+    gst_pad_pause_task (pad);
+    if (flow_ret == GST_FLOW_EOS) {
+      gst_pad_push_event (y4mdec->srcpad, gst_event_new_eos ());
+    } else if (flow_ret == GST_FLOW_NOT_LINKED || flow_ret < GST_FLOW_EOS) {
+      GST_ELEMENT_FLOW_ERROR (y4mdec, flow_ret);
+      gst_pad_push_event (y4mdec->srcpad, gst_event_new_eos ());
+    }
+    return;
+  }
+error:
+  {
+    gst_pad_pause_task (pad);
+    gst_pad_push_event (y4mdec->srcpad, gst_event_new_eos ());
+    return;
+  }
 }
 
 static gboolean
@@ -779,6 +1005,61 @@ gst_y4m_dec_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
   return res;
 }
 
+/* Frames have a fixed size, so in pull mode a seek only needs to compute the
+ * offset of the target frame and restart the streaming task there */
+static gboolean
+gst_y4m_dec_do_seek (GstY4mDec * y4mdec, gdouble rate, GstSeekFlags flags,
+    GstSeekType start_type, gint64 start, GstSeekType stop_type, gint64 stop)
+{
+  gboolean flush = (flags & GST_SEEK_FLAG_FLUSH) != 0;
+  GstSegment seg;
+  gint64 framenum;
+
+  if (!y4mdec->have_header) {
+    GST_DEBUG_OBJECT (y4mdec, "can't seek before the stream header");
+    return FALSE;
+  }
+
+  if (rate <= 0.0) {
+    GST_DEBUG_OBJECT (y4mdec, "negative rates are not supported");
+    return FALSE;
+  }
+
+  if (flush)
+    gst_pad_push_event (y4mdec->srcpad, gst_event_new_flush_start ());
+  else
+    gst_pad_pause_task (y4mdec->sinkpad);
+
+  GST_PAD_STREAM_LOCK (y4mdec->sinkpad);
+
+  seg = y4mdec->segment;
+  gst_segment_do_seek (&seg, rate, GST_FORMAT_TIME, flags, start_type, start,
+      stop_type, stop, NULL);
+
+  /* all frames are keyframes, start at the one containing the position */
+  framenum = gst_y4m_dec_timestamp_to_frames (y4mdec, seg.position);
+  seg.position = gst_y4m_dec_frames_to_timestamp (y4mdec, framenum);
+  if (!(flags & GST_SEEK_FLAG_ACCURATE))
+    seg.start = seg.time = seg.position;
+
+  GST_DEBUG_OBJECT (y4mdec, "seeking to frame %" G_GINT64_FORMAT, framenum);
+
+  if (flush)
+    gst_pad_push_event (y4mdec->srcpad, gst_event_new_flush_stop (TRUE));
+
+  y4mdec->segment = seg;
+  y4mdec->have_new_segment = TRUE;
+  y4mdec->frame_index = framenum;
+  y4mdec->offset = gst_y4m_dec_frames_to_bytes (y4mdec, framenum);
+
+  gst_pad_start_task (y4mdec->sinkpad, (GstTaskFunction) gst_y4m_dec_loop,
+      y4mdec->sinkpad, NULL);
+
+  GST_PAD_STREAM_UNLOCK (y4mdec->sinkpad);
+
+  return TRUE;
+}
+
 static gboolean
 gst_y4m_dec_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
@@ -808,6 +1089,13 @@ gst_y4m_dec_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
         break;
       }
 
+      if (y4mdec->pull_mode) {
+        res = gst_y4m_dec_do_seek (y4mdec, rate, flags, start_type, start,
+            stop_type, stop);
+        gst_event_unref (event);
+        break;
+      }
+
       framenum = gst_y4m_dec_timestamp_to_frames (y4mdec, start);
       GST_DEBUG ("seeking to frame %" G_GINT64_FORMAT, framenum);
       if (framenum == -1) {
@@ -882,6 +1170,21 @@ gst_y4m_dec_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
       gst_query_unref (peer_query);
       break;
     }
+    case GST_QUERY_SEEKING:
+    {
+      GstFormat format;
+
+      if (!y4mdec->pull_mode) {
+        res = gst_pad_query_default (pad, parent, query);
+        break;
+      }
+
+      gst_query_parse_seeking (query, &format, NULL, NULL, NULL);
+      gst_query_set_seeking (query, format, format == GST_FORMAT_TIME
+          && y4mdec->have_header, 0, -1);
+      res = TRUE;
+      break;
+    }
     default:
       res = gst_pad_query_default (pad, parent, query);
       break;
@@ -43,11 +43,14 @@ struct _GstY4mDec
   GstAdapter *adapter;
 
   /* state */
+  gboolean pull_mode;
   gboolean have_header;
   int frame_index;
   int header_size;
+  guint64 offset;               /* pull mode read position */
 
   gboolean have_new_segment;
+  /* BYTES segment from upstream in push mode, our TIME segment in pull mode */
   GstSegment segment;
 
   GstVideoInfo info;
@@ -26,6 +26,15 @@
  * inverse telecine and deinterlace cases that are handled by the
  * deinterlace element.
  *
+ * The filter looks at the previous and next frames as well, so output is
+ * delayed by one frame. The field order is taken from the TFF buffer flag,
+ * and with interlace-mode=mixed only buffers flagged as interlaced are
+ * deinterlaced. With #GstYadif:fields set to all, one frame is output per
+ * field, doubling the frame rate.
+ *
+ * Frames are filtered in horizontal slices of at least 64 rows by up to
+ * #GstYadif:threads threads, so small frames use fewer threads than asked.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -66,16 +75,37 @@ static gboolean gst_yadif_get_unit_size (GstBaseTransform * trans,
     GstCaps * caps, gsize * size);
 static gboolean gst_yadif_start (GstBaseTransform * trans);
 static gboolean gst_yadif_stop (GstBaseTransform * trans);
-static GstFlowReturn gst_yadif_transform (GstBaseTransform * trans,
-    GstBuffer * inbuf, GstBuffer * outbuf);
+static gboolean gst_yadif_sink_event (GstBaseTransform * trans,
+    GstEvent * event);
+static gboolean gst_yadif_query (GstBaseTransform * trans,
+    GstPadDirection direction, GstQuery * query);
+static GstFlowReturn gst_yadif_submit_input_buffer (GstBaseTransform * trans,
+    gboolean is_discont, GstBuffer * input);
+static GstFlowReturn gst_yadif_generate_output (GstBaseTransform * trans,
+    GstBuffer ** outbuf);
 
 enum
 {
   PROP_0,
-  PROP_MODE
+  PROP_MODE,
+  PROP_FIELDS,
+  PROP_THREADS
 };
 
 #define DEFAULT_MODE GST_DEINTERLACE_MODE_AUTO
+#define DEFAULT_FIELDS GST_YADIF_FIELDS_FRAME
+#define DEFAULT_THREADS 0
+
+#define MAX_THREADS 64
+/* don't bother handing out slices smaller than this many rows */
+#define MIN_SLICE_HEIGHT 64
+
+struct _GstYadifSlice
+{
+  guint index;
+  gint parity;
+  gint tff;
+};
 
 /* pad templates */
 
@@ -115,6 +145,24 @@ gst_deinterlace_modes_get_type (void)
   return deinterlace_modes_type;
 }
 
+#define GST_TYPE_YADIF_FIELDS (gst_yadif_fields_get_type ())
+static GType
+gst_yadif_fields_get_type (void)
+{
+  static GType yadif_fields_type = 0;
+
+  static const GEnumValue fields_types[] = {
+    {GST_YADIF_FIELDS_FRAME, "One frame per input frame", "frame"},
+    {GST_YADIF_FIELDS_ALL, "One frame per field (double frame rate)", "all"},
+    {0, NULL, NULL},
+  };
+
+  if (!yadif_fields_type) {
+    yadif_fields_type = g_enum_register_static ("GstYadifFields", fields_types);
+  }
+  return yadif_fields_type;
+}
+
 
 /* class initialization */
 
@@ -151,7 +199,12 @@ gst_yadif_class_init (GstYadifClass * klass)
       GST_DEBUG_FUNCPTR (gst_yadif_get_unit_size);
   base_transform_class->start = GST_DEBUG_FUNCPTR (gst_yadif_start);
   base_transform_class->stop = GST_DEBUG_FUNCPTR (gst_yadif_stop);
-  base_transform_class->transform = GST_DEBUG_FUNCPTR (gst_yadif_transform);
+  base_transform_class->sink_event = GST_DEBUG_FUNCPTR (gst_yadif_sink_event);
+  base_transform_class->query = GST_DEBUG_FUNCPTR (gst_yadif_query);
+  base_transform_class->submit_input_buffer =
+      GST_DEBUG_FUNCPTR (gst_yadif_submit_input_buffer);
+  base_transform_class->generate_output =
+      GST_DEBUG_FUNCPTR (gst_yadif_generate_output);
 
   g_object_class_install_property (gobject_class, PROP_MODE,
       g_param_spec_enum ("mode", "Deinterlace Mode",
@@ -160,11 +213,31 @@ gst_yadif_class_init (GstYadifClass * klass)
           DEFAULT_MODE,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_FIELDS,
+      g_param_spec_enum ("fields", "Fields",
+          "Output one frame per input frame, or one frame per field",
+          GST_TYPE_YADIF_FIELDS, DEFAULT_FIELDS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_THREADS,
+      g_param_spec_uint ("threads", "Threads",
+          "Number of threads filtering slices of each frame "
+          "(0 = number of processors, at most 64)", 0, MAX_THREADS, DEFAULT_THREADS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
 }
 
 static void
 gst_yadif_init (GstYadif * yadif)
 {
+  yadif->fields = DEFAULT_FIELDS;
+  yadif->threads = DEFAULT_THREADS;
+
+  g_mutex_init (&yadif->slice_lock);
+  g_cond_init (&yadif->slice_cond);
+
+  /* output buffers are generated from the frame history, never in place */
+  gst_base_transform_set_in_place (GST_BASE_TRANSFORM (yadif), FALSE);
 }
 
 void
@@ -176,6 +249,14 @@ gst_yadif_set_property (GObject * object, guint property_id,
   switch (property_id) {
     case PROP_MODE:
       yadif->mode = g_value_get_enum (value);
+      gst_base_transform_reconfigure_src (GST_BASE_TRANSFORM (yadif));
+      break;
+    case PROP_FIELDS:
+      yadif->fields = g_value_get_enum (value);
+      gst_base_transform_reconfigure_src (GST_BASE_TRANSFORM (yadif));
+      break;
+    case PROP_THREADS:
+      yadif->threads = g_value_get_uint (value);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -193,6 +274,12 @@ gst_yadif_get_property (GObject * object, guint property_id,
     case PROP_MODE:
       g_value_set_enum (value, yadif->mode);
       break;
+    case PROP_FIELDS:
+      g_value_set_enum (value, yadif->fields);
+      break;
+    case PROP_THREADS:
+      g_value_set_uint (value, yadif->threads);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -212,9 +299,10 @@ gst_yadif_dispose (GObject * object)
 void
 gst_yadif_finalize (GObject * object)
 {
-  /* GstYadif *yadif = GST_YADIF (object); */
+  GstYadif *yadif = GST_YADIF (object);
 
-  /* clean up object here */
+  g_mutex_clear (&yadif->slice_lock);
+  g_cond_clear (&yadif->slice_cond);
 
   G_OBJECT_CLASS (gst_yadif_parent_class)->finalize (object);
 }
@@ -224,6 +312,7 @@ static GstCaps *
 gst_yadif_transform_caps (GstBaseTransform * trans,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter)
 {
+  GstYadif *yadif = GST_YADIF (trans);
   GstCaps *othercaps;
 
   othercaps = gst_caps_copy (caps);
@@ -250,6 +339,38 @@ gst_yadif_transform_caps (GstBaseTransform * trans,
         "progressive", NULL);
   }
 
+  if (yadif->fields == GST_YADIF_FIELDS_ALL &&
+      yadif->mode != GST_DEINTERLACE_MODE_DISABLED) {
+    guint i;
+
+    for (i = 0; i < gst_caps_get_size (othercaps); i++) {
+      GstStructure *s = gst_caps_get_structure (othercaps, i);
+      gint fps_n, fps_d;
+
+      if (gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d)) {
+        if (fps_n == 0)
+          continue;
+        if (direction == GST_PAD_SINK)
+          gst_util_fraction_multiply (fps_n, fps_d, 2, 1, &fps_n, &fps_d);
+        else
+          gst_util_fraction_multiply (fps_n, fps_d, 1, 2, &fps_n, &fps_d);
+        gst_structure_set (s, "framerate", GST_TYPE_FRACTION, fps_n, fps_d,
+            NULL);
+      } else {
+        gst_structure_remove_field (s, "framerate");
+      }
+    }
+  }
+
+  if (filter) {
+    GstCaps *tmp;
+
+    tmp = gst_caps_intersect_full (filter, othercaps,
+        GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (othercaps);
+    othercaps = tmp;
+  }
+
   return othercaps;
 }
 
@@ -258,8 +379,23 @@ gst_yadif_set_caps (GstBaseTransform * trans, GstCaps * incaps,
     GstCaps * outcaps)
 {
   GstYadif *yadif = GST_YADIF (trans);
+  gboolean passthrough;
+
+  if (!gst_video_info_from_caps (&yadif->video_info, incaps))
+    return FALSE;
+
+  passthrough = yadif->mode == GST_DEINTERLACE_MODE_DISABLED ||
+      (yadif->mode == GST_DEINTERLACE_MODE_AUTO &&
+      yadif->fields == GST_YADIF_FIELDS_FRAME &&
+      GST_VIDEO_INFO_INTERLACE_MODE (&yadif->video_info) ==
+      GST_VIDEO_INTERLACE_MODE_PROGRESSIVE);
+  gst_base_transform_set_passthrough (trans, passthrough);
+
+  yadif->n_slices = CLAMP (GST_VIDEO_INFO_HEIGHT (&yadif->video_info) /
+      MIN_SLICE_HEIGHT, 1, yadif->n_threads);
 
-  gst_video_info_from_caps (&yadif->video_info, incaps);
+  GST_DEBUG_OBJECT (yadif, "passthrough %d, %u slices", passthrough,
+      yadif->n_slices);
 
   return TRUE;
 }
@@ -277,9 +413,51 @@ gst_yadif_get_unit_size (GstBaseTransform * trans, GstCaps * caps, gsize * size)
   return FALSE;
 }
 
+void yadif_filter (GstYadif * yadif, int parity, int tff, int slice,
+    int n_slices);
+
+static void
+gst_yadif_filter_slice (GstYadifSlice * slice, GstYadif * yadif)
+{
+  yadif_filter (yadif, slice->parity, slice->tff, slice->index,
+      yadif->n_slices);
+
+  g_mutex_lock (&yadif->slice_lock);
+  if (--yadif->slices_pending == 0)
+    g_cond_signal (&yadif->slice_cond);
+  g_mutex_unlock (&yadif->slice_lock);
+}
+
+static void
+gst_yadif_reset (GstYadif * yadif)
+{
+  gst_buffer_replace (&yadif->prev_buf, NULL);
+  gst_buffer_replace (&yadif->cur_buf, NULL);
+  gst_buffer_replace (&yadif->next_buf, NULL);
+  yadif->field = 0;
+}
+
 static gboolean
 gst_yadif_start (GstBaseTransform * trans)
 {
+  GstYadif *yadif = GST_YADIF (trans);
+  guint i;
+
+  yadif->n_threads = yadif->threads;
+  if (yadif->n_threads == 0)
+    yadif->n_threads = MIN (g_get_num_processors (), MAX_THREADS);
+  yadif->n_slices = 1;
+
+  yadif->slices = g_new (GstYadifSlice, yadif->n_threads);
+  for (i = 0; i < yadif->n_threads; i++)
+    yadif->slices[i].index = i;
+
+  if (yadif->n_threads > 1) {
+    yadif->pool = g_thread_pool_new ((GFunc) gst_yadif_filter_slice, yadif,
+        yadif->n_threads - 1, FALSE, NULL);
+  }
+
+  GST_DEBUG_OBJECT (yadif, "using %u threads", yadif->n_threads);
 
   return TRUE;
 }
@@ -287,38 +465,101 @@ gst_yadif_start (GstBaseTransform * trans)
 static gboolean
 gst_yadif_stop (GstBaseTransform * trans)
 {
+  GstYadif *yadif = GST_YADIF (trans);
+
+  gst_yadif_reset (yadif);
+
+  if (yadif->pool) {
+    g_thread_pool_free (yadif->pool, FALSE, TRUE);
+    yadif->pool = NULL;
+  }
+  g_free (yadif->slices);
+  yadif->slices = NULL;
 
   return TRUE;
 }
 
-void yadif_filter (GstYadif * yadif, int parity, int tff);
+static gboolean
+gst_yadif_is_interlaced (GstYadif * yadif, GstBuffer * buffer)
+{
+  if (yadif->mode == GST_DEINTERLACE_MODE_INTERLACED)
+    return TRUE;
 
-static GstFlowReturn
-gst_yadif_transform (GstBaseTransform * trans, GstBuffer * inbuf,
-    GstBuffer * outbuf)
+  switch (GST_VIDEO_INFO_INTERLACE_MODE (&yadif->video_info)) {
+    case GST_VIDEO_INTERLACE_MODE_INTERLEAVED:
+      return TRUE;
+    case GST_VIDEO_INTERLACE_MODE_MIXED:
+      return GST_BUFFER_FLAG_IS_SET (buffer, GST_VIDEO_BUFFER_FLAG_INTERLACED);
+    default:
+      return FALSE;
+  }
+}
+
+static GstClockTime
+gst_yadif_get_duration (GstYadif * yadif, GstBuffer * cur, GstBuffer * next)
 {
-  GstYadif *yadif = GST_YADIF (trans);
-  int parity;
-  int tff;
+  const GstVideoInfo *info = &yadif->video_info;
+
+  if (GST_BUFFER_DURATION_IS_VALID (cur))
+    return GST_BUFFER_DURATION (cur);
 
-  parity = 0;
-  tff = 0;
+  if (GST_VIDEO_INFO_FPS_N (info) > 0)
+    return gst_util_uint64_scale_int (GST_SECOND, GST_VIDEO_INFO_FPS_D (info),
+        GST_VIDEO_INFO_FPS_N (info));
+
+  if (next != cur && GST_BUFFER_PTS_IS_VALID (cur) &&
+      GST_BUFFER_PTS_IS_VALID (next) &&
+      GST_BUFFER_PTS (next) > GST_BUFFER_PTS (cur))
+    return GST_BUFFER_PTS (next) - GST_BUFFER_PTS (cur);
+
+  return GST_CLOCK_TIME_NONE;
+}
+
+static GstFlowReturn
+gst_yadif_filter_frame (GstYadif * yadif, GstBuffer * prev, GstBuffer * cur,
+    GstBuffer * next, GstBuffer * outbuf, gint parity, gint tff)
+{
+  guint i;
 
   if (!gst_video_frame_map (&yadif->dest_frame, &yadif->video_info, outbuf,
           GST_MAP_WRITE))
     goto dest_map_failed;
 
-  if (!gst_video_frame_map (&yadif->cur_frame, &yadif->video_info, inbuf,
+  if (!gst_video_frame_map (&yadif->cur_frame, &yadif->video_info, cur,
           GST_MAP_READ))
     goto src_map_failed;
 
-  yadif->next_frame = yadif->cur_frame;
-  yadif->prev_frame = yadif->cur_frame;
+  if (!gst_video_frame_map (&yadif->prev_frame, &yadif->video_info, prev,
+          GST_MAP_READ))
+    goto prev_map_failed;
 
-  yadif_filter (yadif, parity, tff);
+  if (!gst_video_frame_map (&yadif->next_frame, &yadif->video_info, next,
+          GST_MAP_READ))
+    goto next_map_failed;
+
+  if (yadif->pool && yadif->n_slices > 1) {
+    yadif->slices_pending = yadif->n_slices - 1;
+    for (i = 1; i < yadif->n_slices; i++) {
+      yadif->slices[i].parity = parity;
+      yadif->slices[i].tff = tff;
+      g_thread_pool_push (yadif->pool, &yadif->slices[i], NULL);
+    }
+
+    /* take a share of the work while waiting */
+    yadif_filter (yadif, parity, tff, 0, yadif->n_slices);
+
+    g_mutex_lock (&yadif->slice_lock);
+    while (yadif->slices_pending > 0)
+      g_cond_wait (&yadif->slice_cond, &yadif->slice_lock);
+    g_mutex_unlock (&yadif->slice_lock);
+  } else {
+    yadif_filter (yadif, parity, tff, 0, 1);
+  }
 
-  gst_video_frame_unmap (&yadif->dest_frame);
+  gst_video_frame_unmap (&yadif->next_frame);
+  gst_video_frame_unmap (&yadif->prev_frame);
   gst_video_frame_unmap (&yadif->cur_frame);
+  gst_video_frame_unmap (&yadif->dest_frame);
   return GST_FLOW_OK;
 
 dest_map_failed:
@@ -326,6 +567,10 @@ dest_map_failed:
     GST_ERROR_OBJECT (yadif, "failed to map dest");
     return GST_FLOW_ERROR;
   }
+next_map_failed:
+  gst_video_frame_unmap (&yadif->prev_frame);
+prev_map_failed:
+  gst_video_frame_unmap (&yadif->cur_frame);
 src_map_failed:
   {
     GST_ERROR_OBJECT (yadif, "failed to map src");
@@ -334,6 +579,205 @@ src_map_failed:
   }
 }
 
+static GstFlowReturn
+gst_yadif_generate_output (GstBaseTransform * trans, GstBuffer ** outbuf)
+{
+  GstYadif *yadif = GST_YADIF (trans);
+  GstBuffer *cur = yadif->cur_buf;
+  GstBuffer *prev, *next;
+  GstFlowReturn ret;
+  gint parity, tff;
+
+  if (gst_base_transform_is_passthrough (trans))
+    return GST_BASE_TRANSFORM_CLASS (gst_yadif_parent_class)->generate_output
+        (trans, outbuf);
+
+  *outbuf = NULL;
+
+  /* the current frame is filtered once the next one is there, or with
+   * itself as the next frame when draining */
+  if (cur == NULL)
+    return GST_FLOW_OK;
+  next = yadif->next_buf;
+  if (next == NULL) {
+    if (!yadif->draining)
+      return GST_FLOW_OK;
+    next = cur;
+  }
+  prev = yadif->prev_buf ? yadif->prev_buf : cur;
+
+  if (gst_yadif_is_interlaced (yadif, cur)) {
+    ret = GST_BASE_TRANSFORM_CLASS (gst_yadif_parent_class)->
+        prepare_output_buffer (trans, cur, outbuf);
+    if (ret != GST_FLOW_OK)
+      return ret;
+
+    /* keep the first field in time for the first output frame, the second
+     * field for the second one */
+    tff = GST_BUFFER_FLAG_IS_SET (cur, GST_VIDEO_BUFFER_FLAG_TFF);
+    parity = tff ^ (yadif->field == 0);
+
+    ret = gst_yadif_filter_frame (yadif, prev, cur, next, *outbuf, parity,
+        tff);
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_replace (outbuf, NULL);
+      return ret;
+    }
+  } else {
+    *outbuf = gst_buffer_copy (cur);
+  }
+
+  GST_BUFFER_FLAG_UNSET (*outbuf, GST_VIDEO_BUFFER_FLAG_INTERLACED);
+  GST_BUFFER_FLAG_UNSET (*outbuf, GST_VIDEO_BUFFER_FLAG_TFF);
+  GST_BUFFER_FLAG_UNSET (*outbuf, GST_VIDEO_BUFFER_FLAG_RFF);
+  GST_BUFFER_FLAG_UNSET (*outbuf, GST_VIDEO_BUFFER_FLAG_ONEFIELD);
+
+  if (yadif->fields == GST_YADIF_FIELDS_ALL) {
+    GstClockTime duration = gst_yadif_get_duration (yadif, cur, next);
+
+    if (GST_CLOCK_TIME_IS_VALID (duration)) {
+      duration /= 2;
+      GST_BUFFER_DURATION (*outbuf) = duration;
+      if (yadif->field == 1 && GST_BUFFER_PTS_IS_VALID (cur))
+        GST_BUFFER_PTS (*outbuf) = GST_BUFFER_PTS (cur) + duration;
+    }
+    GST_BUFFER_DTS (*outbuf) = GST_CLOCK_TIME_NONE;
+    if (yadif->field == 1)
+      GST_BUFFER_FLAG_UNSET (*outbuf, GST_BUFFER_FLAG_DISCONT);
+  }
+
+  if (++yadif->field == (yadif->fields == GST_YADIF_FIELDS_ALL ? 2 : 1)) {
+    yadif->field = 0;
+    if (yadif->prev_buf)
+      gst_buffer_unref (yadif->prev_buf);
+    yadif->prev_buf = yadif->cur_buf;
+    yadif->cur_buf = yadif->next_buf;
+    yadif->next_buf = NULL;
+  }
+
+  return GST_FLOW_OK;
+}
+
+/* push out the frames still waiting for a next frame */
+static GstFlowReturn
+gst_yadif_drain (GstYadif * yadif)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM (yadif);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstBuffer *outbuf;
+
+  if (yadif->cur_buf == NULL)
+    return GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (yadif, "draining");
+
+  yadif->draining = TRUE;
+  do {
+    ret = gst_yadif_generate_output (trans, &outbuf);
+    if (outbuf != NULL)
+      ret = gst_pad_push (GST_BASE_TRANSFORM_SRC_PAD (trans), outbuf);
+  } while (ret == GST_FLOW_OK && outbuf != NULL);
+  yadif->draining = FALSE;
+
+  gst_yadif_reset (yadif);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_yadif_submit_input_buffer (GstBaseTransform * trans, gboolean is_discont,
+    GstBuffer * input)
+{
+  GstYadif *yadif = GST_YADIF (trans);
+  GstFlowReturn ret;
+
+  ret = GST_BASE_TRANSFORM_CLASS (gst_yadif_parent_class)->submit_input_buffer
+      (trans, is_discont, input);
+  if (ret != GST_FLOW_OK || trans->queued_buf == NULL ||
+      gst_base_transform_is_passthrough (trans))
+    return ret;
+
+  /* takes the ref of the queued buffer */
+  input = trans->queued_buf;
+  trans->queued_buf = NULL;
+
+  /* don't interpolate across discontinuities */
+  if (is_discont) {
+    ret = gst_yadif_drain (yadif);
+    if (ret != GST_FLOW_OK) {
+      gst_buffer_unref (input);
+      return ret;
+    }
+  }
+
+  if (yadif->cur_buf == NULL)
+    yadif->cur_buf = input;
+  else
+    yadif->next_buf = input;
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+gst_yadif_sink_event (GstBaseTransform * trans, GstEvent * event)
+{
+  GstYadif *yadif = GST_YADIF (trans);
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_CAPS:
+    case GST_EVENT_SEGMENT:
+    case GST_EVENT_EOS:
+    {
+      GstFlowReturn ret = gst_yadif_drain (yadif);
+
+      if (ret != GST_FLOW_OK)
+        GST_DEBUG_OBJECT (yadif, "draining returned %s",
+            gst_flow_get_name (ret));
+      break;
+    }
+    case GST_EVENT_FLUSH_STOP:
+      gst_yadif_reset (yadif);
+      break;
+    default:
+      break;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (gst_yadif_parent_class)->sink_event (trans,
+      event);
+}
+
+static gboolean
+gst_yadif_query (GstBaseTransform * trans, GstPadDirection direction,
+    GstQuery * query)
+{
+  GstYadif *yadif = GST_YADIF (trans);
+  gboolean ret;
+
+  ret = GST_BASE_TRANSFORM_CLASS (gst_yadif_parent_class)->query (trans,
+      direction, query);
+
+  /* one frame is held back to look ahead */
+  if (ret && direction == GST_PAD_SRC &&
+      GST_QUERY_TYPE (query) == GST_QUERY_LATENCY &&
+      !gst_base_transform_is_passthrough (trans) &&
+      GST_VIDEO_INFO_FPS_N (&yadif->video_info) > 0) {
+    GstClockTime min, max, latency;
+    gboolean live;
+
+    latency = gst_util_uint64_scale_int (GST_SECOND,
+        GST_VIDEO_INFO_FPS_D (&yadif->video_info),
+        GST_VIDEO_INFO_FPS_N (&yadif->video_info));
+
+    gst_query_parse_latency (query, &live, &min, &max);
+    min += latency;
+    if (GST_CLOCK_TIME_IS_VALID (max))
+      max += latency;
+    gst_query_set_latency (query, live, min, max);
+  }
+
+  return ret;
+}
+
 
 static gboolean
 plugin_init (GstPlugin * plugin)
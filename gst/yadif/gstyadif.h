@@ -41,18 +41,44 @@ typedef enum {
   GST_DEINTERLACE_MODE_DISABLED
 } GstDeinterlaceMode;
 
+typedef enum {
+  GST_YADIF_FIELDS_FRAME,
+  GST_YADIF_FIELDS_ALL
+} GstYadifFields;
+
+typedef struct _GstYadifSlice GstYadifSlice;
+
 struct _GstYadif
 {
   GstBaseTransform base_yadif;
 
   GstDeinterlaceMode mode;
+  GstYadifFields fields;
+  guint threads;
 
   GstVideoInfo video_info;
 
+  /* frame history, cur_buf is the frame being output */
+  GstBuffer *prev_buf;
+  GstBuffer *cur_buf;
+  GstBuffer *next_buf;
+  /* field of cur_buf to output next */
+  guint field;
+  gboolean draining;
+
   GstVideoFrame prev_frame;
   GstVideoFrame cur_frame;
   GstVideoFrame next_frame;
   GstVideoFrame dest_frame;
+
+  /* slice threading, slice 0 runs in the streaming thread */
+  GThreadPool *pool;
+  GstYadifSlice *slices;
+  guint n_threads;
+  guint n_slices;
+  GMutex slice_lock;
+  GCond slice_cond;
+  guint slices_pending;
 };
 
 struct _GstYadifClass
@@ -115,17 +115,20 @@ filter_line_c_16bit (guint16 * dst,
 FILTER}
 #endif
 
-void yadif_filter (GstYadif * yadif, int parity, int tff);
+void yadif_filter (GstYadif * yadif, int parity, int tff, int slice,
+    int n_slices);
 #ifdef HAVE_CPU_X86_64
 void filter_line_x86_64 (guint8 * dst,
     guint8 * prev, guint8 * cur, guint8 * next,
     int w, int prefs, int mrefs, int parity, int mode);
 #endif
 
+/* Filters the rows of slice @slice out of @n_slices. Each output row only
+ * depends on the source frames, so slices can be filtered concurrently */
 void
-yadif_filter (GstYadif * yadif, int parity, int tff)
+yadif_filter (GstYadif * yadif, int parity, int tff, int slice, int n_slices)
 {
-  int y, i;
+  int y, y_start, y_end, i;
   const GstVideoInfo *vi = &yadif->video_info;
   const GstVideoFormatInfo *vfi = vi->finfo;
 
@@ -139,13 +142,16 @@ yadif_filter (GstYadif * yadif, int parity, int tff)
     guint8 *next_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->next_frame, i);
     guint8 *dest_data = GST_VIDEO_FRAME_COMP_DATA (&yadif->dest_frame, i);
 
-    for (y = 0; y < h; y++) {
+    y_start = (gint64) h * slice / n_slices;
+    y_end = (gint64) h * (slice + 1) / n_slices;
+
+    for (y = y_start; y < y_end; y++) {
       if ((y ^ parity) & 1) {
         guint8 *prev = prev_data + y * refs;
         guint8 *cur = cur_data + y * refs;
         guint8 *next = next_data + y * refs;
         guint8 *dst = dest_data + y * refs;
-        int mode = ((y == 1) || (y + 2 == h)) ? 2 : yadif->mode;
+        int mode = ((y == 1) || (y + 2 == h)) ? 2 : 0;
 #if HAVE_CPU_X86_64
         if (0) {
           filter_line_c (dst, prev, cur, next, w,
@@ -0,0 +1,313 @@
+/* GStreamer
+ * codecparsers-frame.c: measure allocations and time spent parsing the SEI
+ * and slice headers of an access unit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gsth265parser.h>
+
+#define ITERATIONS 1000000
+/* slice segments per H.265 access unit, few enough to be parsed in the
+ * calling thread */
+#define H265_SLICE_SEGMENTS 3
+
+/* count heap allocations by interposing the allocator; glibc exports the
+ * real implementation under __libc_* names */
+#ifdef __GLIBC__
+#define HAVE_ALLOC_COUNT 1
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static volatile gint n_allocs = 0;
+
+void *
+malloc (size_t size)
+{
+  g_atomic_int_inc (&n_allocs);
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+  g_atomic_int_inc (&n_allocs);
+  return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+  g_atomic_int_inc (&n_allocs);
+  return __libc_realloc (ptr, size);
+}
+#endif
+
+/* 128x64 baseline stream, the slice is an IDR I slice */
+static const guint8 h264_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0xc0, 0x1e, 0xda, 0x08, 0x26, 0x40,
+};
+
+static const guint8 h264_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x3c, 0x80,
+};
+
+static const guint8 h264_slice[] = {
+  0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0xa8, 0xaa, 0xaa, 0xaa, 0xaa,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+  0xaa, 0xaa, 0xaa, 0xaa,
+};
+
+/* 128x64 main profile stream with WPP, the slice segment has an entry point
+ * for each of its 4 CTB rows */
+static const guint8 h265_vps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60,
+  0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x5a, 0xf0, 0x24,
+};
+
+static const guint8 h265_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03,
+  0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x5a, 0xa0, 0x10,
+  0x20, 0x41, 0x65, 0xfa, 0xbc, 0x20, 0x80,
+};
+
+static const guint8 h265_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0x50, 0x1c, 0x60, 0x84, 0x80,
+};
+
+static const guint8 h265_slice[] = {
+  0x00, 0x00, 0x00, 0x01, 0x26, 0x01, 0x93, 0x90, 0x40, 0x18, 0x28, 0x24,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+};
+
+/* two user data unregistered messages, as muxers and encoders commonly
+ * put in every access unit */
+static guint
+make_sei_nal (guint8 * data, const guint8 * nal_header, guint header_size)
+{
+  static const guint8 payload_sizes[] = { 20, 4 };
+  guint i, j, size = 0;
+
+  data[size++] = 0x00;
+  data[size++] = 0x00;
+  data[size++] = 0x00;
+  data[size++] = 0x01;
+  for (i = 0; i < header_size; i++)
+    data[size++] = nal_header[i];
+
+  for (i = 0; i < G_N_ELEMENTS (payload_sizes); i++) {
+    data[size++] = 5;
+    data[size++] = payload_sizes[i];
+    for (j = 0; j < payload_sizes[i]; j++)
+      data[size++] = 0x10 + j;
+  }
+
+  /* rbsp trailing bits */
+  data[size++] = 0x80;
+
+  return size;
+}
+
+static void
+report (const gchar * name, GstClockTime elapsed, gint allocs)
+{
+  gdouble ns = (gdouble) elapsed / ITERATIONS;
+
+#ifdef HAVE_ALLOC_COUNT
+  g_print ("%-24s %8.1f ns/frame, %6.2f allocations/frame\n", name, ns,
+      (gdouble) allocs / ITERATIONS);
+#else
+  g_print ("%-24s %8.1f ns/frame\n", name, ns);
+#endif
+}
+
+static gint
+get_allocs (void)
+{
+#ifdef HAVE_ALLOC_COUNT
+  return g_atomic_int_get (&n_allocs);
+#else
+  return 0;
+#endif
+}
+
+static void
+parse_h264_nal (GstH264NalParser * parser, const guint8 * data, gsize size)
+{
+  GstH264NalUnit nalu;
+
+  if (gst_h264_parser_identify_nalu_unchecked (parser, data, 0, size,
+          &nalu) != GST_H264_PARSER_OK)
+    g_error ("failed to identify H.264 NAL");
+  nalu.size = size - nalu.offset;
+  if (gst_h264_parser_parse_nal (parser, &nalu) != GST_H264_PARSER_OK)
+    g_error ("failed to parse H.264 NAL");
+}
+
+/* a frame is an SEI and an IDR slice, whose header is parsed as h264parse
+ * does */
+static void
+bench_h264 (void)
+{
+  static const guint8 header[] = { 0x06 };
+  GstH264NalParser *parser = gst_h264_nal_parser_new ();
+  GstH264NalUnit sei_nalu, slice_nalu;
+  GstH264SliceHdr slice;
+  GstClockTime start, end;
+  GArray *messages;
+  guint8 data[64];
+  guint size;
+  gint i, allocs;
+
+  parse_h264_nal (parser, h264_sps, sizeof (h264_sps));
+  parse_h264_nal (parser, h264_pps, sizeof (h264_pps));
+
+  size = make_sei_nal (data, header, sizeof (header));
+  if (gst_h264_parser_identify_nalu_unchecked (parser, data, 0, size,
+          &sei_nalu) != GST_H264_PARSER_OK)
+    g_error ("failed to identify H.264 SEI");
+  if (gst_h264_parser_identify_nalu_unchecked (parser, h264_slice, 0,
+          sizeof (h264_slice), &slice_nalu) != GST_H264_PARSER_OK)
+    g_error ("failed to identify H.264 slice");
+  slice_nalu.size = sizeof (h264_slice) - slice_nalu.offset;
+
+  allocs = get_allocs ();
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++) {
+    gst_h264_parser_parse_sei (parser, &sei_nalu, &messages);
+    g_array_free (messages, TRUE);
+    gst_h264_parser_parse_slice_hdr (parser, &slice_nalu, &slice, FALSE,
+        FALSE);
+  }
+  end = gst_util_get_timestamp ();
+  report ("h264 allocating", end - start, get_allocs () - allocs);
+
+  messages = g_array_sized_new (FALSE, FALSE, sizeof (GstH264SEIMessage), 4);
+  allocs = get_allocs ();
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++) {
+    gst_h264_parser_parse_sei_into (parser, &sei_nalu, messages);
+    gst_h264_parser_parse_slice_hdr (parser, &slice_nalu, &slice, FALSE,
+        FALSE);
+  }
+  end = gst_util_get_timestamp ();
+  report ("h264 reusing storage", end - start, get_allocs () - allocs);
+  g_array_free (messages, TRUE);
+
+  gst_h264_nal_parser_free (parser);
+}
+
+static void
+parse_h265_nal (GstH265Parser * parser, const guint8 * data, gsize size)
+{
+  GstH265NalUnit nalu;
+
+  if (gst_h265_parser_identify_nalu_unchecked (parser, data, 0, size,
+          &nalu) != GST_H265_PARSER_OK)
+    g_error ("failed to identify H.265 NAL");
+  nalu.size = size - nalu.offset;
+  if (gst_h265_parser_parse_nal (parser, &nalu) != GST_H265_PARSER_OK)
+    g_error ("failed to parse H.265 NAL");
+}
+
+/* a frame is an SEI and slice segments with entry points, whose substreams
+ * are located as h265parse does for the slice meta */
+static void
+bench_h265 (void)
+{
+  static const guint8 header[] = { GST_H265_NAL_PREFIX_SEI << 1, 0x01 };
+  GstH265Parser *parser = gst_h265_parser_new ();
+  GstH265SliceSegment segments[H265_SLICE_SEGMENTS];
+  GstH265NalUnit sei_nalu, slice_nalu;
+  GstClockTime start, end;
+  GArray *messages;
+  guint8 data[64];
+  guint size;
+  gint i, j, allocs;
+
+  parse_h265_nal (parser, h265_vps, sizeof (h265_vps));
+  parse_h265_nal (parser, h265_sps, sizeof (h265_sps));
+  parse_h265_nal (parser, h265_pps, sizeof (h265_pps));
+
+  size = make_sei_nal (data, header, sizeof (header));
+  if (gst_h265_parser_identify_nalu_unchecked (parser, data, 0, size,
+          &sei_nalu) != GST_H265_PARSER_OK)
+    g_error ("failed to identify H.265 SEI");
+  if (gst_h265_parser_identify_nalu_unchecked (parser, h265_slice, 0,
+          sizeof (h265_slice), &slice_nalu) != GST_H265_PARSER_OK)
+    g_error ("failed to identify H.265 slice");
+  slice_nalu.size = sizeof (h265_slice) - slice_nalu.offset;
+
+  allocs = get_allocs ();
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++) {
+    gst_h265_parser_parse_sei (parser, &sei_nalu, &messages);
+    g_array_free (messages, TRUE);
+
+    memset (segments, 0, sizeof (segments));
+    for (j = 0; j < H265_SLICE_SEGMENTS; j++)
+      segments[j].nalu = slice_nalu;
+    gst_h265_parser_parse_slice_segments (parser, segments,
+        H265_SLICE_SEGMENTS, NULL);
+    for (j = 0; j < H265_SLICE_SEGMENTS; j++)
+      gst_h265_slice_segment_clear (&segments[j]);
+  }
+  end = gst_util_get_timestamp ();
+  report ("h265 allocating", end - start, get_allocs () - allocs);
+
+  /* the SEI messages and the segments are kept from one frame to the next */
+  messages = g_array_sized_new (FALSE, FALSE, sizeof (GstH265SEIMessage), 4);
+  g_array_set_clear_func (messages, (GDestroyNotify) gst_h265_sei_free);
+  memset (segments, 0, sizeof (segments));
+  allocs = get_allocs ();
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++) {
+    gst_h265_parser_parse_sei_into (parser, &sei_nalu, messages);
+
+    for (j = 0; j < H265_SLICE_SEGMENTS; j++)
+      segments[j].nalu = slice_nalu;
+    gst_h265_parser_parse_slice_segments (parser, segments,
+        H265_SLICE_SEGMENTS, NULL);
+  }
+  end = gst_util_get_timestamp ();
+  report ("h265 reusing storage", end - start, get_allocs () - allocs);
+  for (j = 0; j < H265_SLICE_SEGMENTS; j++)
+    gst_h265_slice_segment_clear (&segments[j]);
+  g_array_free (messages, TRUE);
+
+  gst_h265_parser_free (parser);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  gst_init (&argc, &argv);
+
+  g_print ("parsing %d frames, each with an SEI of 2 messages\n", ITERATIONS);
+
+  bench_h264 ();
+  bench_h265 ();
+
+  return 0;
+}
@@ -0,0 +1,151 @@
+/* GStreamer
+ * codecparsers-startcode.c: measure start code scanning throughput
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+#include <gst/codecparsers/gsth264parser.h>
+#include <gst/codecparsers/gstmpegvideoparser.h>
+
+#define BUFFER_SIZE (32 * 1024 * 1024)
+#define DEFAULT_NAL_SIZE (256 * 1024)
+#define ITERATIONS 20
+
+/* Fills @data with start code delimited units of @nal_size bytes. The
+ * payload is random but, as in a real bitstream, never contains a start
+ * code prefix, and has the occasional zero byte to keep the scanner
+ * honest. */
+static void
+fill_buffer (guint8 * data, gsize size, gsize nal_size, guint8 nal_header)
+{
+  GRand *rand = g_rand_new_with_seed (0x5c);
+  gsize i = 0;
+
+  while (i < size) {
+    gsize end = MIN (i + nal_size, size);
+
+    if (i + 5 <= end) {
+      data[i++] = 0x00;
+      data[i++] = 0x00;
+      data[i++] = 0x00;
+      data[i++] = 0x01;
+      data[i++] = nal_header;
+    }
+
+    for (; i < end; i++) {
+      guint8 byte = g_rand_int (rand) & 0xff;
+
+      /* emulation prevention */
+      if (byte <= 0x03 && i >= 2 && data[i - 1] == 0 && data[i - 2] == 0)
+        byte = 0x03;
+
+      data[i] = byte;
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+static void
+report (const gchar * name, GstClockTime elapsed, guint n_units)
+{
+  gdouble mbytes = (gdouble) BUFFER_SIZE * ITERATIONS / (1024 * 1024);
+  gdouble secs = (gdouble) elapsed / GST_SECOND;
+
+  g_print ("%-24s %8.1f MB/s, %u units, %" GST_TIME_FORMAT "\n", name,
+      mbytes / secs, n_units, GST_TIME_ARGS (elapsed));
+}
+
+static void
+bench_h264 (const guint8 * data, gsize size)
+{
+  GstH264NalParser *parser = gst_h264_nal_parser_new ();
+  GstH264NalUnit nalu;
+  GstClockTime start, end;
+  guint n_units = 0;
+  gint i;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++) {
+    guint offset = 0;
+
+    while (gst_h264_parser_identify_nalu (parser, data, offset, size,
+            &nalu) == GST_H264_PARSER_OK) {
+      offset = nalu.offset + nalu.size;
+      n_units++;
+    }
+  }
+  end = gst_util_get_timestamp ();
+
+  report ("h264 identify_nalu", end - start, n_units / ITERATIONS);
+
+  gst_h264_nal_parser_free (parser);
+}
+
+static void
+bench_mpeg_video (const guint8 * data, gsize size)
+{
+  GstMpegVideoPacket packet;
+  GstClockTime start, end;
+  guint n_units = 0;
+  gint i;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < ITERATIONS; i++) {
+    guint offset = 0;
+
+    while (gst_mpeg_video_parse (&packet, data, size, offset)) {
+      n_units++;
+      if (packet.size < 0)
+        break;
+      offset = packet.offset + packet.size;
+    }
+  }
+  end = gst_util_get_timestamp ();
+
+  report ("mpegvideo parse", end - start, n_units / ITERATIONS);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  gint nal_size = DEFAULT_NAL_SIZE;
+  guint8 *data;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    nal_size = MAX (atoi (argv[1]), 16);
+
+  g_print ("scanning %d MB buffers with %d byte units\n",
+      BUFFER_SIZE / (1024 * 1024), nal_size);
+
+  data = g_malloc (BUFFER_SIZE);
+
+  /* IDR slices */
+  fill_buffer (data, BUFFER_SIZE, nal_size, 0x65);
+  bench_h264 (data, BUFFER_SIZE);
+
+  /* slice 1 */
+  fill_buffer (data, BUFFER_SIZE, nal_size, 0x01);
+  bench_mpeg_video (data, BUFFER_SIZE);
+
+  g_free (data);
+
+  return 0;
+}
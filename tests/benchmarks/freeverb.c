@@ -0,0 +1,86 @@
+/* GStreamer
+ * freeverb.c: measure how many channels freeverb can process in realtime
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/gst.h>
+
+#include "benchutils.h"
+
+#define DEFAULT_SECONDS 60
+#define RATE 48000
+/* 20 ms buffers, as typically handled by a voice mixer */
+#define SAMPLES_PER_BUFFER (RATE / 50)
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define FORMAT_NE(f) f "LE"
+#else
+#define FORMAT_NE(f) f "BE"
+#endif
+
+static void
+bench (gint seconds, const gchar * format, gint width, gint channels)
+{
+  GstElement *pipeline;
+  GstClockTime start, end;
+  gdouble elapsed;
+  gint buffers = seconds * RATE / SAMPLES_PER_BUFFER;
+  gint size = SAMPLES_PER_BUFFER * channels * width / 8;
+  gchar *desc;
+
+  /* zeroed input keeps the source cheap, the reverb does the same work
+   * whatever the samples are as long as the buffers are not gaps */
+  desc = g_strdup_printf ("fakesrc num-buffers=%d sizetype=fixed "
+      "sizemax=%d filltype=zero format=time ! "
+      "audio/x-raw,format=%s,rate=%d,channels=%d,layout=interleaved ! "
+      "freeverb ! fakesink sync=false", buffers, size, format, RATE, channels);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (!pipeline)
+    g_error ("failed to create pipeline");
+
+  start = gst_util_get_timestamp ();
+  if (!bench_run_pipeline (pipeline))
+    g_error ("pipeline failed");
+  end = gst_util_get_timestamp ();
+  gst_object_unref (pipeline);
+
+  elapsed = (gdouble) (end - start) / GST_SECOND;
+  g_print ("%-5s %d->2 channels %8.3f us/buffer, %8.1fx realtime\n", format,
+      channels, elapsed * 1e6 / buffers, seconds / elapsed);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  gint seconds = DEFAULT_SECONDS;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    seconds = g_ascii_strtoll (argv[1], NULL, 10);
+
+  g_print ("reverberating %d s of %d Hz audio in %d sample buffers\n",
+      seconds, RATE, SAMPLES_PER_BUFFER);
+
+  bench (seconds, FORMAT_NE ("S16"), 16, 1);
+  bench (seconds, FORMAT_NE ("S16"), 16, 2);
+  bench (seconds, FORMAT_NE ("F32"), 32, 1);
+  bench (seconds, FORMAT_NE ("F32"), 32, 2);
+
+  return 0;
+}
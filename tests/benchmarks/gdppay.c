@@ -0,0 +1,79 @@
+/* GStreamer
+ * gdppay.c: measure the throughput of gdppay on raw 1080p video frames
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/gst.h>
+
+#include "benchutils.h"
+
+#define DEFAULT_FRAMES 1000
+/* one I420 1920x1080 frame */
+#define FRAME_SIZE (1920 * 1080 * 3 / 2)
+
+static void
+bench (gint frames, gboolean crc_header, gboolean crc_payload,
+    guint batch_size)
+{
+  GstElement *pipeline;
+  GstClockTime start, end;
+  gdouble seconds;
+  gchar *desc;
+
+  desc = g_strdup_printf ("fakesrc num-buffers=%d sizetype=fixed "
+      "sizemax=%d filltype=nothing ! "
+      "video/x-raw,format=I420,width=1920,height=1080,framerate=30/1 ! "
+      "gdppay crc-header=%d crc-payload=%d batch-size=%u ! "
+      "fakesink sync=false", frames, FRAME_SIZE, crc_header, crc_payload,
+      batch_size);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (!pipeline)
+    g_error ("failed to create pipeline");
+
+  start = gst_util_get_timestamp ();
+  if (!bench_run_pipeline (pipeline))
+    g_error ("pipeline failed");
+  end = gst_util_get_timestamp ();
+  gst_object_unref (pipeline);
+
+  seconds = (gdouble) (end - start) / GST_SECOND;
+  g_print ("crc-header=%d crc-payload=%d batch-size=%-3u %8.3f ms/frame, "
+      "%8.1f MB/s\n", crc_header, crc_payload, batch_size,
+      seconds * 1000 / frames, (gdouble) frames * FRAME_SIZE / seconds / 1e6);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  gint frames = DEFAULT_FRAMES;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    frames = g_ascii_strtoll (argv[1], NULL, 10);
+
+  g_print ("payloading %d 1080p I420 frames\n", frames);
+
+  bench (frames, FALSE, FALSE, 1);
+  bench (frames, TRUE, FALSE, 1);
+  bench (frames, TRUE, TRUE, 1);
+  bench (frames, FALSE, FALSE, 16);
+  bench (frames, TRUE, TRUE, 16);
+
+  return 0;
+}
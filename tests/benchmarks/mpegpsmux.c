@@ -0,0 +1,83 @@
+/* GStreamer
+ * mpegpsmux.c: measure the muxing throughput of mpegpsmux for 50 Mbit/s
+ *              MPEG-2 video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/gst.h>
+
+#include "benchutils.h"
+
+#define DEFAULT_FRAMES 5000
+/* 50 Mbit/s at 25 frames per second */
+#define BYTE_RATE (50000000 / 8)
+#define FRAME_SIZE (BYTE_RATE / 25)
+
+/* The content of the frames does not matter to the muxer, fakesrc provides
+ * timestamped buffers of the right size */
+static void
+bench (gint frames, guint packs_per_buffer, gboolean aggregate_gops)
+{
+  GstElement *pipeline;
+  GstClockTime start, end;
+  gdouble seconds;
+  gchar *desc;
+
+  desc = g_strdup_printf ("fakesrc num-buffers=%d sizetype=fixed "
+      "sizemax=%d filltype=nothing datarate=%d format=time ! "
+      "video/mpeg,mpegversion=2,systemstream=false,width=1920,height=1080,"
+      "framerate=25/1 ! mpegpsmux packs-per-buffer=%u aggregate-gops=%d ! "
+      "fakesink sync=false", frames, FRAME_SIZE, BYTE_RATE, packs_per_buffer,
+      aggregate_gops);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (!pipeline)
+    g_error ("failed to create pipeline");
+
+  start = gst_util_get_timestamp ();
+  if (!bench_run_pipeline (pipeline))
+    g_error ("pipeline failed");
+  end = gst_util_get_timestamp ();
+  gst_object_unref (pipeline);
+
+  seconds = (gdouble) (end - start) / GST_SECOND;
+  g_print ("packs-per-buffer=%-4u aggregate-gops=%d %8.3f ms/frame, "
+      "%8.1f MB/s, %6.1fx realtime\n", packs_per_buffer, aggregate_gops,
+      seconds * 1000 / frames, (gdouble) frames * FRAME_SIZE / seconds / 1e6,
+      frames / 25.0 / seconds);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  gint frames = DEFAULT_FRAMES;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    frames = g_ascii_strtoll (argv[1], NULL, 10);
+
+  g_print ("muxing %d frames of 50 Mbit/s MPEG-2 video\n", frames);
+
+  bench (frames, 0, FALSE);
+  bench (frames, 1, FALSE);
+  bench (frames, 8, FALSE);
+  bench (frames, 0, TRUE);
+  bench (frames, 8, TRUE);
+
+  return 0;
+}
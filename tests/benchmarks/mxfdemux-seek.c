@@ -0,0 +1,147 @@
+/* GStreamer
+ * mxfdemux-seek.c: measure the time mxfdemux needs for frame accurate seeks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/gst.h>
+#include <glib/gstdio.h>
+
+#include "benchutils.h"
+
+#define DEFAULT_FRAMES 200000
+#define SEEKS 200
+
+/* Tiny uncompressed frames, so that the file has many edit units without
+ * being large */
+static gboolean
+write_file (const gchar * location, gint frames)
+{
+  GstElement *pipeline;
+  gchar *desc;
+  gboolean ret;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=%d pattern=black ! "
+      "video/x-raw,format=UYVY,width=8,height=8,framerate=25/1 ! "
+      "mxfmux ! filesink location=\"%s\"", frames, location);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (!pipeline)
+    return FALSE;
+
+  ret = bench_run_pipeline (pipeline);
+  gst_object_unref (pipeline);
+
+  return ret;
+}
+
+static void
+pad_added_cb (GstElement * demux, GstPad * pad, GstElement * sink)
+{
+  GstPad *sinkpad = gst_element_get_static_pad (sink, "sink");
+
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+}
+
+static GstClockTime
+seek (GstElement * pipeline, GstClockTime position)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstClockTime start, end;
+  GstMessage *msg;
+
+  start = gst_util_get_timestamp ();
+  if (!gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, position))
+    g_error ("seek to %" GST_TIME_FORMAT " failed", GST_TIME_ARGS (position));
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+  end = gst_util_get_timestamp ();
+
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR)
+    g_error ("error while seeking");
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  return end - start;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstElement *pipeline, *src, *demux, *sink;
+  GstClockTime duration, elapsed, first, max = 0, total = 0;
+  GRand *rand;
+  gchar *location;
+  gint frames = DEFAULT_FRAMES;
+  gint fd, i;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    frames = g_ascii_strtoll (argv[1], NULL, 10);
+  duration = gst_util_uint64_scale_int (frames, GST_SECOND, 25);
+
+  fd = g_file_open_tmp ("mxfdemux-seek-XXXXXX.mxf", &location, NULL);
+  if (fd == -1)
+    g_error ("failed to create temporary file");
+  g_close (fd, NULL);
+
+  g_print ("writing %d frames to %s\n", frames, location);
+  if (!write_file (location, frames))
+    g_error ("failed to write MXF file");
+
+  pipeline = gst_pipeline_new (NULL);
+  src = gst_element_factory_make ("filesrc", NULL);
+  demux = gst_element_factory_make ("mxfdemux", NULL);
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (src, "location", location, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add_many (GST_BIN (pipeline), src, demux, sink, NULL);
+  gst_element_link (src, demux);
+  g_signal_connect (demux, "pad-added", G_CALLBACK (pad_added_cb), sink);
+
+  if (gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE
+      || gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) != GST_STATE_CHANGE_SUCCESS)
+    g_error ("failed to preroll");
+
+  /* the first seek loads the index */
+  first = seek (pipeline, duration / 2);
+
+  rand = g_rand_new_with_seed (0);
+  for (i = 0; i < SEEKS; i++) {
+    elapsed = seek (pipeline, gst_util_uint64_scale_int (g_rand_int_range (rand,
+                0, frames), GST_SECOND, 25));
+    total += elapsed;
+    max = MAX (max, elapsed);
+  }
+  g_rand_free (rand);
+
+  g_print ("first seek: %8.3f ms\n", (gdouble) first / GST_MSECOND);
+  g_print ("%d accurate seeks: %8.3f ms average, %8.3f ms max\n", SEEKS,
+      (gdouble) total / SEEKS / GST_MSECOND, (gdouble) max / GST_MSECOND);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  g_unlink (location);
+  g_free (location);
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+/* GStreamer
+ * scenechange.c: measure the cost of scene change detection on 2160p video
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/gst.h>
+
+#include "benchutils.h"
+
+#define DEFAULT_FRAMES 300
+
+static gdouble
+time_pipeline (gint frames, const gchar * filter)
+{
+  GstElement *pipeline;
+  GstClockTime start, end;
+  gchar *desc;
+
+  /* generating the frames is expensive as well, compare against a pipeline
+   * with identity in place of the filter */
+  desc = g_strdup_printf ("videotestsrc num-buffers=%d pattern=snow ! "
+      "video/x-raw,format=I420,width=3840,height=2160,framerate=25/1 ! "
+      "%s ! fakesink sync=false", frames, filter);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  if (!pipeline)
+    g_error ("failed to create pipeline");
+
+  start = gst_util_get_timestamp ();
+  if (!bench_run_pipeline (pipeline))
+    g_error ("pipeline failed");
+  end = gst_util_get_timestamp ();
+  gst_object_unref (pipeline);
+
+  return (gdouble) (end - start) / GST_MSECOND / frames;
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  static const gchar *filters[] = {
+    "scenechange method=sad line-step=1",
+    "scenechange method=sad line-step=4",
+    "scenechange method=histogram line-step=1",
+    "scenechange method=histogram line-step=4",
+  };
+  gint frames = DEFAULT_FRAMES;
+  gdouble base;
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 1)
+    frames = g_ascii_strtoll (argv[1], NULL, 10);
+
+  g_print ("scoring %d 2160p I420 frames\n", frames);
+
+  base = time_pipeline (frames, "identity");
+  g_print ("%-42s %8.3f ms/frame\n", "identity", base);
+
+  for (i = 0; i < G_N_ELEMENTS (filters); i++) {
+    gdouble ms = time_pipeline (frames, filters[i]);
+
+    g_print ("%-42s %8.3f ms/frame (%+.3f over identity)\n", filters[i], ms,
+        ms - base);
+  }
+
+  return 0;
+}
@@ -0,0 +1,108 @@
+/* GStreamer
+ *
+ * unit test for the audiovisualizers drawing helpers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+#include "../../gst/audiovisualizers/gstdrawhelpers.h"
+
+#define MAX_SPAN 67
+/* room for starting the span at any of 4 pixels, i.e. at all 16 byte
+ * alignments of the vector loads, and a pixel after it */
+#define BUF_PIXELS (4 + MAX_SPAN + 1)
+
+/* Random colours, with channels near both ends of the range so that many
+ * of them saturate */
+static guint32
+random_colour (GRand * rand)
+{
+  static const guint8 bases[] = { 0, 1, 100, 128, 200, 254, 255 };
+  guint32 colour = 0;
+  gint k;
+
+  for (k = 0; k < 4; k++) {
+    gint base = bases[g_rand_int_range (rand, 0, G_N_ELEMENTS (bases))];
+    gint v = CLAMP (base + g_rand_int_range (rand, -3, 4), 0, 255);
+
+    colour |= (guint32) v << (8 * k);
+  }
+
+  return colour;
+}
+
+/* the vectorized loop and the per-pixel tail add up the same for every
+ * span length, and nothing around the span is touched */
+GST_START_TEST (test_add_span)
+{
+  guint32 dest[BUF_PIXELS], orig[BUF_PIXELS], colours[BUF_PIXELS];
+  guint n, offset, i, round;
+  GRand *rand;
+
+  rand = g_rand_new_with_seed (5);
+
+  for (round = 0; round < 20; round++) {
+    for (i = 0; i < BUF_PIXELS; i++) {
+      orig[i] = random_colour (rand);
+      colours[i] = random_colour (rand);
+    }
+
+    for (offset = 0; offset < 4; offset++) {
+      for (n = 0; n <= MAX_SPAN; n++) {
+        memcpy (dest, orig, sizeof (dest));
+        add_span (dest + offset, colours, n);
+
+        for (i = 0; i < BUF_PIXELS; i++) {
+          const guint8 *d = (const guint8 *) &dest[i];
+          const guint8 *o = (const guint8 *) &orig[i];
+          gint k;
+
+          if (i < offset || i >= offset + n) {
+            fail_unless_equals_uint64 (dest[i], orig[i]);
+            continue;
+          }
+
+          for (k = 0; k < 4; k++) {
+            const guint8 *c = (const guint8 *) &colours[i - offset];
+
+            fail_unless_equals_int (d[k], MIN (o[k] + c[k], 255));
+          }
+        }
+      }
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+static Suite *
+audiovisualizers_suite (void)
+{
+  Suite *s = suite_create ("audiovisualizers");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_add_span);
+
+  return s;
+}
+
+GST_CHECK_MAIN (audiovisualizers);
@@ -0,0 +1,379 @@
+/* GStreamer
+ *
+ * unit test for bayer2rgb
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstharness.h>
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WIDTH 32
+#define HEIGHT 16
+
+/* the ramp of the 8 bit samples of line y, which makes every bilinear
+ * average exact */
+#define RAMP(y) (8 * (y))
+
+static gint
+format_depth (const gchar * format)
+{
+  return strlen (format) == 4 ? 8 : atoi (format + 4);
+}
+
+/* Converts a frame of @samples, given as values of the depth of @format,
+ * and returns the output buffer and its video info */
+static GstBuffer *
+convert (const gchar * props, const gchar * format, gint width, gint height,
+    const guint16 * samples, const gchar * out_format, GstVideoInfo * info)
+{
+  gint depth = format_depth (format);
+  gboolean big_endian = g_str_has_suffix (format, "be");
+  gint stride = GST_ROUND_UP_4 (depth > 8 ? width * 2 : width);
+  GstHarness *h;
+  GstBuffer *buf;
+  GstMapInfo map;
+  GstCaps *caps;
+  gchar *desc;
+  gint x, y;
+
+  desc = g_strdup_printf ("bayer2rgb %s", props);
+  h = gst_harness_new_parse (desc);
+  g_free (desc);
+
+  caps = gst_caps_new_simple ("video/x-bayer", "format", G_TYPE_STRING, format,
+      "width", G_TYPE_INT, width, "height", G_TYPE_INT, height,
+      "framerate", GST_TYPE_FRACTION, 25, 1, NULL);
+  gst_harness_set_src_caps (h, caps);
+  caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING,
+      out_format, NULL);
+  gst_harness_set_sink_caps (h, caps);
+
+  buf = gst_buffer_new_allocate (NULL, stride * height, NULL);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  for (y = 0; y < height; y++) {
+    guint8 *line = map.data + y * stride;
+
+    for (x = 0; x < width; x++) {
+      guint16 v = samples[y * width + x];
+
+      if (depth == 8)
+        line[x] = v;
+      else if (big_endian)
+        GST_WRITE_UINT16_BE (line + 2 * x, v);
+      else
+        GST_WRITE_UINT16_LE (line + 2 * x, v);
+    }
+  }
+  gst_buffer_unmap (buf, &map);
+
+  buf = gst_harness_push_and_pull (h, buf);
+  fail_unless (buf != NULL);
+
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  fail_unless (gst_video_info_from_caps (info, caps));
+  fail_unless_equals_string (GST_VIDEO_INFO_NAME (info), out_format);
+  gst_caps_unref (caps);
+
+  gst_harness_teardown (h);
+
+  return buf;
+}
+
+/* Returns a frame of the bayer ramp, at @depth */
+static guint16 *
+create_ramp (gint depth)
+{
+  guint16 *samples = g_new (guint16, WIDTH * HEIGHT);
+  gint x, y;
+
+  for (y = 0; y < HEIGHT; y++)
+    for (x = 0; x < WIDTH; x++)
+      samples[y * WIDTH + x] = RAMP (y) << (depth - 8);
+
+  return samples;
+}
+
+/* The expected bilinear interpolation of the BGGR ramp at (x, y), as 8 bit
+ * R, G and B. The lines above the first and below the last are mirrored, so
+ * the first and last line differ from a plain grey ramp. */
+static void
+bilinear_ramp (gint x, gint y, gint rgb[3])
+{
+  gint up = RAMP (y > 0 ? y - 1 : 1);
+  gint down = RAMP (y < HEIGHT - 1 ? y + 1 : HEIGHT - 2);
+  gint c = RAMP (y);
+  gint v = (up + down) / 2;
+  gint cross = (2 * c + up + down) / 4;
+
+  if (!(y & 1) && !(x & 1)) {
+    /* B */
+    rgb[0] = v;
+    rgb[1] = cross;
+    rgb[2] = c;
+  } else if (!(y & 1)) {
+    /* G between B */
+    rgb[0] = v;
+    rgb[1] = c;
+    rgb[2] = c;
+  } else if (!(x & 1)) {
+    /* G between R */
+    rgb[0] = c;
+    rgb[1] = c;
+    rgb[2] = v;
+  } else {
+    /* R */
+    rgb[0] = c;
+    rgb[1] = cross;
+    rgb[2] = v;
+  }
+}
+
+/* Checks @buf of @info against @expected, called with the 8 bit RGB of each
+ * pixel */
+static void
+check_rgb (GstBuffer * buf, GstVideoInfo * info, gint depth,
+    void (*expected) (gint x, gint y, gint rgb[3]))
+{
+  GstVideoFrame frame;
+  gint x, y, c;
+
+  fail_unless (gst_video_frame_map (&frame, info, buf, GST_MAP_READ));
+
+  for (y = 0; y < HEIGHT; y++) {
+    for (x = 0; x < WIDTH; x++) {
+      gint rgb[3];
+
+      expected (x, y, rgb);
+      for (c = 0; c < 3; c++) {
+        const guint8 *p = GST_VIDEO_FRAME_COMP_DATA (&frame, c) +
+            y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, c) +
+            x * GST_VIDEO_FRAME_COMP_PSTRIDE (&frame, c);
+
+        if (GST_VIDEO_FRAME_FORMAT (&frame) == GST_VIDEO_FORMAT_ARGB64) {
+          /* the deep value with its top bits replicated below */
+          guint v = rgb[c] << (depth - 8);
+
+          v = (v << (16 - depth)) | (v >> (2 * depth - 16));
+          fail_unless_equals_int (*(const guint16 *) p, v);
+        } else {
+          fail_unless_equals_int (*p, rgb[c]);
+        }
+      }
+    }
+  }
+
+  gst_video_frame_unmap (&frame);
+}
+
+GST_START_TEST (test_bilinear)
+{
+  const gchar *formats[] = {
+    "bggr", "bggr10le", "bggr10be", "bggr12le", "bggr12be", "bggr16le",
+    "bggr16be"
+  };
+  const gchar *out_formats[] = { "RGBx", "BGRA", "ARGB64" };
+  guint i, j;
+
+  /* 8 bit to 32 bit RGB goes through the ORC kernels, everything else
+   * through the generic path */
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    for (j = 0; j < G_N_ELEMENTS (out_formats); j++) {
+      gint depth = format_depth (formats[i]);
+      guint16 *samples = create_ramp (depth);
+      GstVideoInfo info;
+      GstBuffer *buf;
+
+      GST_INFO ("%s to %s", formats[i], out_formats[j]);
+
+      buf = convert ("method=bilinear threads=1", formats[i], WIDTH, HEIGHT,
+          samples, out_formats[j], &info);
+      check_rgb (buf, &info, depth, bilinear_ramp);
+
+      gst_buffer_unref (buf);
+      g_free (samples);
+    }
+  }
+}
+
+GST_END_TEST;
+
+static void
+grey_ramp (gint x, gint y, gint rgb[3])
+{
+  rgb[0] = rgb[1] = rgb[2] = RAMP (y);
+}
+
+GST_START_TEST (test_edge_aware)
+{
+  const gchar *formats[] = { "bggr", "bggr12le", "bggr16be" };
+  guint i;
+
+  /* green follows the lines, where the colour differences are all zero, so
+   * the whole ramp comes out grey, mirrored first and last line included */
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    gint depth = format_depth (formats[i]);
+    guint16 *samples = create_ramp (depth);
+    GstVideoInfo info;
+    GstBuffer *buf;
+
+    buf = convert ("method=edge-aware threads=1", formats[i], WIDTH, HEIGHT,
+        samples, "RGBx", &info);
+    check_rgb (buf, &info, depth, grey_ramp);
+    gst_buffer_unref (buf);
+
+    buf = convert ("method=edge-aware threads=1", formats[i], WIDTH, HEIGHT,
+        samples, "ARGB64", &info);
+    check_rgb (buf, &info, depth, grey_ramp);
+    gst_buffer_unref (buf);
+
+    g_free (samples);
+  }
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_yuv)
+{
+  const gchar *out_formats[] = { "I420", "NV12" };
+  const gchar *methods[] = { "bilinear", "edge-aware" };
+  guint16 *samples = g_new (guint16, WIDTH * (HEIGHT + 1));
+  guint i, j;
+
+  /* mid grey, odd heights leave a last line of luma without a pair */
+  for (i = 0; i < WIDTH * (HEIGHT + 1); i++)
+    samples[i] = 128 << 4;
+
+  for (i = 0; i < G_N_ELEMENTS (out_formats); i++) {
+    for (j = 0; j < G_N_ELEMENTS (methods); j++) {
+      gint height;
+
+      for (height = HEIGHT; height <= HEIGHT + 1; height++) {
+        GstVideoFrame frame;
+        GstVideoInfo info;
+        GstBuffer *buf;
+        gchar *props;
+        gint x, y, c;
+
+        props = g_strdup_printf ("method=%s threads=1", methods[j]);
+        buf = convert (props, "bggr12le", WIDTH, height, samples,
+            out_formats[i], &info);
+        g_free (props);
+
+        fail_unless (gst_video_frame_map (&frame, &info, buf, GST_MAP_READ));
+        for (c = 0; c < 3; c++) {
+          for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, c); y++) {
+            for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame, c); x++) {
+              guint8 v = GST_VIDEO_FRAME_COMP_DATA (&frame, c)[y *
+                  GST_VIDEO_FRAME_COMP_STRIDE (&frame, c) +
+                  x * GST_VIDEO_FRAME_COMP_PSTRIDE (&frame, c)];
+
+              /* 128 in limited range luma is 126, grey has no chroma */
+              if (c == 0)
+                fail_unless (ABS (v - 126) <= 1);
+              else
+                fail_unless_equals_int (v, 128);
+            }
+          }
+        }
+        gst_video_frame_unmap (&frame);
+
+        gst_buffer_unref (buf);
+      }
+    }
+  }
+
+  g_free (samples);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_threads_identical)
+{
+  const struct
+  {
+    const gchar *format;
+    const gchar *method;
+    const gchar *out_format;
+  } cases[] = {
+    {
+    "grbg", "bilinear", "BGRx"}, {
+    "rggb10le", "bilinear", "ARGB64"}, {
+    "gbrg12be", "edge-aware", "RGBx"}, {
+    "bggr16le", "edge-aware", "I420"}, {
+    "bggr", "edge-aware", "NV12"}
+  };
+  const gint width = 64, height = 256;
+  guint16 *samples = g_new (guint16, width * height);
+  GRand *rand = g_rand_new_with_seed (0x5eed);
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (cases); i++) {
+    gint depth = format_depth (cases[i].format);
+    GstVideoInfo info1, info4;
+    GstBuffer *buf1, *buf4;
+    GstMapInfo map1, map4;
+    gchar *props;
+    gint n;
+
+    for (n = 0; n < width * height; n++)
+      samples[n] = g_rand_int_range (rand, 0, 1 << depth);
+
+    props = g_strdup_printf ("method=%s threads=1", cases[i].method);
+    buf1 = convert (props, cases[i].format, width, height, samples,
+        cases[i].out_format, &info1);
+    g_free (props);
+    props = g_strdup_printf ("method=%s threads=4", cases[i].method);
+    buf4 = convert (props, cases[i].format, width, height, samples,
+        cases[i].out_format, &info4);
+    g_free (props);
+
+    fail_unless (gst_buffer_map (buf1, &map1, GST_MAP_READ));
+    fail_unless (gst_buffer_map (buf4, &map4, GST_MAP_READ));
+    fail_unless_equals_int (map1.size, map4.size);
+    fail_unless (memcmp (map1.data, map4.data, map1.size) == 0);
+    gst_buffer_unmap (buf1, &map1);
+    gst_buffer_unmap (buf4, &map4);
+
+    gst_buffer_unref (buf1);
+    gst_buffer_unref (buf4);
+  }
+
+  g_rand_free (rand);
+  g_free (samples);
+}
+
+GST_END_TEST;
+
+static Suite *
+bayer2rgb_suite (void)
+{
+  Suite *s = suite_create ("bayer2rgb");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_bilinear);
+  tcase_add_test (tc_chain, test_edge_aware);
+  tcase_add_test (tc_chain, test_yuv);
+  tcase_add_test (tc_chain, test_threads_identical);
+
+  return s;
+}
+
+GST_CHECK_MAIN (bayer2rgb);
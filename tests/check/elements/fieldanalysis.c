@@ -0,0 +1,260 @@
+/* GStreamer
+ *
+ * unit test for fieldanalysis
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstharness.h>
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+#include <string.h>
+
+#define N_FRAMES 10
+#define FRAME_DURATION (GST_SECOND / 25)
+
+/* distance the bars move from one frame to the next */
+#define MOTION 20
+
+#define VIDEO_FLAGS (GST_VIDEO_BUFFER_FLAG_INTERLACED | \
+    GST_VIDEO_BUFFER_FLAG_TFF | GST_VIDEO_BUFFER_FLAG_RFF | \
+    GST_VIDEO_BUFFER_FLAG_ONEFIELD)
+
+static const gchar *formats[] = { "YUY2", "UYVY", "Y42B", "I420", "YV12" };
+
+static const gchar *field_metrics[] = { "sad", "ssd", "3-tap" };
+static const gchar *frame_metrics[] = { "5-tap", "windowed-comb" };
+
+typedef enum
+{
+  CONTENT_PROGRESSIVE,
+  CONTENT_INTERLACED,
+  CONTENT_TELECINE
+} Content;
+
+/* vertical bars, 48 samples wide, at position @pos */
+static guint8
+bar (gint x, gint pos)
+{
+  return ((x + pos) / 48) % 2 ? 200 : 50;
+}
+
+/* Creates frame @index of @content. The chroma lines alternate between two
+ * extremes, so that measuring anything else than the luma would see combing
+ * in every frame. */
+static GstBuffer *
+create_frame (GstVideoInfo * info, Content content, guint index)
+{
+  GstVideoFrame frame;
+  GstBuffer *buf;
+  gint c, x, y;
+
+  buf = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (info), NULL);
+  fail_unless (gst_video_frame_map (&frame, info, buf, GST_MAP_WRITE));
+
+  for (c = 0; c < GST_VIDEO_FRAME_N_COMPONENTS (&frame); c++) {
+    guint8 *data = GST_VIDEO_FRAME_COMP_DATA (&frame, c);
+    gint stride = GST_VIDEO_FRAME_COMP_STRIDE (&frame, c);
+    gint pstride = GST_VIDEO_FRAME_COMP_PSTRIDE (&frame, c);
+
+    for (y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT (&frame, c); y++) {
+      guint8 *line = data + y * stride;
+      gint pos;
+
+      switch (content) {
+        case CONTENT_PROGRESSIVE:
+          pos = index * MOTION;
+          break;
+        case CONTENT_INTERLACED:
+          /* the bottom field is captured half a frame later */
+          pos = index * MOTION + (y & 1) * MOTION / 2;
+          break;
+        case CONTENT_TELECINE:
+        default:{
+          /* 3:2 pulldown of 4 film frames to 5 video frames: AA BB BC CD DD */
+          static const guint top[] = { 0, 1, 1, 2, 3 };
+          static const guint bottom[] = { 0, 1, 2, 3, 3 };
+
+          pos = 4 * (index / 5) + ((y & 1) ? bottom : top)[index % 5];
+          pos *= MOTION;
+          break;
+        }
+      }
+
+      for (x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH (&frame, c); x++) {
+        if (c == 0)
+          line[x * pstride] = bar (x, pos);
+        else
+          line[x * pstride] = (y & 1) ? 16 : 240;
+      }
+    }
+  }
+
+  gst_video_frame_unmap (&frame);
+
+  GST_BUFFER_PTS (buf) = index * FRAME_DURATION;
+  GST_BUFFER_DURATION (buf) = FRAME_DURATION;
+  GST_BUFFER_FLAG_SET (buf, GST_VIDEO_BUFFER_FLAG_TFF);
+
+  return buf;
+}
+
+/* Runs N_FRAMES frames of @content through fieldanalysis with the properties
+ * @props, and returns the video flags of the output buffers */
+static GArray *
+analyse (const gchar * props, const gchar * format, gint width, gint height,
+    Content content)
+{
+  GstVideoInfo info;
+  GstHarness *h;
+  GstBuffer *buf;
+  GArray *flags;
+  gchar *desc;
+  guint i;
+
+  desc = g_strdup_printf ("fieldanalysis %s", props);
+  h = gst_harness_new_parse (desc);
+  g_free (desc);
+
+  gst_video_info_set_format (&info, gst_video_format_from_string (format),
+      width, height);
+  GST_VIDEO_INFO_FPS_N (&info) = 25;
+  GST_VIDEO_INFO_FPS_D (&info) = 1;
+  gst_harness_set_src_caps (h, gst_video_info_to_caps (&info));
+
+  for (i = 0; i < N_FRAMES; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_frame (&info, content,
+                i)), GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  flags = g_array_new (FALSE, FALSE, sizeof (guint));
+  while ((buf = gst_harness_try_pull (h))) {
+    guint f = GST_BUFFER_FLAGS (buf) & VIDEO_FLAGS;
+
+    g_array_append_val (flags, f);
+    gst_buffer_unref (buf);
+  }
+  fail_unless_equals_int (flags->len, N_FRAMES);
+
+  gst_harness_teardown (h);
+
+  return flags;
+}
+
+static gboolean
+flags_equal (GArray * a, GArray * b)
+{
+  return a->len == b->len &&
+      memcmp (a->data, b->data, a->len * sizeof (guint)) == 0;
+}
+
+/* only the luma is measured, so every format gives the same verdicts, for
+ * every metric */
+GST_START_TEST (test_formats)
+{
+  guint i, j, k;
+
+  for (i = 0; i < G_N_ELEMENTS (field_metrics); i++) {
+    for (j = 0; j < G_N_ELEMENTS (frame_metrics); j++) {
+      gchar *props = g_strdup_printf ("threads=1 field-metric=%s "
+          "frame-metric=%s", field_metrics[i], frame_metrics[j]);
+      GArray *progressive, *interlaced;
+      guint n;
+
+      progressive = analyse (props, formats[0], 320, 240, CONTENT_PROGRESSIVE);
+      interlaced = analyse (props, formats[0], 320, 240, CONTENT_INTERLACED);
+
+      /* the reference verdicts, checked on the first format */
+      for (n = 0; n < N_FRAMES; n++) {
+        fail_if (g_array_index (progressive, guint, n) &
+            GST_VIDEO_BUFFER_FLAG_INTERLACED);
+        fail_unless (g_array_index (interlaced, guint, n) &
+            GST_VIDEO_BUFFER_FLAG_INTERLACED);
+      }
+
+      for (k = 1; k < G_N_ELEMENTS (formats); k++) {
+        GArray *flags;
+
+        GST_INFO ("%s with %s", formats[k], props);
+
+        flags = analyse (props, formats[k], 320, 240, CONTENT_PROGRESSIVE);
+        fail_unless (flags_equal (flags, progressive));
+        g_array_unref (flags);
+
+        flags = analyse (props, formats[k], 320, 240, CONTENT_INTERLACED);
+        fail_unless (flags_equal (flags, interlaced));
+        g_array_unref (flags);
+      }
+
+      g_array_unref (progressive);
+      g_array_unref (interlaced);
+      g_free (props);
+    }
+  }
+}
+
+GST_END_TEST;
+
+/* frames tall enough to be split in several bands are analysed the same way
+ * by one and by several threads */
+GST_START_TEST (test_threads_identical)
+{
+  const Content contents[] = {
+    CONTENT_PROGRESSIVE, CONTENT_INTERLACED, CONTENT_TELECINE
+  };
+  guint i, j, k;
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++) {
+    for (j = 0; j < G_N_ELEMENTS (field_metrics); j++) {
+      for (k = 0; k < G_N_ELEMENTS (contents); k++) {
+        gchar *props1, *props4;
+        GArray *flags1, *flags4;
+
+        props1 = g_strdup_printf ("threads=1 field-metric=%s",
+            field_metrics[j]);
+        props4 = g_strdup_printf ("threads=4 field-metric=%s",
+            field_metrics[j]);
+
+        flags1 = analyse (props1, formats[i], 176, 288, contents[k]);
+        flags4 = analyse (props4, formats[i], 176, 288, contents[k]);
+        fail_unless (flags_equal (flags1, flags4));
+
+        g_array_unref (flags1);
+        g_array_unref (flags4);
+        g_free (props1);
+        g_free (props4);
+      }
+    }
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+fieldanalysis_suite (void)
+{
+  Suite *s = suite_create ("fieldanalysis");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_set_timeout (tc_chain, 60);
+  tcase_add_test (tc_chain, test_formats);
+  tcase_add_test (tc_chain, test_threads_identical);
+
+  return s;
+}
+
+GST_CHECK_MAIN (fieldanalysis);
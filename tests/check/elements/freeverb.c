@@ -0,0 +1,324 @@
+/* GStreamer
+ *
+ * unit test for freeverb
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <string.h>
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define FORMAT_NE(f) f "LE"
+#else
+#define FORMAT_NE(f) f "BE"
+#endif
+
+/* at 8 kHz the shortest comb is shorter than a processing block */
+#define RATE 8000
+
+#define ROOM_SIZE 0.8f
+#define DAMPING 0.3f
+#define WIDTH 0.7f
+#define LEVEL 0.4f
+
+/* buffer sizes in frames around the block size of 202 frames at RATE, and
+ * long enough in total for the reverb tail to wrap all delay lines a few
+ * times */
+static const guint buffer_frames[] = {
+  1, 7, 201, 202, 203, 404, 33, 1000, 255, 256, 257, 2000, 3
+};
+
+/* The original per-sample Freeverb, as the element computed it before it
+ * processed blocks */
+
+#define DC_OFFSET 1e-8
+#define N_COMBS 8
+#define N_ALLPASSES 4
+
+static const gint comb_tuning[N_COMBS] = {
+  1116, 1188, 1277, 1356, 1422, 1491, 1557, 1617
+};
+
+static const gint allpass_tuning[N_ALLPASSES] = { 556, 441, 341, 225 };
+
+typedef struct
+{
+  gfloat *buffer;
+  gint bufsize;
+  gint bufidx;
+  gfloat filterstore;
+} RefDelay;
+
+typedef struct
+{
+  RefDelay comb[2][N_COMBS];
+  RefDelay allpass[2][N_ALLPASSES];
+  gfloat feedback, damp1, damp2;
+  gfloat wet1, wet2, dry;
+} RefModel;
+
+static void
+ref_delay_init (RefDelay * d, gint size)
+{
+  gint i;
+
+  d->bufsize = MAX (size, 1);
+  d->bufidx = 0;
+  d->filterstore = 0;
+  d->buffer = g_new (gfloat, d->bufsize);
+  for (i = 0; i < d->bufsize; i++)
+    d->buffer[i] = (gfloat) DC_OFFSET;
+}
+
+static void
+ref_model_init (RefModel * m)
+{
+  gfloat srfactor = RATE / 44100.0f;
+  gfloat wet;
+  gint c, i;
+
+  for (c = 0; c < 2; c++) {
+    /* the right channel is spread by 23 samples */
+    for (i = 0; i < N_COMBS; i++)
+      ref_delay_init (&m->comb[c][i], (comb_tuning[i] + 23 * c) * srfactor);
+    for (i = 0; i < N_ALLPASSES; i++)
+      ref_delay_init (&m->allpass[c][i],
+          (allpass_tuning[i] + 23 * c) * srfactor);
+  }
+
+  m->feedback = (ROOM_SIZE * 0.28f) + 0.7f;
+  m->damp1 = DAMPING;
+  m->damp2 = 1 - DAMPING;
+  wet = LEVEL;
+  m->dry = (1.0 - LEVEL);
+  m->wet1 = wet * (WIDTH / 2.0f + 0.5f);
+  m->wet2 = wet * ((1.0f - WIDTH) / 2.0f);
+}
+
+static void
+ref_model_free (RefModel * m)
+{
+  gint c, i;
+
+  for (c = 0; c < 2; c++) {
+    for (i = 0; i < N_COMBS; i++)
+      g_free (m->comb[c][i].buffer);
+    for (i = 0; i < N_ALLPASSES; i++)
+      g_free (m->allpass[c][i].buffer);
+  }
+}
+
+static gfloat
+ref_channel_process (RefModel * m, gint c, gfloat input)
+{
+  gfloat output = 0.0, tmp;
+  gint i;
+
+  for (i = 0; i < N_COMBS; i++) {
+    RefDelay *d = &m->comb[c][i];
+
+    tmp = d->buffer[d->bufidx];
+    d->filterstore = (tmp * m->damp2) + (d->filterstore * m->damp1);
+    d->buffer[d->bufidx] = input + (d->filterstore * m->feedback);
+    if (++d->bufidx >= d->bufsize)
+      d->bufidx = 0;
+    output += tmp;
+  }
+  for (i = 0; i < N_ALLPASSES; i++) {
+    RefDelay *d = &m->allpass[c][i];
+
+    tmp = d->buffer[d->bufidx];
+    d->buffer[d->bufidx] = output + (tmp * 0.5f);
+    if (++d->bufidx >= d->bufsize)
+      d->bufidx = 0;
+    output = tmp - output;
+  }
+
+  /* Remove the DC offset */
+  return output - (gfloat) DC_OFFSET;
+}
+
+/* processes one frame of @in_l and @in_r, which are the same for mono */
+static void
+ref_model_process (RefModel * m, gboolean mono, gfloat in_l, gfloat in_r,
+    gfloat * out_l, gfloat * out_r)
+{
+  gfloat input_l, input_r, l, r;
+
+  if (mono) {
+    input_l = input_r = (2.0f * in_l + DC_OFFSET) * 0.015f;
+  } else {
+    input_l = (in_l + DC_OFFSET) * 0.015f;
+    input_r = (in_r + DC_OFFSET) * 0.015f;
+  }
+
+  l = ref_channel_process (m, 0, input_l);
+  r = ref_channel_process (m, 1, input_r);
+
+  *out_l = l * m->wet1 + r * m->wet2 + in_l * m->dry;
+  *out_r = r * m->wet1 + l * m->wet2 + in_r * m->dry;
+}
+
+/* An impulse, then noise bursts with silence in between so that the tail
+ * is compared too. The S16 input is loud enough for the output to clip. */
+static gfloat
+input_sample (GRand * rand, guint frame, gint channel, gboolean is_float)
+{
+  gfloat amp = is_float ? 1.0f : 32767.0f;
+
+  if (frame == 0)
+    return channel == 0 ? amp : 0.0f;
+  if ((frame / 500) % 2 == 0)
+    return 0.0f;
+
+  return g_rand_double_range (rand, -amp, amp);
+}
+
+static void
+run_reference_test (const gchar * format, gint channels)
+{
+  gboolean is_float = g_str_has_prefix (format, "F32");
+  gboolean mono = channels == 1;
+  gsize bps = is_float ? sizeof (gfloat) : sizeof (gint16);
+  RefModel model;
+  GstHarness *h;
+  GRand *rand;
+  guint frame = 0, b, i;
+
+  h = gst_harness_new ("freeverb");
+  g_object_set (h->element, "room-size", ROOM_SIZE, "damping", DAMPING,
+      "width", WIDTH, "level", LEVEL, NULL);
+  gst_harness_set_src_caps (h, gst_caps_new_simple ("audio/x-raw",
+          "format", G_TYPE_STRING, format, "layout", G_TYPE_STRING,
+          "interleaved", "rate", G_TYPE_INT, RATE, "channels", G_TYPE_INT,
+          channels, NULL));
+
+  ref_model_init (&model);
+  rand = g_rand_new_with_seed (11);
+
+  for (b = 0; b < G_N_ELEMENTS (buffer_frames); b++) {
+    guint n = buffer_frames[b];
+    GstBuffer *in, *out;
+    GstMapInfo map;
+    gfloat *input;
+
+    input = g_new (gfloat, n * channels);
+    in = gst_buffer_new_allocate (NULL, n * channels * bps, NULL);
+    fail_unless (gst_buffer_map (in, &map, GST_MAP_WRITE));
+    for (i = 0; i < n * channels; i++) {
+      input[i] = input_sample (rand, frame + i / channels, i % channels,
+          is_float);
+      if (is_float)
+        ((gfloat *) map.data)[i] = input[i];
+      else
+        ((gint16 *) map.data)[i] = (gint16) input[i];
+      /* the element sees the converted sample */
+      if (!is_float)
+        input[i] = ((gint16 *) map.data)[i];
+    }
+    gst_buffer_unmap (in, &map);
+
+    GST_BUFFER_PTS (in) = gst_util_uint64_scale (frame, GST_SECOND, RATE);
+    GST_BUFFER_DURATION (in) = gst_util_uint64_scale (n, GST_SECOND, RATE);
+    fail_unless_equals_int (gst_harness_push (h, in), GST_FLOW_OK);
+
+    out = gst_harness_pull (h);
+    fail_unless (out != NULL);
+    fail_unless_equals_int (gst_buffer_get_size (out), n * 2 * bps);
+    fail_unless (gst_buffer_map (out, &map, GST_MAP_READ));
+
+    for (i = 0; i < n; i++) {
+      gfloat in_l = input[i * channels];
+      gfloat in_r = input[i * channels + channels - 1];
+      gfloat ref[2];
+      gint c;
+
+      ref_model_process (&model, mono, in_l, in_r, &ref[0], &ref[1]);
+
+      for (c = 0; c < 2; c++) {
+        if (is_float) {
+          gfloat v = ((gfloat *) map.data)[2 * i + c];
+
+          /* only the rounding of the operations may differ */
+          fail_unless (ABS (v - ref[c]) <= 1e-6 + ABS (ref[c]) * 1e-5,
+              "frame %u channel %d: %g != %g", frame + i, c, v, ref[c]);
+        } else {
+          gint v = ((gint16 *) map.data)[2 * i + c];
+          gint r = (gint16) CLAMP (ref[c], G_MININT16, G_MAXINT16);
+
+          fail_unless (ABS (v - r) <= 1, "frame %u channel %d: %d != %d",
+              frame + i, c, v, r);
+        }
+      }
+    }
+
+    gst_buffer_unmap (out, &map);
+    gst_buffer_unref (out);
+    g_free (input);
+    frame += n;
+  }
+
+  g_rand_free (rand);
+  ref_model_free (&model);
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_mono_s16)
+{
+  run_reference_test (FORMAT_NE ("S16"), 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_stereo_s16)
+{
+  run_reference_test (FORMAT_NE ("S16"), 2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_mono_f32)
+{
+  run_reference_test (FORMAT_NE ("F32"), 1);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_stereo_f32)
+{
+  run_reference_test (FORMAT_NE ("F32"), 2);
+}
+
+GST_END_TEST;
+
+static Suite *
+freeverb_suite (void)
+{
+  Suite *s = suite_create ("freeverb");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_mono_s16);
+  tcase_add_test (tc_chain, test_stereo_s16);
+  tcase_add_test (tc_chain, test_mono_f32);
+  tcase_add_test (tc_chain, test_stereo_f32);
+
+  return s;
+}
+
+GST_CHECK_MAIN (freeverb);
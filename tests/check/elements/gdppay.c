@@ -556,6 +556,117 @@ GST_START_TEST (test_crc)
 
 GST_END_TEST;
 
+static void
+push_data_buffer (guint8 value)
+{
+  GstBuffer *inbuffer;
+
+  inbuffer = gst_buffer_new_and_alloc (4);
+  gst_buffer_memset (inbuffer, 0, value, 4);
+  fail_unless (gst_pad_push (mysrcpad, inbuffer) == GST_FLOW_OK);
+}
+
+static void
+check_data_buffer (guint8 value)
+{
+  GstBuffer *outbuffer;
+  GstMapInfo map;
+
+  fail_if ((outbuffer = (GstBuffer *) buffers->data) == NULL);
+  buffers = g_list_remove (buffers, outbuffer);
+  gst_buffer_map (outbuffer, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.size, GST_DP_HEADER_LENGTH + 4);
+  fail_unless_equals_int (map.data[GST_DP_HEADER_LENGTH], value);
+  gst_buffer_unmap (outbuffer, &map);
+  gst_buffer_unref (outbuffer);
+}
+
+GST_START_TEST (test_batch)
+{
+  GstCaps *caps;
+  GstElement *gdppay;
+
+  gdppay = setup_gdppay ();
+  g_object_set (gdppay, "batch-size", 3, NULL);
+
+  fail_unless (gst_element_set_state (gdppay,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  caps = gst_caps_from_string (AUDIO_CAPS_STRING);
+  gst_check_setup_events (mysrcpad, gdppay, caps, GST_FORMAT_TIME);
+
+  /* the stream header goes out right away, the data once the batch is full */
+  push_data_buffer (0);
+  push_data_buffer (1);
+  fail_unless_equals_int (g_list_length (buffers), 3);
+  check_stream_start_buffer (1);
+  check_caps_buffer (1, caps);
+  check_segment_buffer (1);
+
+  push_data_buffer (2);
+  fail_unless_equals_int (g_list_length (buffers), 3);
+  check_data_buffer (0);
+  check_data_buffer (1);
+  check_data_buffer (2);
+
+  /* lowering the batch size keeps the order of the batched buffers */
+  push_data_buffer (3);
+  push_data_buffer (4);
+  fail_unless_equals_int (g_list_length (buffers), 0);
+  g_object_set (gdppay, "batch-size", 1, NULL);
+  push_data_buffer (5);
+  fail_unless_equals_int (g_list_length (buffers), 3);
+  check_data_buffer (3);
+  check_data_buffer (4);
+  check_data_buffer (5);
+
+  /* and a serialized event pushes the batch before itself */
+  g_object_set (gdppay, "batch-size", 3, NULL);
+  push_data_buffer (6);
+  fail_unless_equals_int (g_list_length (buffers), 0);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+  fail_unless (g_list_length (buffers) >= 1);
+  check_data_buffer (6);
+
+  fail_unless (gst_element_set_state (gdppay,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  gst_caps_unref (caps);
+  g_list_foreach (buffers, (GFunc) gst_mini_object_unref, NULL);
+  g_list_free (buffers);
+  buffers = NULL;
+  ASSERT_OBJECT_REFCOUNT (gdppay, "gdppay", 1);
+  cleanup_gdppay (gdppay);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_crc_unaligned)
+{
+  guint8 data[256];
+  guint16 crc;
+  gsize i, offset, length;
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = g_random_int () & 0xff;
+
+  /* compare against the byte wise calculation for all alignments and for
+   * lengths around the eight byte blocks */
+  for (offset = 0; offset < 8; offset++) {
+    for (length = 0; length < 100; length++) {
+      crc = 0xffff;
+      for (i = 0; i < length; i++)
+        crc = (crc << 8) ^ gst_dp_crc_table[(crc >> 8) ^ data[offset + i]];
+      crc = 0xffff ^ crc;
+
+      fail_unless_equals_int (gst_dp_crc (data + offset, length), crc);
+    }
+  }
+}
+
+GST_END_TEST;
+
 
 static Suite *
 gdppay_suite (void)
@@ -569,6 +680,8 @@ gdppay_suite (void)
   tcase_add_test (tc_chain, test_first_no_new_segment);
   tcase_add_test (tc_chain, test_streamheader);
   tcase_add_test (tc_chain, test_crc);
+  tcase_add_test (tc_chain, test_crc_unaligned);
+  tcase_add_test (tc_chain, test_batch);
 
   return s;
 }
@@ -24,6 +24,9 @@
  */
 
 #include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
 #include "parser.h"
 
 #define SRC_CAPS_TMPL   "video/x-h264, parsed=(boolean)false"
@@ -416,6 +419,378 @@ h264parse_packetized_suite (void)
 }
 
 
+/* Builds a byte-stream access unit of SPS, @n_pps times the PPS and the
+ * IDR slice, with the memories of the buffer split every @split bytes, or
+ * one per NAL if @split is 0. Returns the avc version of it in @avc. */
+static GstBuffer *
+create_convert_au (guint n_pps, gsize split, GByteArray * avc)
+{
+  const guint8 *nals[2 + 16];
+  gsize sizes[2 + 16];
+  GByteArray *bs = g_byte_array_new ();
+  GstBuffer *buf = gst_buffer_new ();
+  guint n = 0, i;
+  gsize offset;
+
+  nals[n] = h264_sps;
+  sizes[n++] = sizeof (h264_sps);
+  for (i = 0; i < n_pps; i++) {
+    nals[n] = h264_pps;
+    sizes[n++] = sizeof (h264_pps);
+  }
+  nals[n] = h264_idrframe;
+  sizes[n++] = sizeof (h264_idrframe);
+
+  g_byte_array_set_size (avc, 0);
+  for (i = 0; i < n; i++) {
+    guint8 length[4];
+
+    g_byte_array_append (bs, nals[i], sizes[i]);
+    if (!split)
+      gst_buffer_append_memory (buf, gst_memory_new_wrapped (0,
+              g_memdup (nals[i], sizes[i]), sizes[i], 0, sizes[i],
+              NULL, g_free));
+
+    /* the 4 bytes start code becomes a 4 bytes length */
+    GST_WRITE_UINT32_BE (length, sizes[i] - 4);
+    g_byte_array_append (avc, length, 4);
+    g_byte_array_append (avc, nals[i] + 4, sizes[i] - 4);
+  }
+
+  for (offset = 0; split && offset < bs->len; offset += split) {
+    gsize size = MIN (split, bs->len - offset);
+
+    gst_buffer_append_memory (buf, gst_memory_new_wrapped (0,
+            g_memdup (bs->data + offset, size), size, 0, size, NULL, g_free));
+  }
+  g_byte_array_unref (bs);
+
+  return buf;
+}
+
+/* the avc frames are the same whether the NALs are shared from the input,
+ * in one or several memories, or copied once the output buffer is full */
+GST_START_TEST (test_convert_to_avc)
+{
+  const guint n_pps[] = { 1, 5, 6, 16 };
+  const gsize splits[] = { 0, 7, 1000 };
+  GByteArray *avc = g_byte_array_new ();
+  guint i, j, k;
+
+  for (i = 0; i < G_N_ELEMENTS (n_pps); i++) {
+    for (j = 0; j < G_N_ELEMENTS (splits); j++) {
+      GstHarness *h = gst_harness_new ("h264parse");
+
+      gst_harness_set_src_caps_str (h,
+          "video/x-h264,stream-format=byte-stream");
+      gst_harness_set_sink_caps_str (h,
+          "video/x-h264,stream-format=avc,alignment=au");
+
+      /* the next access unit ends the previous one, EOS the last one */
+      for (k = 0; k < 3; k++)
+        fail_unless_equals_int (gst_harness_push (h,
+                create_convert_au (n_pps[i], splits[j], avc)), GST_FLOW_OK);
+      fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+      fail_unless_equals_int (gst_harness_buffers_in_queue (h), 3);
+      for (k = 0; k < 3; k++) {
+        GstBuffer *buf = gst_harness_pull (h);
+
+        GST_INFO ("%u PPS, split %" G_GSIZE_FORMAT ", %u memories",
+            n_pps[i], splits[j], gst_buffer_n_memory (buf));
+        fail_unless (gst_buffer_n_memory (buf) <= gst_buffer_get_max_memory ());
+        fail_unless_equals_int (gst_buffer_get_size (buf), avc->len);
+        fail_unless (gst_buffer_memcmp (buf, 0, avc->data, avc->len) == 0);
+        gst_buffer_unref (buf);
+      }
+
+      gst_harness_teardown (h);
+    }
+  }
+
+  g_byte_array_unref (avc);
+}
+
+GST_END_TEST;
+
+static Suite *
+h264parse_convert_suite (void)
+{
+  Suite *s = suite_create ("h264parse_convert");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_convert_to_avc);
+
+  return s;
+}
+
+/* frame index files, see gstvideoparseindex.c */
+#define INDEX_HEADER_SIZE 40
+#define INDEX_ENTRY_SIZE 26
+#define INDEX_N_AUS 250
+#define INDEX_AU_SIZE \
+    (sizeof (h264_sps) + sizeof (h264_pps) + sizeof (h264_idrframe))
+#define INDEX_FRAME_DURATION (GST_SECOND / 25)
+
+/* leading garbage, then INDEX_N_AUS access units of one keyframe each */
+static guint8 *
+create_index_stream (gsize * size)
+{
+  guint8 *data, *p;
+  guint i;
+
+  *size = sizeof (garbage_frame) + INDEX_N_AUS * INDEX_AU_SIZE;
+  p = data = g_malloc (*size);
+
+  memcpy (p, garbage_frame, sizeof (garbage_frame));
+  p += sizeof (garbage_frame);
+  for (i = 0; i < INDEX_N_AUS; i++) {
+    memcpy (p, h264_sps, sizeof (h264_sps));
+    p += sizeof (h264_sps);
+    memcpy (p, h264_pps, sizeof (h264_pps));
+    p += sizeof (h264_pps);
+    memcpy (p, h264_idrframe, sizeof (h264_idrframe));
+    p += sizeof (h264_idrframe);
+  }
+
+  return data;
+}
+
+/* Checks that @location holds a complete index of the stream, for media of
+ * @media_size bytes, and returns its inode */
+static guint64
+check_index (const gchar * location, guint64 media_size)
+{
+  GStatBuf st;
+  gchar *contents, *tmp_location;
+  gsize size;
+  guint64 first_offset;
+  guint i;
+
+  /* no partial index is left behind */
+  tmp_location = g_strconcat (location, ".part", NULL);
+  fail_if (g_file_test (tmp_location, G_FILE_TEST_EXISTS));
+  g_free (tmp_location);
+
+  fail_unless (g_file_get_contents (location, &contents, &size, NULL));
+  fail_unless_equals_int (size,
+      INDEX_HEADER_SIZE + INDEX_N_AUS * INDEX_ENTRY_SIZE);
+  fail_unless (memcmp (contents, "GSTVPIDX", 8) == 0);
+  fail_unless_equals_int (GST_READ_UINT32_BE (contents + 8), 3);
+  /* complete */
+  fail_unless (GST_READ_UINT32_BE (contents + 12) & 1);
+  fail_unless_equals_uint64 (GST_READ_UINT64_BE (contents + 16), media_size);
+
+  first_offset = GST_READ_UINT64_BE (contents + INDEX_HEADER_SIZE);
+  fail_unless (first_offset <= sizeof (garbage_frame));
+  for (i = 0; i < INDEX_N_AUS; i++) {
+    const gchar *entry = contents + INDEX_HEADER_SIZE + i * INDEX_ENTRY_SIZE;
+
+    if (i > 0)
+      fail_unless_equals_uint64 (GST_READ_UINT64_BE (entry),
+          sizeof (garbage_frame) + i * INDEX_AU_SIZE);
+    fail_unless_equals_uint64 (GST_READ_UINT64_BE (entry + 8),
+        i * INDEX_FRAME_DURATION);
+    /* keyframe and GOP start */
+    fail_unless_equals_int (entry[25], 3);
+  }
+  g_free (contents);
+
+  fail_unless (g_stat (location, &st) == 0);
+  return st.st_ino;
+}
+
+static void
+index_handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    GArray * pts)
+{
+  GstClockTime ts = GST_BUFFER_PTS (buffer);
+
+  g_array_append_val (pts, ts);
+}
+
+/* Plays the file @location through h264parse writing or using the index
+ * @index_location, seeking to @seek_pos first unless it is -1, and returns
+ * the timestamps of the frames rendered */
+static GArray *
+play_with_index (const gchar * location, const gchar * index_location,
+    GstClockTime seek_pos)
+{
+  GstElement *pipeline, *sink;
+  GstBus *bus;
+  GstMessage *msg;
+  GArray *pts;
+  gchar *desc;
+
+  /* the file is read in several buffers, in push mode */
+  desc = g_strdup_printf ("filesrc location=\"%s\" blocksize=1000 ! queue ! "
+      "capsfilter caps=\"video/x-h264,stream-format=byte-stream,"
+      "framerate=25/1\" ! h264parse index-location=\"%s\" ! "
+      "fakesink name=sink signal-handoffs=true", location, index_location);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (pipeline != NULL);
+
+  pts = g_array_new (FALSE, FALSE, sizeof (GstClockTime));
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (index_handoff_cb), pts);
+  gst_object_unref (sink);
+
+  bus = gst_element_get_bus (pipeline);
+
+  fail_if (gst_element_set_state (pipeline,
+          GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_ASYNC_DONE);
+  gst_message_unref (msg);
+
+  if (seek_pos != -1) {
+    fail_unless (gst_element_seek_simple (pipeline, GST_FORMAT_TIME,
+            GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, seek_pos));
+    /* prerolls again on the frame sought to */
+    msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+        GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+    fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_ASYNC_DONE);
+    gst_message_unref (msg);
+  }
+
+  fail_if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  return pts;
+}
+
+GST_START_TEST (test_index_write_reload_seek)
+{
+  gchar *location, *index_location;
+  guint8 *data;
+  gsize size;
+  guint64 inode;
+  GArray *pts;
+  gint fd;
+
+  data = create_index_stream (&size);
+  fd = g_file_open_tmp ("h264parse-XXXXXX.h264", &location, NULL);
+  fail_unless (fd != -1);
+  fail_unless_equals_int (write (fd, data, size), size);
+  close (fd);
+  g_free (data);
+  index_location = g_strconcat (location, ".idx", NULL);
+
+  /* the garbage skipped at the start does not keep the index from being
+   * completed */
+  pts = play_with_index (location, index_location, -1);
+  fail_unless_equals_int (pts->len, INDEX_N_AUS);
+  g_array_unref (pts);
+  inode = check_index (index_location, size);
+
+  /* reloaded, it is not written again, and the seek lands on the keyframe
+   * it lists */
+  pts = play_with_index (location, index_location,
+      100 * INDEX_FRAME_DURATION + INDEX_FRAME_DURATION / 2);
+  fail_unless (pts->len > 0);
+  fail_unless_equals_uint64 (g_array_index (pts, GstClockTime, 0),
+      100 * INDEX_FRAME_DURATION);
+  fail_unless_equals_int (pts->len, INDEX_N_AUS - 100);
+  g_array_unref (pts);
+  fail_unless_equals_uint64 (check_index (index_location, size), inode);
+
+  g_unlink (index_location);
+  g_unlink (location);
+  g_free (index_location);
+  g_free (location);
+}
+
+GST_END_TEST;
+
+/* Pushes the whole stream through h264parse with a TIME segment, like a
+ * demuxer does, in buffers of 1000 bytes */
+static void
+push_index_stream (const gchar * index_location, const guint8 * data,
+    gsize size)
+{
+  GstHarness *h;
+  gsize offset;
+
+  h = gst_harness_new ("h264parse");
+  g_object_set (h->element, "index-location", index_location, NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/x-h264,stream-format=byte-stream,framerate=25/1");
+
+  for (offset = 0; offset < size; offset += 1000) {
+    GstBuffer *buf = gst_buffer_new_allocate (NULL, MIN (1000, size - offset),
+        NULL);
+
+    gst_buffer_fill (buf, 0, data + offset, gst_buffer_get_size (buf));
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  gst_harness_teardown (h);
+}
+
+/* behind a demuxer the size of the media is not known, so the index is
+ * completed at EOS and identified by the first frame */
+GST_START_TEST (test_index_unknown_size)
+{
+  gchar *index_location;
+  guint8 *data;
+  gsize size;
+  guint64 inode;
+  GStatBuf st;
+  gint fd;
+
+  data = create_index_stream (&size);
+  fd = g_file_open_tmp ("h264parse-XXXXXX.idx", &index_location, NULL);
+  fail_unless (fd != -1);
+  close (fd);
+  g_unlink (index_location);
+
+  push_index_stream (index_location, data, size);
+  inode = check_index (index_location, 0);
+
+  /* the same stream uses the index */
+  push_index_stream (index_location, data, size);
+  fail_unless_equals_uint64 (check_index (index_location, 0), inode);
+
+  /* another one replaces it */
+  data[sizeof (garbage_frame) + sizeof (h264_sps) + sizeof (h264_pps) +
+      sizeof (h264_idrframe) - 1] ^= 0xff;
+  push_index_stream (index_location, data, size);
+  check_index (index_location, 0);
+  fail_unless (g_stat (index_location, &st) == 0);
+  fail_if (st.st_ino == inode);
+
+  g_unlink (index_location);
+  g_free (index_location);
+  g_free (data);
+}
+
+GST_END_TEST;
+
+static Suite *
+h264parse_index_suite (void)
+{
+  Suite *s = suite_create ("h264parse_index");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_index_write_reload_seek);
+  tcase_add_test (tc_chain, test_index_unknown_size);
+
+  return s;
+}
+
 /*
  * TODO:
  *   - Both push- and pull-modes need to be tested
@@ -522,5 +897,17 @@ main (int argc, char **argv)
   nf += srunner_ntests_failed (sr);
   srunner_free (sr);
 
+  s = h264parse_convert_suite ();
+  sr = srunner_create (s);
+  srunner_run_all (sr, CK_NORMAL);
+  nf += srunner_ntests_failed (sr);
+  srunner_free (sr);
+
+  s = h264parse_index_suite ();
+  sr = srunner_create (s);
+  srunner_run_all (sr, CK_NORMAL);
+  nf += srunner_ntests_failed (sr);
+  srunner_free (sr);
+
   return nf;
 }
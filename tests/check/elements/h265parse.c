@@ -0,0 +1,156 @@
+/* GStreamer
+ *
+ * unit test for h265parse
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+/* 128x64 main profile IDR picture with two tile columns, whose slice data
+ * is 20 bytes of filler */
+static const guint8 h265_vps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60,
+  0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x5a, 0xf0, 0x24,
+};
+
+static const guint8 h265_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03,
+  0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x5a, 0xa0, 0x10,
+  0x20, 0x41, 0x65, 0xfa, 0xbc, 0x20, 0x80,
+};
+
+static const guint8 h265_pps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc0, 0x71, 0x84, 0xb8, 0x48,
+};
+
+static const guint8 h265_idr_slice[] = {
+  0x00, 0x00, 0x00, 0x01, 0x26, 0x01, 0xae, 0x84, 0x04, 0xc0, 0xaa, 0xaa,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+};
+
+/* Builds a byte-stream access unit of VPS, SPS, @n_pps times the PPS and
+ * the IDR slice, with the memories of the buffer split every @split bytes,
+ * or one per NAL if @split is 0. Returns the hvc1 version of it in @hvc. */
+static GstBuffer *
+create_au (guint n_pps, gsize split, GByteArray * hvc)
+{
+  const guint8 *nals[3 + 16];
+  gsize sizes[3 + 16];
+  GByteArray *bs = g_byte_array_new ();
+  GstBuffer *buf = gst_buffer_new ();
+  guint n = 0, i;
+  gsize offset;
+
+  nals[n] = h265_vps;
+  sizes[n++] = sizeof (h265_vps);
+  nals[n] = h265_sps;
+  sizes[n++] = sizeof (h265_sps);
+  for (i = 0; i < n_pps; i++) {
+    nals[n] = h265_pps;
+    sizes[n++] = sizeof (h265_pps);
+  }
+  nals[n] = h265_idr_slice;
+  sizes[n++] = sizeof (h265_idr_slice);
+
+  g_byte_array_set_size (hvc, 0);
+  for (i = 0; i < n; i++) {
+    guint8 length[4];
+
+    g_byte_array_append (bs, nals[i], sizes[i]);
+    if (!split)
+      gst_buffer_append_memory (buf, gst_memory_new_wrapped (0,
+              g_memdup (nals[i], sizes[i]), sizes[i], 0, sizes[i],
+              NULL, g_free));
+
+    /* the 4 bytes start code becomes a 4 bytes length */
+    GST_WRITE_UINT32_BE (length, sizes[i] - 4);
+    g_byte_array_append (hvc, length, 4);
+    g_byte_array_append (hvc, nals[i] + 4, sizes[i] - 4);
+  }
+
+  for (offset = 0; split && offset < bs->len; offset += split) {
+    gsize size = MIN (split, bs->len - offset);
+
+    gst_buffer_append_memory (buf, gst_memory_new_wrapped (0,
+            g_memdup (bs->data + offset, size), size, 0, size, NULL, g_free));
+  }
+  g_byte_array_unref (bs);
+
+  return buf;
+}
+
+/* the hvc1 frames are the same whether the NALs are shared from the input,
+ * in one or several memories, or copied once the output buffer is full */
+GST_START_TEST (test_convert_to_hvc1)
+{
+  const guint n_pps[] = { 1, 4, 5, 16 };
+  const gsize splits[] = { 0, 7, 1000 };
+  GByteArray *hvc = g_byte_array_new ();
+  guint i, j, k;
+
+  for (i = 0; i < G_N_ELEMENTS (n_pps); i++) {
+    for (j = 0; j < G_N_ELEMENTS (splits); j++) {
+      GstHarness *h = gst_harness_new ("h265parse");
+
+      gst_harness_set_src_caps_str (h,
+          "video/x-h265,stream-format=byte-stream");
+      gst_harness_set_sink_caps_str (h,
+          "video/x-h265,stream-format=hvc1,alignment=au");
+
+      /* the next access unit ends the previous one, EOS the last one */
+      for (k = 0; k < 3; k++)
+        fail_unless_equals_int (gst_harness_push (h,
+                create_au (n_pps[i], splits[j], hvc)), GST_FLOW_OK);
+      fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+      fail_unless_equals_int (gst_harness_buffers_in_queue (h), 3);
+      for (k = 0; k < 3; k++) {
+        GstBuffer *buf = gst_harness_pull (h);
+
+        GST_INFO ("%u PPS, split %" G_GSIZE_FORMAT ", %u memories",
+            n_pps[i], splits[j], gst_buffer_n_memory (buf));
+        fail_unless (gst_buffer_n_memory (buf) <= gst_buffer_get_max_memory ());
+        fail_unless_equals_int (gst_buffer_get_size (buf), hvc->len);
+        fail_unless (gst_buffer_memcmp (buf, 0, hvc->data, hvc->len) == 0);
+        gst_buffer_unref (buf);
+      }
+
+      gst_harness_teardown (h);
+    }
+  }
+
+  g_byte_array_unref (hvc);
+}
+
+GST_END_TEST;
+
+static Suite *
+h265parse_suite (void)
+{
+  Suite *s = suite_create ("h265parse");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_convert_to_hvc1);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h265parse);
@@ -0,0 +1,139 @@
+/* GStreamer
+ *
+ * unit test for ivtc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+#include "../../gst/ivtc/gstcombmask.h"
+
+#define MAX_TEST_WIDTH 100
+
+static gboolean
+reference_comb_mask (guint8 * mask, const guint8 * src1, const guint8 * src2,
+    const guint8 * src3, int width)
+{
+  gboolean any = FALSE;
+  int i;
+
+  for (i = 0; i < width; i++) {
+    int lo = MIN (src1[i], src3[i]) - 5;
+    int hi = MAX (src1[i], src3[i]) + 5;
+
+    mask[i] = src2[i] < lo || src2[i] > hi;
+    any |= mask[i];
+  }
+
+  return any;
+}
+
+/* Random lines of values near the ends of the range and near each other,
+ * so that many samples are on either side of the +-5 limits */
+static void
+fill_lines (GRand * rand, guint8 * src1, guint8 * src2, guint8 * src3,
+    gint size)
+{
+  static const guint8 bases[] = { 0, 3, 128, 252, 255 };
+  gint i;
+
+  for (i = 0; i < size; i++) {
+    gint base = bases[g_rand_int_range (rand, 0, G_N_ELEMENTS (bases))];
+
+    src1[i] = CLAMP (base + g_rand_int_range (rand, -8, 9), 0, 255);
+    src2[i] = CLAMP (base + g_rand_int_range (rand, -8, 9), 0, 255);
+    src3[i] = CLAMP (base + g_rand_int_range (rand, -8, 9), 0, 255);
+  }
+}
+
+/* the vectorized loop and the scalar tail mark the same samples as the
+ * plain comparison, for widths that are not a multiple of the vector size
+ * and unaligned lines */
+GST_START_TEST (test_comb_mask)
+{
+  guint8 src1[16 + MAX_TEST_WIDTH], src2[16 + MAX_TEST_WIDTH];
+  guint8 src3[16 + MAX_TEST_WIDTH];
+  guint8 mask[MAX_TEST_WIDTH], ref[MAX_TEST_WIDTH];
+  gint width, align, round;
+  GRand *rand;
+
+  rand = g_rand_new_with_seed (7);
+
+  for (round = 0; round < 20; round++) {
+    fill_lines (rand, src1, src2, src3, sizeof (src1));
+
+    for (align = 0; align < 16; align++) {
+      for (width = 1; width <= MAX_TEST_WIDTH; width++) {
+        gboolean any, ref_any;
+
+        memset (mask, 0xff, sizeof (mask));
+        any = get_comb_mask (mask, src1 + align, src2 + align, src3 + align,
+            width);
+        ref_any = reference_comb_mask (ref, src1 + align, src2 + align,
+            src3 + align, width);
+
+        fail_unless_equals_int (any, ref_any);
+        fail_unless (memcmp (mask, ref, width) == 0);
+      }
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+/* a combed sample in the tail only is still reported */
+GST_START_TEST (test_comb_mask_tail)
+{
+  guint8 src1[MAX_TEST_WIDTH], src2[MAX_TEST_WIDTH], src3[MAX_TEST_WIDTH];
+  guint8 mask[MAX_TEST_WIDTH];
+  gint width;
+
+  for (width = 1; width <= MAX_TEST_WIDTH; width++) {
+    memset (src1, 100, width);
+    memset (src2, 100, width);
+    memset (src3, 100, width);
+
+    fail_if (get_comb_mask (mask, src1, src2, src3, width));
+
+    src2[width - 1] = 106;
+    fail_unless (get_comb_mask (mask, src1, src2, src3, width));
+    fail_unless_equals_int (mask[width - 1], 1);
+
+    src2[width - 1] = 105;
+    fail_if (get_comb_mask (mask, src1, src2, src3, width));
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+ivtc_suite (void)
+{
+  Suite *s = suite_create ("ivtc");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_comb_mask);
+  tcase_add_test (tc_chain, test_comb_mask_tail);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ivtc);
@@ -0,0 +1,274 @@
+/* GStreamer
+ *
+ * unit test for mpegpsdemux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <string.h>
+
+#define N_PACKETS 20
+#define VIDEO_PAYLOAD_SIZE 2000
+#define AUDIO_PAYLOAD_SIZE 313
+/* 40 ms in 90 kHz ticks */
+#define PTS_STEP 3600
+
+/* MPEG-2 pack header with a SCR of 0 and no stuffing */
+static const guint8 pack_header[] = {
+  0x00, 0x00, 0x01, 0xba, 0x44, 0x00, 0x04, 0x00, 0x04, 0x01, 0x00, 0x00,
+  0x07, 0xf8
+};
+
+typedef struct
+{
+  GstPad *sinkpad[2];
+  GPtrArray *buffers[2];
+} Outputs;
+
+/* payload byte @i of packet @n, never 0 so that the payloads contain no
+ * start codes */
+static guint8
+payload_byte (guint n, guint i)
+{
+  return (n * 7 + i) % 255 + 1;
+}
+
+static guint
+write_pes (guint8 * data, guint8 id, guint n, guint payload_size)
+{
+  guint64 pts = n * PTS_STEP;
+  guint length = 3 + 5 + payload_size;
+  guint i;
+
+  data[0] = 0x00;
+  data[1] = 0x00;
+  data[2] = 0x01;
+  data[3] = id;
+  GST_WRITE_UINT16_BE (data + 4, length);
+  /* MPEG-2 PES header with a PTS only */
+  data[6] = 0x80;
+  data[7] = 0x80;
+  data[8] = 5;
+  data[9] = 0x21 | ((pts >> 29) & 0x0e);
+  data[10] = (pts >> 22) & 0xff;
+  data[11] = ((pts >> 14) & 0xfe) | 0x01;
+  data[12] = (pts >> 7) & 0xff;
+  data[13] = ((pts << 1) & 0xfe) | 0x01;
+
+  for (i = 0; i < payload_size; i++)
+    data[14 + i] = payload_byte (n, i);
+
+  return 14 + payload_size;
+}
+
+/* A pack header followed by N_PACKETS video and audio PES packets,
+ * interleaved */
+static guint8 *
+create_stream (gsize * size)
+{
+  guint8 *data, *p;
+  guint n;
+
+  data = g_malloc (sizeof (pack_header) +
+      N_PACKETS * (14 + VIDEO_PAYLOAD_SIZE + 14 + AUDIO_PAYLOAD_SIZE));
+
+  memcpy (data, pack_header, sizeof (pack_header));
+  p = data + sizeof (pack_header);
+  for (n = 0; n < N_PACKETS; n++) {
+    p += write_pes (p, 0xe0, n, VIDEO_PAYLOAD_SIZE);
+    p += write_pes (p, 0xc0, n, AUDIO_PAYLOAD_SIZE);
+  }
+
+  *size = p - data;
+  return data;
+}
+
+static GstFlowReturn
+collect_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GPtrArray *buffers = g_object_get_data (G_OBJECT (pad), "buffers");
+
+  g_ptr_array_add (buffers, buffer);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+collect_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  gst_event_unref (event);
+
+  return TRUE;
+}
+
+/* links the new pad to a pad collecting its buffers, so that the demuxer
+ * keeps pushing to it */
+static void
+pad_added_cb (GstElement * element, GstPad * pad, Outputs * outputs)
+{
+  guint index;
+  GstPad *sinkpad;
+
+  if (!strcmp (GST_PAD_NAME (pad), "video_e0"))
+    index = 0;
+  else if (!strcmp (GST_PAD_NAME (pad), "audio_c0"))
+    index = 1;
+  else
+    g_assert_not_reached ();
+
+  fail_unless (outputs->sinkpad[index] == NULL);
+
+  sinkpad = gst_pad_new ("sink", GST_PAD_SINK);
+  g_object_set_data (G_OBJECT (sinkpad), "buffers", outputs->buffers[index]);
+  gst_pad_set_chain_function (sinkpad, collect_chain);
+  gst_pad_set_event_function (sinkpad, collect_event);
+  gst_pad_set_active (sinkpad, TRUE);
+  fail_unless_equals_int (gst_pad_link (pad, sinkpad), GST_PAD_LINK_OK);
+
+  outputs->sinkpad[index] = sinkpad;
+}
+
+/* Checks that the payloads of stream @index come out whole, one buffer per
+ * packet, with their timestamps. If the stream was pushed as the single
+ * buffer @input of @input_size bytes, the payloads have to be sub-buffers of
+ * it. */
+static void
+check_output (Outputs * outputs, guint index, const guint8 * input,
+    gsize input_size)
+{
+  guint payload_size = index == 0 ? VIDEO_PAYLOAD_SIZE : AUDIO_PAYLOAD_SIZE;
+  GPtrArray *buffers = outputs->buffers[index];
+  guint8 *expected;
+  guint n, i;
+
+  fail_unless_equals_int (buffers->len, N_PACKETS);
+
+  expected = g_malloc (payload_size);
+  for (n = 0; n < N_PACKETS; n++) {
+    GstBuffer *buffer = g_ptr_array_index (buffers, n);
+    GstMapInfo map;
+
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer),
+        gst_util_uint64_scale (n * PTS_STEP, GST_SECOND, 90000));
+
+    for (i = 0; i < payload_size; i++)
+      expected[i] = payload_byte (n, i);
+
+    fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+    fail_unless_equals_int (map.size, payload_size);
+    fail_unless (memcmp (map.data, expected, payload_size) == 0);
+    if (input) {
+      fail_unless_equals_int (gst_buffer_n_memory (buffer), 1);
+      fail_unless (map.data > input && map.data < input + input_size);
+    }
+    gst_buffer_unmap (buffer, &map);
+  }
+  g_free (expected);
+}
+
+/* Demuxes the stream pushed in buffers of @chunk_size bytes */
+static void
+run_split_test (gsize chunk_size)
+{
+  Outputs outputs = { {NULL, NULL}, {NULL, NULL} };
+  GstElement *element;
+  GstHarness *h;
+  guint8 *data, *input = NULL;
+  gsize size, pos;
+  guint i;
+
+  GST_INFO ("pushing in buffers of %" G_GSIZE_FORMAT " bytes", chunk_size);
+
+  for (i = 0; i < 2; i++)
+    outputs.buffers[i] =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+
+  element = gst_element_factory_make ("mpegpsdemux", NULL);
+  g_signal_connect (element, "pad-added", G_CALLBACK (pad_added_cb),
+      &outputs);
+
+  h = gst_harness_new_with_element (element, "sink", NULL);
+  gst_harness_set_src_caps_str (h,
+      "video/mpeg, mpegversion=(int)2, systemstream=(boolean)true");
+  gst_harness_play (h);
+
+  data = create_stream (&size);
+  for (pos = 0; pos < size; pos += chunk_size) {
+    gsize len = MIN (chunk_size, size - pos);
+    guint8 *chunk = g_memdup (data + pos, len);
+
+    /* the demuxer keeps the memory alive as long as its sub-buffers */
+    if (len == size)
+      input = chunk;
+
+    fail_unless_equals_int (gst_harness_push (h, gst_buffer_new_wrapped (chunk,
+                len)), GST_FLOW_OK);
+  }
+
+  fail_unless (outputs.sinkpad[0] != NULL);
+  fail_unless (outputs.sinkpad[1] != NULL);
+  check_output (&outputs, 0, input, size);
+  check_output (&outputs, 1, input, size);
+
+  gst_harness_teardown (h);
+  gst_object_unref (element);
+
+  for (i = 0; i < 2; i++) {
+    gst_object_unref (outputs.sinkpad[i]);
+    g_ptr_array_unref (outputs.buffers[i]);
+  }
+  g_free (data);
+}
+
+GST_START_TEST (test_single_buffer)
+{
+  gsize size;
+
+  g_free (create_stream (&size));
+  run_split_test (size);
+}
+
+GST_END_TEST;
+
+/* packets and their headers split across buffer boundaries anywhere come out
+ * the same */
+GST_START_TEST (test_split_packets)
+{
+  static const gsize chunk_sizes[] = { 1, 5, 7, 13, 188, 1000, 2048, 2029 };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (chunk_sizes); i++)
+    run_split_test (chunk_sizes[i]);
+}
+
+GST_END_TEST;
+
+static Suite *
+mpegpsdemux_suite (void)
+{
+  Suite *s = suite_create ("mpegpsdemux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_single_buffer);
+  tcase_add_test (tc_chain, test_split_packets);
+
+  return s;
+}
+
+GST_CHECK_MAIN (mpegpsdemux);
@@ -0,0 +1,210 @@
+/* GStreamer
+ *
+ * unit test for mpegpsmux
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/base/gstadapter.h>
+#include <string.h>
+
+#define VIDEO_CAPS_STRING "video/mpeg, mpegversion = (int) 2, " \
+    "systemstream = (boolean) false"
+
+/* 10 frames at 25 fps, each frame filled with its index */
+#define N_FRAMES 10
+#define FRAME_SIZE 3000
+#define FRAME_DURATION (GST_SECOND / 25)
+
+static GstHarness *
+setup_mpegpsmux (guint packs_per_buffer)
+{
+  GstHarness *h;
+
+  h = gst_harness_new_with_padnames ("mpegpsmux", "sink_%u", "src");
+  g_object_set (h->element, "packs-per-buffer", packs_per_buffer, NULL);
+  gst_harness_set_src_caps_str (h, VIDEO_CAPS_STRING);
+
+  return h;
+}
+
+static GstBuffer *
+create_frame (guint i)
+{
+  GstBuffer *buffer;
+
+  buffer = gst_buffer_new_allocate (NULL, FRAME_SIZE, NULL);
+  gst_buffer_memset (buffer, 0, i, FRAME_SIZE);
+  GST_BUFFER_PTS (buffer) = GST_BUFFER_DTS (buffer) = i * FRAME_DURATION;
+  GST_BUFFER_DURATION (buffer) = FRAME_DURATION;
+  if (i > 0)
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  return buffer;
+}
+
+/* walks the packs of the muxed stream and returns the payload of the
+ * video PES packets */
+static GByteArray *
+extract_video_payload (const guint8 * data, gsize size)
+{
+  GByteArray *payload = g_byte_array_new ();
+  gsize pos = 0;
+
+  fail_unless (size >= 4);
+  fail_unless_equals_int (GST_READ_UINT32_BE (data), 0x000001ba);
+
+  while (pos + 4 <= size) {
+    guint8 stream_id;
+    guint len;
+
+    fail_unless_equals_int (GST_READ_UINT24_BE (data + pos), 0x000001);
+    stream_id = data[pos + 3];
+
+    if (stream_id == 0xb9) {
+      /* program end code, the last thing in the stream */
+      fail_unless_equals_int (pos + 4, size);
+      return payload;
+    } else if (stream_id == 0xba) {
+      fail_unless (pos + 14 <= size);
+      pos += 14 + (data[pos + 13] & 0x07);
+      continue;
+    }
+
+    fail_unless (pos + 6 <= size);
+    len = 6 + GST_READ_UINT16_BE (data + pos + 4);
+    fail_unless (pos + len <= size);
+
+    if (stream_id >= 0xe0 && stream_id <= 0xef) {
+      guint hdr_len;
+
+      fail_unless_equals_int (stream_id, 0xe0);
+      fail_unless_equals_int (data[pos + 6] & 0xc0, 0x80);
+      hdr_len = 9 + data[pos + 8];
+      fail_unless (hdr_len <= len);
+      g_byte_array_append (payload, data + pos + hdr_len, len - hdr_len);
+    }
+    pos += len;
+  }
+
+  fail ("no program end code");
+  return payload;
+}
+
+static void
+check_muxed_stream (GstHarness * h)
+{
+  GstAdapter *adapter = gst_adapter_new ();
+  GstBuffer *buffer;
+  GByteArray *payload;
+  const guint8 *data;
+  gsize size;
+  guint i, j;
+
+  while ((buffer = gst_harness_try_pull (h)))
+    gst_adapter_push (adapter, buffer);
+
+  size = gst_adapter_available (adapter);
+  data = gst_adapter_map (adapter, size);
+  payload = extract_video_payload (data, size);
+  gst_adapter_unmap (adapter);
+  g_object_unref (adapter);
+
+  /* all the frames are in the video PES packets, in order */
+  fail_unless_equals_int (payload->len, N_FRAMES * FRAME_SIZE);
+  for (i = 0; i < N_FRAMES; i++) {
+    for (j = 0; j < FRAME_SIZE; j++) {
+      if (payload->data[i * FRAME_SIZE + j] != i)
+        fail ("frame %u corrupted at byte %u", i, j);
+    }
+  }
+
+  g_byte_array_unref (payload);
+}
+
+static void
+run_mux_test (guint packs_per_buffer)
+{
+  GstHarness *h;
+  guint i;
+
+  h = setup_mpegpsmux (packs_per_buffer);
+
+  for (i = 0; i < N_FRAMES; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_frame (i)),
+        GST_FLOW_OK);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+
+  check_muxed_stream (h);
+
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_mux)
+{
+  run_mux_test (0);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_mux_packs_per_buffer)
+{
+  run_mux_test (1);
+  run_mux_test (4);
+}
+
+GST_END_TEST;
+
+static void
+run_flushing_test (guint packs_per_buffer)
+{
+  GstHarness *h;
+
+  h = setup_mpegpsmux (packs_per_buffer);
+
+  /* a flushing downstream is reported upstream instead of dropping data */
+  gst_pad_set_active (h->sinkpad, FALSE);
+  fail_unless_equals_int (gst_harness_push (h, create_frame (0)),
+      GST_FLOW_FLUSHING);
+
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_downstream_flushing)
+{
+  run_flushing_test (0);
+  run_flushing_test (1);
+}
+
+GST_END_TEST;
+
+static Suite *
+mpegpsmux_suite (void)
+{
+  Suite *s = suite_create ("mpegpsmux");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_mux);
+  tcase_add_test (tc_chain, test_mux_packs_per_buffer);
+  tcase_add_test (tc_chain, test_downstream_flushing);
+
+  return s;
+}
+
+GST_CHECK_MAIN (mpegpsmux);
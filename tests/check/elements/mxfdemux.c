@@ -29,6 +29,62 @@ static GMainLoop *loop = NULL;
 static gboolean have_eos = FALSE;
 static gboolean have_data = FALSE;
 
+/* mxf_file as it looks while being recorded: open header partition without
+ * footer partition offset, and only written up to the footer partition */
+#define GROWING_FILE_FOOTER_OFFSET 20031
+/* last byte of the IndexDuration of the index table segment in the footer */
+#define GROWING_FILE_INDEX_DURATION_OFFSET 20246
+static guint8 *growing_file = NULL;
+static gsize growing_file_size = 0;
+
+/* mxf_file with a descriptive metadata track added to its material package.
+ * The UID of the track is appended to the track batch of the material
+ * package, and the static track, its sequence, a DM segment and the DMS-1
+ * production framework it refers to take the start of the KLV fill item */
+#define DM_FILE_PACKAGE_OFFSET 1886
+#define DM_FILE_PACKAGE_SIZE 164
+#define DM_FILE_TRACKS_OFFSET 2006
+#define DM_FILE_TRACKS_SIZE 40
+#define DM_FILE_FILL_OFFSET 4137
+#define DM_FILE_FILL_SIZE 15838
+
+static const guint8 dm_track_uid[] = {
+  0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1,
+  0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1,
+};
+
+static const guint8 dm_sets[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x53, 0x01, 0x01, 0x0d, 0x01, 0x01, 0x01,
+  0x01, 0x01, 0x3a, 0x00, 0x83, 0x00, 0x00, 0x38, 0x3c, 0x0a, 0x00, 0x10,
+  0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1, 0xd1,
+  0xd1, 0xd1, 0xd1, 0xd1, 0x48, 0x01, 0x00, 0x04, 0x00, 0x00, 0x00, 0x03,
+  0x48, 0x04, 0x00, 0x04, 0x00, 0x00, 0x00, 0x00, 0x48, 0x03, 0x00, 0x10,
+  0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2,
+  0xd2, 0xd2, 0xd2, 0xd2, 0x06, 0x0e, 0x2b, 0x34, 0x02, 0x53, 0x01, 0x01,
+  0x0d, 0x01, 0x01, 0x01, 0x01, 0x01, 0x0f, 0x00, 0x83, 0x00, 0x00, 0x50,
+  0x3c, 0x0a, 0x00, 0x10, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2,
+  0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0xd2, 0x02, 0x01, 0x00, 0x10,
+  0x06, 0x0e, 0x2b, 0x34, 0x04, 0x01, 0x01, 0x01, 0x01, 0x03, 0x02, 0x01,
+  0x10, 0x00, 0x00, 0x00, 0x02, 0x02, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x01, 0x10, 0x01, 0x00, 0x18, 0x00, 0x00, 0x00, 0x01,
+  0x00, 0x00, 0x00, 0x10, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3,
+  0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0x06, 0x0e, 0x2b, 0x34,
+  0x02, 0x53, 0x01, 0x01, 0x0d, 0x01, 0x01, 0x01, 0x01, 0x01, 0x41, 0x00,
+  0x83, 0x00, 0x00, 0x6a, 0x3c, 0x0a, 0x00, 0x10, 0xd3, 0xd3, 0xd3, 0xd3,
+  0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3, 0xd3,
+  0x02, 0x01, 0x00, 0x10, 0x06, 0x0e, 0x2b, 0x34, 0x04, 0x01, 0x01, 0x01,
+  0x01, 0x03, 0x02, 0x01, 0x10, 0x00, 0x00, 0x00, 0x02, 0x02, 0x00, 0x08,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x06, 0x01, 0x00, 0x08,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x06, 0x02, 0x00, 0x12,
+  0x00, 0x47, 0x00, 0x53, 0x00, 0x74, 0x00, 0x72, 0x00, 0x65, 0x00, 0x61,
+  0x00, 0x6d, 0x00, 0x65, 0x00, 0x72, 0x61, 0x01, 0x00, 0x10, 0xd4, 0xd4,
+  0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4,
+  0xd4, 0xd4, 0x06, 0x0e, 0x2b, 0x34, 0x02, 0x53, 0x01, 0x01, 0x0d, 0x01,
+  0x04, 0x01, 0x01, 0x01, 0x01, 0x00, 0x83, 0x00, 0x00, 0x14, 0x3c, 0x0a,
+  0x00, 0x10, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4,
+  0xd4, 0xd4, 0xd4, 0xd4, 0xd4, 0xd4,
+};
+
 static GstStaticPadTemplate mysrctemplate =
 GST_STATIC_PAD_TEMPLATE ("src", GST_PAD_SRC, GST_PAD_ALWAYS,
     GST_STATIC_CAPS ("application/mxf"));
@@ -174,6 +230,40 @@ _src_query (GstPad * pad, GstObject * parent, GstQuery * query)
   return res;
 }
 
+static GstFlowReturn
+_src_getrange_growing (GstPad * pad, GstObject * parent, guint64 offset,
+    guint length, GstBuffer ** buffer)
+{
+  if (offset + length > growing_file_size) {
+    /* the rest of the file is written once the essence was read, and is
+     * there for the next read */
+    if (have_data)
+      growing_file_size = sizeof (mxf_file);
+    return GST_FLOW_EOS;
+  }
+
+  *buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      growing_file + offset, length, 0, length, NULL, NULL);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+_src_query_growing (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstFormat fmt;
+
+  if (GST_QUERY_TYPE (query) != GST_QUERY_DURATION)
+    return _src_query (pad, parent, query);
+
+  gst_query_parse_duration (query, &fmt, NULL);
+  if (fmt != GST_FORMAT_BYTES)
+    return FALSE;
+
+  gst_query_set_duration (query, fmt, growing_file_size);
+  return TRUE;
+}
+
 static GstPad *
 _create_src_pad_pull (void)
 {
@@ -232,6 +322,196 @@ GST_START_TEST (test_pull)
 
 GST_END_TEST;
 
+GST_START_TEST (test_pull_growing)
+{
+  GstStateChangeReturn sret;
+  GstElement *mxfdemux;
+  GstMessage *msg;
+  GstPad *sinkpad;
+  GstBus *bus;
+  gint64 duration;
+
+  have_eos = FALSE;
+  have_data = FALSE;
+  loop = g_main_loop_new (NULL, FALSE);
+
+  growing_file = g_memdup (mxf_file, sizeof (mxf_file));
+  /* open incomplete header partition */
+  growing_file[14] = 0x01;
+  /* that does not know where the footer partition will be */
+  memset (growing_file + 44, 0, 8);
+  /* and whose index covers more than the metadata duration */
+  growing_file[GROWING_FILE_INDEX_DURATION_OFFSET] = 3;
+  growing_file_size = GROWING_FILE_FOOTER_OFFSET;
+
+  mxfdemux = gst_element_factory_make ("mxfdemux", NULL);
+  fail_unless (mxfdemux != NULL);
+  bus = gst_bus_new ();
+  gst_element_set_bus (mxfdemux, bus);
+  g_signal_connect (mxfdemux, "pad-added", G_CALLBACK (_pad_added), NULL);
+  sinkpad = gst_element_get_static_pad (mxfdemux, "sink");
+  fail_unless (sinkpad != NULL);
+
+  mysinkpad = _create_sink_pad ();
+  fail_unless (mysinkpad != NULL);
+  mysrcpad = gst_pad_new_from_static_template (&mysrctemplate, "src");
+  gst_pad_set_getrange_function (mysrcpad, _src_getrange_growing);
+  gst_pad_set_query_function (mysrcpad, _src_query_growing);
+
+  fail_unless (gst_pad_link (mysrcpad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_pad_set_active (mysinkpad, TRUE);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  sret = gst_element_set_state (mxfdemux, GST_STATE_PLAYING);
+  fail_unless_equals_int (sret, GST_STATE_CHANGE_SUCCESS);
+
+  g_main_loop_run (loop);
+  fail_unless (have_eos == TRUE);
+  fail_unless (have_data == TRUE);
+  fail_unless_equals_int (growing_file_size, sizeof (mxf_file));
+
+  /* the footer index written after the essence extended the duration */
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_DURATION_CHANGED);
+  fail_unless (msg != NULL);
+  gst_message_unref (msg);
+
+  sinkpad = gst_pad_get_peer (mysinkpad);
+  fail_unless (gst_pad_query_duration (sinkpad, GST_FORMAT_TIME, &duration));
+  fail_unless_equals_uint64 (duration, 3 * 200 * GST_MSECOND);
+  gst_object_unref (sinkpad);
+
+  gst_element_set_state (mxfdemux, GST_STATE_NULL);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_pad_set_active (mysrcpad, FALSE);
+
+  gst_element_set_bus (mxfdemux, NULL);
+  gst_object_unref (bus);
+  gst_object_unref (mxfdemux);
+  gst_object_unref (mysinkpad);
+  gst_object_unref (mysrcpad);
+  g_main_loop_unref (loop);
+  loop = NULL;
+  g_free (growing_file);
+  growing_file = NULL;
+}
+
+GST_END_TEST;
+
+static guint8 *
+_create_dm_file (void)
+{
+  guint8 *data = g_memdup (mxf_file, sizeof (mxf_file));
+  guint tracks_end = DM_FILE_TRACKS_OFFSET + 4 + DM_FILE_TRACKS_SIZE;
+  guint fill_offset;
+
+  /* make room for the track UID */
+  memcpy (data + tracks_end + sizeof (dm_track_uid), mxf_file + tracks_end,
+      DM_FILE_FILL_OFFSET - tracks_end);
+  memcpy (data + tracks_end, dm_track_uid, sizeof (dm_track_uid));
+  GST_WRITE_UINT24_BE (data + DM_FILE_PACKAGE_OFFSET + 17,
+      DM_FILE_PACKAGE_SIZE + sizeof (dm_track_uid));
+  GST_WRITE_UINT16_BE (data + DM_FILE_TRACKS_OFFSET + 2,
+      DM_FILE_TRACKS_SIZE + sizeof (dm_track_uid));
+  GST_WRITE_UINT32_BE (data + DM_FILE_TRACKS_OFFSET + 4,
+      GST_READ_UINT32_BE (data + DM_FILE_TRACKS_OFFSET + 4) + 1);
+
+  /* and for the new sets, shrinking the fill item accordingly */
+  fill_offset = DM_FILE_FILL_OFFSET + sizeof (dm_track_uid);
+  memcpy (data + fill_offset, dm_sets, sizeof (dm_sets));
+  fill_offset += sizeof (dm_sets);
+  memcpy (data + fill_offset, mxf_file + DM_FILE_FILL_OFFSET, 17);
+  GST_WRITE_UINT24_BE (data + fill_offset + 17,
+      DM_FILE_FILL_SIZE - sizeof (dm_track_uid) - sizeof (dm_sets));
+
+  return data;
+}
+
+/* plays the DM file in pull mode and returns the structure property */
+static GstStructure *
+_get_dm_file_structure (gboolean lazy)
+{
+  GstStateChangeReturn sret;
+  GstElement *mxfdemux;
+  GstStructure *s;
+  GstPad *sinkpad;
+
+  have_eos = FALSE;
+  have_data = FALSE;
+  loop = g_main_loop_new (NULL, FALSE);
+
+  /* served complete from the start */
+  growing_file = _create_dm_file ();
+  growing_file_size = sizeof (mxf_file);
+
+  mxfdemux = gst_element_factory_make ("mxfdemux", NULL);
+  fail_unless (mxfdemux != NULL);
+  g_object_set (mxfdemux, "lazy-descriptive-metadata", lazy, NULL);
+  g_signal_connect (mxfdemux, "pad-added", G_CALLBACK (_pad_added), NULL);
+  sinkpad = gst_element_get_static_pad (mxfdemux, "sink");
+  fail_unless (sinkpad != NULL);
+
+  mysinkpad = _create_sink_pad ();
+  fail_unless (mysinkpad != NULL);
+  mysrcpad = gst_pad_new_from_static_template (&mysrctemplate, "src");
+  gst_pad_set_getrange_function (mysrcpad, _src_getrange_growing);
+  gst_pad_set_query_function (mysrcpad, _src_query_growing);
+
+  fail_unless (gst_pad_link (mysrcpad, sinkpad) == GST_PAD_LINK_OK);
+  gst_object_unref (sinkpad);
+
+  gst_pad_set_active (mysinkpad, TRUE);
+  gst_pad_set_active (mysrcpad, TRUE);
+
+  sret = gst_element_set_state (mxfdemux, GST_STATE_PLAYING);
+  fail_unless_equals_int (sret, GST_STATE_CHANGE_SUCCESS);
+
+  g_main_loop_run (loop);
+  fail_unless (have_eos == TRUE);
+  fail_unless (have_data == TRUE);
+
+  g_object_get (mxfdemux, "structure", &s, NULL);
+  fail_unless (s != NULL);
+
+  gst_element_set_state (mxfdemux, GST_STATE_NULL);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_pad_set_active (mysrcpad, FALSE);
+
+  gst_object_unref (mxfdemux);
+  gst_object_unref (mysinkpad);
+  gst_object_unref (mysrcpad);
+  g_main_loop_unref (loop);
+  loop = NULL;
+  g_free (growing_file);
+  growing_file = NULL;
+
+  return s;
+}
+
+GST_START_TEST (test_pull_lazy_descriptive_metadata)
+{
+  GstStructure *eager, *lazy;
+  gchar *str;
+
+  eager = _get_dm_file_structure (FALSE);
+  lazy = _get_dm_file_structure (TRUE);
+
+  /* the descriptive metadata track is there either way */
+  str = gst_structure_to_string (lazy);
+  fail_unless (strstr (str, "dm-segment") != NULL, "no DM segment in %s", str);
+  fail_unless (strstr (str, "GStreamer") != NULL, "no event comment in %s",
+      str);
+  g_free (str);
+
+  fail_unless (gst_structure_is_equal (eager, lazy));
+
+  gst_structure_free (eager);
+  gst_structure_free (lazy);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_push)
 {
   GstElement *mxfdemux;
@@ -301,6 +581,8 @@ mxfdemux_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_set_timeout (tc_chain, 180);
   tcase_add_test (tc_chain, test_pull);
+  tcase_add_test (tc_chain, test_pull_growing);
+  tcase_add_test (tc_chain, test_pull_lazy_descriptive_metadata);
   tcase_add_test (tc_chain, test_push);
 
   return s;
@@ -65,18 +65,13 @@ on_message_cb (GstBus * bus, GstMessage * message, gpointer user_data)
 }
 
 static void
-run_test (const gchar * pipeline_string)
+run_pipeline (GstElement * pipeline)
 {
-  GstElement *pipeline;
   GstBus *bus;
   GMainLoop *loop;
   OnMessageUserData omud = { NULL, };
   GstStateChangeReturn ret;
 
-  GST_DEBUG ("Testing pipeline '%s'", pipeline_string);
-
-  pipeline = gst_parse_launch (pipeline_string, NULL);
-  fail_unless (pipeline != NULL);
   g_object_set (G_OBJECT (pipeline), "async-handling", TRUE, NULL);
 
   loop = g_main_loop_new (NULL, FALSE);
@@ -101,12 +96,25 @@ run_test (const gchar * pipeline_string)
 
   fail_unless (omud.eos == TRUE);
 
-  gst_object_unref (pipeline);
   g_main_loop_unref (loop);
   gst_bus_remove_signal_watch (bus);
   gst_object_unref (bus);
 }
 
+static void
+run_test (const gchar * pipeline_string)
+{
+  GstElement *pipeline;
+
+  GST_DEBUG ("Testing pipeline '%s'", pipeline_string);
+
+  pipeline = gst_parse_launch (pipeline_string, NULL);
+  fail_unless (pipeline != NULL);
+
+  run_pipeline (pipeline);
+  gst_object_unref (pipeline);
+}
+
 GST_START_TEST (test_mpeg2)
 {
   const gchar *mpeg2enc_name = get_mpeg2enc_element_name ();
@@ -265,6 +273,67 @@ GST_START_TEST (test_h264_raw_audio)
 
 GST_END_TEST;
 
+static const guint8 random_index_pack_key[] = {
+  0x06, 0x0e, 0x2b, 0x34, 0x02, 0x05, 0x01, 0x01,
+  0x0d, 0x01, 0x02, 0x01, 0x01, 0x11, 0x01, 0x00
+};
+
+static void
+on_handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gpointer user_data)
+{
+  GArray *partitions = user_data;
+  GstMapInfo map;
+  guint i;
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  if (map.size > 17 && memcmp (map.data, random_index_pack_key, 16) == 0) {
+    /* short BER length, then a body SID and an offset per partition and
+     * the overall length */
+    fail_unless (map.data[16] < 0x80);
+    fail_unless_equals_int (map.size, 17 + map.data[16]);
+    for (i = 17; i + 12 <= map.size; i += 12) {
+      guint64 offset = GST_READ_UINT64_BE (map.data + i + 4);
+
+      g_array_append_val (partitions, offset);
+    }
+  }
+  gst_buffer_unmap (buffer, &map);
+}
+
+GST_START_TEST (test_partition_interval)
+{
+  GstElement *pipeline, *sink;
+  GArray *partitions;
+  guint i;
+
+  /* 10 s of intra-only video, a body partition every 2 s */
+  pipeline = gst_parse_launch ("videotestsrc num-buffers=250 ! "
+      "video/x-raw,format=(string)v308,width=64,height=48,framerate=25/1 ! "
+      "mxfmux partition-interval=2000000000 ! "
+      "fakesink name=sink signal-handoffs=true", NULL);
+  fail_unless (pipeline != NULL);
+
+  partitions = g_array_new (FALSE, FALSE, sizeof (guint64));
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", (GCallback) on_handoff_cb, partitions);
+  gst_object_unref (sink);
+
+  run_pipeline (pipeline);
+  gst_object_unref (pipeline);
+
+  /* header, first body partition, one at 2, 4, 6 and 8 s, and footer */
+  fail_unless_equals_int (partitions->len, 7);
+  fail_unless_equals_uint64 (g_array_index (partitions, guint64, 0), 0);
+  for (i = 1; i < partitions->len; i++)
+    fail_unless (g_array_index (partitions, guint64, i) >
+        g_array_index (partitions, guint64, i - 1));
+
+  g_array_unref (partitions);
+}
+
+GST_END_TEST;
+
 static Suite *
 mxfmux_suite (void)
 {
@@ -281,6 +350,7 @@ mxfmux_suite (void)
   tcase_add_test (tc_chain, test_dnxhd_mp3);
   tcase_add_test (tc_chain, test_h264_raw_audio);
   tcase_add_test (tc_chain, test_multiple_av_streams);
+  tcase_add_test (tc_chain, test_partition_interval);
 
   return s;
 }
@@ -2,6 +2,9 @@
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstharness.h>
 
+#include <stdio.h>
+#include <string.h>
+
 static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
@@ -115,6 +118,224 @@ GST_START_TEST (test_parse_zerosize_frames)
 
 GST_END_TEST;
 
+/* pcapng with nanosecond timestamps and UDP packets in 802.1Q tagged
+ * Ethernet frames, each with a 4 byte payload */
+#define PCAPNG_PACKET_SIZE (14 + 4 + 20 + 8 + 4)
+
+static gsize
+write_pcapng (guint8 * data, const guint16 * dst_ports, guint n_packets)
+{
+  guint8 *p = data;
+  guint i;
+
+  /* section header block */
+  GST_WRITE_UINT32_LE (p, 0x0a0d0d0a);
+  GST_WRITE_UINT32_LE (p + 4, 28);
+  GST_WRITE_UINT32_LE (p + 8, 0x1a2b3c4d);
+  GST_WRITE_UINT16_LE (p + 12, 1);
+  GST_WRITE_UINT16_LE (p + 14, 0);
+  GST_WRITE_UINT64_LE (p + 16, G_GUINT64_CONSTANT (0xffffffffffffffff));
+  GST_WRITE_UINT32_LE (p + 24, 28);
+  p += 28;
+
+  /* interface description block with if_tsresol of nanoseconds */
+  GST_WRITE_UINT32_LE (p, 0x00000001);
+  GST_WRITE_UINT32_LE (p + 4, 32);
+  GST_WRITE_UINT16_LE (p + 8, 1);
+  GST_WRITE_UINT16_LE (p + 10, 0);
+  GST_WRITE_UINT32_LE (p + 12, 65535);
+  GST_WRITE_UINT16_LE (p + 16, 9);
+  GST_WRITE_UINT16_LE (p + 18, 1);
+  GST_WRITE_UINT32_LE (p + 20, 9);
+  GST_WRITE_UINT32_LE (p + 24, 0);
+  GST_WRITE_UINT32_LE (p + 28, 32);
+  p += 32;
+
+  for (i = 0; i < n_packets; i++) {
+    guint64 ts = GST_SECOND + i * 500;
+    guint block_len = 28 + GST_ROUND_UP_4 (PCAPNG_PACKET_SIZE) + 4;
+    guint8 *pkt;
+
+    /* enhanced packet block */
+    memset (p, 0, block_len);
+    GST_WRITE_UINT32_LE (p, 0x00000006);
+    GST_WRITE_UINT32_LE (p + 4, block_len);
+    GST_WRITE_UINT32_LE (p + 8, 0);
+    GST_WRITE_UINT32_LE (p + 12, ts >> 32);
+    GST_WRITE_UINT32_LE (p + 16, ts & 0xffffffff);
+    GST_WRITE_UINT32_LE (p + 20, PCAPNG_PACKET_SIZE);
+    GST_WRITE_UINT32_LE (p + 24, PCAPNG_PACKET_SIZE);
+
+    /* Ethernet with a VLAN tag */
+    pkt = p + 28;
+    GST_WRITE_UINT16_BE (pkt + 12, 0x8100);
+    GST_WRITE_UINT16_BE (pkt + 14, 42);
+    GST_WRITE_UINT16_BE (pkt + 16, 0x0800);
+    pkt += 18;
+
+    /* IPv4 */
+    pkt[0] = 0x45;
+    GST_WRITE_UINT16_BE (pkt + 2, 20 + 8 + 4);
+    pkt[8] = 64;
+    pkt[9] = 17;
+    GST_WRITE_UINT32_BE (pkt + 12, 0xc0a80001);
+    GST_WRITE_UINT32_BE (pkt + 16, 0xe0000001);
+    pkt += 20;
+
+    /* UDP */
+    GST_WRITE_UINT16_BE (pkt, 4000);
+    GST_WRITE_UINT16_BE (pkt + 2, dst_ports[i]);
+    GST_WRITE_UINT16_BE (pkt + 4, 8 + 4);
+    pkt += 8;
+
+    GST_WRITE_UINT32_BE (pkt, i);
+
+    GST_WRITE_UINT32_LE (p + block_len - 4, block_len);
+    p += block_len;
+  }
+
+  return p - data;
+}
+
+GST_START_TEST (test_parse_pcapng_vlan)
+{
+  static const guint16 dst_ports[] = { 5000, 5000 };
+  GstBuffer *in_buf, *out_buf;
+  GstHarness *h;
+  guint8 data[512];
+  gsize size;
+  guint i;
+
+  size = write_pcapng (data, dst_ports, G_N_ELEMENTS (dst_ports));
+
+  h = gst_harness_new ("pcapparse");
+  gst_harness_set_src_caps_str (h, "raw/x-pcap");
+  gst_harness_play (h);
+
+  /* split in the middle of a block */
+  in_buf = gst_buffer_new_wrapped (g_memdup (data, 70), 70);
+  fail_unless_equals_int (gst_harness_push (h, in_buf), GST_FLOW_OK);
+  in_buf = gst_buffer_new_wrapped (g_memdup (data + 70, size - 70),
+      size - 70);
+  fail_unless_equals_int (gst_harness_push (h, in_buf), GST_FLOW_OK);
+
+  for (i = 0; i < G_N_ELEMENTS (dst_ports); i++) {
+    out_buf = gst_harness_pull (h);
+    fail_unless_equals_int (gst_buffer_get_size (out_buf), 4);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (out_buf), GST_SECOND + i * 500);
+    gst_buffer_unref (out_buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_parse_ts_offset)
+{
+  static const guint16 dst_ports[] = { 5000, 5000 };
+  const GstSegment *segment;
+  GstBuffer *in_buf, *out_buf;
+  GstEvent *event;
+  GstHarness *h;
+  guint8 data[512];
+  gsize size;
+  guint i;
+
+  size = write_pcapng (data, dst_ports, G_N_ELEMENTS (dst_ports));
+
+  h = gst_harness_new_parse ("pcapparse ts-offset=0");
+  gst_harness_set_src_caps_str (h, "raw/x-pcap");
+  gst_harness_play (h);
+
+  in_buf = gst_buffer_new_wrapped (g_memdup (data, size), size);
+  fail_unless_equals_int (gst_harness_push (h, in_buf), GST_FLOW_OK);
+
+  /* the segment starts where the rebased timestamps do */
+  while ((event = gst_harness_pull_event (h))) {
+    if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT)
+      break;
+    gst_event_unref (event);
+  }
+  fail_unless (event != NULL);
+  gst_event_parse_segment (event, &segment);
+  fail_unless_equals_int (segment->format, GST_FORMAT_TIME);
+  fail_unless_equals_uint64 (segment->start, 0);
+  gst_event_unref (event);
+
+  for (i = 0; i < G_N_ELEMENTS (dst_ports); i++) {
+    out_buf = gst_harness_pull (h);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (out_buf), i * 500);
+    gst_buffer_unref (out_buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+static GstPadProbeReturn
+count_buffers_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  guint *n_buffers = user_data;
+
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST)
+    *n_buffers +=
+        gst_buffer_list_length (GST_PAD_PROBE_INFO_BUFFER_LIST (info));
+  else
+    *n_buffers += 1;
+
+  return GST_PAD_PROBE_DROP;
+}
+
+static void
+flow_pad_added_cb (GstElement * element, GstPad * pad, guint * n_buffers)
+{
+  guint index;
+
+  fail_unless (sscanf (GST_PAD_NAME (pad), "src_%u", &index) == 1);
+  fail_unless (index < 2);
+
+  gst_pad_add_probe (pad,
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+      count_buffers_probe, &n_buffers[index], NULL);
+}
+
+GST_START_TEST (test_demux_flows)
+{
+  static const guint16 dst_ports[] = { 5000, 5002, 5000 };
+  guint n_buffers[2] = { 0, 0 };
+  GstElement *element;
+  GstBuffer *in_buf;
+  GstHarness *h;
+  guint8 data[512];
+  gsize size;
+
+  size = write_pcapng (data, dst_ports, G_N_ELEMENTS (dst_ports));
+
+  element = gst_element_factory_make ("pcapparse", NULL);
+  g_object_set (element, "demux", TRUE, NULL);
+  g_signal_connect (element, "pad-added", G_CALLBACK (flow_pad_added_cb),
+      n_buffers);
+
+  h = gst_harness_new_with_element (element, "sink", NULL);
+  gst_harness_set_src_caps_str (h, "raw/x-pcap");
+  gst_harness_play (h);
+
+  in_buf = gst_buffer_new_wrapped (g_memdup (data, size), size);
+  fail_unless_equals_int (gst_harness_push (h, in_buf), GST_FLOW_OK);
+
+  /* one pad per flow, in a single pass */
+  fail_unless_equals_int (element->numsrcpads, 3);
+  fail_unless_equals_int (n_buffers[0], 2);
+  fail_unless_equals_int (n_buffers[1], 1);
+
+  gst_harness_teardown (h);
+  gst_object_unref (element);
+}
+
+GST_END_TEST;
+
 static Suite *
 pcapparse_suite (void)
 {
@@ -133,6 +354,9 @@ pcapparse_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_parse_frames_with_eth_padding);
   tcase_add_test (tc_chain, test_parse_zerosize_frames);
+  tcase_add_test (tc_chain, test_parse_pcapng_vlan);
+  tcase_add_test (tc_chain, test_parse_ts_offset);
+  tcase_add_test (tc_chain, test_demux_flows);
 
   return s;
 }
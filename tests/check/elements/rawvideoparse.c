@@ -26,6 +26,8 @@
 
 #include <gst/check/gstcheck.h>
 #include <gst/video/video.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
 
 /* The checks use as test data an 8x8 Y444 image, with 25 Hz framerate. In the
  * sink caps configuration, the stride is 8 bytes, and the frames are tightly
@@ -607,6 +609,74 @@ GST_START_TEST (test_change_caps)
 
 GST_END_TEST;
 
+static void
+mmap_handoff_cb (GstElement * sink, GstBuffer * buffer, GstPad * pad,
+    gint * n_frames)
+{
+  GstMemory *mem = gst_buffer_peek_memory (buffer, 0);
+  GstMapInfo map;
+
+  /* the frames wrap the read-only mapping of the file */
+  fail_unless (GST_MEMORY_FLAG_IS_SET (mem, GST_MEMORY_FLAG_READONLY));
+  fail_unless_equals_int (gst_buffer_get_size (buffer), 16 * 16);
+
+  gst_buffer_map (buffer, &map, GST_MAP_READ);
+  fail_unless_equals_int (map.data[0], *n_frames);
+  fail_unless_equals_int (map.data[map.size - 1], *n_frames);
+  gst_buffer_unmap (buffer, &map);
+
+  (*n_frames)++;
+}
+
+GST_START_TEST (test_pull_mmap)
+{
+  GstElement *pipeline, *sink;
+  GstBus *bus;
+  GstMessage *msg;
+  guint8 data[16 * 16 * 10];
+  gchar *location, *desc;
+  gint fd, n_frames = 0;
+  guint i;
+
+  /* ten 16x16 GRAY8 frames, each filled with its frame number */
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = i / (16 * 16);
+
+  fd = g_file_open_tmp ("rawvideoparse-XXXXXX.raw", &location, NULL);
+  fail_unless (fd != -1);
+  fail_unless_equals_int (write (fd, data, sizeof (data)), sizeof (data));
+  close (fd);
+
+  desc = g_strdup_printf ("filesrc location=\"%s\" ! rawvideoparse "
+      "use-mmap=true format=gray8 width=16 height=16 ! "
+      "fakesink name=sink signal-handoffs=true", location);
+  pipeline = gst_parse_launch (desc, NULL);
+  g_free (desc);
+  fail_unless (pipeline != NULL);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (mmap_handoff_cb), &n_frames);
+  gst_object_unref (sink);
+
+  fail_if (gst_element_set_state (pipeline,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  fail_unless_equals_int (n_frames, 10);
+
+  g_unlink (location);
+  g_free (location);
+}
+
+GST_END_TEST;
 
 static Suite *
 rawvideoparse_suite (void)
@@ -621,6 +691,7 @@ rawvideoparse_suite (void)
   tcase_add_test (tc_chain, test_push_with_no_framerate);
   tcase_add_test (tc_chain, test_computed_plane_strides);
   tcase_add_test (tc_chain, test_change_caps);
+  tcase_add_test (tc_chain, test_pull_mmap);
 
   return s;
 }
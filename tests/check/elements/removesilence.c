@@ -0,0 +1,333 @@
+/* GStreamer
+ *
+ * unit test for removesilence
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <math.h>
+#include <string.h>
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define FORMAT_NE(f) f "LE"
+#else
+#define FORMAT_NE(f) f "BE"
+#endif
+
+#define RATE 8000
+#define N_FRAMES 2048
+#define BUFFER_DURATION (N_FRAMES * GST_SECOND / RATE)
+/* the VADs decide once per block of this many frames */
+#define BLOCK_DURATION (256 * GST_SECOND / RATE)
+
+/* amplitude of a square wave of @db dB of full scale */
+#define DB(db) pow (10, (db) / 20.0)
+
+static GstHarness *
+setup_removesilence (const gchar * format, gint channels,
+    gboolean per_channel, GstBus ** bus)
+{
+  GstHarness *h;
+
+  h = gst_harness_new ("removesilence");
+  g_object_set (h->element, "silent", FALSE, "per-channel", per_channel,
+      NULL);
+  gst_harness_set_src_caps (h, gst_caps_new_simple ("audio/x-raw",
+          "format", G_TYPE_STRING, format, "layout", G_TYPE_STRING,
+          "interleaved", "rate", G_TYPE_INT, RATE, "channels", G_TYPE_INT,
+          channels, NULL));
+
+  *bus = gst_bus_new ();
+  gst_element_set_bus (h->element, *bus);
+
+  return h;
+}
+
+static void
+teardown_removesilence (GstHarness * h, GstBus * bus)
+{
+  /* every transition has been checked */
+  fail_unless (gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT) == NULL);
+
+  gst_element_set_bus (h->element, NULL);
+  gst_object_unref (bus);
+  gst_harness_teardown (h);
+}
+
+/* Pushes buffer @index of the stream, a square wave with a period of 40
+ * frames and the amplitude @amp[c] on channel c, or silence where it is 0 */
+static void
+push_square (GstHarness * h, const gchar * format, gint channels,
+    guint index, const gdouble * amp)
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  gint i, c;
+
+  if (!strcmp (format, FORMAT_NE ("S16")))
+    buffer = gst_buffer_new_allocate (NULL,
+        N_FRAMES * channels * sizeof (gint16), NULL);
+  else
+    buffer = gst_buffer_new_allocate (NULL,
+        N_FRAMES * channels * sizeof (gfloat), NULL);
+
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+  for (i = 0; i < N_FRAMES; i++) {
+    for (c = 0; c < channels; c++) {
+      gdouble x = (i / 20) % 2 ? -amp[c] : amp[c];
+
+      if (!strcmp (format, FORMAT_NE ("S16")))
+        ((gint16 *) map.data)[i * channels + c] = lrint (x * 32767);
+      else
+        ((gfloat *) map.data)[i * channels + c] = x;
+    }
+  }
+  gst_buffer_unmap (buffer, &map);
+
+  GST_BUFFER_PTS (buffer) = index * BUFFER_DURATION;
+  GST_BUFFER_DURATION (buffer) = BUFFER_DURATION;
+
+  fail_unless_equals_int (gst_harness_push (h, buffer), GST_FLOW_OK);
+}
+
+/* Checks that the transition reported by the last push, if any, is
+ * @field at @ts, with the same structure in the message and the event */
+static void
+check_report (GstHarness * h, GstBus * bus, const gchar * field,
+    GstClockTime ts)
+{
+  const GstStructure *s;
+  GstMessage *msg;
+  GstEvent *event;
+  guint64 value;
+
+  while ((event = gst_harness_try_pull_event (h))) {
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CUSTOM_DOWNSTREAM)
+      break;
+    gst_event_unref (event);
+  }
+  msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+
+  if (!field) {
+    fail_unless (event == NULL);
+    fail_unless (msg == NULL);
+    return;
+  }
+
+  fail_unless (event != NULL);
+  fail_unless (msg != NULL);
+  fail_unless (GST_MESSAGE_SRC (msg) == GST_OBJECT (h->element));
+
+  s = gst_message_get_structure (msg);
+  fail_unless (gst_structure_has_name (s, "removesilence"));
+  fail_unless (gst_structure_get_uint64 (s, field, &value));
+  fail_unless_equals_uint64 (value, ts);
+  fail_unless (gst_structure_is_equal (s, gst_event_get_structure (event)));
+
+  gst_event_unref (event);
+  gst_message_unref (msg);
+}
+
+static void
+run_transitions_test (const gchar * format)
+{
+  const gdouble silence[] = { 0 }, voice[] = { 0.25 };
+  GstHarness *h;
+  GstBus *bus;
+
+  h = setup_removesilence (format, 1, FALSE, &bus);
+
+  /* the stream starts out silent, so there is nothing to report */
+  push_square (h, format, 1, 0, silence);
+  check_report (h, bus, NULL, 0);
+
+  /* voice is reported at the first block */
+  push_square (h, format, 1, 1, voice);
+  check_report (h, bus, "silence-finished", BUFFER_DURATION);
+  push_square (h, format, 1, 2, voice);
+  check_report (h, bus, NULL, 0);
+
+  /* and silence after the 480 frames of hysteresis, the first silent block
+   * still has the power of the voice before it */
+  push_square (h, format, 1, 3, silence);
+  check_report (h, bus, "silence-detected",
+      3 * BUFFER_DURATION + 2 * BLOCK_DURATION);
+
+  /* no audio was dropped */
+  fail_unless_equals_int (gst_harness_buffers_received (h), 4);
+
+  teardown_removesilence (h, bus);
+}
+
+GST_START_TEST (test_transitions_s16)
+{
+  run_transitions_test (FORMAT_NE ("S16"));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_transitions_f32)
+{
+  run_transitions_test (FORMAT_NE ("F32"));
+}
+
+GST_END_TEST;
+
+static void
+run_threshold_test (const gchar * format)
+{
+  const gdouble below[] = { DB (-61) }, above[] = { DB (-59) };
+  GstHarness *h;
+  GstBus *bus;
+  gint threshold;
+
+  h = setup_removesilence (format, 1, FALSE, &bus);
+
+  g_object_get (h->element, "threshold", &threshold, NULL);
+  fail_unless_equals_int (threshold, -60);
+
+  push_square (h, format, 1, 0, below);
+  check_report (h, bus, NULL, 0);
+  push_square (h, format, 1, 1, above);
+  check_report (h, bus, "silence-finished", BUFFER_DURATION);
+
+  teardown_removesilence (h, bus);
+}
+
+GST_START_TEST (test_threshold_s16)
+{
+  run_threshold_test (FORMAT_NE ("S16"));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_threshold_f32)
+{
+  run_threshold_test (FORMAT_NE ("F32"));
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_remove)
+{
+  const gdouble silence[] = { 0 }, voice[] = { 0.25 };
+  GstHarness *h;
+  GstBus *bus;
+
+  h = setup_removesilence (FORMAT_NE ("S16"), 1, FALSE, &bus);
+  g_object_set (h->element, "remove", TRUE, NULL);
+
+  push_square (h, FORMAT_NE ("S16"), 1, 0, silence);
+  check_report (h, bus, NULL, 0);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 0);
+
+  push_square (h, FORMAT_NE ("S16"), 1, 1, voice);
+  check_report (h, bus, "silence-finished", BUFFER_DURATION);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 1);
+
+  teardown_removesilence (h, bus);
+}
+
+GST_END_TEST;
+
+/* -57 dB on the left channel only is -63 dB once downmixed, and a loud wave
+ * in antiphase cancels out */
+static void
+run_multichannel_test (const gchar * format, gboolean per_channel)
+{
+  const gdouble left[] = { DB (-57), 0 }, antiphase[] = { 0.25, -0.25 };
+  const gdouble silence[] = { 0, 0 };
+  GstHarness *h;
+  GstBus *bus;
+
+  h = setup_removesilence (format, 2, per_channel, &bus);
+
+  push_square (h, format, 2, 0, left);
+  if (per_channel) {
+    check_report (h, bus, "silence-finished", 0);
+    push_square (h, format, 2, 1, silence);
+    check_report (h, bus, "silence-detected",
+        BUFFER_DURATION + BLOCK_DURATION);
+  } else {
+    check_report (h, bus, NULL, 0);
+    push_square (h, format, 2, 1, silence);
+    check_report (h, bus, NULL, 0);
+  }
+
+  push_square (h, format, 2, 2, antiphase);
+  if (per_channel)
+    check_report (h, bus, "silence-finished", 2 * BUFFER_DURATION);
+  else
+    check_report (h, bus, NULL, 0);
+
+  teardown_removesilence (h, bus);
+}
+
+GST_START_TEST (test_multichannel_downmix)
+{
+  run_multichannel_test (FORMAT_NE ("S16"), FALSE);
+  run_multichannel_test (FORMAT_NE ("F32"), FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_multichannel_per_channel)
+{
+  run_multichannel_test (FORMAT_NE ("S16"), TRUE);
+  run_multichannel_test (FORMAT_NE ("F32"), TRUE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_silent)
+{
+  const gdouble voice[] = { 0.25 };
+  GstHarness *h;
+  GstBus *bus;
+
+  h = setup_removesilence (FORMAT_NE ("S16"), 1, FALSE, &bus);
+  g_object_set (h->element, "silent", TRUE, NULL);
+
+  push_square (h, FORMAT_NE ("S16"), 1, 0, voice);
+  check_report (h, bus, NULL, 0);
+
+  teardown_removesilence (h, bus);
+}
+
+GST_END_TEST;
+
+static Suite *
+removesilence_suite (void)
+{
+  Suite *s = suite_create ("removesilence");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_transitions_s16);
+  tcase_add_test (tc_chain, test_transitions_f32);
+  tcase_add_test (tc_chain, test_threshold_s16);
+  tcase_add_test (tc_chain, test_threshold_f32);
+  tcase_add_test (tc_chain, test_remove);
+  tcase_add_test (tc_chain, test_multichannel_downmix);
+  tcase_add_test (tc_chain, test_multichannel_per_channel);
+  tcase_add_test (tc_chain, test_silent);
+
+  return s;
+}
+
+GST_CHECK_MAIN (removesilence);
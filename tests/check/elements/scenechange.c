@@ -0,0 +1,187 @@
+/* GStreamer
+ *
+ * unit test for scenechange
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* for the line SAD kernel */
+#include "../../gst/videofilters/gstscenechange.c"
+#undef GST_CAT_DEFAULT
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/video/video.h>
+#include <string.h>
+
+#define WIDTH 100
+#define HEIGHT 60
+#define N_FRAMES 20
+#define CUT_FRAME 10
+#define FRAME_DURATION (GST_SECOND / 25)
+
+static guint64
+reference_line_sad (const guint8 * s1, const guint8 * s2, gint width)
+{
+  guint64 sad = 0;
+  gint i;
+
+  for (i = 0; i < width; i++)
+    sad += s1[i] > s2[i] ? s1[i] - s2[i] : s2[i] - s1[i];
+
+  return sad;
+}
+
+/* the vectorized loop and the scalar tail add up to the plain sum, for
+ * widths that are not a multiple of the vector size and unaligned lines */
+GST_START_TEST (test_line_sad)
+{
+  guint8 s1[16 + 200], s2[16 + 200];
+  gint width, align, i;
+  GRand *rand;
+
+  rand = g_rand_new_with_seed (42);
+
+  for (i = 0; i < G_N_ELEMENTS (s1); i++) {
+    s1[i] = g_rand_int_range (rand, 0, 256);
+    s2[i] = g_rand_int_range (rand, 0, 256);
+  }
+  /* the largest differences both ways */
+  memset (s1 + 16, 0, 20);
+  memset (s2 + 16, 255, 20);
+  memset (s1 + 40, 255, 20);
+  memset (s2 + 40, 0, 20);
+
+  for (align = 0; align < 16; align++) {
+    for (width = 1; width <= 200; width++) {
+      fail_unless_equals_uint64 (get_line_sad (s1 + align, s2 + align, width),
+          reference_line_sad (s1 + align, s2 + align, width));
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+/* A horizontal gradient moving by a pixel per frame, and from CUT_FRAME on
+ * a dark scene with little detail */
+static GstBuffer *
+create_frame (GstVideoInfo * info, guint index)
+{
+  GstVideoFrame frame;
+  GstBuffer *buf;
+  gint x, y;
+
+  buf = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (info), NULL);
+  fail_unless (gst_video_frame_map (&frame, info, buf, GST_MAP_WRITE));
+
+  for (y = 0; y < HEIGHT; y++) {
+    guint8 *line = GST_VIDEO_FRAME_COMP_DATA (&frame, 0) +
+        y * GST_VIDEO_FRAME_COMP_STRIDE (&frame, 0);
+
+    for (x = 0; x < WIDTH; x++) {
+      if (index < CUT_FRAME)
+        line[x] = 100 + (x + index) % 100;
+      else
+        line[x] = 16 + (x + y) % 8;
+    }
+  }
+  memset (GST_VIDEO_FRAME_COMP_DATA (&frame, 1), 128,
+      GST_VIDEO_FRAME_COMP_STRIDE (&frame, 1) *
+      GST_VIDEO_FRAME_COMP_HEIGHT (&frame, 1));
+  memset (GST_VIDEO_FRAME_COMP_DATA (&frame, 2), 128,
+      GST_VIDEO_FRAME_COMP_STRIDE (&frame, 2) *
+      GST_VIDEO_FRAME_COMP_HEIGHT (&frame, 2));
+
+  gst_video_frame_unmap (&frame);
+
+  GST_BUFFER_PTS (buf) = index * FRAME_DURATION;
+  GST_BUFFER_DURATION (buf) = FRAME_DURATION;
+
+  return buf;
+}
+
+/* the cut is reported once, on its first frame, and nothing else is */
+static void
+run_cut_test (const gchar * method, guint line_step)
+{
+  GstVideoInfo info;
+  GstHarness *h;
+  GstEvent *event;
+  guint i, n_cuts = 0;
+
+  h = gst_harness_new ("scenechange");
+  gst_util_set_object_arg (G_OBJECT (h->element), "method", method);
+  g_object_set (h->element, "line-step", line_step, NULL);
+
+  gst_video_info_set_format (&info, GST_VIDEO_FORMAT_I420, WIDTH, HEIGHT);
+  GST_VIDEO_INFO_FPS_N (&info) = 25;
+  GST_VIDEO_INFO_FPS_D (&info) = 1;
+  gst_harness_set_src_caps (h, gst_video_info_to_caps (&info));
+
+  for (i = 0; i < N_FRAMES; i++)
+    fail_unless_equals_int (gst_harness_push (h, create_frame (&info, i)),
+        GST_FLOW_OK);
+
+  while ((event = gst_harness_try_pull_event (h))) {
+    if (gst_video_event_is_force_key_unit (event)) {
+      GstClockTime timestamp;
+
+      fail_unless (gst_video_event_parse_downstream_force_key_unit (event,
+              &timestamp, NULL, NULL, NULL, NULL));
+      fail_unless_equals_uint64 (timestamp, CUT_FRAME * FRAME_DURATION);
+      n_cuts++;
+    }
+    gst_event_unref (event);
+  }
+  fail_unless_equals_int (n_cuts, 1);
+  fail_unless_equals_int (gst_harness_buffers_received (h), N_FRAMES);
+
+  gst_harness_teardown (h);
+}
+
+GST_START_TEST (test_sad_detects_cut)
+{
+  run_cut_test ("sad", 1);
+  run_cut_test ("sad", 3);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_histogram_detects_cut)
+{
+  run_cut_test ("histogram", 1);
+  run_cut_test ("histogram", 3);
+}
+
+GST_END_TEST;
+
+static Suite *
+scenechange_suite (void)
+{
+  Suite *s = suite_create ("scenechange");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_line_sad);
+  tcase_add_test (tc_chain, test_sad_detects_cut);
+  tcase_add_test (tc_chain, test_histogram_detects_cut);
+
+  return s;
+}
+
+GST_CHECK_MAIN (scenechange);
@@ -0,0 +1,213 @@
+/* GStreamer
+ *
+ * unit test for ssim
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <math.h>
+
+#define N_FRAMES 5
+
+#define CAPS_STR(w, h) "video/x-raw,format=I420,width=" #w ",height=" #h \
+    ",framerate=25/1"
+
+/* Runs @desc to EOS and returns the "ssim" messages, followed by the
+ * "ssim-summary" messages. Returns %NULL if the pipeline posted an error. */
+static GList *
+run_pipeline (const gchar * desc)
+{
+  GstElement *pipeline;
+  GstBus *bus;
+  GstMessage *msg;
+  GList *structures = NULL;
+  gboolean error = FALSE;
+
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+  bus = gst_element_get_bus (pipeline);
+
+  fail_if (gst_element_set_state (pipeline, GST_STATE_PLAYING) ==
+      GST_STATE_CHANGE_FAILURE);
+
+  while ((msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+              GST_MESSAGE_ELEMENT | GST_MESSAGE_EOS | GST_MESSAGE_ERROR))) {
+    const GstStructure *s = gst_message_get_structure (msg);
+
+    if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_ELEMENT) {
+      error = GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR;
+      gst_message_unref (msg);
+      break;
+    }
+
+    if (gst_structure_has_name (s, "ssim") ||
+        gst_structure_has_name (s, "ssim-summary"))
+      structures = g_list_append (structures, gst_structure_copy (s));
+    gst_message_unref (msg);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (bus);
+  gst_object_unref (pipeline);
+
+  if (error) {
+    g_list_free_full (structures, (GDestroyNotify) gst_structure_free);
+    return NULL;
+  }
+
+  return structures;
+}
+
+static gdouble
+get_double (const GstStructure * s, const gchar * field)
+{
+  gdouble value;
+
+  fail_unless (gst_structure_get_double (s, field, &value));
+
+  return value;
+}
+
+GST_START_TEST (test_identical)
+{
+  GList *structures, *l;
+  guint frames = 0;
+  guint64 n;
+
+  structures = run_pipeline ("videotestsrc num-buffers=" G_STRINGIFY (N_FRAMES)
+      " pattern=ball ! " CAPS_STR (320, 240) " ! tee name=t ! queue ! "
+      "ssim name=s threads=1 ! fakesink t. ! queue ! s.");
+  fail_unless (structures != NULL);
+
+  for (l = structures; l; l = l->next) {
+    const GstStructure *s = l->data;
+
+    fail_unless_equals_string (gst_structure_get_string (s, "stream"),
+        "sink_1");
+    fail_unless (fabs (get_double (s, "ssim-mean") - 1.0) < 1e-6);
+    fail_unless_equals_float (get_double (s, "ssim-min"), 1.0);
+
+    if (gst_structure_has_name (s, "ssim")) {
+      fail_unless_equals_float (get_double (s, "psnr"), 100.0);
+      fail_unless (gst_structure_get_uint64 (s, "offset", &n));
+      fail_unless_equals_uint64 (n, frames);
+      frames++;
+    } else {
+      fail_unless (gst_structure_get_uint64 (s, "frames", &n));
+      fail_unless_equals_uint64 (n, N_FRAMES);
+      fail_unless_equals_float (get_double (s, "psnr-min"), 100.0);
+      fail_unless (l->next == NULL);
+    }
+  }
+  fail_unless_equals_int (frames, N_FRAMES);
+
+  g_list_free_full (structures, (GDestroyNotify) gst_structure_free);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_different)
+{
+  GList *structures, *l;
+
+  structures = run_pipeline ("videotestsrc num-buffers=" G_STRINGIFY (N_FRAMES)
+      " pattern=smpte ! " CAPS_STR (320, 240) " ! ssim name=s ! fakesink "
+      "videotestsrc num-buffers=" G_STRINGIFY (N_FRAMES) " pattern=checkers-8 "
+      "! " CAPS_STR (320, 240) " ! s.");
+  fail_unless (structures != NULL);
+  fail_unless_equals_int (g_list_length (structures), N_FRAMES + 1);
+
+  for (l = structures; l; l = l->next) {
+    const GstStructure *s = l->data;
+
+    fail_unless (get_double (s, "ssim-mean") < 0.5);
+    if (gst_structure_has_name (s, "ssim")) {
+      fail_unless (get_double (s, "ssim-min") <= get_double (s, "ssim-mean"));
+      fail_unless (get_double (s, "ssim-max") >= get_double (s, "ssim-mean"));
+      fail_unless (get_double (s, "psnr") < 20.0);
+    }
+  }
+
+  g_list_free_full (structures, (GDestroyNotify) gst_structure_free);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_threads_identical)
+{
+  GList *structures1, *structures4, *l1, *l4;
+
+  /* tall enough to be split in several slices */
+  structures1 = run_pipeline ("videotestsrc num-buffers=2 pattern=smpte ! "
+      CAPS_STR (160, 480) " ! ssim name=s threads=1 ! fakesink "
+      "videotestsrc num-buffers=2 pattern=ball ! " CAPS_STR (160, 480)
+      " ! s.");
+  structures4 = run_pipeline ("videotestsrc num-buffers=2 pattern=smpte ! "
+      CAPS_STR (160, 480) " ! ssim name=s threads=4 ! fakesink "
+      "videotestsrc num-buffers=2 pattern=ball ! " CAPS_STR (160, 480)
+      " ! s.");
+  fail_unless (structures1 != NULL);
+  fail_unless (structures4 != NULL);
+  fail_unless_equals_int (g_list_length (structures1),
+      g_list_length (structures4));
+
+  for (l1 = structures1, l4 = structures4; l1; l1 = l1->next, l4 = l4->next) {
+    const GstStructure *s1 = l1->data, *s4 = l4->data;
+
+    fail_unless_equals_float (get_double (s1, "ssim-mean"),
+        get_double (s4, "ssim-mean"));
+    fail_unless_equals_float (get_double (s1, "ssim-min"),
+        get_double (s4, "ssim-min"));
+    if (gst_structure_has_name (s1, "ssim")) {
+      fail_unless_equals_float (get_double (s1, "ssim-max"),
+          get_double (s4, "ssim-max"));
+      fail_unless_equals_float (get_double (s1, "psnr"),
+          get_double (s4, "psnr"));
+    }
+  }
+
+  g_list_free_full (structures1, (GDestroyNotify) gst_structure_free);
+  g_list_free_full (structures4, (GDestroyNotify) gst_structure_free);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_size_mismatch)
+{
+  fail_unless (run_pipeline ("videotestsrc num-buffers=2 ! "
+          CAPS_STR (320, 240) " ! ssim name=s ! fakesink "
+          "videotestsrc num-buffers=2 ! " CAPS_STR (160, 120) " ! s.") == NULL);
+}
+
+GST_END_TEST;
+
+static Suite *
+ssim_suite (void)
+{
+  Suite *s = suite_create ("ssim");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_identical);
+  tcase_add_test (tc_chain, test_different);
+  tcase_add_test (tc_chain, test_threads_identical);
+  tcase_add_test (tc_chain, test_size_mismatch);
+
+  return s;
+}
+
+GST_CHECK_MAIN (ssim);
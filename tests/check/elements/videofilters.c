@@ -0,0 +1,175 @@
+/* GStreamer
+ *
+ * unit test for the videodiff and zebrastripe line kernels
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+#include "../../gst/videofilters/gstvideofilterslines.h"
+
+/* widths of 1 to MAX_TEST_WIDTH are checked at all 16 alignments, so that
+ * the vector loops and the scalar tails run on every split */
+#define MAX_TEST_WIDTH 100
+#define BUF_SIZE (16 + MAX_TEST_WIDTH)
+
+static const guint8 thresholds[] = { 0, 1, 5, 90, 128, 254, 255 };
+
+static void
+fill_random (GRand * rand, guint8 * data, gsize size)
+{
+  gsize i;
+
+  for (i = 0; i < size; i++)
+    data[i] = g_rand_int_range (rand, 0, 256);
+}
+
+/* two lines differing by every amount around the thresholds */
+static void
+fill_diff_lines (GRand * rand, guint8 * s1, guint8 * s2, gsize size)
+{
+  gsize i;
+
+  fill_random (rand, s1, size);
+  for (i = 0; i < size; i++) {
+    gint d = g_rand_int_range (rand, -256, 256);
+
+    /* mostly small differences */
+    if (g_rand_boolean (rand))
+      d /= 32;
+    s2[i] = CLAMP (s1[i] + d, 0, 255);
+  }
+}
+
+GST_START_TEST (test_video_diff_mask_line)
+{
+  guint8 s1[BUF_SIZE], s2[BUF_SIZE];
+  guint8 mask[MAX_TEST_WIDTH];
+  gint width, align, t, i, round;
+  GRand *rand;
+
+  rand = g_rand_new_with_seed (1);
+
+  for (round = 0; round < 10; round++) {
+    fill_diff_lines (rand, s1, s2, BUF_SIZE);
+
+    for (t = 0; t < G_N_ELEMENTS (thresholds); t++) {
+      for (align = 0; align < 16; align++) {
+        for (width = 1; width <= MAX_TEST_WIDTH; width++) {
+          const guint8 *a = s1 + align, *b = s2 + align;
+
+          video_diff_mask_line (mask, a, b, width, thresholds[t]);
+          for (i = 0; i < width; i++) {
+            gint d = ABS (a[i] - b[i]);
+
+            fail_unless_equals_int (mask[i], d > thresholds[t] ? 0xff : 0);
+          }
+        }
+      }
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_video_diff_draw_line)
+{
+  guint8 s[BUF_SIZE], mask[BUF_SIZE], d[MAX_TEST_WIDTH];
+  gint width, align, phase, i;
+  GRand *rand;
+
+  rand = g_rand_new_with_seed (2);
+
+  fill_random (rand, s, BUF_SIZE);
+  for (i = 0; i < BUF_SIZE; i++)
+    mask[i] = g_rand_boolean (rand) ? 0xff : 0;
+
+  for (phase = 0; phase < 8; phase++) {
+    for (align = 0; align < 16; align++) {
+      for (width = 1; width <= MAX_TEST_WIDTH; width++) {
+        video_diff_draw_line (d, s + align, mask + align, width, phase);
+        for (i = 0; i < width; i++) {
+          guint8 stripe = ((i + phase) & 7) < 4 ? 240 : 16;
+
+          fail_unless_equals_int (d[i], mask[align + i] ? stripe :
+              s[align + i]);
+        }
+      }
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_zebra_stripe_line)
+{
+  guint8 data[BUF_SIZE], stripes[BUF_SIZE], mask[BUF_SIZE];
+  guint8 line[MAX_TEST_WIDTH];
+  gint width, align, t, i;
+  GRand *rand;
+
+  rand = g_rand_new_with_seed (3);
+
+  fill_random (rand, data, BUF_SIZE);
+  for (i = 0; i < BUF_SIZE; i++) {
+    stripes[i] = g_rand_boolean (rand) ? 0xff : 0;
+    mask[i] = g_rand_boolean (rand) ? 0xff : 0;
+  }
+
+  for (t = 0; t < G_N_ELEMENTS (thresholds); t++) {
+    for (align = 0; align < 16; align++) {
+      for (width = 1; width <= MAX_TEST_WIDTH; width++) {
+        const guint8 *src = data + align;
+
+        memcpy (line, src, width);
+        zebra_stripe_line (line, stripes + align, mask + align, width,
+            thresholds[t]);
+        for (i = 0; i < width; i++) {
+          gboolean striped = stripes[align + i] && mask[align + i] &&
+              src[i] >= thresholds[t];
+
+          fail_unless_equals_int (line[i], striped ? 16 : src[i]);
+        }
+      }
+    }
+  }
+
+  g_rand_free (rand);
+}
+
+GST_END_TEST;
+
+static Suite *
+videofilters_suite (void)
+{
+  Suite *s = suite_create ("videofilters");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_video_diff_mask_line);
+  tcase_add_test (tc_chain, test_video_diff_draw_line);
+  tcase_add_test (tc_chain, test_zebra_stripe_line);
+
+  return s;
+}
+
+GST_CHECK_MAIN (videofilters);
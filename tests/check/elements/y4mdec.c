@@ -0,0 +1,321 @@
+/* GStreamer
+ *
+ * unit test for y4mdec
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstcheck.h>
+#include <string.h>
+
+/* 10 frames of 16x16 I420 at 25 fps, each frame filled with its index */
+#define Y4M_HEADER "YUV4MPEG2 W16 H16 F25:1 Ip A1:1 C420\n"
+#define Y4M_FRAME_HEADER "FRAME\n"
+#define N_FRAMES 10
+#define FRAME_SIZE (16 * 16 + 2 * 8 * 8)
+#define FRAME_DURATION (GST_SECOND / 25)
+#define FRAME_OFFSET(i) (sizeof (Y4M_HEADER) - 1 + \
+    (i) * (sizeof (Y4M_FRAME_HEADER) - 1 + FRAME_SIZE))
+
+static GstPad *mysrcpad, *mysinkpad;
+static guint8 *y4m_file;
+static gsize y4m_file_size;
+static gint64 seek_offset;
+
+static GMutex eos_lock;
+static GCond eos_cond;
+static gboolean have_eos;
+
+static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("application/x-yuv4mpeg, y4mversion=2"));
+
+static void
+create_y4m_file (void)
+{
+  guint8 *p;
+  guint i;
+
+  y4m_file_size = FRAME_OFFSET (N_FRAMES);
+  y4m_file = p = g_malloc (y4m_file_size);
+
+  memcpy (p, Y4M_HEADER, sizeof (Y4M_HEADER) - 1);
+  p += sizeof (Y4M_HEADER) - 1;
+  for (i = 0; i < N_FRAMES; i++) {
+    memcpy (p, Y4M_FRAME_HEADER, sizeof (Y4M_FRAME_HEADER) - 1);
+    p += sizeof (Y4M_FRAME_HEADER) - 1;
+    memset (p, i, FRAME_SIZE);
+    p += FRAME_SIZE;
+  }
+}
+
+static GstFlowReturn
+_src_getrange (GstPad * pad, GstObject * parent, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  if (offset >= y4m_file_size)
+    return GST_FLOW_EOS;
+
+  length = MIN (length, y4m_file_size - offset);
+  *buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      y4m_file + offset, length, 0, length, NULL, NULL);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_SCHEDULING:
+      gst_query_set_scheduling (query, GST_SCHEDULING_FLAG_SEEKABLE, 1, -1, 0);
+      gst_query_add_scheduling_mode (query, GST_PAD_MODE_PULL);
+      return TRUE;
+    default:
+      return gst_pad_query_default (pad, parent, query);
+  }
+}
+
+/* stands in for a byte based upstream in push mode */
+static gboolean
+_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_SEEK) {
+    GstFormat format;
+    gint64 start;
+
+    gst_event_parse_seek (event, NULL, &format, NULL, NULL, &start, NULL,
+        NULL);
+    fail_unless_equals_int (format, GST_FORMAT_BYTES);
+    seek_offset = start;
+    gst_event_unref (event);
+    return TRUE;
+  }
+
+  return gst_pad_event_default (pad, parent, event);
+}
+
+static gboolean
+_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  if (GST_EVENT_TYPE (event) == GST_EVENT_EOS) {
+    g_mutex_lock (&eos_lock);
+    have_eos = TRUE;
+    g_cond_signal (&eos_cond);
+    g_mutex_unlock (&eos_lock);
+  }
+
+  gst_event_unref (event);
+  return TRUE;
+}
+
+static void
+wait_for_eos (void)
+{
+  g_mutex_lock (&eos_lock);
+  while (!have_eos)
+    g_cond_wait (&eos_cond, &eos_lock);
+  have_eos = FALSE;
+  g_mutex_unlock (&eos_lock);
+}
+
+/* checks that the collected buffers are the frames @first to the last one */
+static void
+check_frames (guint first)
+{
+  GstMapInfo map;
+  guint i;
+
+  fail_unless_equals_int (g_list_length (buffers), N_FRAMES - first);
+
+  for (i = first; i < N_FRAMES; i++) {
+    GstBuffer *buffer = buffers->data;
+
+    buffers = g_list_remove (buffers, buffer);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buffer), i * FRAME_DURATION);
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (buffer), FRAME_DURATION);
+
+    gst_buffer_map (buffer, &map, GST_MAP_READ);
+    fail_unless_equals_int (map.size, FRAME_SIZE);
+    fail_unless_equals_int (map.data[0], i);
+    fail_unless_equals_int (map.data[FRAME_SIZE - 1], i);
+    gst_buffer_unmap (buffer, &map);
+    gst_buffer_unref (buffer);
+  }
+}
+
+static void
+check_segment_start (GstClockTime start)
+{
+  GstEvent *event;
+  const GstSegment *segment;
+
+  event = gst_pad_get_sticky_event (mysinkpad, GST_EVENT_SEGMENT, 0);
+  fail_unless (event != NULL);
+  gst_event_parse_segment (event, &segment);
+  fail_unless_equals_int (segment->format, GST_FORMAT_TIME);
+  fail_unless_equals_uint64 (segment->start, start);
+  gst_event_unref (event);
+}
+
+static GstElement *
+setup_y4mdec (gboolean pull)
+{
+  GstElement *y4mdec;
+
+  create_y4m_file ();
+  have_eos = FALSE;
+
+  y4mdec = gst_check_setup_element ("y4mdec");
+  mysrcpad = gst_check_setup_src_pad (y4mdec, &srctemplate);
+  if (pull) {
+    gst_pad_set_getrange_function (mysrcpad, _src_getrange);
+    gst_pad_set_query_function (mysrcpad, _src_query);
+  } else {
+    gst_pad_set_event_function (mysrcpad, _src_event);
+  }
+  mysinkpad = gst_check_setup_sink_pad (y4mdec, &sinktemplate);
+  gst_pad_set_event_function (mysinkpad, _sink_event);
+
+  gst_pad_set_active (mysrcpad, TRUE);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  return y4mdec;
+}
+
+static void
+cleanup_y4mdec (GstElement * y4mdec)
+{
+  gst_element_set_state (y4mdec, GST_STATE_NULL);
+  gst_check_drop_buffers ();
+
+  gst_pad_set_active (mysrcpad, FALSE);
+  gst_pad_set_active (mysinkpad, FALSE);
+  gst_check_teardown_src_pad (y4mdec);
+  gst_check_teardown_sink_pad (y4mdec);
+  gst_check_teardown_element (y4mdec);
+
+  g_free (y4m_file);
+  y4m_file = NULL;
+}
+
+GST_START_TEST (test_pull_seek)
+{
+  GstElement *y4mdec;
+
+  y4mdec = setup_y4mdec (TRUE);
+
+  fail_unless_equals_int (gst_element_set_state (y4mdec, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  wait_for_eos ();
+  check_frames (0);
+  check_segment_start (0);
+
+  /* the frame containing the position is the first one after the seek */
+  fail_unless (gst_pad_push_event (mysinkpad,
+          gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+              GST_SEEK_TYPE_SET, 5 * FRAME_DURATION + FRAME_DURATION / 2,
+              GST_SEEK_TYPE_NONE, -1)));
+
+  wait_for_eos ();
+  check_frames (5);
+  check_segment_start (5 * FRAME_DURATION);
+
+  /* and the stop position ends the playback */
+  fail_unless (gst_pad_push_event (mysinkpad,
+          gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+              GST_SEEK_TYPE_SET, 2 * FRAME_DURATION,
+              GST_SEEK_TYPE_SET, 4 * FRAME_DURATION)));
+
+  wait_for_eos ();
+  fail_unless_equals_int (g_list_length (buffers), 2);
+  fail_unless_equals_uint64 (GST_BUFFER_PTS (buffers->data),
+      2 * FRAME_DURATION);
+
+  cleanup_y4mdec (y4mdec);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_push_seek)
+{
+  GstElement *y4mdec;
+  GstSegment segment;
+  GstBuffer *buffer;
+  GstCaps *caps;
+
+  y4mdec = setup_y4mdec (FALSE);
+
+  fail_unless_equals_int (gst_element_set_state (y4mdec, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_SUCCESS);
+
+  caps = gst_caps_from_string ("application/x-yuv4mpeg, y4mversion=2");
+  gst_check_setup_events (mysrcpad, y4mdec, caps, GST_FORMAT_BYTES);
+  gst_caps_unref (caps);
+
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, y4m_file,
+      y4m_file_size, 0, y4m_file_size, NULL, NULL);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+  check_frames (0);
+
+  /* seeks are done upstream in bytes, at the start of the frame */
+  seek_offset = -1;
+  fail_unless (gst_pad_push_event (mysinkpad,
+          gst_event_new_seek (1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH,
+              GST_SEEK_TYPE_SET, 5 * FRAME_DURATION,
+              GST_SEEK_TYPE_NONE, -1)));
+  fail_unless_equals_int64 (seek_offset, FRAME_OFFSET (5));
+
+  /* upstream continues from there */
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  segment.start = segment.time = seek_offset;
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_segment (&segment)));
+
+  buffer = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      y4m_file + seek_offset, y4m_file_size - seek_offset, 0,
+      y4m_file_size - seek_offset, NULL, NULL);
+  GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+  check_frames (5);
+  check_segment_start (5 * FRAME_DURATION);
+
+  cleanup_y4mdec (y4mdec);
+}
+
+GST_END_TEST;
+
+static Suite *
+y4mdec_suite (void)
+{
+  Suite *s = suite_create ("y4mdec");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_pull_seek);
+  tcase_add_test (tc_chain, test_push_seek);
+
+  return s;
+}
+
+GST_CHECK_MAIN (y4mdec);
@@ -0,0 +1,165 @@
+/* GStreamer
+ *
+ * unit test for yadif
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/check/gstharness.h>
+#include <gst/check/gstcheck.h>
+#include <gst/video/video.h>
+
+#define WIDTH 64
+#define HEIGHT 256
+#define FRAME_SIZE (WIDTH * HEIGHT * 3 / 2)
+#define FRAME_DURATION (GST_SECOND / 25)
+
+#define CAPS_STR "video/x-raw,format=I420,width=64,height=256," \
+    "framerate=25/1,interlace-mode=interleaved"
+
+static void
+push_frames (GstHarness * h, guint n_frames)
+{
+  guint i;
+
+  for (i = 0; i < n_frames; i++) {
+    GstBuffer *buf = gst_harness_create_buffer (h, FRAME_SIZE);
+
+    gst_buffer_memset (buf, 0, i * 16, FRAME_SIZE);
+    GST_BUFFER_PTS (buf) = i * FRAME_DURATION;
+    GST_BUFFER_DURATION (buf) = FRAME_DURATION;
+    GST_BUFFER_FLAG_SET (buf, GST_VIDEO_BUFFER_FLAG_TFF);
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+}
+
+GST_START_TEST (test_frame_history)
+{
+  GstHarness *h = gst_harness_new_parse ("yadif fields=frame threads=1");
+  GstBuffer *buf;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, CAPS_STR);
+
+  /* the first frame is held back until the next one arrives */
+  push_frames (h, 1);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 0);
+  push_frames (h, 2);
+  fail_unless_equals_int (gst_harness_buffers_received (h), 2);
+
+  /* the last frame is output on EOS */
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  fail_unless_equals_int (gst_harness_buffers_received (h), 3);
+
+  for (i = 0; i < 3; i++) {
+    buf = gst_harness_pull (h);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), i * FRAME_DURATION);
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (buf), FRAME_DURATION);
+    fail_if (GST_BUFFER_FLAG_IS_SET (buf, GST_VIDEO_BUFFER_FLAG_TFF));
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_field_rate)
+{
+  GstHarness *h = gst_harness_new_parse ("yadif fields=all threads=4");
+  GstStructure *s;
+  GstCaps *caps;
+  GstBuffer *buf;
+  gint fps_n, fps_d;
+  guint i;
+
+  gst_harness_set_src_caps_str (h, CAPS_STR);
+
+  push_frames (h, 3);
+  fail_unless (gst_harness_push_event (h, gst_event_new_eos ()));
+  fail_unless_equals_int (gst_harness_buffers_received (h), 6);
+
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  s = gst_caps_get_structure (caps, 0);
+  fail_unless (gst_structure_get_fraction (s, "framerate", &fps_n, &fps_d));
+  fail_unless_equals_int (fps_n, 50);
+  fail_unless_equals_int (fps_d, 1);
+  fail_unless_equals_string (gst_structure_get_string (s, "interlace-mode"),
+      "progressive");
+  gst_caps_unref (caps);
+
+  for (i = 0; i < 6; i++) {
+    buf = gst_harness_pull (h);
+    fail_unless_equals_uint64 (GST_BUFFER_PTS (buf), i * FRAME_DURATION / 2);
+    fail_unless_equals_uint64 (GST_BUFFER_DURATION (buf), FRAME_DURATION / 2);
+    gst_buffer_unref (buf);
+  }
+
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_threads_identical)
+{
+  GstHarness *h1 = gst_harness_new_parse ("yadif fields=all threads=1");
+  GstHarness *h4 = gst_harness_new_parse ("yadif fields=all threads=4");
+  GstBuffer *buf1, *buf4;
+  GstMapInfo map1, map4;
+  guint i;
+
+  gst_harness_set_src_caps_str (h1, CAPS_STR);
+  gst_harness_set_src_caps_str (h4, CAPS_STR);
+
+  push_frames (h1, 4);
+  push_frames (h4, 4);
+  fail_unless (gst_harness_push_event (h1, gst_event_new_eos ()));
+  fail_unless (gst_harness_push_event (h4, gst_event_new_eos ()));
+
+  for (i = 0; i < 8; i++) {
+    buf1 = gst_harness_pull (h1);
+    buf4 = gst_harness_pull (h4);
+    fail_unless (gst_buffer_map (buf1, &map1, GST_MAP_READ));
+    fail_unless (gst_buffer_map (buf4, &map4, GST_MAP_READ));
+    fail_unless_equals_int (map1.size, map4.size);
+    fail_unless (memcmp (map1.data, map4.data, map1.size) == 0);
+    gst_buffer_unmap (buf1, &map1);
+    gst_buffer_unmap (buf4, &map4);
+    gst_buffer_unref (buf1);
+    gst_buffer_unref (buf4);
+  }
+
+  gst_harness_teardown (h1);
+  gst_harness_teardown (h4);
+}
+
+GST_END_TEST;
+
+static Suite *
+yadif_suite (void)
+{
+  Suite *s = suite_create ("yadif");
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_frame_history);
+  tcase_add_test (tc_chain, test_field_rate);
+  tcase_add_test (tc_chain, test_threads_identical);
+
+  return s;
+}
+
+GST_CHECK_MAIN (yadif);
@@ -211,6 +211,108 @@ GST_START_TEST (test_h264_parse_slice_eoseq_slice)
 
 GST_END_TEST;
 
+/* Returns the offset of the first 0x000001 followed by at least one byte in
+ * @data, or -1, the way a bytewise search finds it */
+static gint
+reference_scan (const guint8 * data, gsize size)
+{
+  gsize i;
+
+  for (i = 0; i + 4 <= size; i++) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1)
+      return i;
+  }
+
+  return -1;
+}
+
+/* Checks the NAL found in @data against the bytewise search */
+static void
+check_scan (GstH264NalParser * parser, const guint8 * data, gsize size)
+{
+  GstH264ParserResult res;
+  GstH264NalUnit nalu;
+  gint sc, end;
+
+  sc = reference_scan (data, size);
+  res = gst_h264_parser_identify_nalu (parser, data, 0, size, &nalu);
+
+  if (sc < 0) {
+    assert_equals_int (res, size < 4 ? GST_H264_PARSER_ERROR :
+        GST_H264_PARSER_NO_NAL);
+    return;
+  }
+
+  assert_equals_int (nalu.sc_offset, sc);
+  assert_equals_int (nalu.offset, sc + 3);
+
+  end = reference_scan (data + sc + 3, size - sc - 3);
+  if (end < 0) {
+    assert_equals_int (res, GST_H264_PARSER_NO_NAL_END);
+    return;
+  }
+
+  /* the zeros before the next start code are not part of the NAL */
+  while (end > 0 && data[sc + 3 + end - 1] == 0)
+    end--;
+  if (end < 2) {
+    assert_equals_int (res, GST_H264_PARSER_BROKEN_DATA);
+  } else {
+    assert_equals_int (res, GST_H264_PARSER_OK);
+    assert_equals_int (nalu.size, end);
+  }
+}
+
+/* The start code scanner tests whole vectors of positions at once where the
+ * CPU allows it, it must find the same start codes as a bytewise search at
+ * any alignment, in tails shorter than a vector, and across the boundary
+ * between two vectors */
+GST_START_TEST (test_h264_scan_start_codes)
+{
+  /* mostly zeros and ones, so that there are many start codes and near
+   * misses, none of them of a type that moves the start code offset */
+  static const guint8 alphabet[] = { 0x00, 0x00, 0x00, 0x01, 0x02, 0x41 };
+  GstH264NalParser *parser = gst_h264_nal_parser_new ();
+  GRand *rand = g_rand_new_with_seed (1);
+  guint8 *base, *data;
+  gsize align, size, pos, i;
+  guint n;
+
+  base = g_malloc (32 + 256);
+
+  for (align = 0; align < 32; align++) {
+    data = base + align;
+
+    /* a single start code at every position of a slice of payload bytes */
+    for (size = 1; size <= 100; size++) {
+      for (pos = 0; pos + 4 <= size; pos++) {
+        memset (data, 0x41, size);
+        data[pos] = data[pos + 1] = 0x00;
+        data[pos + 2] = 0x01;
+        check_scan (parser, data, size);
+      }
+
+      memset (data, 0x41, size);
+      check_scan (parser, data, size);
+    }
+
+    /* and random streams of them */
+    for (size = 1; size <= 256; size++) {
+      for (n = 0; n < 8; n++) {
+        for (i = 0; i < size; i++)
+          data[i] = alphabet[g_rand_int_range (rand, 0, sizeof (alphabet))];
+        check_scan (parser, data, size);
+      }
+    }
+  }
+
+  g_free (base);
+  g_rand_free (rand);
+  gst_h264_nal_parser_free (parser);
+}
+
+GST_END_TEST;
+
 static Suite *
 h264parser_suite (void)
 {
@@ -221,6 +323,7 @@ h264parser_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_h264_parse_slice_dpa);
   tcase_add_test (tc_chain, test_h264_parse_slice_eoseq_slice);
+  tcase_add_test (tc_chain, test_h264_scan_start_codes);
 
   return s;
 }
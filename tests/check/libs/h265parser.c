@@ -0,0 +1,335 @@
+/* GStreamer
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#include <gst/check/gstcheck.h>
+#include <gst/codecparsers/gsth265parser.h>
+#include <gst/codecparsers/gsth265slicemeta.h>
+
+/* 128x64 main profile stream with 16x16 CTBs. PPS 0 has two tile columns,
+ * PPS 1 enables WPP. The slices are intra slices of an IDR picture whose
+ * slice data is 20 bytes of filler. */
+static const guint8 h265_vps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x40, 0x01, 0x0c, 0x01, 0xff, 0xff, 0x01, 0x60,
+  0x00, 0x00, 0x03, 0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00,
+  0x5a, 0xf0, 0x24,
+};
+
+static const guint8 h265_sps[] = {
+  0x00, 0x00, 0x00, 0x01, 0x42, 0x01, 0x01, 0x01, 0x60, 0x00, 0x00, 0x03,
+  0x00, 0x90, 0x00, 0x00, 0x03, 0x00, 0x00, 0x03, 0x00, 0x5a, 0xa0, 0x10,
+  0x20, 0x41, 0x65, 0xfa, 0xbc, 0x20, 0x80,
+};
+
+static const guint8 h265_pps_tiles[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0xc0, 0x71, 0x84, 0xb8, 0x48,
+};
+
+static const guint8 h265_pps_wpp[] = {
+  0x00, 0x00, 0x00, 0x01, 0x44, 0x01, 0x50, 0x1c, 0x60, 0x84, 0x80,
+};
+
+static const guint8 h265_slice_tiles[] = {
+  0x00, 0x00, 0x00, 0x01, 0x26, 0x01, 0xae, 0x84, 0x04, 0xc0, 0xaa, 0xaa,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+};
+
+static const guint8 h265_slice_wpp[] = {
+  0x00, 0x00, 0x00, 0x01, 0x26, 0x01, 0x93, 0x90, 0x40, 0x18, 0x28, 0x24,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+};
+
+static const guint8 h265_slice_broken[] = {
+  0x00, 0x00, 0x00, 0x01, 0x26, 0x01, 0xae, 0x84, 0x0e, 0xc0, 0xaa, 0xaa,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+  0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+};
+
+/* parses all the NAL units of @data that are not slices into @parser */
+static void
+parse_parameter_sets (GstH265Parser * parser, const guint8 * data, gsize size)
+{
+  GstH265NalUnit nalu;
+  GstH265ParserResult res;
+
+  res = gst_h265_parser_identify_nalu_unchecked (parser, data, 0, size, &nalu);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+  nalu.size = size - nalu.offset;
+
+  res = gst_h265_parser_parse_nal (parser, &nalu);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+}
+
+static GstH265Parser *
+setup_parser (void)
+{
+  GstH265Parser *parser = gst_h265_parser_new ();
+
+  parse_parameter_sets (parser, h265_vps, sizeof (h265_vps));
+  parse_parameter_sets (parser, h265_sps, sizeof (h265_sps));
+  parse_parameter_sets (parser, h265_pps_tiles, sizeof (h265_pps_tiles));
+  parse_parameter_sets (parser, h265_pps_wpp, sizeof (h265_pps_wpp));
+
+  return parser;
+}
+
+static void
+identify_slice (GstH265Parser * parser, const guint8 * data, gsize size,
+    GstH265SliceSegment * segment)
+{
+  GstH265ParserResult res;
+
+  memset (segment, 0, sizeof (*segment));
+  res = gst_h265_parser_identify_nalu (parser, data, 0, size, &segment->nalu);
+  /* the slice is the last NAL, it has no following start code */
+  assert_equals_int (res, GST_H265_PARSER_NO_NAL_END);
+  assert_equals_int (segment->nalu.type, GST_H265_NAL_SLICE_IDR_W_RADL);
+}
+
+GST_START_TEST (test_h265_parse_slice_segments_tiles)
+{
+  GstH265Parser *parser = setup_parser ();
+  GstH265SliceSegment segment;
+  GstH265ParserResult res;
+
+  identify_slice (parser, h265_slice_tiles, sizeof (h265_slice_tiles),
+      &segment);
+
+  res = gst_h265_parser_parse_slice_segments (parser, &segment, 1, NULL);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+  assert_equals_int (segment.result, GST_H265_PARSER_OK);
+  assert_equals_int (segment.header.num_entry_point_offsets, 1);
+
+  /* 4 bytes of start code, 2 of NAL header and 4 of slice header */
+  assert_equals_int (segment.data_offset, 10);
+  assert_equals_int (segment.num_substreams, 2);
+  assert_equals_int (segment.substream_offsets[0], 10);
+  assert_equals_int (segment.substream_offsets[1], 20);
+
+  gst_h265_slice_segment_clear (&segment);
+  gst_h265_parser_free (parser);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h265_parse_slice_segments_wpp_parallel)
+{
+  GstH265Parser *parser = setup_parser ();
+  GThreadPool *pool = gst_h265_slice_segment_pool_new (2);
+  GstH265SliceSegment segments[6];
+  GstH265ParserResult res;
+  guint i;
+
+  /* enough segments to be handed to the thread pool */
+  for (i = 0; i < G_N_ELEMENTS (segments); i++)
+    identify_slice (parser, h265_slice_wpp, sizeof (h265_slice_wpp),
+        &segments[i]);
+
+  res = gst_h265_parser_parse_slice_segments (parser, segments,
+      G_N_ELEMENTS (segments), pool);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+  g_thread_pool_free (pool, FALSE, TRUE);
+
+  for (i = 0; i < G_N_ELEMENTS (segments); i++) {
+    GstH265SliceSegment *segment = &segments[i];
+
+    assert_equals_int (segment->result, GST_H265_PARSER_OK);
+    /* one substream per CTB row */
+    assert_equals_int (segment->num_substreams, 4);
+    assert_equals_int (segment->data_offset, 12);
+    assert_equals_int (segment->substream_offsets[0], 12);
+    assert_equals_int (segment->substream_offsets[1], 16);
+    assert_equals_int (segment->substream_offsets[2], 22);
+    assert_equals_int (segment->substream_offsets[3], 27);
+
+    gst_h265_slice_segment_clear (segment);
+  }
+
+  gst_h265_parser_free (parser);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h265_parse_slice_segments_reuse)
+{
+  GstH265Parser *parser = setup_parser ();
+  GstH265SliceSegment segment;
+  GstH265ParserResult res;
+  guint *storage;
+
+  identify_slice (parser, h265_slice_tiles, sizeof (h265_slice_tiles),
+      &segment);
+  res = gst_h265_parser_parse_slice_segments (parser, &segment, 1, NULL);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+  assert_equals_int (segment.num_substreams, 2);
+
+  /* more substreams than the first slice, the storage grows */
+  res = gst_h265_parser_identify_nalu (parser, h265_slice_wpp,
+      0, sizeof (h265_slice_wpp), &segment.nalu);
+  assert_equals_int (res, GST_H265_PARSER_NO_NAL_END);
+  res = gst_h265_parser_parse_slice_segments (parser, &segment, 1, NULL);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+  assert_equals_int (segment.num_substreams, 4);
+  assert_equals_int (segment.substream_offsets[0], 12);
+  assert_equals_int (segment.substream_offsets[1], 16);
+  assert_equals_int (segment.substream_offsets[2], 22);
+  assert_equals_int (segment.substream_offsets[3], 27);
+  fail_unless (segment.max_substreams >= 4);
+  /* the entry points are only kept as substream offsets */
+  fail_unless (segment.header.entry_point_offset_minus1 == NULL);
+
+  /* and is kept for smaller slices */
+  storage = segment.substream_offsets;
+  res = gst_h265_parser_identify_nalu (parser, h265_slice_tiles,
+      0, sizeof (h265_slice_tiles), &segment.nalu);
+  assert_equals_int (res, GST_H265_PARSER_NO_NAL_END);
+  res = gst_h265_parser_parse_slice_segments (parser, &segment, 1, NULL);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+  assert_equals_int (segment.num_substreams, 2);
+  assert_equals_int (segment.substream_offsets[0], 10);
+  assert_equals_int (segment.substream_offsets[1], 20);
+  fail_unless (segment.substream_offsets == storage);
+
+  gst_h265_slice_segment_clear (&segment);
+  gst_h265_parser_free (parser);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h265_parse_slice_segments_broken)
+{
+  GstH265Parser *parser = setup_parser ();
+  GstH265SliceSegment segments[2];
+  GstH265ParserResult res;
+
+  identify_slice (parser, h265_slice_tiles, sizeof (h265_slice_tiles),
+      &segments[0]);
+  /* its entry point is past the end of the NAL unit */
+  identify_slice (parser, h265_slice_broken, sizeof (h265_slice_broken),
+      &segments[1]);
+
+  res = gst_h265_parser_parse_slice_segments (parser, segments, 2, NULL);
+  assert_equals_int (res, GST_H265_PARSER_BROKEN_DATA);
+  assert_equals_int (segments[0].result, GST_H265_PARSER_OK);
+  assert_equals_int (segments[1].result, GST_H265_PARSER_BROKEN_DATA);
+  assert_equals_int (segments[1].num_substreams, 0);
+  assert_equals_int (segments[1].data_offset, 0);
+
+  gst_h265_slice_segment_clear (&segments[0]);
+  gst_h265_slice_segment_clear (&segments[1]);
+  gst_h265_parser_free (parser);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_h265_slice_meta)
+{
+  GstH265Parser *parser = setup_parser ();
+  GstH265SliceSegment segments[2];
+  GstH265SliceMeta *meta;
+  GstBuffer *buffer;
+  GstMapInfo map;
+  GstH265ParserResult res;
+  gsize au_size = 0, slice_pos;
+
+  /* an access unit with its parameter sets, the slice, and a broken slice
+   * that is left out of the meta */
+  buffer = gst_buffer_new_allocate (NULL, sizeof (h265_vps) +
+      sizeof (h265_sps) + sizeof (h265_pps_tiles) + sizeof (h265_slice_tiles) +
+      sizeof (h265_slice_broken), NULL);
+  au_size += gst_buffer_fill (buffer, au_size, h265_vps, sizeof (h265_vps));
+  au_size += gst_buffer_fill (buffer, au_size, h265_sps, sizeof (h265_sps));
+  au_size += gst_buffer_fill (buffer, au_size, h265_pps_tiles,
+      sizeof (h265_pps_tiles));
+  slice_pos = au_size;
+  au_size += gst_buffer_fill (buffer, au_size, h265_slice_tiles,
+      sizeof (h265_slice_tiles));
+  au_size += gst_buffer_fill (buffer, au_size, h265_slice_broken,
+      sizeof (h265_slice_broken));
+
+  fail_unless (gst_buffer_map (buffer, &map, GST_MAP_READ));
+  memset (segments, 0, sizeof (segments));
+  res = gst_h265_parser_identify_nalu (parser, map.data, slice_pos, map.size,
+      &segments[0].nalu);
+  assert_equals_int (res, GST_H265_PARSER_OK);
+  res = gst_h265_parser_identify_nalu (parser, map.data,
+      slice_pos + sizeof (h265_slice_tiles), map.size, &segments[1].nalu);
+  assert_equals_int (res, GST_H265_PARSER_NO_NAL_END);
+
+  gst_h265_parser_parse_slice_segments (parser, segments, 2, NULL);
+  meta = gst_buffer_add_h265_slice_meta (buffer, segments, 2);
+  gst_buffer_unmap (buffer, &map);
+
+  fail_unless (meta != NULL);
+  fail_unless (gst_buffer_get_h265_slice_meta (buffer) == meta);
+  fail_unless (meta->tiles_enabled);
+  fail_if (meta->entropy_coding_sync_enabled);
+  assert_equals_int (meta->num_tile_columns, 2);
+  assert_equals_int (meta->num_tile_rows, 1);
+
+  assert_equals_int (meta->num_segments, 1);
+  assert_equals_int (meta->segments[0].offset, slice_pos + 4);
+  assert_equals_int (meta->segments[0].size, sizeof (h265_slice_tiles) - 4);
+  assert_equals_int (meta->segments[0].data_offset, slice_pos + 10);
+  assert_equals_int (meta->segments[0].segment_address, 0);
+  fail_if (meta->segments[0].dependent);
+  assert_equals_int (meta->segments[0].first_substream, 0);
+  assert_equals_int (meta->segments[0].num_substreams, 2);
+
+  assert_equals_int (meta->num_substreams, 2);
+  assert_equals_int (meta->substreams[0].offset, slice_pos + 10);
+  assert_equals_int (meta->substreams[0].size, 10);
+  assert_equals_int (meta->substreams[1].offset, slice_pos + 20);
+  assert_equals_int (meta->substreams[1].size, 10);
+
+  gst_h265_slice_segment_clear (&segments[0]);
+  gst_h265_slice_segment_clear (&segments[1]);
+
+  /* offsets are only valid for the buffer the meta was added to */
+  {
+    GstBuffer *region = gst_buffer_copy_region (buffer, GST_BUFFER_COPY_ALL,
+        slice_pos, sizeof (h265_slice_tiles));
+
+    fail_unless (gst_buffer_get_h265_slice_meta (region) == NULL);
+    gst_buffer_unref (region);
+  }
+
+  gst_buffer_unref (buffer);
+  gst_h265_parser_free (parser);
+}
+
+GST_END_TEST;
+
+static Suite *
+h265parser_suite (void)
+{
+  Suite *s = suite_create ("H265 Parser library");
+
+  TCase *tc_chain = tcase_create ("general");
+
+  suite_add_tcase (s, tc_chain);
+  tcase_add_test (tc_chain, test_h265_parse_slice_segments_tiles);
+  tcase_add_test (tc_chain, test_h265_parse_slice_segments_wpp_parallel);
+  tcase_add_test (tc_chain, test_h265_parse_slice_segments_reuse);
+  tcase_add_test (tc_chain, test_h265_parse_slice_segments_broken);
+  tcase_add_test (tc_chain, test_h265_slice_meta);
+
+  return s;
+}
+
+GST_CHECK_MAIN (h265parser);